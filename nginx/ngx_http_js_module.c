@@ -12,26 +12,134 @@
 #include <njs.h>
 
 
+#define NGX_HTTP_JS_HEADER_LEN        32
+#define NGX_HTTP_JS_HEADER_INDEX_MIN  8
+
+
 typedef struct {
     njs_vm_t            *vm;
     ngx_array_t         *paths;
+    ngx_str_t            init_worker;
+    size_t               memory_limit;
+    ngx_int_t            max_instructions;
+    ngx_msec_t           timeout;
+    ngx_flag_t           lazy;
+    ngx_int_t            jit;
     const njs_extern_t  *req_proto;
+    const njs_extern_t  *dict_proto;
+    ngx_array_t         *dicts;
+    ngx_hash_t           headers_in_hash;
 } ngx_http_js_main_conf_t;
 
 
+typedef struct {
+    ngx_rbtree_t         rbtree;
+    ngx_rbtree_node_t    sentinel;
+    ngx_atomic_t         rwlock;
+
+    /* Most recently inserted entries are at the head. */
+    ngx_queue_t          lru;
+} ngx_http_js_dict_sh_t;
+
+
+typedef struct {
+    ngx_str_t                 name;
+    ngx_shm_zone_t           *shm_zone;
+    ngx_http_js_dict_sh_t    *sh;
+    ngx_slab_pool_t          *shpool;
+    ngx_msec_t                timeout;
+    ngx_flag_t                evict;
+} ngx_http_js_dict_t;
+
+
+#define NGX_HTTP_JS_DICT_STRING  0
+#define NGX_HTTP_JS_DICT_NUMBER  1
+
+/* Live entries examined by an allocation before it gives up. */
+#define NGX_HTTP_JS_DICT_SCAN    64
+
+
+#define ngx_http_js_dict_expired(node, now)                                   \
+    ((node)->expire != 0 && (ngx_msec_int_t) ((node)->expire - (now)) <= 0)
+
+
+typedef struct {
+    ngx_str_node_t       sn;
+    ngx_queue_t          queue;
+    ngx_msec_t           expire;
+    ngx_str_t            value;
+    double               number;
+    u_char               type;
+
+    /*
+     * Set by readers without the write lock, the eviction gives
+     * a second chance to the entries read since the last pass.
+     */
+    u_char               used;
+
+    u_char               data[1];
+} ngx_http_js_dict_node_t;
+
+
 typedef struct {
     ngx_str_t            content;
 } ngx_http_js_loc_conf_t;
 
 
 typedef struct {
-    njs_vm_t            *vm;
-    ngx_log_t           *log;
-    ngx_uint_t           done;
-    ngx_int_t            status;
-    njs_opaque_value_t   request;
-    njs_opaque_value_t   request_body;
-    ngx_str_t            redirect_uri;
+    ngx_uint_t           key;
+    ngx_table_elt_t     *header;
+} ngx_http_js_header_slot_t;
+
+
+typedef struct {
+    ngx_http_js_header_slot_t  *slots;
+    ngx_uint_t                  size;
+    ngx_uint_t                  nelts;
+} ngx_http_js_header_index_t;
+
+
+/* The layout allows ngx_event_ident() to be used in the debug log. */
+
+typedef struct {
+    ngx_http_request_t  *request;
+    void                *unused[2];
+    ngx_int_t            ident;
+} ngx_http_js_event_t;
+
+
+typedef struct {
+    /* The key is the expiration time. */
+    ngx_rbtree_node_t    node;
+
+    njs_vm_event_t       vm_event;
+    ngx_queue_t          queue;
+
+    /* The event is posted to the VM and waits for the release. */
+    unsigned             fired:1;
+} ngx_http_js_timer_t;
+
+
+typedef struct {
+    njs_vm_t                   *vm;
+    ngx_log_t                  *log;
+    ngx_uint_t                  done;
+    ngx_int_t                   status;
+    njs_opaque_value_t          request;
+    njs_opaque_value_t          request_body;
+    ngx_str_t                   redirect_uri;
+    ngx_http_js_header_index_t  headers_in_index;
+    ngx_http_js_header_index_t  headers_out_index;
+
+    /*
+     * All the JS timers of a request share a single nginx timer
+     * which is set to the earliest expiration time.
+     */
+    ngx_event_t                 timer;
+    ngx_http_js_event_t         timer_data;
+    ngx_rbtree_t                timers;
+    ngx_rbtree_node_t           timers_sentinel;
+    ngx_queue_t                 free_timers;
 } ngx_http_js_ctx_t;
 
 
@@ -42,11 +150,42 @@ typedef struct {
 
 
 typedef struct {
-    ngx_http_request_t  *request;
-    njs_vm_event_t       vm_event;
-    void                *unused;
-    ngx_int_t            ident;
-} ngx_http_js_event_t;
+    ngx_str_t            name;
+    ngx_uint_t           offset;
+} ngx_http_js_header_t;
+
+
+typedef struct {
+    nxt_str_t            uri;
+    nxt_str_t            args;
+    nxt_str_t            method_name;
+    nxt_str_t            body;
+    ngx_uint_t           method;
+    unsigned             has_body:1;
+    unsigned             detached:1;
+} ngx_http_js_subrequest_t;
+
+
+typedef struct ngx_http_js_fanout_s  ngx_http_js_fanout_t;
+
+typedef struct {
+    ngx_http_js_fanout_t  *fanout;
+    ngx_uint_t             index;
+    ngx_event_t            timer;
+    unsigned               done:1;
+} ngx_http_js_fanout_item_t;
+
+
+struct ngx_http_js_fanout_s {
+    ngx_http_request_t         *request;
+    njs_vm_t                   *vm;
+    njs_vm_event_t              vm_event;
+    njs_opaque_value_t          replies;
+    ngx_http_js_fanout_item_t  *items;
+    ngx_uint_t                  nitems;
+    ngx_uint_t                  pending;
+    unsigned                    first:1;
+};
 
 
 static ngx_int_t ngx_http_js_content_handler(ngx_http_request_t *r);
@@ -68,6 +207,18 @@ static njs_ret_t ngx_http_js_ext_next_header(njs_vm_t *vm, njs_value_t *value,
     void *obj, void *next);
 static ngx_table_elt_t *ngx_http_js_get_header(ngx_list_part_t *part,
     u_char *data, size_t len);
+static ngx_table_elt_t *ngx_http_js_find_header(ngx_http_request_t *r,
+    ngx_http_js_header_index_t *index, ngx_list_t *headers, u_char *data,
+    size_t len);
+static ngx_int_t ngx_http_js_header_index_init(ngx_http_request_t *r,
+    ngx_http_js_header_index_t *index, ngx_list_t *headers, ngx_uint_t n);
+static void ngx_http_js_header_index_invalidate(ngx_http_request_t *r);
+static ngx_table_elt_t *ngx_http_js_get_header_in(ngx_http_request_t *r,
+    u_char *data, size_t len);
+static ngx_table_elt_t *ngx_http_js_get_header_out(ngx_http_request_t *r,
+    u_char *data, size_t len);
+static njs_ret_t ngx_http_js_ext_get_raw_headers(njs_vm_t *vm,
+    njs_value_t *value, void *obj, uintptr_t data);
 static njs_ret_t ngx_http_js_ext_get_header_out(njs_vm_t *vm,
     njs_value_t *value, void *obj, uintptr_t data);
 static njs_ret_t ngx_http_js_ext_set_header_out(njs_vm_t *vm, void *obj,
@@ -122,21 +273,64 @@ static njs_ret_t ngx_http_js_ext_set_variable(njs_vm_t *vm, void *obj,
        uintptr_t data, nxt_str_t *value);
 static njs_ret_t ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_ext_subrequests(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_subrequest_options(njs_vm_t *vm,
+    const njs_value_t *options, ngx_http_js_subrequest_t *sro);
 static ngx_int_t ngx_http_js_subrequest(ngx_http_request_t *r,
-    nxt_str_t *uri_arg, nxt_str_t *args_arg, njs_function_t *callback,
+    ngx_http_js_subrequest_t *sro, ngx_http_post_subrequest_t *ps,
     ngx_http_request_t **sr);
+static ngx_int_t ngx_http_js_subrequest_set_done(ngx_http_request_t *r);
 static ngx_int_t ngx_http_js_subrequest_done(ngx_http_request_t *r,
     void *data, ngx_int_t rc);
+static ngx_int_t ngx_http_js_fanout_done(ngx_http_request_t *r, void *data,
+    ngx_int_t rc);
+static void ngx_http_js_fanout_timer_handler(ngx_event_t *ev);
+static void ngx_http_js_fanout_item_done(ngx_http_js_fanout_item_t *item,
+    ngx_uint_t success);
+static void ngx_http_js_fanout_finalize(ngx_http_js_fanout_t *fo);
+static void ngx_http_js_fanout_cleanup(void *data);
+static njs_ret_t ngx_http_js_msec(njs_vm_t *vm, const njs_value_t *value,
+    ngx_msec_t *msec);
 static njs_ret_t ngx_http_js_ext_get_parent(njs_vm_t *vm, njs_value_t *value,
     void *obj, uintptr_t data);
 static njs_ret_t ngx_http_js_ext_get_reply_body(njs_vm_t *vm,
     njs_value_t *value, void *obj, uintptr_t data);
 
+static njs_ret_t ngx_http_js_ext_get_shared(njs_vm_t *vm, njs_value_t *value,
+    void *obj, uintptr_t data);
+static njs_ret_t ngx_http_js_ext_dict_get(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_ext_dict_set(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_ext_dict_incr(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_ext_dict_expire(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t ngx_http_js_ext_dict_delete(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static ngx_http_js_dict_t *ngx_http_js_dict_arg(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, ngx_str_t *key);
+static ngx_http_js_dict_node_t *ngx_http_js_dict_lookup(
+    ngx_http_js_dict_t *dict, ngx_str_t *key);
+static ngx_int_t ngx_http_js_dict_add(ngx_http_js_dict_t *dict,
+    ngx_str_t *key, ngx_str_t *value, double number, ngx_uint_t type,
+    ngx_msec_t expire, ngx_msec_t now);
+static void *ngx_http_js_dict_alloc(ngx_http_js_dict_t *dict, size_t size,
+    ngx_msec_t now);
+static void ngx_http_js_dict_delete_node(ngx_http_js_dict_t *dict,
+    ngx_http_js_dict_node_t *node);
+static ngx_msec_t ngx_http_js_dict_expire_time(ngx_msec_t ttl,
+    ngx_msec_t now);
+
 static njs_host_event_t ngx_http_js_set_timer(njs_external_ptr_t external,
     uint64_t delay, njs_vm_event_t vm_event);
 static void ngx_http_js_clear_timer(njs_external_ptr_t external,
     njs_host_event_t event);
 static void ngx_http_js_timer_handler(ngx_event_t *ev);
+static void ngx_http_js_update_timer(ngx_http_js_ctx_t *ctx);
+static void ngx_http_js_run_events(ngx_http_request_t *r,
+    ngx_http_js_ctx_t *ctx);
 static void ngx_http_js_handle_event(ngx_http_request_t *r,
     njs_vm_event_t vm_event, njs_value_t *args, nxt_uint_t nargs);
 static njs_ret_t ngx_http_js_string(njs_vm_t *vm, const njs_value_t *value,
@@ -147,12 +341,27 @@ static char *ngx_http_js_include(ngx_conf_t *cf, ngx_command_t *cmd,
 static char *ngx_http_js_set(ngx_conf_t *cf, ngx_command_t *cmd, void *conf);
 static char *ngx_http_js_content(ngx_conf_t *cf, ngx_command_t *cmd,
     void *conf);
+static char *ngx_http_js_shared_dict_zone(ngx_conf_t *cf, ngx_command_t *cmd,
+    void *conf);
+static ngx_int_t ngx_http_js_dict_init_zone(ngx_shm_zone_t *shm_zone,
+    void *data);
+static ngx_int_t ngx_http_js_init_worker(ngx_cycle_t *cycle);
+static ngx_int_t ngx_http_js_add_variables(ngx_conf_t *cf);
+static ngx_int_t ngx_http_js_mem_peak_variable(ngx_http_request_t *r,
+    ngx_http_variable_value_t *v, uintptr_t data);
+static char *ngx_http_js_before_include(ngx_conf_t *cf, void *post,
+    void *data);
 static void *ngx_http_js_create_main_conf(ngx_conf_t *cf);
+static char *ngx_http_js_init_main_conf(ngx_conf_t *cf, void *conf);
 static void *ngx_http_js_create_loc_conf(ngx_conf_t *cf);
 static char *ngx_http_js_merge_loc_conf(ngx_conf_t *cf, void *parent,
     void *child);
 
 
+static ngx_conf_post_t  ngx_http_js_before_include_post =
+    { ngx_http_js_before_include };
+
+
 static ngx_command_t  ngx_http_js_commands[] = {
 
     { ngx_string("js_include"),
@@ -169,6 +378,48 @@ static ngx_command_t  ngx_http_js_commands[] = {
       offsetof(ngx_http_js_main_conf_t, paths),
       NULL },
 
+    { ngx_string("js_init_worker"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_str_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, init_worker),
+      NULL },
+
+    { ngx_string("js_memory_limit"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_size_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, memory_limit),
+      NULL },
+
+    { ngx_string("js_max_instructions"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_num_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, max_instructions),
+      NULL },
+
+    { ngx_string("js_timeout"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_msec_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, timeout),
+      NULL },
+
+    { ngx_string("js_lazy"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_FLAG,
+      ngx_conf_set_flag_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, lazy),
+      &ngx_http_js_before_include_post },
+
+    { ngx_string("js_jit"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_num_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(ngx_http_js_main_conf_t, jit),
+      &ngx_http_js_before_include_post },
+
     { ngx_string("js_set"),
       NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE2,
       ngx_http_js_set,
@@ -183,16 +434,32 @@ static ngx_command_t  ngx_http_js_commands[] = {
       0,
       NULL },
 
+    { ngx_string("js_shared_dict_zone"),
+      NGX_HTTP_MAIN_CONF|NGX_CONF_1MORE,
+      ngx_http_js_shared_dict_zone,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      0,
+      NULL },
+
       ngx_null_command
 };
 
 
+static ngx_http_variable_t  ngx_http_js_vars[] = {
+
+    { ngx_string("js_mem_peak"), NULL, ngx_http_js_mem_peak_variable,
+      0, NGX_HTTP_VAR_NOCACHEABLE, 0 },
+
+      ngx_http_null_variable
+};
+
+
 static ngx_http_module_t  ngx_http_js_module_ctx = {
-    NULL,                          /* preconfiguration */
+    ngx_http_js_add_variables,     /* preconfiguration */
     NULL,                          /* postconfiguration */
 
     ngx_http_js_create_main_conf,  /* create main configuration */
-    NULL,                          /* init main configuration */
+    ngx_http_js_init_main_conf,    /* init main configuration */
 
     NULL,                          /* create server configuration */
     NULL,                          /* merge server configuration */
@@ -209,7 +476,7 @@ ngx_module_t  ngx_http_js_module = {
     NGX_HTTP_MODULE,               /* module type */
     NULL,                          /* init master */
     NULL,                          /* init module */
-    NULL,                          /* init process */
+    ngx_http_js_init_worker,       /* init process */
     NULL,                          /* init thread */
     NULL,                          /* exit thread */
     NULL,                          /* exit process */
@@ -218,6 +485,90 @@ ngx_module_t  ngx_http_js_module = {
 };
 
 
+static const struct {
+    ngx_str_t   name;
+    ngx_uint_t  value;
+} ngx_http_js_methods[] = {
+    { ngx_string("GET"),       NGX_HTTP_GET },
+    { ngx_string("POST"),      NGX_HTTP_POST },
+    { ngx_string("HEAD"),      NGX_HTTP_HEAD },
+    { ngx_string("OPTIONS"),   NGX_HTTP_OPTIONS },
+    { ngx_string("PROPFIND"),  NGX_HTTP_PROPFIND },
+    { ngx_string("PUT"),       NGX_HTTP_PUT },
+    { ngx_string("MKCOL"),     NGX_HTTP_MKCOL },
+    { ngx_string("DELETE"),    NGX_HTTP_DELETE },
+    { ngx_string("COPY"),      NGX_HTTP_COPY },
+    { ngx_string("MOVE"),      NGX_HTTP_MOVE },
+    { ngx_string("PROPPATCH"), NGX_HTTP_PROPPATCH },
+    { ngx_string("LOCK"),      NGX_HTTP_LOCK },
+    { ngx_string("UNLOCK"),    NGX_HTTP_UNLOCK },
+    { ngx_string("PATCH"),     NGX_HTTP_PATCH },
+    { ngx_string("TRACE"),     NGX_HTTP_TRACE },
+};
+
+
+/*
+ * Request headers which nginx already keeps a pointer to, the first
+ * occurrence of a header is stored in ngx_http_headers_in_t.
+ */
+
+static ngx_http_js_header_t  ngx_http_js_headers_in[] = {
+
+    { ngx_string("Host"),
+      offsetof(ngx_http_headers_in_t, host) },
+
+    { ngx_string("Connection"),
+      offsetof(ngx_http_headers_in_t, connection) },
+
+    { ngx_string("If-Modified-Since"),
+      offsetof(ngx_http_headers_in_t, if_modified_since) },
+
+    { ngx_string("If-Unmodified-Since"),
+      offsetof(ngx_http_headers_in_t, if_unmodified_since) },
+
+    { ngx_string("If-Match"),
+      offsetof(ngx_http_headers_in_t, if_match) },
+
+    { ngx_string("If-None-Match"),
+      offsetof(ngx_http_headers_in_t, if_none_match) },
+
+    { ngx_string("User-Agent"),
+      offsetof(ngx_http_headers_in_t, user_agent) },
+
+    { ngx_string("Referer"),
+      offsetof(ngx_http_headers_in_t, referer) },
+
+    { ngx_string("Content-Length"),
+      offsetof(ngx_http_headers_in_t, content_length) },
+
+    { ngx_string("Content-Type"),
+      offsetof(ngx_http_headers_in_t, content_type) },
+
+    { ngx_string("Range"),
+      offsetof(ngx_http_headers_in_t, range) },
+
+    { ngx_string("If-Range"),
+      offsetof(ngx_http_headers_in_t, if_range) },
+
+    { ngx_string("Transfer-Encoding"),
+      offsetof(ngx_http_headers_in_t, transfer_encoding) },
+
+    { ngx_string("Expect"),
+      offsetof(ngx_http_headers_in_t, expect) },
+
+    { ngx_string("Upgrade"),
+      offsetof(ngx_http_headers_in_t, upgrade) },
+
+    { ngx_string("Authorization"),
+      offsetof(ngx_http_headers_in_t, authorization) },
+
+    { ngx_string("Keep-Alive"),
+      offsetof(ngx_http_headers_in_t, keep_alive) },
+
+    { ngx_null_string, 0 }
+};
+
+
 static njs_external_t  ngx_http_js_ext_request[] = {
 
     { nxt_string("uri"),
@@ -316,6 +667,18 @@ static njs_external_t  ngx_http_js_ext_request[] = {
       NULL,
       0 },
 
+    { nxt_string("rawHeadersIn"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      ngx_http_js_ext_get_raw_headers,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      offsetof(ngx_http_request_t, headers_in.headers) },
+
     { nxt_string("args"),
       NJS_EXTERN_OBJECT,
       NULL,
@@ -364,6 +727,18 @@ static njs_external_t  ngx_http_js_ext_request[] = {
       NULL,
       0 },
 
+    { nxt_string("rawHeadersOut"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      ngx_http_js_ext_get_raw_headers,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      offsetof(ngx_http_request_t, headers_out.headers) },
+
     { nxt_string("subrequest"),
       NJS_EXTERN_METHOD,
       NULL,
@@ -376,6 +751,18 @@ static njs_external_t  ngx_http_js_ext_request[] = {
       ngx_http_js_ext_subrequest,
       0 },
 
+    { nxt_string("subrequests"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_subrequests,
+      0 },
+
     { nxt_string("log"),
       NJS_EXTERN_METHOD,
       NULL,
@@ -474,6 +861,86 @@ static njs_external_t  ngx_http_js_ext_request[] = {
 };
 
 
+static njs_external_t  ngx_http_js_ext_ngx[] = {
+
+    { nxt_string("shared"),
+      NJS_EXTERN_OBJECT,
+      NULL,
+      0,
+      ngx_http_js_ext_get_shared,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+};
+
+
+static njs_external_t  ngx_http_js_ext_shared_dict[] = {
+
+    { nxt_string("get"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_dict_get,
+      0 },
+
+    { nxt_string("set"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_dict_set,
+      0 },
+
+    { nxt_string("incr"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_dict_incr,
+      0 },
+
+    { nxt_string("expire"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_dict_expire,
+      0 },
+
+    { nxt_string("delete"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      ngx_http_js_ext_dict_delete,
+      0 },
+};
+
+
 static njs_external_t  ngx_http_js_externals[] = {
 
     { nxt_string("request"),
@@ -487,6 +954,30 @@ static njs_external_t  ngx_http_js_externals[] = {
       NULL,
       NULL,
       0 },
+
+    { nxt_string("ngx"),
+      NJS_EXTERN_OBJECT,
+      ngx_http_js_ext_ngx,
+      nxt_nitems(ngx_http_js_ext_ngx),
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("SharedDict"),
+      NJS_EXTERN_OBJECT,
+      ngx_http_js_ext_shared_dict,
+      nxt_nitems(ngx_http_js_ext_shared_dict),
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
 };
 
 
@@ -560,7 +1051,9 @@ ngx_http_js_content_event_handler(ngx_http_request_t *r)
 
     ctx->status = NGX_HTTP_INTERNAL_SERVER_ERROR;
 
-    if (njs_vm_call(ctx->vm, func, njs_value_arg(&ctx->request), 1) != NJS_OK) {
+    if (njs_vm_call(ctx->vm, func, njs_value_arg(&ctx->request), 1) != NJS_OK
+        || njs_vm_run(ctx->vm) == NJS_ERROR)
+    {
         njs_vm_retval_to_ext_string(ctx->vm, &exception);
 
         ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
@@ -706,6 +1199,18 @@ ngx_http_js_variable(ngx_http_request_t *r, ngx_http_variable_value_t *v,
         return NGX_ERROR;
     }
 
+    /* Promise jobs queued by the handler are run before it returns. */
+
+    if (!pending && njs_vm_run(ctx->vm) == NJS_ERROR) {
+        njs_vm_retval_to_ext_string(ctx->vm, &exception);
+
+        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
+                      "js exception: %*s", exception.length, exception.start);
+
+        v->not_found = 1;
+        return NGX_OK;
+    }
+
     if (!pending && njs_vm_pending(ctx->vm)) {
         ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
                       "async operation inside \"%V\" variable handler", fname);
@@ -756,8 +1261,22 @@ ngx_http_js_init_vm(ngx_http_request_t *r)
         return NGX_ERROR;
     }
 
-    cln = ngx_pool_cleanup_add(r->pool, 0);
-    if (cln == NULL) {
+    njs_vm_memory_limit(ctx->vm, jmcf->memory_limit);
+    njs_vm_execution_limit(ctx->vm, jmcf->max_instructions, jmcf->timeout);
+
+    ctx->timer_data.request = r;
+    ctx->timer_data.ident = r->connection->fd;
+
+    ctx->timer.data = &ctx->timer_data;
+    ctx->timer.log = r->connection->log;
+    ctx->timer.handler = ngx_http_js_timer_handler;
+
+    ngx_rbtree_init(&ctx->timers, &ctx->timers_sentinel,
+                    ngx_rbtree_insert_timer_value);
+    ngx_queue_init(&ctx->free_timers);
+
+    cln = ngx_pool_cleanup_add(r->pool, 0);
+    if (cln == NULL) {
         return NGX_ERROR;
     }
 
@@ -790,11 +1309,23 @@ ngx_http_js_cleanup_ctx(void *data)
 {
     ngx_http_js_ctx_t *ctx = data;
 
+    nxt_mp_stat_t  stat;
+
     if (njs_vm_pending(ctx->vm)) {
         ngx_log_error(NGX_LOG_ERR, ctx->log, 0, "pending events");
     }
 
+    njs_vm_memory_stats(ctx->vm, &stat);
+
+    ngx_log_debug3(NGX_LOG_DEBUG_HTTP, ctx->log, 0,
+                   "http js vm memory peak:%uz allocations:%ui large:%ui",
+                   stat.peak, stat.allocations, stat.large);
+
     njs_vm_destroy(ctx->vm);
+
+    if (ctx->timer.timer_set) {
+        ngx_del_timer(&ctx->timer);
+    }
 }
 
 
@@ -918,6 +1449,294 @@ ngx_http_js_get_header(ngx_list_part_t *part, u_char *data, size_t len)
 }
 
 
+static ngx_table_elt_t *
+ngx_http_js_find_header(ngx_http_request_t *r,
+    ngx_http_js_header_index_t *index, ngx_list_t *headers, u_char *data,
+    size_t len)
+{
+    ngx_uint_t                  n, i, key, mask;
+    ngx_list_part_t            *part;
+    ngx_table_elt_t            *h;
+    ngx_http_js_header_slot_t  *slot;
+
+    n = 0;
+
+    for (part = &headers->part; part != NULL; part = part->next) {
+        n += part->nelts;
+    }
+
+    if (n < NGX_HTTP_JS_HEADER_INDEX_MIN) {
+        return ngx_http_js_get_header(&headers->part, data, len);
+    }
+
+    /*
+     * The index is rebuilt when the list has grown since the last lookup,
+     * headers added by nginx itself or by other modules are noticed this way.
+     */
+
+    if (index->nelts != n) {
+        if (ngx_http_js_header_index_init(r, index, headers, n) != NGX_OK) {
+            return ngx_http_js_get_header(&headers->part, data, len);
+        }
+    }
+
+    key = ngx_hash_key_lc(data, len);
+    mask = index->size - 1;
+
+    for (i = key & mask; /* void */ ; i = (i + 1) & mask) {
+        slot = &index->slots[i];
+        h = slot->header;
+
+        if (h == NULL) {
+            return NULL;
+        }
+
+        if (slot->key != key
+            || h->key.len != len
+            || ngx_strncasecmp(h->key.data, data, len) != 0)
+        {
+            continue;
+        }
+
+        if (h->hash == 0) {
+
+            /* the header was removed, a duplicate may follow it */
+
+            index->nelts = 0;
+
+            return ngx_http_js_get_header(&headers->part, data, len);
+        }
+
+        return h;
+    }
+}
+
+
+static ngx_int_t
+ngx_http_js_header_index_init(ngx_http_request_t *r,
+    ngx_http_js_header_index_t *index, ngx_list_t *headers, ngx_uint_t n)
+{
+    ngx_uint_t                  i, j, key, mask, size;
+    ngx_list_part_t            *part;
+    ngx_table_elt_t            *header, *h, *e;
+    ngx_http_js_header_slot_t  *slot;
+
+    size = 16;
+
+    while (size < n * 2) {
+        size <<= 1;
+    }
+
+    if (index->slots == NULL || index->size < size) {
+        index->slots = ngx_pcalloc(r->pool,
+                                   size * sizeof(ngx_http_js_header_slot_t));
+        if (index->slots == NULL) {
+            return NGX_ERROR;
+        }
+
+        index->size = size;
+
+    } else {
+        ngx_memzero(index->slots,
+                    index->size * sizeof(ngx_http_js_header_slot_t));
+    }
+
+    mask = index->size - 1;
+
+    part = &headers->part;
+    header = part->elts;
+
+    for (i = 0; /* void */ ; i++) {
+
+        if (i >= part->nelts) {
+            if (part->next == NULL) {
+                break;
+            }
+
+            part = part->next;
+            header = part->elts;
+            i = 0;
+        }
+
+        h = &header[i];
+
+        if (h->hash == 0) {
+            continue;
+        }
+
+        key = ngx_hash_key_lc(h->key.data, h->key.len);
+
+        for (j = key & mask; /* void */ ; j = (j + 1) & mask) {
+            slot = &index->slots[j];
+            e = slot->header;
+
+            if (e == NULL) {
+                slot->key = key;
+                slot->header = h;
+                break;
+            }
+
+            /* the first of duplicate headers wins, as in the list scan */
+
+            if (slot->key == key
+                && e->key.len == h->key.len
+                && ngx_strncasecmp(e->key.data, h->key.data, h->key.len) == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    index->nelts = n;
+
+    return NGX_OK;
+}
+
+
+static void
+ngx_http_js_header_index_invalidate(ngx_http_request_t *r)
+{
+    ngx_http_js_ctx_t  *ctx;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx != NULL) {
+        ctx->headers_out_index.nelts = 0;
+    }
+}
+
+
+static ngx_table_elt_t *
+ngx_http_js_get_header_in(ngx_http_request_t *r, u_char *data, size_t len)
+{
+    ngx_uint_t                key;
+    ngx_http_js_ctx_t        *ctx;
+    ngx_http_js_header_t     *hh;
+    ngx_http_js_main_conf_t  *jmcf;
+    u_char                    lowcase[NGX_HTTP_JS_HEADER_LEN];
+
+    if (len <= NGX_HTTP_JS_HEADER_LEN) {
+        key = ngx_hash_strlow(lowcase, data, len);
+
+        jmcf = ngx_http_get_module_main_conf(r, ngx_http_js_module);
+
+        hh = ngx_hash_find(&jmcf->headers_in_hash, key, lowcase, len);
+
+        if (hh != NULL) {
+            return *(ngx_table_elt_t **) ((char *) &r->headers_in
+                                          + hh->offset);
+        }
+    }
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx == NULL) {
+        return ngx_http_js_get_header(&r->headers_in.headers.part, data, len);
+    }
+
+    return ngx_http_js_find_header(r, &ctx->headers_in_index,
+                                   &r->headers_in.headers, data, len);
+}
+
+
+static ngx_table_elt_t *
+ngx_http_js_get_header_out(ngx_http_request_t *r, u_char *data, size_t len)
+{
+    ngx_http_js_ctx_t  *ctx;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx == NULL) {
+        return ngx_http_js_get_header(&r->headers_out.headers.part, data, len);
+    }
+
+    return ngx_http_js_find_header(r, &ctx->headers_out_index,
+                                   &r->headers_out.headers, data, len);
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_get_raw_headers(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    char *p = obj;
+
+    njs_ret_t         rc;
+    ngx_uint_t        i, n;
+    ngx_list_t       *headers;
+    njs_value_t      *entry, *elt;
+    ngx_list_part_t  *part;
+    ngx_table_elt_t  *header, *h;
+
+    headers = (ngx_list_t *) (p + data);
+
+    n = 0;
+
+    for (part = &headers->part; part != NULL; part = part->next) {
+        n += part->nelts;
+    }
+
+    rc = njs_vm_array_alloc(vm, value, n);
+    if (rc != NJS_OK) {
+        return NJS_ERROR;
+    }
+
+    part = &headers->part;
+    header = part->elts;
+
+    for (i = 0; /* void */ ; i++) {
+
+        if (i >= part->nelts) {
+            if (part->next == NULL) {
+                break;
+            }
+
+            part = part->next;
+            header = part->elts;
+            i = 0;
+        }
+
+        h = &header[i];
+
+        if (h->hash == 0) {
+            continue;
+        }
+
+        entry = njs_vm_array_push(vm, value);
+        if (entry == NULL) {
+            return NJS_ERROR;
+        }
+
+        rc = njs_vm_array_alloc(vm, entry, 2);
+        if (rc != NJS_OK) {
+            return NJS_ERROR;
+        }
+
+        elt = njs_vm_array_push(vm, entry);
+        if (elt == NULL) {
+            return NJS_ERROR;
+        }
+
+        rc = njs_vm_value_string_set(vm, elt, h->key.data, h->key.len);
+        if (rc != NJS_OK) {
+            return NJS_ERROR;
+        }
+
+        elt = njs_vm_array_push(vm, entry);
+        if (elt == NULL) {
+            return NJS_ERROR;
+        }
+
+        rc = njs_vm_value_string_set(vm, elt, h->value.data, h->value.len);
+        if (rc != NJS_OK) {
+            return NJS_ERROR;
+        }
+    }
+
+    return NJS_OK;
+}
+
+
 static njs_ret_t
 ngx_http_js_ext_get_header_out(njs_vm_t *vm, njs_value_t *value, void *obj,
     uintptr_t data)
@@ -960,8 +1779,7 @@ ngx_http_js_ext_get_header_out(njs_vm_t *vm, njs_value_t *value, void *obj,
         }
     }
 
-    h = ngx_http_js_get_header(&r->headers_out.headers.part, v->start,
-                               v->length);
+    h = ngx_http_js_get_header_out(r, v->start, v->length);
     if (h == NULL) {
         njs_value_undefined_set(value);
         return NJS_OK;
@@ -996,12 +1814,13 @@ ngx_http_js_ext_set_header_out(njs_vm_t *vm, void *obj, uintptr_t data,
         return NJS_OK;
     }
 
-    h = ngx_http_js_get_header(&r->headers_out.headers.part, v->start,
-                               v->length);
+    h = ngx_http_js_get_header_out(r, v->start, v->length);
 
     if (h != NULL && value->length == 0) {
         h->hash = 0;
         h = NULL;
+
+        ngx_http_js_header_index_invalidate(r);
     }
 
     if (h == NULL && value->length != 0) {
@@ -1010,6 +1829,8 @@ ngx_http_js_ext_set_header_out(njs_vm_t *vm, void *obj, uintptr_t data,
             return NJS_ERROR;
         }
 
+        ngx_http_js_header_index_invalidate(r);
+
         p = ngx_pnalloc(r->pool, v->length);
         if (p == NULL) {
             return NJS_ERROR;
@@ -1521,8 +2342,7 @@ ngx_http_js_ext_get_header_in(njs_vm_t *vm, njs_value_t *value, void *obj,
     r = (ngx_http_request_t *) obj;
     v = (nxt_str_t *) data;
 
-    h = ngx_http_js_get_header(&r->headers_in.headers.part, v->start,
-                               v->length);
+    h = ngx_http_js_get_header_in(r, v->start, v->length);
     if (h == NULL) {
         njs_value_undefined_set(value);
         return NJS_OK;
@@ -1726,40 +2546,16 @@ static njs_ret_t
 ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    ngx_int_t                 rc;
-    nxt_str_t                 uri_arg, args_arg, method_name, body_arg;
-    ngx_uint_t                method, methods_max, has_body;
-    njs_value_t              *value;
-    njs_function_t           *callback;
-    ngx_http_js_ctx_t        *ctx;
-    const njs_value_t        *arg, *options;
-    ngx_http_request_t       *r, *sr;
-    ngx_http_request_body_t  *rb;
-
-    static const struct {
-        ngx_str_t   name;
-        ngx_uint_t  value;
-    } methods[] = {
-        { ngx_string("GET"),       NGX_HTTP_GET },
-        { ngx_string("POST"),      NGX_HTTP_POST },
-        { ngx_string("HEAD"),      NGX_HTTP_HEAD },
-        { ngx_string("OPTIONS"),   NGX_HTTP_OPTIONS },
-        { ngx_string("PROPFIND"),  NGX_HTTP_PROPFIND },
-        { ngx_string("PUT"),       NGX_HTTP_PUT },
-        { ngx_string("MKCOL"),     NGX_HTTP_MKCOL },
-        { ngx_string("DELETE"),    NGX_HTTP_DELETE },
-        { ngx_string("COPY"),      NGX_HTTP_COPY },
-        { ngx_string("MOVE"),      NGX_HTTP_MOVE },
-        { ngx_string("PROPPATCH"), NGX_HTTP_PROPPATCH },
-        { ngx_string("LOCK"),      NGX_HTTP_LOCK },
-        { ngx_string("UNLOCK"),    NGX_HTTP_UNLOCK },
-        { ngx_string("PATCH"),     NGX_HTTP_PATCH },
-        { ngx_string("TRACE"),     NGX_HTTP_TRACE },
-    };
-
-    static const nxt_str_t args_key   = nxt_string("args");
-    static const nxt_str_t method_key = nxt_string("method");
-    static const nxt_str_t body_key = nxt_string("body");
+    ngx_int_t                    rc;
+    nxt_bool_t                   promised;
+    njs_vm_event_t               vm_event;
+    njs_function_t              *callback;
+    ngx_http_js_ctx_t           *ctx;
+    njs_opaque_value_t           promise, callbacks[2];
+    const njs_value_t           *arg, *options;
+    ngx_http_request_t          *r, *sr;
+    ngx_http_js_subrequest_t     sro;
+    ngx_http_post_subrequest_t  *ps;
 
     r = njs_vm_external(vm, njs_arg(args, nargs, 0));
     if (nxt_slow_path(r == NULL)) {
@@ -1774,12 +2570,14 @@ ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
-    if (ngx_http_js_string(vm, njs_arg(args, nargs, 1), &uri_arg) != NJS_OK) {
+    ngx_memzero(&sro, sizeof(ngx_http_js_subrequest_t));
+
+    if (ngx_http_js_string(vm, njs_arg(args, nargs, 1), &sro.uri) != NJS_OK) {
         njs_vm_error(vm, "failed to convert uri arg");
         return NJS_ERROR;
     }
 
-    if (uri_arg.length == 0) {
+    if (sro.uri.length == 0) {
         njs_vm_error(vm, "uri is empty");
         return NJS_ERROR;
     }
@@ -1787,17 +2585,10 @@ ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     options = NULL;
     callback = NULL;
 
-    method = 0;
-    methods_max = sizeof(methods) / sizeof(methods[0]);
-
-    args_arg.length = 0;
-    args_arg.start = NULL;
-    has_body = 0;
-
     arg = njs_arg(args, nargs, 2);
 
     if (njs_value_is_string(arg)) {
-        if (njs_vm_value_to_ext_string(vm, &args_arg, arg, 0) != NJS_OK) {
+        if (njs_vm_value_to_ext_string(vm, &sro.args, arg, 0) != NJS_OK) {
             njs_vm_error(vm, "failed to convert args");
             return NJS_ERROR;
         }
@@ -1814,42 +2605,8 @@ ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     }
 
     if (options != NULL) {
-        value = njs_vm_object_prop(vm, options, &args_key);
-        if (value != NULL) {
-            if (ngx_http_js_string(vm, value, &args_arg) != NJS_OK) {
-                njs_vm_error(vm, "failed to convert options.args");
-                return NJS_ERROR;
-            }
-        }
-
-        value = njs_vm_object_prop(vm, options, &method_key);
-        if (value != NULL) {
-            if (ngx_http_js_string(vm, value, &method_name) != NJS_OK) {
-                njs_vm_error(vm, "failed to convert options.method");
-                return NJS_ERROR;
-            }
-
-            while (method < methods_max) {
-                if (method_name.length == methods[method].name.len
-                    && ngx_memcmp(method_name.start, methods[method].name.data,
-                                  method_name.length)
-                       == 0)
-                {
-                    break;
-                }
-
-                method++;
-            }
-        }
-
-        value = njs_vm_object_prop(vm, options, &body_key);
-        if (value != NULL) {
-            if (ngx_http_js_string(vm, value, &body_arg) != NJS_OK) {
-                njs_vm_error(vm, "failed to convert options.body");
-                return NJS_ERROR;
-            }
-
-            has_body = 1;
+        if (ngx_http_js_subrequest_options(vm, options, &sro) != NJS_OK) {
+            return NJS_ERROR;
         }
     }
 
@@ -1865,231 +2622,1243 @@ ngx_http_js_ext_subrequest(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         }
     }
 
-    rc  = ngx_http_js_subrequest(r, &uri_arg, &args_arg, callback, &sr);
-    if (rc != NGX_OK) {
+    if (callback != NULL && sro.detached) {
+        njs_vm_error(vm, "detached subrequest cannot have a callback");
         return NJS_ERROR;
     }
 
-    if (method != methods_max) {
-        sr->method = methods[method].value;
-        sr->method_name = methods[method].name;
+    /*
+     * A subrequest without a callback returns a promise which is
+     * resolved with the reply, unless the "detached" option is set:
+     * then the subrequest is not waited for.
+     */
+
+    promised = (callback == NULL && !sro.detached);
 
-    } else {
-        sr->method = NGX_HTTP_UNKNOWN;
-        sr->method_name.len = method_name.length;
-        sr->method_name.data = method_name.start;
+    if (promised) {
+        if (njs_vm_promise_create(vm, njs_value_arg(&promise),
+                                  njs_value_arg(&callbacks))
+            != NJS_OK)
+        {
+            njs_vm_error(vm, "internal error");
+            return NJS_ERROR;
+        }
+
+        callback = njs_value_function(njs_value_arg(&callbacks[0]));
     }
 
-    sr->header_only = (sr->method == NGX_HTTP_HEAD) || (callback == NULL);
+    ps = NULL;
+    vm_event = NULL;
 
-    if (has_body) {
-        rb = ngx_pcalloc(r->pool, sizeof(ngx_http_request_body_t));
-        if (rb == NULL) {
-            goto memory_error;
+    if (callback != NULL) {
+        ps = ngx_palloc(r->pool, sizeof(ngx_http_post_subrequest_t));
+        if (ps == NULL) {
+            njs_vm_error(vm, "internal error");
+            return NJS_ERROR;
         }
 
-        if (body_arg.length != 0) {
-            rb->bufs = ngx_alloc_chain_link(r->pool);
-            if (rb->bufs == NULL) {
-                goto memory_error;
-            }
+        vm_event = njs_vm_add_event(vm, callback, 1, NULL, NULL);
+        if (vm_event == NULL) {
+            njs_vm_error(vm, "internal error");
+            return NJS_ERROR;
+        }
 
-            rb->bufs->next = NULL;
+        ps->handler = ngx_http_js_subrequest_done;
+        ps->data = vm_event;
+    }
+
+    rc = ngx_http_js_subrequest(r, &sro, ps, &sr);
+    if (rc != NGX_OK) {
+        if (vm_event != NULL) {
+            njs_vm_del_event(vm, vm_event);
+        }
+
+        return NJS_ERROR;
+    }
+
+    if (promised) {
+        njs_vm_retval_set(vm, njs_value_arg(&promise));
+    }
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_subrequests(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    uint32_t                     i, n;
+    ngx_int_t                    rc;
+    ngx_msec_t                   timeout, item_timeout;
+    njs_value_t                 *requests, *request, *reply;
+    njs_function_t              *callback;
+    ngx_pool_cleanup_t          *cln;
+    ngx_http_js_ctx_t           *ctx;
+    const njs_value_t           *arg, *options, *value;
+    ngx_http_request_t          *r, *sr;
+    ngx_http_js_fanout_t        *fo;
+    ngx_http_js_subrequest_t     sro;
+    ngx_http_js_fanout_item_t   *item;
+    ngx_http_post_subrequest_t  *ps;
+
+    static const nxt_str_t uri_key = nxt_string("uri");
+    static const nxt_str_t first_key = nxt_string("first");
+    static const nxt_str_t timeout_key = nxt_string("timeout");
+
+    r = njs_vm_external(vm, njs_arg(args, nargs, 0));
+    if (nxt_slow_path(r == NULL)) {
+        return NJS_ERROR;
+    }
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx->vm != vm) {
+        njs_vm_error(vm, "subrequests can only be created for "
+                         "the primary request");
+        return NJS_ERROR;
+    }
+
+    requests = njs_value_arg(njs_arg(args, nargs, 1));
+
+    if (!njs_value_is_array(requests)) {
+        njs_vm_error(vm, "requests is not an array");
+        return NJS_ERROR;
+    }
+
+    if (njs_vm_array_length(vm, requests, &n) != NJS_OK) {
+        return NJS_ERROR;
+    }
+
+    if (n == 0) {
+        njs_vm_error(vm, "requests are empty");
+        return NJS_ERROR;
+    }
+
+    options = NULL;
+
+    arg = njs_arg(args, nargs, 2);
+
+    if (!njs_value_is_function(arg)) {
+        if (njs_value_is_object(arg)) {
+            options = arg;
+
+        } else if (!njs_value_is_null_or_undefined(arg)) {
+            njs_vm_error(vm, "options is not an object");
+            return NJS_ERROR;
+        }
+
+        arg = njs_arg(args, nargs, 3);
+
+        if (!njs_value_is_function(arg)) {
+            njs_vm_error(vm, "callback is not a function");
+            return NJS_ERROR;
+        }
+    }
+
+    callback = njs_value_function(arg);
+
+    fo = ngx_pcalloc(r->pool, sizeof(ngx_http_js_fanout_t));
+    if (fo == NULL) {
+        goto memory_error;
+    }
+
+    fo->items = ngx_pcalloc(r->pool, n * sizeof(ngx_http_js_fanout_item_t));
+    if (fo->items == NULL) {
+        goto memory_error;
+    }
+
+    fo->request = r;
+    fo->vm = vm;
+    fo->nitems = n;
+    fo->pending = n;
+
+    timeout = 0;
+
+    if (options != NULL) {
+        value = njs_vm_object_prop(vm, options, &timeout_key);
+        if (value != NULL) {
+            if (ngx_http_js_msec(vm, value, &timeout) != NJS_OK) {
+                njs_vm_error(vm, "failed to convert options.timeout");
+                return NJS_ERROR;
+            }
+        }
+
+        value = njs_vm_object_prop(vm, options, &first_key);
+        if (value != NULL) {
+            fo->first = njs_value_bool(value);
+        }
+    }
+
+    if (njs_vm_array_alloc(vm, njs_value_arg(&fo->replies), n) != NJS_OK) {
+        return NJS_ERROR;
+    }
+
+    for (i = 0; i < n; i++) {
+        reply = njs_vm_array_push(vm, njs_value_arg(&fo->replies));
+        if (reply == NULL) {
+            return NJS_ERROR;
+        }
+    }
+
+    cln = ngx_pool_cleanup_add(r->pool, 0);
+    if (cln == NULL) {
+        goto memory_error;
+    }
+
+    cln->handler = ngx_http_js_fanout_cleanup;
+    cln->data = fo;
+
+    fo->vm_event = njs_vm_add_event(vm, callback, 1, NULL, NULL);
+    if (fo->vm_event == NULL) {
+        goto memory_error;
+    }
+
+    /*
+     * The requests array is not modified while subrequests are created,
+     * so its start can be fetched once.
+     */
+
+    request = njs_vm_array_start(vm, requests);
+
+    for (i = 0; i < n; i++) {
+        item = &fo->items[i];
+
+        item->fanout = fo;
+        item->index = i;
+
+        item_timeout = timeout;
+
+        ngx_memzero(&sro, sizeof(ngx_http_js_subrequest_t));
+
+        value = &request[i];
+
+        if (njs_value_is_string(value)) {
+            if (ngx_http_js_string(vm, value, &sro.uri) != NJS_OK) {
+                njs_vm_error(vm, "failed to convert requests[%uD]", i);
+                goto failed;
+            }
+
+        } else if (njs_value_is_object(value)) {
+            arg = njs_vm_object_prop(vm, value, &uri_key);
+            if (arg == NULL || ngx_http_js_string(vm, arg, &sro.uri) != NJS_OK)
+            {
+                njs_vm_error(vm, "failed to convert requests[%uD].uri", i);
+                goto failed;
+            }
+
+            if (ngx_http_js_subrequest_options(vm, value, &sro) != NJS_OK) {
+                goto failed;
+            }
+
+            arg = njs_vm_object_prop(vm, value, &timeout_key);
+            if (arg != NULL) {
+                if (ngx_http_js_msec(vm, arg, &item_timeout) != NJS_OK) {
+                    njs_vm_error(vm, "failed to convert requests[%uD].timeout",
+                                 i);
+                    goto failed;
+                }
+            }
+
+        } else {
+            njs_vm_error(vm, "failed to convert requests[%uD]", i);
+            goto failed;
+        }
+
+        if (sro.uri.length == 0) {
+            njs_vm_error(vm, "uri is empty");
+            goto failed;
+        }
+
+        ps = ngx_palloc(r->pool, sizeof(ngx_http_post_subrequest_t));
+        if (ps == NULL) {
+            njs_vm_error(vm, "internal error");
+            goto failed;
+        }
+
+        ps->handler = ngx_http_js_fanout_done;
+        ps->data = item;
+
+        rc = ngx_http_js_subrequest(r, &sro, ps, &sr);
+        if (rc != NGX_OK) {
+            goto failed;
+        }
+
+        if (item_timeout) {
+            item->timer.handler = ngx_http_js_fanout_timer_handler;
+            item->timer.data = item;
+            item->timer.log = r->connection->log;
+
+            ngx_add_timer(&item->timer, item_timeout);
+        }
+    }
+
+    return NJS_OK;
+
+failed:
+
+    /* subrequests already created are left to complete unnoticed */
+
+    ngx_http_js_fanout_finalize(fo);
+
+    njs_vm_del_event(vm, fo->vm_event);
+
+    return NJS_ERROR;
+
+memory_error:
+
+    njs_vm_error(vm, "internal error");
+
+    return NJS_ERROR;
+}
+
+
+static njs_ret_t
+ngx_http_js_subrequest_options(njs_vm_t *vm, const njs_value_t *options,
+    ngx_http_js_subrequest_t *sro)
+{
+    ngx_uint_t          methods_max;
+    const njs_value_t  *value;
+
+    static const nxt_str_t args_key   = nxt_string("args");
+    static const nxt_str_t method_key = nxt_string("method");
+    static const nxt_str_t body_key = nxt_string("body");
+    static const nxt_str_t detached_key = nxt_string("detached");
+
+    methods_max = sizeof(ngx_http_js_methods) / sizeof(ngx_http_js_methods[0]);
+
+    value = njs_vm_object_prop(vm, options, &args_key);
+    if (value != NULL) {
+        if (ngx_http_js_string(vm, value, &sro->args) != NJS_OK) {
+            njs_vm_error(vm, "failed to convert options.args");
+            return NJS_ERROR;
+        }
+    }
+
+    value = njs_vm_object_prop(vm, options, &method_key);
+    if (value != NULL) {
+        if (ngx_http_js_string(vm, value, &sro->method_name) != NJS_OK) {
+            njs_vm_error(vm, "failed to convert options.method");
+            return NJS_ERROR;
+        }
+
+        while (sro->method < methods_max) {
+            if (sro->method_name.length
+                == ngx_http_js_methods[sro->method].name.len
+                && ngx_memcmp(sro->method_name.start,
+                              ngx_http_js_methods[sro->method].name.data,
+                              sro->method_name.length)
+                   == 0)
+            {
+                break;
+            }
+
+            sro->method++;
+        }
+    }
+
+    value = njs_vm_object_prop(vm, options, &body_key);
+    if (value != NULL) {
+        if (ngx_http_js_string(vm, value, &sro->body) != NJS_OK) {
+            njs_vm_error(vm, "failed to convert options.body");
+            return NJS_ERROR;
+        }
+
+        sro->has_body = 1;
+    }
+
+    value = njs_vm_object_prop(vm, options, &detached_key);
+    if (value != NULL) {
+        sro->detached = njs_value_bool(value);
+    }
+
+    return NJS_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_subrequest(ngx_http_request_t *r, ngx_http_js_subrequest_t *sro,
+    ngx_http_post_subrequest_t *ps, ngx_http_request_t **sr)
+{
+    ngx_int_t                 flags;
+    ngx_str_t                 uri, args;
+    ngx_uint_t                methods_max;
+    ngx_http_js_ctx_t        *ctx;
+    ngx_http_request_body_t  *rb;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    methods_max = sizeof(ngx_http_js_methods) / sizeof(ngx_http_js_methods[0]);
+
+    rb = NULL;
+
+    if (sro->has_body) {
+        rb = ngx_pcalloc(r->pool, sizeof(ngx_http_request_body_t));
+        if (rb == NULL) {
+            goto memory_error;
+        }
+
+        if (sro->body.length != 0) {
+            rb->bufs = ngx_alloc_chain_link(r->pool);
+            if (rb->bufs == NULL) {
+                goto memory_error;
+            }
+
+            rb->bufs->next = NULL;
+
+            rb->bufs->buf = ngx_calloc_buf(r->pool);
+            if (rb->bufs->buf == NULL) {
+                goto memory_error;
+            }
+
+            rb->bufs->buf->memory = 1;
+            rb->bufs->buf->last_buf = 1;
+
+            rb->bufs->buf->pos = sro->body.start;
+            rb->bufs->buf->last = sro->body.start + sro->body.length;
+        }
+    }
+
+    flags = NGX_HTTP_SUBREQUEST_BACKGROUND;
+
+    if (ps != NULL) {
+        flags |= NGX_HTTP_SUBREQUEST_IN_MEMORY;
+    }
+
+    uri.len = sro->uri.length;
+    uri.data = sro->uri.start;
+
+    args.len = sro->args.length;
+    args.data = sro->args.start;
+
+    if (ngx_http_subrequest(r, &uri, args.len ? &args : NULL, sr, ps, flags)
+        != NGX_OK)
+    {
+        njs_vm_error(ctx->vm, "subrequest creation failed");
+        return NJS_ERROR;
+    }
+
+    if (sro->method != methods_max) {
+        (*sr)->method = ngx_http_js_methods[sro->method].value;
+        (*sr)->method_name = ngx_http_js_methods[sro->method].name;
+
+    } else {
+        (*sr)->method = NGX_HTTP_UNKNOWN;
+        (*sr)->method_name.len = sro->method_name.length;
+        (*sr)->method_name.data = sro->method_name.start;
+    }
+
+    (*sr)->header_only = ((*sr)->method == NGX_HTTP_HEAD) || (ps == NULL);
+
+    if (rb != NULL) {
+        (*sr)->request_body = rb;
+        (*sr)->headers_in.content_length_n = sro->body.length;
+        (*sr)->headers_in.chunked = 0;
+    }
+
+    return NGX_OK;
+
+memory_error:
+
+    njs_vm_error(ctx->vm, "internal error");
+
+    return NJS_ERROR;
+}
+
+
+static ngx_int_t
+ngx_http_js_subrequest_set_done(ngx_http_request_t *r)
+{
+    ngx_http_js_ctx_t  *ctx;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx && ctx->done) {
+        return NGX_DONE;
+    }
+
+    if (ctx == NULL) {
+        ctx = ngx_pcalloc(r->pool, sizeof(ngx_http_js_ctx_t));
+        if (ctx == NULL) {
+            return NGX_ERROR;
+        }
+
+        ngx_http_set_ctx(r, ctx, ngx_http_js_module);
+    }
+
+    ctx->done = 1;
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_subrequest_done(ngx_http_request_t *r, void *data, ngx_int_t rc)
+{
+    njs_vm_event_t  vm_event = data;
+
+    nxt_int_t                 ret;
+    ngx_http_js_ctx_t        *ctx;
+    njs_opaque_value_t        reply;
+    ngx_http_js_main_conf_t  *jmcf;
+
+    if (rc != NGX_OK || r->connection->error || r->buffered) {
+        return rc;
+    }
+
+    rc = ngx_http_js_subrequest_set_done(r);
+    if (rc != NGX_OK) {
+        return (rc == NGX_DONE) ? NGX_OK : NGX_ERROR;
+    }
+
+    jmcf = ngx_http_get_module_main_conf(r, ngx_http_js_module);
+
+    ctx = ngx_http_get_module_ctx(r->parent, ngx_http_js_module);
+
+    ngx_log_debug2(NGX_LOG_DEBUG_HTTP, r->connection->log, 0,
+                   "js subrequest done s: %ui parent ctx: %p",
+                   r->headers_out.status, ctx);
+
+    if (ctx == NULL) {
+        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
+                      "js subrequest: failed to get the parent context");
+
+        return NGX_ERROR;
+    }
+
+    ret = njs_vm_external_create(ctx->vm, njs_value_arg(&reply),
+                                 jmcf->req_proto, r);
+    if (ret != NXT_OK) {
+        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
+                      "js subrequest reply creation failed");
+
+        return NGX_ERROR;
+    }
+
+    ngx_http_js_handle_event(r->parent, vm_event, njs_value_arg(&reply), 1);
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_fanout_done(ngx_http_request_t *r, void *data, ngx_int_t rc)
+{
+    ngx_http_js_fanout_item_t  *item = data;
+
+    nxt_int_t                 ret;
+    njs_value_t              *reply;
+    ngx_http_js_fanout_t     *fo;
+    ngx_http_js_main_conf_t  *jmcf;
+
+    if (rc != NGX_OK || r->connection->error) {
+
+        /*
+         * The handler is not called again for a failed subrequest,
+         * its reply slot is left undefined.
+         */
+
+        ngx_log_debug2(NGX_LOG_DEBUG_HTTP, r->connection->log, 0,
+                       "js subrequests item %ui failed rc: %i",
+                       item->index, rc);
+
+        if (!item->done) {
+            ngx_http_js_fanout_item_done(item, 0);
+        }
+
+        return rc;
+    }
+
+    if (r->buffered) {
+        return rc;
+    }
+
+    rc = ngx_http_js_subrequest_set_done(r);
+    if (rc != NGX_OK) {
+        if (rc == NGX_DONE) {
+            return NGX_OK;
+        }
+
+        if (!item->done) {
+            ngx_http_js_fanout_item_done(item, 0);
+        }
+
+        return NGX_ERROR;
+    }
+
+    fo = item->fanout;
+
+    ngx_log_debug3(NGX_LOG_DEBUG_HTTP, r->connection->log, 0,
+                   "js subrequests item %ui done s: %ui ignored: %ui",
+                   item->index, r->headers_out.status, item->done);
+
+    if (item->done) {
+
+        /* timed out or the group has already completed */
+
+        return NGX_OK;
+    }
+
+    jmcf = ngx_http_get_module_main_conf(r, ngx_http_js_module);
+
+    reply = njs_vm_array_start(fo->vm, njs_value_arg(&fo->replies));
+
+    ret = njs_vm_external_create(fo->vm, &reply[item->index], jmcf->req_proto,
+                                 r);
+    if (ret != NXT_OK) {
+        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
+                      "js subrequest reply creation failed");
+
+        ngx_http_js_fanout_item_done(item, 0);
+
+        return NGX_ERROR;
+    }
+
+    ngx_http_js_fanout_item_done(item, r->headers_out.status >= NGX_HTTP_OK
+                                       && r->headers_out.status
+                                          < NGX_HTTP_SPECIAL_RESPONSE);
+
+    return NGX_OK;
+}
+
+
+static void
+ngx_http_js_fanout_timer_handler(ngx_event_t *ev)
+{
+    ngx_connection_t           *c;
+    ngx_http_js_fanout_item_t  *item;
+
+    item = ev->data;
+
+    c = item->fanout->request->connection;
+
+    ngx_log_debug1(NGX_LOG_DEBUG_HTTP, c->log, 0,
+                   "js subrequests item %ui timed out", item->index);
+
+    ngx_http_js_fanout_item_done(item, 0);
+
+    ngx_http_run_posted_requests(c);
+}
+
+
+static void
+ngx_http_js_fanout_item_done(ngx_http_js_fanout_item_t *item,
+    ngx_uint_t success)
+{
+    ngx_http_js_fanout_t  *fo;
+
+    fo = item->fanout;
+
+    item->done = 1;
+
+    if (item->timer.timer_set) {
+        ngx_del_timer(&item->timer);
+    }
+
+    fo->pending--;
+
+    if (fo->pending != 0 && !(fo->first && success)) {
+        return;
+    }
+
+    ngx_http_js_fanout_finalize(fo);
+
+    ngx_http_js_handle_event(fo->request, fo->vm_event,
+                             njs_value_arg(&fo->replies), 1);
+}
+
+
+static void
+ngx_http_js_fanout_finalize(ngx_http_js_fanout_t *fo)
+{
+    ngx_uint_t                  i;
+    ngx_http_js_fanout_item_t  *item;
+
+    for (i = 0; i < fo->nitems; i++) {
+        item = &fo->items[i];
+
+        item->done = 1;
+
+        if (item->timer.timer_set) {
+            ngx_del_timer(&item->timer);
+        }
+    }
+}
+
+
+static void
+ngx_http_js_fanout_cleanup(void *data)
+{
+    ngx_http_js_fanout_t *fo = data;
+
+    ngx_http_js_fanout_finalize(fo);
+}
+
+
+static njs_ret_t
+ngx_http_js_msec(njs_vm_t *vm, const njs_value_t *value, ngx_msec_t *msec)
+{
+    double  n;
+
+    if (!njs_value_is_valid_number(value)) {
+        return NJS_ERROR;
+    }
+
+    n = njs_value_number(value);
+
+    if (n < 0 || n > NGX_MAX_INT32_VALUE) {
+        return NJS_ERROR;
+    }
+
+    *msec = (ngx_msec_t) n;
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_get_parent(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    ngx_http_js_ctx_t   *ctx;
+    ngx_http_request_t  *r;
+
+    r = (ngx_http_request_t *) obj;
+
+    ctx = r->parent ? ngx_http_get_module_ctx(r->parent, ngx_http_js_module)
+                    : NULL;
+
+    if (ctx == NULL || ctx->vm != vm) {
+        njs_vm_error(vm, "parent can only be returned for a subrequest");
+        return NJS_ERROR;
+    }
+
+    njs_value_assign(value, njs_value_arg(&ctx->request));
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_get_reply_body(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    size_t               len;
+    ngx_buf_t           *b;
+    ngx_http_request_t  *r;
+
+    r = (ngx_http_request_t *) obj;
+
+    b = r->out ? r->out->buf : NULL;
+
+    if (b == NULL) {
+        return njs_vm_value_string_set(vm, value, (u_char *) "", 0);
+    }
+
+    len = b->last - b->pos;
+
+    /*
+     * The in-memory reply is allocated from the main request pool,
+     * which outlives the VM, so the body is not copied.
+     */
+
+    return njs_vm_value_string_set(vm, value, b->pos, len);
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_get_shared(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    nxt_str_t                 *v;
+    ngx_uint_t                 i;
+    ngx_http_js_dict_t       **dicts;
+    ngx_http_js_main_conf_t   *jmcf;
+
+    jmcf = (ngx_http_js_main_conf_t *) obj;
+    v = (nxt_str_t *) data;
+
+    if (jmcf->dicts != NULL) {
+        dicts = jmcf->dicts->elts;
+
+        for (i = 0; i < jmcf->dicts->nelts; i++) {
+            if (dicts[i]->name.len == v->length
+                && ngx_strncmp(dicts[i]->name.data, v->start, v->length) == 0)
+            {
+                return njs_vm_external_create(vm, value, jmcf->dict_proto,
+                                              dicts[i]);
+            }
+        }
+    }
+
+    njs_value_undefined_set(value);
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_dict_get(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    u_char                   *p;
+    njs_ret_t                 ret;
+    ngx_str_t                 key;
+    ngx_http_js_dict_t       *dict;
+    ngx_http_js_dict_node_t  *node;
+
+    dict = ngx_http_js_dict_arg(vm, args, nargs, &key);
+    if (dict == NULL) {
+        return NJS_ERROR;
+    }
+
+    ret = NJS_OK;
+
+    ngx_rwlock_rlock(&dict->sh->rwlock);
+
+    node = ngx_http_js_dict_lookup(dict, &key);
+
+    if (node == NULL || ngx_http_js_dict_expired(node, ngx_current_msec)) {
+        njs_value_undefined_set(njs_vm_retval(vm));
+
+    } else if (node->type == NGX_HTTP_JS_DICT_NUMBER) {
+        node->used = 1;
+        njs_value_number_set(njs_vm_retval(vm), node->number);
+
+    } else {
+        node->used = 1;
+
+        p = njs_vm_value_string_alloc(vm, njs_vm_retval(vm), node->value.len);
+        if (p != NULL) {
+            ngx_memcpy(p, node->value.data, node->value.len);
+
+        } else {
+            ret = NJS_ERROR;
+        }
+    }
+
+    ngx_rwlock_unlock(&dict->sh->rwlock);
+
+    return ret;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_dict_set(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    double               number;
+    nxt_str_t            s;
+    ngx_int_t            rc;
+    ngx_str_t            key, value;
+    ngx_msec_t           now, ttl;
+    ngx_uint_t           type;
+    const njs_value_t   *arg;
+    ngx_http_js_dict_t  *dict;
+
+    dict = ngx_http_js_dict_arg(vm, args, nargs, &key);
+    if (dict == NULL) {
+        return NJS_ERROR;
+    }
+
+    number = 0;
+    ngx_str_null(&value);
+
+    arg = njs_arg(args, nargs, 2);
+
+    if (njs_value_is_number(arg)) {
+        type = NGX_HTTP_JS_DICT_NUMBER;
+        number = njs_value_number(arg);
+
+    } else {
+        if (njs_vm_value_to_ext_string(vm, &s, arg, 0) != NJS_OK) {
+            return NJS_ERROR;
+        }
+
+        type = NGX_HTTP_JS_DICT_STRING;
+        value.data = s.start;
+        value.len = s.length;
+    }
+
+    ttl = dict->timeout;
+
+    arg = njs_arg(args, nargs, 3);
+
+    if (!njs_value_is_undefined(arg)
+        && ngx_http_js_msec(vm, arg, &ttl) != NJS_OK)
+    {
+        njs_vm_error(vm, "ttl is invalid");
+        return NJS_ERROR;
+    }
+
+    now = ngx_current_msec;
+
+    ngx_rwlock_wlock(&dict->sh->rwlock);
+
+    rc = ngx_http_js_dict_add(dict, &key, &value, number, type,
+                              ngx_http_js_dict_expire_time(ttl, now), now);
+
+    ngx_rwlock_unlock(&dict->sh->rwlock);
+
+    if (rc != NGX_OK) {
+        njs_vm_error(vm, "shared dict \"%*s\" is full",
+                     dict->name.len, dict->name.data);
+        return NJS_ERROR;
+    }
+
+    njs_value_boolean_set(njs_vm_retval(vm), 1);
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+ngx_http_js_ext_dict_incr(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    double                    delta, number;
+    ngx_int_t                 rc;
+    ngx_str_t                 key, value;
+    ngx_msec_t                now, ttl;
+    const njs_value_t        *arg;
+    ngx_http_js_dict_t       *dict;
+    ngx_http_js_dict_node_t  *node;
+
+    dict = ngx_http_js_dict_arg(vm, args, nargs, &key);
+    if (dict == NULL) {
+        return NJS_ERROR;
+    }
+
+    arg = njs_arg(args, nargs, 2);
+
+    if (!njs_value_is_number(arg)) {
+        njs_vm_error(vm, "delta is not a number");
+        return NJS_ERROR;
+    }
 
-            rb->bufs->buf = ngx_calloc_buf(r->pool);
-            if (rb->bufs->buf == NULL) {
-                goto memory_error;
-            }
+    delta = njs_value_number(arg);
+    number = 0;
 
-            rb->bufs->buf->memory = 1;
-            rb->bufs->buf->last_buf = 1;
+    arg = njs_arg(args, nargs, 3);
 
-            rb->bufs->buf->pos = body_arg.start;
-            rb->bufs->buf->last = body_arg.start + body_arg.length;
+    if (!njs_value_is_undefined(arg)) {
+        if (!njs_value_is_number(arg)) {
+            njs_vm_error(vm, "init is not a number");
+            return NJS_ERROR;
         }
 
-        sr->request_body = rb;
-        sr->headers_in.content_length_n = body_arg.length;
-        sr->headers_in.chunked = 0;
+        number = njs_value_number(arg);
     }
 
-    return NJS_OK;
+    ttl = dict->timeout;
 
-memory_error:
+    arg = njs_arg(args, nargs, 4);
 
-    njs_vm_error(ctx->vm, "internal error");
+    if (!njs_value_is_undefined(arg)
+        && ngx_http_js_msec(vm, arg, &ttl) != NJS_OK)
+    {
+        njs_vm_error(vm, "ttl is invalid");
+        return NJS_ERROR;
+    }
 
-    return NJS_ERROR;
-}
+    now = ngx_current_msec;
 
+    ngx_rwlock_wlock(&dict->sh->rwlock);
 
-static ngx_int_t
-ngx_http_js_subrequest(ngx_http_request_t *r, nxt_str_t *uri_arg,
-    nxt_str_t *args_arg, njs_function_t *callback, ngx_http_request_t **sr)
-{
-    ngx_int_t                    flags;
-    ngx_str_t                    uri, args;
-    njs_vm_event_t               vm_event;
-    ngx_http_js_ctx_t           *ctx;
-    ngx_http_post_subrequest_t  *ps;
+    node = ngx_http_js_dict_lookup(dict, &key);
 
-    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+    if (node != NULL && ngx_http_js_dict_expired(node, now)) {
+        ngx_http_js_dict_delete_node(dict, node);
+        node = NULL;
+    }
 
-    flags = NGX_HTTP_SUBREQUEST_BACKGROUND;
+    if (node == NULL) {
+        number += delta;
+        ngx_str_null(&value);
 
-    if (callback != NULL) {
-        ps = ngx_palloc(r->pool, sizeof(ngx_http_post_subrequest_t));
-        if (ps == NULL) {
-            njs_vm_error(ctx->vm, "internal error");
-            return NJS_ERROR;
-        }
+        rc = ngx_http_js_dict_add(dict, &key, &value, number,
+                                  NGX_HTTP_JS_DICT_NUMBER,
+                                  ngx_http_js_dict_expire_time(ttl, now), now);
 
-        vm_event = njs_vm_add_event(ctx->vm, callback, 1, NULL, NULL);
-        if (vm_event == NULL) {
-            njs_vm_error(ctx->vm, "internal error");
+        if (rc != NGX_OK) {
+            ngx_rwlock_unlock(&dict->sh->rwlock);
+
+            njs_vm_error(vm, "shared dict \"%*s\" is full",
+                         dict->name.len, dict->name.data);
             return NJS_ERROR;
         }
 
-        ps->handler = ngx_http_js_subrequest_done;
-        ps->data = vm_event;
-
-        flags |= NGX_HTTP_SUBREQUEST_IN_MEMORY;
+    } else if (node->type == NGX_HTTP_JS_DICT_NUMBER) {
+        node->number += delta;
+        number = node->number;
 
     } else {
-        ps = NULL;
-        vm_event = NULL;
+        ngx_rwlock_unlock(&dict->sh->rwlock);
+
+        njs_vm_error(vm, "value is not a number");
+        return NJS_ERROR;
     }
 
-    uri.len = uri_arg->length;
-    uri.data = uri_arg->start;
+    ngx_rwlock_unlock(&dict->sh->rwlock);
 
-    args.len = args_arg->length;
-    args.data = args_arg->start;
+    njs_value_number_set(njs_vm_retval(vm), number);
 
-    if (ngx_http_subrequest(r, &uri, args.len ? &args : NULL, sr, ps, flags)
-        != NGX_OK)
-    {
-        if (vm_event != NULL) {
-            njs_vm_del_event(ctx->vm, vm_event);
-        }
+    return NJS_OK;
+}
 
-        njs_vm_error(ctx->vm, "subrequest creation failed");
+
+static njs_ret_t
+ngx_http_js_ext_dict_expire(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    ngx_str_t                 key;
+    ngx_msec_t                now, ttl;
+    ngx_http_js_dict_t       *dict;
+    ngx_http_js_dict_node_t  *node;
+
+    dict = ngx_http_js_dict_arg(vm, args, nargs, &key);
+    if (dict == NULL) {
+        return NJS_ERROR;
+    }
+
+    if (ngx_http_js_msec(vm, njs_arg(args, nargs, 2), &ttl) != NJS_OK) {
+        njs_vm_error(vm, "ttl is invalid");
         return NJS_ERROR;
     }
 
+    now = ngx_current_msec;
+
+    ngx_rwlock_wlock(&dict->sh->rwlock);
+
+    node = ngx_http_js_dict_lookup(dict, &key);
+
+    if (node != NULL && ngx_http_js_dict_expired(node, now)) {
+        node = NULL;
+    }
+
+    if (node != NULL) {
+        node->expire = ngx_http_js_dict_expire_time(ttl, now);
+    }
+
+    ngx_rwlock_unlock(&dict->sh->rwlock);
+
+    njs_value_boolean_set(njs_vm_retval(vm), node != NULL);
+
     return NJS_OK;
 }
 
 
-static ngx_int_t
-ngx_http_js_subrequest_done(ngx_http_request_t *r, void *data, ngx_int_t rc)
+static njs_ret_t
+ngx_http_js_ext_dict_delete(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
 {
-    njs_vm_event_t  vm_event = data;
+    ngx_str_t                 key;
+    ngx_uint_t                found;
+    ngx_http_js_dict_t       *dict;
+    ngx_http_js_dict_node_t  *node;
 
-    nxt_int_t                 ret;
-    ngx_http_js_ctx_t        *ctx;
-    njs_opaque_value_t        reply;
-    ngx_http_js_main_conf_t  *jmcf;
+    dict = ngx_http_js_dict_arg(vm, args, nargs, &key);
+    if (dict == NULL) {
+        return NJS_ERROR;
+    }
 
-    if (rc != NGX_OK || r->connection->error || r->buffered) {
-        return rc;
+    found = 0;
+
+    ngx_rwlock_wlock(&dict->sh->rwlock);
+
+    node = ngx_http_js_dict_lookup(dict, &key);
+
+    if (node != NULL) {
+        found = !ngx_http_js_dict_expired(node, ngx_current_msec);
+        ngx_http_js_dict_delete_node(dict, node);
     }
 
-    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+    ngx_rwlock_unlock(&dict->sh->rwlock);
 
-    if (ctx && ctx->done) {
-        return NGX_OK;
+    njs_value_boolean_set(njs_vm_retval(vm), found);
+
+    return NJS_OK;
+}
+
+
+static ngx_http_js_dict_t *
+ngx_http_js_dict_arg(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    ngx_str_t *key)
+{
+    nxt_str_t            s;
+    const njs_value_t   *arg;
+    ngx_http_js_dict_t  *dict;
+
+    dict = njs_vm_external(vm, njs_arg(args, nargs, 0));
+    if (nxt_slow_path(dict == NULL)) {
+        return NULL;
     }
 
-    if (ctx == NULL) {
-        ctx = ngx_pcalloc(r->pool, sizeof(ngx_http_js_ctx_t));
-        if (ctx == NULL) {
-            return NGX_ERROR;
-        }
+    arg = njs_arg(args, nargs, 1);
 
-        ngx_http_set_ctx(r, ctx, ngx_http_js_module);
+    if (!njs_value_is_string(arg)) {
+        njs_vm_error(vm, "key is not a string");
+        return NULL;
     }
 
-    ctx->done = 1;
+    if (njs_vm_value_to_ext_string(vm, &s, arg, 0) != NJS_OK) {
+        return NULL;
+    }
 
-    jmcf = ngx_http_get_module_main_conf(r, ngx_http_js_module);
+    if (s.length == 0) {
+        njs_vm_error(vm, "key is empty");
+        return NULL;
+    }
 
-    ctx = ngx_http_get_module_ctx(r->parent, ngx_http_js_module);
+    key->data = s.start;
+    key->len = s.length;
 
-    ngx_log_debug2(NGX_LOG_DEBUG_HTTP, r->connection->log, 0,
-                   "js subrequest done s: %ui parent ctx: %p",
-                   r->headers_out.status, ctx);
+    return dict;
+}
 
-    if (ctx == NULL) {
-        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
-                      "js subrequest: failed to get the parent context");
 
+static ngx_http_js_dict_node_t *
+ngx_http_js_dict_lookup(ngx_http_js_dict_t *dict, ngx_str_t *key)
+{
+    uint32_t  hash;
+
+    hash = ngx_crc32_short(key->data, key->len);
+
+    return (ngx_http_js_dict_node_t *)
+               ngx_str_rbtree_lookup(&dict->sh->rbtree, key, hash);
+}
+
+
+static ngx_int_t
+ngx_http_js_dict_add(ngx_http_js_dict_t *dict, ngx_str_t *key,
+    ngx_str_t *value, double number, ngx_uint_t type, ngx_msec_t expire,
+    ngx_msec_t now)
+{
+    size_t                    size;
+    ngx_http_js_dict_node_t  *node, *old;
+
+    size = offsetof(ngx_http_js_dict_node_t, data) + key->len + value->len;
+
+    /*
+     * The new entry is allocated before the old one is removed,
+     * so a failed allocation leaves the old value in place.
+     */
+
+    node = ngx_http_js_dict_alloc(dict, size, now);
+    if (node == NULL) {
         return NGX_ERROR;
     }
 
-    ret = njs_vm_external_create(ctx->vm, njs_value_arg(&reply),
-                                 jmcf->req_proto, r);
-    if (ret != NXT_OK) {
-        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
-                      "js subrequest reply creation failed");
+    /* The old entry could have been evicted by the allocation. */
 
-        return NGX_ERROR;
+    old = ngx_http_js_dict_lookup(dict, key);
+    if (old != NULL) {
+        ngx_http_js_dict_delete_node(dict, old);
     }
 
-    ngx_http_js_handle_event(r->parent, vm_event, njs_value_arg(&reply), 1);
+    node->sn.node.key = ngx_crc32_short(key->data, key->len);
+    node->sn.str.data = node->data;
+    node->sn.str.len = key->len;
+    ngx_memcpy(node->data, key->data, key->len);
+
+    node->value.data = node->data + key->len;
+    node->value.len = value->len;
+    ngx_memcpy(node->value.data, value->data, value->len);
+
+    node->number = number;
+    node->type = type;
+    node->expire = expire;
+    node->used = 0;
+
+    ngx_rbtree_insert(&dict->sh->rbtree, &node->sn.node);
+    ngx_queue_insert_head(&dict->sh->lru, &node->queue);
 
     return NGX_OK;
 }
 
 
-static njs_ret_t
-ngx_http_js_ext_get_parent(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
+/*
+ * When the zone is exhausted, entries are examined from the tail of
+ * the LRU queue.  Expired entries are reclaimed, entries read since
+ * the last pass get a second chance, and with "evict" the others are
+ * dropped.  The number of entries examined without freeing is limited,
+ * so an allocation does not walk the whole zone under the write lock.
+ */
+
+static void *
+ngx_http_js_dict_alloc(ngx_http_js_dict_t *dict, size_t size, ngx_msec_t now)
 {
-    ngx_http_js_ctx_t   *ctx;
-    ngx_http_request_t  *r;
+    void                     *p;
+    ngx_uint_t                n;
+    ngx_queue_t              *q;
+    ngx_http_js_dict_node_t  *node;
+
+    p = ngx_slab_alloc(dict->shpool, size);
+    if (p != NULL) {
+        return p;
+    }
 
-    r = (ngx_http_request_t *) obj;
+    n = 0;
 
-    ctx = r->parent ? ngx_http_get_module_ctx(r->parent, ngx_http_js_module)
-                    : NULL;
+    while (!ngx_queue_empty(&dict->sh->lru)) {
+        q = ngx_queue_last(&dict->sh->lru);
+        node = ngx_queue_data(q, ngx_http_js_dict_node_t, queue);
 
-    if (ctx == NULL || ctx->vm != vm) {
-        njs_vm_error(vm, "parent can only be returned for a subrequest");
-        return NJS_ERROR;
-    }
+        if (!ngx_http_js_dict_expired(node, now)) {
 
-    njs_value_assign(value, njs_value_arg(&ctx->request));
+            if (n == NGX_HTTP_JS_DICT_SCAN) {
+                if (!dict->evict) {
+                    return NULL;
+                }
 
-    return NJS_OK;
+                /* no more second chances */
+
+            } else if (node->used || !dict->evict) {
+                n++;
+
+                node->used = 0;
+                ngx_queue_remove(q);
+                ngx_queue_insert_head(&dict->sh->lru, q);
+                continue;
+            }
+        }
+
+        ngx_http_js_dict_delete_node(dict, node);
+
+        p = ngx_slab_alloc(dict->shpool, size);
+        if (p != NULL) {
+            return p;
+        }
+    }
+
+    return NULL;
 }
 
 
-static njs_ret_t
-ngx_http_js_ext_get_reply_body(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
+static void
+ngx_http_js_dict_delete_node(ngx_http_js_dict_t *dict,
+    ngx_http_js_dict_node_t *node)
 {
-    size_t               len;
-    u_char              *p;
-    ngx_buf_t           *b;
-    ngx_http_request_t  *r;
-
-    r = (ngx_http_request_t *) obj;
+    ngx_rbtree_delete(&dict->sh->rbtree, &node->sn.node);
+    ngx_queue_remove(&node->queue);
+    ngx_slab_free(dict->shpool, node);
+}
 
-    b = r->out ? r->out->buf : NULL;
 
-    len = b ? b->last - b->pos : 0;
+static ngx_msec_t
+ngx_http_js_dict_expire_time(ngx_msec_t ttl, ngx_msec_t now)
+{
+    ngx_msec_t  expire;
 
-    p = njs_vm_value_string_alloc(vm, value, len);
-    if (p == NULL) {
-        return NJS_ERROR;
+    if (ttl == 0) {
+        return 0;
     }
 
-    if (len) {
-        ngx_memcpy(p, b->pos, len);
-    }
+    /* Zero is reserved for entries without expiration. */
 
-    return NJS_OK;
+    expire = now + ttl;
+
+    return (expire != 0) ? expire : 1;
 }
 
 
@@ -2097,53 +3866,76 @@ static njs_host_event_t
 ngx_http_js_set_timer(njs_external_ptr_t external, uint64_t delay,
     njs_vm_event_t vm_event)
 {
-    ngx_event_t          *ev;
+    ngx_queue_t          *q;
+    ngx_http_js_ctx_t    *ctx;
     ngx_http_request_t   *r;
-    ngx_http_js_event_t  *js_event;
+    ngx_http_js_timer_t  *timer;
 
     r = (ngx_http_request_t *) external;
 
-    ev = ngx_pcalloc(r->pool, sizeof(ngx_event_t));
-    if (ev == NULL) {
+    if (r == NULL) {
+        /* js_init_worker function, no request to bind the timer to. */
         return NULL;
     }
 
-    js_event = ngx_palloc(r->pool, sizeof(ngx_http_js_event_t));
-    if (js_event == NULL) {
-        return NULL;
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (!ngx_queue_empty(&ctx->free_timers)) {
+        q = ngx_queue_head(&ctx->free_timers);
+        ngx_queue_remove(q);
+
+        timer = ngx_queue_data(q, ngx_http_js_timer_t, queue);
+
+    } else {
+        timer = ngx_palloc(r->pool, sizeof(ngx_http_js_timer_t));
+        if (timer == NULL) {
+            return NULL;
+        }
     }
 
-    js_event->request = r;
-    js_event->vm_event = vm_event;
-    js_event->ident = r->connection->fd;
+    timer->vm_event = vm_event;
+    timer->fired = 0;
+    timer->node.key = ngx_current_msec + (ngx_msec_t) delay;
 
-    ev->data = js_event;
-    ev->log = r->connection->log;
-    ev->handler = ngx_http_js_timer_handler;
+    ngx_rbtree_insert(&ctx->timers, &timer->node);
 
-    ngx_add_timer(ev, delay);
+    ngx_http_js_update_timer(ctx);
 
-    return ev;
+    return timer;
 }
 
 
 static void
 ngx_http_js_clear_timer(njs_external_ptr_t external, njs_host_event_t event)
 {
-    ngx_event_t  *ev = event;
+    ngx_http_js_ctx_t    *ctx;
+    ngx_http_request_t   *r;
+    ngx_http_js_timer_t  *timer;
 
-    if (ev->timer_set) {
-        ngx_del_timer(ev);
+    r = (ngx_http_request_t *) external;
+    timer = (ngx_http_js_timer_t *) event;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (!timer->fired) {
+        ngx_rbtree_delete(&ctx->timers, &timer->node);
+        ngx_http_js_update_timer(ctx);
     }
+
+    ngx_queue_insert_head(&ctx->free_timers, &timer->queue);
 }
 
 
 static void
 ngx_http_js_timer_handler(ngx_event_t *ev)
 {
+    ngx_uint_t            n;
     ngx_connection_t     *c;
+    ngx_rbtree_node_t    *node, *root, *sentinel;
+    ngx_http_js_ctx_t    *ctx;
     ngx_http_request_t   *r;
     ngx_http_js_event_t  *js_event;
+    ngx_http_js_timer_t  *timer;
 
     js_event = (ngx_http_js_event_t *) ev->data;
 
@@ -2151,38 +3943,125 @@ ngx_http_js_timer_handler(ngx_event_t *ev)
 
     c = r->connection;
 
-    ngx_http_js_handle_event(r, js_event->vm_event, NULL, 0);
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    /*
+     * All the timers expired by now are posted at once
+     * and are handled by a single njs_vm_run() call.
+     */
+
+    n = 0;
+    sentinel = ctx->timers.sentinel;
+
+    for ( ;; ) {
+        root = ctx->timers.root;
+
+        if (root == sentinel) {
+            break;
+        }
+
+        node = ngx_rbtree_min(root, sentinel);
+
+        if ((ngx_msec_int_t) (node->key - ngx_current_msec) > 0) {
+            break;
+        }
+
+        ngx_rbtree_delete(&ctx->timers, node);
+
+        timer = (ngx_http_js_timer_t *) node;
+        timer->fired = 1;
+
+        if (njs_vm_post_event(ctx->vm, timer->vm_event, NULL, 0) != NJS_OK) {
+            ngx_http_finalize_request(r, NGX_ERROR);
+            goto done;
+        }
+
+        n++;
+    }
+
+    ngx_log_debug1(NGX_LOG_DEBUG_HTTP, c->log, 0,
+                   "http js timers fired: %ui", n);
+
+    ngx_http_js_update_timer(ctx);
+
+    if (n != 0) {
+        ngx_http_js_run_events(r, ctx);
+    }
+
+done:
 
     ngx_http_run_posted_requests(c);
 }
 
 
 static void
-ngx_http_js_handle_event(ngx_http_request_t *r, njs_vm_event_t vm_event,
-    njs_value_t *args, nxt_uint_t nargs)
+ngx_http_js_update_timer(ngx_http_js_ctx_t *ctx)
 {
-    njs_ret_t           rc;
-    nxt_str_t           exception;
-    ngx_http_js_ctx_t  *ctx;
+    ngx_msec_int_t      delay;
+    ngx_rbtree_node_t  *node, *root, *sentinel;
 
-    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+    root = ctx->timers.root;
+    sentinel = ctx->timers.sentinel;
 
-    njs_vm_post_event(ctx->vm, vm_event, args, nargs);
+    if (root == sentinel) {
+        if (ctx->timer.timer_set) {
+            ngx_del_timer(&ctx->timer);
+        }
+
+        return;
+    }
+
+    node = ngx_rbtree_min(root, sentinel);
+
+    if (ctx->timer.timer_set) {
+        if (ctx->timer.timer.key == node->key) {
+            return;
+        }
+
+        /* ngx_add_timer() would keep a close enough old time. */
+        ngx_del_timer(&ctx->timer);
+    }
+
+    delay = (ngx_msec_int_t) (node->key - ngx_current_msec);
+
+    ngx_add_timer(&ctx->timer, (delay > 0) ? (ngx_msec_t) delay : 0);
+}
+
+
+static void
+ngx_http_js_run_events(ngx_http_request_t *r, ngx_http_js_ctx_t *ctx)
+{
+    njs_ret_t  rc;
+    nxt_str_t  exception;
 
     rc = njs_vm_run(ctx->vm);
 
     if (rc == NJS_ERROR) {
         njs_vm_retval_to_ext_string(ctx->vm, &exception);
 
-        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
-                      "js exception: %*s", exception.length, exception.start);
+        ngx_log_error(NGX_LOG_ERR, r->connection->log, 0,
+                      "js exception: %*s", exception.length, exception.start);
+
+        ngx_http_finalize_request(r, NGX_ERROR);
+    }
+
+    if (rc == NJS_OK) {
+        ngx_http_post_request(r, NULL);
+    }
+}
+
+
+static void
+ngx_http_js_handle_event(ngx_http_request_t *r, njs_vm_event_t vm_event,
+    njs_value_t *args, nxt_uint_t nargs)
+{
+    ngx_http_js_ctx_t  *ctx;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
 
-        ngx_http_finalize_request(r, NGX_ERROR);
-    }
+    njs_vm_post_event(ctx->vm, vm_event, args, nargs);
 
-    if (rc == NJS_OK) {
-        ngx_http_post_request(r, NULL);
-    }
+    ngx_http_js_run_events(r, ctx);
 }
 
 
@@ -2218,7 +4097,11 @@ ngx_http_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
     ngx_uint_t             i;
     njs_vm_opt_t           options;
     ngx_file_info_t        fi;
+    njs_opaque_value_t     ngx_object;
     ngx_pool_cleanup_t    *cln;
+    const njs_extern_t    *proto;
+
+    static const nxt_str_t  ngx_name = nxt_string("ngx");
 
     if (jmcf->vm) {
         return "is duplicate";
@@ -2282,10 +4165,15 @@ ngx_http_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
     ngx_memzero(&options, sizeof(njs_vm_opt_t));
 
     options.backtrace = 1;
+    options.lazy = (jmcf->lazy == 1);
     options.ops = &ngx_http_js_ops;
     options.argv = ngx_argv;
     options.argc = ngx_argc;
 
+    if (jmcf->jit != NGX_CONF_UNSET) {
+        options.jit = jmcf->jit;
+    }
+
     file = value[1];
     options.file.start = file.data;
     options.file.length = file.len;
@@ -2339,6 +4227,27 @@ ngx_http_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
         return NGX_CONF_ERROR;
     }
 
+    jmcf->dict_proto = njs_vm_external_prototype(jmcf->vm,
+                                                 &ngx_http_js_externals[2]);
+    if (jmcf->dict_proto == NULL) {
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                           "failed to add shared dict proto");
+        return NGX_CONF_ERROR;
+    }
+
+    proto = njs_vm_external_prototype(jmcf->vm, &ngx_http_js_externals[1]);
+
+    rc = njs_vm_external_create(jmcf->vm, njs_value_arg(&ngx_object), proto,
+                                jmcf);
+    if (rc != NXT_OK
+        || njs_vm_external_bind(jmcf->vm, &ngx_name,
+                                njs_value_arg(&ngx_object))
+           != NXT_OK)
+    {
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0, "failed to bind ngx object");
+        return NGX_CONF_ERROR;
+    }
+
     rc = njs_vm_compile(jmcf->vm, &start, end);
 
     if (rc != NJS_OK) {
@@ -2361,6 +4270,26 @@ ngx_http_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 }
 
 
+/*
+ * The VM options are applied when "js_include" creates the VM,
+ * the directives setting them are not allowed after it.
+ */
+
+static char *
+ngx_http_js_before_include(ngx_conf_t *cf, void *post, void *data)
+{
+    ngx_http_js_main_conf_t  *jmcf;
+
+    jmcf = ngx_http_conf_get_module_main_conf(cf, ngx_http_js_module);
+
+    if (jmcf->vm != NULL) {
+        return "must be specified before \"js_include\"";
+    }
+
+    return NGX_CONF_OK;
+}
+
+
 static char *
 ngx_http_js_set(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 {
@@ -2419,6 +4348,339 @@ ngx_http_js_content(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 }
 
 
+static char *
+ngx_http_js_shared_dict_zone(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
+{
+    ngx_http_js_main_conf_t *jmcf = conf;
+
+    u_char               *p;
+    ssize_t               size;
+    ngx_str_t            *value, name, s;
+    ngx_flag_t            evict;
+    ngx_msec_t            timeout;
+    ngx_uint_t            i;
+    ngx_shm_zone_t       *shm_zone;
+    ngx_http_js_dict_t   *dict, **dp;
+
+    size = 0;
+    evict = 0;
+    timeout = 0;
+    ngx_str_null(&name);
+
+    value = cf->args->elts;
+
+    for (i = 1; i < cf->args->nelts; i++) {
+
+        if (ngx_strncmp(value[i].data, "zone=", 5) == 0) {
+
+            name.data = value[i].data + 5;
+
+            p = (u_char *) ngx_strchr(name.data, ':');
+
+            if (p == NULL) {
+                ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                                   "invalid zone size \"%V\"", &value[i]);
+                return NGX_CONF_ERROR;
+            }
+
+            name.len = p - name.data;
+
+            s.data = p + 1;
+            s.len = value[i].data + value[i].len - s.data;
+
+            size = ngx_parse_size(&s);
+
+            if (size == NGX_ERROR) {
+                ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                                   "invalid zone size \"%V\"", &value[i]);
+                return NGX_CONF_ERROR;
+            }
+
+            if (size < (ssize_t) (8 * ngx_pagesize)) {
+                ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                                   "zone \"%V\" is too small", &value[i]);
+                return NGX_CONF_ERROR;
+            }
+
+            continue;
+        }
+
+        if (ngx_strncmp(value[i].data, "timeout=", 8) == 0) {
+
+            s.data = value[i].data + 8;
+            s.len = value[i].len - 8;
+
+            timeout = ngx_parse_time(&s, 0);
+
+            if (timeout == (ngx_msec_t) NGX_ERROR) {
+                ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                                   "invalid timeout \"%V\"", &value[i]);
+                return NGX_CONF_ERROR;
+            }
+
+            continue;
+        }
+
+        if (ngx_strcmp(value[i].data, "evict") == 0) {
+            evict = 1;
+            continue;
+        }
+
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                           "invalid parameter \"%V\"", &value[i]);
+        return NGX_CONF_ERROR;
+    }
+
+    if (name.len == 0) {
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                           "\"%V\" must have \"zone\" parameter",
+                           &cmd->name);
+        return NGX_CONF_ERROR;
+    }
+
+    dict = ngx_pcalloc(cf->pool, sizeof(ngx_http_js_dict_t));
+    if (dict == NULL) {
+        return NGX_CONF_ERROR;
+    }
+
+    shm_zone = ngx_shared_memory_add(cf, &name, size, &ngx_http_js_module);
+    if (shm_zone == NULL) {
+        return NGX_CONF_ERROR;
+    }
+
+    if (shm_zone->data) {
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                           "duplicate zone \"%V\"", &name);
+        return NGX_CONF_ERROR;
+    }
+
+    dict->name = name;
+    dict->shm_zone = shm_zone;
+    dict->timeout = timeout;
+    dict->evict = evict;
+
+    shm_zone->init = ngx_http_js_dict_init_zone;
+    shm_zone->data = dict;
+
+    if (jmcf->dicts == NULL) {
+        jmcf->dicts = ngx_array_create(cf->pool, 4,
+                                       sizeof(ngx_http_js_dict_t *));
+        if (jmcf->dicts == NULL) {
+            return NGX_CONF_ERROR;
+        }
+    }
+
+    dp = ngx_array_push(jmcf->dicts);
+    if (dp == NULL) {
+        return NGX_CONF_ERROR;
+    }
+
+    *dp = dict;
+
+    return NGX_CONF_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_dict_init_zone(ngx_shm_zone_t *shm_zone, void *data)
+{
+    ngx_http_js_dict_t *prev = data;
+
+    size_t               len;
+    ngx_http_js_dict_t  *dict;
+
+    dict = shm_zone->data;
+
+    if (prev) {
+        dict->sh = prev->sh;
+        dict->shpool = prev->shpool;
+
+        return NGX_OK;
+    }
+
+    dict->shpool = (ngx_slab_pool_t *) shm_zone->shm.addr;
+
+    if (shm_zone->shm.exists) {
+        dict->sh = dict->shpool->data;
+
+        return NGX_OK;
+    }
+
+    dict->sh = ngx_slab_alloc(dict->shpool, sizeof(ngx_http_js_dict_sh_t));
+    if (dict->sh == NULL) {
+        return NGX_ERROR;
+    }
+
+    dict->shpool->data = dict->sh;
+
+    ngx_rbtree_init(&dict->sh->rbtree, &dict->sh->sentinel,
+                    ngx_str_rbtree_insert_value);
+
+    ngx_queue_init(&dict->sh->lru);
+
+    dict->sh->rwlock = 0;
+
+    len = sizeof(" in js shared dict \"\"") + shm_zone->shm.name.len;
+
+    dict->shpool->log_ctx = ngx_slab_alloc(dict->shpool, len);
+    if (dict->shpool->log_ctx == NULL) {
+        return NGX_ERROR;
+    }
+
+    ngx_sprintf(dict->shpool->log_ctx, " in js shared dict \"%V\"%Z",
+                &shm_zone->shm.name);
+
+    /* Exhaustion is handled by expiration and eviction. */
+
+    dict->shpool->log_nomem = 0;
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_init_worker(ngx_cycle_t *cycle)
+{
+    njs_vm_t                 *vm;
+    nxt_str_t                 name, exception;
+    njs_function_t           *func;
+    ngx_pool_cleanup_t       *cln;
+    ngx_http_js_main_conf_t  *jmcf;
+
+    if (ngx_process != NGX_PROCESS_WORKER
+        && ngx_process != NGX_PROCESS_SINGLE)
+    {
+        return NGX_OK;
+    }
+
+    jmcf = ngx_http_cycle_get_module_main_conf(cycle, ngx_http_js_module);
+
+    if (jmcf == NULL || jmcf->init_worker.len == 0) {
+        return NGX_OK;
+    }
+
+    /*
+     * The global code and the js_init_worker function are run once
+     * in a clone of the configuration VM.  The resulting globals are
+     * frozen and become the initial state of the request VMs.  On error
+     * the requests keep using the configuration VM.
+     */
+
+    vm = njs_vm_clone(jmcf->vm, NULL);
+    if (vm == NULL) {
+        ngx_log_error(NGX_LOG_ERR, cycle->log, 0, "failed to clone JS VM");
+        return NGX_OK;
+    }
+
+    cln = ngx_pool_cleanup_add(cycle->pool, 0);
+    if (cln == NULL) {
+        njs_vm_destroy(vm);
+        return NGX_OK;
+    }
+
+    cln->handler = ngx_http_js_cleanup_vm;
+    cln->data = vm;
+
+    njs_vm_execution_limit(vm, jmcf->max_instructions, jmcf->timeout);
+
+    if (njs_vm_start(vm) == NJS_ERROR) {
+        goto exception;
+    }
+
+    name.start = jmcf->init_worker.data;
+    name.length = jmcf->init_worker.len;
+
+    func = njs_vm_function(vm, &name);
+    if (func == NULL) {
+        ngx_log_error(NGX_LOG_ERR, cycle->log, 0,
+                      "js function \"%V\" not found", &jmcf->init_worker);
+        return NGX_OK;
+    }
+
+    if (njs_vm_call(vm, func, NULL, 0) != NJS_OK
+        || njs_vm_run(vm) == NJS_ERROR)
+    {
+        goto exception;
+    }
+
+    if (njs_vm_pending(vm)) {
+        ngx_log_error(NGX_LOG_ERR, cycle->log, 0,
+                      "js function \"%V\" left pending events",
+                      &jmcf->init_worker);
+        return NGX_OK;
+    }
+
+    if (njs_vm_freeze(vm) != NXT_OK) {
+        ngx_log_error(NGX_LOG_ERR, cycle->log, 0, "failed to freeze JS VM");
+        return NGX_OK;
+    }
+
+    jmcf->vm = vm;
+
+    return NGX_OK;
+
+exception:
+
+    njs_vm_retval_to_ext_string(vm, &exception);
+
+    ngx_log_error(NGX_LOG_ERR, cycle->log, 0, "js exception: %*s",
+                  exception.length, exception.start);
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_add_variables(ngx_conf_t *cf)
+{
+    ngx_http_variable_t  *var, *v;
+
+    for (v = ngx_http_js_vars; v->name.len; v++) {
+        var = ngx_http_add_variable(cf, &v->name, v->flags);
+        if (var == NULL) {
+            return NGX_ERROR;
+        }
+
+        var->get_handler = v->get_handler;
+        var->data = v->data;
+    }
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_http_js_mem_peak_variable(ngx_http_request_t *r,
+    ngx_http_variable_value_t *v, uintptr_t data)
+{
+    u_char             *p;
+    nxt_mp_stat_t       stat;
+    ngx_http_js_ctx_t  *ctx;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_http_js_module);
+
+    if (ctx == NULL || ctx->vm == NULL) {
+        v->not_found = 1;
+        return NGX_OK;
+    }
+
+    p = ngx_pnalloc(r->pool, NGX_SIZE_T_LEN);
+    if (p == NULL) {
+        return NGX_ERROR;
+    }
+
+    njs_vm_memory_stats(ctx->vm, &stat);
+
+    v->len = ngx_sprintf(p, "%uz", stat.peak) - p;
+    v->valid = 1;
+    v->no_cacheable = 0;
+    v->not_found = 0;
+    v->data = p;
+
+    return NGX_OK;
+}
+
+
 static void *
 ngx_http_js_create_main_conf(ngx_conf_t *cf)
 {
@@ -2433,10 +4695,18 @@ ngx_http_js_create_main_conf(ngx_conf_t *cf)
      * set by ngx_pcalloc():
      *
      *     conf->vm = NULL;
+     *     conf->init_worker = { 0, NULL };
      *     conf->req_proto = NULL;
+     *     conf->dict_proto = NULL;
+     *     conf->dicts = NULL;
      */
 
     conf->paths = NGX_CONF_UNSET_PTR;
+    conf->memory_limit = NGX_CONF_UNSET_SIZE;
+    conf->max_instructions = NGX_CONF_UNSET;
+    conf->timeout = NGX_CONF_UNSET_MSEC;
+    conf->lazy = NGX_CONF_UNSET;
+    conf->jit = NGX_CONF_UNSET;
 
     return conf;
 }
@@ -2462,6 +4732,68 @@ ngx_http_js_create_loc_conf(ngx_conf_t *cf)
 }
 
 
+static char *
+ngx_http_js_init_main_conf(ngx_conf_t *cf, void *conf)
+{
+    ngx_http_js_main_conf_t *jmcf = conf;
+
+    ngx_array_t            headers_in;
+    ngx_hash_key_t        *hk;
+    ngx_hash_init_t        hash;
+    ngx_http_js_header_t  *header;
+
+    if (jmcf->init_worker.len && jmcf->vm == NULL) {
+        ngx_conf_log_error(NGX_LOG_EMERG, cf, 0,
+                           "\"js_init_worker\" requires \"js_include\"");
+        return NGX_CONF_ERROR;
+    }
+
+    ngx_conf_init_size_value(jmcf->memory_limit, 0);
+    ngx_conf_init_value(jmcf->max_instructions, 0);
+    ngx_conf_init_msec_value(jmcf->timeout, 0);
+    ngx_conf_init_value(jmcf->lazy, 0);
+    ngx_conf_init_value(jmcf->jit, 0);
+
+    if (jmcf->jit && (jmcf->max_instructions || jmcf->timeout)) {
+        ngx_conf_log_error(NGX_LOG_WARN, cf, 0,
+                           "\"js_jit\" is ignored while "
+                           "\"js_max_instructions\" or \"js_timeout\" "
+                           "is set");
+    }
+
+    if (ngx_array_init(&headers_in, cf->temp_pool, 32, sizeof(ngx_hash_key_t))
+        != NGX_OK)
+    {
+        return NGX_CONF_ERROR;
+    }
+
+    for (header = ngx_http_js_headers_in; header->name.len; header++) {
+        hk = ngx_array_push(&headers_in);
+        if (hk == NULL) {
+            return NGX_CONF_ERROR;
+        }
+
+        hk->key = header->name;
+        hk->key_hash = ngx_hash_key_lc(header->name.data, header->name.len);
+        hk->value = header;
+    }
+
+    hash.hash = &jmcf->headers_in_hash;
+    hash.key = ngx_hash_key_lc;
+    hash.max_size = 512;
+    hash.bucket_size = ngx_align(64, ngx_cacheline_size);
+    hash.name = "js_headers_in_hash";
+    hash.pool = cf->pool;
+    hash.temp_pool = NULL;
+
+    if (ngx_hash_init(&hash, headers_in.elts, headers_in.nelts) != NGX_OK) {
+        return NGX_CONF_ERROR;
+    }
+
+    return NGX_CONF_OK;
+}
+
+
 static char *
 ngx_http_js_merge_loc_conf(ngx_conf_t *cf, void *parent, void *child)
 {
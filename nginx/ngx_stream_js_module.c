@@ -16,6 +16,11 @@
 typedef struct {
     njs_vm_t              *vm;
     ngx_array_t           *paths;
+    size_t                 memory_limit;
+    ngx_int_t              max_instructions;
+    ngx_msec_t             timeout;
+    ngx_flag_t             lazy;
+    ngx_int_t              jit;
     const njs_extern_t    *proto;
 } ngx_stream_js_main_conf_t;
 
@@ -39,9 +44,17 @@ typedef struct {
     ngx_int_t               status;
     njs_vm_event_t          upload_event;
     njs_vm_event_t          download_event;
+    unsigned                upload_buffer:1;
+    unsigned                download_buffer:1;
     unsigned                from_upstream:1;
     unsigned                filter:1;
     unsigned                in_progress:1;
+
+    /*
+     * The timers released by the VM are reused, so an interval
+     * rearmed on every run does not grow the connection pool.
+     */
+    ngx_queue_t             free_timers;
 } ngx_stream_js_ctx_t;
 
 
@@ -53,6 +66,13 @@ typedef struct {
 } ngx_stream_js_event_t;
 
 
+typedef struct {
+    ngx_event_t            event;
+    ngx_stream_js_event_t  data;
+    ngx_queue_t            queue;
+} ngx_stream_js_timer_t;
+
+
 static ngx_int_t ngx_stream_js_access_handler(ngx_stream_session_t *s);
 static ngx_int_t ngx_stream_js_preread_handler(ngx_stream_session_t *s);
 static ngx_int_t ngx_stream_js_phase_handler(ngx_stream_session_t *s,
@@ -69,7 +89,7 @@ static njs_ret_t ngx_stream_js_buffer_arg(ngx_stream_session_t *s,
 static njs_ret_t ngx_stream_js_flags_arg(ngx_stream_session_t *s,
     njs_value_t *flags);
 static njs_vm_event_t *ngx_stream_js_event(ngx_stream_session_t *s,
-    nxt_str_t *event);
+    nxt_str_t *event, ngx_uint_t *buffer);
 
 static njs_ret_t ngx_stream_js_ext_get_remote_address(njs_vm_t *vm,
     njs_value_t *value, void *obj, uintptr_t data);
@@ -117,13 +137,23 @@ static char *ngx_stream_js_include(ngx_conf_t *cf, ngx_command_t *cmd,
     void *conf);
 static char *ngx_stream_js_set(ngx_conf_t *cf, ngx_command_t *cmd,
     void *conf);
+static ngx_int_t ngx_stream_js_add_variables(ngx_conf_t *cf);
+static ngx_int_t ngx_stream_js_mem_peak_variable(ngx_stream_session_t *s,
+    ngx_stream_variable_value_t *v, uintptr_t data);
+static char *ngx_stream_js_before_include(ngx_conf_t *cf, void *post,
+    void *data);
 static void *ngx_stream_js_create_main_conf(ngx_conf_t *cf);
+static char *ngx_stream_js_init_main_conf(ngx_conf_t *cf, void *conf);
 static void *ngx_stream_js_create_srv_conf(ngx_conf_t *cf);
 static char *ngx_stream_js_merge_srv_conf(ngx_conf_t *cf, void *parent,
     void *child);
 static ngx_int_t ngx_stream_js_init(ngx_conf_t *cf);
 
 
+static ngx_conf_post_t  ngx_stream_js_before_include_post =
+    { ngx_stream_js_before_include };
+
+
 static ngx_command_t  ngx_stream_js_commands[] = {
 
     { ngx_string("js_include"),
@@ -140,6 +170,41 @@ static ngx_command_t  ngx_stream_js_commands[] = {
       offsetof(ngx_stream_js_main_conf_t, paths),
       NULL },
 
+    { ngx_string("js_memory_limit"),
+      NGX_STREAM_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_size_slot,
+      NGX_STREAM_MAIN_CONF_OFFSET,
+      offsetof(ngx_stream_js_main_conf_t, memory_limit),
+      NULL },
+
+    { ngx_string("js_max_instructions"),
+      NGX_STREAM_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_num_slot,
+      NGX_STREAM_MAIN_CONF_OFFSET,
+      offsetof(ngx_stream_js_main_conf_t, max_instructions),
+      NULL },
+
+    { ngx_string("js_timeout"),
+      NGX_STREAM_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_msec_slot,
+      NGX_STREAM_MAIN_CONF_OFFSET,
+      offsetof(ngx_stream_js_main_conf_t, timeout),
+      NULL },
+
+    { ngx_string("js_lazy"),
+      NGX_STREAM_MAIN_CONF|NGX_CONF_FLAG,
+      ngx_conf_set_flag_slot,
+      NGX_STREAM_MAIN_CONF_OFFSET,
+      offsetof(ngx_stream_js_main_conf_t, lazy),
+      &ngx_stream_js_before_include_post },
+
+    { ngx_string("js_jit"),
+      NGX_STREAM_MAIN_CONF|NGX_CONF_TAKE1,
+      ngx_conf_set_num_slot,
+      NGX_STREAM_MAIN_CONF_OFFSET,
+      offsetof(ngx_stream_js_main_conf_t, jit),
+      &ngx_stream_js_before_include_post },
+
     { ngx_string("js_set"),
       NGX_STREAM_MAIN_CONF|NGX_CONF_TAKE2,
       ngx_stream_js_set,
@@ -172,12 +237,21 @@ static ngx_command_t  ngx_stream_js_commands[] = {
 };
 
 
+static ngx_stream_variable_t  ngx_stream_js_vars[] = {
+
+    { ngx_string("js_mem_peak"), NULL, ngx_stream_js_mem_peak_variable,
+      0, NGX_STREAM_VAR_NOCACHEABLE, 0 },
+
+      ngx_stream_null_variable
+};
+
+
 static ngx_stream_module_t  ngx_stream_js_module_ctx = {
-    NULL,                           /* preconfiguration */
+    ngx_stream_js_add_variables,    /* preconfiguration */
     ngx_stream_js_init,             /* postconfiguration */
 
     ngx_stream_js_create_main_conf, /* create main configuration */
-    NULL,                           /* init main configuration */
+    ngx_stream_js_init_main_conf,   /* init main configuration */
 
     ngx_stream_js_create_srv_conf,  /* create server configuration */
     ngx_stream_js_merge_srv_conf,   /* merge server configuration */
@@ -451,6 +525,10 @@ ngx_stream_js_phase_handler(ngx_stream_session_t *s, ngx_str_t *name)
         if (ret != NJS_OK) {
             goto exception;
         }
+
+        if (njs_vm_run(ctx->vm) == NJS_ERROR) {
+            goto exception;
+        }
     }
 
     if (ctx->upload_event != NULL) {
@@ -468,6 +546,15 @@ ngx_stream_js_phase_handler(ngx_stream_session_t *s, ngx_str_t *name)
                           njs_value_arg(&ctx->args[1]), 2);
 
         rc = njs_vm_run(ctx->vm);
+
+        /*
+         * The callback may have changed ctx->upload_buffer with s.on(),
+         * the argument itself tells whether it refers to the nginx buffer,
+         * detaching is a no-op for a string.
+         */
+
+        njs_vm_array_buffer_detach(ctx->vm, njs_value_arg(&ctx->args[1]));
+
         if (rc == NJS_ERROR) {
             goto exception;
         }
@@ -553,6 +640,10 @@ ngx_stream_js_body_filter(ngx_stream_session_t *s, ngx_chain_t *in,
         if (ret != NJS_OK) {
             goto exception;
         }
+
+        if (njs_vm_run(ctx->vm) == NJS_ERROR) {
+            goto exception;
+        }
     }
 
     ctx->filter = 1;
@@ -578,6 +669,9 @@ ngx_stream_js_body_filter(ngx_stream_session_t *s, ngx_chain_t *in,
                               njs_value_arg(&ctx->args[1]), 2);
 
             rc = njs_vm_run(ctx->vm);
+
+            njs_vm_array_buffer_detach(ctx->vm, njs_value_arg(&ctx->args[1]));
+
             if (rc == NJS_ERROR) {
                 goto exception;
             }
@@ -679,6 +773,27 @@ ngx_stream_js_variable(ngx_stream_session_t *s, ngx_stream_variable_value_t *v,
         return NGX_ERROR;
     }
 
+    /* The string can be collected by njs_vm_run(). */
+
+    v->data = ngx_pnalloc(s->connection->pool, value.length);
+    if (v->data == NULL) {
+        return NGX_ERROR;
+    }
+
+    ngx_memcpy(v->data, value.start, value.length);
+
+    /* Promise jobs queued by the handler are run before it returns. */
+
+    if (!pending && njs_vm_run(ctx->vm) == NJS_ERROR) {
+        njs_vm_retval_to_ext_string(ctx->vm, &exception);
+
+        ngx_log_error(NGX_LOG_ERR, s->connection->log, 0,
+                      "js exception: %*s", exception.length, exception.start);
+
+        v->not_found = 1;
+        return NGX_OK;
+    }
+
     if (!pending && njs_vm_pending(ctx->vm)) {
         ngx_log_error(NGX_LOG_ERR, s->connection->log, 0,
                       "async operation inside \"%V\" variable handler", fname);
@@ -689,7 +804,6 @@ ngx_stream_js_variable(ngx_stream_session_t *s, ngx_stream_variable_value_t *v,
     v->valid = 1;
     v->no_cacheable = 0;
     v->not_found = 0;
-    v->data = value.start;
 
     return NGX_OK;
 }
@@ -717,6 +831,8 @@ ngx_stream_js_init_vm(ngx_stream_session_t *s)
             return NGX_ERROR;
         }
 
+        ngx_queue_init(&ctx->free_timers);
+
         ngx_stream_set_ctx(s, ctx, ngx_stream_js_module);
     }
 
@@ -729,6 +845,9 @@ ngx_stream_js_init_vm(ngx_stream_session_t *s)
         return NGX_ERROR;
     }
 
+    njs_vm_memory_limit(ctx->vm, jmcf->memory_limit);
+    njs_vm_execution_limit(ctx->vm, jmcf->max_instructions, jmcf->timeout);
+
     cln = ngx_pool_cleanup_add(s->connection->pool, 0);
     if (cln == NULL) {
         return NGX_ERROR;
@@ -763,6 +882,8 @@ ngx_stream_js_cleanup_ctx(void *data)
 {
     ngx_stream_js_ctx_t *ctx = data;
 
+    nxt_mp_stat_t  stat;
+
     if (ctx->upload_event != NULL) {
         njs_vm_del_event(ctx->vm, ctx->upload_event);
         ctx->upload_event = NULL;
@@ -777,6 +898,12 @@ ngx_stream_js_cleanup_ctx(void *data)
         ngx_log_error(NGX_LOG_ERR, ctx->log, 0, "pending events");
     }
 
+    njs_vm_memory_stats(ctx->vm, &stat);
+
+    ngx_log_debug3(NGX_LOG_DEBUG_STREAM, ctx->log, 0,
+                   "stream js vm memory peak:%uz allocations:%ui large:%ui",
+                   stat.peak, stat.allocations, stat.large);
+
     njs_vm_destroy(ctx->vm);
 }
 
@@ -806,6 +933,18 @@ ngx_stream_js_buffer_arg(ngx_stream_session_t *s, njs_value_t *buffer)
 
     len = b ? b->last - b->pos : 0;
 
+    if ((ctx->filter && ctx->from_upstream) ? ctx->download_buffer
+                                            : ctx->upload_buffer)
+    {
+        /*
+         * The ArrayBuffer refers to the nginx buffer without copying,
+         * it is detached once the callback returns.
+         */
+
+        return njs_vm_array_buffer_set(ctx->vm, buffer, b ? b->pos : NULL,
+                                       len);
+    }
+
     p = njs_vm_value_string_alloc(ctx->vm, buffer, len);
     if (p == NULL) {
         return NJS_ERROR;
@@ -847,15 +986,23 @@ ngx_stream_js_flags_arg(ngx_stream_session_t *s, njs_value_t *flags)
 }
 
 
+/*
+ * The "upstream" and "downstream" events are the "upload" and "download"
+ * events which receive the data as an ArrayBuffer instead of a string.
+ */
+
 static njs_vm_event_t *
-ngx_stream_js_event(ngx_stream_session_t *s, nxt_str_t *event)
+ngx_stream_js_event(ngx_stream_session_t *s, nxt_str_t *event,
+    ngx_uint_t *buffer)
 {
     ngx_uint_t             i, n;
     ngx_stream_js_ctx_t  *ctx;
 
     static const nxt_str_t events[] = {
         nxt_string("upload"),
-        nxt_string("download")
+        nxt_string("download"),
+        nxt_string("upstream"),
+        nxt_string("downstream")
     };
 
     ctx = ngx_stream_get_module_ctx(s, ngx_stream_js_module);
@@ -878,7 +1025,11 @@ ngx_stream_js_event(ngx_stream_session_t *s, nxt_str_t *event)
         return NULL;
     }
 
-    if (i == 0) {
+    if (buffer != NULL) {
+        *buffer = (i >= 2);
+    }
+
+    if (i % 2 == 0) {
         return &ctx->upload_event;
     }
 
@@ -1038,8 +1189,10 @@ ngx_stream_js_ext_on(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
     nxt_str_t              name;
+    ngx_uint_t             buffer;
     njs_vm_event_t        *event;
     const njs_value_t     *callback;
+    ngx_stream_js_ctx_t   *ctx;
     ngx_stream_session_t  *s;
 
     s = njs_vm_external(vm, njs_arg(args, nargs, 0));
@@ -1060,7 +1213,7 @@ ngx_stream_js_ext_on(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
-    event = ngx_stream_js_event(s, &name);
+    event = ngx_stream_js_event(s, &name, &buffer);
     if (event == NULL) {
         return NJS_ERROR;
     }
@@ -1076,6 +1229,15 @@ ngx_stream_js_ext_on(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
+    ctx = ngx_stream_get_module_ctx(s, ngx_stream_js_module);
+
+    if (event == &ctx->upload_event) {
+        ctx->upload_buffer = buffer;
+
+    } else {
+        ctx->download_buffer = buffer;
+    }
+
     return NJS_OK;
 }
 
@@ -1100,7 +1262,7 @@ ngx_stream_js_ext_off(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
-    event = ngx_stream_js_event(s, &name);
+    event = ngx_stream_js_event(s, &name, NULL);
     if (event == NULL) {
         return NJS_ERROR;
     }
@@ -1143,7 +1305,11 @@ ngx_stream_js_ext_send(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
-    if (ngx_stream_js_string(vm, njs_arg(args, nargs, 1), &buffer) != NJS_OK) {
+    value = njs_arg(args, nargs, 1);
+
+    if (njs_vm_value_array_buffer(vm, &buffer, value) != NJS_OK
+        && ngx_stream_js_string(vm, value, &buffer) != NJS_OK)
+    {
         njs_vm_error(vm, "failed to get buffer arg");
         return NJS_ERROR;
     }
@@ -1173,17 +1339,31 @@ ngx_stream_js_ext_send(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 
     b = cl->buf;
 
+    /*
+     * The string can be collected by the next njs_vm_run() while the buffer
+     * is still busy, so the data are copied to the buffer memory which is
+     * reused once the buffer is sent.
+     */
+
+    if ((size_t) (b->end - b->start) < buffer.length) {
+        b->start = ngx_pnalloc(c->pool, buffer.length);
+        if (b->start == NULL) {
+            njs_vm_error(vm, "memory error");
+            return NJS_ERROR;
+        }
+
+        b->end = b->start + buffer.length;
+    }
+
     b->flush = flush;
     b->last_buf = last_buf;
 
-    b->memory = (buffer.length ? 1 : 0);
+    b->temporary = (buffer.length ? 1 : 0);
     b->sync = (buffer.length ? 0 : 1);
     b->tag = (ngx_buf_tag_t) &ngx_stream_js_module;
 
-    b->start = buffer.start;
-    b->end = buffer.start + buffer.length;
     b->pos = b->start;
-    b->last = b->end;
+    b->last = ngx_cpymem(b->start, buffer.start, buffer.length);
 
     *ctx->last_out = cl;
     ctx->last_out = &cl->next;
@@ -1292,22 +1472,35 @@ static njs_host_event_t
 ngx_stream_js_set_timer(njs_external_ptr_t external, uint64_t delay,
     njs_vm_event_t vm_event)
 {
+    ngx_queue_t            *q;
     ngx_event_t            *ev;
+    ngx_stream_js_ctx_t    *ctx;
     ngx_stream_session_t   *s;
     ngx_stream_js_event_t  *js_event;
+    ngx_stream_js_timer_t  *timer;
 
     s = (ngx_stream_session_t *) external;
 
-    ev = ngx_pcalloc(s->connection->pool, sizeof(ngx_event_t));
-    if (ev == NULL) {
-        return NULL;
-    }
+    ctx = ngx_stream_get_module_ctx(s, ngx_stream_js_module);
 
-    js_event = ngx_palloc(s->connection->pool, sizeof(ngx_stream_js_event_t));
-    if (js_event == NULL) {
-        return NULL;
+    if (!ngx_queue_empty(&ctx->free_timers)) {
+        q = ngx_queue_head(&ctx->free_timers);
+        ngx_queue_remove(q);
+
+        timer = ngx_queue_data(q, ngx_stream_js_timer_t, queue);
+
+    } else {
+        timer = ngx_palloc(s->connection->pool, sizeof(ngx_stream_js_timer_t));
+        if (timer == NULL) {
+            return NULL;
+        }
     }
 
+    ev = &timer->event;
+    ngx_memzero(ev, sizeof(ngx_event_t));
+
+    js_event = &timer->data;
+
     js_event->session = s;
     js_event->vm_event = vm_event;
     js_event->ident = s->connection->fd;
@@ -1318,18 +1511,27 @@ ngx_stream_js_set_timer(njs_external_ptr_t external, uint64_t delay,
 
     ngx_add_timer(ev, delay);
 
-    return ev;
+    return timer;
 }
 
 
 static void
 ngx_stream_js_clear_timer(njs_external_ptr_t external, njs_host_event_t event)
 {
-    ngx_event_t  *ev = event;
+    ngx_stream_js_ctx_t    *ctx;
+    ngx_stream_session_t   *s;
+    ngx_stream_js_timer_t  *timer;
+
+    s = (ngx_stream_session_t *) external;
+    timer = (ngx_stream_js_timer_t *) event;
+
+    ctx = ngx_stream_get_module_ctx(s, ngx_stream_js_module);
 
-    if (ev->timer_set) {
-        ngx_del_timer(ev);
+    if (timer->event.timer_set) {
+        ngx_del_timer(&timer->event);
     }
+
+    ngx_queue_insert_head(&ctx->free_timers, &timer->queue);
 }
 
 
@@ -1472,10 +1674,16 @@ ngx_stream_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
     ngx_memzero(&options, sizeof(njs_vm_opt_t));
 
     options.backtrace = 1;
+    options.gc = 1;
+    options.lazy = (jmcf->lazy == 1);
     options.ops = &ngx_stream_js_ops;
     options.argv = ngx_argv;
     options.argc = ngx_argc;
 
+    if (jmcf->jit != NGX_CONF_UNSET) {
+        options.jit = jmcf->jit;
+    }
+
     file = value[1];
     options.file.start = file.data;
     options.file.length = file.len;
@@ -1552,6 +1760,26 @@ ngx_stream_js_include(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 }
 
 
+/*
+ * The VM options are applied when "js_include" creates the VM,
+ * the directives setting them are not allowed after it.
+ */
+
+static char *
+ngx_stream_js_before_include(ngx_conf_t *cf, void *post, void *data)
+{
+    ngx_stream_js_main_conf_t  *jmcf;
+
+    jmcf = ngx_stream_conf_get_module_main_conf(cf, ngx_stream_js_module);
+
+    if (jmcf->vm != NULL) {
+        return "must be specified before \"js_include\"";
+    }
+
+    return NGX_CONF_OK;
+}
+
+
 static char *
 ngx_stream_js_set(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 {
@@ -1588,6 +1816,57 @@ ngx_stream_js_set(ngx_conf_t *cf, ngx_command_t *cmd, void *conf)
 }
 
 
+static ngx_int_t
+ngx_stream_js_add_variables(ngx_conf_t *cf)
+{
+    ngx_stream_variable_t  *var, *v;
+
+    for (v = ngx_stream_js_vars; v->name.len; v++) {
+        var = ngx_stream_add_variable(cf, &v->name, v->flags);
+        if (var == NULL) {
+            return NGX_ERROR;
+        }
+
+        var->get_handler = v->get_handler;
+        var->data = v->data;
+    }
+
+    return NGX_OK;
+}
+
+
+static ngx_int_t
+ngx_stream_js_mem_peak_variable(ngx_stream_session_t *s,
+    ngx_stream_variable_value_t *v, uintptr_t data)
+{
+    u_char               *p;
+    nxt_mp_stat_t         stat;
+    ngx_stream_js_ctx_t  *ctx;
+
+    ctx = ngx_stream_get_module_ctx(s, ngx_stream_js_module);
+
+    if (ctx == NULL || ctx->vm == NULL) {
+        v->not_found = 1;
+        return NGX_OK;
+    }
+
+    p = ngx_pnalloc(s->connection->pool, NGX_SIZE_T_LEN);
+    if (p == NULL) {
+        return NGX_ERROR;
+    }
+
+    njs_vm_memory_stats(ctx->vm, &stat);
+
+    v->len = ngx_sprintf(p, "%uz", stat.peak) - p;
+    v->valid = 1;
+    v->no_cacheable = 0;
+    v->not_found = 0;
+    v->data = p;
+
+    return NGX_OK;
+}
+
+
 static void *
 ngx_stream_js_create_main_conf(ngx_conf_t *cf)
 {
@@ -1606,11 +1885,38 @@ ngx_stream_js_create_main_conf(ngx_conf_t *cf)
      */
 
     conf->paths = NGX_CONF_UNSET_PTR;
+    conf->memory_limit = NGX_CONF_UNSET_SIZE;
+    conf->max_instructions = NGX_CONF_UNSET;
+    conf->timeout = NGX_CONF_UNSET_MSEC;
+    conf->lazy = NGX_CONF_UNSET;
+    conf->jit = NGX_CONF_UNSET;
 
     return conf;
 }
 
 
+static char *
+ngx_stream_js_init_main_conf(ngx_conf_t *cf, void *conf)
+{
+    ngx_stream_js_main_conf_t *jmcf = conf;
+
+    ngx_conf_init_size_value(jmcf->memory_limit, 0);
+    ngx_conf_init_value(jmcf->max_instructions, 0);
+    ngx_conf_init_msec_value(jmcf->timeout, 0);
+    ngx_conf_init_value(jmcf->lazy, 0);
+    ngx_conf_init_value(jmcf->jit, 0);
+
+    if (jmcf->jit && (jmcf->max_instructions || jmcf->timeout)) {
+        ngx_conf_log_error(NGX_LOG_WARN, cf, 0,
+                           "\"js_jit\" is ignored while "
+                           "\"js_max_instructions\" or \"js_timeout\" "
+                           "is set");
+    }
+
+    return NGX_CONF_OK;
+}
+
+
 static void *
 ngx_stream_js_create_srv_conf(ngx_conf_t *cf)
 {
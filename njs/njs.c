@@ -6,6 +6,7 @@
 
 #include <njs_core.h>
 #include <njs_regexp.h>
+#include <njs_promise.h>
 #include <string.h>
 
 
@@ -123,6 +124,8 @@ njs_vm_create(njs_vm_opt_t *options)
 
             options->shared = vm->shared;
 
+            vm->shared->mem_pool = mp;
+
             nxt_lvlhsh_init(&vm->shared->keywords_hash);
 
             ret = njs_lexer_keywords_init(mp, &vm->shared->keywords_hash);
@@ -209,6 +212,12 @@ njs_vm_destroy(njs_vm_t *vm)
         }
     }
 
+#if (NXT_HAVE_JIT)
+    if (vm->shared != NULL && vm->shared->mem_pool == vm->mem_pool) {
+        njs_jit_destroy(vm->shared);
+    }
+#endif
+
     nxt_mp_destroy(vm->mem_pool);
 }
 
@@ -318,8 +327,15 @@ njs_vm_clone(njs_vm_t *vm, njs_external_ptr_t external)
         return NULL;
     }
 
-    nmp = nxt_mp_create(&njs_vm_mp_proto, NULL, NULL, 2 * nxt_pagesize(),
-                        128, 512, 16);
+    if (vm->options.arena && !vm->options.gc) {
+        nmp = nxt_mp_arena_create(&njs_vm_mp_proto, NULL, NULL,
+                                  4 * nxt_pagesize());
+
+    } else {
+        nmp = nxt_mp_create(&njs_vm_mp_proto, NULL, NULL, 2 * nxt_pagesize(),
+                            128, 512, 16);
+    }
+
     if (nxt_slow_path(nmp == NULL)) {
         return NULL;
     }
@@ -367,6 +383,19 @@ njs_vm_clone(njs_vm_t *vm, njs_external_ptr_t external)
 
         nvm->global_scope = vm->global_scope;
         nvm->scope_size = vm->scope_size;
+        nvm->frozen = vm->frozen;
+
+        if (vm->options.gc) {
+            njs_gc_init(nvm);
+            nvm->gc = 1;
+        }
+
+        /*
+         * The compiled code and the arena pool cannot release
+         * the strings, see njs_value_release().
+         */
+        nvm->refcount = !vm->options.jit
+                        && (!vm->options.arena || vm->options.gc);
 
         nvm->debug = vm->debug;
 
@@ -433,6 +462,7 @@ njs_vm_init(njs_vm_t *vm)
 
     nxt_lvlhsh_init(&vm->events_hash);
     nxt_queue_init(&vm->posted_events);
+    nxt_queue_init(&vm->unhandled_rejections);
 
     if (vm->debug != NULL) {
         backtrace = nxt_array_create(4, sizeof(njs_backtrace_entry_t),
@@ -468,6 +498,10 @@ njs_vm_invoke(njs_vm_t *vm, njs_function_t *function, const njs_value_t *args,
     njs_ret_t    ret;
     njs_value_t  *this;
 
+    if (nxt_slow_path(vm->terminated)) {
+        return njs_vm_terminate(vm);
+    }
+
     this = (njs_value_t *) &njs_value_undefined;
 
     current = vm->current;
@@ -507,6 +541,8 @@ njs_vm_add_event(njs_vm_t *vm, njs_function_t *function, nxt_uint_t once,
     event->function = function;
     event->once = once;
     event->posted = 0;
+    event->interval = 0;
+    event->delay = 0;
     event->nargs = 0;
     event->args = NULL;
 
@@ -573,11 +609,31 @@ njs_vm_post_event(njs_vm_t *vm, njs_vm_event_t vm_event,
 nxt_int_t
 njs_vm_run(njs_vm_t *vm)
 {
+    nxt_int_t  ret;
+
     if (nxt_slow_path(vm->backtrace != NULL)) {
         nxt_array_reset(vm->backtrace);
     }
 
-    return njs_vm_handle_events(vm);
+    ret = njs_vm_handle_events(vm);
+
+    if (vm->gc && vm->gc_allocated >= vm->gc_threshold && ret != NJS_ERROR) {
+        /* A failed collection just leaves the values allocated. */
+        (void) njs_vm_gc(vm);
+    }
+
+    return ret;
+}
+
+
+nxt_int_t
+njs_vm_gc(njs_vm_t *vm)
+{
+    if (!vm->gc || vm->top_frame == NULL || vm->top_frame->previous != NULL) {
+        return NXT_ERROR;
+    }
+
+    return njs_gc(vm);
 }
 
 
@@ -586,6 +642,15 @@ njs_vm_start(njs_vm_t *vm)
 {
     njs_ret_t  ret;
 
+    if (vm->frozen) {
+        /* The global code has already been run before njs_vm_freeze(). */
+        return NXT_OK;
+    }
+
+    if (nxt_slow_path(vm->terminated)) {
+        return njs_vm_terminate(vm);
+    }
+
     ret = njs_module_load(vm);
     if (nxt_slow_path(ret != NXT_OK)) {
         return ret;
@@ -601,6 +666,70 @@ njs_vm_start(njs_vm_t *vm)
 }
 
 
+void
+njs_vm_memory_stats(njs_vm_t *vm, nxt_mp_stat_t *stat)
+{
+    nxt_mp_stat(vm->mem_pool, stat);
+}
+
+
+void
+njs_vm_memory_limit(njs_vm_t *vm, size_t limit)
+{
+    nxt_mp_limit(vm->mem_pool, limit);
+}
+
+
+void
+njs_vm_execution_limit(njs_vm_t *vm, nxt_uint_t instructions,
+    nxt_uint_t timeout)
+{
+    vm->ops_limit = instructions;
+    vm->timeout = (uint64_t) timeout * 1000000;
+}
+
+
+nxt_int_t
+njs_vm_freeze(njs_vm_t *vm)
+{
+    u_char       *values, *scope;
+    njs_ret_t    ret;
+    njs_value_t  *value, *end;
+
+    if (vm->options.accumulative) {
+        return NXT_ERROR;
+    }
+
+    scope = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t), vm->scope_size);
+    if (nxt_slow_path(scope == NULL)) {
+        return NXT_ERROR;
+    }
+
+    values = (u_char *) vm->scopes[NJS_SCOPE_GLOBAL] + NJS_INDEX_GLOBAL_OFFSET;
+    memcpy(scope, values, vm->scope_size);
+
+    value = (njs_value_t *) scope;
+    end = (njs_value_t *) (scope + vm->scope_size);
+
+    while (value < end) {
+        ret = njs_object_deep_freeze(vm, value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        value++;
+    }
+
+    vm->global_scope = (njs_value_t *) scope;
+    vm->frozen = 1;
+
+    /* The strings are referenced by the clones now. */
+    vm->gc = 0;
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 njs_vm_handle_events(njs_vm_t *vm)
 {
@@ -626,6 +755,13 @@ njs_vm_handle_events(njs_vm_t *vm)
         } else {
             ev->posted = 0;
             nxt_queue_remove(&ev->link);
+
+            if (ev->interval) {
+                ret = njs_rearm_event(vm, ev);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return ret;
+                }
+            }
         }
 
         ret = njs_vm_call(vm, ev->function, ev->args, ev->nargs);
@@ -635,6 +771,10 @@ njs_vm_handle_events(njs_vm_t *vm)
         }
     }
 
+    if (nxt_slow_path(!nxt_queue_is_empty(&vm->unhandled_rejections))) {
+        return njs_promise_unhandled_rejection(vm);
+    }
+
     return njs_posted_events(vm) ? NJS_AGAIN : NJS_OK;
 }
 
@@ -761,7 +901,7 @@ njs_vm_object_alloc(njs_vm_t *vm, njs_value_t *retval, ...)
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&object->hash, &lhq);
+        ret = nxt_flathsh_insert(&object->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
             njs_internal_error(vm, NULL);
             goto done;
@@ -797,7 +937,7 @@ njs_vm_object_prop(njs_vm_t *vm, const njs_value_t *value, const nxt_str_t *key)
     lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_find(&value->data.u.object->hash, &lhq);
+    ret = nxt_flathsh_find(&value->data.u.object->hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
         return NULL;
     }
@@ -806,3 +946,74 @@ njs_vm_object_prop(njs_vm_t *vm, const njs_value_t *value, const nxt_str_t *key)
 
     return &prop->value;
 }
+
+
+njs_ret_t
+njs_vm_array_alloc(njs_vm_t *vm, njs_value_t *retval, uint32_t spare)
+{
+    njs_array_t  *array;
+
+    array = njs_array_alloc(vm, 0, spare);
+
+    if (nxt_slow_path(array == NULL)) {
+        return NJS_ERROR;
+    }
+
+    retval->data.u.array = array;
+    retval->type = NJS_ARRAY;
+    retval->data.truth = 1;
+
+    return NJS_OK;
+}
+
+
+njs_value_t *
+njs_vm_array_push(njs_vm_t *vm, njs_value_t *value)
+{
+    njs_ret_t    ret;
+    njs_value_t  *slot;
+    njs_array_t  *array;
+
+    if (nxt_slow_path(!njs_is_array(value))) {
+        njs_type_error(vm, "njs_vm_array_push() argument is not array");
+        return NULL;
+    }
+
+    array = value->data.u.array;
+
+    ret = njs_array_expand(vm, array, 0, 1);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    slot = &array->start[array->length++];
+    *slot = njs_value_undefined;
+
+    return slot;
+}
+
+
+njs_value_t *
+njs_vm_array_start(njs_vm_t *vm, njs_value_t *value)
+{
+    if (nxt_slow_path(!njs_is_array(value))) {
+        njs_type_error(vm, "njs_vm_array_start() argument is not array");
+        return NULL;
+    }
+
+    return value->data.u.array->start;
+}
+
+
+njs_ret_t
+njs_vm_array_length(njs_vm_t *vm, njs_value_t *value, uint32_t *length)
+{
+    if (nxt_slow_path(!njs_is_array(value))) {
+        njs_type_error(vm, "njs_vm_array_length() argument is not array");
+        return NJS_ERROR;
+    }
+
+    *length = value->data.u.array->length;
+
+    return NJS_OK;
+}
@@ -20,6 +20,7 @@
 #include <nxt_stub.h>
 #include <nxt_array.h>
 #include <nxt_lvlhsh.h>
+#include <nxt_mp.h>
 
 
 typedef intptr_t                    njs_ret_t;
@@ -66,6 +67,7 @@ typedef njs_ret_t (*njs_extern_set_t)(njs_vm_t *vm, void *obj, uintptr_t data,
     nxt_str_t *value);
 typedef njs_ret_t (*njs_extern_find_t)(njs_vm_t *vm, void *obj, uintptr_t data,
     nxt_bool_t delete);
+/* The "next" iteration state has room for a pointer. */
 typedef njs_ret_t (*njs_extern_foreach_t)(njs_vm_t *vm, void *obj, void *next);
 typedef njs_ret_t (*njs_extern_next_t)(njs_vm_t *vm, njs_value_t *value,
     void *obj, void *next);
@@ -153,6 +155,39 @@ typedef struct {
     uint8_t                         sandbox;         /* 1 bit */
     uint8_t                         module;          /* 1 bit */
     uint8_t                         quiet;           /* 1 bit */
+
+    /*
+     * The clones of the VM reclaim unreachable strings, objects and
+     * arrays, see njs_vm_gc().
+     * The strings obtained with njs_vm_value_to_ext_string() are valid
+     * until the next njs_vm_run() or njs_vm_gc() then.
+     */
+    uint8_t                         gc;              /* 1 bit */
+
+    /*
+     * The clones of the VM allocate memory from an arena, the memory
+     * is not reused and is released by njs_vm_destroy() at once.
+     * The option is ignored if the gc option is set.
+     */
+    uint8_t                         arena;           /* 1 bit */
+
+    /*
+     * The bodies of functions are only scanned at compile time,
+     * they are parsed and their bytecode is generated on their
+     * first call.  The syntax errors in a function body are reported
+     * on its calls.  The code is allocated from the memory pool of
+     * the VM which has compiled the script and is shared by all
+     * its clones.
+     */
+    uint8_t                         lazy;            /* 1 bit */
+
+    /*
+     * Functions are compiled to machine code after the given number
+     * of calls and loop iterations, zero disables the compilation.
+     * The option is ignored unless njs is configured with NXT_JIT=YES
+     * on x86-64, and while the execution limits are set.
+     */
+    uint32_t                        jit;
 } njs_vm_opt_t;
 
 
@@ -208,9 +243,20 @@ NXT_EXPORT nxt_int_t njs_vm_invoke(njs_vm_t *vm, njs_function_t *function,
  *    still pending.
  *  NJS_ERROR some exception or internal error happens.
  *    njs_vm_retval(vm) can be used to get the retval or exception value.
+ *
+ * If the "gc" option is set the unreachable values are collected
+ * when enough memory has been allocated since the last collection.
  */
 NXT_EXPORT nxt_int_t njs_vm_run(njs_vm_t *vm);
 
+/*
+ * Collects the strings, objects and arrays allocated by the VM clone which
+ * are not reachable from the global variables, the pending events and the
+ * retval.
+ * The VM must not run any code, that is between njs_vm_run() calls.
+ */
+NXT_EXPORT nxt_int_t njs_vm_gc(njs_vm_t *vm);
+
 /*
  * Runs the global code.
  *   NJS_OK successful run.
@@ -220,6 +266,35 @@ NXT_EXPORT nxt_int_t njs_vm_run(njs_vm_t *vm);
  */
 NXT_EXPORT nxt_int_t njs_vm_start(njs_vm_t *vm);
 
+/*
+ * Makes the current values of the global variables the initial values
+ * of the VM clones.  All the objects reachable from the global variables
+ * are frozen, so the clones share them without copying.  The global code
+ * is not run again by njs_vm_start() of the frozen VM and its clones.
+ *
+ * The VM must not be destroyed while its clones are alive.
+ */
+NXT_EXPORT nxt_int_t njs_vm_freeze(njs_vm_t *vm);
+
+NXT_EXPORT void njs_vm_memory_stats(njs_vm_t *vm, nxt_mp_stat_t *stat);
+
+/*
+ * Limits the memory of the VM, an allocation over the limit throws
+ * MemoryError.  The limit 0 means unlimited.
+ */
+NXT_EXPORT void njs_vm_memory_limit(njs_vm_t *vm, size_t limit);
+
+/*
+ * Limits the total number of instructions executed by the VM and the time
+ * in milliseconds of each njs_vm_start(), njs_vm_call() or event handler.
+ * The limits are checked on backward jumps, calls and returns.  When
+ * a limit is exceeded the VM throws InternalError which cannot be caught,
+ * and all the following runs of the VM fail.  The limit 0 means unlimited.
+ * Functions are not run as machine code while any limit is set.
+ */
+NXT_EXPORT void njs_vm_execution_limit(njs_vm_t *vm, nxt_uint_t instructions,
+    nxt_uint_t timeout);
+
 NXT_EXPORT nxt_int_t njs_vm_add_path(njs_vm_t *vm, const nxt_str_t *path);
 
 NXT_EXPORT const njs_extern_t *njs_vm_external_prototype(njs_vm_t *vm,
@@ -280,6 +355,7 @@ NXT_EXPORT nxt_int_t njs_value_is_number(const njs_value_t *value);
 NXT_EXPORT nxt_int_t njs_value_is_valid_number(const njs_value_t *value);
 NXT_EXPORT nxt_int_t njs_value_is_string(const njs_value_t *value);
 NXT_EXPORT nxt_int_t njs_value_is_object(const njs_value_t *value);
+NXT_EXPORT nxt_int_t njs_value_is_array(const njs_value_t *value);
 NXT_EXPORT nxt_int_t njs_value_is_function(const njs_value_t *value);
 
 NXT_EXPORT njs_ret_t njs_vm_object_alloc(njs_vm_t *vm, njs_value_t *retval,
@@ -287,6 +363,37 @@ NXT_EXPORT njs_ret_t njs_vm_object_alloc(njs_vm_t *vm, njs_value_t *retval,
 NXT_EXPORT njs_value_t *njs_vm_object_prop(njs_vm_t *vm,
     const njs_value_t *value, const nxt_str_t *key);
 
+NXT_EXPORT njs_ret_t njs_vm_array_alloc(njs_vm_t *vm, njs_value_t *retval,
+    uint32_t spare);
+/*
+ * Appends an undefined element to an array and returns a pointer to it.
+ */
+NXT_EXPORT njs_value_t *njs_vm_array_push(njs_vm_t *vm, njs_value_t *value);
+NXT_EXPORT njs_value_t *njs_vm_array_start(njs_vm_t *vm, njs_value_t *value);
+NXT_EXPORT njs_ret_t njs_vm_array_length(njs_vm_t *vm, njs_value_t *value,
+    uint32_t *length);
+
+/*
+ * Creates a pending promise, its resolve and reject functions are
+ * stored in callbacks[0] and callbacks[1].
+ */
+NXT_EXPORT njs_ret_t njs_vm_promise_create(njs_vm_t *vm, njs_value_t *retval,
+    njs_value_t *callbacks);
+
+/*
+ * Creates an ArrayBuffer referring to the memory without copying.
+ * The buffer must be detached before the memory becomes invalid.
+ */
+NXT_EXPORT njs_ret_t njs_vm_array_buffer_set(njs_vm_t *vm, njs_value_t *value,
+    u_char *start, uint32_t size);
+NXT_EXPORT void njs_vm_array_buffer_detach(njs_vm_t *vm, njs_value_t *value);
+/*
+ * Gets the bytes of an ArrayBuffer, a typed array or a DataView,
+ * returns NXT_DECLINED for other values.
+ */
+NXT_EXPORT njs_ret_t njs_vm_value_array_buffer(njs_vm_t *vm, nxt_str_t *dst,
+    const njs_value_t *value);
+
 NXT_EXPORT njs_ret_t njs_vm_json_parse(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs);
 NXT_EXPORT njs_ret_t njs_vm_json_stringify(njs_vm_t *vm, njs_value_t *args,
@@ -52,6 +52,7 @@ typedef struct {
      */
     njs_value_t             retval;
 
+    njs_function_loop_t     loop;
     uint32_t                index;
     uint32_t                length;
 } njs_array_iter_t;
@@ -88,11 +89,34 @@ typedef struct {
     njs_value_t             retval;
 
     njs_function_t          *function;
-    uint32_t                index;
+    njs_value_t             *buffer;
+    njs_value_t             *src;
+    njs_value_t             *dst;
+
+    /* The number of sorted values. */
+    uint32_t                length;
+
+    /* The current merge of src[lo..mid) and src[mid..hi) to dst[lo..hi). */
+    uint32_t                width;
+    uint32_t                mid;
+    uint32_t                hi;
+    uint32_t                left;
+    uint32_t                right;
     uint32_t                current;
 } njs_array_sort_t;
 
 
+typedef struct {
+    njs_value_t             key;
+    njs_value_t             value;
+} njs_array_sort_entry_t;
+
+
+/* Returns a positive value if the first value should be placed after. */
+typedef double (*njs_array_sort_compare_t)(const njs_value_t *val1,
+    const njs_value_t *val2);
+
+
 static njs_ret_t njs_array_prototype_slice_continuation(njs_vm_t *vm,
     njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
 static njs_ret_t njs_array_prototype_slice_copy(njs_vm_t *vm,
@@ -122,6 +146,11 @@ static nxt_noinline uint32_t njs_array_prototype_map_index(njs_array_t *array,
     njs_array_map_t *map);
 static nxt_noinline njs_ret_t njs_array_iterator_args(njs_vm_t *vm,
     njs_value_t *args, nxt_uint_t nargs);
+static njs_ret_t njs_array_iterator_loop(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static nxt_noinline njs_ret_t njs_array_iterator_call(njs_vm_t *vm,
+    njs_array_iter_t *iter, njs_function_t *function, njs_value_t *args,
+    nxt_uint_t nargs);
 static nxt_noinline uint32_t njs_array_iterator_index(njs_array_t *array,
     njs_array_iter_t *iter);
 static nxt_noinline njs_ret_t njs_array_iterator_apply(njs_vm_t *vm,
@@ -138,10 +167,23 @@ static njs_ret_t njs_array_prototype_sort_continuation(njs_vm_t *vm,
     njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
 
 
+nxt_inline njs_ret_t
+njs_array_frozen(njs_vm_t *vm, njs_array_t *array)
+{
+    if (nxt_slow_path(array->object.frozen)) {
+        njs_type_error(vm, "Cannot modify a frozen array");
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
 nxt_noinline njs_array_t *
 njs_array_alloc(njs_vm_t *vm, uint64_t length, uint32_t spare)
 {
     uint64_t     size;
+    njs_value_t  *data;
     njs_array_t  *array;
 
     if (nxt_slow_path(length > UINT32_MAX)) {
@@ -154,24 +196,36 @@ njs_array_alloc(njs_vm_t *vm, uint64_t length, uint32_t spare)
         goto memory_error;
     }
 
-    array = nxt_mp_alloc(vm->mem_pool, sizeof(njs_array_t));
-    if (nxt_slow_path(array == NULL)) {
+    data = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                        size * sizeof(njs_value_t));
+    if (nxt_slow_path(data == NULL)) {
         goto memory_error;
     }
 
-    array->data = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
-                               size * sizeof(njs_value_t));
-    if (nxt_slow_path(array->data == NULL)) {
+    if (vm->gc) {
+        array = njs_gc_alloc(vm, NJS_ARRAY, sizeof(njs_array_t));
+
+        /* The elements are freed along with the array. */
+        vm->gc_allocated += size * sizeof(njs_value_t);
+
+    } else {
+        array = nxt_mp_alloc(vm->mem_pool, sizeof(njs_array_t));
+    }
+
+    if (nxt_slow_path(array == NULL)) {
+        nxt_mp_free(vm->mem_pool, data);
         goto memory_error;
     }
 
+    array->data = data;
     array->start = array->data;
-    nxt_lvlhsh_init(&array->object.hash);
+    nxt_flathsh_init(&array->object.hash);
     array->object.shared_hash = vm->shared->array_instance_hash;
     array->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_ARRAY].object;
     array->object.type = NJS_ARRAY;
     array->object.shared = 0;
     array->object.extensible = 1;
+    array->object.frozen = 0;
     array->size = size;
     array->length = length;
 
@@ -260,6 +314,10 @@ njs_array_expand(njs_vm_t *vm, njs_array_t *array, uint32_t prepend,
 
     array->size = size;
 
+    if (vm->gc) {
+        vm->gc_allocated += size * sizeof(njs_value_t);
+    }
+
     old = array->data;
     array->data = start;
     start += prepend;
@@ -487,6 +545,10 @@ njs_array_length(njs_vm_t *vm, njs_value_t *value, njs_value_t *setval,
 
     array = (njs_array_t *) proto;
 
+    if (njs_array_frozen(vm, array) != NXT_OK) {
+        return NJS_ERROR;
+    }
+
     size = (int64_t) length - array->length;
 
     if (size > 0) {
@@ -706,6 +768,10 @@ njs_array_prototype_push(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     if (njs_is_array(&args[0])) {
         array = args[0].data.u.array;
 
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         if (nargs != 0) {
             ret = njs_array_expand(vm, array, 0, nargs);
             if (nxt_slow_path(ret != NXT_OK)) {
@@ -737,6 +803,10 @@ njs_array_prototype_pop(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     if (njs_is_array(&args[0])) {
         array = args[0].data.u.array;
 
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         if (array->length != 0) {
             array->length--;
             value = &array->start[array->length];
@@ -763,6 +833,11 @@ njs_array_prototype_unshift(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 
     if (njs_is_array(&args[0])) {
         array = args[0].data.u.array;
+
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         n = nargs - 1;
 
         if (n != 0) {
@@ -801,6 +876,10 @@ njs_array_prototype_shift(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     if (njs_is_array(&args[0])) {
         array = args[0].data.u.array;
 
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         if (array->length != 0) {
             array->length--;
 
@@ -836,6 +915,10 @@ njs_array_prototype_splice(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         array = args[0].data.u.array;
         length = array->length;
 
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         if (nargs > 1) {
             start = args[1].data.u.number;
 
@@ -931,6 +1014,11 @@ njs_array_prototype_reverse(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 
     if (njs_is_array(&args[0])) {
         array = args[0].data.u.array;
+
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
         length = array->length;
 
         if (length > 1) {
@@ -982,6 +1070,7 @@ njs_array_prototype_join(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
     uint32_t          max;
+    njs_ret_t         ret;
     nxt_uint_t        i, n;
     njs_array_t       *array;
     njs_value_t       *value, *values;
@@ -1035,9 +1124,23 @@ njs_array_prototype_join(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
                 && njs_is_valid(value)
                 && !njs_is_null_or_undefined(value))
             {
-                values[n++] = *value;
+                /*
+                 * Numbers and booleans are converted here, only objects
+                 * are converted by traps, each of them restarts the join.
+                 */
+
+                if (njs_is_primitive(value)) {
+                    ret = njs_primitive_value_to_string(vm, &values[n], value);
+                    if (nxt_slow_path(ret != NXT_OK)) {
+                        nxt_mp_free(vm->mem_pool, values);
+                        return NXT_ERROR;
+                    }
+
+                } else {
+                    values[n] = *value;
+                }
 
-                if (n >= max) {
+                if (++n >= max) {
                     break;
                 }
             }
@@ -1216,12 +1319,66 @@ njs_array_copy(njs_value_t *dst, njs_value_t *src)
 }
 
 
+/*
+ * The search loops are specialized by the type of the searched value
+ * to avoid njs_values_strict_equal() type dispatch for each element.
+ * The elements are njs_value_t of any type, there are no element kinds
+ * and no raw double storage, so elements are compared one at a time.
+ */
+
+static nxt_int_t
+njs_array_index_of(const njs_value_t *start, nxt_int_t i, nxt_int_t length,
+    const njs_value_t *value)
+{
+    double  num;
+
+    if (njs_is_number(value)) {
+        num = value->data.u.number;
+
+        do {
+            if (start[i].type == NJS_NUMBER && start[i].data.u.number == num) {
+                return i;
+            }
+
+            i++;
+
+        } while (i < length);
+
+        return -1;
+    }
+
+    if (njs_is_string(value)) {
+
+        do {
+            if (njs_is_string(&start[i]) && njs_string_eq(value, &start[i])) {
+                return i;
+            }
+
+            i++;
+
+        } while (i < length);
+
+        return -1;
+    }
+
+    do {
+        if (njs_values_strict_equal(value, &start[i])) {
+            return i;
+        }
+
+        i++;
+
+    } while (i < length);
+
+    return -1;
+}
+
+
 static njs_ret_t
 njs_array_prototype_index_of(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
     nxt_int_t    i, index, length;
-    njs_value_t  *value, *start;
     njs_array_t  *array;
 
     index = -1;
@@ -1255,18 +1412,7 @@ njs_array_prototype_index_of(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         }
     }
 
-    value = &args[1];
-    start = array->start;
-
-    do {
-        if (njs_values_strict_equal(value, &start[i])) {
-            index = i;
-            break;
-        }
-
-        i++;
-
-    } while (i < length);
+    index = njs_array_index_of(array->start, i, length, &args[1]);
 
 done:
 
@@ -1280,6 +1426,7 @@ static njs_ret_t
 njs_array_prototype_last_index_of(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused)
 {
+    double       num;
     nxt_int_t    i, n, index, length;
     njs_value_t  *value, *start;
     njs_array_t  *array;
@@ -1317,6 +1464,37 @@ njs_array_prototype_last_index_of(njs_vm_t *vm, njs_value_t *args,
     value = &args[1];
     start = array->start;
 
+    if (njs_is_number(value)) {
+        num = value->data.u.number;
+
+        do {
+            if (start[i].type == NJS_NUMBER && start[i].data.u.number == num) {
+                index = i;
+                break;
+            }
+
+            i--;
+
+        } while (i >= 0);
+
+        goto done;
+    }
+
+    if (njs_is_string(value)) {
+
+        do {
+            if (njs_is_string(&start[i]) && njs_string_eq(value, &start[i])) {
+                index = i;
+                break;
+            }
+
+            i--;
+
+        } while (i >= 0);
+
+        goto done;
+    }
+
     do {
         if (njs_values_strict_equal(value, &start[i])) {
             index = i;
@@ -1392,16 +1570,8 @@ njs_array_prototype_includes(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 
         } while (i < length);
 
-    } else {
-        do {
-            if (njs_values_strict_equal(value, &start[i])) {
-                retval = &njs_value_true;
-                break;
-            }
-
-            i++;
-
-        } while (i < length);
+    } else if (njs_array_index_of(start, i, length, value) != -1) {
+        retval = &njs_value_true;
     }
 
 done:
@@ -1483,6 +1653,10 @@ njs_array_prototype_fill_continuation(njs_vm_t *vm, njs_value_t *args,
         array = this->data.u.array;
         length = array->length;
 
+        if (njs_array_frozen(vm, array) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
     } else {
 
         if (nxt_slow_path(!njs_is_primitive(&fill->length))) {
@@ -1571,7 +1745,7 @@ njs_array_prototype_for_each(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     iter = njs_vm_continuation(vm);
     iter->u.cont.function = njs_array_prototype_for_each_continuation;
 
-    return njs_array_prototype_for_each_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1610,7 +1784,7 @@ njs_array_prototype_some(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     iter = njs_vm_continuation(vm);
     iter->u.cont.function = njs_array_prototype_some_continuation;
 
-    return njs_array_prototype_some_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1660,7 +1834,7 @@ njs_array_prototype_every(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     iter->u.cont.function = njs_array_prototype_every_continuation;
     iter->retval.data.truth = 1;
 
-    return njs_array_prototype_every_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1714,7 +1888,7 @@ njs_array_prototype_filter(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NXT_ERROR;
     }
 
-    return njs_array_prototype_filter_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1769,7 +1943,7 @@ njs_array_prototype_find(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     find = njs_vm_continuation(vm);
     find->iter.u.cont.function = njs_array_prototype_find_continuation;
 
-    return njs_array_prototype_find_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1825,7 +1999,7 @@ njs_array_prototype_find_index(njs_vm_t *vm, njs_value_t *args,
     iter = njs_vm_continuation(vm);
     iter->u.cont.function = njs_array_prototype_find_index_continuation;
 
-    return njs_array_prototype_find_index_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1883,8 +2057,8 @@ njs_array_prototype_find_apply(njs_vm_t *vm, njs_array_iter_t *iter,
 
     arguments[3] = args[0];
 
-    return njs_function_apply(vm, args[1].data.u.function, arguments, 4,
-                              (njs_index_t) &iter->retval);
+    return njs_array_iterator_call(vm, iter, args[1].data.u.function,
+                                   arguments, 4);
 }
 
 
@@ -1909,7 +2083,7 @@ njs_array_prototype_map(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NXT_ERROR;
     }
 
-    return njs_array_prototype_map_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -1998,7 +2172,7 @@ njs_array_prototype_reduce(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         iter->retval = array->start[n];
     }
 
-    return njs_array_prototype_reduce_continuation(vm, args, nargs, unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -2032,8 +2206,8 @@ njs_array_prototype_reduce_continuation(njs_vm_t *vm, njs_value_t *args,
 
     arguments[4] = args[0];
 
-    return njs_function_apply(vm, args[1].data.u.function, arguments, 5,
-                              (njs_index_t) &iter->retval);
+    return njs_array_iterator_call(vm, iter, args[1].data.u.function,
+                                   arguments, 5);
 }
 
 
@@ -2049,6 +2223,8 @@ njs_array_iterator_args(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs)
         iter->retval.data.truth = 0;
         iter->index = NJS_ARRAY_INVALID_INDEX;
 
+        njs_function_loop_init(vm, &iter->loop, args[1].data.u.function);
+
         return NXT_OK;
     }
 
@@ -2058,6 +2234,48 @@ njs_array_iterator_args(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs)
 }
 
 
+/*
+ * The iterator methods are continuations which are called again after
+ * each callback call.  A user-defined callback is called in a native
+ * loop, then njs_array_iterator_call() returns NXT_AGAIN and the
+ * continuation is called again here without returning to the interpreter.
+ */
+
+static njs_ret_t
+njs_array_iterator_loop(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_ret_t         ret;
+    njs_array_iter_t  *iter;
+
+    iter = njs_vm_continuation(vm);
+
+    do {
+        ret = iter->u.cont.function(vm, args, nargs, unused);
+    } while (ret == NXT_AGAIN);
+
+    return ret;
+}
+
+
+static nxt_noinline njs_ret_t
+njs_array_iterator_call(njs_vm_t *vm, njs_array_iter_t *iter,
+    njs_function_t *function, njs_value_t *args, nxt_uint_t nargs)
+{
+    njs_ret_t  ret;
+
+    if (iter->loop.function != NULL) {
+        ret = njs_function_loop_call(vm, &iter->loop, args, nargs - 1,
+                                     &iter->retval);
+
+        return (ret == NXT_OK) ? NXT_AGAIN : ret;
+    }
+
+    return njs_function_apply(vm, function, args, nargs,
+                              (njs_index_t) &iter->retval);
+}
+
+
 static nxt_noinline uint32_t
 njs_array_iterator_index(njs_array_t *array, njs_array_iter_t *iter)
 {
@@ -2096,8 +2314,8 @@ njs_array_iterator_apply(njs_vm_t *vm, njs_array_iter_t *iter,
 
     arguments[3] = args[0];
 
-    return njs_function_apply(vm, args[1].data.u.function, arguments, 4,
-                              (njs_index_t) &iter->retval);
+    return njs_array_iterator_call(vm, iter, args[1].data.u.function,
+                                   arguments, 4);
 }
 
 
@@ -2134,8 +2352,7 @@ njs_array_prototype_reduce_right(njs_vm_t *vm, njs_value_t *args,
         iter->retval = array->start[n];
     }
 
-    return njs_array_prototype_reduce_right_continuation(vm, args, nargs,
-                                                         unused);
+    return njs_array_iterator_loop(vm, args, nargs, unused);
 }
 
 
@@ -2169,8 +2386,8 @@ njs_array_prototype_reduce_right_continuation(njs_vm_t *vm, njs_value_t *args,
 
     arguments[4] = args[0];
 
-    return njs_function_apply(vm, args[1].data.u.function, arguments, 5,
-                              (njs_index_t) &iter->retval);
+    return njs_array_iterator_call(vm, iter, args[1].data.u.function,
+                                   arguments, 5);
 }
 
 
@@ -2228,29 +2445,315 @@ static const njs_function_t  njs_array_string_sort_function = {
 };
 
 
+static double
+njs_array_sort_string_compare(const njs_value_t *val1, const njs_value_t *val2)
+{
+    return njs_string_cmp(val1, val2);
+}
+
+
+static double
+njs_array_sort_ascending_compare(const njs_value_t *val1,
+    const njs_value_t *val2)
+{
+    return val1->data.u.number - val2->data.u.number;
+}
+
+
+static double
+njs_array_sort_descending_compare(const njs_value_t *val1,
+    const njs_value_t *val2)
+{
+    return val2->data.u.number - val1->data.u.number;
+}
+
+
+/*
+ * The comparison functions "function(a, b) { return a - b }" and
+ * "function(a, b) { return b - a }" are compiled to the SUBSTRACT of
+ * the arguments followed by the RETURN of the result.  For numbers
+ * they are replaced with the native comparison.
+ */
+
+static njs_array_sort_compare_t
+njs_array_sort_numeric_compare(njs_vm_t *vm, njs_function_t *function)
+{
+    njs_vmcode_3addr_t     *sub;
+    njs_vmcode_return_t    *ret;
+    njs_function_lambda_t  *lambda;
+
+    if (function->native || function->bound != NULL) {
+        return NULL;
+    }
+
+    lambda = function->u.lambda;
+
+    if (lambda->start == NULL
+        && njs_generate_lambda(vm, lambda) != NXT_OK)
+    {
+        return NULL;
+    }
+
+    sub = (njs_vmcode_3addr_t *) lambda->start;
+
+    if (sub->code.operation != njs_vmcode_substraction) {
+        return NULL;
+    }
+
+    ret = (njs_vmcode_return_t *) (sub + 1);
+
+    if (ret->code.operation != njs_vmcode_return || ret->retval != sub->dst) {
+        return NULL;
+    }
+
+    if (sub->src1 == njs_scope_index(1, NJS_SCOPE_ARGUMENTS)
+        && sub->src2 == njs_scope_index(2, NJS_SCOPE_ARGUMENTS))
+    {
+        return njs_array_sort_ascending_compare;
+    }
+
+    if (sub->src1 == njs_scope_index(2, NJS_SCOPE_ARGUMENTS)
+        && sub->src2 == njs_scope_index(1, NJS_SCOPE_ARGUMENTS))
+    {
+        return njs_array_sort_descending_compare;
+    }
+
+    return NULL;
+}
+
+
+/* The bottom-up stable merge sort, returns either entries or buffer. */
+
+static njs_array_sort_entry_t *
+njs_array_merge_sort(njs_array_sort_entry_t *entries,
+    njs_array_sort_entry_t *buffer, uint32_t length,
+    njs_array_sort_compare_t compare)
+{
+    uint32_t                i, j, k, lo, mid, hi, width;
+    njs_array_sort_entry_t  *src, *dst, *tmp;
+
+    src = entries;
+    dst = buffer;
+
+    for (width = 1; width < length; width *= 2) {
+
+        for (lo = 0; lo < length; lo = hi) {
+            mid = nxt_min(lo + width, length);
+            hi = nxt_min(mid + width, length);
+
+            i = lo;
+            j = mid;
+            k = lo;
+
+            while (i < mid && j < hi) {
+                if (compare(&src[i].key, &src[j].key) > 0) {
+                    dst[k++] = src[j++];
+
+                } else {
+                    dst[k++] = src[i++];
+                }
+            }
+
+            while (i < mid) {
+                dst[k++] = src[i++];
+            }
+
+            while (j < hi) {
+                dst[k++] = src[j++];
+            }
+        }
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    return src;
+}
+
+
+/*
+ * Arrays of primitive values with the default comparison and arrays of
+ * numbers with a numeric comparison function are sorted without calls
+ * to the comparison function.
+ */
+
+static njs_ret_t
+njs_array_sort_native(njs_vm_t *vm, njs_array_t *array, uint32_t length,
+    njs_array_sort_compare_t compare)
+{
+    uint32_t                i;
+    njs_ret_t               ret;
+    nxt_bool_t              convert;
+    njs_array_sort_entry_t  *entries, *sorted;
+
+    entries = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                           2 * length * sizeof(njs_array_sort_entry_t));
+    if (nxt_slow_path(entries == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    convert = (compare == njs_array_sort_string_compare);
+
+    for (i = 0; i < length; i++) {
+        entries[i].value = array->start[i];
+
+        if (convert && !njs_is_string(&array->start[i])) {
+            ret = njs_primitive_value_to_string(vm, &entries[i].key,
+                                                &array->start[i]);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                nxt_mp_free(vm->mem_pool, entries);
+                return NXT_ERROR;
+            }
+
+        } else {
+            entries[i].key = array->start[i];
+        }
+    }
+
+    sorted = njs_array_merge_sort(entries, &entries[length], length, compare);
+
+    for (i = 0; i < length; i++) {
+        if (convert && !njs_is_string(&sorted[i].value)) {
+            njs_release(vm, &sorted[i].key);
+        }
+
+        array->start[i] = sorted[i].value;
+    }
+
+    nxt_mp_free(vm->mem_pool, entries);
+
+    return NXT_OK;
+}
+
+
 static njs_ret_t
 njs_array_prototype_sort(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused)
 {
-    njs_array_sort_t  *sort;
+    uint32_t                  i, n, length, undefined;
+    njs_ret_t                 ret;
+    nxt_bool_t                numbers, primitives;
+    njs_array_t               *array;
+    njs_value_t               *start;
+    njs_function_t            *function;
+    njs_array_sort_t          *sort;
+    njs_array_sort_compare_t  compare;
+
+    if (!njs_is_array(&args[0]) || args[0].data.u.array->length < 2) {
+        goto done;
+    }
 
-    if (njs_is_array(&args[0]) && args[0].data.u.array->length > 1) {
+    array = args[0].data.u.array;
 
-        sort = njs_vm_continuation(vm);
-        sort->u.cont.function = njs_array_prototype_sort_continuation;
-        sort->current = 0;
-        sort->retval = njs_value_zero;
+    if (njs_array_frozen(vm, array) != NXT_OK) {
+        return NXT_ERROR;
+    }
 
-        if (nargs > 1 && njs_is_function(&args[1])) {
-            sort->function = args[1].data.u.function;
+    /*
+     * Undefined values are moved after the sorted values, and holes
+     * are moved to the end of array.  Neither are compared.
+     */
 
-        } else {
-            sort->function = (njs_function_t *) &njs_array_string_sort_function;
+    start = array->start;
+    length = 0;
+    undefined = 0;
+    numbers = 1;
+    primitives = 1;
+
+    for (i = 0; i < array->length; i++) {
+        if (!njs_is_valid(&start[i])) {
+            continue;
+        }
+
+        if (njs_is_undefined(&start[i])) {
+            undefined++;
+            continue;
         }
 
-        return njs_array_prototype_sort_continuation(vm, args, nargs, unused);
+        numbers &= njs_is_number(&start[i]);
+        primitives &= njs_is_primitive(&start[i]);
+
+        start[length++] = start[i];
+    }
+
+    n = length + undefined;
+
+    for (i = length; i < n; i++) {
+        start[i] = njs_value_undefined;
+    }
+
+    for (i = n; i < array->length; i++) {
+        njs_set_invalid(&start[i]);
     }
 
+    if (length < 2) {
+        goto done;
+    }
+
+    function = NULL;
+
+    if (nargs > 1 && njs_is_function(&args[1])) {
+        function = args[1].data.u.function;
+    }
+
+    compare = NULL;
+
+    if (function == NULL) {
+        if (primitives) {
+            compare = njs_array_sort_string_compare;
+        }
+
+    } else if (numbers) {
+        compare = njs_array_sort_numeric_compare(vm, function);
+    }
+
+    if (compare != NULL) {
+        ret = njs_array_sort_native(vm, array, length, compare);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        goto done;
+    }
+
+    /*
+     * The values are sorted in a separate buffer because the comparison
+     * function may change the array.
+     */
+
+    sort = njs_vm_continuation(vm);
+
+    sort->buffer = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                                2 * length * sizeof(njs_value_t));
+    if (nxt_slow_path(sort->buffer == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    memcpy(sort->buffer, start, length * sizeof(njs_value_t));
+
+    sort->u.cont.function = njs_array_prototype_sort_continuation;
+    sort->function = (function != NULL)
+                     ? function
+                     : (njs_function_t *) &njs_array_string_sort_function;
+    sort->src = sort->buffer;
+    sort->dst = &sort->buffer[length];
+    sort->length = length;
+    sort->width = 1;
+    sort->mid = 1;
+    sort->hi = 2;
+    sort->left = 0;
+    sort->right = 1;
+    sort->current = 0;
+
+    njs_set_invalid(&sort->retval);
+
+    return njs_array_prototype_sort_continuation(vm, args, nargs, unused);
+
+done:
+
     vm->retval = args[0];
 
     return NXT_OK;
@@ -2261,70 +2764,98 @@ static njs_ret_t
 njs_array_prototype_sort_continuation(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused)
 {
-    uint32_t          n;
+    double            num;
+    uint32_t          i, n;
     njs_array_t       *array;
-    njs_value_t       value, *start, arguments[3];
+    njs_value_t       *src, *dst, *tmp, arguments[3];
     njs_array_sort_t  *sort;
 
-    array = args[0].data.u.array;
-    start = array->start;
-
     sort = njs_vm_continuation(vm);
 
-    if (njs_is_number(&sort->retval)) {
+    src = sort->src;
+    dst = sort->dst;
+
+    if (njs_is_valid(&sort->retval)) {
 
-        /*
-         * The sort function is implemented with the insertion sort algorithm.
-         * Its worst and average computational complexity is O^2.  This point
-         * should be considered as return point from comparison function so
-         * "goto next" moves control to the appropriate step of the algorithm.
-         * The first iteration also goes there because sort->retval is zero.
-         */
-        if (sort->retval.data.u.number <= 0) {
-            goto next;
+        /* The return point from the comparison function. */
+
+        if (njs_is_numeric(&sort->retval)) {
+            num = sort->retval.data.u.number;
+
+        } else if (njs_is_string(&sort->retval)) {
+            num = njs_string_to_number(&sort->retval, 0);
+
+        } else {
+            num = 0;
         }
 
-        n = sort->index;
+        njs_set_invalid(&sort->retval);
 
-    swap:
+        if (num > 0) {
+            dst[sort->current++] = src[sort->right++];
 
-        value = start[n];
-        start[n] = start[n - 1];
-        n--;
-        start[n] = value;
+        } else {
+            dst[sort->current++] = src[sort->left++];
+        }
+    }
 
-        do {
-            if (n > 0) {
+    for ( ;; ) {
 
-                if (njs_is_valid(&start[n])) {
+        if (sort->left < sort->mid && sort->right < sort->hi) {
+            arguments[0] = njs_value_undefined;
 
-                    if (njs_is_valid(&start[n - 1])) {
-                        arguments[0] = njs_value_undefined;
+            /* GC: array elt, array */
+            arguments[1] = src[sort->left];
+            arguments[2] = src[sort->right];
 
-                        /* GC: array elt, array */
-                        arguments[1] = start[n - 1];
-                        arguments[2] = start[n];
+            return njs_function_apply(vm, sort->function, arguments, 3,
+                                      (njs_index_t) &sort->retval);
+        }
 
-                        sort->index = n;
+        while (sort->left < sort->mid) {
+            dst[sort->current++] = src[sort->left++];
+        }
 
-                        return njs_function_apply(vm, sort->function,
-                                                  arguments, 3,
-                                                  (njs_index_t) &sort->retval);
-                    }
+        while (sort->right < sort->hi) {
+            dst[sort->current++] = src[sort->right++];
+        }
 
-                    /* Move invalid values to the end of array. */
-                    goto swap;
-                }
+        if (sort->hi == sort->length) {
+
+            /* A pass is completed. */
+
+            tmp = src;
+            src = dst;
+            dst = tmp;
+
+            sort->src = src;
+            sort->dst = dst;
+
+            sort->width *= 2;
+
+            if (sort->width >= sort->length) {
+                break;
             }
 
-        next:
+            sort->hi = 0;
+        }
+
+        sort->left = sort->hi;
+        sort->mid = nxt_min(sort->left + sort->width, sort->length);
+        sort->hi = nxt_min(sort->mid + sort->width, sort->length);
+        sort->right = sort->mid;
+        sort->current = sort->left;
+    }
 
-            sort->current++;
-            n = sort->current;
+    array = args[0].data.u.array;
+    n = nxt_min(sort->length, array->length);
 
-        } while (n < array->length);
+    for (i = 0; i < n; i++) {
+        array->start[i] = src[i];
     }
 
+    nxt_mp_free(vm->mem_pool, sort->buffer);
+
     vm->retval = args[0];
 
     return NXT_OK;
@@ -2562,7 +3093,7 @@ static const njs_object_prop_t  njs_array_prototype_properties[] =
         .type = NJS_METHOD,
         .name = njs_string("sort"),
         .value = njs_native_function(njs_array_prototype_sort,
-                     njs_continuation_size(njs_array_iter_t), 0),
+                     njs_continuation_size(njs_array_sort_t), 0),
         .writable = 1,
         .configurable = 1,
     },
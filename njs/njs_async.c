@@ -0,0 +1,417 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <njs_promise.h>
+#include <njs_async.h>
+#include <string.h>
+
+
+/*
+ * An async function returns its promise on the first "await".  The
+ * function frame is copied out of the stack along with the frames of the
+ * calls whose arguments were being evaluated, e.g. "f(1, await p)", and
+ * the function returns the promise as usual.  The awaited value is cast
+ * to a promise and its reaction job copies the frames back on top of the
+ * stack and restarts the "await" instruction, which stores the settled
+ * value or throws it.  So an awaiting function costs one heap block and
+ * the rest of the stack is not affected.  An uncaught exception rejects
+ * the function promise through the frame exception handler.
+ */
+
+#define NJS_ASYNC_MAGIC  0x6173
+
+
+static njs_ret_t njs_async_fulfilled(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_async_rejected(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_async_resume(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_async_state_t state);
+static njs_ret_t njs_async_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+
+
+njs_ret_t
+njs_async_frame_init(njs_vm_t *vm, njs_frame_t *frame)
+{
+    njs_ret_t    ret;
+    njs_async_t  *async;
+
+    async = nxt_mp_alloc(vm->mem_pool, sizeof(njs_async_t));
+    if (nxt_slow_path(async == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    ret = njs_promise_create(vm, &async->promise);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_mp_free(vm->mem_pool, async);
+        return ret;
+    }
+
+    async->fulfilled = njs_value_undefined;
+    async->rejected = njs_value_undefined;
+    async->value = njs_value_undefined;
+    async->state = NJS_ASYNC_RUNNING;
+    async->await = NULL;
+    async->frames = NULL;
+    async->nframes = 0;
+
+    frame->async = async;
+    frame->native.async = 1;
+    frame->native.exception.catch = (u_char *) njs_async_catch_nexus;
+
+    return NXT_OK;
+}
+
+
+njs_ret_t
+njs_async_suspend(njs_vm_t *vm, njs_frame_t *frame, const njs_value_t *value)
+{
+    u_char              *p;
+    size_t              size;
+    njs_ret_t           ret;
+    nxt_uint_t          i, n;
+    njs_value_t         data;
+    njs_async_t         *async;
+    njs_async_frame_t   *af;
+    njs_native_frame_t  *native;
+
+    async = frame->async;
+
+    n = 0;
+    size = 0;
+
+    for (native = vm->top_frame; /* void */; native = native->previous) {
+        n++;
+        size += native->free - (u_char *) native;
+
+        if (native == &frame->native) {
+            break;
+        }
+    }
+
+    af = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                      nxt_align_size(n * sizeof(njs_async_frame_t),
+                                     sizeof(njs_value_t))
+                      + size);
+    if (nxt_slow_path(af == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    if (njs_is_undefined(&async->fulfilled)) {
+        njs_value_data_set(&data, async);
+        data.data.magic16 = NJS_ASYNC_MAGIC;
+
+        ret = njs_promise_function(vm, &async->fulfilled, njs_async_fulfilled,
+                                   &data);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto failed;
+        }
+
+        ret = njs_promise_function(vm, &async->rejected, njs_async_rejected,
+                                   &data);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto failed;
+        }
+    }
+
+    ret = njs_promise_react(vm, value, &async->fulfilled, &async->rejected);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto failed;
+    }
+
+    p = (u_char *) af;
+    p += nxt_align_size(n * sizeof(njs_async_frame_t), sizeof(njs_value_t));
+
+    native = vm->top_frame;
+    i = n;
+
+    do {
+        i--;
+
+        af[i].address = native;
+        af[i].size = native->free - (u_char *) native;
+        af[i].frame = (njs_native_frame_t *) p;
+
+        memcpy(p, native, af[i].size);
+        p += af[i].size;
+
+        native = native->previous;
+
+    } while (i != 0);
+
+    /*
+     * The function frame is released by the return, the calls frames
+     * are released here.  A frame with its own stack chunk starts the
+     * chunk, so the copies tell the chunks to free.
+     */
+
+    for (i = n - 1; i != 0; i--) {
+        if (af[i].frame->size != 0) {
+            njs_function_stack_free(vm, af[i].address);
+        }
+    }
+
+    vm->top_frame = &frame->native;
+
+    async->await = vm->current;
+    async->frames = af;
+    async->nframes = n;
+
+    return NXT_OK;
+
+failed:
+
+    nxt_mp_free(vm->mem_pool, af);
+
+    return NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_async_fulfilled(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_async_resume(vm, args, nargs, NJS_ASYNC_FULFILLED);
+}
+
+
+static njs_ret_t
+njs_async_rejected(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_async_resume(vm, args, nargs, NJS_ASYNC_REJECTED);
+}
+
+
+/*
+ * The function is resumed on top of the handler frame and returns
+ * to the handler continuation.
+ *   args[1]: the async context,
+ *   args[2]: the settled value.
+ */
+
+static njs_ret_t
+njs_async_resume(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_async_state_t state)
+{
+    u_char              *free_start;
+    uint8_t             mask;
+    uint32_t            chunk_size, free_size;
+    intptr_t            delta;
+    nxt_uint_t          i, n, nesting;
+    njs_frame_t         *frame, *lambda_frame;
+    njs_async_t         *async;
+    njs_function_t      *function;
+    njs_async_frame_t   *af;
+    njs_promise_cont_t  *cont;
+    njs_native_frame_t  *top, *native, *previous;
+
+    async = args[1].data.u.data;
+    cont = njs_vm_continuation(vm);
+    top = vm->top_frame;
+
+    af = async->frames;
+    frame = NULL;
+
+    for (i = 0; i < async->nframes; i++) {
+        native = njs_function_frame_alloc(vm, af[i].size);
+        if (nxt_slow_path(native == NULL)) {
+            goto failed;
+        }
+
+        chunk_size = native->size;
+        free_size = native->free_size;
+        free_start = native->free;
+        previous = native->previous;
+
+        memcpy(native, af[i].frame, af[i].size);
+
+        native->size = chunk_size;
+        native->free_size = free_size;
+        native->free = free_start;
+        native->previous = previous;
+
+        delta = (u_char *) native - (u_char *) af[i].address;
+
+        native->arguments = (njs_value_t *) ((u_char *) native->arguments
+                                             + delta);
+
+        if (native->continuation != NULL) {
+            native->continuation = (njs_continuation_t *)
+                                   ((u_char *) native->continuation + delta);
+        }
+
+        if (native->function->native) {
+            continue;
+        }
+
+        lambda_frame = (njs_frame_t *) native;
+        lambda_frame->local = (njs_value_t *) ((u_char *) lambda_frame->local
+                                               + delta);
+
+        if (i == 0) {
+            frame = lambda_frame;
+            frame->previous_active_frame = vm->active_frame;
+
+        } else {
+            lambda_frame->previous_active_frame = frame;
+        }
+    }
+
+    frame->retval = (njs_index_t) &cont->retval;
+    frame->return_address = (u_char *) njs_continuation_nexus;
+
+    cont->u.cont.function = njs_async_continuation;
+
+    vm->active_frame = frame;
+
+    vm->scopes[NJS_SCOPE_ARGUMENTS] = frame->native.arguments;
+    vm->scopes[NJS_SCOPE_LOCAL] = frame->local;
+
+    function = frame->native.function;
+    nesting = function->u.lambda->nesting;
+    mask = function->u.lambda->closures | (1 << nesting);
+
+    for (n = 0; n <= nesting; n++) {
+        vm->scopes[NJS_SCOPE_CLOSURE + n] = (mask & (1 << n))
+                                            ? &frame->closures[n]->u.values
+                                            : NULL;
+    }
+
+    if (async->nframes > 1) {
+        native = vm->top_frame;
+        function = native->function;
+
+        vm->scopes[NJS_SCOPE_CALLEE_ARGUMENTS] = native->arguments
+                                                 + function->args_offset;
+    }
+
+    nxt_mp_free(vm->mem_pool, af);
+
+    async->frames = NULL;
+    async->nframes = 0;
+
+    async->state = state;
+    async->value = *njs_arg(args, nargs, 2);
+
+    vm->current = async->await;
+
+    return NJS_APPLIED;
+
+failed:
+
+    while (vm->top_frame != top) {
+        native = vm->top_frame;
+        vm->top_frame = native->previous;
+
+        if (native->size != 0) {
+            njs_function_stack_free(vm, native);
+        }
+    }
+
+    return NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_async_continuation(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+njs_async_gc_mark(njs_gc_t *gc, const njs_value_t *value)
+{
+    uint8_t             mask;
+    nxt_int_t           ret;
+    nxt_uint_t          i, n, nesting;
+    njs_frame_t         *frame;
+    njs_value_t         *start, *end;
+    njs_async_t         *async;
+    njs_function_t      *function;
+    njs_native_frame_t  *native;
+
+    if (value->data.magic16 != NJS_ASYNC_MAGIC) {
+        return NXT_DECLINED;
+    }
+
+    async = value->data.u.data;
+
+    ret = njs_gc_mark_value(gc, &async->promise);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    ret = njs_gc_mark_value(gc, &async->value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    for (i = 0; i < async->nframes; i++) {
+        native = async->frames[i].frame;
+        function = native->function;
+
+        ret = njs_gc_push(gc, &function->object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (native->arguments_object != NULL) {
+            ret = njs_gc_push(gc, native->arguments_object);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+        /* The values are addressed in the copy. */
+
+        start = (njs_value_t *) ((u_char *) native->arguments
+                                 - (u_char *) async->frames[i].address
+                                 + (u_char *) native);
+
+        if (function->native) {
+            end = (njs_value_t *) ((u_char *) native + async->frames[i].size);
+
+        } else {
+            frame = (njs_frame_t *) native;
+            end = (njs_value_t *) ((u_char *) frame->local
+                                   - (u_char *) async->frames[i].address
+                                   + (u_char *) native);
+
+            /* The locals of the called frames are not initialized yet. */
+
+            if (i == 0) {
+                end += function->u.lambda->local_size / sizeof(njs_value_t);
+
+                nesting = function->u.lambda->nesting;
+                mask = function->u.lambda->closures | (1 << nesting);
+
+                for (n = 0; n <= nesting; n++) {
+                    if (mask & (1 << n)) {
+                        ret = njs_gc_mark_closure(gc, frame->closures[n]);
+                        if (nxt_slow_path(ret != NXT_OK)) {
+                            return ret;
+                        }
+                    }
+                }
+            }
+        }
+
+        ret = njs_gc_mark_values(gc, start, end - start);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return NXT_OK;
+}
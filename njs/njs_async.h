@@ -0,0 +1,56 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_ASYNC_H_INCLUDED_
+#define _NJS_ASYNC_H_INCLUDED_
+
+
+typedef enum {
+    NJS_ASYNC_RUNNING = 0,
+    NJS_ASYNC_FULFILLED,
+    NJS_ASYNC_REJECTED,
+} njs_async_state_t;
+
+
+/* A copy of a frame suspended by "await". */
+
+typedef struct {
+    njs_native_frame_t             *address;
+    njs_native_frame_t             *frame;
+    size_t                         size;
+} njs_async_frame_t;
+
+
+struct njs_async_s {
+    /* The promise returned by the async function. */
+    njs_value_t                    promise;
+
+    /* The handlers of the awaited promises. */
+    njs_value_t                    fulfilled;
+    njs_value_t                    rejected;
+
+    /* The settled value of the awaited promise. */
+    njs_value_t                    value;
+    njs_async_state_t              state;
+
+    /* The "await" instruction to resume the function at. */
+    u_char                         *await;
+
+    /*
+     * The function frame followed by the frames of the calls
+     * whose arguments were being evaluated.
+     */
+    njs_async_frame_t              *frames;
+    nxt_uint_t                     nframes;
+};
+
+
+njs_ret_t njs_async_frame_init(njs_vm_t *vm, njs_frame_t *frame);
+njs_ret_t njs_async_suspend(njs_vm_t *vm, njs_frame_t *frame,
+    const njs_value_t *value);
+nxt_int_t njs_async_gc_mark(njs_gc_t *gc, const njs_value_t *value);
+
+
+#endif /* _NJS_ASYNC_H_INCLUDED_ */
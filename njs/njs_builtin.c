@@ -14,6 +14,9 @@
 #include <njs_module.h>
 #include <njs_fs.h>
 #include <njs_crypto.h>
+#include <njs_promise.h>
+#include <njs_typed_array.h>
+#include <njs_map.h>
 #include <string.h>
 
 
@@ -28,7 +31,7 @@ static njs_ret_t njs_prototype_function(njs_vm_t *vm, njs_value_t *args,
 static nxt_array_t *njs_vm_expression_completions(njs_vm_t *vm,
     nxt_str_t *expression);
 static nxt_array_t *njs_object_completions(njs_vm_t *vm, njs_object_t *object);
-static nxt_int_t njs_env_hash_init(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+static nxt_int_t njs_env_hash_init(njs_vm_t *vm, nxt_flathsh_t *hash,
     char **environment);
 
 
@@ -50,6 +53,7 @@ const njs_object_init_t  *njs_object_init[] = {
 const njs_object_init_t  *njs_module_init[] = {
     &njs_fs_object_init,          /* fs                 */
     &njs_crypto_object_init,      /* crypto             */
+    &njs_timers_object_init,      /* timers             */
     NULL
 };
 
@@ -65,6 +69,22 @@ const njs_object_init_t  *njs_prototype_init[] = {
     &njs_date_prototype_init,
     &njs_hash_prototype_init,
     &njs_hmac_prototype_init,
+    &njs_promise_prototype_init,
+    &njs_array_buffer_prototype_init,
+    &njs_data_view_prototype_init,
+    &njs_int8_array_prototype_init,
+    &njs_uint8_array_prototype_init,
+    &njs_uint8_clamped_array_prototype_init,
+    &njs_int16_array_prototype_init,
+    &njs_uint16_array_prototype_init,
+    &njs_int32_array_prototype_init,
+    &njs_uint32_array_prototype_init,
+    &njs_float32_array_prototype_init,
+    &njs_float64_array_prototype_init,
+    &njs_map_prototype_init,
+    &njs_set_prototype_init,
+    &njs_weak_map_prototype_init,
+    &njs_weak_set_prototype_init,
     &njs_error_prototype_init,
     &njs_eval_error_prototype_init,
     &njs_internal_error_prototype_init,
@@ -88,6 +108,22 @@ const njs_object_init_t  *njs_constructor_init[] = {
     &njs_date_constructor_init,
     &njs_hash_constructor_init,
     &njs_hmac_constructor_init,
+    &njs_promise_constructor_init,
+    &njs_array_buffer_constructor_init,
+    &njs_data_view_constructor_init,
+    &njs_int8_array_constructor_init,
+    &njs_uint8_array_constructor_init,
+    &njs_uint8_clamped_array_constructor_init,
+    &njs_int16_array_constructor_init,
+    &njs_uint16_array_constructor_init,
+    &njs_int32_array_constructor_init,
+    &njs_uint32_array_constructor_init,
+    &njs_float32_array_constructor_init,
+    &njs_float64_array_constructor_init,
+    &njs_map_constructor_init,
+    &njs_set_constructor_init,
+    &njs_weak_map_constructor_init,
+    &njs_weak_set_constructor_init,
     &njs_error_constructor_init,
     &njs_eval_error_constructor_init,
     &njs_internal_error_constructor_init,
@@ -116,6 +152,8 @@ const njs_object_init_t  *njs_function_init[] = {
     &njs_set_timeout_function_init,
     &njs_set_immediate_function_init,
     &njs_clear_timeout_function_init,
+    &njs_set_interval_function_init,
+    &njs_clear_interval_function_init,
     NULL
 };
 
@@ -139,6 +177,9 @@ const njs_function_init_t  njs_native_functions[] = {
     { njs_set_immediate,
       { NJS_SKIP_ARG, NJS_FUNCTION_ARG } },
     { njs_clear_timeout,               { NJS_SKIP_ARG, NJS_NUMBER_ARG } },
+    { njs_set_interval,
+      { NJS_SKIP_ARG, NJS_FUNCTION_ARG, NJS_NUMBER_ARG } },
+    { njs_clear_timeout,               { NJS_SKIP_ARG, NJS_NUMBER_ARG } },
 };
 
 
@@ -155,6 +196,33 @@ const njs_function_init_t  njs_native_constructors[] = {
     { njs_hash_constructor,       { NJS_SKIP_ARG, NJS_STRING_ARG } },
     { njs_hmac_constructor,       { NJS_SKIP_ARG, NJS_STRING_ARG,
                                     NJS_STRING_ARG } },
+    { njs_promise_constructor,    { 0 } },
+    { njs_array_buffer_constructor,
+      { NJS_SKIP_ARG, NJS_NUMBER_ARG } },
+    { njs_data_view_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_int8_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_uint8_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_uint8_clamped_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_int16_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_uint16_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_int32_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_uint32_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_float32_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_float64_array_constructor,
+      { NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_NUMBER_ARG } },
+    { njs_map_constructor,        { 0 } },
+    { njs_set_constructor,        { 0 } },
+    { njs_weak_map_constructor,   { 0 } },
+    { njs_weak_set_constructor,   { 0 } },
     { njs_error_constructor,      { NJS_SKIP_ARG, NJS_STRING_ARG } },
     { njs_eval_error_constructor, { NJS_SKIP_ARG, NJS_STRING_ARG } },
     { njs_internal_error_constructor,
@@ -207,6 +275,23 @@ const njs_object_prototype_t  njs_prototype_values[] = {
     { .object_value = { .value = njs_value(NJS_DATA, 0, 0.0),
                         .object = { .type = NJS_OBJECT } } },
 
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+    { .object =       { .type = NJS_OBJECT } },
+
     { .object =       { .type = NJS_OBJECT_ERROR } },
     { .object =       { .type = NJS_OBJECT_EVAL_ERROR } },
     { .object =       { .type = NJS_OBJECT_INTERNAL_ERROR } },
@@ -222,7 +307,7 @@ extern char  **environ;
 
 
 nxt_inline nxt_int_t
-njs_object_hash_init(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_object_hash_init(njs_vm_t *vm, nxt_flathsh_t *hash,
     const njs_object_init_t *init)
 {
     return njs_object_hash_create(vm, hash, init->properties, init->items);
@@ -320,7 +405,7 @@ njs_builtin_objects_create(njs_vm_t *vm)
             lhq.key_hash = nxt_djb_hash(sandbox_key.start, sandbox_key.length);
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&module->object.shared_hash, &lhq);
+            ret = nxt_flathsh_find(&module->object.shared_hash, &lhq);
             if (nxt_fast_path(ret != NXT_OK)) {
                 continue;
             }
@@ -383,7 +468,7 @@ njs_builtin_objects_create(njs_vm_t *vm)
                                               vm->shared->empty_regexp_pattern;
 
     string_object = &shared->string_object;
-    nxt_lvlhsh_init(&string_object->hash);
+    nxt_flathsh_init(&string_object->hash);
     string_object->shared_hash = vm->shared->string_instance_hash;
     string_object->type = NJS_OBJECT_STRING;
     string_object->shared = 1;
@@ -415,6 +500,9 @@ njs_builtin_objects_create(njs_vm_t *vm)
         func++;
     }
 
+    shared->constructors[NJS_CONSTRUCTOR_PROMISE].continuation_size =
+                                     njs_continuation_size(njs_promise_cont_t);
+
     return NXT_OK;
 }
 
@@ -463,6 +551,70 @@ njs_prototype_function(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
  * Date.__proto__               -> Function_Prototype,
  * Date_Prototype.__proto__     -> Object_Prototype,
  *
+ * Promise(),
+ * Promise.__proto__            -> Function_Prototype,
+ * Promise_Prototype.__proto__  -> Object_Prototype,
+ *
+ * ArrayBuffer(),
+ * ArrayBuffer.__proto__           -> Function_Prototype,
+ * ArrayBuffer_Prototype.__proto__ -> Object_Prototype,
+ *
+ * DataView(),
+ * DataView.__proto__           -> Function_Prototype,
+ * DataView_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Int8Array(),
+ * Int8Array.__proto__           -> Function_Prototype,
+ * Int8Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Uint8Array(),
+ * Uint8Array.__proto__           -> Function_Prototype,
+ * Uint8Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Uint8ClampedArray(),
+ * Uint8ClampedArray.__proto__           -> Function_Prototype,
+ * Uint8ClampedArray_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Int16Array(),
+ * Int16Array.__proto__           -> Function_Prototype,
+ * Int16Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Uint16Array(),
+ * Uint16Array.__proto__           -> Function_Prototype,
+ * Uint16Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Int32Array(),
+ * Int32Array.__proto__           -> Function_Prototype,
+ * Int32Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Uint32Array(),
+ * Uint32Array.__proto__           -> Function_Prototype,
+ * Uint32Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Float32Array(),
+ * Float32Array.__proto__           -> Function_Prototype,
+ * Float32Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Float64Array(),
+ * Float64Array.__proto__           -> Function_Prototype,
+ * Float64Array_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Map(),
+ * Map.__proto__           -> Function_Prototype,
+ * Map_Prototype.__proto__ -> Object_Prototype,
+ *
+ * Set(),
+ * Set.__proto__           -> Function_Prototype,
+ * Set_Prototype.__proto__ -> Object_Prototype,
+ *
+ * WeakMap(),
+ * WeakMap.__proto__           -> Function_Prototype,
+ * WeakMap_Prototype.__proto__ -> Object_Prototype,
+ *
+ * WeakSet(),
+ * WeakSet.__proto__           -> Function_Prototype,
+ * WeakSet_Prototype.__proto__ -> Object_Prototype,
+ *
  * Error(),
  * Error.__proto__               -> Function_Prototype,
  * Error_Prototype.__proto__     -> Object_Prototype,
@@ -840,7 +992,7 @@ njs_vm_expression_completions(njs_vm_t *vm, nxt_str_t *expression)
         lhq.key.length = p - lhq.key.start;
         lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
 
-        ret = nxt_lvlhsh_find(&value->data.u.object->hash, &lhq);
+        ret = nxt_flathsh_find(&value->data.u.object->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
             return NULL;
         }
@@ -861,22 +1013,22 @@ njs_vm_expression_completions(njs_vm_t *vm, nxt_str_t *expression)
 static nxt_array_t *
 njs_object_completions(njs_vm_t *vm, njs_object_t *object)
 {
-    size_t             size;
-    nxt_uint_t         n, k;
-    nxt_str_t          *compl;
-    nxt_array_t        *completions;
-    njs_object_t       *o;
-    njs_object_prop_t  *prop;
-    nxt_lvlhsh_each_t  lhe;
+    size_t              size;
+    nxt_uint_t          n, k;
+    nxt_str_t           *compl;
+    nxt_array_t         *completions;
+    njs_object_t        *o;
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
 
     size = 0;
     o = object;
 
     do {
-        nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+        nxt_flathsh_each_init(&fhe);
 
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(&o->hash, &lhe);
+            prop = nxt_flathsh_each(&o->hash, &fhe);
             if (prop == NULL) {
                 break;
             }
@@ -884,10 +1036,10 @@ njs_object_completions(njs_vm_t *vm, njs_object_t *object)
             size++;
         }
 
-        nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+        nxt_flathsh_each_init(&fhe);
 
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(&o->shared_hash, &lhe);
+            prop = nxt_flathsh_each(&o->shared_hash, &fhe);
             if (prop == NULL) {
                 break;
             }
@@ -911,10 +1063,10 @@ njs_object_completions(njs_vm_t *vm, njs_object_t *object)
     compl = completions->start;
 
     do {
-        nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+        nxt_flathsh_each_init(&fhe);
 
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(&o->hash, &lhe);
+            prop = nxt_flathsh_each(&o->hash, &fhe);
             if (prop == NULL) {
                 break;
             }
@@ -932,10 +1084,10 @@ njs_object_completions(njs_vm_t *vm, njs_object_t *object)
             }
         }
 
-        nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+        nxt_flathsh_each_init(&fhe);
 
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(&o->shared_hash, &lhe);
+            prop = nxt_flathsh_each(&o->shared_hash, &fhe);
             if (prop == NULL) {
                 break;
             }
@@ -1189,21 +1341,21 @@ njs_process_object_argv(njs_vm_t *vm, njs_value_t *process,
     lhq.pool = vm->mem_pool;
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_insert(&process->data.u.object->hash, &lhq);
+    ret = nxt_flathsh_insert(&process->data.u.object->hash, &lhq);
 
     if (nxt_fast_path(ret == NXT_OK)) {
         *retval = prop->value;
         return NXT_OK;
     }
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NXT_ERROR;
 }
 
 
 static nxt_int_t
-njs_env_hash_init(njs_vm_t *vm, nxt_lvlhsh_t *hash, char **environment)
+njs_env_hash_init(njs_vm_t *vm, nxt_flathsh_t *hash, char **environment)
 {
     char                **ep;
     u_char              *val, *entry;
@@ -1247,9 +1399,9 @@ njs_env_hash_init(njs_vm_t *vm, nxt_lvlhsh_t *hash, char **environment)
         njs_string_get(&prop->name, &lhq.key);
         lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
 
-        ret = nxt_lvlhsh_insert(hash, &lhq);
+        ret = nxt_flathsh_insert(hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
     }
@@ -1292,14 +1444,14 @@ njs_process_object_env(njs_vm_t *vm, njs_value_t *process,
     lhq.key = nxt_string_value("env");
     lhq.key_hash = NJS_ENV_HASH;
 
-    ret = nxt_lvlhsh_insert(&process->data.u.object->hash, &lhq);
+    ret = nxt_flathsh_insert(&process->data.u.object->hash, &lhq);
 
     if (nxt_fast_path(ret == NXT_OK)) {
         *retval = prop->value;
         return NXT_OK;
     }
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NXT_ERROR;
 }
@@ -24,6 +24,7 @@
 #include <nxt_array.h>
 #include <nxt_queue.h>
 #include <nxt_lvlhsh.h>
+#include <nxt_flathsh.h>
 #include <nxt_random.h>
 #include <nxt_time.h>
 #include <nxt_file.h>
@@ -49,6 +50,8 @@
 #include <njs_event.h>
 #include <njs_extern.h>
 #include <njs_module.h>
+#include <njs_gc.h>
+#include <njs_jit.h>
 
 
 #endif /* _NJS_CORE_H_INCLUDED_ */
@@ -134,11 +134,12 @@ njs_crypto_object_value_alloc(njs_vm_t *vm, nxt_uint_t proto)
     ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
 
     if (nxt_fast_path(ov != NULL)) {
-        nxt_lvlhsh_init(&ov->object.hash);
-        nxt_lvlhsh_init(&ov->object.shared_hash);
+        nxt_flathsh_init(&ov->object.hash);
+        nxt_flathsh_init(&ov->object.shared_hash);
         ov->object.type = NJS_OBJECT_VALUE;
         ov->object.shared = 0;
         ov->object.extensible = 1;
+        ov->object.frozen = 0;
 
         ov->object.__proto__ = &vm->prototypes[proto].object;
         return ov;
@@ -48,6 +48,23 @@ static double njs_date_utc_time(struct tm *tm, double time);
 static const njs_value_t  njs_string_invalid_date = njs_string("Invalid Date");
 
 
+/*
+ * A date reachable from the global state of a frozen VM is shared
+ * by the clones, its time must not be changed.
+ */
+
+nxt_inline njs_ret_t
+njs_date_frozen(njs_vm_t *vm, njs_date_t *date)
+{
+    if (nxt_slow_path(date->object.frozen)) {
+        njs_type_error(vm, "Cannot modify a frozen Date");
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_noinline uint64_t
 njs_gettime(void)
 {
@@ -150,11 +167,12 @@ njs_date_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             return NXT_ERROR;
         }
 
-        nxt_lvlhsh_init(&date->object.hash);
-        nxt_lvlhsh_init(&date->object.shared_hash);
+        nxt_flathsh_init(&date->object.hash);
+        nxt_flathsh_init(&date->object.shared_hash);
         date->object.type = NJS_DATE;
         date->object.shared = 0;
         date->object.extensible = 1;
+        date->object.frozen = 0;
         date->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_DATE].object;
 
         date->time = njs_timeclip(time);
@@ -1424,6 +1442,10 @@ njs_date_prototype_set_time(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 {
     double  time;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1449,6 +1471,10 @@ njs_date_prototype_set_milliseconds(njs_vm_t *vm, njs_value_t *args,
 {
     double  time;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1475,6 +1501,10 @@ njs_date_prototype_set_seconds(njs_vm_t *vm, njs_value_t *args,
     double   time;
     int64_t  sec, ms;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1506,6 +1536,10 @@ njs_date_prototype_set_minutes(njs_vm_t *vm, njs_value_t *args,
     int64_t    ms;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1543,6 +1577,10 @@ njs_date_prototype_set_utc_minutes(njs_vm_t *vm, njs_value_t *args,
     double   time;
     int64_t  clock, min, sec, ms;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1580,6 +1618,10 @@ njs_date_prototype_set_hours(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     int64_t    ms;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1621,6 +1663,10 @@ njs_date_prototype_set_utc_hours(njs_vm_t *vm, njs_value_t *args,
     double   time;
     int64_t  clock, hour, min, sec, ms;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1658,6 +1704,10 @@ njs_date_prototype_set_date(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1690,6 +1740,10 @@ njs_date_prototype_set_utc_date(njs_vm_t *vm, njs_value_t *args,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1722,6 +1776,10 @@ njs_date_prototype_set_month(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1758,6 +1816,10 @@ njs_date_prototype_set_utc_month(njs_vm_t *vm, njs_value_t *args,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1794,6 +1856,10 @@ njs_date_prototype_set_full_year(njs_vm_t *vm, njs_value_t *args,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
@@ -1834,6 +1900,10 @@ njs_date_prototype_set_utc_full_year(njs_vm_t *vm, njs_value_t *args,
     time_t     clock;
     struct tm  tm;
 
+    if (njs_date_frozen(vm, args[0].data.u.date) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
     time = args[0].data.u.date->time;
 
     if (nxt_fast_path(!isnan(time))) {
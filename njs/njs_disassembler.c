@@ -7,7 +7,7 @@
 #include <njs_core.h>
 
 
-static void njs_disassemble(u_char *start, u_char *end);
+static nxt_uint_t njs_disassemble(u_char *start, u_char *end);
 
 
 typedef struct {
@@ -33,6 +33,10 @@ static njs_code_name_t  code_names[] = {
           nxt_string("TEMPLATE LITERAL") },
     { njs_vmcode_object_copy, sizeof(njs_vmcode_object_copy_t),
           nxt_string("OBJECT COPY     ") },
+    { njs_vmcode_array_spread, sizeof(njs_vmcode_3addr_t),
+          nxt_string("ARRAY SPREAD    ") },
+    { njs_vmcode_object_spread, sizeof(njs_vmcode_3addr_t),
+          nxt_string("OBJECT SPREAD   ") },
 
     { njs_vmcode_property_get, sizeof(njs_vmcode_prop_get_t),
           nxt_string("PROPERTY GET    ") },
@@ -130,6 +134,8 @@ static njs_code_name_t  code_names[] = {
 
     { njs_vmcode_throw, sizeof(njs_vmcode_throw_t),
           nxt_string("THROW           ") },
+    { njs_vmcode_await, sizeof(njs_vmcode_await_t),
+          nxt_string("AWAIT           ") },
 
 };
 
@@ -137,7 +143,7 @@ static njs_code_name_t  code_names[] = {
 void
 njs_disassembler(njs_vm_t *vm)
 {
-    nxt_uint_t     n;
+    nxt_uint_t     n, count;
     njs_vm_code_t  *code;
 
     code = vm->code->start;
@@ -145,19 +151,23 @@ njs_disassembler(njs_vm_t *vm)
 
     while (n != 0) {
         nxt_printf("%V:%V\n", &code->file, &code->name);
-        njs_disassemble(code->start, code->end);
+        count = njs_disassemble(code->start, code->end);
+
+        nxt_printf("%ui instructions, %uz bytes, %uz local values\n",
+                   count, (size_t) (code->end - code->start),
+                   code->scope_size / sizeof(njs_value_t));
         code++;
         n--;
     }
 }
 
 
-static void
+static nxt_uint_t
 njs_disassemble(u_char *start, u_char *end)
 {
     u_char                       *p;
     nxt_str_t                    *name;
-    nxt_uint_t                   n;
+    nxt_uint_t                   n, count;
     const char                   *sign;
     njs_code_name_t              *code_name;
     njs_vmcode_jump_t            *jump;
@@ -177,10 +187,12 @@ njs_disassemble(u_char *start, u_char *end)
     njs_vmcode_equal_jump_t      *equal;
     njs_vmcode_prop_foreach_t    *prop_foreach;
     njs_vmcode_method_frame_t    *method;
+    njs_vmcode_spread_frame_t    *spread;
     njs_vmcode_try_trampoline_t  *try_tramp;
     njs_vmcode_function_frame_t  *function;
 
     p = start;
+    count = 0;
 
     /*
      * On some 32-bit platform uintptr_t is int and compilers warn
@@ -190,6 +202,7 @@ njs_disassemble(u_char *start, u_char *end)
 
     while (p < end) {
         operation = *(njs_vmcode_operation_t *) p;
+        count++;
 
         if (operation == njs_vmcode_array) {
             array = (njs_vmcode_array_t *) p;
@@ -301,6 +314,18 @@ njs_disassemble(u_char *start, u_char *end)
             continue;
         }
 
+        if (operation == njs_vmcode_spread_frame) {
+            spread = (njs_vmcode_spread_frame_t *) p;
+
+            nxt_printf("%05uz SPREAD FRAME      %04Xz %04Xz %04Xz %uz%s\n",
+                       p - start, (size_t) spread->function,
+                       (size_t) spread->object, (size_t) spread->array,
+                       spread->nargs, spread->code.ctor ? " CTOR" : "");
+
+            p += sizeof(njs_vmcode_spread_frame_t);
+            continue;
+        }
+
         if (operation == njs_vmcode_property_foreach) {
             prop_foreach = (njs_vmcode_prop_foreach_t *) p;
 
@@ -313,6 +338,18 @@ njs_disassemble(u_char *start, u_char *end)
             continue;
         }
 
+        if (operation == njs_vmcode_value_foreach) {
+            prop_foreach = (njs_vmcode_prop_foreach_t *) p;
+
+            nxt_printf("%05uz VALUE FOREACH     %04Xz %04Xz +%uz\n",
+                       p - start, (size_t) prop_foreach->next,
+                       (size_t) prop_foreach->object,
+                       (size_t) prop_foreach->offset);
+
+            p += sizeof(njs_vmcode_prop_foreach_t);
+            continue;
+        }
+
         if (operation == njs_vmcode_property_next) {
             prop_next = (njs_vmcode_prop_next_t *) p;
 
@@ -326,6 +363,19 @@ njs_disassemble(u_char *start, u_char *end)
             continue;
         }
 
+        if (operation == njs_vmcode_value_next) {
+            prop_next = (njs_vmcode_prop_next_t *) p;
+
+            nxt_printf("%05uz VALUE NEXT        %04Xz %04Xz %04Xz %uz\n",
+                       p - start, (size_t) prop_next->retval,
+                       (size_t) prop_next->object, (size_t) prop_next->next,
+                       (size_t) prop_next->offset);
+
+            p += sizeof(njs_vmcode_prop_next_t);
+
+            continue;
+        }
+
         if (operation == njs_vmcode_try_start) {
             try_start = (njs_vmcode_try_start_t *) p;
 
@@ -470,4 +520,6 @@ njs_disassemble(u_char *start, u_char *end)
 
         continue;
     }
+
+    return count;
 }
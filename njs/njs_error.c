@@ -69,11 +69,12 @@ njs_error_alloc(njs_vm_t *vm, njs_value_type_t type, const njs_value_t *name,
         goto memory_error;
     }
 
-    nxt_lvlhsh_init(&error->hash);
-    nxt_lvlhsh_init(&error->shared_hash);
+    nxt_flathsh_init(&error->hash);
+    nxt_flathsh_init(&error->shared_hash);
     error->type = type;
     error->shared = 0;
     error->extensible = 1;
+    error->frozen = 0;
     error->__proto__ = &vm->prototypes[njs_error_prototype_index(type)].object;
 
     lhq.replace = 0;
@@ -91,9 +92,9 @@ njs_error_alloc(njs_vm_t *vm, njs_value_type_t type, const njs_value_t *name,
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&error->hash, &lhq);
+        ret = nxt_flathsh_insert(&error->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NULL;
         }
     }
@@ -112,9 +113,9 @@ njs_error_alloc(njs_vm_t *vm, njs_value_type_t type, const njs_value_t *name,
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&error->hash, &lhq);
+        ret = nxt_flathsh_insert(&error->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NULL;
         }
     }
@@ -501,8 +502,8 @@ njs_memory_error_set(njs_vm_t *vm, njs_value_t *value)
     prototypes = vm->prototypes;
     object = &vm->memory_error_object;
 
-    nxt_lvlhsh_init(&object->hash);
-    nxt_lvlhsh_init(&object->shared_hash);
+    nxt_flathsh_init(&object->hash);
+    nxt_flathsh_init(&object->shared_hash);
     object->__proto__ = &prototypes[NJS_PROTOTYPE_INTERNAL_ERROR].object;
     object->type = NJS_OBJECT_INTERNAL_ERROR;
     object->shared = 1;
@@ -527,6 +528,24 @@ njs_memory_error(njs_vm_t *vm)
 }
 
 
+/*
+ * nxt_lvlhsh_insert() and nxt_flathsh_insert() fail with NXT_ERROR if
+ * the memory cannot be allocated and with NXT_DECLINED if the key already
+ * exists.
+ */
+
+void
+njs_lvlhsh_insert_error(njs_vm_t *vm, nxt_int_t ret)
+{
+    if (ret == NXT_ERROR) {
+        njs_memory_error(vm);
+        return;
+    }
+
+    njs_internal_error(vm, "lvlhsh insert failed");
+}
+
+
 njs_ret_t
 njs_memory_error_constructor(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused)
@@ -39,6 +39,7 @@ void njs_error_fmt_new(njs_vm_t *vm, njs_value_t *dst, njs_value_type_t type,
 
 void njs_memory_error(njs_vm_t *vm);
 void njs_memory_error_set(njs_vm_t *vm, njs_value_t *value);
+void njs_lvlhsh_insert_error(njs_vm_t *vm, nxt_int_t ret);
 
 njs_object_t *njs_error_alloc(njs_vm_t *vm, njs_value_type_t type,
     const njs_value_t *name, const njs_value_t *message);
@@ -69,6 +69,31 @@ njs_add_event(njs_vm_t *vm, njs_event_t *event)
 }
 
 
+/*
+ * Schedules the next run of an interval event.  It is done before
+ * the event function is called, so clearInterval() called from the
+ * function cancels the next run.
+ */
+
+nxt_int_t
+njs_rearm_event(njs_vm_t *vm, njs_event_t *ev)
+{
+    njs_vm_ops_t  *ops;
+
+    njs_del_event(vm, ev, NJS_EVENT_RELEASE);
+
+    ops = vm->options.ops;
+
+    ev->host_event = ops->set_timer(vm->external, ev->delay, ev);
+    if (nxt_slow_path(ev->host_event == NULL)) {
+        njs_internal_error(vm, "set_timer() failed");
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
 void
 njs_del_event(njs_vm_t *vm, njs_event_t *ev, nxt_uint_t action)
 {
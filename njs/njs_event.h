@@ -27,13 +27,18 @@ typedef struct {
     njs_value_t             id;
     nxt_queue_link_t        link;
 
+    /* The period of setInterval() events. */
+    uint64_t                delay;
+
     unsigned                posted:1;
     unsigned                once:1;
+    unsigned                interval:1;
 } njs_event_t;
 
 
 nxt_int_t njs_add_event(njs_vm_t *vm, njs_event_t *event);
 void njs_del_event(njs_vm_t *vm, njs_event_t *event, nxt_uint_t action);
+nxt_int_t njs_rearm_event(njs_vm_t *vm, njs_event_t *event);
 
 
 extern const nxt_lvlhsh_proto_t  njs_event_hash_proto;
@@ -103,7 +103,7 @@ njs_vm_external_add(njs_vm_t *vm, nxt_lvlhsh_t *hash, njs_external_t *external,
 
             /*
              * nxt_mp_zalloc() does also:
-             *   nxt_lvlhsh_init(&function->object.hash);
+             *   nxt_flathsh_init(&function->object.hash);
              *   function->object.__proto__ = NULL;
              *   function->ctor = 0;
              */
@@ -143,7 +143,7 @@ njs_vm_external_add(njs_vm_t *vm, nxt_lvlhsh_t *hash, njs_external_t *external,
 
             ret = nxt_lvlhsh_insert(hash, &lhq);
             if (nxt_slow_path(ret != NXT_OK)) {
-                njs_internal_error(vm, "lvlhsh insert failed");
+                njs_lvlhsh_insert_error(vm, ret);
                 return NULL;
             }
         }
@@ -228,7 +228,7 @@ njs_vm_external_bind(njs_vm_t *vm, const nxt_str_t *var_name,
 
     ret = nxt_lvlhsh_insert(&vm->externals_hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return ret;
     }
 
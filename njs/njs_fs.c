@@ -6,6 +6,7 @@
 
 #include <njs_core.h>
 #include <njs_fs.h>
+#include <njs_promise.h>
 #include <string.h>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -46,6 +47,15 @@ static njs_ret_t njs_fs_write_file_sync_internal(njs_vm_t *vm,
     njs_value_t *args, nxt_uint_t nargs, int default_flags);
 static njs_ret_t njs_fs_done(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_fs_promise_read_file(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_fs_promise_append_file(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_fs_promise_write_file(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_fs_promise(njs_vm_t *vm, njs_ret_t ret);
+static njs_ret_t njs_fs_promises(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval);
 
 static njs_ret_t njs_fs_error(njs_vm_t *vm, const char *syscall,
     const char *description, njs_value_t *path, int errn, njs_value_t *retval);
@@ -120,7 +130,7 @@ njs_fs_read_file(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             lhq.key = nxt_string_value("flag");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[2].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[2].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &flag);
@@ -130,7 +140,7 @@ njs_fs_read_file(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             lhq.key = nxt_string_value("encoding");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[2].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[2].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &encoding);
@@ -339,7 +349,7 @@ njs_fs_read_file_sync(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             lhq.key = nxt_string_value("flag");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[2].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[2].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &flag);
@@ -349,7 +359,7 @@ njs_fs_read_file_sync(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             lhq.key = nxt_string_value("encoding");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[2].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[2].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &encoding);
@@ -573,7 +583,7 @@ static njs_ret_t njs_fs_write_file_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("flag");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &flag);
@@ -583,7 +593,7 @@ static njs_ret_t njs_fs_write_file_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("encoding");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &encoding);
@@ -593,7 +603,7 @@ static njs_ret_t njs_fs_write_file_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("mode");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 mode = &prop->value;
@@ -760,7 +770,7 @@ njs_fs_write_file_sync_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("flag");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &flag);
@@ -770,7 +780,7 @@ njs_fs_write_file_sync_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("encoding");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 njs_string_get(&prop->value, &encoding);
@@ -780,7 +790,7 @@ njs_fs_write_file_sync_internal(njs_vm_t *vm, njs_value_t *args,
             lhq.key = nxt_string_value("mode");
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&args[3].data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&args[3].data.u.object->hash, &lhq);
             if (ret == NXT_OK) {
                 prop = lhq.value;
                 mode = &prop->value;
@@ -889,6 +899,104 @@ static njs_ret_t njs_fs_done(njs_vm_t *vm, njs_value_t *args,
 }
 
 
+static njs_ret_t
+njs_fs_promise_read_file(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_fs_promise(vm, njs_fs_read_file_sync(vm, args, nargs, unused));
+}
+
+
+static njs_ret_t
+njs_fs_promise_append_file(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_fs_promise(vm,
+                          njs_fs_write_file_sync_internal(vm, args, nargs,
+                                              O_APPEND | O_CREAT | O_WRONLY));
+}
+
+
+static njs_ret_t
+njs_fs_promise_write_file(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_fs_promise(vm,
+                          njs_fs_write_file_sync_internal(vm, args, nargs,
+                                              O_TRUNC | O_CREAT | O_WRONLY));
+}
+
+
+/*
+ * The file operations are synchronous, their result or exception
+ * is delivered through an already settled promise.
+ */
+
+static njs_ret_t
+njs_fs_promise(njs_vm_t *vm, njs_ret_t ret)
+{
+    njs_value_t  value;
+
+    value = vm->retval;
+
+    return njs_promise_settled(vm, &vm->retval, &value, ret != NJS_OK);
+}
+
+
+static const njs_object_prop_t  njs_fs_promises_properties[] =
+{
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("readFile"),
+        .value = njs_native_function(njs_fs_promise_read_file, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("appendFile"),
+        .value = njs_native_function(njs_fs_promise_append_file, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("writeFile"),
+        .value = njs_native_function(njs_fs_promise_write_file, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+static njs_ret_t
+njs_fs_promises(njs_vm_t *vm, njs_value_t *value, njs_value_t *setval,
+    njs_value_t *retval)
+{
+    nxt_int_t     ret;
+    njs_object_t  *object;
+
+    object = njs_object_alloc(vm);
+    if (nxt_slow_path(object == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = njs_object_hash_create(vm, &object->hash, njs_fs_promises_properties,
+                                 nxt_nitems(njs_fs_promises_properties));
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    retval->data.u.object = object;
+    retval->type = NJS_OBJECT;
+    retval->data.truth = 1;
+
+    return NXT_OK;
+}
+
+
 static njs_ret_t njs_fs_error(njs_vm_t *vm, const char *syscall,
     const char *description, njs_value_t *path, int errn, njs_value_t *retval)
 {
@@ -930,9 +1038,9 @@ static njs_ret_t njs_fs_error(njs_vm_t *vm, const char *syscall,
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&error->hash, &lhq);
+        ret = nxt_flathsh_insert(&error->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NJS_ERROR;
         }
     }
@@ -949,9 +1057,9 @@ static njs_ret_t njs_fs_error(njs_vm_t *vm, const char *syscall,
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&error->hash, &lhq);
+        ret = nxt_flathsh_insert(&error->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NJS_ERROR;
         }
     }
@@ -974,9 +1082,9 @@ static njs_ret_t njs_fs_error(njs_vm_t *vm, const char *syscall,
 
         lhq.value = prop;
 
-        ret = nxt_lvlhsh_insert(&error->hash, &lhq);
+        ret = nxt_flathsh_insert(&error->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NJS_ERROR;
         }
     }
@@ -1090,6 +1198,12 @@ static const njs_object_prop_t  njs_fs_object_properties[] =
         .configurable = 1,
     },
 
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("promises"),
+        .value = njs_prop_handler(njs_fs_promises),
+    },
+
 };
 
 
@@ -5,12 +5,12 @@
  */
 
 #include <njs_core.h>
+#include <njs_async.h>
 #include <string.h>
 
 
 static njs_function_t *njs_function_copy(njs_vm_t *vm,
     njs_function_t *function);
-static njs_native_frame_t *njs_function_frame_alloc(njs_vm_t *vm, size_t size);
 static njs_ret_t njs_normalize_args(njs_vm_t *vm, njs_value_t *args,
     uint8_t *args_types, nxt_uint_t nargs);
 
@@ -23,7 +23,8 @@ njs_function_alloc(njs_vm_t *vm, njs_function_lambda_t *lambda,
     nxt_uint_t      n, nesting;
     njs_function_t  *function;
 
-    nesting = lambda->nesting;
+    /* A function which captures no outer values needs no closures. */
+    nesting = (lambda->closures != 0) ? lambda->nesting : 0;
     size = sizeof(njs_function_t) + nesting * sizeof(njs_closure_t *);
 
     function = nxt_mp_zalloc(vm->mem_pool, size);
@@ -33,11 +34,11 @@ njs_function_alloc(njs_vm_t *vm, njs_function_lambda_t *lambda,
 
     /*
      * nxt_mp_zalloc() does also:
-     *   nxt_lvlhsh_init(&function->object.hash);
+     *   nxt_flathsh_init(&function->object.hash);
      *   function->object.__proto__ = NULL;
      */
 
-    function->ctor = !lambda->arrow;
+    function->ctor = !lambda->arrow && !lambda->async;
     function->args_offset = 1;
     function->u.lambda = lambda;
 
@@ -59,8 +60,11 @@ njs_function_alloc(njs_vm_t *vm, njs_function_lambda_t *lambda,
         n = 0;
 
         do {
-            /* GC: retain closure. */
-            function->closures[n] = closures[n];
+            if (lambda->closures & (1 << n)) {
+                /* GC: retain closure. */
+                function->closures[n] = closures[n];
+            }
+
             n++;
         } while (n < nesting);
     }
@@ -114,7 +118,11 @@ njs_function_copy(njs_vm_t *vm, njs_function_t *function)
     njs_closure_t   **closures;
     njs_function_t  *copy;
 
-    nesting = (function->native) ? 0 : function->u.lambda->nesting;
+    nesting = 0;
+
+    if (!function->native && function->u.lambda->closures != 0) {
+        nesting = function->u.lambda->nesting;
+    }
 
     size = sizeof(njs_function_t) + nesting * sizeof(njs_closure_t *);
 
@@ -138,8 +146,14 @@ njs_function_copy(njs_vm_t *vm, njs_function_t *function)
     n = 0;
 
     do {
-        /* GC: retain closure. */
-        copy->closures[n] = closures[n];
+        if (function->u.lambda->closures & (1 << n)) {
+            /* GC: retain closure. */
+            copy->closures[n] = closures[n];
+
+        } else {
+            copy->closures[n] = NULL;
+        }
+
         n++;
     } while (n < nesting);
 
@@ -188,9 +202,9 @@ njs_function_arguments_object_init(njs_vm_t *vm, njs_native_frame_t *frame)
     lhq.pool = vm->mem_pool;
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_insert(&arguments->hash, &lhq);
+    ret = nxt_flathsh_insert(&arguments->hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
@@ -206,9 +220,9 @@ njs_function_arguments_object_init(njs_vm_t *vm, njs_native_frame_t *frame)
         njs_string_get(&prop->name, &lhq.key);
         lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
 
-        ret = nxt_lvlhsh_insert(&arguments->hash, &lhq);
+        ret = nxt_flathsh_insert(&arguments->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
     }
@@ -353,6 +367,7 @@ njs_function_lambda_frame(njs_vm_t *vm, njs_function_t *function,
     nxt_bool_t ctor)
 {
     size_t                 size;
+    nxt_int_t              ret;
     nxt_uint_t             n, max_args, closures;
     njs_value_t            *value, *bound;
     njs_frame_t            *frame;
@@ -361,9 +376,21 @@ njs_function_lambda_frame(njs_vm_t *vm, njs_function_t *function,
 
     lambda = function->u.lambda;
 
+    if (nxt_slow_path(lambda->start == NULL)) {
+        ret = njs_generate_lambda(vm, lambda);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
     max_args = nxt_max(nargs, lambda->nargs);
 
-    closures = lambda->nesting + lambda->block_closures;
+    /*
+     * The function closure slot is allocated even if the function
+     * has no closure values, because nested functions copy it.
+     */
+
+    closures = lambda->nesting + 1;
 
     size = njs_frame_size(closures)
            + (function->args_offset + max_args) * sizeof(njs_value_t)
@@ -443,18 +470,33 @@ njs_function_frame_alloc(njs_vm_t *vm, size_t size)
         chunk_size = 0;
 
     } else {
-        spare_size = size + NJS_FRAME_SPARE_SIZE;
-        spare_size = nxt_align_size(spare_size, NJS_FRAME_SPARE_SIZE);
+        frame = vm->spare_stack;
+
+        if (frame != NULL && size <= frame->size) {
+            spare_size = frame->size;
+
+        } else {
+            frame = NULL;
+            spare_size = size + NJS_FRAME_SPARE_SIZE;
+            spare_size = nxt_align_size(spare_size, NJS_FRAME_SPARE_SIZE);
+        }
 
         if (vm->stack_size + spare_size > NJS_MAX_STACK_SIZE) {
             njs_range_error(vm, "Maximum call stack size exceeded");
             return NULL;
         }
 
-        frame = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t), spare_size);
-        if (nxt_slow_path(frame == NULL)) {
-            njs_memory_error(vm);
-            return NULL;
+        if (frame != NULL) {
+            vm->spare_stack = frame->previous;
+            vm->spare_stack_n--;
+
+        } else {
+            frame = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                                 spare_size);
+            if (nxt_slow_path(frame == NULL)) {
+                njs_memory_error(vm);
+                return NULL;
+            }
         }
 
         chunk_size = spare_size;
@@ -479,6 +521,7 @@ njs_function_lambda_call(njs_vm_t *vm, njs_index_t retval,
     u_char *return_address)
 {
     size_t                 size;
+    uint8_t                mask;
     njs_ret_t              ret;
     nxt_uint_t             n, nesting;
     njs_frame_t            *frame;
@@ -509,25 +552,35 @@ njs_function_lambda_call(njs_vm_t *vm, njs_index_t retval,
 
     memcpy(frame->local, lambda->local_scope, lambda->local_size);
 
-    /* Parent closures values. */
+    /*
+     * Parent closures values.  Only the levels referenced by the function
+     * and its nested functions are set, the other slots are not used.
+     */
 
-    n = 0;
     nesting = lambda->nesting;
+    mask = lambda->closures;
 
-    if (nesting != 0) {
+    if (mask != 0) {
         closures = njs_function_closures(vm, function);
-        do {
-            closure = *closures++;
 
-            frame->closures[n] = closure;
-            vm->scopes[NJS_SCOPE_CLOSURE + n] = &closure->u.values;
+        for (n = 0; n < nesting; n++) {
+            if (mask & (1 << n)) {
+                closure = closures[n];
 
-            n++;
-        } while (n < nesting);
+                frame->closures[n] = closure;
+                vm->scopes[NJS_SCOPE_CLOSURE + n] = &closure->u.values;
+
+            } else {
+                frame->closures[n] = NULL;
+            }
+        }
     }
 
     /* Function closure values. */
 
+    n = nesting;
+    frame->closures[n] = NULL;
+
     if (lambda->block_closures > 0) {
         closure = NULL;
 
@@ -541,7 +594,7 @@ njs_function_lambda_call(njs_vm_t *vm, njs_index_t retval,
             }
 
             size -= sizeof(njs_value_t);
-            closure->u.count = 0;
+            closure->u.count = size / sizeof(njs_value_t);
             dst = closure->values;
 
             src = lambda->closure_scope;
@@ -563,6 +616,13 @@ njs_function_lambda_call(njs_vm_t *vm, njs_index_t retval,
         }
     }
 
+    if (nxt_slow_path(lambda->async)) {
+        ret = njs_async_frame_init(vm, frame);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
     vm->active_frame = frame;
 
     return NJS_APPLIED;
@@ -783,8 +843,7 @@ njs_function_frame_free(njs_vm_t *vm, njs_native_frame_t *frame)
         /* GC: free frame->local, etc. */
 
         if (frame->size != 0) {
-            vm->stack_size -= frame->size;
-            nxt_mp_free(vm->mem_pool, frame);
+            njs_function_stack_free(vm, frame);
         }
 
         frame = previous;
@@ -793,6 +852,150 @@ njs_function_frame_free(njs_vm_t *vm, njs_native_frame_t *frame)
 }
 
 
+void
+njs_function_stack_free(njs_vm_t *vm, njs_native_frame_t *frame)
+{
+    vm->stack_size -= frame->size;
+
+    /*
+     * A recursion allocates and frees stack chunks each time the stack
+     * crosses a chunk boundary, so a few chunks of moderate size are kept
+     * for reuse.  The chunks left after a deep recursion or allocated for
+     * large frames are freed.
+     */
+
+    if (vm->spare_stack_n == NJS_SPARE_STACK_MAX
+        || frame->size > NJS_SPARE_STACK_CHUNK_MAX)
+    {
+        nxt_mp_free(vm->mem_pool, frame);
+        return;
+    }
+
+    frame->previous = vm->spare_stack;
+    vm->spare_stack = frame;
+    vm->spare_stack_n++;
+}
+
+
+/*
+ * Only user-defined functions can be called in a native loop.  Native
+ * and bound functions and too deeply nested loops are called through
+ * continuations, loop->function is set to NULL for them.
+ */
+
+void
+njs_function_loop_init(njs_vm_t *vm, njs_function_loop_t *loop,
+    njs_function_t *function)
+{
+    loop->frame = NULL;
+    loop->nargs = 0;
+
+    if (function->native
+        || function->bound != NULL
+        || vm->running >= NJS_MAX_LOOP_NESTING)
+    {
+        loop->function = NULL;
+        return;
+    }
+
+    loop->function = function;
+}
+
+
+/*
+ * njs_function_loop_call() calls the function with args[0] as "this"
+ * and returns NXT_OK after the function has returned or NXT_ERROR if
+ * an exception has not been caught in the function.  The method frame
+ * stops the exception unwinding, so the method returns the error to the
+ * interpreter which continues the unwinding from the method frame.
+ */
+
+njs_ret_t
+njs_function_loop_call(njs_vm_t *vm, njs_function_loop_t *loop,
+    const njs_value_t *args, nxt_uint_t nargs, njs_value_t *retval)
+{
+    u_char                 *current;
+    njs_ret_t              ret;
+    nxt_uint_t             n;
+    njs_value_t            *value;
+    njs_frame_t            *frame;
+    njs_native_frame_t     *native, *previous;
+    njs_function_lambda_t  *lambda;
+
+    previous = vm->top_frame;
+    frame = loop->frame;
+
+    if (frame != NULL
+        && frame->native.size == 0
+        && frame->native.previous == previous
+        && loop->nargs == nargs)
+    {
+        /*
+         * The frame has been allocated in the method frame spare space
+         * which is not used between the calls, so the frame is intact
+         * except the values the function could change.
+         */
+
+        native = &frame->native;
+
+        native->arguments_object = NULL;
+        native->exception.next = NULL;
+        native->exception.catch = NULL;
+        native->trap_tries = 0;
+
+        value = native->arguments;
+        *value++ = args[0];
+
+        vm->scopes[NJS_SCOPE_CALLEE_ARGUMENTS] = value;
+
+        memcpy(value, &args[1], nargs * sizeof(njs_value_t));
+        value += nargs;
+
+        lambda = loop->function->u.lambda;
+
+        for (n = nargs; n < lambda->nargs; n++) {
+            *value++ = njs_value_undefined;
+        }
+
+        frame->previous_active_frame = vm->active_frame;
+        vm->top_frame = native;
+
+    } else {
+        ret = njs_function_lambda_frame(vm, loop->function, &args[0],
+                                        &args[1], nargs, 0);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        loop->frame = (njs_frame_t *) vm->top_frame;
+        loop->nargs = nargs;
+    }
+
+    current = vm->current;
+
+    /* The function returns to njs_vmcode_stop(). */
+
+    ret = njs_function_lambda_call(vm, (njs_index_t) retval,
+                                   (u_char *) &njs_continuation_nexus[1]);
+
+    if (nxt_fast_path(ret == NJS_APPLIED)) {
+        previous->barrier = 1;
+
+        ret = njs_vmcode_interpreter(vm);
+
+        previous->barrier = 0;
+
+        if (ret == NJS_STOP) {
+            ret = NXT_OK;
+        }
+    }
+
+    vm->current = current;
+
+    return ret;
+}
+
+
 /*
  * The "prototype" property of user defined functions is created on
  * demand in private hash of the functions by the "prototype" getter.
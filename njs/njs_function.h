@@ -24,20 +24,45 @@ struct njs_function_lambda_s {
     uint32_t                       local_size;
     uint32_t                       closure_size;
 
+    /* The frame size of a call with exactly nargs arguments. */
+    uint32_t                       frame_size;
+
     /* Function nesting level. */
     uint8_t                        nesting;           /* 4 bits */
 
     /* Function internal block closures levels. */
     uint8_t                        block_closures;    /* 4 bits */
 
+    /*
+     * The outer closure levels referenced by the function and its nested
+     * functions, a bit mask.  Only these closures are copied to the
+     * function and its frames.
+     */
+    uint8_t                        closures;          /* 5 bits */
+
     uint8_t                        arrow;             /* 1 bit */
     uint8_t                        rest_parameters;   /* 1 bit */
+    uint8_t                        async;             /* 1 bit */
 
     /* Initial values of local scope. */
     njs_value_t                    *local_scope;
     njs_value_t                    *closure_scope;
 
     u_char                         *start;
+    u_char                         *end;
+
+#if (NXT_HAVE_JIT)
+    /* The number of calls and loop iterations until the compilation. */
+    uint32_t                       jit_counter;
+    njs_jit_code_t                 *jit;
+#endif
+
+    /* The function node and name until the bytecode is generated. */
+    njs_parser_node_t              *node;
+    const nxt_str_t                *name;
+
+    /* The function body source until the body is parsed. */
+    njs_parser_source_t            *source;
 };
 
 
@@ -56,6 +81,16 @@ struct njs_function_lambda_s {
 
 #define NJS_FRAME_SPARE_SIZE       512
 
+/* The freed stack chunks kept for reuse and the largest size kept. */
+#define NJS_SPARE_STACK_MAX        16
+#define NJS_SPARE_STACK_CHUNK_MAX  (4 * NJS_FRAME_SPARE_SIZE)
+
+/*
+ * The maximum nesting of interpreter runs by native loops, it limits
+ * the C stack used by recursive calls of the loops.
+ */
+#define NJS_MAX_LOOP_NESTING       32
+
 
 typedef struct {
     njs_function_native_t          function;
@@ -74,6 +109,19 @@ typedef struct {
 #define NJS_CONTINUATION_SIZE      njs_continuation_size(njs_continuation_t)
 
 
+/*
+ * A native method calls a user-defined function repeatedly in a nested
+ * interpreter run instead of returning to the interpreter through
+ * a continuation.  The function frame is built once on top of the method
+ * frame and then only its arguments are updated for each call.
+ */
+typedef struct {
+    njs_function_t                 *function;
+    njs_frame_t                    *frame;
+    nxt_uint_t                     nargs;
+} njs_function_loop_t;
+
+
 #define njs_vm_trap_value(vm, val)                                            \
     (vm)->top_frame->trap_scratch.data.u.value = val
 
@@ -126,6 +174,12 @@ struct njs_native_frame_s {
      * it is used to increment or decrement this value.
      */
     uint8_t                        trap_reference;   /* 1 bit */
+
+    /* The exception unwinding of a nested interpreter run stops here. */
+    uint8_t                        barrier;          /* 1 bit */
+
+    /* The frame of an async function, it has the async context. */
+    uint8_t                        async;            /* 1 bit */
 };
 
 
@@ -137,6 +191,8 @@ struct njs_frame_s {
     u_char                         *return_address;
     njs_frame_t                    *previous_active_frame;
 
+    njs_async_t                    *async;
+
     njs_value_t                    *local;
 #if (NXT_SUNC)
     njs_closure_t                  *closures[1];
@@ -165,6 +221,7 @@ njs_ret_t njs_function_native_frame(njs_vm_t *vm, njs_function_t *function,
 njs_ret_t njs_function_lambda_frame(njs_vm_t *vm, njs_function_t *function,
     const njs_value_t *this, const njs_value_t *args, nxt_uint_t nargs,
     nxt_bool_t ctor);
+njs_native_frame_t *njs_function_frame_alloc(njs_vm_t *vm, size_t size);
 njs_ret_t njs_function_activate(njs_vm_t *vm, njs_function_t *function,
     const njs_value_t *this, const njs_value_t *args, nxt_uint_t nargs,
     njs_index_t retval, size_t advance);
@@ -174,6 +231,11 @@ njs_ret_t njs_function_native_call(njs_vm_t *vm, njs_function_native_t native,
     njs_value_t *args, uint8_t *args_types, nxt_uint_t nargs,
     njs_index_t retval, u_char *return_address);
 void njs_function_frame_free(njs_vm_t *vm, njs_native_frame_t *frame);
+void njs_function_stack_free(njs_vm_t *vm, njs_native_frame_t *frame);
+void njs_function_loop_init(njs_vm_t *vm, njs_function_loop_t *loop,
+    njs_function_t *function);
+njs_ret_t njs_function_loop_call(njs_vm_t *vm, njs_function_loop_t *loop,
+    const njs_value_t *args, nxt_uint_t nargs, njs_value_t *retval);
 
 
 nxt_inline njs_ret_t
@@ -0,0 +1,730 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <njs_promise.h>
+#include <njs_typed_array.h>
+#include <njs_map.h>
+#include <njs_async.h>
+#include <string.h>
+
+
+/*
+ * A mark and sweep collector of the long strings, plain objects and arrays
+ * allocated by the VM clones created with the "gc" option.  They are the
+ * bulk of the garbage of the long-lived VMs which process data chunk by
+ * chunk.
+ *
+ * The collection is run between njs_vm_run() events when no frame is
+ * active, so the roots are the global scope, the builtin objects, the
+ * retval, and the pending events.  The collection is not incremental,
+ * its pause is proportional to the size of the reachable data.
+ *
+ * The tracked items are preceded by njs_gc_item_t which links them into
+ * the vm->gc_items list.  They are also added to vm->gc_hash to tell them
+ * from the values of the parent VM, the compiled code and the static
+ * values which are never reclaimed.  The other objects, such as functions,
+ * closures, regexps, dates, errors and the primitive value wrappers, are
+ * traced but stay in the pool until the VM is destroyed.
+ */
+
+typedef struct {
+    nxt_queue_link_t  link;
+    uint32_t          size;
+    njs_value_type_t  type:8;    /* NJS_STRING, NJS_OBJECT or NJS_ARRAY */
+    uint8_t           mark;      /* 1 bit */
+} njs_gc_item_t;
+
+
+struct njs_gc_s {
+    njs_vm_t          *vm;
+    nxt_mp_t          *pool;
+
+    /* The objects and closures already marked. */
+    nxt_lvlhsh_t      marked;
+
+    /* The objects to trace, of njs_object_t *. */
+    nxt_array_t       *stack;
+};
+
+
+/* The objects and arrays contain values which require the alignment. */
+
+#define NJS_GC_ITEM_SIZE                                                      \
+    nxt_align_size(sizeof(njs_gc_item_t), sizeof(njs_value_t))
+
+#define njs_gc_item_data(item)                                                \
+    ((void *) ((u_char *) (item) + NJS_GC_ITEM_SIZE))
+
+#define njs_gc_item(p)                                                        \
+    ((njs_gc_item_t *) ((u_char *) (p) - NJS_GC_ITEM_SIZE))
+
+
+static nxt_int_t njs_gc_mark_roots(njs_gc_t *gc);
+static nxt_int_t njs_gc_mark_event(njs_gc_t *gc, njs_event_t *event);
+static nxt_int_t njs_gc_mark_object(njs_gc_t *gc, njs_object_t *object);
+static nxt_int_t njs_gc_mark_function(njs_gc_t *gc, njs_function_t *function);
+static nxt_int_t njs_gc_marked(njs_gc_t *gc, void *p);
+static void njs_gc_mark_item(njs_gc_t *gc, void *p);
+static size_t njs_gc_sweep(njs_vm_t *vm, nxt_bool_t reclaim);
+static void njs_gc_free(njs_vm_t *vm, njs_gc_item_t *item);
+static void njs_gc_free_object(njs_vm_t *vm, njs_object_t *object);
+static nxt_int_t njs_gc_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
+
+
+static const nxt_lvlhsh_proto_t  njs_gc_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    0,
+    njs_gc_hash_test,
+    njs_lvlhsh_alloc,
+    njs_lvlhsh_free,
+};
+
+
+/* The hashes are keyed by the pointers to the tracked items. */
+
+#define njs_gc_query_init(lhq, p)                                             \
+    do {                                                                      \
+        (lhq)->key.start = (u_char *) (p);                                    \
+        (lhq)->key.length = sizeof(void *);                                   \
+        (lhq)->key_hash = nxt_djb_hash((p), sizeof(void *));                  \
+        (lhq)->proto = &njs_gc_hash_proto;                                    \
+    } while (0)
+
+
+void
+njs_gc_init(njs_vm_t *vm)
+{
+    nxt_lvlhsh_init(&vm->gc_hash);
+    nxt_queue_init(&vm->gc_items);
+
+    vm->gc_allocated = 0;
+    vm->gc_threshold = NJS_GC_THRESHOLD;
+}
+
+
+void *
+njs_gc_alloc(njs_vm_t *vm, njs_value_type_t type, size_t size)
+{
+    void                *p;
+    nxt_int_t           ret;
+    njs_gc_item_t       *item;
+    nxt_lvlhsh_query_t  lhq;
+
+    size += NJS_GC_ITEM_SIZE;
+
+    item = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t), size);
+    if (nxt_slow_path(item == NULL)) {
+        return NULL;
+    }
+
+    p = njs_gc_item_data(item);
+
+    njs_gc_query_init(&lhq, &p);
+    lhq.replace = 0;
+    lhq.value = p;
+    lhq.pool = vm->mem_pool;
+
+    ret = nxt_lvlhsh_insert(&vm->gc_hash, &lhq);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_mp_free(vm->mem_pool, item);
+        return NULL;
+    }
+
+    item->size = size;
+    item->type = type;
+    item->mark = 0;
+
+    nxt_queue_insert_tail(&vm->gc_items, &item->link);
+
+    vm->gc_allocated += size;
+
+    return p;
+}
+
+
+nxt_int_t
+njs_gc(njs_vm_t *vm)
+{
+    size_t        live;
+    nxt_int_t     ret;
+    njs_gc_t      gc;
+    njs_object_t  **objects;
+
+    if (nxt_queue_is_empty(&vm->gc_items)) {
+        vm->gc_allocated = 0;
+        return NXT_OK;
+    }
+
+    gc.vm = vm;
+
+    gc.pool = nxt_mp_create(&njs_vm_mp_proto, NULL, NULL, nxt_pagesize(),
+                            128, 512, 16);
+    if (nxt_slow_path(gc.pool == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_lvlhsh_init(&gc.marked);
+
+    gc.stack = nxt_array_create(64, sizeof(njs_object_t *),
+                                &njs_array_mem_proto, gc.pool);
+    if (nxt_slow_path(gc.stack == NULL)) {
+        ret = NXT_ERROR;
+        goto done;
+    }
+
+    ret = njs_gc_mark_roots(&gc);
+
+    /* The stack is used instead of recursion to trace long object chains. */
+
+    while (ret == NXT_OK && gc.stack->items != 0) {
+        gc.stack->items--;
+        objects = gc.stack->start;
+
+        ret = njs_gc_mark_object(&gc, objects[gc.stack->items]);
+    }
+
+done:
+
+    nxt_mp_destroy(gc.pool);
+
+    /* The marks are reset anyway, nothing is reclaimed on failure. */
+
+    live = njs_gc_sweep(vm, ret == NXT_OK);
+
+    if (ret == NXT_OK) {
+        vm->gc_allocated = 0;
+        vm->gc_threshold = nxt_max(live, NJS_GC_THRESHOLD);
+    }
+
+    return ret;
+}
+
+
+static nxt_int_t
+njs_gc_mark_roots(njs_gc_t *gc)
+{
+    njs_vm_t           *vm;
+    nxt_int_t          ret;
+    nxt_uint_t         i;
+    njs_value_t        *values;
+    njs_event_t        *event;
+    njs_module_t       **modules;
+    nxt_queue_t        *events;
+    nxt_queue_link_t   *link;
+    nxt_lvlhsh_each_t  lhe;
+
+    vm = gc->vm;
+
+    ret = njs_gc_mark_value(gc, &vm->retval);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    values = (njs_value_t *) ((u_char *) vm->scopes[NJS_SCOPE_GLOBAL]
+                              + NJS_INDEX_GLOBAL_OFFSET);
+
+    ret = njs_gc_mark_values(gc, values, vm->scope_size / sizeof(njs_value_t));
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    for (i = 0; i < NJS_PROTOTYPE_MAX; i++) {
+        ret = njs_gc_push(gc, &vm->prototypes[i].object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    for (i = 0; i < NJS_CONSTRUCTOR_MAX; i++) {
+        ret = njs_gc_push(gc, &vm->constructors[i].object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    /* The shared objects are modified in place by the clones. */
+
+    for (i = 0; i < NJS_OBJECT_MAX; i++) {
+        ret = njs_gc_push(gc, &vm->shared->objects[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    for (i = 0; i < NJS_FUNCTION_MAX; i++) {
+        ret = njs_gc_push(gc, &vm->shared->functions[i].object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (vm->modules != NULL) {
+        modules = vm->modules->start;
+
+        for (i = 0; i < vm->modules->items; i++) {
+            ret = njs_gc_push(gc, &modules[i]->object);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+    }
+
+    nxt_lvlhsh_each_init(&lhe, &njs_event_hash_proto);
+
+    for ( ;; ) {
+        event = nxt_lvlhsh_each(&vm->events_hash, &lhe);
+
+        if (event == NULL) {
+            break;
+        }
+
+        ret = njs_gc_mark_event(gc, event);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    /* Promise jobs are posted without being added to the events hash. */
+
+    events = &vm->posted_events;
+
+    for (link = nxt_queue_first(events);
+         link != nxt_queue_tail(events);
+         link = nxt_queue_next(link))
+    {
+        event = nxt_queue_link_data(link, njs_event_t, link);
+
+        ret = njs_gc_mark_event(gc, event);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return njs_promise_gc_mark_rejections(vm, gc);
+}
+
+
+static nxt_int_t
+njs_gc_mark_event(njs_gc_t *gc, njs_event_t *event)
+{
+    nxt_int_t  ret;
+
+    if (event->function != NULL) {
+        ret = njs_gc_push(gc, &event->function->object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return njs_gc_mark_values(gc, event->args, event->nargs);
+}
+
+
+nxt_int_t
+njs_gc_mark_value(njs_gc_t *gc, const njs_value_t *value)
+{
+    nxt_int_t  ret;
+
+    switch (value->type) {
+
+    case NJS_STRING:
+        if (value->short_string.size == NJS_STRING_LONG) {
+            njs_gc_mark_item(gc, value->long_string.data);
+        }
+
+        return NXT_OK;
+
+    case NJS_DATA:
+        ret = njs_typed_array_gc_mark(gc, value);
+        if (ret != NXT_DECLINED) {
+            return ret;
+        }
+
+        ret = njs_map_gc_mark(gc, value);
+        if (ret != NXT_DECLINED) {
+            return ret;
+        }
+
+        ret = njs_async_gc_mark(gc, value);
+        if (ret != NXT_DECLINED) {
+            return ret;
+        }
+
+        return njs_promise_gc_mark(gc, value);
+
+    default:
+        if (njs_is_object(value)) {
+            return njs_gc_push(gc, value->data.u.object);
+        }
+
+        return NXT_OK;
+    }
+}
+
+
+static nxt_int_t
+njs_gc_mark_object(njs_gc_t *gc, njs_object_t *object)
+{
+    nxt_int_t            ret;
+    njs_array_t          *array;
+    njs_regexp_t         *regexp;
+    njs_object_prop_t    *prop;
+    nxt_flathsh_each_t   fhe;
+    njs_object_value_t   *ov;
+
+    /*
+     * The shared hashes are not traced, the properties
+     * are copied to the private hash once they are changed.
+     */
+
+    nxt_flathsh_each_init(&fhe);
+
+    for ( ;; ) {
+        prop = nxt_flathsh_each(&object->hash, &fhe);
+
+        if (prop == NULL) {
+            break;
+        }
+
+        ret = njs_gc_mark_value(gc, &prop->name);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (prop->type != NJS_PROPERTY && prop->type != NJS_METHOD) {
+            continue;
+        }
+
+        ret = njs_gc_mark_value(gc, &prop->value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_gc_mark_value(gc, &prop->getter);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_gc_mark_value(gc, &prop->setter);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    ret = njs_gc_push(gc, object->__proto__);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    switch (object->type) {
+
+    case NJS_ARRAY:
+        array = (njs_array_t *) object;
+
+        return njs_gc_mark_values(gc, array->start, array->length);
+
+    case NJS_OBJECT_BOOLEAN:
+    case NJS_OBJECT_NUMBER:
+    case NJS_OBJECT_STRING:
+    case NJS_OBJECT_VALUE:
+        ov = (njs_object_value_t *) object;
+
+        return njs_gc_mark_value(gc, &ov->value);
+
+    case NJS_FUNCTION:
+        return njs_gc_mark_function(gc, (njs_function_t *) object);
+
+    case NJS_REGEXP:
+        regexp = (njs_regexp_t *) object;
+
+        return njs_gc_mark_value(gc, &regexp->string);
+
+    default:
+        return NXT_OK;
+    }
+}
+
+
+static nxt_int_t
+njs_gc_mark_function(njs_gc_t *gc, njs_function_t *function)
+{
+    nxt_int_t   ret;
+    nxt_uint_t  n;
+
+    if (function->bound != NULL) {
+        ret = njs_gc_mark_values(gc, function->bound, function->args_offset);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (function->native || !function->closure) {
+        return NXT_OK;
+    }
+
+    for (n = 0; n < function->u.lambda->nesting; n++) {
+        ret = njs_gc_mark_closure(gc, function->closures[n]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+njs_gc_mark_closure(njs_gc_t *gc, njs_closure_t *closure)
+{
+    nxt_int_t  ret;
+
+    if (closure == NULL) {
+        return NXT_OK;
+    }
+
+    ret = njs_gc_marked(gc, closure);
+
+    if (ret != NXT_OK) {
+        return (ret == NXT_DECLINED) ? NXT_OK : ret;
+    }
+
+    return njs_gc_mark_values(gc, closure->values, closure->u.count);
+}
+
+
+nxt_int_t
+njs_gc_mark_values(njs_gc_t *gc, const njs_value_t *values, nxt_uint_t n)
+{
+    nxt_int_t  ret;
+
+    while (n != 0) {
+        ret = njs_gc_mark_value(gc, values);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        values++;
+        n--;
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+njs_gc_push(njs_gc_t *gc, njs_object_t *object)
+{
+    nxt_int_t     ret;
+    njs_object_t  **p;
+
+    if (object == NULL) {
+        return NXT_OK;
+    }
+
+    ret = njs_gc_marked(gc, object);
+
+    if (ret != NXT_OK) {
+        /* The object has already been pushed or an error. */
+        return (ret == NXT_DECLINED) ? NXT_OK : ret;
+    }
+
+    njs_gc_mark_item(gc, object);
+
+    p = nxt_array_add(gc->stack, &njs_array_mem_proto, gc->pool);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *p = object;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Returns NXT_OK if the item is marked for the first time,
+ * NXT_DECLINED if it has already been marked.
+ */
+
+static nxt_int_t
+njs_gc_marked(njs_gc_t *gc, void *p)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    njs_gc_query_init(&lhq, &p);
+    lhq.replace = 0;
+    lhq.value = p;
+    lhq.pool = gc->pool;
+
+    return nxt_lvlhsh_insert(&gc->marked, &lhq);
+}
+
+
+static void
+njs_gc_mark_item(njs_gc_t *gc, void *p)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    njs_gc_query_init(&lhq, &p);
+
+    if (nxt_lvlhsh_find(&gc->vm->gc_hash, &lhq) == NXT_OK) {
+        njs_gc_item(p)->mark = 1;
+    }
+}
+
+
+static size_t
+njs_gc_sweep(njs_vm_t *vm, nxt_bool_t reclaim)
+{
+    size_t            live;
+    njs_array_t       *array;
+    njs_gc_item_t     *item;
+    nxt_queue_link_t  *link, *next;
+
+    live = 0;
+
+    /*
+     * The objects are freed before the strings because the names
+     * of their properties are used to empty the property hashes.
+     */
+
+    for (link = nxt_queue_first(&vm->gc_items);
+         link != nxt_queue_tail(&vm->gc_items);
+         link = next)
+    {
+        next = nxt_queue_next(link);
+
+        item = nxt_queue_link_data(link, njs_gc_item_t, link);
+
+        if (item->mark || !reclaim) {
+            live += item->size;
+
+            if (item->type == NJS_ARRAY) {
+                array = njs_gc_item_data(item);
+                live += array->size * sizeof(njs_value_t);
+            }
+
+            continue;
+        }
+
+        if (item->type != NJS_STRING) {
+            njs_gc_free(vm, item);
+        }
+    }
+
+    for (link = nxt_queue_first(&vm->gc_items);
+         link != nxt_queue_tail(&vm->gc_items);
+         link = next)
+    {
+        next = nxt_queue_next(link);
+
+        item = nxt_queue_link_data(link, njs_gc_item_t, link);
+
+        if (item->mark || !reclaim) {
+            item->mark = 0;
+            continue;
+        }
+
+        njs_gc_free(vm, item);
+    }
+
+    return live;
+}
+
+
+void
+njs_gc_free_string(njs_vm_t *vm, njs_string_t *string)
+{
+    njs_gc_free(vm, njs_gc_item(string));
+}
+
+
+static void
+njs_gc_free(njs_vm_t *vm, njs_gc_item_t *item)
+{
+    void                *p;
+    njs_array_t         *array;
+    nxt_lvlhsh_query_t  lhq;
+
+    p = njs_gc_item_data(item);
+
+    switch (item->type) {
+
+    case NJS_ARRAY:
+        array = p;
+
+        nxt_mp_free(vm->mem_pool, array->data);
+
+        /* Fall through. */
+
+    case NJS_OBJECT:
+        njs_gc_free_object(vm, p);
+        break;
+
+    default:
+        break;
+    }
+
+    njs_gc_query_init(&lhq, &p);
+    lhq.pool = vm->mem_pool;
+
+    (void) nxt_lvlhsh_delete(&vm->gc_hash, &lhq);
+
+    nxt_queue_remove(&item->link);
+
+    nxt_mp_free(vm->mem_pool, item);
+}
+
+
+/*
+ * The properties of the own hash are allocated one by one and are
+ * not shared with other objects.  They are deleted one by one to
+ * let the hash release its table.
+ */
+
+static void
+njs_gc_free_object(njs_vm_t *vm, njs_object_t *object)
+{
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.proto = &njs_object_hash_proto;
+    lhq.pool = vm->mem_pool;
+
+    nxt_flathsh_each_init(&fhe);
+
+    for ( ;; ) {
+        prop = nxt_flathsh_each(&object->hash, &fhe);
+
+        if (prop == NULL) {
+            return;
+        }
+
+        njs_string_get(&prop->name, &lhq.key);
+        lhq.key_hash = fhe.key_hash;
+
+        if (nxt_slow_path(nxt_flathsh_delete(&object->hash, &lhq) != NXT_OK)) {
+            /* The rest of the hash is left to the pool. */
+            return;
+        }
+
+        nxt_mp_free(vm->mem_pool, prop);
+    }
+}
+
+
+static nxt_int_t
+njs_gc_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    if (*(void **) lhq->key.start == data) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
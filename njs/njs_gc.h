@@ -0,0 +1,28 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_GC_H_INCLUDED_
+#define _NJS_GC_H_INCLUDED_
+
+
+/* The minimal size of values allocated between collections. */
+#define NJS_GC_THRESHOLD       (64 * 1024)
+
+
+typedef struct njs_gc_s  njs_gc_t;
+
+
+void njs_gc_init(njs_vm_t *vm);
+void *njs_gc_alloc(njs_vm_t *vm, njs_value_type_t type, size_t size);
+void njs_gc_free_string(njs_vm_t *vm, njs_string_t *string);
+nxt_int_t njs_gc(njs_vm_t *vm);
+nxt_int_t njs_gc_mark_value(njs_gc_t *gc, const njs_value_t *value);
+nxt_int_t njs_gc_mark_values(njs_gc_t *gc, const njs_value_t *values,
+    nxt_uint_t n);
+nxt_int_t njs_gc_mark_closure(njs_gc_t *gc, njs_closure_t *closure);
+nxt_int_t njs_gc_push(njs_gc_t *gc, njs_object_t *object);
+
+
+#endif /* _NJS_GC_H_INCLUDED_ */
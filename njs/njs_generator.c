@@ -79,6 +79,8 @@ static nxt_int_t njs_generate_for_statement(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_int_t njs_generate_for_in_statement(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
+static nxt_int_t njs_generate_for_of_statement(njs_vm_t *vm,
+    njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_noinline nxt_int_t njs_generate_start_block(njs_vm_t *vm,
     njs_generator_t *generator, njs_generator_block_type_t type,
     const nxt_str_t *label);
@@ -119,6 +121,12 @@ static nxt_int_t njs_generate_object(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_node_t *node);
 static nxt_int_t njs_generate_array(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_node_t *node);
+static nxt_int_t njs_generate_spread_element(njs_vm_t *vm,
+    njs_generator_t *generator, njs_parser_node_t *node);
+static nxt_int_t njs_generate_rest(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node);
+static nxt_int_t njs_generate_destructuring(njs_vm_t *vm,
+    njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_int_t njs_generate_function(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_node_t *node);
 static nxt_int_t njs_generate_regexp(njs_vm_t *vm, njs_generator_t *generator,
@@ -137,6 +145,13 @@ static nxt_int_t njs_generate_inc_dec_operation(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node, nxt_bool_t post);
 static nxt_int_t njs_generate_function_declaration(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
+static void njs_generate_lambda_error(njs_vm_t *vm,
+    njs_parser_source_t *source);
+static nxt_bool_t njs_generate_lazy_allowed(njs_parser_node_t *node,
+    uint32_t mask);
+static nxt_int_t njs_generate_function_code(njs_vm_t *vm,
+    njs_function_lambda_t *lambda, njs_parser_node_t *node,
+    const nxt_str_t *name);
 static nxt_int_t njs_generate_function_scope(njs_vm_t *vm,
     njs_function_lambda_t *lambda, njs_parser_node_t *node,
     const nxt_str_t *name);
@@ -150,10 +165,16 @@ static nxt_int_t njs_generate_method_call(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_noinline nxt_int_t njs_generate_call(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
+static nxt_bool_t njs_generate_is_spread_call(njs_parser_node_t *node);
+static nxt_int_t njs_generate_spread_call(njs_vm_t *vm,
+    njs_generator_t *generator, njs_parser_node_t *node, njs_index_t function,
+    njs_index_t object);
 static nxt_int_t njs_generate_try_statement(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_int_t njs_generate_throw_statement(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
+static nxt_int_t njs_generate_await(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node);
 static nxt_int_t njs_generate_import_statement(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_int_t njs_generate_export_statement(njs_vm_t *vm,
@@ -174,6 +195,11 @@ static nxt_noinline nxt_int_t njs_generate_node_index_release(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 static nxt_noinline nxt_int_t njs_generate_index_release(njs_vm_t *vm,
     njs_generator_t *generator, njs_index_t index);
+static void njs_generate_unused_result(njs_parser_node_t *node);
+static nxt_bool_t njs_generate_has_reference(njs_parser_node_t *node,
+    const nxt_str_t *name);
+static nxt_bool_t njs_generate_is_primary(njs_vm_t *vm,
+    njs_parser_node_t *node);
 static nxt_int_t njs_generate_reference_error(njs_vm_t *vm,
     njs_generator_t *generator, njs_parser_node_t *node);
 
@@ -288,6 +314,9 @@ njs_generator(njs_vm_t *vm, njs_generator_t *generator, njs_parser_node_t *node)
     case NJS_TOKEN_FOR_IN:
         return njs_generate_for_in_statement(vm, generator, node);
 
+    case NJS_TOKEN_FOR_OF:
+        return njs_generate_for_of_statement(vm, generator, node);
+
     case NJS_TOKEN_CONTINUE:
         return njs_generate_continue_statement(vm, generator, node);
 
@@ -372,6 +401,9 @@ njs_generator(njs_vm_t *vm, njs_generator_t *generator, njs_parser_node_t *node)
     case NJS_TOKEN_TYPEOF:
         return njs_generate_typeof_operation(vm, generator, node);
 
+    case NJS_TOKEN_AWAIT:
+        return njs_generate_await(vm, generator, node);
+
     case NJS_TOKEN_INCREMENT:
     case NJS_TOKEN_DECREMENT:
         return njs_generate_inc_dec_operation(vm, generator, node, 0);
@@ -402,6 +434,15 @@ njs_generator(njs_vm_t *vm, njs_generator_t *generator, njs_parser_node_t *node)
     case NJS_TOKEN_ARRAY:
         return njs_generate_array(vm, generator, node);
 
+    case NJS_TOKEN_ELLIPSIS:
+        return njs_generate_spread_element(vm, generator, node);
+
+    case NJS_TOKEN_REST:
+        return njs_generate_rest(vm, generator, node);
+
+    case NJS_TOKEN_DESTRUCTURING:
+        return njs_generate_destructuring(vm, generator, node);
+
     case NJS_TOKEN_FUNCTION_EXPRESSION:
         return njs_generate_function(vm, generator, node);
 
@@ -420,6 +461,22 @@ njs_generator(njs_vm_t *vm, njs_generator_t *generator, njs_parser_node_t *node)
     case NJS_TOKEN_FUNCTION_CONSTRUCTOR:
     case NJS_TOKEN_REGEXP_CONSTRUCTOR:
     case NJS_TOKEN_DATE_CONSTRUCTOR:
+    case NJS_TOKEN_PROMISE_CONSTRUCTOR:
+    case NJS_TOKEN_ARRAY_BUFFER_CONSTRUCTOR:
+    case NJS_TOKEN_DATA_VIEW_CONSTRUCTOR:
+    case NJS_TOKEN_INT8_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_UINT8_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_UINT8_CLAMPED_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_INT16_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_UINT16_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_INT32_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_UINT32_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_FLOAT32_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_FLOAT64_ARRAY_CONSTRUCTOR:
+    case NJS_TOKEN_MAP_CONSTRUCTOR:
+    case NJS_TOKEN_SET_CONSTRUCTOR:
+    case NJS_TOKEN_WEAK_MAP_CONSTRUCTOR:
+    case NJS_TOKEN_WEAK_SET_CONSTRUCTOR:
     case NJS_TOKEN_ERROR_CONSTRUCTOR:
     case NJS_TOKEN_EVAL_ERROR_CONSTRUCTOR:
     case NJS_TOKEN_INTERNAL_ERROR_CONSTRUCTOR:
@@ -468,6 +525,8 @@ njs_generator(njs_vm_t *vm, njs_generator_t *generator, njs_parser_node_t *node)
     case NJS_TOKEN_SET_TIMEOUT:
     case NJS_TOKEN_SET_IMMEDIATE:
     case NJS_TOKEN_CLEAR_TIMEOUT:
+    case NJS_TOKEN_SET_INTERVAL:
+    case NJS_TOKEN_CLEAR_INTERVAL:
         return njs_generate_builtin_object(vm, generator, node);
 
     case NJS_TOKEN_FUNCTION:
@@ -846,12 +905,29 @@ njs_generate_switch_statement(njs_vm_t *vm, njs_generator_t *generator,
     index = expr->index;
 
     if (!expr->temporary) {
-        index = njs_generate_temp_index_get(vm, generator, swtch);
-        if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
-            return NXT_ERROR;
+
+        /*
+         * A variable value is preserved unless all the "case" expressions
+         * are literals or variables, any other expression may change it,
+         * even by an implicit valueOf() call.
+         */
+
+        for (branch = swtch->right; branch != NULL; branch = branch->left) {
+            if (branch->token != NJS_TOKEN_DEFAULT
+                && !njs_generate_is_primary(vm, branch->right->left))
+            {
+                break;
+            }
         }
 
-        njs_generate_code_move(generator, move, index, expr->index);
+        if (branch != NULL) {
+            index = njs_generate_temp_index_get(vm, generator, swtch);
+            if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+                return NXT_ERROR;
+            }
+
+            njs_generate_code_move(generator, move, index, expr->index);
+        }
     }
 
     ret = njs_generate_start_block(vm, generator, NJS_GENERATOR_SWITCH,
@@ -901,10 +977,12 @@ njs_generate_switch_statement(njs_vm_t *vm, njs_generator_t *generator,
         }
     }
 
-    /* Release either temporary index or temporary expr->index. */
-    ret = njs_generate_index_release(vm, generator, index);
-    if (nxt_slow_path(ret != NXT_OK)) {
-        return ret;
+    if (index != expr->index || expr->temporary) {
+        /* Release either temporary index or temporary expr->index. */
+        ret = njs_generate_index_release(vm, generator, index);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
     }
 
     njs_generate_code_jump(generator, jump,
@@ -1076,6 +1154,8 @@ njs_generate_for_statement(njs_vm_t *vm, njs_generator_t *generator,
 
     /* The loop initialization. */
 
+    njs_generate_unused_result(node->left);
+
     ret = njs_generator(vm, generator, node->left);
     if (nxt_slow_path(ret != NXT_OK)) {
         return ret;
@@ -1119,6 +1199,8 @@ njs_generate_for_statement(njs_vm_t *vm, njs_generator_t *generator,
 
     update = node->right;
 
+    njs_generate_unused_result(update);
+
     ret = njs_generator(vm, generator, update);
     if (nxt_slow_path(ret != NXT_OK)) {
         return ret;
@@ -1239,6 +1321,130 @@ njs_generate_for_in_statement(njs_vm_t *vm, njs_generator_t *generator,
 }
 
 
+static nxt_int_t
+njs_generate_for_of_statement(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node)
+{
+    njs_ret_t                  loop_offset, value_offset;
+    nxt_int_t                  ret;
+    njs_index_t                index, src;
+    njs_parser_node_t          *foreach, *target, *object;
+    njs_vmcode_move_t          *move;
+    njs_vmcode_prop_next_t     *value_next;
+    njs_vmcode_prop_foreach_t  *value_foreach;
+
+    ret = njs_generate_start_block(vm, generator, NJS_GENERATOR_LOOP,
+                                   &node->name);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    foreach = node->left;
+    target = foreach->left;
+    object = foreach->right;
+
+    /* The iterated value. */
+
+    ret = njs_generator(vm, generator, object);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    if (object->token == NJS_TOKEN_NAME) {
+        /* The loop body can change the variable. */
+        src = object->index;
+
+        index = njs_generate_node_temp_index_get(vm, generator, object);
+        if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        njs_generate_code_move(generator, move, index, src);
+    }
+
+    njs_generate_code(generator, njs_vmcode_prop_foreach_t, value_foreach,
+                      njs_vmcode_value_foreach, 2, 1);
+    value_offset = njs_code_offset(generator, value_foreach);
+    value_foreach->object = object->index;
+
+    index = njs_generate_temp_index_get(vm, generator, object);
+    if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+        return NXT_ERROR;
+    }
+
+    value_foreach->next = index;
+
+    if (target->token != NJS_TOKEN_NAME) {
+        /* The element value referenced by the pattern or assignment. */
+        foreach->index = njs_generate_temp_index_get(vm, generator, foreach);
+        if (nxt_slow_path(foreach->index == NJS_INDEX_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        foreach->temporary = 1;
+    }
+
+    /* The loop body. */
+
+    loop_offset = njs_code_offset(generator, generator->code_end);
+
+    if (target->token != NJS_TOKEN_NAME) {
+        ret = njs_generator(vm, generator, target);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_generate_node_index_release(vm, generator, target);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    ret = njs_generator(vm, generator, node->right);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    /* The loop iterator. */
+
+    njs_generate_patch_block(vm, generator, generator->block->continuation);
+
+    njs_code_set_jump_offset(generator, njs_vmcode_prop_foreach_t,
+                             value_offset);
+
+    if (target->token == NJS_TOKEN_NAME) {
+        ret = njs_generator(vm, generator, target);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        foreach->index = target->index;
+    }
+
+    njs_generate_code(generator, njs_vmcode_prop_next_t, value_next,
+                      njs_vmcode_value_next, 3, 0);
+    value_offset = njs_code_offset(generator, value_next);
+    value_next->retval = foreach->index;
+    value_next->object = object->index;
+    value_next->next = index;
+    value_next->offset = loop_offset - value_offset;
+
+    njs_generate_patch_block_exit(vm, generator);
+
+    ret = njs_generate_node_index_release(vm, generator, foreach);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    ret = njs_generate_node_index_release(vm, generator, object);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_generate_index_release(vm, generator, index);
+}
+
+
 static nxt_noinline nxt_int_t
 njs_generate_start_block(njs_vm_t *vm, njs_generator_t *generator,
     njs_generator_block_type_t type, const nxt_str_t *label)
@@ -1539,6 +1745,8 @@ njs_generate_statement(njs_vm_t *vm, njs_generator_t *generator,
 {
     nxt_int_t  ret;
 
+    njs_generate_unused_result(node->right);
+
     ret = njs_generate_children(vm, generator, node);
 
     if (nxt_fast_path(ret == NXT_OK)) {
@@ -1882,6 +2090,12 @@ njs_generate_object(njs_vm_t *vm, njs_generator_t *generator,
 {
     njs_vmcode_object_t  *object;
 
+    if (nxt_slow_path(node->ctor)) {
+        njs_generate_syntax_error(vm, node,
+                                  "Invalid shorthand property initializer");
+        return NXT_ERROR;
+    }
+
     node->index = njs_generate_object_dest_index(vm, generator, node);
     if (nxt_slow_path(node->index == NJS_INDEX_ERROR)) {
         return NXT_ERROR;
@@ -1918,6 +2132,126 @@ njs_generate_array(njs_vm_t *vm, njs_generator_t *generator,
 }
 
 
+static nxt_int_t
+njs_generate_spread_element(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node)
+{
+    nxt_int_t               ret;
+    njs_parser_node_t       *literal;
+    njs_vmcode_3addr_t      *spread;
+    njs_vmcode_operation_t  operation;
+
+    ret = njs_generator(vm, generator, node->left);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    literal = node->right->u.object;
+
+    operation = (literal->token == NJS_TOKEN_ARRAY) ? njs_vmcode_array_spread
+                                                    : njs_vmcode_object_spread;
+
+    njs_generate_code(generator, njs_vmcode_3addr_t, spread, operation, 3, 0);
+    spread->dst = literal->index;
+    spread->src1 = node->left->index;
+    spread->src2 = njs_value_index(vm, &njs_value_zero, generator->runtime);
+
+    return njs_generate_node_index_release(vm, generator, node->left);
+}
+
+
+static nxt_int_t
+njs_generate_rest(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node)
+{
+    nxt_int_t               ret;
+    njs_index_t             index;
+    njs_parser_node_t       *keys;
+    njs_vmcode_array_t      *array;
+    njs_vmcode_object_t     *object;
+    njs_vmcode_3addr_t      *rest;
+    njs_vmcode_operation_t  operation;
+
+    keys = node->right;
+
+    ret = njs_generator(vm, generator, keys);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    /*
+     * The rest value is created in a temporary, so the target is
+     * not changed if the source value is not iterable.
+     */
+    index = njs_generate_node_temp_index_get(vm, generator, node);
+    if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+        return NXT_ERROR;
+    }
+
+    if (keys->token == NJS_TOKEN_NUMBER) {
+        njs_generate_code(generator, njs_vmcode_array_t, array,
+                          njs_vmcode_array, 1, 1);
+        array->code.ctor = 0;
+        array->retval = index;
+        array->length = 0;
+
+        operation = njs_vmcode_array_spread;
+
+    } else {
+        njs_generate_code(generator, njs_vmcode_object_t, object,
+                          njs_vmcode_object, 1, 1);
+        object->retval = index;
+
+        operation = njs_vmcode_object_spread;
+    }
+
+    njs_generate_code(generator, njs_vmcode_3addr_t, rest, operation, 3, 0);
+    rest->dst = index;
+    rest->src1 = node->left->u.object->index;
+    rest->src2 = keys->index;
+
+    return njs_generate_node_index_release(vm, generator, keys);
+}
+
+
+static nxt_int_t
+njs_generate_destructuring(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node)
+{
+    nxt_int_t          ret;
+    njs_index_t        index;
+    njs_parser_node_t  *expr;
+    njs_vmcode_move_t  *move;
+
+    expr = node->right;
+
+    ret = njs_generator(vm, generator, expr);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    if (expr->token == NJS_TOKEN_NAME) {
+        /*
+         * Preserve the source value stored in a variable in a case
+         * if the variable is changed by the pattern assignments.
+         */
+        index = njs_generate_node_temp_index_get(vm, generator, node);
+        if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        njs_generate_code_move(generator, move, index, expr->index);
+
+    } else {
+        node->index = expr->index;
+        node->temporary = expr->temporary;
+    }
+
+    /* The pattern elements. */
+    return njs_generator(vm, generator, node->left);
+}
+
+
 static nxt_int_t
 njs_generate_function(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_node_t *node)
@@ -2010,6 +2344,7 @@ njs_generate_test_jump_expression(njs_vm_t *vm, njs_generator_t *generator,
 {
     njs_ret_t               jump_offset;
     nxt_int_t               ret;
+    njs_parser_node_t       *dest;
     njs_vmcode_move_t       *move;
     njs_vmcode_test_jump_t  *test_jump;
 
@@ -2023,9 +2358,27 @@ njs_generate_test_jump_expression(njs_vm_t *vm, njs_generator_t *generator,
     jump_offset = njs_code_offset(generator, test_jump);
     test_jump->value = node->left->index;
 
-    node->index = njs_generate_node_temp_index_get(vm, generator, node);
-    if (nxt_slow_path(node->index == NJS_INDEX_ERROR)) {
-        return node->index;
+    /*
+     * The left operand value is stored directly to a destination
+     * variable if the right operand cannot throw or read the variable,
+     * otherwise the variable would be changed before the assignment.
+     */
+
+    dest = node->dest;
+
+    if (dest != NULL
+        && dest->token == NJS_TOKEN_NAME
+        && dest->index != NJS_INDEX_NONE
+        && njs_generate_is_primary(vm, node->right)
+        && !njs_generate_has_reference(node->right, &dest->u.reference.name))
+    {
+        node->index = dest->index;
+
+    } else {
+        node->index = njs_generate_node_temp_index_get(vm, generator, node);
+        if (nxt_slow_path(node->index == NJS_INDEX_ERROR)) {
+            return node->index;
+        }
     }
 
     test_jump->retval = node->index;
@@ -2340,6 +2693,215 @@ njs_generate_function_declaration(njs_vm_t *vm, njs_generator_t *generator,
 static nxt_int_t
 njs_generate_function_scope(njs_vm_t *vm, njs_function_lambda_t *lambda,
     njs_parser_node_t *node, const nxt_str_t *name)
+{
+    lambda->nesting = node->right->scope->nesting;
+    lambda->closures = node->right->scope->closures;
+
+    if (lambda->source == NULL
+        && (!vm->options.lazy || !njs_generate_lazy_allowed(node->right, 0)))
+    {
+        return njs_generate_function_code(vm, lambda, node, name);
+    }
+
+    lambda->node = node;
+    lambda->name = name;
+
+    /* The maximum frame size disables the fast call path. */
+    lambda->frame_size = (uint32_t) -1;
+
+    return NXT_OK;
+}
+
+
+/*
+ * The generator reports "break" and "continue" statements outside of loops
+ * and shorthand property initializers outside of patterns as syntax errors
+ * and does not support some jumps from try-catch blocks.  To report such
+ * errors at compile time, the generation is postponed only for functions
+ * which cannot fail this way.  Labelled jumps are treated conservatively.
+ */
+
+static nxt_bool_t
+njs_generate_lazy_allowed(njs_parser_node_t *node, uint32_t mask)
+{
+    if (node == NULL) {
+        return 1;
+    }
+
+    switch (node->token) {
+
+    case NJS_TOKEN_TRY:
+        return 0;
+
+    case NJS_TOKEN_OBJECT:
+        if (node->ctor) {
+            return 0;
+        }
+
+        break;
+
+    case NJS_TOKEN_BREAK:
+        return (node->name.length == 0 && (mask & NJS_GENERATOR_ALL) != 0);
+
+    case NJS_TOKEN_CONTINUE:
+        return (node->name.length == 0 && (mask & NJS_GENERATOR_LOOP) != 0);
+
+    case NJS_TOKEN_WHILE:
+    case NJS_TOKEN_DO:
+    case NJS_TOKEN_FOR:
+    case NJS_TOKEN_FOR_IN:
+    case NJS_TOKEN_FOR_OF:
+        mask |= NJS_GENERATOR_LOOP;
+        break;
+
+    case NJS_TOKEN_SWITCH:
+        mask |= NJS_GENERATOR_SWITCH;
+        break;
+
+    case NJS_TOKEN_FUNCTION:
+    case NJS_TOKEN_FUNCTION_EXPRESSION:
+        mask = 0;
+        break;
+
+    default:
+        break;
+    }
+
+    return njs_generate_lazy_allowed(node->left, mask)
+           && njs_generate_lazy_allowed(node->right, mask);
+}
+
+
+/*
+ * Generates the bytecode of a lazily compiled function on its first call.
+ * The body skipped by the pre-parser is parsed before.  The VM may be
+ * a clone, so the code is allocated from the memory pool of the VM which
+ * has compiled the script to be shared by all the clones, and the code
+ * entries are added to the array of the shared data.
+ */
+
+nxt_int_t
+njs_generate_lambda(njs_vm_t *vm, njs_function_lambda_t *lambda)
+{
+    nxt_mp_t             *mp;
+    nxt_int_t            ret;
+    njs_value_t          retval;
+    nxt_array_t          *code;
+    njs_parser_source_t  *source;
+
+    source = lambda->source;
+
+    if (source != NULL && source->error != 0) {
+        goto failed;
+    }
+
+    retval = vm->retval;
+    vm->retval = njs_value_undefined;
+
+    mp = vm->mem_pool;
+    vm->mem_pool = vm->shared->mem_pool;
+
+    code = vm->code;
+    vm->code = vm->shared->code;
+
+    ret = NXT_OK;
+
+    if (source != NULL) {
+        ret = njs_parser_lambda_source(vm, lambda->node, source);
+    }
+
+    if (ret == NXT_OK) {
+        ret = njs_generate_function_code(vm, lambda, lambda->node,
+                                         lambda->name);
+    }
+
+    vm->shared->code = vm->code;
+    vm->code = code;
+
+    vm->mem_pool = mp;
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        if (source == NULL) {
+            njs_memory_error(vm);
+            return NXT_ERROR;
+        }
+
+        njs_generate_lambda_error(vm, source);
+
+        goto failed;
+    }
+
+    vm->retval = retval;
+
+    lambda->node = NULL;
+    lambda->name = NULL;
+    lambda->source = NULL;
+
+    return NXT_OK;
+
+failed:
+
+    if (source->message.start == NULL) {
+        njs_memory_error(vm);
+
+    } else {
+        njs_error_new(vm, &vm->retval, source->error, source->message.start,
+                      source->message.length);
+    }
+
+    return NXT_ERROR;
+}
+
+
+/*
+ * A function body which has failed to parse is left partially parsed,
+ * so the error is reported on each call.  The error object has been
+ * allocated from the shared memory pool, only its message is kept there
+ * and the error is created again by the calling VM.
+ */
+
+static void
+njs_generate_lambda_error(njs_vm_t *vm, njs_parser_source_t *source)
+{
+    u_char              *p;
+    nxt_str_t           message;
+    njs_object_prop_t   *prop;
+    nxt_lvlhsh_query_t  lhq;
+
+    source->error = NJS_OBJECT_INTERNAL_ERROR;
+
+    if (!njs_is_error(&vm->retval)
+        || vm->retval.data.u.object == &vm->memory_error_object)
+    {
+        return;
+    }
+
+    lhq.key_hash = NJS_MESSAGE_HASH;
+    lhq.key = nxt_string_value("message");
+
+    prop = njs_object_property(vm, vm->retval.data.u.object, &lhq);
+    if (prop == NULL || !njs_is_string(&prop->value)) {
+        return;
+    }
+
+    njs_string_get(&prop->value, &message);
+
+    p = nxt_mp_alloc(vm->shared->mem_pool, message.length + 1);
+    if (nxt_slow_path(p == NULL)) {
+        return;
+    }
+
+    memcpy(p, message.start, message.length);
+
+    source->error = vm->retval.type;
+    source->message.start = p;
+    source->message.length = message.length;
+}
+
+
+static nxt_int_t
+njs_generate_function_code(njs_vm_t *vm, njs_function_lambda_t *lambda,
+    njs_parser_node_t *node, const nxt_str_t *name)
 {
     size_t           size;
     nxt_int_t        ret;
@@ -2364,11 +2926,14 @@ njs_generate_function_scope(njs_vm_t *vm, njs_function_lambda_t *lambda,
 
         lambda->closure_size = size;
 
-        lambda->nesting = node->scope->nesting;
-
         lambda->start = generator.code_start;
+        lambda->end = generator.code_end;
         lambda->local_size = generator.scope_size;
         lambda->local_scope = generator.local_scope;
+
+        lambda->frame_size = njs_frame_size(lambda->nesting + 1)
+                             + (1 + lambda->nargs) * sizeof(njs_value_t)
+                             + lambda->local_size;
     }
 
     return ret;
@@ -2447,6 +3012,7 @@ njs_generate_scope(njs_vm_t *vm, njs_generator_t *generator,
 
     code->start = generator->code_start;
     code->end = generator->code_end;
+    code->scope_size = scope_size;
     code->file = scope->file;
     code->name = *name;
 
@@ -2579,7 +3145,9 @@ njs_generate_function_call(njs_vm_t *vm, njs_generator_t *generator,
 {
     njs_ret_t                    func_offset;
     njs_ret_t                    ret;
+    njs_index_t                  index;
     njs_parser_node_t            *name;
+    njs_vmcode_move_t            *move;
     njs_vmcode_function_frame_t  *func;
 
     if (node->left != NULL) {
@@ -2604,6 +3172,34 @@ njs_generate_function_call(njs_vm_t *vm, njs_generator_t *generator,
         return NXT_OK;
     }
 
+    if (njs_generate_is_spread_call(node)) {
+        index = name->index;
+
+        if (name == node || name->token == NJS_TOKEN_NAME) {
+            /* The variable can be changed by the arguments. */
+            index = njs_generate_temp_index_get(vm, generator, node);
+            if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+                return NXT_ERROR;
+            }
+
+            njs_generate_code_move(generator, move, index, name->index);
+        }
+
+        ret = njs_generate_spread_call(vm, generator, node, index,
+                                       njs_value_index(vm,
+                                                       &njs_value_undefined,
+                                                       generator->runtime));
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (index != name->index) {
+            return njs_generate_index_release(vm, generator, index);
+        }
+
+        return NXT_OK;
+    }
+
     njs_generate_code(generator, njs_vmcode_function_frame_t, func,
                       njs_vmcode_function_frame, 2, 0);
     func_offset = njs_code_offset(generator, func);
@@ -2629,7 +3225,10 @@ njs_generate_method_call(njs_vm_t *vm, njs_generator_t *generator,
 {
     njs_ret_t                  method_offset;
     nxt_int_t                  ret;
+    njs_index_t                index, object;
     njs_parser_node_t          *prop;
+    njs_vmcode_move_t          *move;
+    njs_vmcode_prop_get_t      *prop_get;
     njs_vmcode_method_frame_t  *method;
 
     prop = node->left;
@@ -2648,6 +3247,51 @@ njs_generate_method_call(njs_vm_t *vm, njs_generator_t *generator,
         return ret;
     }
 
+    if (njs_generate_is_spread_call(node)) {
+        index = njs_generate_temp_index_get(vm, generator, prop);
+        if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        njs_generate_code(generator, njs_vmcode_prop_get_t, prop_get,
+                          njs_vmcode_property_get, 3, 1);
+        prop_get->value = index;
+        prop_get->object = prop->left->index;
+        prop_get->property = prop->right->index;
+
+        object = prop->left->index;
+
+        if (prop->left->token == NJS_TOKEN_NAME) {
+            /* The variable can be changed by the arguments. */
+            object = njs_generate_temp_index_get(vm, generator, prop);
+            if (nxt_slow_path(object == NJS_INDEX_ERROR)) {
+                return NXT_ERROR;
+            }
+
+            njs_generate_code_move(generator, move, object,
+                                   prop->left->index);
+        }
+
+        ret = njs_generate_spread_call(vm, generator, node, index, object);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_generate_index_release(vm, generator, index);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (object != prop->left->index) {
+            ret = njs_generate_index_release(vm, generator, object);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+        return njs_generate_children_indexes_release(vm, generator, prop);
+    }
+
     njs_generate_code(generator, njs_vmcode_method_frame_t, method,
                       njs_vmcode_method_frame, 3, 0);
     method_offset = njs_code_offset(generator, method);
@@ -2715,6 +3359,117 @@ njs_generate_call(njs_vm_t *vm, njs_generator_t *generator,
 }
 
 
+static nxt_bool_t
+njs_generate_is_spread_call(njs_parser_node_t *node)
+{
+    njs_parser_node_t  *arg;
+
+    arg = node->right;
+
+    if (arg == NULL) {
+        return 0;
+    }
+
+    while (arg->right != NULL) {
+        arg = arg->right;
+    }
+
+    return (arg->left->token == NJS_TOKEN_ELLIPSIS);
+}
+
+
+/*
+ * A call with the trailing spread argument evaluates the static arguments
+ * to temporary values because the frame can be created only when the
+ * spread array length is known.  Then the SPREAD FRAME operation creates
+ * the frame and copies the array values, the static arguments are moved
+ * to their frame slots, so no intermediate array is allocated.
+ */
+
+static nxt_int_t
+njs_generate_spread_call(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node, njs_index_t function, njs_index_t object)
+{
+    nxt_int_t                   ret;
+    nxt_uint_t                  nargs;
+    njs_index_t                 index, src, retval;
+    njs_parser_node_t           *arg, *expr;
+    njs_vmcode_move_t           *move;
+    njs_vmcode_function_call_t  *call;
+    njs_vmcode_spread_frame_t   *spread;
+
+    nargs = 0;
+
+    for (arg = node->right; arg->right != NULL; arg = arg->right) {
+        nargs++;
+
+        expr = arg->left;
+        expr->dest = NULL;
+
+        ret = njs_generator(vm, generator, expr);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (expr->token == NJS_TOKEN_NAME) {
+            /* The variable can be changed by the following arguments. */
+            src = expr->index;
+
+            index = njs_generate_node_temp_index_get(vm, generator, expr);
+            if (nxt_slow_path(index == NJS_INDEX_ERROR)) {
+                return NXT_ERROR;
+            }
+
+            njs_generate_code_move(generator, move, index, src);
+        }
+    }
+
+    /* The spread array. */
+
+    expr = arg->left->left;
+
+    ret = njs_generator(vm, generator, expr);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    njs_generate_code(generator, njs_vmcode_spread_frame_t, spread,
+                      njs_vmcode_spread_frame, 3, 0);
+    spread->code.ctor = node->ctor;
+    spread->nargs = nargs;
+    spread->function = function;
+    spread->array = expr->index;
+    spread->object = object;
+
+    ret = njs_generate_node_index_release(vm, generator, expr);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    for (arg = node->right; arg->right != NULL; arg = arg->right) {
+        njs_generate_code_move(generator, move, arg->index, arg->left->index);
+
+        ret = njs_generate_node_index_release(vm, generator, arg->left);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    retval = njs_generate_dest_index(vm, generator, node);
+    if (nxt_slow_path(retval == NJS_INDEX_ERROR)) {
+        return retval;
+    }
+
+    node->index = retval;
+
+    njs_generate_code(generator, njs_vmcode_function_call_t, call,
+                      njs_vmcode_function_call, 1, 0);
+    call->retval = retval;
+
+    return NXT_OK;
+}
+
+
 #define njs_generate_code_catch(generator, _code, _exception)                 \
     do {                                                                      \
             njs_generate_code(generator, njs_vmcode_catch_t, _code,           \
@@ -3076,6 +3831,38 @@ njs_generate_throw_statement(njs_vm_t *vm, njs_generator_t *generator,
 }
 
 
+/*
+ * The result of "await" is stored by the await instruction itself
+ * when the function is resumed.
+ */
+
+static nxt_int_t
+njs_generate_await(njs_vm_t *vm, njs_generator_t *generator,
+    njs_parser_node_t *node)
+{
+    nxt_int_t           ret;
+    njs_vmcode_await_t  *code;
+
+    ret = njs_generator(vm, generator, node->left);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    njs_generate_code(generator, njs_vmcode_await_t, code,
+                      njs_vmcode_await, 2, 0);
+    code->value = node->left->index;
+
+    node->index = njs_generate_dest_index(vm, generator, node);
+    if (nxt_slow_path(node->index == NJS_INDEX_ERROR)) {
+        return node->index;
+    }
+
+    code->retval = node->index;
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 njs_generate_import_statement(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_node_t *node)
@@ -3285,6 +4072,83 @@ njs_generate_index_release(njs_vm_t *vm, njs_generator_t *generator,
 }
 
 
+/*
+ * The result of an expression statement is not used, so a postfix
+ * increment or decrement of a variable is generated as a prefix one
+ * storing the result directly to the variable instead of a temporary.
+ */
+
+static void
+njs_generate_unused_result(njs_parser_node_t *node)
+{
+    if (node == NULL
+        || node->left == NULL
+        || node->left->token != NJS_TOKEN_NAME)
+    {
+        return;
+    }
+
+    switch (node->token) {
+
+    case NJS_TOKEN_POST_INCREMENT:
+        node->token = NJS_TOKEN_INCREMENT;
+        node->u.operation = njs_vmcode_increment;
+        break;
+
+    case NJS_TOKEN_POST_DECREMENT:
+        node->token = NJS_TOKEN_DECREMENT;
+        node->u.operation = njs_vmcode_decrement;
+        break;
+
+    case NJS_TOKEN_INCREMENT:
+    case NJS_TOKEN_DECREMENT:
+        break;
+
+    default:
+        return;
+    }
+
+    node->dest = node->left;
+}
+
+
+static nxt_bool_t
+njs_generate_has_reference(njs_parser_node_t *node, const nxt_str_t *name)
+{
+    if (node == NULL) {
+        return 0;
+    }
+
+    if (node->token == NJS_TOKEN_NAME
+        && nxt_strstr_eq(&node->u.reference.name, name))
+    {
+        return 1;
+    }
+
+    return njs_generate_has_reference(node->left, name)
+           || njs_generate_has_reference(node->right, name);
+}
+
+
+/*
+ * A literal or a declared variable is evaluated without calling user
+ * code, such as valueOf() methods and getters, and cannot throw.
+ */
+
+static nxt_bool_t
+njs_generate_is_primary(njs_vm_t *vm, njs_parser_node_t *node)
+{
+    if (node->token >= NJS_TOKEN_FIRST_CONST
+        && node->token <= NJS_TOKEN_LAST_CONST)
+    {
+        return 1;
+    }
+
+    return (node->token == NJS_TOKEN_NAME
+            && njs_variable_typeof(vm, node) != NJS_INDEX_NONE);
+}
+
+
 static nxt_int_t
 njs_generate_reference_error(njs_vm_t *vm, njs_generator_t *generator,
                              njs_parser_node_t *node)
@@ -29,6 +29,7 @@ struct njs_generator_s {
 
 nxt_int_t njs_generate_scope(njs_vm_t *vm, njs_generator_t *generator,
     njs_parser_scope_t *scope, const nxt_str_t *name);
+nxt_int_t njs_generate_lambda(njs_vm_t *vm, njs_function_lambda_t *lambda);
 
 
 #endif /* _NJS_GENERATOR_H_INCLUDED_ */
@@ -0,0 +1,1084 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <string.h>
+#include <sys/mman.h>
+
+
+/*
+ * The baseline compiler translates the bytecode of a hot function to
+ * x86-64 machine code.  The code calls the same vmcode operations as the
+ * interpreter does, but decodes their operands inline and follows the
+ * returned offsets with native branches instead of the dispatch loop.
+ * The jumps, moves, number arithmetic and comparisons are compiled inline.
+ *
+ * The machine code returns to the interpreter on calls, returns, traps,
+ * exceptions and any other operation result it does not expect.  The
+ * interpreter completes the instruction as if it had executed it itself.
+ */
+
+
+typedef enum {
+    NJS_JIT_GENERIC = 0,
+    NJS_JIT_JUMP,
+    NJS_JIT_IF_TRUE_JUMP,
+    NJS_JIT_IF_FALSE_JUMP,
+    NJS_JIT_IF_EQUAL_JUMP,
+    NJS_JIT_TEST_IF_TRUE,
+    NJS_JIT_TEST_IF_FALSE,
+    NJS_JIT_MOVE,
+    NJS_JIT_ADDITION,
+    NJS_JIT_SUBSTRACTION,
+    NJS_JIT_MULTIPLICATION,
+    NJS_JIT_LESS,
+    NJS_JIT_LESS_OR_EQUAL,
+    NJS_JIT_GREATER,
+    NJS_JIT_GREATER_OR_EQUAL,
+} njs_jit_kind_t;
+
+
+typedef struct {
+    njs_vmcode_operation_t     operation;
+    uint8_t                    size;
+    uint8_t                    kind;
+} njs_jit_operation_t;
+
+
+/* The machine code returns the pair in the rax and rdx registers. */
+
+typedef struct {
+    njs_ret_t                  ret;
+    njs_vmcode_generic_t       *vmcode;
+} njs_jit_exit_t;
+
+
+typedef njs_jit_exit_t (*njs_jit_entry_t)(njs_vm_t *vm, u_char *entry);
+
+
+struct njs_jit_code_s {
+    njs_jit_code_t             *next;
+    size_t                     size;
+
+    u_char                     *start;
+    u_char                     *end;
+
+    /* The machine code offsets of the bytecode instructions. */
+    uint32_t                   *entries;
+
+    u_char                     *text;
+};
+
+
+typedef struct {
+    /* The offset of the rel32 field in the machine code. */
+    uint32_t                   from;
+
+    /* The bytecode offset of the jump target or the exiting instruction. */
+    uint32_t                   to;
+
+    uint8_t                    exit;      /* 1 bit */
+} njs_jit_patch_t;
+
+
+typedef struct {
+    u_char                     *p;
+    u_char                     *text;
+
+    njs_jit_patch_t            *patches;
+    nxt_uint_t                 npatches;
+
+    uint8_t                    failed;    /* 1 bit */
+} njs_jit_t;
+
+
+#define NJS_JIT_RAX            0
+#define NJS_JIT_RCX            1
+#define NJS_JIT_RDX            2
+#define NJS_JIT_RBX            3
+#define NJS_JIT_RSI            6
+#define NJS_JIT_RDI            7
+
+#define NJS_JIT_JMP            0x00
+#define NJS_JIT_JE             0x84
+#define NJS_JIT_JNE            0x85
+#define NJS_JIT_JA             0x87
+
+/* The bytecode instructions are aligned to the operation pointer size. */
+#define NJS_JIT_ALIGN          sizeof(njs_vmcode_operation_t)
+
+/* The maximum machine code size of an instruction and its exit stub. */
+#define NJS_JIT_CODE_MAX       384
+#define NJS_JIT_EXIT_MAX       16
+#define NJS_JIT_PATCHES        3
+
+#define NJS_JIT_NUMBER         offsetof(njs_value_t, data.u.number)
+#define NJS_JIT_TRUTH          offsetof(njs_value_t, data.truth)
+
+
+#define njs_jit_byte(jit, byte)                                               \
+    *(jit)->p++ = (u_char) (byte)
+
+
+static njs_jit_code_t *njs_jit_compile(njs_vm_t *vm,
+    njs_function_lambda_t *lambda);
+static const njs_jit_operation_t *njs_jit_operation(
+    njs_vmcode_operation_t operation);
+static void njs_jit_instruction(njs_jit_t *jit, const njs_jit_operation_t *op,
+    njs_vmcode_generic_t *vmcode, uint32_t offset);
+static void njs_jit_call(njs_jit_t *jit, njs_vmcode_generic_t *vmcode);
+static void njs_jit_result(njs_jit_t *jit, njs_vmcode_generic_t *vmcode,
+    uint32_t offset, size_t size);
+static void njs_jit_numbers(njs_jit_t *jit, njs_vmcode_3addr_t *code,
+    u_char **slow);
+static void njs_jit_operand(njs_jit_t *jit, nxt_uint_t reg,
+    njs_index_t index);
+static void njs_jit_copy(njs_jit_t *jit);
+static void njs_jit_truth(njs_jit_t *jit);
+static void njs_jit_cmp_rax(njs_jit_t *jit, njs_ret_t value);
+static void njs_jit_jump(njs_jit_t *jit, u_char cc, uint32_t to,
+    nxt_bool_t exit);
+static u_char *njs_jit_branch(njs_jit_t *jit, u_char cc);
+static void njs_jit_bind(njs_jit_t *jit, u_char *rel);
+static void njs_jit_vm_field(njs_jit_t *jit, u_char opcode, nxt_uint_t reg,
+    size_t offset);
+static void njs_jit_mov_imm(njs_jit_t *jit, nxt_uint_t reg, uint64_t value);
+static void njs_jit_imm32(njs_jit_t *jit, uint32_t value);
+
+
+static const njs_jit_operation_t  njs_jit_operations[] = {
+
+    { njs_vmcode_jump, sizeof(njs_vmcode_jump_t), NJS_JIT_JUMP },
+    { njs_vmcode_if_true_jump, sizeof(njs_vmcode_cond_jump_t),
+      NJS_JIT_IF_TRUE_JUMP },
+    { njs_vmcode_if_false_jump, sizeof(njs_vmcode_cond_jump_t),
+      NJS_JIT_IF_FALSE_JUMP },
+    { njs_vmcode_if_equal_jump, sizeof(njs_vmcode_equal_jump_t),
+      NJS_JIT_IF_EQUAL_JUMP },
+    { njs_vmcode_test_if_true, sizeof(njs_vmcode_test_jump_t),
+      NJS_JIT_TEST_IF_TRUE },
+    { njs_vmcode_test_if_false, sizeof(njs_vmcode_test_jump_t),
+      NJS_JIT_TEST_IF_FALSE },
+
+    { njs_vmcode_move, sizeof(njs_vmcode_move_t), NJS_JIT_MOVE },
+
+    { njs_vmcode_addition, sizeof(njs_vmcode_3addr_t), NJS_JIT_ADDITION },
+    { njs_vmcode_substraction, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_SUBSTRACTION },
+    { njs_vmcode_multiplication, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_MULTIPLICATION },
+
+    { njs_vmcode_less, sizeof(njs_vmcode_3addr_t), NJS_JIT_LESS },
+    { njs_vmcode_less_or_equal, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_LESS_OR_EQUAL },
+    { njs_vmcode_greater, sizeof(njs_vmcode_3addr_t), NJS_JIT_GREATER },
+    { njs_vmcode_greater_or_equal, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GREATER_OR_EQUAL },
+
+    { njs_vmcode_object, sizeof(njs_vmcode_object_t), NJS_JIT_GENERIC },
+    { njs_vmcode_array, sizeof(njs_vmcode_array_t), NJS_JIT_GENERIC },
+    { njs_vmcode_function, sizeof(njs_vmcode_function_t), NJS_JIT_GENERIC },
+    { njs_vmcode_this, sizeof(njs_vmcode_this_t), NJS_JIT_GENERIC },
+    { njs_vmcode_arguments, sizeof(njs_vmcode_arguments_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_regexp, sizeof(njs_vmcode_regexp_t), NJS_JIT_GENERIC },
+    { njs_vmcode_template_literal, sizeof(njs_vmcode_template_literal_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_object_copy, sizeof(njs_vmcode_object_copy_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_array_spread, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_object_spread, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_property_get, sizeof(njs_vmcode_prop_get_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_property_init, sizeof(njs_vmcode_prop_set_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_property_set, sizeof(njs_vmcode_prop_set_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_property_in, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_property_delete, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_property_foreach, sizeof(njs_vmcode_prop_foreach_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_property_next, sizeof(njs_vmcode_prop_next_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_value_foreach, sizeof(njs_vmcode_prop_foreach_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_value_next, sizeof(njs_vmcode_prop_next_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_instance_of, sizeof(njs_vmcode_instance_of_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_function_frame, sizeof(njs_vmcode_function_frame_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_method_frame, sizeof(njs_vmcode_method_frame_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_spread_frame, sizeof(njs_vmcode_spread_frame_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_function_call, sizeof(njs_vmcode_function_call_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_return, sizeof(njs_vmcode_return_t), NJS_JIT_GENERIC },
+    { njs_vmcode_stop, sizeof(njs_vmcode_stop_t), NJS_JIT_GENERIC },
+
+    { njs_vmcode_increment, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_decrement, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_post_increment, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_post_decrement, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_delete, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_void, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_typeof, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_unary_plus, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_unary_negation, sizeof(njs_vmcode_2addr_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_exponentiation, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_division, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_remainder, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_left_shift, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_right_shift, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_unsigned_right_shift, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_logical_not, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_bitwise_not, sizeof(njs_vmcode_2addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_bitwise_and, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_bitwise_xor, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_bitwise_or, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+
+    { njs_vmcode_equal, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_not_equal, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_strict_equal, sizeof(njs_vmcode_3addr_t), NJS_JIT_GENERIC },
+    { njs_vmcode_strict_not_equal, sizeof(njs_vmcode_3addr_t),
+      NJS_JIT_GENERIC },
+
+    { njs_vmcode_try_start, sizeof(njs_vmcode_try_start_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_try_break, sizeof(njs_vmcode_try_trampoline_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_try_continue, sizeof(njs_vmcode_try_trampoline_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_try_return, sizeof(njs_vmcode_try_return_t),
+      NJS_JIT_GENERIC },
+    { njs_vmcode_try_end, sizeof(njs_vmcode_try_end_t), NJS_JIT_GENERIC },
+    { njs_vmcode_catch, sizeof(njs_vmcode_catch_t), NJS_JIT_GENERIC },
+    { njs_vmcode_finally, sizeof(njs_vmcode_finally_t), NJS_JIT_GENERIC },
+    { njs_vmcode_throw, sizeof(njs_vmcode_throw_t), NJS_JIT_GENERIC },
+    { njs_vmcode_reference_error, sizeof(njs_vmcode_reference_error_t),
+      NJS_JIT_GENERIC },
+};
+
+
+/*
+ * Runs the machine code of the active function from vm->current.
+ * NXT_DECLINED is returned if the code is not available, otherwise
+ * the instruction the machine code has stopped at, its operands and
+ * the operation result are returned to complete the instruction.
+ */
+
+njs_ret_t
+njs_jit_run(njs_vm_t *vm, njs_vmcode_generic_t **vmcode, njs_value_t **value1,
+    njs_value_t **value2)
+{
+    size_t                 offset;
+    uint32_t               entry;
+    njs_jit_exit_t         exit;
+    njs_jit_code_t         *code;
+    njs_function_t         *function;
+    njs_vmcode_generic_t   *code2;
+    njs_function_lambda_t  *lambda;
+
+    /* The machine code does not count instructions and check time. */
+
+    if (vm->options.jit == 0 || vm->ops_limit != 0 || vm->timeout != 0) {
+        return NXT_DECLINED;
+    }
+
+    function = vm->active_frame->native.function;
+
+    if (function == NULL) {
+        return NXT_DECLINED;
+    }
+
+    lambda = function->u.lambda;
+
+    if (vm->current < lambda->start || vm->current >= lambda->end) {
+        /* Continuations and traps. */
+        return NXT_DECLINED;
+    }
+
+    code = lambda->jit;
+
+    if (code == NULL) {
+        if (lambda->jit_counter == (uint32_t) -1
+            || ++lambda->jit_counter < vm->options.jit)
+        {
+            return NXT_DECLINED;
+        }
+
+        code = njs_jit_compile(vm, lambda);
+
+        if (code == NULL) {
+            /* The function is not compiled again. */
+            lambda->jit_counter = (uint32_t) -1;
+            return NXT_DECLINED;
+        }
+
+        lambda->jit = code;
+    }
+
+    offset = vm->current - code->start;
+
+    if (offset % NJS_JIT_ALIGN != 0) {
+        return NXT_DECLINED;
+    }
+
+    entry = code->entries[offset / NJS_JIT_ALIGN];
+
+    if (entry == 0) {
+        return NXT_DECLINED;
+    }
+
+    exit = ((njs_jit_entry_t) code->text)(vm, code->text + entry);
+
+    code2 = exit.vmcode;
+
+    *vmcode = code2;
+    *value1 = NULL;
+    *value2 = (njs_value_t *) code2->operand1;
+
+    switch (code2->code.operands) {
+
+    case NJS_VMCODE_3OPERANDS:
+        *value2 = njs_vmcode_operand(vm, code2->operand3);
+
+        /* Fall through. */
+
+    case NJS_VMCODE_2OPERANDS:
+        *value1 = njs_vmcode_operand(vm, code2->operand2);
+    }
+
+    return exit.ret;
+}
+
+
+void
+njs_jit_destroy(njs_vm_shared_t *shared)
+{
+    njs_jit_code_t  *code, *next;
+
+    for (code = shared->jit; code != NULL; code = next) {
+        next = code->next;
+        (void) munmap(code, code->size);
+    }
+
+    shared->jit = NULL;
+}
+
+
+static njs_jit_code_t *
+njs_jit_compile(njs_vm_t *vm, njs_function_lambda_t *lambda)
+{
+    u_char                     *p, *map, *limit, *target;
+    size_t                     size, header, text_size;
+    int32_t                    rel;
+    uint32_t                   offset, epilogue;
+    nxt_uint_t                 i, n, count;
+    njs_jit_t                  jit;
+    njs_jit_code_t             *code;
+    njs_jit_patch_t            *patch;
+    const njs_jit_operation_t  *op;
+
+    if (lambda->start == NULL || sizeof(njs_value_t) != 16) {
+        return NULL;
+    }
+
+    count = 0;
+
+    for (p = lambda->start; p < lambda->end; p += op->size) {
+        op = njs_jit_operation(*(njs_vmcode_operation_t *) p);
+        if (op == NULL) {
+            return NULL;
+        }
+
+        count++;
+    }
+
+    n = (lambda->end - lambda->start) / NJS_JIT_ALIGN;
+
+    header = nxt_align_size(sizeof(njs_jit_code_t) + n * sizeof(uint32_t),
+                            16);
+    text_size = 64 + count * (NJS_JIT_CODE_MAX
+                              + NJS_JIT_PATCHES * NJS_JIT_EXIT_MAX);
+    size = header + text_size;
+
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON,
+               -1, 0);
+    if (nxt_slow_path(map == MAP_FAILED)) {
+        return NULL;
+    }
+
+    jit.patches = nxt_mp_alloc(vm->mem_pool,
+                               count * NJS_JIT_PATCHES
+                               * sizeof(njs_jit_patch_t));
+    if (nxt_slow_path(jit.patches == NULL)) {
+        (void) munmap(map, size);
+        return NULL;
+    }
+
+    code = (njs_jit_code_t *) map;
+
+    code->size = size;
+    code->start = lambda->start;
+    code->end = lambda->end;
+    code->entries = (uint32_t *) (map + sizeof(njs_jit_code_t));
+    code->text = map + header;
+
+    jit.p = code->text;
+    jit.text = code->text;
+    jit.npatches = 0;
+    jit.failed = 0;
+
+    /*
+     * The entry: the vm is kept in the callee-saved rbx register,
+     * the stack is aligned to 16 bytes for the operation calls.
+     *
+     *   push  rbx
+     *   mov   rbx, rdi
+     *   jmp   rsi
+     */
+
+    njs_jit_byte(&jit, 0x53);
+    njs_jit_byte(&jit, 0x48);
+    njs_jit_byte(&jit, 0x89);
+    njs_jit_byte(&jit, 0xfb);
+    njs_jit_byte(&jit, 0xff);
+    njs_jit_byte(&jit, 0xe6);
+
+    /*
+     * The exit: the operation result is in rax and the instruction in rdx.
+     *
+     *   pop   rbx
+     *   ret
+     */
+
+    epilogue = jit.p - jit.text;
+
+    njs_jit_byte(&jit, 0x5b);
+    njs_jit_byte(&jit, 0xc3);
+
+    limit = jit.text + count * NJS_JIT_CODE_MAX;
+
+    for (p = lambda->start; p < lambda->end; p += op->size) {
+        op = njs_jit_operation(*(njs_vmcode_operation_t *) p);
+        offset = p - lambda->start;
+
+        code->entries[offset / NJS_JIT_ALIGN] = jit.p - jit.text;
+
+        njs_jit_instruction(&jit, op, (njs_vmcode_generic_t *) p, offset);
+
+        if (nxt_slow_path(jit.p > limit)) {
+            goto failed;
+        }
+    }
+
+    /* The code never runs past the last instruction which returns.  ud2 */
+
+    njs_jit_byte(&jit, 0x0f);
+    njs_jit_byte(&jit, 0x0b);
+
+    /* The jump targets and the exit stubs. */
+
+    for (i = 0; i < jit.npatches; i++) {
+        patch = &jit.patches[i];
+
+        if (patch->exit) {
+            target = jit.p;
+
+            /*
+             *   mov   rdx, vmcode
+             *   jmp   exit
+             */
+
+            njs_jit_mov_imm(&jit, NJS_JIT_RDX,
+                            (uintptr_t) (lambda->start + patch->to));
+            njs_jit_byte(&jit, 0xe9);
+            njs_jit_imm32(&jit, epilogue - (jit.p + 4 - jit.text));
+
+        } else {
+            if (patch->to >= (uint32_t) (lambda->end - lambda->start)
+                || patch->to % NJS_JIT_ALIGN != 0
+                || code->entries[patch->to / NJS_JIT_ALIGN] == 0)
+            {
+                goto failed;
+            }
+
+            target = jit.text + code->entries[patch->to / NJS_JIT_ALIGN];
+        }
+
+        rel = target - (jit.text + patch->from + 4);
+        memcpy(jit.text + patch->from, &rel, sizeof(int32_t));
+    }
+
+    if (jit.failed) {
+        goto failed;
+    }
+
+    nxt_mp_free(vm->mem_pool, jit.patches);
+
+    code->next = vm->shared->jit;
+    vm->shared->jit = code;
+
+    if (nxt_slow_path(mprotect(map, size, PROT_READ | PROT_EXEC) != 0)) {
+        vm->shared->jit = code->next;
+        (void) munmap(map, size);
+        return NULL;
+    }
+
+    return code;
+
+failed:
+
+    nxt_mp_free(vm->mem_pool, jit.patches);
+    (void) munmap(map, size);
+
+    return NULL;
+}
+
+
+static const njs_jit_operation_t *
+njs_jit_operation(njs_vmcode_operation_t operation)
+{
+    nxt_uint_t  i;
+
+    for (i = 0; i < nxt_nitems(njs_jit_operations); i++) {
+        if (njs_jit_operations[i].operation == operation) {
+            return &njs_jit_operations[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+njs_jit_instruction(njs_jit_t *jit, const njs_jit_operation_t *op,
+    njs_vmcode_generic_t *vmcode, uint32_t offset)
+{
+    u_char                   *slow[2], *done;
+    njs_vmcode_move_t        *move;
+    njs_vmcode_jump_t        *jump;
+    njs_vmcode_3addr_t       *code3;
+    njs_vmcode_cond_jump_t   *cond;
+    njs_vmcode_test_jump_t   *test;
+    njs_vmcode_equal_jump_t  *equal;
+
+    switch (op->kind) {
+
+    case NJS_JIT_JUMP:
+        jump = (njs_vmcode_jump_t *) vmcode;
+        njs_jit_jump(jit, NJS_JIT_JMP, offset + jump->offset, 0);
+        break;
+
+    case NJS_JIT_IF_TRUE_JUMP:
+    case NJS_JIT_IF_FALSE_JUMP:
+        cond = (njs_vmcode_cond_jump_t *) vmcode;
+
+        njs_jit_operand(jit, NJS_JIT_RSI, cond->cond);
+        njs_jit_truth(jit);
+        njs_jit_jump(jit, (op->kind == NJS_JIT_IF_TRUE_JUMP) ? NJS_JIT_JNE
+                                                             : NJS_JIT_JE,
+                     offset + cond->offset, 0);
+        break;
+
+    case NJS_JIT_TEST_IF_TRUE:
+    case NJS_JIT_TEST_IF_FALSE:
+        test = (njs_vmcode_test_jump_t *) vmcode;
+
+        njs_jit_operand(jit, NJS_JIT_RSI, test->value);
+        njs_jit_operand(jit, NJS_JIT_RDI, test->retval);
+        njs_jit_copy(jit);
+        njs_jit_truth(jit);
+        njs_jit_jump(jit, (op->kind == NJS_JIT_TEST_IF_TRUE) ? NJS_JIT_JNE
+                                                             : NJS_JIT_JE,
+                     offset + test->offset, 0);
+        break;
+
+    case NJS_JIT_IF_EQUAL_JUMP:
+        equal = (njs_vmcode_equal_jump_t *) vmcode;
+
+        njs_jit_call(jit, vmcode);
+        njs_jit_cmp_rax(jit, equal->offset);
+        njs_jit_jump(jit, NJS_JIT_JE, offset + equal->offset, 0);
+        njs_jit_result(jit, vmcode, offset, op->size);
+        break;
+
+    case NJS_JIT_MOVE:
+        move = (njs_vmcode_move_t *) vmcode;
+
+        njs_jit_operand(jit, NJS_JIT_RSI, move->src);
+        njs_jit_operand(jit, NJS_JIT_RDI, move->dst);
+        njs_jit_copy(jit);
+        break;
+
+    case NJS_JIT_ADDITION:
+    case NJS_JIT_SUBSTRACTION:
+    case NJS_JIT_MULTIPLICATION:
+        code3 = (njs_vmcode_3addr_t *) vmcode;
+
+        njs_jit_numbers(jit, code3, slow);
+
+        /* movsd  xmm0, [rsi + number] */
+
+        njs_jit_byte(jit, 0xf2);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x10);
+        njs_jit_byte(jit, 0x46);
+        njs_jit_byte(jit, NJS_JIT_NUMBER);
+
+        /* addsd, subsd, mulsd  xmm0, [rdx + number] */
+
+        njs_jit_byte(jit, 0xf2);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, (op->kind == NJS_JIT_ADDITION) ? 0x58
+                          : (op->kind == NJS_JIT_SUBSTRACTION) ? 0x5c : 0x59);
+        njs_jit_byte(jit, 0x42);
+        njs_jit_byte(jit, NJS_JIT_NUMBER);
+
+        njs_jit_operand(jit, NJS_JIT_RDI, code3->dst);
+
+        /* mov  byte [rdi], NJS_NUMBER */
+
+        njs_jit_byte(jit, 0xc6);
+        njs_jit_byte(jit, 0x07);
+        njs_jit_byte(jit, NJS_NUMBER);
+
+        /* movsd  [rdi + number], xmm0 */
+
+        njs_jit_byte(jit, 0xf2);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x11);
+        njs_jit_byte(jit, 0x47);
+        njs_jit_byte(jit, NJS_JIT_NUMBER);
+
+        /*
+         * The number is true unless it is zero or NaN:
+         *
+         *   xorpd    xmm1, xmm1
+         *   ucomisd  xmm0, xmm1
+         *   setne    al
+         *   mov      [rdi + truth], al
+         */
+
+        njs_jit_byte(jit, 0x66);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x57);
+        njs_jit_byte(jit, 0xc9);
+        njs_jit_byte(jit, 0x66);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x2e);
+        njs_jit_byte(jit, 0xc1);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x95);
+        njs_jit_byte(jit, 0xc0);
+        njs_jit_byte(jit, 0x88);
+        njs_jit_byte(jit, 0x47);
+        njs_jit_byte(jit, NJS_JIT_TRUTH);
+
+        done = njs_jit_branch(jit, NJS_JIT_JMP);
+
+        njs_jit_bind(jit, slow[0]);
+        njs_jit_bind(jit, slow[1]);
+
+        njs_jit_call(jit, vmcode);
+        njs_jit_result(jit, vmcode, offset, op->size);
+
+        njs_jit_bind(jit, done);
+        break;
+
+    case NJS_JIT_LESS:
+    case NJS_JIT_LESS_OR_EQUAL:
+    case NJS_JIT_GREATER:
+    case NJS_JIT_GREATER_OR_EQUAL:
+        code3 = (njs_vmcode_3addr_t *) vmcode;
+
+        njs_jit_numbers(jit, code3, slow);
+
+        /*
+         *   movsd  xmm0, [rsi + number]
+         *   movsd  xmm1, [rdx + number]
+         */
+
+        njs_jit_byte(jit, 0xf2);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x10);
+        njs_jit_byte(jit, 0x46);
+        njs_jit_byte(jit, NJS_JIT_NUMBER);
+        njs_jit_byte(jit, 0xf2);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x10);
+        njs_jit_byte(jit, 0x4a);
+        njs_jit_byte(jit, NJS_JIT_NUMBER);
+
+        /*
+         * The "above" conditions are false for NaN:
+         *
+         *   ucomisd  xmm1, xmm0  for less
+         *   ucomisd  xmm0, xmm1  for greater
+         */
+
+        njs_jit_byte(jit, 0x66);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x2e);
+        njs_jit_byte(jit, (op->kind == NJS_JIT_LESS
+                           || op->kind == NJS_JIT_LESS_OR_EQUAL) ? 0xc8
+                                                                 : 0xc1);
+
+        njs_jit_mov_imm(jit, NJS_JIT_RAX, (uintptr_t) &njs_value_false);
+        njs_jit_mov_imm(jit, NJS_JIT_RCX, (uintptr_t) &njs_value_true);
+
+        /* cmova, cmovae  rax, rcx */
+
+        njs_jit_byte(jit, 0x48);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, (op->kind == NJS_JIT_LESS
+                           || op->kind == NJS_JIT_GREATER) ? 0x47 : 0x43);
+        njs_jit_byte(jit, 0xc1);
+
+        njs_jit_operand(jit, NJS_JIT_RDI, code3->dst);
+
+        /*
+         *   movdqu  xmm0, [rax]
+         *   movdqu  [rdi], xmm0
+         */
+
+        njs_jit_byte(jit, 0xf3);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x6f);
+        njs_jit_byte(jit, 0x00);
+        njs_jit_byte(jit, 0xf3);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x7f);
+        njs_jit_byte(jit, 0x07);
+
+        done = njs_jit_branch(jit, NJS_JIT_JMP);
+
+        njs_jit_bind(jit, slow[0]);
+        njs_jit_bind(jit, slow[1]);
+
+        njs_jit_call(jit, vmcode);
+        njs_jit_result(jit, vmcode, offset, op->size);
+
+        njs_jit_bind(jit, done);
+        break;
+
+    default:
+        njs_jit_call(jit, vmcode);
+        njs_jit_result(jit, vmcode, offset, op->size);
+        break;
+    }
+}
+
+
+/*
+ * Calls the operation with the operands decoded in the same way
+ * as njs_vmcode_interpreter() does.
+ */
+
+static void
+njs_jit_call(njs_jit_t *jit, njs_vmcode_generic_t *vmcode)
+{
+    /*
+     *   mov  rax, vmcode
+     *   mov  [rbx + current], rax
+     */
+
+    njs_jit_mov_imm(jit, NJS_JIT_RAX, (uintptr_t) vmcode);
+    njs_jit_vm_field(jit, 0x89, NJS_JIT_RAX, offsetof(njs_vm_t, current));
+
+    switch (vmcode->code.operands) {
+
+    case NJS_VMCODE_3OPERANDS:
+        njs_jit_operand(jit, NJS_JIT_RDX, vmcode->operand3);
+        njs_jit_operand(jit, NJS_JIT_RSI, vmcode->operand2);
+        break;
+
+    case NJS_VMCODE_2OPERANDS:
+        njs_jit_mov_imm(jit, NJS_JIT_RDX, vmcode->operand1);
+        njs_jit_operand(jit, NJS_JIT_RSI, vmcode->operand2);
+        break;
+
+    default:
+        njs_jit_mov_imm(jit, NJS_JIT_RDX, vmcode->operand1);
+
+        /* xor  esi, esi */
+
+        njs_jit_byte(jit, 0x31);
+        njs_jit_byte(jit, 0xf6);
+        break;
+    }
+
+    /*
+     *   mov   rdi, rbx
+     *   mov   rax, operation
+     *   call  rax
+     */
+
+    njs_jit_byte(jit, 0x48);
+    njs_jit_byte(jit, 0x89);
+    njs_jit_byte(jit, 0xdf);
+
+    njs_jit_mov_imm(jit, NJS_JIT_RAX, (uintptr_t) vmcode->code.operation);
+
+    njs_jit_byte(jit, 0xff);
+    njs_jit_byte(jit, 0xd0);
+}
+
+
+static void
+njs_jit_result(njs_jit_t *jit, njs_vmcode_generic_t *vmcode, uint32_t offset,
+    size_t size)
+{
+    njs_jit_cmp_rax(jit, size);
+    njs_jit_jump(jit, NJS_JIT_JNE, offset, 1);
+
+    if (vmcode->code.retval) {
+        njs_jit_operand(jit, NJS_JIT_RDI, vmcode->operand1);
+
+        /*
+         *   movdqu  xmm0, [rbx + retval]
+         *   movdqu  [rdi], xmm0
+         */
+
+        njs_jit_byte(jit, 0xf3);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x6f);
+        njs_jit_byte(jit, 0x83);
+        njs_jit_imm32(jit, offsetof(njs_vm_t, retval));
+
+        njs_jit_byte(jit, 0xf3);
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, 0x7f);
+        njs_jit_byte(jit, 0x07);
+    }
+}
+
+
+/*
+ * Loads the source operands to rsi and rdx and branches to the slow
+ * path unless both of them are numeric, see njs_is_numeric().
+ */
+
+static void
+njs_jit_numbers(njs_jit_t *jit, njs_vmcode_3addr_t *code, u_char **slow)
+{
+    njs_jit_operand(jit, NJS_JIT_RSI, code->src1);
+    njs_jit_operand(jit, NJS_JIT_RDX, code->src2);
+
+    /*
+     *   cmp  byte [rsi], NJS_NUMBER
+     *   ja   slow
+     *   cmp  byte [rdx], NJS_NUMBER
+     *   ja   slow
+     */
+
+    njs_jit_byte(jit, 0x80);
+    njs_jit_byte(jit, 0x3e);
+    njs_jit_byte(jit, NJS_NUMBER);
+    slow[0] = njs_jit_branch(jit, NJS_JIT_JA);
+
+    njs_jit_byte(jit, 0x80);
+    njs_jit_byte(jit, 0x3a);
+    njs_jit_byte(jit, NJS_NUMBER);
+    slow[1] = njs_jit_branch(jit, NJS_JIT_JA);
+}
+
+
+/* Loads the address of the operand to the register. */
+
+static void
+njs_jit_operand(njs_jit_t *jit, nxt_uint_t reg, njs_index_t index)
+{
+    uintptr_t  scope, offset;
+
+    scope = njs_scope_type(index);
+    offset = njs_scope_offset(index);
+
+    if (scope == NJS_SCOPE_ABSOLUTE) {
+        /* The absolute scope base is NULL. */
+        njs_jit_mov_imm(jit, reg, offset);
+        return;
+    }
+
+    if (nxt_slow_path(offset > INT32_MAX)) {
+        jit->failed = 1;
+        return;
+    }
+
+    /* mov  reg, [rbx + scopes[scope]] */
+
+    njs_jit_vm_field(jit, 0x8b, reg,
+                     offsetof(njs_vm_t, scopes) + scope * sizeof(void *));
+
+    if (offset != 0) {
+
+        /* add  reg, offset */
+
+        njs_jit_byte(jit, 0x48);
+        njs_jit_byte(jit, 0x81);
+        njs_jit_byte(jit, 0xc0 | reg);
+        njs_jit_imm32(jit, offset);
+    }
+}
+
+
+/* Copies the value from rsi to rdi. */
+
+static void
+njs_jit_copy(njs_jit_t *jit)
+{
+    /*
+     *   movdqu  xmm0, [rsi]
+     *   movdqu  [rdi], xmm0
+     */
+
+    njs_jit_byte(jit, 0xf3);
+    njs_jit_byte(jit, 0x0f);
+    njs_jit_byte(jit, 0x6f);
+    njs_jit_byte(jit, 0x06);
+    njs_jit_byte(jit, 0xf3);
+    njs_jit_byte(jit, 0x0f);
+    njs_jit_byte(jit, 0x7f);
+    njs_jit_byte(jit, 0x07);
+}
+
+
+/* Tests the truth of the value in rsi, see njs_is_true(). */
+
+static void
+njs_jit_truth(njs_jit_t *jit)
+{
+    /* cmp  byte [rsi + truth], 0 */
+
+    njs_jit_byte(jit, 0x80);
+    njs_jit_byte(jit, 0x7e);
+    njs_jit_byte(jit, NJS_JIT_TRUTH);
+    njs_jit_byte(jit, 0x00);
+}
+
+
+static void
+njs_jit_cmp_rax(njs_jit_t *jit, njs_ret_t value)
+{
+    if (nxt_slow_path(value < INT32_MIN || value > INT32_MAX)) {
+        jit->failed = 1;
+        return;
+    }
+
+    /* cmp  rax, imm32 */
+
+    njs_jit_byte(jit, 0x48);
+    njs_jit_byte(jit, 0x3d);
+    njs_jit_imm32(jit, (uint32_t) value);
+}
+
+
+/*
+ * Jumps to a bytecode instruction or to the exit stub of an instruction,
+ * the rel32 displacement is set after all instructions are compiled.
+ */
+
+static void
+njs_jit_jump(njs_jit_t *jit, u_char cc, uint32_t to, nxt_bool_t exit)
+{
+    njs_jit_patch_t  *patch;
+
+    if (cc == NJS_JIT_JMP) {
+        njs_jit_byte(jit, 0xe9);
+
+    } else {
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, cc);
+    }
+
+    patch = &jit->patches[jit->npatches++];
+
+    patch->from = jit->p - jit->text;
+    patch->to = to;
+    patch->exit = exit;
+
+    njs_jit_imm32(jit, 0);
+}
+
+
+/* A forward branch within the instruction code. */
+
+static u_char *
+njs_jit_branch(njs_jit_t *jit, u_char cc)
+{
+    u_char  *rel;
+
+    if (cc == NJS_JIT_JMP) {
+        njs_jit_byte(jit, 0xe9);
+
+    } else {
+        njs_jit_byte(jit, 0x0f);
+        njs_jit_byte(jit, cc);
+    }
+
+    rel = jit->p;
+
+    njs_jit_imm32(jit, 0);
+
+    return rel;
+}
+
+
+static void
+njs_jit_bind(njs_jit_t *jit, u_char *rel)
+{
+    int32_t  value;
+
+    value = jit->p - (rel + 4);
+
+    memcpy(rel, &value, sizeof(int32_t));
+}
+
+
+/* mov  reg, [rbx + offset]  or  mov  [rbx + offset], reg */
+
+static void
+njs_jit_vm_field(njs_jit_t *jit, u_char opcode, nxt_uint_t reg, size_t offset)
+{
+    njs_jit_byte(jit, 0x48);
+    njs_jit_byte(jit, opcode);
+    njs_jit_byte(jit, 0x80 | (reg << 3) | NJS_JIT_RBX);
+    njs_jit_imm32(jit, offset);
+}
+
+
+/* mov  reg, imm64 */
+
+static void
+njs_jit_mov_imm(njs_jit_t *jit, nxt_uint_t reg, uint64_t value)
+{
+    njs_jit_byte(jit, 0x48);
+    njs_jit_byte(jit, 0xb8 + reg);
+
+    memcpy(jit->p, &value, sizeof(uint64_t));
+    jit->p += sizeof(uint64_t);
+}
+
+
+static void
+njs_jit_imm32(njs_jit_t *jit, uint32_t value)
+{
+    memcpy(jit->p, &value, sizeof(uint32_t));
+    jit->p += sizeof(uint32_t);
+}
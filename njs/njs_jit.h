@@ -0,0 +1,22 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_JIT_H_INCLUDED_
+#define _NJS_JIT_H_INCLUDED_
+
+
+/*
+ * The default number of calls and loop iterations of a function
+ * before it is compiled to machine code.
+ */
+#define NJS_JIT_THRESHOLD      1000
+
+
+njs_ret_t njs_jit_run(njs_vm_t *vm, njs_vmcode_generic_t **vmcode,
+    njs_value_t **value1, njs_value_t **value2);
+void njs_jit_destroy(njs_vm_shared_t *shared);
+
+
+#endif /* _NJS_JIT_H_INCLUDED_ */
@@ -499,9 +499,9 @@ njs_json_parse_object(njs_json_parse_ctx_t *ctx, njs_value_t *value,
         lhq.pool = ctx->pool;
         lhq.proto = &njs_object_hash_proto;
 
-        ret = nxt_lvlhsh_insert(&object->hash, &lhq);
+        ret = nxt_flathsh_insert(&object->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(ctx->vm, "lvlhsh insert/replace failed");
+            njs_lvlhsh_insert_error(ctx->vm, ret);
             return NULL;
         }
 
@@ -939,7 +939,7 @@ njs_json_skip_space(const u_char *start, const u_char *end)
 
 #define njs_json_is_non_empty(_value)                                         \
     (((_value)->type == NJS_OBJECT)                                           \
-      && !nxt_lvlhsh_is_empty(&(_value)->data.u.object->hash))                \
+      && !nxt_flathsh_is_empty(&(_value)->data.u.object->hash))               \
      || (((_value)->type == NJS_ARRAY) && (_value)->data.u.array->length != 0)
 
 
@@ -966,7 +966,7 @@ njs_json_parse_continuation(njs_vm_t *vm, njs_value_t *args, nxt_uint_t unused,
                 lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
                 lhq.proto = &njs_object_hash_proto;
 
-                ret = nxt_lvlhsh_find(&state->value.data.u.object->hash, &lhq);
+                ret = nxt_flathsh_find(&state->value.data.u.object->hash, &lhq);
                 if (nxt_slow_path(ret == NXT_DECLINED)) {
                     state->index++;
                     break;
@@ -1010,7 +1010,7 @@ njs_json_parse_continuation(njs_vm_t *vm, njs_value_t *args, nxt_uint_t unused,
             lhq.pool = vm->mem_pool;
 
             if (njs_is_undefined(&parse->retval)) {
-                ret = nxt_lvlhsh_delete(&state->value.data.u.object->hash,
+                ret = nxt_flathsh_delete(&state->value.data.u.object->hash,
                                         &lhq);
 
             } else {
@@ -1020,12 +1020,12 @@ njs_json_parse_continuation(njs_vm_t *vm, njs_value_t *args, nxt_uint_t unused,
                 }
 
                 lhq.value = prop;
-                ret = nxt_lvlhsh_insert(&state->value.data.u.object->hash,
+                ret = nxt_flathsh_insert(&state->value.data.u.object->hash,
                                         &lhq);
             }
 
             if (nxt_slow_path(ret != NXT_OK)) {
-                njs_internal_error(vm, "lvlhsh insert/replace failed");
+                njs_lvlhsh_insert_error(vm, ret);
                 return NXT_ERROR;
             }
 
@@ -1270,7 +1270,7 @@ njs_json_stringify_continuation(njs_vm_t *vm, njs_value_t *args,
             lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
             lhq.proto = &njs_object_hash_proto;
 
-            ret = nxt_lvlhsh_find(&state->value.data.u.object->hash, &lhq);
+            ret = nxt_flathsh_find(&state->value.data.u.object->hash, &lhq);
             if (nxt_slow_path(ret == NXT_DECLINED)) {
                 break;
             }
@@ -1953,7 +1953,7 @@ njs_json_wrap_value(njs_vm_t *vm, const njs_value_t *value)
 
     lhq.value = prop;
 
-    ret = nxt_lvlhsh_insert(&wrapper->data.u.object->hash, &lhq);
+    ret = nxt_flathsh_insert(&wrapper->data.u.object->hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
         return NULL;
     }
@@ -2469,9 +2469,9 @@ njs_vm_value_dump(njs_vm_t *vm, nxt_str_t *retval, const njs_value_t *value,
                 object = state->value.data.u.object;
                 lhq.proto = &njs_object_hash_proto;
 
-                ret = nxt_lvlhsh_find(&object->hash, &lhq);
+                ret = nxt_flathsh_find(&object->hash, &lhq);
                 if (ret == NXT_DECLINED) {
-                    ret = nxt_lvlhsh_find(&object->shared_hash, &lhq);
+                    ret = nxt_flathsh_find(&object->shared_hash, &lhq);
                     if (nxt_slow_path(ret == NXT_DECLINED)) {
                         break;
                     }
@@ -102,6 +102,7 @@ typedef enum {
     NJS_TOKEN_NEW,
     NJS_TOKEN_DELETE,
     NJS_TOKEN_YIELD,
+    NJS_TOKEN_AWAIT,
 
     NJS_TOKEN_DIGIT,
     NJS_TOKEN_LETTER,
@@ -127,6 +128,8 @@ typedef enum {
     NJS_TOKEN_PROPERTY_DELETE,
 
     NJS_TOKEN_ARRAY,
+    NJS_TOKEN_DESTRUCTURING,
+    NJS_TOKEN_REST,
 
     NJS_TOKEN_GRAVE,
     NJS_TOKEN_TEMPLATE_LITERAL,
@@ -152,6 +155,7 @@ typedef enum {
     NJS_TOKEN_DO,
     NJS_TOKEN_FOR,
     NJS_TOKEN_FOR_IN,
+    NJS_TOKEN_FOR_OF,
     NJS_TOKEN_BREAK,
     NJS_TOKEN_CONTINUE,
     NJS_TOKEN_SWITCH,
@@ -183,6 +187,22 @@ typedef enum {
     NJS_TOKEN_FUNCTION_CONSTRUCTOR,
     NJS_TOKEN_REGEXP_CONSTRUCTOR,
     NJS_TOKEN_DATE_CONSTRUCTOR,
+    NJS_TOKEN_PROMISE_CONSTRUCTOR,
+    NJS_TOKEN_ARRAY_BUFFER_CONSTRUCTOR,
+    NJS_TOKEN_DATA_VIEW_CONSTRUCTOR,
+    NJS_TOKEN_INT8_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_UINT8_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_UINT8_CLAMPED_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_INT16_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_UINT16_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_INT32_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_UINT32_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_FLOAT32_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_FLOAT64_ARRAY_CONSTRUCTOR,
+    NJS_TOKEN_MAP_CONSTRUCTOR,
+    NJS_TOKEN_SET_CONSTRUCTOR,
+    NJS_TOKEN_WEAK_MAP_CONSTRUCTOR,
+    NJS_TOKEN_WEAK_SET_CONSTRUCTOR,
     NJS_TOKEN_ERROR_CONSTRUCTOR,
     NJS_TOKEN_EVAL_ERROR_CONSTRUCTOR,
     NJS_TOKEN_INTERNAL_ERROR_CONSTRUCTOR,
@@ -209,6 +229,8 @@ typedef enum {
     NJS_TOKEN_SET_TIMEOUT,
     NJS_TOKEN_SET_IMMEDIATE,
     NJS_TOKEN_CLEAR_TIMEOUT,
+    NJS_TOKEN_SET_INTERVAL,
+    NJS_TOKEN_CLEAR_INTERVAL,
 
     NJS_TOKEN_IMPORT,
     NJS_TOKEN_FROM,
@@ -28,6 +28,7 @@ static const njs_keyword_t  njs_keywords[] = {
     { nxt_string("new"),           NJS_TOKEN_NEW, 0 },
     { nxt_string("delete"),        NJS_TOKEN_DELETE, 0 },
     { nxt_string("yield"),         NJS_TOKEN_YIELD, 0 },
+    { nxt_string("await"),         NJS_TOKEN_AWAIT, 0 },
 
     /* Statements. */
 
@@ -69,6 +70,23 @@ static const njs_keyword_t  njs_keywords[] = {
     { nxt_string("Function"),      NJS_TOKEN_FUNCTION_CONSTRUCTOR, 0 },
     { nxt_string("RegExp"),        NJS_TOKEN_REGEXP_CONSTRUCTOR, 0 },
     { nxt_string("Date"),          NJS_TOKEN_DATE_CONSTRUCTOR, 0 },
+    { nxt_string("Promise"),       NJS_TOKEN_PROMISE_CONSTRUCTOR, 0 },
+    { nxt_string("ArrayBuffer"),   NJS_TOKEN_ARRAY_BUFFER_CONSTRUCTOR, 0 },
+    { nxt_string("DataView"),      NJS_TOKEN_DATA_VIEW_CONSTRUCTOR, 0 },
+    { nxt_string("Int8Array"),     NJS_TOKEN_INT8_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Uint8Array"),    NJS_TOKEN_UINT8_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Uint8ClampedArray"),
+      NJS_TOKEN_UINT8_CLAMPED_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Int16Array"),    NJS_TOKEN_INT16_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Uint16Array"),   NJS_TOKEN_UINT16_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Int32Array"),    NJS_TOKEN_INT32_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Uint32Array"),   NJS_TOKEN_UINT32_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Float32Array"),  NJS_TOKEN_FLOAT32_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Float64Array"),  NJS_TOKEN_FLOAT64_ARRAY_CONSTRUCTOR, 0 },
+    { nxt_string("Map"),           NJS_TOKEN_MAP_CONSTRUCTOR, 0 },
+    { nxt_string("Set"),           NJS_TOKEN_SET_CONSTRUCTOR, 0 },
+    { nxt_string("WeakMap"),       NJS_TOKEN_WEAK_MAP_CONSTRUCTOR, 0 },
+    { nxt_string("WeakSet"),       NJS_TOKEN_WEAK_SET_CONSTRUCTOR, 0 },
     { nxt_string("Error"),         NJS_TOKEN_ERROR_CONSTRUCTOR, 0 },
     { nxt_string("EvalError"),     NJS_TOKEN_EVAL_ERROR_CONSTRUCTOR, 0 },
     { nxt_string("InternalError"), NJS_TOKEN_INTERNAL_ERROR_CONSTRUCTOR, 0 },
@@ -93,6 +111,8 @@ static const njs_keyword_t  njs_keywords[] = {
     { nxt_string("setTimeout"),    NJS_TOKEN_SET_TIMEOUT, 0 },
     { nxt_string("setImmediate"),  NJS_TOKEN_SET_IMMEDIATE, 0 },
     { nxt_string("clearTimeout"),  NJS_TOKEN_CLEAR_TIMEOUT, 0 },
+    { nxt_string("setInterval"),   NJS_TOKEN_SET_INTERVAL, 0 },
+    { nxt_string("clearInterval"), NJS_TOKEN_CLEAR_INTERVAL, 0 },
 
     /* Module. */
     { nxt_string("import"),        NJS_TOKEN_IMPORT, 0 },
@@ -101,7 +121,6 @@ static const njs_keyword_t  njs_keywords[] = {
 
     /* Reserved words. */
 
-    { nxt_string("await"),         NJS_TOKEN_RESERVED, 0 },
     { nxt_string("class"),         NJS_TOKEN_RESERVED, 0 },
     { nxt_string("const"),         NJS_TOKEN_RESERVED, 0 },
     { nxt_string("debugger"),      NJS_TOKEN_RESERVED, 0 },
@@ -0,0 +1,1763 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <njs_map.h>
+#include <string.h>
+#include <math.h>
+
+
+/*
+ * Map, Set, WeakMap and WeakSet are object values holding njs_map_t.
+ * The data values are tagged with the magic like promises.  The entries
+ * are stored in an array in the insertion order and the flat hash maps
+ * the keys to the entry indices.  A deleted entry is marked with the
+ * invalid key and is left in place, so forEach() iterates the array by
+ * index and visits the entries added during the iteration.
+ *
+ * When the array is full it is compacted if it has deleted entries and
+ * is not iterated by an active forEach() call, otherwise it grows twice.
+ *
+ * The keys are compared with SameValueZero: NaN is equal to NaN and
+ * -0 is stored as +0.  The objects are not reclaimed by the VM, so the
+ * weak collections hold their keys as the other ones but accept only
+ * objects as keys and cannot be iterated.
+ */
+
+#define NJS_MAP_MAGIC            0x6d61
+#define NJS_SET_MAGIC            0x7365
+#define NJS_WEAK_MAP_MAGIC       0x776d
+#define NJS_WEAK_SET_MAGIC       0x7773
+
+#define NJS_MAP_MIN_SIZE         8
+#define NJS_MAP_MAX_SIZE         (1 << 26)
+
+
+typedef struct {
+    njs_value_t                  key;
+    njs_value_t                  value;
+} njs_map_entry_t;
+
+
+typedef struct {
+    njs_map_entry_t              *entries;
+    uint32_t                     size;
+
+    /* The number of the used entries including the deleted ones. */
+    uint32_t                     used;
+    uint32_t                     deleted;
+
+    /*
+     * The hash values are the entry indices increased by one,
+     * because the hash elements must not be NULL.
+     */
+    nxt_flathsh_t                hash;
+} njs_map_t;
+
+
+#define njs_map_index(value)     ((uintptr_t) (value) - 1)
+#define njs_map_element(index)   ((void *) ((uintptr_t) (index) + 1))
+
+
+typedef struct {
+    union {
+        njs_continuation_t       cont;
+        u_char                   padding[NJS_CONTINUATION_SIZE];
+    } u;
+    /*
+     * This retval value must be aligned so the continuation is padded
+     * to aligned size.
+     */
+    njs_value_t                  retval;
+
+    uint32_t                     index;
+} njs_map_iter_t;
+
+
+static njs_ret_t njs_map_prototype_for_each(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_set_prototype_for_each(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_map_for_each_continuation(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static nxt_int_t njs_map_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
+static void *njs_map_hash_alloc(void *pool, size_t size, nxt_uint_t nalloc);
+static void njs_map_hash_free(void *pool, void *p, size_t size);
+
+
+static const nxt_lvlhsh_proto_t  njs_map_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    0,
+    njs_map_hash_test,
+    njs_map_hash_alloc,
+    njs_map_hash_free,
+};
+
+
+/* The key is passed as the pointer to the normalized value. */
+
+#define njs_map_query_init(lhq, vm, entries, val)                             \
+    do {                                                                      \
+        (lhq)->key_hash = njs_map_key_hash(val);                              \
+        (lhq)->key.start = (u_char *) (val);                                  \
+        (lhq)->key.length = sizeof(njs_value_t);                              \
+        (lhq)->proto = &njs_map_hash_proto;                                   \
+        (lhq)->pool = (vm)->mem_pool;                                         \
+        (lhq)->data = (entries);                                              \
+    } while (0)
+
+
+nxt_inline njs_map_t *
+njs_map_data(const njs_value_t *value, uint16_t magic)
+{
+    njs_object_value_t  *ov;
+
+    if (njs_is_object_value(value)) {
+        ov = value->data.u.object_value;
+
+        if (njs_is_data(&ov->value) && ov->value.data.magic16 == magic) {
+            return ov->value.data.u.data;
+        }
+    }
+
+    return NULL;
+}
+
+
+static const char *
+njs_map_name(uint16_t magic)
+{
+    switch (magic) {
+
+    case NJS_MAP_MAGIC:
+        return "Map";
+
+    case NJS_SET_MAGIC:
+        return "Set";
+
+    case NJS_WEAK_MAP_MAGIC:
+        return "WeakMap";
+
+    default:
+        return "WeakSet";
+    }
+}
+
+
+static njs_map_t *
+njs_map_this(njs_vm_t *vm, const njs_value_t *value, uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_data(value, magic);
+
+    if (nxt_slow_path(map == NULL)) {
+        njs_type_error(vm, "\"this\" argument is not a %s",
+                       njs_map_name(magic));
+    }
+
+    return map;
+}
+
+
+/*
+ * A collection reachable from the global state of a frozen VM is shared
+ * by the clones, its entries must not be changed.
+ */
+
+static njs_map_t *
+njs_map_this_mutable(njs_vm_t *vm, const njs_value_t *value, uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_this(vm, value, magic);
+
+    if (nxt_fast_path(map != NULL) && value->data.u.object->frozen) {
+        njs_type_error(vm, "Cannot modify a frozen %s", njs_map_name(magic));
+        return NULL;
+    }
+
+    return map;
+}
+
+
+static njs_map_t *
+njs_map_alloc(njs_vm_t *vm, njs_value_t *value, uint16_t magic)
+{
+    nxt_uint_t          index;
+    njs_map_t           *map;
+    njs_object_value_t  *ov;
+
+    ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
+    if (nxt_slow_path(ov == NULL)) {
+        goto memory_error;
+    }
+
+    map = nxt_mp_alloc(vm->mem_pool, sizeof(njs_map_t));
+    if (nxt_slow_path(map == NULL)) {
+        goto memory_error;
+    }
+
+    map->entries = NULL;
+    map->size = 0;
+    map->used = 0;
+    map->deleted = 0;
+    nxt_flathsh_init(&map->hash);
+
+    switch (magic) {
+
+    case NJS_MAP_MAGIC:
+        index = NJS_PROTOTYPE_MAP;
+        break;
+
+    case NJS_SET_MAGIC:
+        index = NJS_PROTOTYPE_SET;
+        break;
+
+    case NJS_WEAK_MAP_MAGIC:
+        index = NJS_PROTOTYPE_WEAK_MAP;
+        break;
+
+    default:
+        index = NJS_PROTOTYPE_WEAK_SET;
+        break;
+    }
+
+    nxt_flathsh_init(&ov->object.hash);
+    nxt_flathsh_init(&ov->object.shared_hash);
+    ov->object.__proto__ = &vm->prototypes[index].object;
+    ov->object.type = NJS_OBJECT_VALUE;
+    ov->object.shared = 0;
+    ov->object.extensible = 1;
+    ov->object.frozen = 0;
+
+    njs_value_data_set(&ov->value, map);
+    ov->value.data.magic16 = magic;
+
+    value->data.u.object_value = ov;
+    value->type = NJS_OBJECT_VALUE;
+    value->data.truth = 1;
+
+    return map;
+
+memory_error:
+
+    njs_memory_error(vm);
+
+    return NULL;
+}
+
+
+nxt_inline void
+njs_map_key(njs_value_t *key, const njs_value_t *value)
+{
+    *key = *value;
+
+    if (njs_is_number(key)) {
+        if (key->data.u.number == 0) {
+            *key = njs_value_zero;
+
+        } else if (isnan(key->data.u.number)) {
+            *key = njs_value_nan;
+        }
+    }
+}
+
+
+static uint32_t
+njs_map_key_hash(const njs_value_t *key)
+{
+    nxt_str_t  str;
+
+    switch (key->type) {
+
+    case NJS_STRING:
+        njs_string_get(key, &str);
+        return nxt_djb_hash(str.start, str.length);
+
+    case NJS_NUMBER:
+        return nxt_djb_hash(&key->data.u.number, sizeof(double));
+
+    case NJS_NULL:
+    case NJS_UNDEFINED:
+    case NJS_BOOLEAN:
+        return key->type | (key->data.truth << 8);
+
+    default:
+        return nxt_djb_hash(&key->data.u.data, sizeof(void *));
+    }
+}
+
+
+static nxt_int_t
+njs_map_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    njs_value_t      *key;
+    njs_map_entry_t  *entry;
+
+    key = (njs_value_t *) lhq->key.start;
+    entry = (njs_map_entry_t *) lhq->data + njs_map_index(data);
+
+    if (njs_values_strict_equal(key, &entry->key)) {
+        return NXT_OK;
+    }
+
+    /* The NaN keys are normalized. */
+
+    if (njs_is_number(key) && isnan(key->data.u.number)
+        && njs_is_number(&entry->key) && isnan(entry->key.data.u.number))
+    {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static void *
+njs_map_hash_alloc(void *pool, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_alloc(pool, size);
+}
+
+
+static void
+njs_map_hash_free(void *pool, void *p, size_t size)
+{
+    nxt_mp_free(pool, p);
+}
+
+
+/*
+ * The entry indices are kept while the collection is iterated by
+ * the forEach() calls which are found on the stack of frames.
+ */
+
+static nxt_bool_t
+njs_map_iterated(njs_vm_t *vm, njs_map_t *map)
+{
+    njs_value_t         *value;
+    njs_function_t      *function;
+    njs_native_frame_t  *frame;
+
+    for (frame = vm->top_frame; frame != NULL; frame = frame->previous) {
+        function = frame->function;
+
+        if (function == NULL
+            || !function->native
+            || (function->u.native != njs_map_prototype_for_each
+                && function->u.native != njs_set_prototype_for_each))
+        {
+            continue;
+        }
+
+        value = &frame->arguments[0];
+
+        if (njs_is_object_value(value)
+            && value->data.u.object_value->value.data.u.data == map)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static njs_ret_t
+njs_map_expand(njs_vm_t *vm, njs_map_t *map)
+{
+    uint32_t            i, n, size;
+    nxt_bool_t          compact;
+    njs_map_entry_t     *entries, *old;
+    nxt_lvlhsh_query_t  lhq;
+
+    compact = 0;
+    size = NJS_MAP_MIN_SIZE;
+
+    if (map->size != 0) {
+        size = map->size;
+        compact = (map->deleted != 0 && !njs_map_iterated(vm, map));
+
+        if (!compact || map->used - map->deleted >= size / 2) {
+            if (nxt_slow_path(size >= NJS_MAP_MAX_SIZE)) {
+                njs_memory_error(vm);
+                return NXT_ERROR;
+            }
+
+            size *= 2;
+        }
+    }
+
+    entries = nxt_mp_align(vm->mem_pool, sizeof(njs_value_t),
+                           size * sizeof(njs_map_entry_t));
+    if (nxt_slow_path(entries == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    old = map->entries;
+
+    if (!compact) {
+        if (old != NULL) {
+            memcpy(entries, old, map->used * sizeof(njs_map_entry_t));
+        }
+
+    } else {
+        n = 0;
+
+        for (i = 0; i < map->used; i++) {
+            if (!njs_is_valid(&old[i].key)) {
+                continue;
+            }
+
+            entries[n] = old[i];
+
+            /*
+             * The indices are replaced in place.  They only decrease,
+             * so an already replaced index refers to an old entry which
+             * is deleted or has another key.
+             */
+
+            njs_map_query_init(&lhq, vm, old, &entries[n].key);
+            lhq.replace = 1;
+            lhq.value = njs_map_element(n);
+
+            (void) nxt_flathsh_insert(&map->hash, &lhq);
+
+            n++;
+        }
+
+        map->used = n;
+        map->deleted = 0;
+    }
+
+    if (old != NULL) {
+        nxt_mp_free(vm->mem_pool, old);
+    }
+
+    map->entries = entries;
+    map->size = size;
+
+    return NXT_OK;
+}
+
+
+static njs_map_entry_t *
+njs_map_lookup(njs_vm_t *vm, njs_map_t *map, const njs_value_t *value)
+{
+    njs_value_t         key;
+    nxt_lvlhsh_query_t  lhq;
+
+    njs_map_key(&key, value);
+    njs_map_query_init(&lhq, vm, map->entries, &key);
+
+    if (nxt_flathsh_find(&map->hash, &lhq) == NXT_OK) {
+        return &map->entries[njs_map_index(lhq.value)];
+    }
+
+    return NULL;
+}
+
+
+static njs_ret_t
+njs_map_insert(njs_vm_t *vm, njs_map_t *map, const njs_value_t *value,
+    const njs_value_t *setval)
+{
+    nxt_int_t           ret;
+    njs_value_t         key;
+    njs_map_entry_t     *entry;
+    nxt_lvlhsh_query_t  lhq;
+
+    if (map->used == map->size) {
+        entry = njs_map_lookup(vm, map, value);
+
+        if (entry != NULL) {
+            entry->value = *setval;
+            return NXT_OK;
+        }
+
+        ret = njs_map_expand(vm, map);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    njs_map_key(&key, value);
+    njs_map_query_init(&lhq, vm, map->entries, &key);
+    lhq.replace = 0;
+    lhq.value = njs_map_element(map->used);
+
+    ret = nxt_flathsh_insert(&map->hash, &lhq);
+
+    if (ret == NXT_DECLINED) {
+        map->entries[njs_map_index(lhq.value)].value = *setval;
+        return NXT_OK;
+    }
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    entry = &map->entries[map->used++];
+    entry->key = key;
+    entry->value = *setval;
+
+    return NXT_OK;
+}
+
+
+static nxt_bool_t
+njs_map_remove(njs_vm_t *vm, njs_map_t *map, const njs_value_t *value)
+{
+    njs_value_t         key;
+    njs_map_entry_t     *entry;
+    nxt_lvlhsh_query_t  lhq;
+
+    njs_map_key(&key, value);
+    njs_map_query_init(&lhq, vm, map->entries, &key);
+
+    if (nxt_flathsh_delete(&map->hash, &lhq) != NXT_OK) {
+        return 0;
+    }
+
+    entry = &map->entries[njs_map_index(lhq.value)];
+    entry->key = njs_value_invalid;
+    entry->value = njs_value_invalid;
+
+    map->deleted++;
+
+    if (map->deleted == map->used && !njs_map_iterated(vm, map)) {
+        map->used = 0;
+        map->deleted = 0;
+    }
+
+    return 1;
+}
+
+
+static void
+njs_map_reset(njs_vm_t *vm, njs_map_t *map)
+{
+    uint32_t            i;
+    njs_map_entry_t     *entry;
+    nxt_lvlhsh_query_t  lhq;
+
+    for (i = 0; i < map->used; i++) {
+        entry = &map->entries[i];
+
+        if (!njs_is_valid(&entry->key)) {
+            continue;
+        }
+
+        njs_map_query_init(&lhq, vm, map->entries, &entry->key);
+
+        (void) nxt_flathsh_delete(&map->hash, &lhq);
+
+        entry->key = njs_value_invalid;
+        entry->value = njs_value_invalid;
+    }
+
+    map->deleted = map->used;
+
+    if (!njs_map_iterated(vm, map)) {
+        map->used = 0;
+        map->deleted = 0;
+    }
+}
+
+
+static njs_ret_t
+njs_map_put(njs_vm_t *vm, njs_map_t *map, uint16_t magic,
+    const njs_value_t *key, const njs_value_t *value)
+{
+    if (magic == NJS_WEAK_MAP_MAGIC && !njs_is_object(key)) {
+        njs_type_error(vm, "invalid value used as weak map key");
+        return NXT_ERROR;
+    }
+
+    if (magic == NJS_WEAK_SET_MAGIC && !njs_is_object(key)) {
+        njs_type_error(vm, "invalid value used in weak set");
+        return NXT_ERROR;
+    }
+
+    return njs_map_insert(vm, map, key, value);
+}
+
+
+static njs_ret_t
+njs_map_entry_array(njs_vm_t *vm, njs_value_t *value,
+    const njs_map_entry_t *entry)
+{
+    njs_array_t  *array;
+
+    array = njs_array_alloc(vm, 2, 0);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    array->start[0] = entry->key;
+    array->start[1] = entry->value;
+
+    value->data.u.array = array;
+    value->type = NJS_ARRAY;
+    value->data.truth = 1;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Adds an element of the constructor argument,
+ * the elements of maps are [key, value] arrays.
+ */
+
+static njs_ret_t
+njs_map_add_element(njs_vm_t *vm, njs_map_t *map, uint16_t magic,
+    const njs_value_t *element)
+{
+    njs_array_t        *array;
+    const njs_value_t  *key, *value;
+
+    if (!njs_is_valid(element)) {
+        element = &njs_value_undefined;
+    }
+
+    if (magic == NJS_SET_MAGIC || magic == NJS_WEAK_SET_MAGIC) {
+        return njs_map_put(vm, map, magic, element, element);
+    }
+
+    if (nxt_slow_path(!njs_is_array(element))) {
+        njs_type_error(vm, "iterator value is not an entry array");
+        return NXT_ERROR;
+    }
+
+    array = element->data.u.array;
+
+    key = &njs_value_undefined;
+    value = &njs_value_undefined;
+
+    if (array->length > 0 && njs_is_valid(&array->start[0])) {
+        key = &array->start[0];
+    }
+
+    if (array->length > 1 && njs_is_valid(&array->start[1])) {
+        value = &array->start[1];
+    }
+
+    return njs_map_put(vm, map, magic, key, value);
+}
+
+
+/*
+ * The constructors accept arrays, maps and sets
+ * as iterables, the other iterables are not supported.
+ */
+
+static njs_ret_t
+njs_map_create(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    uint32_t           i;
+    njs_ret_t          ret;
+    njs_map_t          *map, *source;
+    njs_array_t        *array;
+    njs_value_t        object, entry;
+    njs_map_entry_t    *entries;
+    const njs_value_t  *iterable;
+
+    if (!vm->top_frame->ctor) {
+        njs_type_error(vm, "the %s constructor must be called with \"new\"",
+                       njs_map_name(magic));
+        return NXT_ERROR;
+    }
+
+    map = njs_map_alloc(vm, &object, magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    iterable = njs_arg(args, nargs, 1);
+
+    if (njs_is_array(iterable)) {
+        array = iterable->data.u.array;
+
+        for (i = 0; i < array->length; i++) {
+            ret = njs_map_add_element(vm, map, magic, &array->start[i]);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+    } else if ((source = njs_map_data(iterable, NJS_SET_MAGIC)) != NULL) {
+        entries = source->entries;
+
+        for (i = 0; i < source->used; i++) {
+            if (!njs_is_valid(&entries[i].key)) {
+                continue;
+            }
+
+            ret = njs_map_add_element(vm, map, magic, &entries[i].key);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+    } else if ((source = njs_map_data(iterable, NJS_MAP_MAGIC)) != NULL) {
+        entries = source->entries;
+
+        for (i = 0; i < source->used; i++) {
+            if (!njs_is_valid(&entries[i].key)) {
+                continue;
+            }
+
+            if (magic == NJS_MAP_MAGIC || magic == NJS_WEAK_MAP_MAGIC) {
+                ret = njs_map_put(vm, map, magic, &entries[i].key,
+                                  &entries[i].value);
+
+            } else {
+                ret = njs_map_entry_array(vm, &entry, &entries[i]);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return ret;
+                }
+
+                ret = njs_map_put(vm, map, magic, &entry, &entry);
+            }
+
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+    } else if (!njs_is_null_or_undefined(iterable)) {
+        njs_type_error(vm, "the %s constructor argument is not iterable",
+                       njs_map_name(magic));
+        return NXT_ERROR;
+    }
+
+    vm->retval = object;
+
+    return NXT_OK;
+}
+
+
+njs_ret_t
+njs_map_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_create(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+njs_ret_t
+njs_set_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_create(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+njs_ret_t
+njs_weak_map_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_create(vm, args, nargs, NJS_WEAK_MAP_MAGIC);
+}
+
+
+njs_ret_t
+njs_weak_set_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_create(vm, args, nargs, NJS_WEAK_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_get(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_map_t        *map;
+    njs_map_entry_t  *entry;
+
+    map = njs_map_this(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    entry = njs_map_lookup(vm, map, njs_arg(args, nargs, 1));
+
+    vm->retval = (entry != NULL) ? entry->value : njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_set(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_ret_t  ret;
+    njs_map_t  *map;
+
+    map = njs_map_this_mutable(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = njs_map_put(vm, map, magic, njs_arg(args, nargs, 1),
+                      njs_arg(args, nargs, 2));
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    vm->retval = args[0];
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_add(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_ret_t          ret;
+    njs_map_t          *map;
+    const njs_value_t  *value;
+
+    map = njs_map_this_mutable(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    value = njs_arg(args, nargs, 1);
+
+    ret = njs_map_put(vm, map, magic, value, value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    vm->retval = args[0];
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_has(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_this(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_map_lookup(vm, map, njs_arg(args, nargs, 1)) != NULL) {
+        vm->retval = njs_value_true;
+
+    } else {
+        vm->retval = njs_value_false;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_delete(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_this_mutable(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_map_remove(vm, map, njs_arg(args, nargs, 1))) {
+        vm->retval = njs_value_true;
+
+    } else {
+        vm->retval = njs_value_false;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_clear(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_this_mutable(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    njs_map_reset(vm, map);
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_size(njs_vm_t *vm, njs_value_t *value, njs_value_t *retval,
+    uint16_t magic)
+{
+    njs_map_t  *map;
+
+    map = njs_map_data(value, magic);
+
+    if (map == NULL) {
+        *retval = njs_value_undefined;
+        return NXT_OK;
+    }
+
+    njs_value_number_set(retval, map->used - map->deleted);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_map_for_each(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    uint16_t magic)
+{
+    njs_map_iter_t  *iter;
+
+    if (nxt_slow_path(njs_map_this(vm, &args[0], magic) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(!njs_is_function(njs_arg(args, nargs, 1)))) {
+        njs_type_error(vm, "the callback argument is not a function");
+        return NXT_ERROR;
+    }
+
+    iter = njs_vm_continuation(vm);
+    iter->u.cont.function = njs_map_for_each_continuation;
+    iter->index = 0;
+
+    return njs_map_for_each_continuation(vm, args, nargs, 0);
+}
+
+
+static njs_ret_t
+njs_map_for_each_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_map_t        *map;
+    njs_value_t      arguments[4];
+    njs_map_iter_t   *iter;
+    njs_map_entry_t  *entry;
+
+    iter = njs_vm_continuation(vm);
+    map = args[0].data.u.object_value->value.data.u.data;
+
+    do {
+        if (iter->index >= map->used) {
+            vm->retval = njs_value_undefined;
+            return NXT_OK;
+        }
+
+        entry = &map->entries[iter->index++];
+
+    } while (!njs_is_valid(&entry->key));
+
+    arguments[0] = *njs_arg(args, nargs, 2);
+    arguments[1] = entry->value;
+    arguments[2] = entry->key;
+    arguments[3] = args[0];
+
+    return njs_function_apply(vm, args[1].data.u.function, arguments, 4,
+                              (njs_index_t) &iter->retval);
+}
+
+
+/* keys(), values() and entries() return arrays instead of iterators. */
+
+static njs_ret_t
+njs_map_elements(njs_vm_t *vm, njs_value_t *args, uint16_t magic,
+    njs_object_enum_t kind)
+{
+    uint32_t         i;
+    njs_ret_t        ret;
+    njs_map_t        *map;
+    njs_array_t      *array;
+    njs_value_t      *value;
+    njs_map_entry_t  *entry;
+
+    map = njs_map_this(vm, &args[0], magic);
+    if (nxt_slow_path(map == NULL)) {
+        return NXT_ERROR;
+    }
+
+    array = njs_array_alloc(vm, map->used - map->deleted, 0);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    value = array->start;
+
+    for (i = 0; i < map->used; i++) {
+        entry = &map->entries[i];
+
+        if (!njs_is_valid(&entry->key)) {
+            continue;
+        }
+
+        switch (kind) {
+
+        case NJS_ENUM_KEYS:
+            *value = entry->key;
+            break;
+
+        case NJS_ENUM_VALUES:
+            *value = entry->value;
+            break;
+
+        default:
+            ret = njs_map_entry_array(vm, value, entry);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            break;
+        }
+
+        value++;
+    }
+
+    vm->retval.data.u.array = array;
+    vm->retval.type = NJS_ARRAY;
+    vm->retval.data.truth = 1;
+
+    return NXT_OK;
+}
+
+
+static const njs_object_prop_t  njs_map_constructor_properties[] =
+{
+    /* Map.name == "Map". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("Map"),
+        .configurable = 1,
+    },
+
+    /* Map.length == 0. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 0, 0.0),
+        .configurable = 1,
+    },
+
+    /* Map.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+};
+
+
+const njs_object_init_t  njs_map_constructor_init = {
+    nxt_string("Map"),
+    njs_map_constructor_properties,
+    nxt_nitems(njs_map_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_map_prototype_get(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_get(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_set(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_set(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_has(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_has(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_delete(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_delete(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_clear(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_clear(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_for_each(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_for_each(vm, args, nargs, NJS_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_map_prototype_keys(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_elements(vm, args, NJS_MAP_MAGIC, NJS_ENUM_KEYS);
+}
+
+
+static njs_ret_t
+njs_map_prototype_values(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_elements(vm, args, NJS_MAP_MAGIC, NJS_ENUM_VALUES);
+}
+
+
+static njs_ret_t
+njs_map_prototype_entries(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_elements(vm, args, NJS_MAP_MAGIC, NJS_ENUM_BOTH);
+}
+
+
+static njs_ret_t
+njs_map_prototype_size(njs_vm_t *vm, njs_value_t *value, njs_value_t *setval,
+    njs_value_t *retval)
+{
+    return njs_map_size(vm, value, retval, NJS_MAP_MAGIC);
+}
+
+
+static const njs_object_prop_t  njs_map_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("size"),
+        .value = njs_prop_handler(njs_map_prototype_size),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("get"),
+        .value = njs_native_function(njs_map_prototype_get, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("set"),
+        .value = njs_native_function(njs_map_prototype_set, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("has"),
+        .value = njs_native_function(njs_map_prototype_has, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("delete"),
+        .value = njs_native_function(njs_map_prototype_delete, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("clear"),
+        .value = njs_native_function(njs_map_prototype_clear, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("forEach"),
+        .value = njs_native_function(njs_map_prototype_for_each,
+                     njs_continuation_size(njs_map_iter_t), 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("keys"),
+        .value = njs_native_function(njs_map_prototype_keys, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("values"),
+        .value = njs_native_function(njs_map_prototype_values, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("entries"),
+        .value = njs_native_function(njs_map_prototype_entries, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_map_prototype_init = {
+    nxt_string("Map"),
+    njs_map_prototype_properties,
+    nxt_nitems(njs_map_prototype_properties),
+};
+
+
+static const njs_object_prop_t  njs_set_constructor_properties[] =
+{
+    /* Set.name == "Set". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("Set"),
+        .configurable = 1,
+    },
+
+    /* Set.length == 0. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 0, 0.0),
+        .configurable = 1,
+    },
+
+    /* Set.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+};
+
+
+const njs_object_init_t  njs_set_constructor_init = {
+    nxt_string("Set"),
+    njs_set_constructor_properties,
+    nxt_nitems(njs_set_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_set_prototype_add(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_add(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_set_prototype_has(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_has(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_set_prototype_delete(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_delete(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_set_prototype_clear(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_clear(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_set_prototype_for_each(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_for_each(vm, args, nargs, NJS_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_set_prototype_values(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_elements(vm, args, NJS_SET_MAGIC, NJS_ENUM_KEYS);
+}
+
+
+static njs_ret_t
+njs_set_prototype_entries(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_elements(vm, args, NJS_SET_MAGIC, NJS_ENUM_BOTH);
+}
+
+
+static njs_ret_t
+njs_set_prototype_size(njs_vm_t *vm, njs_value_t *value, njs_value_t *setval,
+    njs_value_t *retval)
+{
+    return njs_map_size(vm, value, retval, NJS_SET_MAGIC);
+}
+
+
+static const njs_object_prop_t  njs_set_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("size"),
+        .value = njs_prop_handler(njs_set_prototype_size),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("add"),
+        .value = njs_native_function(njs_set_prototype_add, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("has"),
+        .value = njs_native_function(njs_set_prototype_has, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("delete"),
+        .value = njs_native_function(njs_set_prototype_delete, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("clear"),
+        .value = njs_native_function(njs_set_prototype_clear, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("forEach"),
+        .value = njs_native_function(njs_set_prototype_for_each,
+                     njs_continuation_size(njs_map_iter_t), 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    /* Set.prototype.keys() is the same as Set.prototype.values(). */
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("keys"),
+        .value = njs_native_function(njs_set_prototype_values, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("values"),
+        .value = njs_native_function(njs_set_prototype_values, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("entries"),
+        .value = njs_native_function(njs_set_prototype_entries, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_set_prototype_init = {
+    nxt_string("Set"),
+    njs_set_prototype_properties,
+    nxt_nitems(njs_set_prototype_properties),
+};
+
+
+static const njs_object_prop_t  njs_weak_map_constructor_properties[] =
+{
+    /* WeakMap.name == "WeakMap". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("WeakMap"),
+        .configurable = 1,
+    },
+
+    /* WeakMap.length == 0. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 0, 0.0),
+        .configurable = 1,
+    },
+
+    /* WeakMap.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+};
+
+
+const njs_object_init_t  njs_weak_map_constructor_init = {
+    nxt_string("WeakMap"),
+    njs_weak_map_constructor_properties,
+    nxt_nitems(njs_weak_map_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_weak_map_prototype_get(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_get(vm, args, nargs, NJS_WEAK_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_weak_map_prototype_set(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_set(vm, args, nargs, NJS_WEAK_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_weak_map_prototype_has(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_has(vm, args, nargs, NJS_WEAK_MAP_MAGIC);
+}
+
+
+static njs_ret_t
+njs_weak_map_prototype_delete(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_map_delete(vm, args, nargs, NJS_WEAK_MAP_MAGIC);
+}
+
+
+static const njs_object_prop_t  njs_weak_map_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("get"),
+        .value = njs_native_function(njs_weak_map_prototype_get, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("set"),
+        .value = njs_native_function(njs_weak_map_prototype_set, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("has"),
+        .value = njs_native_function(njs_weak_map_prototype_has, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("delete"),
+        .value = njs_native_function(njs_weak_map_prototype_delete, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_weak_map_prototype_init = {
+    nxt_string("WeakMap"),
+    njs_weak_map_prototype_properties,
+    nxt_nitems(njs_weak_map_prototype_properties),
+};
+
+
+static const njs_object_prop_t  njs_weak_set_constructor_properties[] =
+{
+    /* WeakSet.name == "WeakSet". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("WeakSet"),
+        .configurable = 1,
+    },
+
+    /* WeakSet.length == 0. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 0, 0.0),
+        .configurable = 1,
+    },
+
+    /* WeakSet.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+};
+
+
+const njs_object_init_t  njs_weak_set_constructor_init = {
+    nxt_string("WeakSet"),
+    njs_weak_set_constructor_properties,
+    nxt_nitems(njs_weak_set_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_weak_set_prototype_add(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_add(vm, args, nargs, NJS_WEAK_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_weak_set_prototype_has(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_map_has(vm, args, nargs, NJS_WEAK_SET_MAGIC);
+}
+
+
+static njs_ret_t
+njs_weak_set_prototype_delete(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_map_delete(vm, args, nargs, NJS_WEAK_SET_MAGIC);
+}
+
+
+static const njs_object_prop_t  njs_weak_set_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("add"),
+        .value = njs_native_function(njs_weak_set_prototype_add, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("has"),
+        .value = njs_native_function(njs_weak_set_prototype_has, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("delete"),
+        .value = njs_native_function(njs_weak_set_prototype_delete, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_weak_set_prototype_init = {
+    nxt_string("WeakSet"),
+    njs_weak_set_prototype_properties,
+    nxt_nitems(njs_weak_set_prototype_properties),
+};
+
+
+njs_ret_t
+njs_map_deep_freeze(njs_vm_t *vm, const njs_value_t *value)
+{
+    uint32_t         i;
+    njs_ret_t        ret;
+    njs_map_t        *map;
+    njs_map_entry_t  *entry;
+
+    map = NULL;
+
+    if (njs_is_object_value(value)
+        && njs_is_data(&value->data.u.object_value->value))
+    {
+        switch (value->data.u.object_value->value.data.magic16) {
+
+        case NJS_MAP_MAGIC:
+        case NJS_SET_MAGIC:
+        case NJS_WEAK_MAP_MAGIC:
+        case NJS_WEAK_SET_MAGIC:
+            map = value->data.u.object_value->value.data.u.data;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (map == NULL) {
+        return NXT_DECLINED;
+    }
+
+    for (i = 0; i < map->used; i++) {
+        entry = &map->entries[i];
+
+        if (!njs_is_valid(&entry->key)) {
+            continue;
+        }
+
+        ret = njs_object_deep_freeze(vm, &entry->key);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_object_deep_freeze(vm, &entry->value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+njs_map_gc_mark(njs_gc_t *gc, const njs_value_t *value)
+{
+    uint32_t         i;
+    nxt_int_t        ret;
+    njs_map_t        *map;
+    njs_map_entry_t  *entry;
+
+    switch (value->data.magic16) {
+
+    case NJS_MAP_MAGIC:
+    case NJS_SET_MAGIC:
+    case NJS_WEAK_MAP_MAGIC:
+    case NJS_WEAK_SET_MAGIC:
+        map = value->data.u.data;
+
+        for (i = 0; i < map->used; i++) {
+            entry = &map->entries[i];
+
+            if (!njs_is_valid(&entry->key)) {
+                continue;
+            }
+
+            ret = njs_gc_mark_value(gc, &entry->key);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            ret = njs_gc_mark_value(gc, &entry->value);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+        return NXT_OK;
+
+    default:
+        return NXT_DECLINED;
+    }
+}
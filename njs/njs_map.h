@@ -0,0 +1,33 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_MAP_H_INCLUDED_
+#define _NJS_MAP_H_INCLUDED_
+
+
+njs_ret_t njs_map_deep_freeze(njs_vm_t *vm, const njs_value_t *value);
+nxt_int_t njs_map_gc_mark(njs_gc_t *gc, const njs_value_t *value);
+
+njs_ret_t njs_map_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_set_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_weak_map_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_weak_set_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+
+
+extern const njs_object_init_t  njs_map_constructor_init;
+extern const njs_object_init_t  njs_map_prototype_init;
+extern const njs_object_init_t  njs_set_constructor_init;
+extern const njs_object_init_t  njs_set_prototype_init;
+extern const njs_object_init_t  njs_weak_map_constructor_init;
+extern const njs_object_init_t  njs_weak_map_prototype_init;
+extern const njs_object_init_t  njs_weak_set_constructor_init;
+extern const njs_object_init_t  njs_weak_set_prototype_init;
+
+
+#endif /* _NJS_MAP_H_INCLUDED_ */
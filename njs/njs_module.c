@@ -475,7 +475,7 @@ njs_module_add(njs_vm_t *vm, nxt_str_t *name)
     nxt_mp_free(vm->mem_pool, module->name.start);
     nxt_mp_free(vm->mem_pool, module);
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NULL;
 }
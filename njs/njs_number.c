@@ -40,7 +40,7 @@ njs_value_to_index(const njs_value_t *value)
 
         array = value->data.u.array;
 
-        if (nxt_lvlhsh_is_empty(&array->object.hash)) {
+        if (nxt_flathsh_is_empty(&array->object.hash)) {
 
             if (array->length == 0) {
                 /* An empty array value is zero. */
@@ -41,6 +41,33 @@ nxt_noinline int32_t njs_number_to_int32(double num);
 nxt_noinline uint32_t njs_number_to_uint32(double num);
 nxt_noinline uint32_t njs_number_to_length(double num);
 
+
+/*
+ * The numbers are doubles but most of them are small integers: loop
+ * counters, array indexes and hash buckets.  The int32 fast path avoids
+ * the njs_number_to_int64() call for them.  The range check also fails
+ * for NaN, so the cast is always defined.
+ */
+
+nxt_inline nxt_bool_t
+njs_number_is_int32(double num)
+{
+    return (num >= -2147483648.0 && num <= 2147483647.0
+            && (double) (int32_t) num == num);
+}
+
+
+nxt_inline int32_t
+njs_number_to_int32_fast(double num)
+{
+    if (nxt_fast_path(num >= -2147483648.0 && num <= 2147483647.0)) {
+        /* ES5.1 ToInt32() truncates the fraction as the C cast does. */
+        return (int32_t) num;
+    }
+
+    return njs_number_to_int32(num);
+}
+
 nxt_inline nxt_int_t
 njs_char_to_hex(u_char c)
 {
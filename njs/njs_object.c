@@ -5,10 +5,14 @@
  */
 
 #include <njs_core.h>
+#include <njs_typed_array.h>
+#include <njs_map.h>
 #include <string.h>
 
 
 static nxt_int_t njs_object_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
+static nxt_bool_t njs_object_is_builtin(njs_vm_t *vm,
+    const njs_object_t *object);
 static njs_object_prop_t *njs_object_exist_in_proto(const njs_object_t *begin,
     const njs_object_t *end, nxt_lvlhsh_query_t *lhq);
 static uint32_t njs_object_enumerate_array_length(const njs_object_t *object);
@@ -34,15 +38,21 @@ njs_object_alloc(njs_vm_t *vm)
 {
     njs_object_t  *object;
 
-    object = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_t));
+    if (vm->gc) {
+        object = njs_gc_alloc(vm, NJS_OBJECT, sizeof(njs_object_t));
+
+    } else {
+        object = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_t));
+    }
 
     if (nxt_fast_path(object != NULL)) {
-        nxt_lvlhsh_init(&object->hash);
-        nxt_lvlhsh_init(&object->shared_hash);
+        nxt_flathsh_init(&object->hash);
+        nxt_flathsh_init(&object->shared_hash);
         object->__proto__ = &vm->prototypes[NJS_PROTOTYPE_OBJECT].object;
         object->type = NJS_OBJECT;
         object->shared = 0;
         object->extensible = 1;
+        object->frozen = 0;
         return object;
     }
 
@@ -88,18 +98,19 @@ njs_object_value_alloc(njs_vm_t *vm, const njs_value_t *value, nxt_uint_t type)
     ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
 
     if (nxt_fast_path(ov != NULL)) {
-        nxt_lvlhsh_init(&ov->object.hash);
+        nxt_flathsh_init(&ov->object.hash);
 
         if (type == NJS_STRING) {
             ov->object.shared_hash = vm->shared->string_instance_hash;
 
         } else {
-            nxt_lvlhsh_init(&ov->object.shared_hash);
+            nxt_flathsh_init(&ov->object.shared_hash);
         }
 
         ov->object.type = njs_object_value_type(type);
         ov->object.shared = 0;
         ov->object.extensible = 1;
+        ov->object.frozen = 0;
 
         index = njs_primitive_prototype_index(type);
         ov->object.__proto__ = &vm->prototypes[index].object;
@@ -116,7 +127,7 @@ njs_object_value_alloc(njs_vm_t *vm, const njs_value_t *value, nxt_uint_t type)
 
 
 nxt_int_t
-njs_object_hash_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_object_hash_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     const njs_object_prop_t *prop, nxt_uint_t n)
 {
     nxt_int_t           ret;
@@ -131,9 +142,9 @@ njs_object_hash_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
         lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
         lhq.value = (void *) prop;
 
-        ret = nxt_lvlhsh_insert(hash, &lhq);
+        ret = nxt_flathsh_insert(hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
 
@@ -151,7 +162,7 @@ const nxt_lvlhsh_proto_t  njs_object_hash_proto
     NXT_LVLHSH_DEFAULT,
     0,
     njs_object_hash_test,
-    njs_lvlhsh_alloc,
+    njs_flathsh_alloc,
     njs_lvlhsh_free,
 };
 
@@ -378,7 +389,7 @@ njs_object_exist_in_proto(const njs_object_t *object, const njs_object_t *end,
     lhq->proto = &njs_object_hash_proto;
 
     while (object != end) {
-        ret = nxt_lvlhsh_find(&object->hash, lhq);
+        ret = nxt_flathsh_find(&object->hash, lhq);
 
         if (nxt_fast_path(ret == NXT_OK)) {
             prop = lhq->value;
@@ -390,7 +401,7 @@ njs_object_exist_in_proto(const njs_object_t *object, const njs_object_t *end,
             return lhq->value;
         }
 
-        ret = nxt_lvlhsh_find(&object->shared_hash, lhq);
+        ret = nxt_flathsh_find(&object->shared_hash, lhq);
 
         if (nxt_fast_path(ret == NXT_OK)) {
             return lhq->value;
@@ -636,26 +647,26 @@ static uint32_t
 njs_object_own_enumerate_object_length(const njs_object_t *object,
     const njs_object_t *parent, nxt_bool_t all)
 {
-    uint32_t            length;
-    nxt_int_t           ret;
-    nxt_lvlhsh_each_t   lhe;
-    njs_object_prop_t   *prop, *ext_prop;
-    nxt_lvlhsh_query_t  lhq;
-    const nxt_lvlhsh_t  *hash;
-
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    uint32_t             length;
+    nxt_int_t            ret;
+    nxt_flathsh_each_t   fhe;
+    njs_object_prop_t    *prop, *ext_prop;
+    nxt_lvlhsh_query_t   lhq;
+    const nxt_flathsh_t  *hash;
+
+    nxt_flathsh_each_init(&fhe);
     hash = &object->hash;
 
     length = 0;
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
         }
 
-        lhq.key_hash = lhe.key_hash;
+        lhq.key_hash = fhe.key_hash;
         njs_string_get(&prop->name, &lhq.key);
 
         ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -667,21 +678,21 @@ njs_object_own_enumerate_object_length(const njs_object_t *object,
         }
     }
 
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
     hash = &object->shared_hash;
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
         }
 
-        lhq.key_hash = lhe.key_hash;
+        lhq.key_hash = fhe.key_hash;
         njs_string_get(&prop->name, &lhq.key);
 
         lhq.proto = &njs_object_hash_proto;
-        ret = nxt_lvlhsh_find(&object->hash, &lhq);
+        ret = nxt_flathsh_find(&object->hash, &lhq);
 
         if (ret != NXT_OK) {
             ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -913,15 +924,15 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
     const njs_object_t *parent, njs_array_t *items, njs_object_enum_t kind,
     nxt_bool_t all)
 {
-    nxt_int_t           ret;
-    njs_value_t         *item;
-    njs_array_t         *entry;
-    nxt_lvlhsh_each_t   lhe;
-    njs_object_prop_t   *prop, *ext_prop;
-    nxt_lvlhsh_query_t  lhq;
-    const nxt_lvlhsh_t  *hash;
+    nxt_int_t            ret;
+    njs_value_t          *item;
+    njs_array_t          *entry;
+    nxt_flathsh_each_t   fhe;
+    njs_object_prop_t    *prop, *ext_prop;
+    nxt_lvlhsh_query_t   lhq;
+    const nxt_flathsh_t  *hash;
 
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     item = items->start;
     hash = &object->hash;
@@ -929,13 +940,13 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
     switch (kind) {
     case NJS_ENUM_KEYS:
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(hash, &lhe);
+            prop = nxt_flathsh_each(hash, &fhe);
 
             if (prop == NULL) {
                 break;
             }
 
-            lhq.key_hash = lhe.key_hash;
+            lhq.key_hash = fhe.key_hash;
             njs_string_get(&prop->name, &lhq.key);
 
             ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -947,21 +958,21 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
             }
         }
 
-        nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+        nxt_flathsh_each_init(&fhe);
         hash = &object->shared_hash;
 
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(hash, &lhe);
+            prop = nxt_flathsh_each(hash, &fhe);
 
             if (prop == NULL) {
                 break;
             }
 
-            lhq.key_hash = lhe.key_hash;
+            lhq.key_hash = fhe.key_hash;
             njs_string_get(&prop->name, &lhq.key);
 
             lhq.proto = &njs_object_hash_proto;
-            ret = nxt_lvlhsh_find(&object->hash, &lhq);
+            ret = nxt_flathsh_find(&object->hash, &lhq);
 
             if (ret != NXT_OK) {
                 ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -976,13 +987,13 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
 
     case NJS_ENUM_VALUES:
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(hash, &lhe);
+            prop = nxt_flathsh_each(hash, &fhe);
 
             if (prop == NULL) {
                 break;
             }
 
-            lhq.key_hash = lhe.key_hash;
+            lhq.key_hash = fhe.key_hash;
             njs_string_get(&prop->name, &lhq.key);
 
             ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -996,21 +1007,21 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
         }
 
         if (nxt_slow_path(all)) {
-            nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+            nxt_flathsh_each_init(&fhe);
             hash = &object->shared_hash;
 
             for ( ;; ) {
-                prop = nxt_lvlhsh_each(hash, &lhe);
+                prop = nxt_flathsh_each(hash, &fhe);
 
                 if (prop == NULL) {
                     break;
                 }
 
-                lhq.key_hash = lhe.key_hash;
+                lhq.key_hash = fhe.key_hash;
                 njs_string_get(&prop->name, &lhq.key);
 
                 lhq.proto = &njs_object_hash_proto;
-                ret = nxt_lvlhsh_find(&object->hash, &lhq);
+                ret = nxt_flathsh_find(&object->hash, &lhq);
 
                 if (ret != NXT_OK) {
                     ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -1026,13 +1037,13 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
 
     case NJS_ENUM_BOTH:
         for ( ;; ) {
-            prop = nxt_lvlhsh_each(hash, &lhe);
+            prop = nxt_flathsh_each(hash, &fhe);
 
             if (prop == NULL) {
                 break;
             }
 
-            lhq.key_hash = lhe.key_hash;
+            lhq.key_hash = fhe.key_hash;
             njs_string_get(&prop->name, &lhq.key);
 
             ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -1059,21 +1070,21 @@ njs_object_own_enumerate_object(njs_vm_t *vm, const njs_object_t *object,
         }
 
         if (nxt_slow_path(all)) {
-            nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+            nxt_flathsh_each_init(&fhe);
             hash = &object->shared_hash;
 
             for ( ;; ) {
-                prop = nxt_lvlhsh_each(hash, &lhe);
+                prop = nxt_flathsh_each(hash, &fhe);
 
                 if (prop == NULL) {
                     break;
                 }
 
-                lhq.key_hash = lhe.key_hash;
+                lhq.key_hash = fhe.key_hash;
                 njs_string_get(&prop->name, &lhq.key);
 
                 lhq.proto = &njs_object_hash_proto;
-                ret = nxt_lvlhsh_find(&object->hash, &lhq);
+                ret = nxt_flathsh_find(&object->hash, &lhq);
 
                 if (ret != NXT_OK) {
                     ext_prop = njs_object_exist_in_proto(parent, object, &lhq);
@@ -1153,12 +1164,12 @@ static njs_ret_t
 njs_object_define_properties(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    nxt_int_t          ret;
-    njs_value_t        *value;
-    nxt_lvlhsh_t       *hash;
-    nxt_lvlhsh_each_t  lhe;
-    njs_object_prop_t  *prop;
-    const njs_value_t  *desc;
+    nxt_int_t           ret;
+    njs_value_t         *value;
+    nxt_flathsh_t       *hash;
+    nxt_flathsh_each_t  fhe;
+    njs_object_prop_t   *prop;
+    const njs_value_t   *desc;
 
     if (!njs_is_object(njs_arg(args, nargs, 1))) {
         njs_type_error(vm, "cannot convert %s argument to object",
@@ -1180,12 +1191,12 @@ njs_object_define_properties(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NXT_ERROR;
     }
 
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     hash = &desc->data.u.object->hash;
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
@@ -1280,9 +1291,9 @@ njs_object_get_own_property_descriptors(njs_vm_t *vm, njs_value_t *args,
         lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
         lhq.value = pr;
 
-        ret = nxt_lvlhsh_insert(&descriptors->hash, &lhq);
+        ret = nxt_flathsh_insert(&descriptors->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
     }
@@ -1349,11 +1360,11 @@ static njs_ret_t
 njs_object_freeze(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    nxt_lvlhsh_t       *hash;
-    njs_object_t       *object;
-    njs_object_prop_t  *prop;
-    nxt_lvlhsh_each_t  lhe;
-    const njs_value_t  *value;
+    nxt_flathsh_t       *hash;
+    njs_object_t        *object;
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
+    const njs_value_t   *value;
 
     value = njs_arg(args, nargs, 1);
 
@@ -1365,12 +1376,12 @@ njs_object_freeze(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     object = value->data.u.object;
     object->extensible = 0;
 
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     hash = &object->hash;
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
@@ -1386,15 +1397,182 @@ njs_object_freeze(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 }
 
 
+/*
+ * The copies of the built-in prototypes and constructors in any VM,
+ * including the parent VMs, share the hashes of njs_vm_shared_t.
+ */
+
+static nxt_bool_t
+njs_object_is_builtin(njs_vm_t *vm, const njs_object_t *object)
+{
+    void        *table;
+    nxt_uint_t  i;
+
+    table = object->shared_hash.table;
+
+    if (table == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < NJS_PROTOTYPE_MAX; i++) {
+        if (table == vm->shared->prototypes[i].object.shared_hash.table) {
+            return 1;
+        }
+    }
+
+    for (i = 0; i < NJS_CONSTRUCTOR_MAX; i++) {
+        if (table == vm->shared->constructors[i].object.shared_hash.table) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * Freezes the value and all the objects reachable from it including
+ * array elements, accessors and prototypes, so a VM clone can share
+ * them without copying.  Unlike Object.freeze() frozen arrays cannot
+ * be modified in place either.  The memory of ArrayBuffers becomes
+ * read-only, the entries of collections are frozen and cannot be
+ * changed.  The built-in prototypes and constructors and the shared
+ * objects are not frozen, they are not part of the global state.
+ */
+
+njs_ret_t
+njs_object_deep_freeze(njs_vm_t *vm, njs_value_t *value)
+{
+    uint32_t             i;
+    njs_ret_t            ret;
+    njs_value_t          proto;
+    njs_array_t          *array;
+    njs_object_t         *object;
+    njs_function_t       *function;
+    njs_object_prop_t    *prop;
+    njs_typed_array_t    *view;
+    nxt_flathsh_each_t   fhe;
+    njs_array_buffer_t   *buffer;
+    nxt_lvlhsh_query_t   lhq;
+
+    if (!njs_is_object(value)) {
+        return NXT_OK;
+    }
+
+    object = value->data.u.object;
+
+    if (object->frozen || object->shared || njs_object_is_builtin(vm, object))
+    {
+        return NXT_OK;
+    }
+
+    if (njs_is_function(value)) {
+        function = value->data.u.function;
+
+        /*
+         * The prototype of a constructor is created on the first access,
+         * it is created now to keep the function hash unchanged.
+         */
+
+        if (!function->native && function->ctor && !object->shared) {
+            lhq.key_hash = NJS_PROTOTYPE_HASH;
+            lhq.key = nxt_string_value("prototype");
+            lhq.proto = &njs_object_hash_proto;
+
+            if (nxt_flathsh_find(&object->hash, &lhq) != NXT_OK
+                && njs_function_property_prototype_create(vm, value) == NULL)
+            {
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    object->frozen = 1;
+    object->extensible = 0;
+
+    buffer = njs_array_buffer(value);
+
+    if (buffer == NULL) {
+        view = njs_array_buffer_view(value);
+
+        if (view != NULL) {
+            buffer = view->buffer;
+        }
+    }
+
+    if (buffer != NULL) {
+        buffer->frozen = 1;
+    }
+
+    ret = njs_map_deep_freeze(vm, value);
+    if (nxt_slow_path(ret == NXT_ERROR)) {
+        return ret;
+    }
+
+    nxt_flathsh_each_init(&fhe);
+
+    for ( ;; ) {
+        prop = nxt_flathsh_each(&object->hash, &fhe);
+
+        if (prop == NULL) {
+            break;
+        }
+
+        prop->writable = 0;
+        prop->configurable = 0;
+
+        if (prop->type != NJS_PROPERTY && prop->type != NJS_METHOD) {
+            continue;
+        }
+
+        ret = njs_object_deep_freeze(vm, &prop->value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_object_deep_freeze(vm, &prop->getter);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        ret = njs_object_deep_freeze(vm, &prop->setter);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (njs_is_array(value)) {
+        array = value->data.u.array;
+
+        for (i = 0; i < array->length; i++) {
+            ret = njs_object_deep_freeze(vm, &array->start[i]);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+    }
+
+    if (object->__proto__ != NULL) {
+        proto.data.u.object = object->__proto__;
+        proto.type = NJS_OBJECT;
+        proto.data.truth = 1;
+
+        return njs_object_deep_freeze(vm, &proto);
+    }
+
+    return NXT_OK;
+}
+
+
 static njs_ret_t
 njs_object_is_frozen(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    nxt_lvlhsh_t       *hash;
-    njs_object_t       *object;
-    njs_object_prop_t  *prop;
-    nxt_lvlhsh_each_t  lhe;
-    const njs_value_t  *value, *retval;
+    nxt_flathsh_t       *hash;
+    njs_object_t        *object;
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
+    const njs_value_t   *value, *retval;
 
     value = njs_arg(args, nargs, 1);
 
@@ -1406,7 +1584,7 @@ njs_object_is_frozen(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     retval = &njs_value_false;
 
     object = value->data.u.object;
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     hash = &object->hash;
 
@@ -1415,7 +1593,7 @@ njs_object_is_frozen(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     }
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
@@ -1444,11 +1622,11 @@ static njs_ret_t
 njs_object_seal(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    nxt_lvlhsh_t       *hash;
-    njs_object_t       *object;
-    const njs_value_t  *value;
-    njs_object_prop_t  *prop;
-    nxt_lvlhsh_each_t  lhe;
+    nxt_flathsh_t       *hash;
+    njs_object_t        *object;
+    const njs_value_t   *value;
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
 
     value = njs_arg(args, nargs, 1);
 
@@ -1460,12 +1638,12 @@ njs_object_seal(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     object = value->data.u.object;
     object->extensible = 0;
 
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     hash = &object->hash;
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
@@ -1484,11 +1662,11 @@ static njs_ret_t
 njs_object_is_sealed(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    nxt_lvlhsh_t       *hash;
-    njs_object_t       *object;
-    njs_object_prop_t  *prop;
-    nxt_lvlhsh_each_t  lhe;
-    const njs_value_t  *value, *retval;
+    nxt_flathsh_t       *hash;
+    njs_object_t        *object;
+    njs_object_prop_t   *prop;
+    nxt_flathsh_each_t  fhe;
+    const njs_value_t   *value, *retval;
 
     value = njs_arg(args, nargs, 1);
 
@@ -1500,7 +1678,7 @@ njs_object_is_sealed(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     retval = &njs_value_false;
 
     object = value->data.u.object;
-    nxt_lvlhsh_each_init(&lhe, &njs_object_hash_proto);
+    nxt_flathsh_each_init(&fhe);
 
     hash = &object->hash;
 
@@ -1509,7 +1687,7 @@ njs_object_is_sealed(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     }
 
     for ( ;; ) {
-        prop = nxt_lvlhsh_each(hash, &lhe);
+        prop = nxt_flathsh_each(hash, &fhe);
 
         if (prop == NULL) {
             break;
@@ -1640,7 +1818,7 @@ njs_object_prototype_create(njs_vm_t *vm, njs_value_t *value,
 
 
 njs_value_t *
-njs_property_prototype_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_property_prototype_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     njs_object_t *prototype)
 {
     nxt_int_t                 ret;
@@ -1667,13 +1845,13 @@ njs_property_prototype_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
     lhq.pool = vm->mem_pool;
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_insert(hash, &lhq);
+    ret = nxt_flathsh_insert(hash, &lhq);
 
     if (nxt_fast_path(ret == NXT_OK)) {
         return &prop->value;
     }
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NULL;
 }
@@ -1877,28 +2055,35 @@ const njs_object_init_t  njs_object_constructor_init = {
 
 /*
  * ES6, 9.1.2: [[SetPrototypeOf]].
+ *
+ * The prototype of a non-extensible object cannot be changed.  This also
+ * covers the objects frozen by njs_vm_freeze(), they are shared by the VM
+ * clones and must not keep a pointer to a memory of a clone.
  */
-static nxt_bool_t
+static nxt_int_t
 njs_object_set_prototype_of(njs_vm_t *vm, njs_object_t *object,
     const njs_value_t *value)
 {
     const njs_object_t *proto;
 
-    proto = njs_is_object(value) ? value->data.u.object->__proto__
-                                 : NULL;
+    proto = njs_is_object(value) ? value->data.u.object : NULL;
 
     if (nxt_slow_path(object->__proto__ == proto)) {
-        return 1;
+        return NXT_OK;
+    }
+
+    if (nxt_slow_path(!object->extensible || object->frozen)) {
+        return NXT_DECLINED;
     }
 
     if (nxt_slow_path(proto == NULL)) {
         object->__proto__ = NULL;
-        return 1;
+        return NXT_OK;
     }
 
     do {
         if (proto == object) {
-            return 0;
+            return NXT_ERROR;
         }
 
         proto = proto->__proto__;
@@ -1907,7 +2092,7 @@ njs_object_set_prototype_of(njs_vm_t *vm, njs_object_t *object,
 
     object->__proto__ = value->data.u.object;
 
-    return 1;
+    return NXT_OK;
 }
 
 
@@ -1915,7 +2100,7 @@ njs_ret_t
 njs_object_prototype_proto(njs_vm_t *vm, njs_value_t *value,
     njs_value_t *setval, njs_value_t *retval)
 {
-    nxt_bool_t    ret;
+    nxt_int_t     ret;
     njs_object_t  *proto, *object;
 
     if (!njs_is_object(value)) {
@@ -1928,7 +2113,14 @@ njs_object_prototype_proto(njs_vm_t *vm, njs_value_t *value,
     if (setval != NULL) {
         if (njs_is_object(setval) || njs_is_null(setval)) {
             ret = njs_object_set_prototype_of(vm, object, setval);
-            if (nxt_slow_path(!ret)) {
+
+            if (nxt_slow_path(ret == NXT_DECLINED)) {
+                njs_type_error(vm, "Cannot set __proto__ of "
+                               "non-extensible object");
+                return NXT_ERROR;
+            }
+
+            if (nxt_slow_path(ret != NXT_OK)) {
                 njs_type_error(vm, "Cyclic __proto__ value");
                 return NXT_ERROR;
             }
@@ -2010,7 +2202,7 @@ found:
 
 
 njs_value_t *
-njs_property_constructor_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_property_constructor_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     njs_value_t *constructor)
 {
     nxt_int_t                 ret;
@@ -2036,13 +2228,13 @@ njs_property_constructor_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
     lhq.pool = vm->mem_pool;
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_insert(hash, &lhq);
+    ret = nxt_flathsh_insert(hash, &lhq);
 
     if (nxt_fast_path(ret == NXT_OK)) {
         return &prop->value;
     }
 
-    njs_internal_error(vm, "lvlhsh insert/replace failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NULL;
 }
@@ -65,7 +65,10 @@ typedef struct {
     /* scratch is used to get the value of an NJS_PROPERTY_HANDLER property. */
     njs_object_prop_t           scratch;
 
-    /* These three fields are used for NJS_EXTERNAL setters. */
+    /*
+     * These three fields are used for NJS_EXTERNAL setters,
+     * ext_index is also used for typed array elements.
+     */
     uintptr_t                   ext_data;
     const njs_extern_t          *ext_proto;
     uint32_t                    ext_index;
@@ -105,7 +108,7 @@ njs_array_t *njs_object_enumerate(njs_vm_t *vm, const njs_object_t *object,
     njs_object_enum_t kind, nxt_bool_t all);
 njs_array_t *njs_object_own_enumerate(njs_vm_t *vm, const njs_object_t *object,
     njs_object_enum_t kind, nxt_bool_t all);
-nxt_int_t njs_object_hash_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+nxt_int_t njs_object_hash_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     const njs_object_prop_t *prop, nxt_uint_t n);
 njs_ret_t njs_object_constructor(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
@@ -113,13 +116,13 @@ njs_ret_t njs_primitive_prototype_get_proto(njs_vm_t *vm, njs_value_t *value,
     njs_value_t *setval, njs_value_t *retval);
 njs_ret_t njs_object_prototype_create(njs_vm_t *vm, njs_value_t *value,
     njs_value_t *setval, njs_value_t *retval);
-njs_value_t *njs_property_prototype_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_value_t *njs_property_prototype_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     njs_object_t *prototype);
 njs_ret_t njs_object_prototype_proto(njs_vm_t *vm, njs_value_t *value,
     njs_value_t *setval, njs_value_t *retval);
 njs_ret_t njs_object_prototype_create_constructor(njs_vm_t *vm,
     njs_value_t *value, njs_value_t *setval, njs_value_t *retval);
-njs_value_t *njs_property_constructor_create(njs_vm_t *vm, nxt_lvlhsh_t *hash,
+njs_value_t *njs_property_constructor_create(njs_vm_t *vm, nxt_flathsh_t *hash,
     njs_value_t *constructor);
 njs_ret_t njs_object_prototype_to_string(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
@@ -139,6 +142,7 @@ njs_ret_t njs_object_prop_define(njs_vm_t *vm, njs_value_t *object,
 njs_ret_t njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
     const njs_value_t *value, const njs_value_t *property);
 njs_ret_t njs_prop_private_copy(njs_vm_t *vm, njs_property_query_t *pq);
+njs_ret_t njs_object_deep_freeze(njs_vm_t *vm, njs_value_t *value);
 const char *njs_prop_type_string(njs_object_prop_type_t type);
 
 extern const njs_object_init_t  njs_object_constructor_init;
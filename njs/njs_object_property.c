@@ -5,6 +5,7 @@
  */
 
 #include <njs_core.h>
+#include <njs_typed_array.h>
 #include <string.h>
 
 
@@ -49,11 +50,12 @@ njs_ret_t
 njs_property_query(njs_vm_t *vm, njs_property_query_t *pq, njs_value_t *object,
     const njs_value_t *property)
 {
-    uint32_t        index;
-    uint32_t        (*hash)(const void *, size_t);
-    njs_ret_t       ret;
-    njs_object_t    *obj;
-    njs_function_t  *function;
+    uint32_t           index;
+    uint32_t           (*hash)(const void *, size_t);
+    njs_ret_t          ret;
+    njs_object_t       *obj;
+    njs_function_t     *function;
+    njs_typed_array_t  *array;
 
     if (nxt_slow_path(!njs_is_primitive(property))) {
         return njs_trap(vm, NJS_TRAP_PROPERTY);
@@ -96,7 +98,23 @@ njs_property_query(njs_vm_t *vm, njs_property_query_t *pq, njs_value_t *object,
     case NJS_OBJECT_SYNTAX_ERROR:
     case NJS_OBJECT_TYPE_ERROR:
     case NJS_OBJECT_URI_ERROR:
+        obj = object->data.u.object;
+        break;
+
     case NJS_OBJECT_VALUE:
+        if (!njs_is_null_or_undefined_or_boolean(property)) {
+            array = njs_typed_array(object);
+
+            if (array != NULL) {
+                index = njs_value_to_index(property);
+
+                if (nxt_fast_path(index != NJS_ARRAY_INVALID_INDEX)) {
+                    return njs_typed_array_property_query(vm, pq, array,
+                                                          index);
+                }
+            }
+        }
+
         obj = object->data.u.object;
         break;
 
@@ -120,12 +138,13 @@ njs_property_query(njs_vm_t *vm, njs_property_query_t *pq, njs_value_t *object,
 
         if (nxt_fast_path(ret == NXT_OK)) {
             njs_string_get(&pq->value, &pq->lhq.key);
-            njs_type_error(vm, "cannot get property \"%V\" of undefined",
-                           &pq->lhq.key);
+            njs_type_error(vm, "cannot get property \"%V\" of %s",
+                           &pq->lhq.key, njs_type_string(object->type));
             return NXT_ERROR;
         }
 
-        njs_type_error(vm, "cannot get property \"unknown\" of undefined");
+        njs_type_error(vm, "cannot get property \"unknown\" of %s",
+                       njs_type_string(object->type));
 
         return NXT_ERROR;
     }
@@ -198,7 +217,7 @@ njs_object_property_query(njs_vm_t *vm, njs_property_query_t *pq,
             }
         }
 
-        ret = nxt_lvlhsh_find(&proto->hash, &pq->lhq);
+        ret = nxt_flathsh_find(&proto->hash, &pq->lhq);
 
         if (ret == NXT_OK) {
             prop = pq->lhq.value;
@@ -212,7 +231,7 @@ njs_object_property_query(njs_vm_t *vm, njs_property_query_t *pq,
             }
 
         } else {
-            ret = nxt_lvlhsh_find(&proto->shared_hash, &pq->lhq);
+            ret = nxt_flathsh_find(&proto->shared_hash, &pq->lhq);
 
             if (ret == NXT_OK) {
                 pq->shared = 1;
@@ -244,7 +263,7 @@ njs_array_property_query(njs_vm_t *vm, njs_property_query_t *pq,
     njs_object_prop_t  *prop;
 
     if (index >= array->length) {
-        if (pq->query != NJS_PROPERTY_QUERY_SET) {
+        if (pq->query != NJS_PROPERTY_QUERY_SET || array->object.frozen) {
             return NXT_DECLINED;
         }
 
@@ -281,9 +300,9 @@ njs_array_property_query(njs_vm_t *vm, njs_property_query_t *pq,
         prop->type = NJS_PROPERTY_REF;
     }
 
-    prop->writable = 1;
+    prop->writable = !array->object.frozen;
     prop->enumerable = 1;
-    prop->configurable = 1;
+    prop->configurable = !array->object.frozen;
 
     pq->lhq.value = prop;
 
@@ -657,7 +676,9 @@ njs_value_property_set(njs_vm_t *vm, njs_value_t *object,
         /* Fall through. */
 
     case NXT_DECLINED:
-        if (nxt_slow_path(pq.own_whiteout != NULL)) {
+        if (nxt_slow_path(pq.own_whiteout != NULL
+                          && object->data.u.object->extensible))
+        {
             /* Previously deleted property. */
             prop = pq.own_whiteout;
 
@@ -698,9 +719,9 @@ njs_value_property_set(njs_vm_t *vm, njs_value_t *object,
     pq.lhq.value = prop;
     pq.lhq.pool = vm->mem_pool;
 
-    ret = nxt_lvlhsh_insert(&object->data.u.object->hash, &pq.lhq);
+    ret = nxt_flathsh_insert(&object->data.u.object->hash, &pq.lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
@@ -754,13 +775,13 @@ njs_object_property(njs_vm_t *vm, const njs_object_t *object,
     lhq->proto = &njs_object_hash_proto;
 
     do {
-        ret = nxt_lvlhsh_find(&object->hash, lhq);
+        ret = nxt_flathsh_find(&object->hash, lhq);
 
         if (nxt_fast_path(ret == NXT_OK)) {
             return lhq->value;
         }
 
-        ret = nxt_lvlhsh_find(&object->shared_hash, lhq);
+        ret = nxt_flathsh_find(&object->shared_hash, lhq);
 
         if (nxt_fast_path(ret == NXT_OK)) {
             return lhq->value;
@@ -848,9 +869,9 @@ njs_object_prop_define(njs_vm_t *vm, njs_value_t *object,
             pq.lhq.replace = 0;
             pq.lhq.pool = vm->mem_pool;
 
-            ret = nxt_lvlhsh_insert(&object->data.u.object->hash, &pq.lhq);
+            ret = nxt_flathsh_insert(&object->data.u.object->hash, &pq.lhq);
             if (nxt_slow_path(ret != NXT_OK)) {
-                njs_internal_error(vm, "lvlhsh insert failed");
+                njs_lvlhsh_insert_error(vm, ret);
                 return NXT_ERROR;
             }
         }
@@ -1218,9 +1239,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
         lhq.value = pr;
 
-        ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+        ret = nxt_flathsh_insert(&desc->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
 
@@ -1236,9 +1257,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
         lhq.value = pr;
 
-        ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+        ret = nxt_flathsh_insert(&desc->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
 
@@ -1255,9 +1276,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
         lhq.value = pr;
 
-        ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+        ret = nxt_flathsh_insert(&desc->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
 
@@ -1272,9 +1293,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
         lhq.value = pr;
 
-        ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+        ret = nxt_flathsh_insert(&desc->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
     }
@@ -1291,9 +1312,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
     lhq.value = pr;
 
-    ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+    ret = nxt_flathsh_insert(&desc->hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
@@ -1309,9 +1330,9 @@ njs_object_prop_descriptor(njs_vm_t *vm, njs_value_t *dest,
 
     lhq.value = pr;
 
-    ret = nxt_lvlhsh_insert(&desc->hash, &lhq);
+    ret = nxt_flathsh_insert(&desc->hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
@@ -1347,9 +1368,9 @@ njs_prop_private_copy(njs_vm_t *vm, njs_property_query_t *pq)
     pq->lhq.value = prop;
     pq->lhq.pool = vm->mem_pool;
 
-    ret = nxt_lvlhsh_insert(&pq->prototype->hash, &pq->lhq);
+    ret = nxt_flathsh_insert(&pq->prototype->hash, &pq->lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
@@ -1383,9 +1404,9 @@ njs_prop_private_copy(njs_vm_t *vm, njs_property_query_t *pq)
     lhq.proto = &njs_object_hash_proto;
     lhq.pool = vm->mem_pool;
 
-    ret = nxt_lvlhsh_insert(&function->object.hash, &lhq);
+    ret = nxt_flathsh_insert(&function->object.hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
-        njs_internal_error(vm, "lvlhsh insert failed");
+        njs_lvlhsh_insert_error(vm, ret);
         return NXT_ERROR;
     }
 
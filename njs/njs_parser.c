@@ -23,7 +23,7 @@ static njs_token_t njs_parser_block(njs_vm_t *vm,
 static njs_token_t njs_parser_labelled_statement(njs_vm_t *vm,
     njs_parser_t *parser);
 static njs_token_t njs_parser_function_declaration(njs_vm_t *vm,
-    njs_parser_t *parser);
+    njs_parser_t *parser, nxt_bool_t async);
 static njs_token_t njs_parser_function_lambda(njs_vm_t *vm,
     njs_parser_t *parser, njs_function_lambda_t *lambda, njs_token_t token);
 static njs_token_t njs_parser_lambda_arguments(njs_vm_t *vm,
@@ -33,12 +33,26 @@ static njs_token_t njs_parser_lambda_argument(njs_vm_t *vm,
     njs_parser_t *parser, njs_index_t index);
 static njs_token_t njs_parser_lambda_body(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
+static njs_token_t njs_parser_lambda_skip(njs_vm_t *vm, njs_parser_t *parser,
+    njs_function_lambda_t *lambda);
+static nxt_int_t njs_parser_lambda_name(njs_vm_t *vm, njs_parser_t *parser,
+    njs_lexer_token_t *lt);
+static nxt_int_t njs_parser_template_skip(njs_lexer_t *lexer);
 static njs_parser_node_t *njs_parser_return_set(njs_vm_t *vm,
     njs_parser_t *parser, njs_parser_node_t *expr);
 static njs_token_t njs_parser_return_statement(njs_vm_t *vm,
     njs_parser_t *parser);
 static njs_token_t njs_parser_var_statement(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t parent, nxt_bool_t var_in);
+static nxt_int_t njs_parser_pattern(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern);
+static njs_parser_node_t *njs_parser_pattern_rest(njs_vm_t *vm,
+    njs_parser_t *parser, njs_parser_node_t *pattern, nxt_bool_t array);
+static njs_parser_node_t *njs_parser_pattern_element(njs_vm_t *vm,
+    njs_parser_t *parser, njs_parser_node_t *assign, njs_parser_node_t *target,
+    njs_parser_node_t *value);
+static nxt_int_t njs_parser_pattern_declare(njs_vm_t *vm,
+    njs_parser_t *parser, njs_parser_node_t *pattern);
 static njs_token_t njs_parser_if_statement(njs_vm_t *vm, njs_parser_t *parser);
 static njs_token_t njs_parser_switch_statement(njs_vm_t *vm,
     njs_parser_t *parser);
@@ -51,6 +65,10 @@ static njs_token_t njs_parser_var_in_statement(njs_vm_t *vm,
     njs_parser_t *parser, njs_parser_node_t *name);
 static njs_token_t njs_parser_for_in_statement(njs_vm_t *vm,
     njs_parser_t *parser, nxt_str_t *name, njs_token_t token);
+static njs_token_t njs_parser_for_of_statement(njs_vm_t *vm,
+    njs_parser_t *parser, nxt_str_t *name);
+static njs_token_t njs_parser_for_of(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *target);
 static njs_token_t njs_parser_brk_statement(njs_vm_t *vm,
     njs_parser_t *parser, njs_token_t token);
 static njs_token_t njs_parser_try_statement(njs_vm_t *vm, njs_parser_t *parser);
@@ -64,6 +82,8 @@ static njs_token_t njs_parser_export_statement(njs_vm_t *vm,
 static nxt_int_t njs_parser_export_sink(njs_vm_t *vm, njs_parser_t *parser);
 static njs_token_t njs_parser_grouping_expression(njs_vm_t *vm,
     njs_parser_t *parser);
+static nxt_int_t njs_parser_arrow_match(njs_vm_t *vm, njs_parser_t *parser,
+    njs_token_t token, size_t offset);
 
 
 #define njs_parser_chain_current(parser)                            \
@@ -76,6 +96,29 @@ static njs_token_t njs_parser_grouping_expression(njs_vm_t *vm,
     (parser)->scope->top = node
 
 
+/* "of" is not a reserved word and is parsed as a name. */
+
+#define njs_parser_is_of(parser, token)                                       \
+    ((token) == NJS_TOKEN_NAME                                                \
+     && nxt_strstr_eq(njs_parser_text(parser), &njs_parser_of_name))
+
+
+static const nxt_str_t  njs_parser_of_name = nxt_string("of");
+
+
+/*
+ * "async" is not a reserved word either, it starts an async function
+ * only if "function" or an arrow function follows.
+ */
+
+#define njs_parser_is_async(parser, token)                                    \
+    ((token) == NJS_TOKEN_NAME                                                \
+     && nxt_strstr_eq(njs_parser_text(parser), &njs_parser_async_name))
+
+
+static const nxt_str_t  njs_parser_async_name = nxt_string("async");
+
+
 nxt_int_t
 njs_parser(njs_vm_t *vm, njs_parser_t *parser, njs_parser_t *prev)
 {
@@ -338,7 +381,7 @@ njs_parser_statement(njs_vm_t *vm, njs_parser_t *parser,
     switch (token) {
 
     case NJS_TOKEN_FUNCTION:
-        return njs_parser_function_declaration(vm, parser);
+        return njs_parser_function_declaration(vm, parser, 0);
 
     case NJS_TOKEN_IF:
         return njs_parser_if_statement(vm, parser);
@@ -407,6 +450,15 @@ njs_parser_statement(njs_vm_t *vm, njs_parser_t *parser,
                 return njs_parser_labelled_statement(vm, parser);
             }
 
+            if (njs_parser_is_async(parser, token)
+                && njs_lexer_peek_token(vm, parser->lexer, 0)
+                   == NJS_TOKEN_FUNCTION)
+            {
+                (void) njs_parser_token(vm, parser);
+
+                return njs_parser_function_declaration(vm, parser, 1);
+            }
+
             /* Fall through. */
 
         default:
@@ -596,7 +648,7 @@ njs_parser_labelled_statement(njs_vm_t *vm, njs_parser_t *parser)
 
 static njs_function_t *
 njs_parser_function_alloc(njs_vm_t *vm, njs_parser_t *parser,
-    njs_variable_t *var)
+    njs_variable_t *var, nxt_bool_t async)
 {
     njs_value_t            *value;
     njs_function_t         *function;
@@ -608,6 +660,8 @@ njs_parser_function_alloc(njs_vm_t *vm, njs_parser_t *parser,
         return NULL;
     }
 
+    lambda->async = async;
+
     /* TODO:
      *  njs_function_t is used to pass lambda to
      *  njs_generate_function_declaration() and is not actually needed.
@@ -635,7 +689,8 @@ njs_parser_function_alloc(njs_vm_t *vm, njs_parser_t *parser,
 
 
 static njs_token_t
-njs_parser_function_declaration(njs_vm_t *vm, njs_parser_t *parser)
+njs_parser_function_declaration(njs_vm_t *vm, njs_parser_t *parser,
+    nxt_bool_t async)
 {
     njs_ret_t          ret;
     njs_token_t        token;
@@ -682,7 +737,7 @@ njs_parser_function_declaration(njs_vm_t *vm, njs_parser_t *parser)
 
     parser->node = node;
 
-    function = njs_parser_function_alloc(vm, parser, var);
+    function = njs_parser_function_alloc(vm, parser, var, async);
     if (nxt_slow_path(function == NULL)) {
         return NJS_TOKEN_ERROR;
     }
@@ -694,7 +749,8 @@ njs_parser_function_declaration(njs_vm_t *vm, njs_parser_t *parser)
 
 
 njs_token_t
-njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser)
+njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser,
+    nxt_bool_t async)
 {
     njs_ret_t              ret;
     njs_token_t            token;
@@ -736,7 +792,7 @@ njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser)
             return token;
         }
 
-        function = njs_parser_function_alloc(vm, parser, var);
+        function = njs_parser_function_alloc(vm, parser, var, async);
         if (nxt_slow_path(function == NULL)) {
             return NJS_TOKEN_ERROR;
         }
@@ -749,6 +805,8 @@ njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser)
         if (nxt_slow_path(lambda == NULL)) {
             return NJS_TOKEN_ERROR;
         }
+
+        lambda->async = async;
     }
 
     node->u.value.data.u.lambda = lambda;
@@ -767,12 +825,15 @@ njs_parser_function_lambda(njs_vm_t *vm, njs_parser_t *parser,
 {
     njs_ret_t    ret;
     njs_index_t  index;
+    njs_token_t  next;
 
     ret = njs_parser_scope_begin(vm, parser, NJS_SCOPE_FUNCTION);
     if (nxt_slow_path(ret != NXT_OK)) {
         return NJS_TOKEN_ERROR;
     }
 
+    parser->scope->async = lambda->async;
+
     index = NJS_SCOPE_ARGUMENTS;
 
     /* A "this" reservation. */
@@ -783,7 +844,14 @@ njs_parser_function_lambda(njs_vm_t *vm, njs_parser_t *parser,
         return token;
     }
 
-    token = njs_parser_lambda_body(vm, parser, token);
+    next = NJS_TOKEN_AGAIN;
+
+    if (vm->options.lazy && token == NJS_TOKEN_OPEN_BRACE) {
+        next = njs_parser_lambda_skip(vm, parser, lambda);
+    }
+
+    token = (next != NJS_TOKEN_AGAIN) ? next
+                                      : njs_parser_lambda_body(vm, parser, token);
     if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
         return token;
     }
@@ -920,6 +988,341 @@ njs_parser_lambda_body(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token)
 }
 
 
+/*
+ * The pre-parser of the lazy mode skips a function body up to the matching
+ * closing brace and saves the body source to parse it on the first call.
+ * The names used in the body are added to the function scope as references,
+ * so the outer variables captured by the body and the built-in objects are
+ * allocated at compile time.  The body is parsed at once if it has a regexp
+ * literal, a slash after a closing parenthesis or brace, which may start
+ * a regexp literal, or a token which fails the whole parse.
+ */
+
+#define NJS_PARSER_SKIP_NESTING  64
+
+
+static njs_token_t
+njs_parser_lambda_skip(njs_vm_t *vm, njs_parser_t *parser,
+    njs_function_lambda_t *lambda)
+{
+    u_char               *start, *p;
+    size_t               size;
+    uint32_t             line;
+    nxt_int_t            ret;
+    nxt_uint_t           level;
+    njs_token_t          token, prev;
+    njs_lexer_t          lexer;
+    njs_parser_node_t    *node;
+    njs_parser_source_t  *source;
+    uint8_t              open[NJS_PARSER_SKIP_NESTING];
+
+    if (!nxt_queue_is_empty(&parser->lexer->preread)) {
+        return NJS_TOKEN_AGAIN;
+    }
+
+    /* The current token is the opening brace of the body. */
+
+    start = parser->lexer->lexer_token->text.start;
+    line = parser->lexer->line;
+
+    lexer = *parser->lexer;
+    lexer.lexer_token = NULL;
+    nxt_queue_init(&lexer.preread);
+
+    open[0] = NJS_TOKEN_OPEN_BRACE;
+    level = 1;
+    prev = NJS_TOKEN_OPEN_BRACE;
+
+    for ( ;; ) {
+        token = njs_lexer_token(vm, &lexer);
+
+        switch (token) {
+
+        case NJS_TOKEN_LINE_END:
+            continue;
+
+        case NJS_TOKEN_OPEN_PARENTHESIS:
+        case NJS_TOKEN_OPEN_BRACKET:
+        case NJS_TOKEN_OPEN_BRACE:
+            if (level == NJS_PARSER_SKIP_NESTING) {
+                goto again;
+            }
+
+            open[level++] = token;
+            break;
+
+        case NJS_TOKEN_CLOSE_PARENTHESIS:
+        case NJS_TOKEN_CLOSE_BRACKET:
+        case NJS_TOKEN_CLOSE_BRACE:
+            level--;
+
+            if (open[level] == NJS_TOKEN_GRAVE
+                && token == NJS_TOKEN_CLOSE_BRACE)
+            {
+                /* The end of a template literal substitution. */
+                token = NJS_TOKEN_GRAVE;
+                goto template;
+            }
+
+            /* The closing tokens follow the opening ones. */
+
+            if (open[level] + 1 != token) {
+                goto again;
+            }
+
+            if (level == 0) {
+                goto done;
+            }
+
+            break;
+
+        case NJS_TOKEN_GRAVE:
+        template:
+
+            ret = njs_parser_template_skip(&lexer);
+
+            if (ret == NXT_ERROR) {
+                goto again;
+            }
+
+            if (ret == NXT_AGAIN) {
+                if (level == NJS_PARSER_SKIP_NESTING) {
+                    goto again;
+                }
+
+                open[level++] = NJS_TOKEN_GRAVE;
+                token = NJS_TOKEN_OPEN_BRACE;
+                break;
+            }
+
+            token = NJS_TOKEN_STRING;
+            break;
+
+        case NJS_TOKEN_DIVISION:
+        case NJS_TOKEN_DIVISION_ASSIGNMENT:
+            switch (prev) {
+            case NJS_TOKEN_NAME:
+            case NJS_TOKEN_UNDEFINED:
+            case NJS_TOKEN_NULL:
+            case NJS_TOKEN_NUMBER:
+            case NJS_TOKEN_BOOLEAN:
+            case NJS_TOKEN_STRING:
+            case NJS_TOKEN_ESCAPE_STRING:
+            case NJS_TOKEN_CLOSE_BRACKET:
+            case NJS_TOKEN_THIS:
+            case NJS_TOKEN_ARGUMENTS:
+                break;
+
+            default:
+                if (prev < NJS_TOKEN_FIRST_OBJECT
+                    || prev > NJS_TOKEN_CLEAR_INTERVAL)
+                {
+                    goto again;
+                }
+            }
+
+            break;
+
+        case NJS_TOKEN_ERROR:
+            return NJS_TOKEN_ERROR;
+
+        case NJS_TOKEN_ILLEGAL:
+        case NJS_TOKEN_END:
+        case NJS_TOKEN_UNTERMINATED_STRING:
+        case NJS_TOKEN_IMPORT:
+        case NJS_TOKEN_EXPORT:
+            goto again;
+
+        default:
+            if (prev == NJS_TOKEN_DOT) {
+                /* A property name. */
+                token = NJS_TOKEN_NAME;
+                break;
+            }
+
+            if (token == NJS_TOKEN_NAME
+                || (token > NJS_TOKEN_FIRST_OBJECT
+                    && token <= NJS_TOKEN_CLEAR_INTERVAL))
+            {
+                ret = njs_parser_lambda_name(vm, parser, lexer.lexer_token);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return NJS_TOKEN_ERROR;
+                }
+            }
+
+            break;
+        }
+
+        prev = token;
+    }
+
+done:
+
+    size = lexer.start - start;
+
+    source = nxt_mp_alloc(vm->mem_pool, sizeof(njs_parser_source_t) + size);
+    if (nxt_slow_path(source == NULL)) {
+        return NJS_TOKEN_ERROR;
+    }
+
+    p = (u_char *) source + sizeof(njs_parser_source_t);
+    memcpy(p, start, size);
+
+    source->text.start = p;
+    source->text.length = size;
+    source->file = lexer.file;
+    source->line = line;
+    source->error = 0;
+    source->message.length = 0;
+    source->message.start = NULL;
+
+    lambda->source = source;
+
+    nxt_mp_free(vm->mem_pool, lexer.lexer_token);
+
+    parser->lexer->start = lexer.start;
+    parser->lexer->line = lexer.line;
+
+    /* The body is replaced when the source is parsed. */
+
+    node = parser->node;
+
+    node->right = njs_parser_return_set(vm, parser, NULL);
+    if (nxt_slow_path(node->right == NULL)) {
+        return NJS_TOKEN_ERROR;
+    }
+
+    return njs_parser_token(vm, parser);
+
+again:
+
+    nxt_mp_free(vm->mem_pool, lexer.lexer_token);
+
+    return NJS_TOKEN_AGAIN;
+}
+
+
+static nxt_int_t
+njs_parser_lambda_name(njs_vm_t *vm, njs_parser_t *parser,
+    njs_lexer_token_t *lt)
+{
+    njs_parser_node_t   *node;
+    njs_parser_scope_t  *scope;
+    nxt_lvlhsh_query_t  lhq;
+
+    /* Built-in objects are referenced in the global scope. */
+
+    scope = (lt->token == NJS_TOKEN_NAME) ? parser->scope
+                                          : njs_parser_global_scope(vm);
+
+    lhq.key_hash = lt->key_hash;
+    lhq.key = lt->text;
+    lhq.proto = &njs_references_hash_proto;
+
+    if (nxt_lvlhsh_find(&scope->references, &lhq) == NXT_OK) {
+        return NXT_OK;
+    }
+
+    node = njs_parser_reference(vm, parser, lt->token, &lt->text,
+                                lt->key_hash, lt->token_line);
+    if (nxt_slow_path(node == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (node->token == NJS_TOKEN_EXTERNAL) {
+        nxt_mp_free(vm->mem_pool, node);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_parser_template_skip(njs_lexer_t *lexer)
+{
+    u_char  c, *p;
+
+    p = lexer->start;
+
+    while (p < lexer->end) {
+
+        c = *p++;
+
+        if (c == '\\') {
+            if (p == lexer->end) {
+                break;
+            }
+
+            p++;
+
+            continue;
+        }
+
+        if (c == '`') {
+            lexer->start = p;
+            return NXT_OK;
+        }
+
+        if (c == '$' && p < lexer->end && *p == '{') {
+            lexer->start = p + 1;
+            return NXT_AGAIN;
+        }
+    }
+
+    return NXT_ERROR;
+}
+
+
+/*
+ * Parses the body of a function skipped by the pre-parser.  The parser
+ * continues in the function scope, so the body is parsed exactly as it
+ * would be at compile time.
+ */
+
+nxt_int_t
+njs_parser_lambda_source(njs_vm_t *vm, njs_parser_node_t *node,
+    njs_parser_source_t *source)
+{
+    nxt_int_t           ret;
+    njs_token_t         token;
+    njs_lexer_t         lexer;
+    njs_parser_t        parser, *prev;
+    njs_parser_scope_t  *scope;
+
+    ret = njs_lexer_init(vm, &lexer, &source->file, source->text.start,
+                         source->text.start + source->text.length);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    lexer.line = source->line;
+
+    scope = node->right->scope;
+    scope->top = NULL;
+
+    parser.lexer = &lexer;
+    parser.node = node;
+    parser.scope = scope;
+
+    prev = vm->parser;
+    vm->parser = &parser;
+
+    token = njs_parser_token(vm, &parser);
+
+    if (nxt_fast_path(token > NJS_TOKEN_ILLEGAL)) {
+        token = njs_parser_lambda_body(vm, &parser, token);
+    }
+
+    vm->parser = prev;
+
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return NXT_ERROR;
+    }
+
+    return njs_variables_lambda_reference(vm, scope);
+}
+
+
 static njs_parser_node_t *
 njs_parser_return_set(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *expr)
@@ -1013,114 +1416,476 @@ njs_parser_return_statement(njs_vm_t *vm, njs_parser_t *parser)
     case NJS_TOKEN_END:
         return token;
 
-    default:
-        token = njs_parser_expression(vm, parser, token);
-        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
-            return token;
+    default:
+        token = njs_parser_expression(vm, parser, token);
+        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+            return token;
+        }
+
+        if (parser->node->token == NJS_TOKEN_FUNCTION) {
+            /* TODO: test closure */
+        }
+
+        node->right = parser->node;
+        parser->node = node;
+
+        return token;
+    }
+}
+
+
+static njs_token_t
+njs_parser_var_statement(njs_vm_t *vm, njs_parser_t *parser, njs_token_t parent,
+    nxt_bool_t var_in)
+{
+    nxt_int_t            ret;
+    njs_token_t          token;
+    njs_parser_node_t    *left, *stmt, *name, *assign, *expr;
+    njs_variable_type_t  type;
+
+    type = NJS_VARIABLE_VAR;
+
+    parser->node = NULL;
+    left = NULL;
+
+    do {
+        token = njs_parser_token(vm, parser);
+        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+            return token;
+        }
+
+        if (token == NJS_TOKEN_OPEN_BRACE || token == NJS_TOKEN_OPEN_BRACKET) {
+            token = njs_parser_terminal(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            name = parser->node;
+
+            ret = njs_parser_destructuring(vm, parser, name, 1);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NJS_TOKEN_ILLEGAL;
+            }
+
+        } else {
+            if (token != NJS_TOKEN_NAME) {
+                if (token == NJS_TOKEN_ARGUMENTS || token == NJS_TOKEN_EVAL) {
+                    njs_parser_syntax_error(vm, parser, "Identifier \"%V\" "
+                                            "is forbidden in var declaration",
+                                            njs_parser_text(parser));
+                }
+
+                return NJS_TOKEN_ILLEGAL;
+            }
+
+            name = njs_parser_variable_node(vm, parser,
+                                            njs_parser_text(parser),
+                                            njs_parser_key_hash(parser),
+                                            type);
+            if (nxt_slow_path(name == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+        }
+
+        if (var_in) {
+            if (njs_parser_is_of(parser, token)) {
+                return njs_parser_for_of(vm, parser, name);
+            }
+
+            if (token == NJS_TOKEN_IN && name->token == NJS_TOKEN_NAME) {
+                return njs_parser_var_in_statement(vm, parser, name);
+            }
+
+            var_in = 0;
+        }
+
+        expr = NULL;
+
+        if (token == NJS_TOKEN_ASSIGNMENT) {
+
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            token = njs_parser_assignment_expression(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            expr = parser->node;
+        }
+
+        if (name->token == NJS_TOKEN_DESTRUCTURING) {
+            if (expr == NULL) {
+                njs_parser_syntax_error(vm, parser, "Missing initializer "
+                                        "in destructuring declaration");
+                return NJS_TOKEN_ILLEGAL;
+            }
+
+            name->right = expr;
+            assign = name;
+
+        } else {
+            assign = njs_parser_node_new(vm, parser, parent);
+            if (nxt_slow_path(assign == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            assign->u.operation = njs_vmcode_move;
+            assign->left = name;
+            assign->right = expr;
+        }
+
+        stmt = njs_parser_node_new(vm, parser, NJS_TOKEN_STATEMENT);
+        if (nxt_slow_path(stmt == NULL)) {
+            return NJS_TOKEN_ERROR;
+        }
+
+        stmt->left = left;
+        stmt->right = assign;
+        parser->node = stmt;
+
+        left = stmt;
+
+    } while (token == NJS_TOKEN_COMMA);
+
+    return token;
+}
+
+
+/*
+ * An object or array literal followed by "=" or "of" is a destructuring
+ * pattern.  The literal property initializations are turned in place
+ * into assignments of the source value properties to the targets,
+ * so the pattern is compiled to plain property_get operations:
+ *
+ *   DESTRUCTURING: right is the source value,
+ *                  left is a chain of the element assignments, where
+ *                  the element value is PROPERTY(OBJECT_VALUE(pattern), key).
+ *
+ * A default value is handled by a nested pattern with a single element:
+ * target = (value === undefined) ? default : value.
+ *
+ * The rest element is the last spread element of the literal, its value is
+ *   REST: left is OBJECT_VALUE(pattern),
+ *         right is the index of the first element of the rest array
+ *         or an array of the property names excluded from the rest object.
+ */
+
+nxt_int_t
+njs_parser_destructuring(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern, nxt_bool_t var)
+{
+    nxt_int_t  ret;
+
+    ret = njs_parser_pattern(vm, parser, pattern);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    if (var) {
+        return njs_parser_pattern_declare(vm, parser, pattern);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_parser_pattern(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern)
+{
+    nxt_int_t          ret;
+    nxt_bool_t         array;
+    njs_parser_node_t  *stmt, *assign, *property, *target, *expr, *node,
+                       *value, *cond, *branch, *undef;
+
+    array = (pattern->token == NJS_TOKEN_ARRAY);
+
+    pattern->token = NJS_TOKEN_DESTRUCTURING;
+
+    for (stmt = pattern->left; stmt != NULL; stmt = stmt->left) {
+        assign = stmt->right;
+
+        if (assign->token == NJS_TOKEN_ELLIPSIS) {
+            if (stmt != pattern->left) {
+                njs_parser_syntax_error(vm, parser,
+                                        "Rest element must be last element");
+                return NXT_ERROR;
+            }
+
+            target = assign->left;
+
+            if (array
+                && (target->token == NJS_TOKEN_OBJECT
+                    || target->token == NJS_TOKEN_ARRAY))
+            {
+                ret = njs_parser_pattern(vm, parser, target);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return ret;
+                }
+
+            } else if (target->token != NJS_TOKEN_NAME
+                       && target->token != NJS_TOKEN_PROPERTY)
+            {
+                njs_parser_syntax_error(vm, parser, "Invalid rest element");
+                return NXT_ERROR;
+            }
+
+            value = njs_parser_pattern_rest(vm, parser, pattern, array);
+            if (nxt_slow_path(value == NULL)) {
+                return NXT_ERROR;
+            }
+
+            value->left = assign->right;
+
+            stmt->right = njs_parser_pattern_element(vm, parser, assign,
+                                                     target, value);
+            continue;
+        }
+
+        property = assign->left;
+        target = assign->right;
+
+        property->token = NJS_TOKEN_PROPERTY;
+        property->u.operation = njs_vmcode_property_get;
+
+        expr = NULL;
+
+        if (target->token == NJS_TOKEN_ASSIGNMENT
+            || target->token == NJS_TOKEN_DESTRUCTURING)
+        {
+            /* The target with a default value. */
+            expr = target->right;
+
+            if (target->token == NJS_TOKEN_ASSIGNMENT) {
+                target = target->left;
+
+            } else {
+                target->right = NULL;
+            }
+        }
+
+        switch (target->token) {
+
+        case NJS_TOKEN_OBJECT:
+        case NJS_TOKEN_ARRAY:
+            ret = njs_parser_pattern(vm, parser, target);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            break;
+
+        case NJS_TOKEN_NAME:
+        case NJS_TOKEN_PROPERTY:
+        case NJS_TOKEN_DESTRUCTURING:
+            break;
+
+        default:
+            njs_parser_syntax_error(vm, parser,
+                                    "Invalid destructuring assignment target");
+            return NXT_ERROR;
+        }
+
+        if (expr == NULL) {
+            stmt->right = njs_parser_pattern_element(vm, parser, assign,
+                                                     target, property);
+            continue;
+        }
+
+        node = njs_parser_node_new(vm, parser, NJS_TOKEN_DESTRUCTURING);
+        if (nxt_slow_path(node == NULL)) {
+            return NXT_ERROR;
+        }
+
+        node->right = property;
+
+        value = njs_parser_node_new(vm, parser, NJS_TOKEN_OBJECT_VALUE);
+        if (nxt_slow_path(value == NULL)) {
+            return NXT_ERROR;
+        }
+
+        value->u.object = node;
+
+        undef = njs_parser_node_new(vm, parser, NJS_TOKEN_UNDEFINED);
+        if (nxt_slow_path(undef == NULL)) {
+            return NXT_ERROR;
+        }
+
+        undef->u.value = njs_value_undefined;
+
+        cond = njs_parser_node_new(vm, parser, NJS_TOKEN_STRICT_EQUAL);
+        if (nxt_slow_path(cond == NULL)) {
+            return NXT_ERROR;
+        }
+
+        cond->u.operation = njs_vmcode_strict_equal;
+        cond->left = value;
+        cond->right = undef;
+
+        branch = njs_parser_node_new(vm, parser, NJS_TOKEN_BRANCHING);
+        if (nxt_slow_path(branch == NULL)) {
+            return NXT_ERROR;
+        }
+
+        branch->left = expr;
+
+        branch->right = njs_parser_node_new(vm, parser, NJS_TOKEN_OBJECT_VALUE);
+        if (nxt_slow_path(branch->right == NULL)) {
+            return NXT_ERROR;
         }
 
-        if (parser->node->token == NJS_TOKEN_FUNCTION) {
-            /* TODO: test closure */
+        branch->right->u.object = node;
+
+        value = njs_parser_node_new(vm, parser, NJS_TOKEN_CONDITIONAL);
+        if (nxt_slow_path(value == NULL)) {
+            return NXT_ERROR;
         }
 
-        node->right = parser->node;
-        parser->node = node;
+        value->left = cond;
+        value->right = branch;
+        branch->left->dest = value;
+        branch->right->dest = value;
 
-        return token;
+        node->left = njs_parser_node_new(vm, parser, NJS_TOKEN_STATEMENT);
+        if (nxt_slow_path(node->left == NULL)) {
+            return NXT_ERROR;
+        }
+
+        node->left->right = njs_parser_pattern_element(vm, parser, assign,
+                                                       target, value);
+        stmt->right = node;
     }
+
+    return NXT_OK;
 }
 
 
-static njs_token_t
-njs_parser_var_statement(njs_vm_t *vm, njs_parser_t *parser, njs_token_t parent,
-    nxt_bool_t var_in)
+static njs_parser_node_t *
+njs_parser_pattern_rest(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern, nxt_bool_t array)
 {
-    njs_token_t          token;
-    njs_parser_node_t    *left, *stmt, *name, *assign, *expr;
-    njs_variable_type_t  type;
-
-    type = NJS_VARIABLE_VAR;
+    nxt_int_t          ret;
+    njs_parser_node_t  *rest, *stmt, *key, *name;
 
-    parser->node = NULL;
-    left = NULL;
+    rest = njs_parser_node_new(vm, parser, NJS_TOKEN_REST);
+    if (nxt_slow_path(rest == NULL)) {
+        return NULL;
+    }
 
-    do {
-        token = njs_parser_token(vm, parser);
-        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
-            return token;
+    if (array) {
+        key = njs_parser_node_new(vm, parser, NJS_TOKEN_NUMBER);
+        if (nxt_slow_path(key == NULL)) {
+            return NULL;
         }
 
-        if (token != NJS_TOKEN_NAME) {
-            if (token == NJS_TOKEN_ARGUMENTS || token == NJS_TOKEN_EVAL) {
-                njs_parser_syntax_error(vm, parser, "Identifier \"%V\" "
-                                        "is forbidden in var declaration",
-                                        njs_parser_text(parser));
-            }
+        key->u.value.data.u.number = pattern->u.length;
+        key->u.value.type = NJS_NUMBER;
+        key->u.value.data.truth = (pattern->u.length != 0);
 
-            return NJS_TOKEN_ILLEGAL;
+        rest->right = key;
+
+        return rest;
+    }
+
+    rest->right = njs_parser_node_new(vm, parser, NJS_TOKEN_ARRAY);
+    if (nxt_slow_path(rest->right == NULL)) {
+        return NULL;
+    }
+
+    /* The other elements are not converted yet. */
+
+    for (stmt = pattern->left->left; stmt != NULL; stmt = stmt->left) {
+        if (stmt->right->token == NJS_TOKEN_ELLIPSIS) {
+            /* Reported as not the last element. */
+            continue;
         }
 
-        name = njs_parser_variable_node(vm, parser,
-                                        njs_parser_text(parser),
-                                        njs_parser_key_hash(parser),
-                                        type);
+        key = stmt->right->left->right;
+
+        name = njs_parser_node_new(vm, parser, key->token);
         if (nxt_slow_path(name == NULL)) {
-            return NJS_TOKEN_ERROR;
+            return NULL;
         }
 
-        token = njs_parser_token(vm, parser);
-        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
-            return token;
+        name->u.value = key->u.value;
+
+        ret = njs_parser_array_item(vm, parser, rest->right, name);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
         }
+    }
 
-        if (var_in) {
-            if (token == NJS_TOKEN_IN) {
-                return njs_parser_var_in_statement(vm, parser, name);
-            }
+    return rest;
+}
 
-            var_in = 0;
-        }
 
-        expr = NULL;
+static njs_parser_node_t *
+njs_parser_pattern_element(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *assign, njs_parser_node_t *target,
+    njs_parser_node_t *value)
+{
+    if (target->token == NJS_TOKEN_DESTRUCTURING) {
+        target->right = value;
+        return target;
+    }
 
-        if (token == NJS_TOKEN_ASSIGNMENT) {
+    assign->token = NJS_TOKEN_ASSIGNMENT;
+    assign->u.operation = njs_vmcode_move;
+    assign->left = target;
+    assign->right = value;
 
-            token = njs_parser_token(vm, parser);
-            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
-                return token;
-            }
+    return assign;
+}
 
-            token = njs_parser_assignment_expression(vm, parser, token);
-            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
-                return token;
-            }
 
-            expr = parser->node;
-        }
+static nxt_int_t
+njs_parser_pattern_declare(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern)
+{
+    nxt_int_t          ret;
+    njs_variable_t     *var;
+    njs_parser_node_t  *stmt, *node;
 
-        assign = njs_parser_node_new(vm, parser, parent);
-        if (nxt_slow_path(assign == NULL)) {
-            return NJS_TOKEN_ERROR;
-        }
+    for (stmt = pattern->left; stmt != NULL; stmt = stmt->left) {
+        node = stmt->right;
 
-        assign->u.operation = njs_vmcode_move;
-        assign->left = name;
-        assign->right = expr;
+        if (node->token == NJS_TOKEN_DESTRUCTURING) {
+            ret = njs_parser_pattern_declare(vm, parser, node);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
 
-        stmt = njs_parser_node_new(vm, parser, NJS_TOKEN_STATEMENT);
-        if (nxt_slow_path(stmt == NULL)) {
-            return NJS_TOKEN_ERROR;
+            continue;
         }
 
-        stmt->left = left;
-        stmt->right = assign;
-        parser->node = stmt;
+        node = node->left;
 
-        left = stmt;
+        if (node->token != NJS_TOKEN_NAME) {
+            njs_parser_syntax_error(vm, parser,
+                                    "Invalid destructuring declaration target");
+            return NXT_ERROR;
+        }
 
-    } while (token == NJS_TOKEN_COMMA);
+        var = njs_variable_add(vm, parser->scope, &node->u.reference.name,
+                               node->u.reference.hash, NJS_VARIABLE_VAR);
+        if (nxt_slow_path(var == NULL)) {
+            return NXT_ERROR;
+        }
 
-    return token;
+        if (njs_is_null(&var->value)) {
+            var->value = njs_value_undefined;
+        }
+    }
+
+    return NXT_OK;
 }
 
 
@@ -1128,7 +1893,7 @@ static njs_token_t
 njs_parser_if_statement(njs_vm_t *vm, njs_parser_t *parser)
 {
     njs_token_t        token;
-    njs_parser_node_t  *node, *cond, *stmt;
+    njs_parser_node_t  *node, *cond, *stmt, *live, *dead;
 
     token = njs_parser_grouping_expression(vm, parser);
     if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
@@ -1166,6 +1931,47 @@ njs_parser_if_statement(njs_vm_t *vm, njs_parser_t *parser)
         parser->node = node;
     }
 
+    if (njs_parser_is_const(cond)) {
+
+        /*
+         * The dead branch is eliminated unless it declares functions,
+         * their lambdas are generated from the declaration nodes.
+         * The live branch is wrapped in a statement node to preserve
+         * the completion value of the "if" statement.
+         */
+
+        live = parser->node;
+        dead = NULL;
+
+        if (live != NULL && live->token == NJS_TOKEN_BRANCHING) {
+            dead = live->right;
+            live = live->left;
+
+            if (!njs_is_true(&cond->u.value)) {
+                stmt = live;
+                live = dead;
+                dead = stmt;
+            }
+
+        } else if (!njs_is_true(&cond->u.value)) {
+            dead = live;
+            live = NULL;
+        }
+
+        if (!njs_parser_has_declaration(dead)) {
+            node = njs_parser_node_new(vm, parser, NJS_TOKEN_STATEMENT);
+            if (nxt_slow_path(node == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            node->left = NULL;
+            node->right = live;
+            parser->node = node;
+
+            return token;
+        }
+    }
+
     node = njs_parser_node_new(vm, parser, NJS_TOKEN_IF);
     if (nxt_slow_path(node == NULL)) {
         return NJS_TOKEN_ERROR;
@@ -1394,7 +2200,9 @@ njs_parser_for_statement(njs_vm_t *vm, njs_parser_t *parser)
 
             init = parser->node;
 
-            if (init->token == NJS_TOKEN_FOR_IN) {
+            if (init->token == NJS_TOKEN_FOR_IN
+                || init->token == NJS_TOKEN_FOR_OF)
+            {
                 goto done;
             }
 
@@ -1417,6 +2225,15 @@ njs_parser_for_statement(njs_vm_t *vm, njs_parser_t *parser)
 
                 goto done;
             }
+
+            if (njs_parser_is_of(parser, token)) {
+                token = njs_parser_for_of_statement(vm, parser, &name);
+                if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                    return token;
+                }
+
+                goto done;
+            }
         }
     }
 
@@ -1580,6 +2397,123 @@ njs_parser_for_in_statement(njs_vm_t *vm, njs_parser_t *parser, nxt_str_t *name,
 }
 
 
+static njs_token_t
+njs_parser_for_of_statement(njs_vm_t *vm, njs_parser_t *parser,
+    nxt_str_t *name)
+{
+    nxt_int_t          ret;
+    njs_parser_node_t  *node;
+
+    node = parser->node;
+
+    switch (node->token) {
+
+    case NJS_TOKEN_OBJECT:
+    case NJS_TOKEN_ARRAY:
+        ret = njs_parser_destructuring(vm, parser, node, 0);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NJS_TOKEN_ILLEGAL;
+        }
+
+        break;
+
+    case NJS_TOKEN_NAME:
+    case NJS_TOKEN_PROPERTY:
+        break;
+
+    default:
+        njs_parser_ref_error(vm, parser, "Invalid left-hand side \"%V\" "
+                             "in for-of statement", name);
+
+        return NJS_TOKEN_ILLEGAL;
+    }
+
+    return njs_parser_for_of(vm, parser, node);
+}
+
+
+/*
+ * The "for-of" statement:
+ *   FOR_OF: left is a node with the target in left and the iterated
+ *           value in right, right is the loop body.
+ * A target other than a variable is assigned from the element value
+ * referenced by OBJECT_VALUE of the node.
+ */
+
+static njs_token_t
+njs_parser_for_of(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *target)
+{
+    njs_token_t        token;
+    njs_parser_node_t  *node, *foreach, *value, *assign;
+
+    node = njs_parser_node_new(vm, parser, 0);
+    if (nxt_slow_path(node == NULL)) {
+        return NJS_TOKEN_ERROR;
+    }
+
+    if (target->token != NJS_TOKEN_NAME) {
+        value = njs_parser_node_new(vm, parser, NJS_TOKEN_OBJECT_VALUE);
+        if (nxt_slow_path(value == NULL)) {
+            return NJS_TOKEN_ERROR;
+        }
+
+        value->u.object = node;
+
+        if (target->token == NJS_TOKEN_DESTRUCTURING) {
+            target->right = value;
+
+        } else {
+            assign = njs_parser_node_new(vm, parser, NJS_TOKEN_ASSIGNMENT);
+            if (nxt_slow_path(assign == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            assign->u.operation = njs_vmcode_move;
+            assign->left = target;
+            assign->right = value;
+            target = assign;
+        }
+    }
+
+    node->left = target;
+
+    token = njs_parser_token(vm, parser);
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return token;
+    }
+
+    token = njs_parser_assignment_expression(vm, parser, token);
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return token;
+    }
+
+    node->right = parser->node;
+
+    token = njs_parser_match(vm, parser, token, NJS_TOKEN_CLOSE_PARENTHESIS);
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return token;
+    }
+
+    token = njs_parser_block(vm, parser, token);
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return token;
+    }
+
+    foreach = njs_parser_node_new(vm, parser, NJS_TOKEN_FOR_OF);
+    if (nxt_slow_path(foreach == NULL)) {
+        return NJS_TOKEN_ERROR;
+    }
+
+    foreach->left = node;
+    foreach->right = parser->node;
+
+    parser->node = foreach;
+
+    return token;
+}
+
+
 static njs_token_t
 njs_parser_brk_statement(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token)
@@ -2068,15 +3002,47 @@ nxt_int_t
 njs_parser_match_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token)
 {
-    size_t      offset;
+    return njs_parser_arrow_match(vm, parser, token, 0);
+}
+
+
+/*
+ * Tests whether "async" starts an async function or an async arrow
+ * function.  The tokens which follow are only peeked.
+ */
+
+nxt_int_t
+njs_parser_match_async(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token)
+{
+    if (!njs_parser_is_async(parser, token)) {
+        return NXT_DECLINED;
+    }
+
+    token = njs_lexer_peek_token(vm, parser->lexer, 0);
+
+    if (token == NJS_TOKEN_FUNCTION) {
+        return NXT_OK;
+    }
+
+    return njs_parser_arrow_match(vm, parser, token, 1);
+}
+
+
+/*
+ * The token is followed by the tokens starting at the offset
+ * in the preread queue.
+ */
+
+static nxt_int_t
+njs_parser_arrow_match(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token,
+    size_t offset)
+{
     nxt_bool_t  rest_parameters;
 
     if (token != NJS_TOKEN_OPEN_PARENTHESIS && token != NJS_TOKEN_NAME) {
         return NXT_DECLINED;
     }
 
-    offset = 0;
-
     if (token == NJS_TOKEN_NAME) {
         goto arrow;
     }
@@ -2141,7 +3107,7 @@ arrow:
 
 njs_token_t
 njs_parser_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
-    njs_token_t token)
+    njs_token_t token, nxt_bool_t async)
 {
     njs_ret_t              ret;
     njs_index_t            index;
@@ -2162,6 +3128,7 @@ njs_parser_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
     }
 
     lambda->arrow = 1;
+    lambda->async = async;
 
     node->u.value.data.u.lambda = lambda;
 
@@ -2171,6 +3138,7 @@ njs_parser_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
     }
 
     parser->scope->arrow_function = 1;
+    parser->scope->async = async;
 
     index = NJS_SCOPE_ARGUMENTS;
 
@@ -2251,6 +3219,18 @@ njs_parser_has_side_effect(njs_parser_node_t *node)
         return 1;
     }
 
+    switch (node->token) {
+
+    case NJS_TOKEN_INCREMENT:
+    case NJS_TOKEN_POST_INCREMENT:
+    case NJS_TOKEN_DECREMENT:
+    case NJS_TOKEN_POST_DECREMENT:
+        return 1;
+
+    default:
+        break;
+    }
+
     side_effect = njs_parser_has_side_effect(node->left);
 
     if (nxt_fast_path(!side_effect)) {
@@ -2261,6 +3241,22 @@ njs_parser_has_side_effect(njs_parser_node_t *node)
 }
 
 
+nxt_bool_t
+njs_parser_has_declaration(njs_parser_node_t *node)
+{
+    if (node == NULL) {
+        return 0;
+    }
+
+    if (node->token == NJS_TOKEN_FUNCTION) {
+        return 1;
+    }
+
+    return njs_parser_has_declaration(node->left)
+           || njs_parser_has_declaration(node->right);
+}
+
+
 njs_token_t
 njs_parser_unexpected_token(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token)
@@ -30,9 +30,13 @@ struct njs_parser_scope_s {
 
     njs_scope_t                     type:8;
     uint8_t                         nesting;     /* 4 bits */
+
+    /* The outer closure levels referenced by the function, a bit mask. */
+    uint8_t                         closures;
     uint8_t                         argument_closures;
     uint8_t                         module;
     uint8_t                         arrow_function;
+    uint8_t                         async;
 };
 
 
@@ -76,20 +80,52 @@ struct njs_parser_s {
 };
 
 
+/* The source of a function body which is parsed on the first call. */
+
+typedef struct {
+    nxt_str_t                       text;
+    nxt_str_t                       file;
+    uint32_t                        line;
+
+    /*
+     * The type and the message of the error reported on each call
+     * if the body has failed to parse, the null message stands for
+     * MemoryError.
+     */
+    njs_value_type_t                error:8;
+    nxt_str_t                       message;
+} njs_parser_source_t;
+
+
 nxt_int_t njs_parser(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_t *prev);
 njs_token_t njs_parser_expression(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
 njs_token_t njs_parser_assignment_expression(njs_vm_t *vm,
     njs_parser_t *parser, njs_token_t token);
-njs_token_t njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser);
+njs_token_t njs_parser_function_expression(njs_vm_t *vm, njs_parser_t *parser,
+    nxt_bool_t async);
 nxt_int_t njs_parser_match_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
-njs_token_t njs_parser_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
+nxt_int_t njs_parser_match_async(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
+njs_token_t njs_parser_arrow_expression(njs_vm_t *vm, njs_parser_t *parser,
+    njs_token_t token, nxt_bool_t async);
+nxt_int_t njs_parser_destructuring(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *pattern, nxt_bool_t var);
+njs_token_t njs_parser_array_elements(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *array, njs_parser_node_t *items, njs_token_t end);
+nxt_int_t njs_parser_array_item(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *array, njs_parser_node_t *value);
+nxt_int_t njs_parser_spread_element(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *parent, njs_parser_node_t *value);
 njs_token_t njs_parser_module_lambda(njs_vm_t *vm, njs_parser_t *parser);
 njs_token_t njs_parser_terminal(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
+njs_parser_node_t *njs_parser_reference(njs_vm_t *vm, njs_parser_t *parser,
+    njs_token_t token, nxt_str_t *name, uint32_t hash, uint32_t token_line);
+nxt_int_t njs_parser_lambda_source(njs_vm_t *vm, njs_parser_node_t *node,
+    njs_parser_source_t *source);
 njs_token_t njs_parser_template_literal(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *parent);
 njs_parser_node_t *njs_parser_argument(njs_vm_t *vm, njs_parser_t *parser,
@@ -101,6 +137,7 @@ njs_variable_t *njs_variable_resolve(njs_vm_t *vm, njs_parser_node_t *node);
 njs_index_t njs_variable_typeof(njs_vm_t *vm, njs_parser_node_t *node);
 njs_index_t njs_variable_index(njs_vm_t *vm, njs_parser_node_t *node);
 nxt_bool_t njs_parser_has_side_effect(njs_parser_node_t *node);
+nxt_bool_t njs_parser_has_declaration(njs_parser_node_t *node);
 njs_token_t njs_parser_unexpected_token(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token);
 u_char *njs_parser_trace_handler(nxt_trace_t *trace, nxt_trace_data_t *td,
@@ -115,6 +152,13 @@ void njs_parser_node_error(njs_vm_t *vm, njs_parser_node_t *node,
     ((node)->token == NJS_TOKEN_NAME || (node)->token == NJS_TOKEN_PROPERTY)
 
 
+/* The literal nodes have their values in node->u.value. */
+
+#define njs_parser_is_const(node)                                             \
+    ((node)->token >= NJS_TOKEN_FIRST_CONST                                   \
+     && (node)->token <= NJS_TOKEN_LAST_CONST)
+
+
 #define njs_scope_accumulative(vm, scope)                                     \
     ((vm)->options.accumulative && (scope)->type == NJS_SCOPE_GLOBAL)
 
@@ -66,6 +66,10 @@ static njs_token_t njs_parser_call(njs_vm_t *vm, njs_parser_t *parser,
     njs_token_t token, uint8_t ctor);
 static njs_token_t njs_parser_arguments(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *parent);
+static njs_token_t njs_parser_fold_operation(njs_vm_t *vm,
+    njs_parser_t *parser, njs_parser_node_t *node, njs_token_t token);
+static void njs_parser_fold_logical(njs_parser_t *parser,
+    njs_parser_node_t *node);
 
 
 static const njs_parser_expression_t
@@ -302,6 +306,32 @@ njs_parser_assignment_expression(njs_vm_t *vm, njs_parser_t *parser,
             return token;
         }
 
+        node = parser->node;
+
+        if (operation == njs_vmcode_move
+            && (node->token == NJS_TOKEN_OBJECT
+                || node->token == NJS_TOKEN_ARRAY))
+        {
+            if (njs_parser_destructuring(vm, parser, node, 0) != NXT_OK) {
+                return NJS_TOKEN_ILLEGAL;
+            }
+
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            token = njs_parser_assignment_expression(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            node->right = parser->node;
+            parser->node = node;
+
+            continue;
+        }
+
         if (!njs_parser_is_lvalue(parser->node)) {
             token = parser->node->token;
 
@@ -406,6 +436,14 @@ njs_parser_conditional_expression(njs_vm_t *vm, njs_parser_t *parser,
         node->right->dest = cond;
 
         parser->node = cond;
+
+        if (njs_parser_is_const(cond->left)) {
+            /* The branch is known at compile time. */
+            node = njs_is_true(&cond->left->u.value) ? node->left
+                                                     : node->right;
+            node->dest = NULL;
+            parser->node = node;
+        }
     }
 }
 
@@ -463,6 +501,18 @@ njs_parser_binary_expression(njs_vm_t *vm, njs_parser_t *parser,
         node->right = parser->node;
         node->right->dest = node;
         parser->node = node;
+
+        if (node->token == NJS_TOKEN_LOGICAL_AND
+            || node->token == NJS_TOKEN_LOGICAL_OR)
+        {
+            njs_parser_fold_logical(parser, node);
+            continue;
+        }
+
+        token = njs_parser_fold_operation(vm, parser, node, token);
+        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+            return token;
+        }
     }
 }
 
@@ -502,6 +552,8 @@ njs_parser_exponential_expression(njs_vm_t *vm, njs_parser_t *parser,
         node->right = parser->node;
         node->right->dest = node;
         parser->node = node;
+
+        return njs_parser_fold_operation(vm, parser, node, token);
     }
 
     return token;
@@ -515,6 +567,7 @@ njs_parser_unary_expression(njs_vm_t *vm, njs_parser_t *parser,
     double                  num;
     njs_token_t             next;
     njs_parser_node_t       *node;
+    njs_parser_scope_t      *scope;
     njs_vmcode_operation_t  operation;
 
     switch (token) {
@@ -549,6 +602,18 @@ njs_parser_unary_expression(njs_vm_t *vm, njs_parser_t *parser,
         operation = njs_vmcode_delete;
         break;
 
+    case NJS_TOKEN_AWAIT:
+        scope = njs_function_scope(parser->scope, 1);
+
+        if (scope == NULL || !scope->async) {
+            njs_parser_syntax_error(vm, parser, "await is only valid "
+                                    "in async functions");
+            return NJS_TOKEN_ILLEGAL;
+        }
+
+        operation = njs_vmcode_await;
+        break;
+
     default:
         return njs_parser_inc_dec_expression(vm, parser, token);
     }
@@ -623,7 +688,138 @@ njs_parser_unary_expression(njs_vm_t *vm, njs_parser_t *parser,
     node->left->dest = node;
     parser->node = node;
 
-    return next;
+    return njs_parser_fold_operation(vm, parser, node, next);
+}
+
+
+/*
+ * Constant folding.  An operation with literal operands is evaluated by
+ * the same vmcode handler as in runtime, so the result is the same.
+ * Only the operand types processed by the handlers without traps are
+ * folded, the traps require a running frame.
+ */
+
+static njs_token_t
+njs_parser_fold_operation(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *node, njs_token_t token)
+{
+    njs_ret_t               ret;
+    nxt_bool_t              numeric, primitive;
+    njs_value_t             *val1, *val2, retval;
+    njs_vmcode_operation_t  operation;
+
+    if (!njs_parser_is_const(node->left)
+        || (node->right != NULL && !njs_parser_is_const(node->right)))
+    {
+        return token;
+    }
+
+    val1 = &node->left->u.value;
+    val2 = (node->right != NULL) ? &node->right->u.value : val1;
+
+    numeric = njs_is_numeric(val1) && njs_is_numeric(val2);
+    primitive = numeric || (njs_is_string(val1) && njs_is_string(val2));
+
+    operation = node->u.operation;
+
+    if (operation == njs_vmcode_addition) {
+        if (!primitive) {
+            return token;
+        }
+
+    } else if (operation == njs_vmcode_substraction
+               || operation == njs_vmcode_multiplication
+               || operation == njs_vmcode_exponentiation
+               || operation == njs_vmcode_division
+               || operation == njs_vmcode_remainder
+               || operation == njs_vmcode_left_shift
+               || operation == njs_vmcode_right_shift
+               || operation == njs_vmcode_unsigned_right_shift
+               || operation == njs_vmcode_bitwise_and
+               || operation == njs_vmcode_bitwise_xor
+               || operation == njs_vmcode_bitwise_or
+               || operation == njs_vmcode_unary_plus
+               || operation == njs_vmcode_unary_negation
+               || operation == njs_vmcode_bitwise_not)
+    {
+        if (!numeric) {
+            return token;
+        }
+
+    } else if (operation != njs_vmcode_less
+               && operation != njs_vmcode_greater
+               && operation != njs_vmcode_less_or_equal
+               && operation != njs_vmcode_greater_or_equal
+               && operation != njs_vmcode_equal
+               && operation != njs_vmcode_not_equal
+               && operation != njs_vmcode_strict_equal
+               && operation != njs_vmcode_strict_not_equal
+               && operation != njs_vmcode_logical_not
+               && operation != njs_vmcode_typeof
+               && operation != njs_vmcode_void)
+    {
+        return token;
+    }
+
+    /* vm->retval may hold the result of the previous accumulative run. */
+    retval = vm->retval;
+
+    ret = operation(vm, val1, val2);
+
+    node->u.value = vm->retval;
+    vm->retval = retval;
+
+    if (nxt_slow_path(ret == NXT_ERROR)) {
+        return NJS_TOKEN_ERROR;
+    }
+
+    switch (node->u.value.type) {
+
+    case NJS_UNDEFINED:
+        node->token = NJS_TOKEN_UNDEFINED;
+        break;
+
+    case NJS_BOOLEAN:
+        node->token = NJS_TOKEN_BOOLEAN;
+        break;
+
+    case NJS_NUMBER:
+        node->token = NJS_TOKEN_NUMBER;
+        break;
+
+    default:
+        node->token = NJS_TOKEN_STRING;
+        break;
+    }
+
+    node->left = NULL;
+    node->right = NULL;
+
+    return token;
+}
+
+
+static void
+njs_parser_fold_logical(njs_parser_t *parser, njs_parser_node_t *node)
+{
+    nxt_bool_t  right;
+
+    if (!njs_parser_is_const(node->left)) {
+        return;
+    }
+
+    /* "true && x" and "false || x" are "x", otherwise the left operand. */
+
+    right = njs_is_true(&node->left->u.value);
+
+    if (node->token == NJS_TOKEN_LOGICAL_OR) {
+        right = !right;
+    }
+
+    node = right ? node->right : node->left;
+    node->dest = NULL;
+
+    parser->node = node;
 }
 
 
@@ -959,9 +1155,10 @@ static njs_token_t
 njs_parser_arguments(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *parent)
 {
+    nxt_int_t          ret;
     njs_token_t        token;
     njs_index_t        index;
-    njs_parser_node_t  *node;
+    njs_parser_node_t  *node, *spread, *array;
 
     index = NJS_SCOPE_CALLEE_ARGUMENTS;
 
@@ -975,11 +1172,58 @@ njs_parser_arguments(njs_vm_t *vm, njs_parser_t *parser,
             break;
         }
 
+        spread = NULL;
+
+        if (token == NJS_TOKEN_ELLIPSIS) {
+            spread = njs_parser_node_new(vm, parser, NJS_TOKEN_ELLIPSIS);
+            if (nxt_slow_path(spread == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+        }
+
         token = njs_parser_assignment_expression(vm, parser, token);
         if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
             return token;
         }
 
+        if (spread != NULL) {
+            if (token == NJS_TOKEN_COMMA) {
+                /*
+                 * The frame is sized by the spread array length after all
+                 * arguments are evaluated.  To keep the static arguments
+                 * at fixed frame slots, the arguments starting from a
+                 * spread argument which is not the last one are collected
+                 * into an array literal, which is spread instead.
+                 */
+                array = njs_parser_node_new(vm, parser, NJS_TOKEN_ARRAY);
+                if (nxt_slow_path(array == NULL)) {
+                    return NJS_TOKEN_ERROR;
+                }
+
+                ret = njs_parser_spread_element(vm, parser, array,
+                                                parser->node);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return NJS_TOKEN_ERROR;
+                }
+
+                token = njs_parser_array_elements(vm, parser, array, NULL,
+                                                  NJS_TOKEN_CLOSE_PARENTHESIS);
+                if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                    return token;
+                }
+
+                parser->node = array;
+            }
+
+            spread->left = parser->node;
+            parser->node = spread;
+        }
+
         node = njs_parser_argument(vm, parser, parser->node, index);
         if (nxt_slow_path(node == NULL)) {
             return NJS_TOKEN_ERROR;
@@ -9,9 +9,6 @@
 #include <string.h>
 
 
-static njs_parser_node_t *njs_parser_reference(njs_vm_t *vm,
-    njs_parser_t *parser, njs_token_t token, nxt_str_t *name, uint32_t hash,
-    uint32_t token_line);
 static nxt_int_t njs_parser_builtin(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *node, njs_value_type_t type, nxt_str_t *name,
     uint32_t hash);
@@ -22,8 +19,6 @@ static nxt_int_t njs_parser_object_property(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *value);
 static njs_token_t njs_parser_array(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *array);
-static nxt_int_t njs_parser_array_item(njs_vm_t *vm, njs_parser_t *parser,
-    njs_parser_node_t *array, njs_parser_node_t *value);
 static nxt_int_t njs_parser_template_expression(njs_vm_t *vm,
     njs_parser_t *parser);
 static nxt_int_t njs_parser_template_string(njs_vm_t *vm,
@@ -43,7 +38,21 @@ njs_parser_terminal(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token)
 
     ret = njs_parser_match_arrow_expression(vm, parser, token);
     if (ret == NXT_OK) {
-        return njs_parser_arrow_expression(vm, parser, token);
+        return njs_parser_arrow_expression(vm, parser, token, 0);
+    }
+
+    ret = njs_parser_match_async(vm, parser, token);
+    if (ret == NXT_OK) {
+        token = njs_parser_token(vm, parser);
+        if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+            return token;
+        }
+
+        if (token == NJS_TOKEN_FUNCTION) {
+            return njs_parser_function_expression(vm, parser, 1);
+        }
+
+        return njs_parser_arrow_expression(vm, parser, token, 1);
     }
 
     if (token == NJS_TOKEN_OPEN_PARENTHESIS) {
@@ -62,7 +71,7 @@ njs_parser_terminal(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token)
     }
 
     if (token == NJS_TOKEN_FUNCTION) {
-        return njs_parser_function_expression(vm, parser);
+        return njs_parser_function_expression(vm, parser, 0);
     }
 
     switch (token) {
@@ -200,7 +209,7 @@ njs_parser_terminal(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token)
 }
 
 
-static njs_parser_node_t *
+njs_parser_node_t *
 njs_parser_reference(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token,
     nxt_str_t *name, uint32_t hash, uint32_t token_line)
 {
@@ -312,6 +321,70 @@ njs_parser_reference(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token,
         node->index = NJS_INDEX_DATE;
         break;
 
+    case NJS_TOKEN_PROMISE_CONSTRUCTOR:
+        node->index = NJS_INDEX_PROMISE;
+        break;
+
+    case NJS_TOKEN_ARRAY_BUFFER_CONSTRUCTOR:
+        node->index = NJS_INDEX_ARRAY_BUFFER;
+        break;
+
+    case NJS_TOKEN_DATA_VIEW_CONSTRUCTOR:
+        node->index = NJS_INDEX_DATA_VIEW;
+        break;
+
+    case NJS_TOKEN_INT8_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_INT8_ARRAY;
+        break;
+
+    case NJS_TOKEN_UINT8_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_UINT8_ARRAY;
+        break;
+
+    case NJS_TOKEN_UINT8_CLAMPED_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_UINT8_CLAMPED_ARRAY;
+        break;
+
+    case NJS_TOKEN_INT16_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_INT16_ARRAY;
+        break;
+
+    case NJS_TOKEN_UINT16_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_UINT16_ARRAY;
+        break;
+
+    case NJS_TOKEN_INT32_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_INT32_ARRAY;
+        break;
+
+    case NJS_TOKEN_UINT32_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_UINT32_ARRAY;
+        break;
+
+    case NJS_TOKEN_FLOAT32_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_FLOAT32_ARRAY;
+        break;
+
+    case NJS_TOKEN_FLOAT64_ARRAY_CONSTRUCTOR:
+        node->index = NJS_INDEX_FLOAT64_ARRAY;
+        break;
+
+    case NJS_TOKEN_MAP_CONSTRUCTOR:
+        node->index = NJS_INDEX_MAP;
+        break;
+
+    case NJS_TOKEN_SET_CONSTRUCTOR:
+        node->index = NJS_INDEX_SET;
+        break;
+
+    case NJS_TOKEN_WEAK_MAP_CONSTRUCTOR:
+        node->index = NJS_INDEX_WEAK_MAP;
+        break;
+
+    case NJS_TOKEN_WEAK_SET_CONSTRUCTOR:
+        node->index = NJS_INDEX_WEAK_SET;
+        break;
+
     case NJS_TOKEN_ERROR_CONSTRUCTOR:
         node->index = NJS_INDEX_OBJECT_ERROR;
         break;
@@ -362,6 +435,8 @@ njs_parser_reference(njs_vm_t *vm, njs_parser_t *parser, njs_token_t token,
     case NJS_TOKEN_SET_TIMEOUT:
     case NJS_TOKEN_SET_IMMEDIATE:
     case NJS_TOKEN_CLEAR_TIMEOUT:
+    case NJS_TOKEN_SET_INTERVAL:
+    case NJS_TOKEN_CLEAR_INTERVAL:
         ret = njs_parser_builtin(vm, parser, node, NJS_FUNCTION, name, hash);
         if (nxt_slow_path(ret != NXT_OK)) {
             return NULL;
@@ -479,8 +554,14 @@ njs_parser_builtin(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *node,
  *   PropertyDefinition:
  *     PropertyName : AssignmentExpression
  *     IdentifierReference
+ *     CoverInitializedName
+ *     ... AssignmentExpression
  *   PropertyName:
  *    IdentifierName, StringLiteral, NumericLiteral.
+ *
+ * CoverInitializedName, "name = value", is valid only in a destructuring
+ * pattern, the object is marked by the ctor flag and the generator reports
+ * the object as a syntax error if it has not been turned into a pattern.
  */
 static njs_token_t
 njs_parser_object(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *obj)
@@ -518,6 +599,24 @@ njs_parser_object(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *obj)
         case NJS_TOKEN_CLOSE_BRACE:
             goto done;
 
+        case NJS_TOKEN_ELLIPSIS:
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            token = njs_parser_assignment_expression(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            ret = njs_parser_spread_element(vm, parser, obj, parser->node);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            goto next;
+
         case NJS_TOKEN_NUMBER:
         case NJS_TOKEN_STRING:
         case NJS_TOKEN_ESCAPE_STRING:
@@ -567,6 +666,45 @@ njs_parser_object(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *obj)
 
             break;
 
+        case NJS_TOKEN_ASSIGNMENT:
+
+            if (name.length == 0
+                || prop_token == NJS_TOKEN_THIS
+                || prop_token == NJS_TOKEN_GLOBAL_THIS)
+            {
+                return NJS_TOKEN_ILLEGAL;
+            }
+
+            expression = njs_parser_node_new(vm, parser, NJS_TOKEN_ASSIGNMENT);
+            if (nxt_slow_path(expression == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            expression->u.operation = njs_vmcode_move;
+
+            expression->left = njs_parser_reference(vm, parser, prop_token,
+                                                    &name, hash, token_line);
+            if (nxt_slow_path(expression->left == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            token = njs_parser_assignment_expression(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            expression->right = parser->node;
+
+            obj->ctor = 1;
+            obj->token_line = token_line;
+
+            break;
+
         case NJS_TOKEN_COLON:
             token = njs_parser_token(vm, parser);
             if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
@@ -590,6 +728,8 @@ njs_parser_object(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *obj)
             return NJS_TOKEN_ERROR;
         }
 
+    next:
+
         if (token == NJS_TOKEN_CLOSE_BRACE) {
             break;
         }
@@ -653,6 +793,33 @@ njs_parser_object_property(njs_vm_t *vm, njs_parser_t *parser,
 
 static njs_token_t
 njs_parser_array(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *array)
+{
+    njs_token_t  token;
+
+    token = njs_parser_array_elements(vm, parser, array, array,
+                                      NJS_TOKEN_CLOSE_BRACKET);
+    if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+        return token;
+    }
+
+    parser->node = array;
+
+    return njs_parser_token(vm, parser);
+}
+
+
+/*
+ * The elements before the first spread element are stored at their
+ * indexes known at compile time.  The elements following a spread element
+ * are collected into a nested array literal which is spread in its turn.
+ * The "items" is the literal the next element is added to, it is NULL
+ * after a spread element.  The elements of spread call arguments end with
+ * the closing parenthesis and cannot be elided.
+ */
+
+njs_token_t
+njs_parser_array_elements(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *array, njs_parser_node_t *items, njs_token_t end)
 {
     nxt_int_t    ret;
     njs_token_t  token;
@@ -663,13 +830,50 @@ njs_parser_array(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *array)
             return token;
         }
 
-        if (token == NJS_TOKEN_CLOSE_BRACKET) {
+        if (token == end) {
             break;
         }
 
+        if (token == NJS_TOKEN_ELLIPSIS) {
+            token = njs_parser_token(vm, parser);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            token = njs_parser_assignment_expression(vm, parser, token);
+            if (nxt_slow_path(token <= NJS_TOKEN_ILLEGAL)) {
+                return token;
+            }
+
+            ret = njs_parser_spread_element(vm, parser, array, parser->node);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            items = NULL;
+
+            goto next;
+        }
+
+        if (token == NJS_TOKEN_COMMA && end != NJS_TOKEN_CLOSE_BRACKET) {
+            return NJS_TOKEN_ILLEGAL;
+        }
+
+        if (items == NULL) {
+            items = njs_parser_node_new(vm, parser, NJS_TOKEN_ARRAY);
+            if (nxt_slow_path(items == NULL)) {
+                return NJS_TOKEN_ERROR;
+            }
+
+            ret = njs_parser_spread_element(vm, parser, array, items);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NJS_TOKEN_ERROR;
+            }
+        }
+
         if (token == NJS_TOKEN_COMMA) {
-            array->ctor = 1;
-            array->u.length++;
+            items->ctor = 1;
+            items->u.length++;
             continue;
         }
 
@@ -678,12 +882,14 @@ njs_parser_array(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *array)
             return token;
         }
 
-        ret = njs_parser_array_item(vm, parser, array, parser->node);
+        ret = njs_parser_array_item(vm, parser, items, parser->node);
         if (nxt_slow_path(ret != NXT_OK)) {
             return NJS_TOKEN_ERROR;
         }
 
-        if (token == NJS_TOKEN_CLOSE_BRACKET) {
+    next:
+
+        if (token == end) {
             break;
         }
 
@@ -692,13 +898,11 @@ njs_parser_array(njs_vm_t *vm, njs_parser_t *parser, njs_parser_node_t *array)
         }
     }
 
-    parser->node = array;
-
-    return njs_parser_token(vm, parser);
+    return token;
 }
 
 
-static nxt_int_t
+nxt_int_t
 njs_parser_array_item(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *array, njs_parser_node_t *value)
 {
@@ -726,6 +930,45 @@ njs_parser_array_item(njs_vm_t *vm, njs_parser_t *parser,
 }
 
 
+/*
+ * A spread element of an array or object literal:
+ *   ELLIPSIS: left is the spread value, right is OBJECT_VALUE(literal).
+ */
+
+nxt_int_t
+njs_parser_spread_element(njs_vm_t *vm, njs_parser_t *parser,
+    njs_parser_node_t *parent, njs_parser_node_t *value)
+{
+    njs_parser_node_t  *stmt, *spread, *object;
+
+    object = njs_parser_node_new(vm, parser, NJS_TOKEN_OBJECT_VALUE);
+    if (nxt_slow_path(object == NULL)) {
+        return NXT_ERROR;
+    }
+
+    object->u.object = parent;
+
+    spread = njs_parser_node_new(vm, parser, NJS_TOKEN_ELLIPSIS);
+    if (nxt_slow_path(spread == NULL)) {
+        return NXT_ERROR;
+    }
+
+    spread->left = value;
+    spread->right = object;
+
+    stmt = njs_parser_node_new(vm, parser, NJS_TOKEN_STATEMENT);
+    if (nxt_slow_path(stmt == NULL)) {
+        return NXT_ERROR;
+    }
+
+    stmt->right = spread;
+    stmt->left = parent->left;
+    parent->left = stmt;
+
+    return NXT_OK;
+}
+
+
 njs_token_t
 njs_parser_template_literal(njs_vm_t *vm, njs_parser_t *parser,
     njs_parser_node_t *parent)
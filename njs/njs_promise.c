@@ -0,0 +1,1636 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <njs_promise.h>
+#include <string.h>
+
+
+/*
+ * A promise is an object value holding njs_promise_data_t.  The data
+ * value is tagged with the magic to tell promises from other objects
+ * with the NJS_DATA value such as crypto Hash or Hmac.  The other
+ * structures passed around as NJS_DATA values are tagged as well
+ * to trace the values they refer to in njs_promise_gc_mark().
+ */
+#define NJS_PROMISE_MAGIC             0x7072
+#define NJS_PROMISE_CAPABILITY_MAGIC  0x7063
+#define NJS_PROMISE_REACTION_MAGIC    0x7065
+#define NJS_PROMISE_ELEMENT_MAGIC     0x7061
+
+
+typedef enum {
+    NJS_PROMISE_PENDING = 0,
+    NJS_PROMISE_FULFILLED,
+    NJS_PROMISE_REJECTED,
+} njs_promise_state_t;
+
+
+typedef struct {
+    njs_promise_state_t       state;
+    njs_value_t               result;
+    nxt_queue_t               reactions;
+
+    /* A link in vm->unhandled_rejections. */
+    nxt_queue_link_t          link;
+
+    uint8_t                   is_handled;     /* 1 bit */
+} njs_promise_data_t;
+
+
+typedef struct {
+    /* A derived promise or undefined. */
+    njs_value_t               promise;
+
+    njs_value_t               fulfilled;
+    njs_value_t               rejected;
+    nxt_queue_link_t          link;
+} njs_promise_reaction_t;
+
+
+/* The resolve and reject functions share the "already resolved" state. */
+
+typedef struct {
+    njs_value_t               promise;
+    njs_value_t               resolve;
+    njs_value_t               reject;
+    uint8_t                   resolved;       /* 1 bit */
+} njs_promise_capability_t;
+
+
+typedef struct {
+    njs_promise_capability_t  *capability;
+    njs_value_t               values;
+    uint32_t                  remaining;
+} njs_promise_all_t;
+
+
+typedef struct {
+    njs_promise_all_t         *all;
+    uint32_t                  index;
+    uint8_t                   called;         /* 1 bit */
+} njs_promise_all_element_t;
+
+
+/*
+ * Promise jobs are ordinary posted events, so they are run
+ * by njs_vm_run() in the order they were queued.
+ */
+
+typedef struct {
+    njs_event_t               event;
+    njs_value_t               args[3];
+} njs_promise_job_t;
+
+
+static njs_promise_data_t *njs_promise_alloc(njs_vm_t *vm,
+    njs_value_t *value);
+static njs_promise_capability_t *njs_promise_capability(njs_vm_t *vm,
+    const njs_value_t *promise);
+static njs_ret_t njs_promise_resolve_value(njs_vm_t *vm,
+    const njs_value_t *promise, const njs_value_t *resolution);
+static njs_ret_t njs_promise_settle(njs_vm_t *vm, njs_promise_data_t *data,
+    const njs_value_t *value, njs_promise_state_t state);
+static njs_ret_t njs_promise_perform_then(njs_vm_t *vm,
+    const njs_value_t *promise, const njs_value_t *fulfilled,
+    const njs_value_t *rejected, const njs_value_t *derived);
+static njs_ret_t njs_promise_job_post(njs_vm_t *vm,
+    const njs_value_t *function, const njs_value_t *args, nxt_uint_t nargs);
+static njs_ret_t njs_promise_apply(njs_vm_t *vm, njs_function_t *function,
+    const njs_value_t *this, const njs_value_t *args, nxt_uint_t nargs,
+    njs_promise_cont_t *cont, njs_function_native_t next);
+static njs_ret_t njs_promise_then_property(njs_vm_t *vm,
+    const njs_value_t *value, njs_value_t *then);
+static njs_ret_t njs_promise_constructor_continuation(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_resolve_function(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_reject_function(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_reaction_job(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_reaction_job_continuation(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_thenable_job(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_thenable_job_continuation(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_prototype_then(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_finally_continuation(njs_vm_t *vm,
+    njs_value_t *args, nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_finally_value(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static njs_ret_t njs_promise_finally_thrower(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+static nxt_int_t njs_promise_gc_mark_reaction(njs_gc_t *gc,
+    njs_promise_reaction_t *reaction);
+static nxt_int_t njs_promise_gc_mark_capability(njs_gc_t *gc,
+    njs_promise_capability_t *capability);
+
+
+static const njs_value_t  njs_promise_then_string = njs_string("then");
+
+static const njs_value_t  njs_promise_reaction_job_function =
+    njs_native_function(njs_promise_reaction_job,
+                        njs_continuation_size(njs_promise_cont_t), 0);
+
+static const njs_value_t  njs_promise_thenable_job_function =
+    njs_native_function(njs_promise_thenable_job,
+                        njs_continuation_size(njs_promise_cont_t), 0);
+
+
+nxt_inline njs_promise_data_t *
+njs_promise_data(const njs_value_t *value)
+{
+    njs_object_value_t  *ov;
+
+    if (njs_is_object_value(value)) {
+        ov = value->data.u.object_value;
+
+        if (njs_is_data(&ov->value)
+            && ov->value.data.magic16 == NJS_PROMISE_MAGIC)
+        {
+            return ov->value.data.u.data;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * A native function calling script code sets the exception handler of its
+ * own frame to the continuation, so the continuation is called whether
+ * the callee returns or throws.  The latter leaves cont->retval invalid
+ * and the exception in vm->retval.
+ */
+
+nxt_inline nxt_bool_t
+njs_promise_thrown(njs_vm_t *vm, njs_promise_cont_t *cont)
+{
+    vm->top_frame->exception.catch = NULL;
+
+    return !njs_is_valid(&cont->retval);
+}
+
+
+njs_ret_t
+njs_promise_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_value_t               promise, arguments[2];
+    const njs_value_t         *executor;
+    njs_promise_cont_t        *cont;
+    njs_promise_capability_t  *capability;
+
+    if (!vm->top_frame->ctor) {
+        njs_type_error(vm, "the Promise constructor must be called "
+                       "with \"new\"");
+        return NXT_ERROR;
+    }
+
+    executor = njs_arg(args, nargs, 1);
+
+    if (!njs_is_function(executor)) {
+        njs_type_error(vm, "Promise executor is not a function");
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(njs_promise_alloc(vm, &promise) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    capability = njs_promise_capability(vm, &promise);
+    if (nxt_slow_path(capability == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cont = njs_vm_continuation(vm);
+    cont->value = promise;
+    cont->data = capability;
+
+    arguments[0] = capability->resolve;
+    arguments[1] = capability->reject;
+
+    return njs_promise_apply(vm, executor->data.u.function,
+                             &njs_value_undefined, arguments, 2, cont,
+                             njs_promise_constructor_continuation);
+}
+
+
+static njs_ret_t
+njs_promise_constructor_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t                 ret;
+    njs_value_t               value;
+    njs_promise_cont_t        *cont;
+    njs_promise_capability_t  *capability;
+
+    cont = njs_vm_continuation(vm);
+
+    if (njs_promise_thrown(vm, cont)) {
+        capability = cont->data;
+
+        if (!capability->resolved) {
+            capability->resolved = 1;
+
+            value = vm->retval;
+
+            ret = njs_promise_settle(vm, njs_promise_data(&cont->value),
+                                     &value, NJS_PROMISE_REJECTED);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+    }
+
+    vm->retval = cont->value;
+
+    return NXT_OK;
+}
+
+
+static njs_promise_data_t *
+njs_promise_alloc(njs_vm_t *vm, njs_value_t *value)
+{
+    njs_object_value_t  *ov;
+    njs_promise_data_t  *data;
+
+    ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
+    if (nxt_slow_path(ov == NULL)) {
+        goto memory_error;
+    }
+
+    data = nxt_mp_alloc(vm->mem_pool, sizeof(njs_promise_data_t));
+    if (nxt_slow_path(data == NULL)) {
+        goto memory_error;
+    }
+
+    data->state = NJS_PROMISE_PENDING;
+    data->result = njs_value_undefined;
+    data->is_handled = 0;
+    nxt_queue_init(&data->reactions);
+
+    nxt_flathsh_init(&ov->object.hash);
+    nxt_flathsh_init(&ov->object.shared_hash);
+    ov->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_PROMISE].object;
+    ov->object.type = NJS_OBJECT_VALUE;
+    ov->object.shared = 0;
+    ov->object.extensible = 1;
+    ov->object.frozen = 0;
+
+    njs_value_data_set(&ov->value, data);
+    ov->value.data.magic16 = NJS_PROMISE_MAGIC;
+
+    value->data.u.object_value = ov;
+    value->type = NJS_OBJECT_VALUE;
+    value->data.truth = 1;
+
+    return data;
+
+memory_error:
+
+    njs_memory_error(vm);
+
+    return NULL;
+}
+
+
+static njs_promise_capability_t *
+njs_promise_capability(njs_vm_t *vm, const njs_value_t *promise)
+{
+    njs_ret_t                 ret;
+    njs_value_t               value;
+    njs_promise_capability_t  *capability;
+
+    capability = nxt_mp_alloc(vm->mem_pool, sizeof(njs_promise_capability_t));
+    if (nxt_slow_path(capability == NULL)) {
+        njs_memory_error(vm);
+        return NULL;
+    }
+
+    capability->promise = *promise;
+    capability->resolved = 0;
+
+    njs_value_data_set(&value, capability);
+    value.data.magic16 = NJS_PROMISE_CAPABILITY_MAGIC;
+
+    ret = njs_promise_function(vm, &capability->resolve,
+                               njs_promise_resolve_function, &value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    ret = njs_promise_function(vm, &capability->reject,
+                               njs_promise_reject_function, &value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    return capability;
+}
+
+
+/*
+ * Creates a native function with the value bound as the first argument.
+ */
+
+njs_ret_t
+njs_promise_function(njs_vm_t *vm, njs_value_t *retval,
+    njs_function_native_t native, const njs_value_t *value)
+{
+    njs_value_t     *bound;
+    njs_function_t  *function;
+
+    function = nxt_mp_zalloc(vm->mem_pool, sizeof(njs_function_t));
+    if (nxt_slow_path(function == NULL)) {
+        goto memory_error;
+    }
+
+    bound = nxt_mp_alloc(vm->mem_pool, 2 * sizeof(njs_value_t));
+    if (nxt_slow_path(bound == NULL)) {
+        goto memory_error;
+    }
+
+    bound[0] = njs_value_undefined;
+    bound[1] = *value;
+
+    /*
+     * nxt_mp_zalloc() does also:
+     *   nxt_flathsh_init(&function->object.hash);
+     *   nxt_flathsh_init(&function->object.shared_hash);
+     */
+
+    function->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_FUNCTION].object;
+    function->object.type = NJS_FUNCTION;
+    function->object.extensible = 1;
+
+    function->native = 1;
+    function->args_offset = 2;
+    function->continuation_size = njs_continuation_size(njs_promise_cont_t);
+    function->u.native = native;
+    function->bound = bound;
+
+    retval->data.u.function = function;
+    retval->type = NJS_FUNCTION;
+    retval->data.truth = 1;
+
+    return NXT_OK;
+
+memory_error:
+
+    njs_memory_error(vm);
+
+    return NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_promise_resolve_function(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t                 ret;
+    njs_promise_capability_t  *capability;
+
+    capability = args[1].data.u.data;
+
+    if (!capability->resolved) {
+        capability->resolved = 1;
+
+        ret = njs_promise_resolve_value(vm, &capability->promise,
+                                        njs_arg(args, nargs, 2));
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_reject_function(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t                 ret;
+    njs_promise_capability_t  *capability;
+
+    capability = args[1].data.u.data;
+
+    if (!capability->resolved) {
+        capability->resolved = 1;
+
+        ret = njs_promise_settle(vm, njs_promise_data(&capability->promise),
+                                 njs_arg(args, nargs, 2),
+                                 NJS_PROMISE_REJECTED);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+/*
+ * ES6, 25.4.1.3.2: Promise Resolve Functions.
+ *   Only NXT_ERROR on memory allocation failure is returned,
+ *   other failures reject the promise.
+ */
+
+static njs_ret_t
+njs_promise_resolve_value(njs_vm_t *vm, const njs_value_t *promise,
+    const njs_value_t *resolution)
+{
+    njs_ret_t           ret;
+    njs_value_t         then, value, args[3];
+    njs_promise_data_t  *data;
+
+    data = njs_promise_data(promise);
+
+    if (njs_is_object(resolution)) {
+
+        if (resolution->data.u.object == promise->data.u.object) {
+            njs_type_error(vm, "promise is resolved with itself");
+            goto rejected;
+        }
+
+        ret = njs_promise_then_property(vm, resolution, &then);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto rejected;
+        }
+
+        if (njs_is_function(&then)) {
+            args[0] = *promise;
+            args[1] = *resolution;
+            args[2] = then;
+
+            return njs_promise_job_post(vm, &njs_promise_thenable_job_function,
+                                        args, 3);
+        }
+    }
+
+    return njs_promise_settle(vm, data, resolution, NJS_PROMISE_FULFILLED);
+
+rejected:
+
+    value = vm->retval;
+
+    return njs_promise_settle(vm, data, &value, NJS_PROMISE_REJECTED);
+}
+
+
+/*
+ * Getters of the "then" property are not invoked, since they cannot
+ * be called from the middle of a native function.
+ */
+
+static njs_ret_t
+njs_promise_then_property(njs_vm_t *vm, const njs_value_t *value,
+    njs_value_t *then)
+{
+    njs_ret_t             ret;
+    njs_object_prop_t     *prop;
+    njs_property_query_t  pq;
+
+    *then = njs_value_undefined;
+
+    njs_property_query_init(&pq, NJS_PROPERTY_QUERY_GET, 0);
+
+    ret = njs_property_query(vm, &pq, (njs_value_t *) value,
+                             &njs_promise_then_string);
+
+    if (ret != NXT_OK) {
+        return (ret == NXT_ERROR) ? NXT_ERROR : NXT_OK;
+    }
+
+    prop = pq.lhq.value;
+
+    switch (prop->type) {
+
+    case NJS_METHOD:
+    case NJS_PROPERTY:
+        if (njs_is_data_descriptor(prop)) {
+            *then = prop->value;
+        }
+
+        break;
+
+    case NJS_PROPERTY_HANDLER:
+        pq.scratch = *prop;
+        prop = &pq.scratch;
+
+        ret = prop->value.data.u.prop_handler(vm, (njs_value_t *) value,
+                                              NULL, &prop->value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        *then = prop->value;
+        break;
+
+    default:
+        break;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_settle(njs_vm_t *vm, njs_promise_data_t *data,
+    const njs_value_t *value, njs_promise_state_t state)
+{
+    njs_ret_t               ret;
+    njs_value_t             args[3];
+    nxt_queue_link_t        *link;
+    njs_promise_reaction_t  *reaction;
+
+    data->state = state;
+    data->result = *value;
+
+    if (state == NJS_PROMISE_REJECTED && !data->is_handled) {
+        nxt_queue_insert_tail(&vm->unhandled_rejections, &data->link);
+    }
+
+    args[1] = data->result;
+    args[2] = (state == NJS_PROMISE_REJECTED) ? njs_value_true
+                                              : njs_value_false;
+
+    for (link = nxt_queue_first(&data->reactions);
+         link != nxt_queue_tail(&data->reactions);
+         link = nxt_queue_next(link))
+    {
+        reaction = nxt_queue_link_data(link, njs_promise_reaction_t, link);
+
+        njs_value_data_set(&args[0], reaction);
+        args[0].data.magic16 = NJS_PROMISE_REACTION_MAGIC;
+
+        ret = njs_promise_job_post(vm, &njs_promise_reaction_job_function,
+                                   args, 3);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    nxt_queue_init(&data->reactions);
+
+    return NXT_OK;
+}
+
+
+/*
+ * ES6, 25.4.5.3.1: PerformPromiseThen().
+ */
+
+static njs_ret_t
+njs_promise_perform_then(njs_vm_t *vm, const njs_value_t *promise,
+    const njs_value_t *fulfilled, const njs_value_t *rejected,
+    const njs_value_t *derived)
+{
+    njs_value_t             args[3];
+    njs_promise_data_t      *data;
+    njs_promise_reaction_t  *reaction;
+
+    data = njs_promise_data(promise);
+
+    reaction = nxt_mp_alloc(vm->mem_pool, sizeof(njs_promise_reaction_t));
+    if (nxt_slow_path(reaction == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    reaction->promise = *derived;
+    reaction->fulfilled = njs_is_function(fulfilled) ? *fulfilled
+                                                     : njs_value_undefined;
+    reaction->rejected = njs_is_function(rejected) ? *rejected
+                                                   : njs_value_undefined;
+
+    if (data->state == NJS_PROMISE_PENDING) {
+        nxt_queue_insert_tail(&data->reactions, &reaction->link);
+        data->is_handled = 1;
+
+        return NXT_OK;
+    }
+
+    if (data->state == NJS_PROMISE_REJECTED && !data->is_handled) {
+        nxt_queue_remove(&data->link);
+    }
+
+    data->is_handled = 1;
+
+    njs_value_data_set(&args[0], reaction);
+    args[0].data.magic16 = NJS_PROMISE_REACTION_MAGIC;
+    args[1] = data->result;
+    args[2] = (data->state == NJS_PROMISE_REJECTED) ? njs_value_true
+                                                    : njs_value_false;
+
+    return njs_promise_job_post(vm, &njs_promise_reaction_job_function,
+                                args, 3);
+}
+
+
+static njs_ret_t
+njs_promise_job_post(njs_vm_t *vm, const njs_value_t *function,
+    const njs_value_t *args, nxt_uint_t nargs)
+{
+    njs_promise_job_t  *job;
+
+    job = nxt_mp_alloc(vm->mem_pool, sizeof(njs_promise_job_t));
+    if (nxt_slow_path(job == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    memcpy(job->args, args, nargs * sizeof(njs_value_t));
+
+    /*
+     * Jobs are not added to vm->events_hash, so they are not "once"
+     * events and are only unlinked from vm->posted_events when run.
+     */
+
+    job->event.function = function->data.u.function;
+    job->event.args = job->args;
+    job->event.nargs = nargs;
+    job->event.host_event = NULL;
+    job->event.destructor = NULL;
+    job->event.id = njs_value_undefined;
+    job->event.once = 0;
+    job->event.interval = 0;
+    job->event.posted = 1;
+
+    nxt_queue_insert_tail(&vm->posted_events, &job->event.link);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_apply(njs_vm_t *vm, njs_function_t *function,
+    const njs_value_t *this, const njs_value_t *args, nxt_uint_t nargs,
+    njs_promise_cont_t *cont, njs_function_native_t next)
+{
+    njs_ret_t           ret;
+    njs_native_frame_t  *frame;
+
+    frame = vm->top_frame;
+
+    cont->u.cont.function = next;
+    njs_set_invalid(&cont->retval);
+
+    ret = njs_function_activate(vm, function, this, args, nargs,
+                                (njs_index_t) &cont->retval, 0);
+
+    if (nxt_fast_path(ret == NJS_APPLIED)) {
+        frame->exception.catch = (u_char *) njs_continuation_nexus;
+    }
+
+    return ret;
+}
+
+
+/*
+ * ES6, 25.4.2.1: PromiseReactionJob().
+ *   args[1]: the reaction,
+ *   args[2]: the settled value,
+ *   args[3]: true if the promise was rejected.
+ */
+
+static njs_ret_t
+njs_promise_reaction_job(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_ret_t               ret;
+    njs_value_t             *handler;
+    njs_promise_cont_t      *cont;
+    njs_promise_reaction_t  *reaction;
+
+    reaction = args[1].data.u.data;
+
+    handler = njs_is_true(&args[3]) ? &reaction->rejected
+                                    : &reaction->fulfilled;
+
+    if (njs_is_function(handler)) {
+        cont = njs_vm_continuation(vm);
+        cont->data = reaction;
+
+        return njs_promise_apply(vm, handler->data.u.function,
+                                 &njs_value_undefined, &args[2], 1, cont,
+                                 njs_promise_reaction_job_continuation);
+    }
+
+    ret = NXT_OK;
+
+    if (!njs_is_undefined(&reaction->promise)) {
+        if (njs_is_true(&args[3])) {
+            ret = njs_promise_settle(vm, njs_promise_data(&reaction->promise),
+                                     &args[2], NJS_PROMISE_REJECTED);
+
+        } else {
+            ret = njs_promise_resolve_value(vm, &reaction->promise, &args[2]);
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return ret;
+}
+
+
+static njs_ret_t
+njs_promise_reaction_job_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t               ret;
+    njs_value_t             value;
+    njs_promise_cont_t      *cont;
+    njs_promise_reaction_t  *reaction;
+
+    cont = njs_vm_continuation(vm);
+    reaction = cont->data;
+
+    ret = NXT_OK;
+
+    if (njs_promise_thrown(vm, cont)) {
+        value = vm->retval;
+
+        if (!njs_is_undefined(&reaction->promise)) {
+            ret = njs_promise_settle(vm, njs_promise_data(&reaction->promise),
+                                     &value, NJS_PROMISE_REJECTED);
+        }
+
+    } else if (!njs_is_undefined(&reaction->promise)) {
+        ret = njs_promise_resolve_value(vm, &reaction->promise,
+                                        &cont->retval);
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return ret;
+}
+
+
+/*
+ * ES6, 25.4.2.2: PromiseResolveThenableJob().
+ *   args[1]: the promise,
+ *   args[2]: the thenable,
+ *   args[3]: the thenable "then" method.
+ */
+
+static njs_ret_t
+njs_promise_thenable_job(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_ret_t                 ret;
+    njs_value_t               arguments[2];
+    njs_function_t            *then;
+    njs_promise_cont_t        *cont;
+    njs_promise_capability_t  *capability;
+
+    then = args[3].data.u.function;
+
+    if (then->native && then->u.native == njs_promise_prototype_then
+        && njs_promise_data(&args[2]) != NULL)
+    {
+        /* A native promise is adopted without calling script code. */
+
+        ret = njs_promise_perform_then(vm, &args[2], &njs_value_undefined,
+                                       &njs_value_undefined, &args[1]);
+
+        vm->retval = njs_value_undefined;
+
+        return ret;
+    }
+
+    capability = njs_promise_capability(vm, &args[1]);
+    if (nxt_slow_path(capability == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cont = njs_vm_continuation(vm);
+    cont->data = capability;
+
+    arguments[0] = capability->resolve;
+    arguments[1] = capability->reject;
+
+    return njs_promise_apply(vm, then, &args[2], arguments, 2, cont,
+                             njs_promise_thenable_job_continuation);
+}
+
+
+static njs_ret_t
+njs_promise_thenable_job_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t                 ret;
+    njs_value_t               value;
+    njs_promise_cont_t        *cont;
+    njs_promise_capability_t  *capability;
+
+    cont = njs_vm_continuation(vm);
+    capability = cont->data;
+
+    if (njs_promise_thrown(vm, cont) && !capability->resolved) {
+        capability->resolved = 1;
+
+        value = vm->retval;
+
+        ret = njs_promise_settle(vm, njs_promise_data(&capability->promise),
+                                 &value, NJS_PROMISE_REJECTED);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Creates a promise resolved with the value or rejected with it.
+ */
+
+njs_ret_t
+njs_promise_settled(njs_vm_t *vm, njs_value_t *retval,
+    const njs_value_t *value, nxt_bool_t rejected)
+{
+    njs_value_t         promise;
+    njs_promise_data_t  *data;
+
+    data = njs_promise_alloc(vm, &promise);
+    if (nxt_slow_path(data == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *retval = promise;
+
+    if (rejected) {
+        return njs_promise_settle(vm, data, value, NJS_PROMISE_REJECTED);
+    }
+
+    return njs_promise_resolve_value(vm, &promise, value);
+}
+
+
+njs_ret_t
+njs_vm_promise_create(njs_vm_t *vm, njs_value_t *retval,
+    njs_value_t *callbacks)
+{
+    njs_value_t               promise;
+    njs_promise_capability_t  *capability;
+
+    if (nxt_slow_path(njs_promise_alloc(vm, &promise) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    capability = njs_promise_capability(vm, &promise);
+    if (nxt_slow_path(capability == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *retval = promise;
+    callbacks[0] = capability->resolve;
+    callbacks[1] = capability->reject;
+
+    return NXT_OK;
+}
+
+
+/*
+ * ES6, 25.4.4.5: PromiseResolve().
+ */
+
+nxt_inline njs_ret_t
+njs_promise_cast(njs_vm_t *vm, const njs_value_t *value, njs_value_t *retval)
+{
+    if (njs_promise_data(value) != NULL) {
+        *retval = *value;
+        return NXT_OK;
+    }
+
+    return njs_promise_settled(vm, retval, value, 0);
+}
+
+
+njs_ret_t
+njs_promise_create(njs_vm_t *vm, njs_value_t *retval)
+{
+    if (nxt_slow_path(njs_promise_alloc(vm, retval) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Resolves or rejects a promise created by njs_promise_create().
+ */
+
+njs_ret_t
+njs_promise_settle_value(njs_vm_t *vm, const njs_value_t *promise,
+    const njs_value_t *value, nxt_bool_t rejected)
+{
+    if (rejected) {
+        return njs_promise_settle(vm, njs_promise_data(promise), value,
+                                  NJS_PROMISE_REJECTED);
+    }
+
+    return njs_promise_resolve_value(vm, promise, value);
+}
+
+
+/*
+ * Calls one of the native functions once the value cast to a promise
+ * is settled, no derived promise is created.
+ */
+
+njs_ret_t
+njs_promise_react(njs_vm_t *vm, const njs_value_t *value,
+    const njs_value_t *fulfilled, const njs_value_t *rejected)
+{
+    njs_ret_t    ret;
+    njs_value_t  promise;
+
+    ret = njs_promise_cast(vm, value, &promise);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_promise_perform_then(vm, &promise, fulfilled, rejected,
+                                    &njs_value_undefined);
+}
+
+
+/*
+ * Reports the first promise rejected without a handler and marks
+ * all such promises as handled.
+ */
+
+njs_ret_t
+njs_promise_unhandled_rejection(njs_vm_t *vm)
+{
+    nxt_queue_t         *rejections;
+    nxt_queue_link_t    *link;
+    njs_promise_data_t  *data;
+
+    rejections = &vm->unhandled_rejections;
+
+    link = nxt_queue_first(rejections);
+    data = nxt_queue_link_data(link, njs_promise_data_t, link);
+
+    vm->retval = data->result;
+
+    while (link != nxt_queue_tail(rejections)) {
+        data = nxt_queue_link_data(link, njs_promise_data_t, link);
+        data->is_handled = 1;
+
+        link = nxt_queue_next(link);
+    }
+
+    nxt_queue_init(rejections);
+
+    return NXT_ERROR;
+}
+
+
+/*
+ * Marks the values referred to by the promise structures
+ * which are passed around as NJS_DATA values.
+ */
+
+nxt_int_t
+njs_promise_gc_mark(njs_gc_t *gc, const njs_value_t *value)
+{
+    nxt_int_t                  ret;
+    nxt_queue_link_t           *link;
+    njs_promise_all_t          *all;
+    njs_promise_data_t         *data;
+    njs_promise_reaction_t     *reaction;
+    njs_promise_all_element_t  *element;
+
+    switch (value->data.magic16) {
+
+    case NJS_PROMISE_MAGIC:
+        data = value->data.u.data;
+
+        ret = njs_gc_mark_value(gc, &data->result);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        for (link = nxt_queue_first(&data->reactions);
+             link != nxt_queue_tail(&data->reactions);
+             link = nxt_queue_next(link))
+        {
+            reaction = nxt_queue_link_data(link, njs_promise_reaction_t, link);
+
+            ret = njs_promise_gc_mark_reaction(gc, reaction);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+        return NXT_OK;
+
+    case NJS_PROMISE_REACTION_MAGIC:
+        return njs_promise_gc_mark_reaction(gc, value->data.u.data);
+
+    case NJS_PROMISE_CAPABILITY_MAGIC:
+        return njs_promise_gc_mark_capability(gc, value->data.u.data);
+
+    case NJS_PROMISE_ELEMENT_MAGIC:
+        element = value->data.u.data;
+        all = element->all;
+
+        ret = njs_gc_mark_value(gc, &all->values);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        return njs_promise_gc_mark_capability(gc, all->capability);
+
+    default:
+        return NXT_OK;
+    }
+}
+
+
+nxt_int_t
+njs_promise_gc_mark_rejections(njs_vm_t *vm, njs_gc_t *gc)
+{
+    nxt_int_t           ret;
+    nxt_queue_t         *rejections;
+    nxt_queue_link_t    *link;
+    njs_promise_data_t  *data;
+
+    rejections = &vm->unhandled_rejections;
+
+    for (link = nxt_queue_first(rejections);
+         link != nxt_queue_tail(rejections);
+         link = nxt_queue_next(link))
+    {
+        data = nxt_queue_link_data(link, njs_promise_data_t, link);
+
+        ret = njs_gc_mark_value(gc, &data->result);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_promise_gc_mark_reaction(njs_gc_t *gc, njs_promise_reaction_t *reaction)
+{
+    nxt_int_t  ret;
+
+    ret = njs_gc_mark_value(gc, &reaction->promise);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    ret = njs_gc_mark_value(gc, &reaction->fulfilled);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_gc_mark_value(gc, &reaction->rejected);
+}
+
+
+static nxt_int_t
+njs_promise_gc_mark_capability(njs_gc_t *gc,
+    njs_promise_capability_t *capability)
+{
+    nxt_int_t  ret;
+
+    ret = njs_gc_mark_value(gc, &capability->promise);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    ret = njs_gc_mark_value(gc, &capability->resolve);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_gc_mark_value(gc, &capability->reject);
+}
+
+
+static njs_ret_t
+njs_promise_resolve(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_cast(vm, njs_arg(args, nargs, 1), &vm->retval);
+}
+
+
+static njs_ret_t
+njs_promise_reject(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_settled(vm, &vm->retval, njs_arg(args, nargs, 1), 1);
+}
+
+
+static njs_ret_t
+njs_promise_all_element(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_ret_t                  ret;
+    njs_promise_all_t          *all;
+    njs_promise_capability_t   *capability;
+    njs_promise_all_element_t  *element;
+
+    element = args[1].data.u.data;
+
+    if (!element->called) {
+        element->called = 1;
+
+        all = element->all;
+        all->values.data.u.array->start[element->index] =
+                                                     *njs_arg(args, nargs, 2);
+
+        if (--all->remaining == 0) {
+            capability = all->capability;
+
+            if (!capability->resolved) {
+                capability->resolved = 1;
+
+                ret = njs_promise_resolve_value(vm, &capability->promise,
+                                                &all->values);
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    return ret;
+                }
+            }
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Promise.all() and Promise.race() accept arrays only
+ * since iterators are not supported.
+ */
+
+static njs_ret_t
+njs_promise_combinator(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    nxt_bool_t race)
+{
+    uint32_t                   i, length;
+    njs_ret_t                  ret;
+    njs_value_t                promise, item, value, function, *start;
+    njs_array_t                *array, *values;
+    njs_promise_all_t          *all;
+    const njs_value_t          *iterable;
+    njs_promise_capability_t   *capability;
+    njs_promise_all_element_t  *element;
+
+    iterable = njs_arg(args, nargs, 1);
+
+    if (!njs_is_array(iterable)) {
+        njs_type_error(vm, "argument is not an array");
+        value = vm->retval;
+
+        return njs_promise_settled(vm, &vm->retval, &value, 1);
+    }
+
+    if (nxt_slow_path(njs_promise_alloc(vm, &promise) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    capability = njs_promise_capability(vm, &promise);
+    if (nxt_slow_path(capability == NULL)) {
+        return NXT_ERROR;
+    }
+
+    array = iterable->data.u.array;
+    length = array->length;
+
+    all = NULL;
+
+    if (!race) {
+        values = njs_array_alloc(vm, length, 0);
+        if (nxt_slow_path(values == NULL)) {
+            return NXT_ERROR;
+        }
+
+        for (i = 0; i < length; i++) {
+            values->start[i] = njs_value_undefined;
+        }
+
+        all = nxt_mp_alloc(vm->mem_pool, sizeof(njs_promise_all_t));
+        if (nxt_slow_path(all == NULL)) {
+            njs_memory_error(vm);
+            return NXT_ERROR;
+        }
+
+        all->capability = capability;
+        all->values.data.u.array = values;
+        all->values.type = NJS_ARRAY;
+        all->values.data.truth = 1;
+        all->remaining = 1;
+    }
+
+    for (i = 0; i < length; i++) {
+        start = array->start;
+
+        item = njs_is_valid(&start[i]) ? start[i] : njs_value_undefined;
+
+        ret = njs_promise_cast(vm, &item, &value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        if (race) {
+            ret = njs_promise_perform_then(vm, &value, &capability->resolve,
+                                           &capability->reject,
+                                           &njs_value_undefined);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            continue;
+        }
+
+        element = nxt_mp_alloc(vm->mem_pool,
+                               sizeof(njs_promise_all_element_t));
+        if (nxt_slow_path(element == NULL)) {
+            njs_memory_error(vm);
+            return NXT_ERROR;
+        }
+
+        element->all = all;
+        element->index = i;
+        element->called = 0;
+
+        njs_value_data_set(&item, element);
+        item.data.magic16 = NJS_PROMISE_ELEMENT_MAGIC;
+
+        ret = njs_promise_function(vm, &function, njs_promise_all_element,
+                                   &item);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        all->remaining++;
+
+        ret = njs_promise_perform_then(vm, &value, &function,
+                                       &capability->reject,
+                                       &njs_value_undefined);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (!race && --all->remaining == 0) {
+        capability->resolved = 1;
+
+        ret = njs_promise_resolve_value(vm, &promise, &all->values);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    vm->retval = promise;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_all(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_combinator(vm, args, nargs, 0);
+}
+
+
+static njs_ret_t
+njs_promise_race(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_combinator(vm, args, nargs, 1);
+}
+
+
+static const njs_object_prop_t  njs_promise_constructor_properties[] =
+{
+    /* Promise.name == "Promise". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("Promise"),
+        .configurable = 1,
+    },
+
+    /* Promise.length == 1. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 1, 1.0),
+        .configurable = 1,
+    },
+
+    /* Promise.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("resolve"),
+        .value = njs_native_function(njs_promise_resolve, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("reject"),
+        .value = njs_native_function(njs_promise_reject, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("all"),
+        .value = njs_native_function(njs_promise_all, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("race"),
+        .value = njs_native_function(njs_promise_race, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_promise_constructor_init = {
+    nxt_string("Promise"),
+    njs_promise_constructor_properties,
+    nxt_nitems(njs_promise_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_promise_prototype_then(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_ret_t    ret;
+    njs_value_t  derived;
+
+    if (njs_promise_data(&args[0]) == NULL) {
+        njs_type_error(vm, "\"this\" argument is not a Promise");
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(njs_promise_alloc(vm, &derived) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = njs_promise_perform_then(vm, &args[0], njs_arg(args, nargs, 1),
+                                   njs_arg(args, nargs, 2), &derived);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    vm->retval = derived;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_prototype_catch(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    njs_value_t  arguments[3];
+
+    arguments[0] = args[0];
+    arguments[1] = njs_value_undefined;
+    arguments[2] = *njs_arg(args, nargs, 1);
+
+    return njs_promise_prototype_then(vm, arguments, 3, unused);
+}
+
+
+/*
+ * ES9, 25.6.5.3.1: Then Finally Functions and Catch Finally Functions.
+ *   args[1]: the onFinally function,
+ *   args[2]: the value or the reason.
+ */
+
+static njs_ret_t
+njs_promise_finally_call(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    nxt_bool_t rejected)
+{
+    njs_promise_cont_t  *cont;
+
+    cont = njs_vm_continuation(vm);
+    cont->value = *njs_arg(args, nargs, 2);
+    cont->data = (void *) (uintptr_t) rejected;
+
+    return njs_promise_apply(vm, args[1].data.u.function,
+                             &njs_value_undefined, &args[2], 0, cont,
+                             njs_promise_finally_continuation);
+}
+
+
+static njs_ret_t
+njs_promise_then_finally(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_finally_call(vm, args, nargs, 0);
+}
+
+
+static njs_ret_t
+njs_promise_catch_finally(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_promise_finally_call(vm, args, nargs, 1);
+}
+
+
+static njs_ret_t
+njs_promise_finally_continuation(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t              ret;
+    njs_value_t            promise, derived, thunk;
+    nxt_bool_t             rejected;
+    njs_promise_cont_t     *cont;
+    njs_function_native_t  native;
+
+    cont = njs_vm_continuation(vm);
+
+    if (njs_promise_thrown(vm, cont)) {
+        return NXT_ERROR;
+    }
+
+    rejected = (nxt_bool_t) (uintptr_t) cont->data;
+
+    if (!njs_is_object(&cont->retval)) {
+        /* A non-thenable result does not delay the original outcome. */
+
+        vm->retval = cont->value;
+
+        return rejected ? NXT_ERROR : NXT_OK;
+    }
+
+    ret = njs_promise_settled(vm, &promise, &cont->retval, 0);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    native = rejected ? njs_promise_finally_thrower
+                      : njs_promise_finally_value;
+
+    ret = njs_promise_function(vm, &thunk, native, &cont->value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    if (nxt_slow_path(njs_promise_alloc(vm, &derived) == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = njs_promise_perform_then(vm, &promise, &thunk, &njs_value_undefined,
+                                   &derived);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    vm->retval = derived;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_finally_value(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    vm->retval = args[1];
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_promise_finally_thrower(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    vm->retval = args[1];
+
+    return NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_promise_prototype_finally(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_ret_t          ret;
+    njs_value_t        arguments[3];
+    const njs_value_t  *on_finally;
+
+    if (njs_promise_data(&args[0]) == NULL) {
+        njs_type_error(vm, "\"this\" argument is not a Promise");
+        return NXT_ERROR;
+    }
+
+    arguments[0] = args[0];
+
+    on_finally = njs_arg(args, nargs, 1);
+
+    if (!njs_is_function(on_finally)) {
+        arguments[1] = *on_finally;
+        arguments[2] = *on_finally;
+
+        return njs_promise_prototype_then(vm, arguments, 3, unused);
+    }
+
+    ret = njs_promise_function(vm, &arguments[1], njs_promise_then_finally,
+                               on_finally);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    ret = njs_promise_function(vm, &arguments[2], njs_promise_catch_finally,
+                               on_finally);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_promise_prototype_then(vm, arguments, 3, unused);
+}
+
+
+static const njs_object_prop_t  njs_promise_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("then"),
+        .value = njs_native_function(njs_promise_prototype_then, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("catch"),
+        .value = njs_native_function(njs_promise_prototype_catch, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("finally"),
+        .value = njs_native_function(njs_promise_prototype_finally, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_promise_prototype_init = {
+    nxt_string("Promise"),
+    njs_promise_prototype_properties,
+    nxt_nitems(njs_promise_prototype_properties),
+};
@@ -0,0 +1,42 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_PROMISE_H_INCLUDED_
+#define _NJS_PROMISE_H_INCLUDED_
+
+
+typedef struct {
+    union {
+        njs_continuation_t  cont;
+        u_char              padding[NJS_CONTINUATION_SIZE];
+    } u;
+
+    njs_value_t             retval;
+    njs_value_t             value;
+    void                    *data;
+} njs_promise_cont_t;
+
+
+njs_ret_t njs_promise_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_promise_settled(njs_vm_t *vm, njs_value_t *retval,
+    const njs_value_t *value, nxt_bool_t rejected);
+njs_ret_t njs_promise_create(njs_vm_t *vm, njs_value_t *retval);
+njs_ret_t njs_promise_settle_value(njs_vm_t *vm, const njs_value_t *promise,
+    const njs_value_t *value, nxt_bool_t rejected);
+njs_ret_t njs_promise_react(njs_vm_t *vm, const njs_value_t *value,
+    const njs_value_t *fulfilled, const njs_value_t *rejected);
+njs_ret_t njs_promise_function(njs_vm_t *vm, njs_value_t *retval,
+    njs_function_native_t native, const njs_value_t *value);
+njs_ret_t njs_promise_unhandled_rejection(njs_vm_t *vm);
+nxt_int_t njs_promise_gc_mark(njs_gc_t *gc, const njs_value_t *value);
+nxt_int_t njs_promise_gc_mark_rejections(njs_vm_t *vm, njs_gc_t *gc);
+
+
+extern const njs_object_init_t  njs_promise_constructor_init;
+extern const njs_object_init_t  njs_promise_prototype_init;
+
+
+#endif /* _NJS_PROMISE_H_INCLUDED_ */
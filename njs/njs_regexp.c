@@ -31,7 +31,8 @@ static u_char *njs_regexp_compile_trace_handler(nxt_trace_t *trace,
 static u_char *njs_regexp_match_trace_handler(nxt_trace_t *trace,
     nxt_trace_data_t *td, u_char *start);
 static njs_ret_t njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp,
-    njs_utf8_t utf8, u_char *string, nxt_regex_match_data_t *match_data);
+    const njs_value_t *input, njs_utf8_t utf8, u_char *string,
+    nxt_regex_match_data_t *match_data);
 static njs_ret_t njs_regexp_string_create(njs_vm_t *vm, njs_value_t *value,
     u_char *start, uint32_t size, int32_t length);
 
@@ -702,14 +703,16 @@ njs_regexp_alloc(njs_vm_t *vm, njs_regexp_pattern_t *pattern)
     regexp = nxt_mp_alloc(vm->mem_pool, sizeof(njs_regexp_t));
 
     if (nxt_fast_path(regexp != NULL)) {
-        nxt_lvlhsh_init(&regexp->object.hash);
-        nxt_lvlhsh_init(&regexp->object.shared_hash);
+        nxt_flathsh_init(&regexp->object.hash);
+        nxt_flathsh_init(&regexp->object.shared_hash);
         regexp->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_REGEXP].object;
         regexp->object.type = NJS_REGEXP;
         regexp->object.shared = 0;
         regexp->object.extensible = 1;
+        regexp->object.frozen = 0;
         regexp->last_index = 0;
         regexp->pattern = pattern;
+        regexp->string = njs_string_empty;
         return regexp;
     }
 
@@ -904,7 +907,21 @@ njs_regexp_prototype_exec(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     }
 
     regexp = args[0].data.u.regexp;
-    regexp->string = *value;
+
+    /*
+     * A regexp reachable from the global state of a frozen VM is shared
+     * by the clones, its lastIndex and input string must not be changed.
+     */
+
+    if (nxt_slow_path(regexp->object.frozen)) {
+        if (regexp->pattern->global) {
+            njs_type_error(vm, "Cannot modify a frozen RegExp");
+            return NXT_ERROR;
+        }
+
+    } else {
+        regexp->string = *value;
+    }
 
     (void) njs_string_prop(&string, value);
 
@@ -937,8 +954,8 @@ njs_regexp_prototype_exec(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             ret = njs_regexp_match(vm, &pattern->regex[type], string.start,
                                    string.size, match_data);
             if (ret >= 0) {
-                return njs_regexp_exec_result(vm, regexp, utf8, string.start,
-                                              match_data);
+                return njs_regexp_exec_result(vm, regexp, value, utf8,
+                                              string.start, match_data);
             }
 
             if (nxt_slow_path(ret != NXT_REGEX_NOMATCH)) {
@@ -949,7 +966,10 @@ njs_regexp_prototype_exec(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         }
     }
 
-    regexp->last_index = 0;
+    if (!regexp->object.frozen) {
+        regexp->last_index = 0;
+    }
+
     vm->retval = njs_value_null;
 
     return NXT_OK;
@@ -957,8 +977,9 @@ njs_regexp_prototype_exec(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
 
 
 static njs_ret_t
-njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
-    u_char *string, nxt_regex_match_data_t *match_data)
+njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp,
+    const njs_value_t *input, njs_utf8_t utf8, u_char *string,
+    nxt_regex_match_data_t *match_data)
 {
     int                 *captures;
     u_char              *start;
@@ -1023,12 +1044,12 @@ njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
     lhq.pool = vm->mem_pool;
     lhq.proto = &njs_object_hash_proto;
 
-    ret = nxt_lvlhsh_insert(&array->object.hash, &lhq);
+    ret = nxt_flathsh_insert(&array->object.hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto insert_fail;
     }
 
-    prop = njs_object_prop_alloc(vm, &string_input, &regexp->string, 1);
+    prop = njs_object_prop_alloc(vm, &string_input, input, 1);
     if (nxt_slow_path(prop == NULL)) {
         goto fail;
     }
@@ -1037,7 +1058,7 @@ njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
     lhq.key = nxt_string_value("input");
     lhq.value = prop;
 
-    ret = nxt_lvlhsh_insert(&array->object.hash, &lhq);
+    ret = nxt_flathsh_insert(&array->object.hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto insert_fail;
     }
@@ -1051,7 +1072,7 @@ njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
     lhq.key = nxt_string_value("groups");
     lhq.value = prop;
 
-    ret = nxt_lvlhsh_insert(&array->object.hash, &lhq);
+    ret = nxt_flathsh_insert(&array->object.hash, &lhq);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto insert_fail;
     }
@@ -1087,7 +1108,7 @@ njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
             lhq.key = group->name;
             lhq.value = prop;
 
-            ret = nxt_lvlhsh_insert(&groups->hash, &lhq);
+            ret = nxt_flathsh_insert(&groups->hash, &lhq);
             if (nxt_slow_path(ret != NXT_OK)) {
                 goto insert_fail;
             }
@@ -1106,7 +1127,7 @@ njs_regexp_exec_result(njs_vm_t *vm, njs_regexp_t *regexp, njs_utf8_t utf8,
 
 insert_fail:
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
 fail:
 
@@ -32,6 +32,7 @@
 typedef struct {
     uint8_t                 disassemble;
     uint8_t                 interactive;
+    uint8_t                 jit;
     uint8_t                 module;
     uint8_t                 quiet;
     uint8_t                 sandbox;
@@ -262,6 +263,7 @@ main(int argc, char **argv)
     vm_options.quiet = opts.quiet;
     vm_options.sandbox = opts.sandbox;
     vm_options.module = opts.module;
+    vm_options.jit = opts.jit ? NJS_JIT_THRESHOLD : 0;
 
     vm_options.ops = &njs_console_ops;
     vm_options.external = &njs_console;
@@ -305,6 +307,9 @@ njs_get_options(njs_opts_t *opts, int argc, char** argv)
         "Options:\n"
         "  -c                specify the command to execute.\n"
         "  -d                print disassembled code.\n"
+#if (NXT_HAVE_JIT)
+        "  -j                compile hot functions to machine code.\n"
+#endif
         "  -p                set path prefix for modules.\n"
         "  -q                disable interactive introduction prompt.\n"
         "  -s                sandbox mode.\n"
@@ -347,6 +352,12 @@ njs_get_options(njs_opts_t *opts, int argc, char** argv)
             opts->disassemble = 1;
             break;
 
+#if (NXT_HAVE_JIT)
+        case 'j':
+            opts->jit = 1;
+            break;
+#endif
+
         case 'p':
             if (++i < argc) {
                 opts->n_paths++;
@@ -754,9 +765,10 @@ static nxt_int_t
 njs_process_script(njs_console_t *console, njs_opts_t *opts,
     const nxt_str_t *script)
 {
-    u_char     *start;
-    njs_vm_t   *vm;
-    nxt_int_t  ret;
+    u_char      *start;
+    njs_vm_t    *vm;
+    nxt_int_t   ret;
+    nxt_bool_t  failed;
 
     vm = console->vm;
     start = script->start;
@@ -774,34 +786,40 @@ njs_process_script(njs_console_t *console, njs_opts_t *opts,
 
     njs_output(vm, opts, ret);
 
-    for ( ;; ) {
-        if (!njs_vm_pending(vm)) {
-            break;
-        }
+    failed = (ret != NXT_OK);
 
+    /*
+     * njs_vm_run() is called at least once, so a promise rejected
+     * without a handler by the global code is reported as well.
+     */
+
+    for ( ;; ) {
         ret = njs_process_events(console, opts);
         if (nxt_slow_path(ret != NXT_OK)) {
             nxt_error("njs_process_events() failed\n");
-            ret = NJS_ERROR;
-            break;
+            return NJS_ERROR;
         }
 
         if (njs_vm_waiting(vm) && !njs_vm_posted(vm)) {
             /*TODO: async events. */
 
             nxt_error("njs_process_script(): async events unsupported\n");
-            ret = NJS_ERROR;
-            break;
+            return NJS_ERROR;
         }
 
         ret = njs_vm_run(vm);
 
         if (ret == NJS_ERROR) {
             njs_output(vm, opts, ret);
+            failed = 1;
+        }
+
+        if (!njs_vm_pending(vm)) {
+            break;
         }
     }
 
-    return ret;
+    return failed ? NJS_ERROR : NJS_OK;
 }
 
 
@@ -7,6 +7,7 @@
 #include <njs_core.h>
 #include <njs_regexp.h>
 #include <njs_regexp_pattern.h>
+#include <njs_typed_array.h>
 #include <string.h>
 
 
@@ -146,7 +147,13 @@ njs_string_set(njs_vm_t *vm, njs_value_t *value, const u_char *start,
         value->long_string.external = 0xff;
         value->long_string.size = size;
 
-        string = nxt_mp_alloc(vm->mem_pool, sizeof(njs_string_t));
+        if (vm->gc) {
+            string = njs_gc_alloc(vm, NJS_STRING, sizeof(njs_string_t));
+
+        } else {
+            string = nxt_mp_alloc(vm->mem_pool, sizeof(njs_string_t));
+        }
+
         if (nxt_slow_path(string == NULL)) {
             njs_memory_error(vm);
             return NXT_ERROR;
@@ -156,7 +163,7 @@ njs_string_set(njs_vm_t *vm, njs_value_t *value, const u_char *start,
 
         string->start = (u_char *) start;
         string->length = 0;
-        string->retain = 1;
+        string->retain = 0;
     }
 
     return NXT_OK;
@@ -220,14 +227,19 @@ njs_string_alloc(njs_vm_t *vm, njs_value_t *value, uint64_t size,
         total = size;
     }
 
-    string = nxt_mp_alloc(vm->mem_pool, sizeof(njs_string_t) + total);
+    if (vm->gc) {
+        string = njs_gc_alloc(vm, NJS_STRING, sizeof(njs_string_t) + total);
+
+    } else {
+        string = nxt_mp_alloc(vm->mem_pool, sizeof(njs_string_t) + total);
+    }
 
     if (nxt_fast_path(string != NULL)) {
         value->long_string.data = string;
 
         string->start = (u_char *) string + sizeof(njs_string_t);
         string->length = length;
-        string->retain = 1;
+        string->retain = 0;
 
         if (map_offset != 0) {
             map = (uint32_t *) (string->start + map_offset);
@@ -1416,6 +1428,10 @@ done:
  * String.bytesFrom(array).
  * Converts an array containing octets into a byte string.
  *
+ * String.bytesFrom(buffer).
+ * Copies the bytes of an ArrayBuffer, a typed array or a DataView
+ * into a byte string.
+ *
  * String.bytesFrom(string[, encoding]).
  * Converts a string using provided encoding: hex, base64, base64url to
  * a byte string.
@@ -1425,6 +1441,7 @@ static njs_ret_t
 njs_string_bytes_from(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
+    nxt_str_t          bytes;
     const njs_value_t  *value;
 
     value = njs_arg(args, nargs, 1);
@@ -1437,7 +1454,11 @@ njs_string_bytes_from(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return njs_string_bytes_from_array(vm, njs_arg(args, nargs, 1));
     }
 
-    njs_type_error(vm, "value must be a string or array");
+    if (njs_array_buffer_bytes(value, &bytes) == NXT_OK) {
+        return njs_string_new(vm, &vm->retval, bytes.start, bytes.length, 0);
+    }
+
+    njs_type_error(vm, "value must be a string, array or ArrayBuffer");
 
     return NJS_ERROR;
 }
@@ -2684,7 +2705,10 @@ njs_string_match_multiple(njs_vm_t *vm, njs_value_t *args,
     njs_regexp_utf8_t  type;
     njs_string_prop_t  string;
 
-    args[1].data.u.regexp->last_index = 0;
+    if (!args[1].data.u.regexp->object.frozen) {
+        args[1].data.u.regexp->last_index = 0;
+    }
+
     vm->retval = njs_value_null;
 
     (void) njs_string_prop(&string, &args[0]);
@@ -4667,7 +4691,7 @@ njs_value_index(njs_vm_t *vm, const njs_value_t *src, nxt_uint_t runtime)
 
             string->start = (u_char *) string + sizeof(njs_string_t);
             string->length = src->long_string.data->length;
-            string->retain = 0xffff;
+            string->retain = 0;
 
             memcpy(string->start, start, size);
         }
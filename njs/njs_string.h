@@ -82,6 +82,13 @@ struct njs_string_s {
 };
 
 
+/*
+ * The link counter of a string is maintained only if the flag is set,
+ * see njs_value_retain().
+ */
+#define NJS_STRING_COUNTED  0x80000000
+
+
 typedef struct {
     size_t    size;
     size_t    length;
@@ -9,14 +9,24 @@
 #include <string.h>
 
 
+typedef enum {
+    NJS_TIMER_TIMEOUT = 0,
+    NJS_TIMER_IMMEDIATE,
+    NJS_TIMER_INTERVAL,
+} njs_timer_type_t;
+
+
+static njs_ret_t njs_timer_add(njs_vm_t *vm, njs_function_t *function,
+    const njs_value_t *args, nxt_uint_t nargs, uint64_t delay,
+    njs_timer_type_t type);
+
+
 static njs_ret_t
 njs_set_timer(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
-    njs_index_t unused, nxt_bool_t immediate)
+    njs_index_t unused, njs_timer_type_t type)
 {
-    nxt_uint_t     n;
-    uint64_t       delay;
-    njs_event_t   *event;
-    njs_vm_ops_t  *ops;
+    nxt_uint_t  n;
+    uint64_t    delay;
 
     if (nxt_slow_path(nargs < 2)) {
         njs_type_error(vm, "too few arguments");
@@ -28,16 +38,72 @@ njs_set_timer(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         return NJS_ERROR;
     }
 
-    ops = vm->options.ops;
-    if (nxt_slow_path(ops == NULL)) {
-        njs_internal_error(vm, "not supported by host environment");
-        return NJS_ERROR;
+    delay = 0;
+
+    if (type != NJS_TIMER_IMMEDIATE && nargs >= 3 && njs_is_number(&args[2])) {
+        delay = args[2].data.u.number;
     }
 
+    n = (type == NJS_TIMER_IMMEDIATE) ? 2 : 3;
+
+    return njs_timer_add(vm, args[1].data.u.function, &args[n],
+                         (nargs >= n) ? nargs - n : 0, delay, type);
+}
+
+
+/*
+ * The promise versions of the timers resolve the promise with
+ * the value instead of calling a function:
+ *   setTimeout(delay, value),
+ *   setImmediate(value).
+ */
+
+static njs_ret_t
+njs_set_timer_promise(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused, njs_timer_type_t type)
+{
+    njs_ret_t    ret;
+    uint64_t     delay;
+    nxt_uint_t   n;
+    njs_value_t  promise, callbacks[2];
+
     delay = 0;
 
-    if (!immediate && nargs >= 3 && njs_is_number(&args[2])) {
-        delay = args[2].data.u.number;
+    if (type != NJS_TIMER_IMMEDIATE && nargs >= 2 && njs_is_number(&args[1])) {
+        delay = args[1].data.u.number;
+    }
+
+    ret = njs_vm_promise_create(vm, &promise, callbacks);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NJS_ERROR;
+    }
+
+    n = (type == NJS_TIMER_IMMEDIATE) ? 1 : 2;
+
+    ret = njs_timer_add(vm, callbacks[0].data.u.function,
+                        njs_arg(args, nargs, n), 1, delay, type);
+    if (nxt_slow_path(ret != NJS_OK)) {
+        return ret;
+    }
+
+    vm->retval = promise;
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+njs_timer_add(njs_vm_t *vm, njs_function_t *function, const njs_value_t *args,
+    nxt_uint_t nargs, uint64_t delay, njs_timer_type_t type)
+{
+    njs_ret_t     ret;
+    njs_event_t   *event;
+    njs_vm_ops_t  *ops;
+
+    ops = vm->options.ops;
+    if (nxt_slow_path(ops == NULL && type != NJS_TIMER_IMMEDIATE)) {
+        njs_internal_error(vm, "not supported by host environment");
+        return NJS_ERROR;
     }
 
     event = nxt_mp_alloc(vm->mem_pool, sizeof(njs_event_t));
@@ -45,12 +111,13 @@ njs_set_timer(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
         goto memory_error;
     }
 
-    n = immediate ? 2 : 3;
-
-    event->destructor = ops->clear_timer;
-    event->function = args[1].data.u.function;
-    event->nargs = (nargs >= n) ? nargs - n : 0;
-    event->once = 1;
+    event->destructor = (ops != NULL) ? ops->clear_timer : NULL;
+    event->host_event = NULL;
+    event->function = function;
+    event->nargs = nargs;
+    event->once = (type != NJS_TIMER_INTERVAL);
+    event->interval = (type == NJS_TIMER_INTERVAL);
+    event->delay = delay;
     event->posted = 0;
 
     if (event->nargs != 0) {
@@ -60,7 +127,24 @@ njs_set_timer(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
             goto memory_error;
         }
 
-        memcpy(event->args, &args[n], sizeof(njs_value_t) * event->nargs);
+        memcpy(event->args, args, sizeof(njs_value_t) * event->nargs);
+    }
+
+    if (type == NJS_TIMER_IMMEDIATE) {
+        /*
+         * Immediate events do not need a host timer, they are run
+         * by the next njs_vm_run() together with the other posted events.
+         */
+
+        ret = njs_add_event(vm, event);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        event->posted = 1;
+        nxt_queue_insert_tail(&vm->posted_events, &event->link);
+
+        return NJS_OK;
     }
 
     event->host_event = ops->set_timer(vm->external, delay, event);
@@ -83,7 +167,7 @@ njs_ret_t
 njs_set_timeout(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    return njs_set_timer(vm, args, nargs, unused, 0);
+    return njs_set_timer(vm, args, nargs, unused, NJS_TIMER_TIMEOUT);
 }
 
 
@@ -91,7 +175,31 @@ njs_ret_t
 njs_set_immediate(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
     njs_index_t unused)
 {
-    return njs_set_timer(vm, args, nargs, unused, 1);
+    return njs_set_timer(vm, args, nargs, unused, NJS_TIMER_IMMEDIATE);
+}
+
+
+njs_ret_t
+njs_set_interval(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_set_timer(vm, args, nargs, unused, NJS_TIMER_INTERVAL);
+}
+
+
+static njs_ret_t
+njs_timers_set_timeout(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_set_timer_promise(vm, args, nargs, unused, NJS_TIMER_TIMEOUT);
+}
+
+
+static njs_ret_t
+njs_timers_set_immediate(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_set_timer_promise(vm, args, nargs, unused, NJS_TIMER_IMMEDIATE);
 }
 
 
@@ -148,3 +256,94 @@ const njs_object_init_t  njs_clear_timeout_function_init = {
     NULL,
     0,
 };
+
+
+const njs_object_init_t  njs_set_interval_function_init = {
+    nxt_string("setInterval"),
+    NULL,
+    0,
+};
+
+
+const njs_object_init_t  njs_clear_interval_function_init = {
+    nxt_string("clearInterval"),
+    NULL,
+    0,
+};
+
+
+static const njs_object_prop_t  njs_timers_promises_properties[] =
+{
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setTimeout"),
+        .value = njs_native_function(njs_timers_set_timeout, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setImmediate"),
+        .value = njs_native_function(njs_timers_set_immediate, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+static njs_ret_t
+njs_timers_promises(njs_vm_t *vm, njs_value_t *value, njs_value_t *setval,
+    njs_value_t *retval)
+{
+    nxt_int_t     ret;
+    njs_object_t  *object;
+
+    object = njs_object_alloc(vm);
+    if (nxt_slow_path(object == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = njs_object_hash_create(vm, &object->hash,
+                                 njs_timers_promises_properties,
+                                 nxt_nitems(njs_timers_promises_properties));
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    retval->data.u.object = object;
+    retval->type = NJS_OBJECT;
+    retval->data.truth = 1;
+
+    return NXT_OK;
+}
+
+
+static const njs_object_prop_t  njs_timers_object_properties[] =
+{
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("timers"),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("sandbox"),
+        .value = njs_value(NJS_BOOLEAN, 1, 1.0),
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("promises"),
+        .value = njs_prop_handler(njs_timers_promises),
+    },
+};
+
+
+const njs_object_init_t  njs_timers_object_init = {
+    nxt_string("timers"),
+    njs_timers_object_properties,
+    nxt_nitems(njs_timers_object_properties),
+};
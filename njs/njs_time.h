@@ -12,6 +12,8 @@ njs_ret_t njs_set_timeout(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
 njs_ret_t njs_set_immediate(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_set_interval(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
 njs_ret_t njs_clear_timeout(njs_vm_t *vm, njs_value_t *args,
     nxt_uint_t nargs, njs_index_t unused);
 
@@ -19,5 +21,8 @@ njs_ret_t njs_clear_timeout(njs_vm_t *vm, njs_value_t *args,
 extern const njs_object_init_t  njs_set_timeout_function_init;
 extern const njs_object_init_t  njs_set_immediate_function_init;
 extern const njs_object_init_t  njs_clear_timeout_function_init;
+extern const njs_object_init_t  njs_set_interval_function_init;
+extern const njs_object_init_t  njs_clear_interval_function_init;
+extern const njs_object_init_t  njs_timers_object_init;
 
 #endif /* _NJS_TIMEOUT_H_INCLUDED_ */
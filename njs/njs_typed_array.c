@@ -0,0 +1,2501 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <njs_core.h>
+#include <njs_typed_array.h>
+#include <string.h>
+
+
+/*
+ * ArrayBuffer, typed arrays and DataView are object values holding
+ * njs_array_buffer_t or njs_typed_array_t.  The data values are tagged
+ * with the magic like promises.  A typed array or a DataView refers to
+ * the ArrayBuffer object and accesses its memory directly, the elements
+ * are converted on each access and are never stored as njs values.
+ *
+ * An external ArrayBuffer refers to the memory of the host, such as
+ * an nginx buffer, without copying.  The host detaches the buffer before
+ * the memory becomes invalid, the views of a detached buffer are empty.
+ *
+ * The memory of a buffer reachable from the global state of a frozen VM
+ * is shared by its clones, the buffer cannot be modified or detached.
+ */
+
+#define NJS_ARRAY_BUFFER_MAGIC     0x6162
+#define NJS_TYPED_ARRAY_MAGIC      0x7461
+#define NJS_DATA_VIEW_MAGIC        0x6476
+
+#define NJS_ARRAY_BUFFER_MAX_SIZE  0x7fffffff
+
+
+static njs_array_buffer_t *njs_array_buffer_alloc(njs_vm_t *vm,
+    njs_value_t *value, u_char *start, uint32_t size);
+static njs_typed_array_t *njs_array_buffer_view_alloc(njs_vm_t *vm,
+    njs_value_t *value, const njs_value_t *buffer, uint32_t offset,
+    uint32_t length, njs_typed_array_type_t type, uint16_t magic);
+static njs_typed_array_t *njs_typed_array_alloc(njs_vm_t *vm,
+    njs_value_t *value, uint32_t length, njs_typed_array_type_t type);
+static njs_ret_t njs_typed_array_element_set(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval);
+
+
+static const uint8_t  njs_typed_array_sizes[] = {
+    1,  /* Int8Array */
+    1,  /* Uint8Array */
+    1,  /* Uint8ClampedArray */
+    2,  /* Int16Array */
+    2,  /* Uint16Array */
+    4,  /* Int32Array */
+    4,  /* Uint32Array */
+    4,  /* Float32Array */
+    8,  /* Float64Array */
+};
+
+
+static const char  *njs_typed_array_names[] = {
+    "Int8Array",
+    "Uint8Array",
+    "Uint8ClampedArray",
+    "Int16Array",
+    "Uint16Array",
+    "Int32Array",
+    "Uint32Array",
+    "Float32Array",
+    "Float64Array",
+};
+
+
+nxt_inline void *
+njs_array_buffer_data(const njs_value_t *value, uint16_t magic)
+{
+    njs_object_value_t  *ov;
+
+    if (njs_is_object_value(value)) {
+        ov = value->data.u.object_value;
+
+        if (njs_is_data(&ov->value) && ov->value.data.magic16 == magic) {
+            return ov->value.data.u.data;
+        }
+    }
+
+    return NULL;
+}
+
+
+njs_array_buffer_t *
+njs_array_buffer(const njs_value_t *value)
+{
+    return njs_array_buffer_data(value, NJS_ARRAY_BUFFER_MAGIC);
+}
+
+
+njs_typed_array_t *
+njs_typed_array(const njs_value_t *value)
+{
+    return njs_array_buffer_data(value, NJS_TYPED_ARRAY_MAGIC);
+}
+
+
+nxt_inline njs_typed_array_t *
+njs_data_view(const njs_value_t *value)
+{
+    return njs_array_buffer_data(value, NJS_DATA_VIEW_MAGIC);
+}
+
+
+/* A typed array or DataView. */
+
+njs_typed_array_t *
+njs_array_buffer_view(const njs_value_t *value)
+{
+    njs_typed_array_t  *view;
+
+    view = njs_typed_array(value);
+
+    if (view == NULL) {
+        view = njs_data_view(value);
+    }
+
+    return view;
+}
+
+
+nxt_inline uint32_t
+njs_typed_array_length(const njs_typed_array_t *array)
+{
+    return array->buffer->detached ? 0 : array->length;
+}
+
+
+nxt_inline u_char *
+njs_typed_array_element(const njs_typed_array_t *array, uint32_t index)
+{
+    return array->buffer->start + array->offset
+           + index * njs_typed_array_sizes[array->type];
+}
+
+
+/*
+ * The memory of external buffers may be unaligned, so the elements are
+ * copied with memcpy() which is compiled to a single load or store.
+ */
+
+static double
+njs_typed_array_get(const njs_typed_array_t *array, uint32_t index)
+{
+    float     f32;
+    double    f64;
+    u_char    *p;
+    int16_t   i16;
+    int32_t   i32;
+    uint16_t  u16;
+    uint32_t  u32;
+
+    p = njs_typed_array_element(array, index);
+
+    switch (array->type) {
+
+    case NJS_TYPED_ARRAY_INT8:
+        return (int8_t) *p;
+
+    case NJS_TYPED_ARRAY_UINT8:
+    case NJS_TYPED_ARRAY_UINT8_CLAMPED:
+        return *p;
+
+    case NJS_TYPED_ARRAY_INT16:
+        memcpy(&i16, p, sizeof(int16_t));
+        return i16;
+
+    case NJS_TYPED_ARRAY_UINT16:
+        memcpy(&u16, p, sizeof(uint16_t));
+        return u16;
+
+    case NJS_TYPED_ARRAY_INT32:
+        memcpy(&i32, p, sizeof(int32_t));
+        return i32;
+
+    case NJS_TYPED_ARRAY_UINT32:
+        memcpy(&u32, p, sizeof(uint32_t));
+        return u32;
+
+    case NJS_TYPED_ARRAY_FLOAT32:
+        memcpy(&f32, p, sizeof(float));
+        return f32;
+
+    default:
+        memcpy(&f64, p, sizeof(double));
+        return f64;
+    }
+}
+
+
+nxt_inline u_char
+njs_typed_array_clamp(double num)
+{
+    if (!(num > 0)) {
+        /* NaN and negative numbers. */
+        return 0;
+    }
+
+    if (num >= 255) {
+        return 255;
+    }
+
+    /* Rounds half to even in the default rounding mode. */
+
+    return (u_char) lrint(num);
+}
+
+
+static void
+njs_typed_array_set(njs_typed_array_t *array, uint32_t index, double num)
+{
+    float     f32;
+    u_char    *p;
+    uint16_t  u16;
+    uint32_t  u32;
+
+    p = njs_typed_array_element(array, index);
+
+    switch (array->type) {
+
+    case NJS_TYPED_ARRAY_INT8:
+    case NJS_TYPED_ARRAY_UINT8:
+        *p = (u_char) njs_number_to_int64(num);
+        return;
+
+    case NJS_TYPED_ARRAY_UINT8_CLAMPED:
+        *p = njs_typed_array_clamp(num);
+        return;
+
+    case NJS_TYPED_ARRAY_INT16:
+    case NJS_TYPED_ARRAY_UINT16:
+        u16 = (uint16_t) njs_number_to_int64(num);
+        memcpy(p, &u16, sizeof(uint16_t));
+        return;
+
+    case NJS_TYPED_ARRAY_INT32:
+    case NJS_TYPED_ARRAY_UINT32:
+        u32 = njs_number_to_uint32(num);
+        memcpy(p, &u32, sizeof(uint32_t));
+        return;
+
+    case NJS_TYPED_ARRAY_FLOAT32:
+        f32 = (float) num;
+        memcpy(p, &f32, sizeof(float));
+        return;
+
+    default:
+        memcpy(p, &num, sizeof(double));
+        return;
+    }
+}
+
+
+/*
+ * The values stored in typed arrays are converted to numbers without
+ * calling valueOf() of objects other than Boolean, Number and String.
+ */
+
+static double
+njs_typed_array_number(const njs_value_t *value)
+{
+    if (njs_is_primitive(value)) {
+        return njs_primitive_value_to_number(value);
+    }
+
+    switch (value->type) {
+    case NJS_OBJECT_BOOLEAN:
+    case NJS_OBJECT_NUMBER:
+    case NJS_OBJECT_STRING:
+        value = &value->data.u.object_value->value;
+        return njs_primitive_value_to_number(value);
+
+    default:
+        return NAN;
+    }
+}
+
+
+/*
+ * ES8, 7.1.17: ToIndex().  The values are numeric or undefined
+ * after the arguments normalization.
+ */
+
+static njs_ret_t
+njs_array_buffer_index(const njs_value_t *value, uint32_t *index)
+{
+    double  num;
+
+    num = njs_is_primitive(value) ? njs_primitive_value_to_number(value) : NAN;
+
+    if (isnan(num)) {
+        *index = 0;
+        return NXT_OK;
+    }
+
+    num = trunc(num);
+
+    if (num < 0 || num > NJS_ARRAY_BUFFER_MAX_SIZE) {
+        return NXT_DECLINED;
+    }
+
+    *index = (uint32_t) num;
+
+    return NXT_OK;
+}
+
+
+/*
+ * The relative begin and end arguments of slice(), subarray() and fill().
+ * The values are undefined or integers after the arguments normalization.
+ */
+
+static uint32_t
+njs_array_buffer_relative_index(const njs_value_t *value, uint32_t length,
+    uint32_t dflt)
+{
+    int64_t  index;
+
+    if (njs_is_undefined(value)) {
+        return dflt;
+    }
+
+    index = (int64_t) value->data.u.number;
+
+    if (index < 0) {
+        index += length;
+        return (index < 0) ? 0 : index;
+    }
+
+    return (index > length) ? length : index;
+}
+
+
+static njs_array_buffer_t *
+njs_array_buffer_alloc(njs_vm_t *vm, njs_value_t *value, u_char *start,
+    uint32_t size)
+{
+    njs_array_buffer_t  *buffer;
+    njs_object_value_t  *ov;
+
+    ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
+    if (nxt_slow_path(ov == NULL)) {
+        goto memory_error;
+    }
+
+    buffer = nxt_mp_alloc(vm->mem_pool, sizeof(njs_array_buffer_t));
+    if (nxt_slow_path(buffer == NULL)) {
+        goto memory_error;
+    }
+
+    buffer->external = (start != NULL);
+    buffer->detached = 0;
+    buffer->frozen = 0;
+    buffer->size = size;
+
+    if (start == NULL && size != 0) {
+        start = nxt_mp_zalloc(vm->mem_pool, size);
+        if (nxt_slow_path(start == NULL)) {
+            goto memory_error;
+        }
+    }
+
+    buffer->start = start;
+
+    nxt_flathsh_init(&ov->object.hash);
+    nxt_flathsh_init(&ov->object.shared_hash);
+    ov->object.__proto__ = &vm->prototypes[NJS_PROTOTYPE_ARRAY_BUFFER].object;
+    ov->object.type = NJS_OBJECT_VALUE;
+    ov->object.shared = 0;
+    ov->object.extensible = 1;
+    ov->object.frozen = 0;
+
+    njs_value_data_set(&ov->value, buffer);
+    ov->value.data.magic16 = NJS_ARRAY_BUFFER_MAGIC;
+
+    value->data.u.object_value = ov;
+    value->type = NJS_OBJECT_VALUE;
+    value->data.truth = 1;
+
+    return buffer;
+
+memory_error:
+
+    njs_memory_error(vm);
+
+    return NULL;
+}
+
+
+/*
+ * Creates a typed array or a DataView of the ArrayBuffer object,
+ * the DataView is a view of bytes with the NJS_TYPED_ARRAY_UINT8 type.
+ */
+
+static njs_typed_array_t *
+njs_array_buffer_view_alloc(njs_vm_t *vm, njs_value_t *value,
+    const njs_value_t *buffer, uint32_t offset, uint32_t length,
+    njs_typed_array_type_t type, uint16_t magic)
+{
+    nxt_uint_t          index;
+    njs_typed_array_t   *array;
+    njs_object_value_t  *ov;
+
+    ov = nxt_mp_alloc(vm->mem_pool, sizeof(njs_object_value_t));
+    if (nxt_slow_path(ov == NULL)) {
+        goto memory_error;
+    }
+
+    array = nxt_mp_alloc(vm->mem_pool, sizeof(njs_typed_array_t));
+    if (nxt_slow_path(array == NULL)) {
+        goto memory_error;
+    }
+
+    array->object = *buffer;
+    array->buffer = njs_array_buffer(buffer);
+    array->offset = offset;
+    array->length = length;
+    array->type = type;
+
+    njs_value_data_set(&ov->value, array);
+    ov->value.data.magic16 = magic;
+
+    index = (magic == NJS_DATA_VIEW_MAGIC) ? NJS_PROTOTYPE_DATA_VIEW
+                                           : NJS_PROTOTYPE_INT8_ARRAY + type;
+
+    nxt_flathsh_init(&ov->object.hash);
+    nxt_flathsh_init(&ov->object.shared_hash);
+    ov->object.__proto__ = &vm->prototypes[index].object;
+    ov->object.type = NJS_OBJECT_VALUE;
+    ov->object.shared = 0;
+    ov->object.extensible = 1;
+    ov->object.frozen = 0;
+
+    value->data.u.object_value = ov;
+    value->type = NJS_OBJECT_VALUE;
+    value->data.truth = 1;
+
+    return array;
+
+memory_error:
+
+    njs_memory_error(vm);
+
+    return NULL;
+}
+
+
+/* Creates a typed array with a new zero filled ArrayBuffer. */
+
+static njs_typed_array_t *
+njs_typed_array_alloc(njs_vm_t *vm, njs_value_t *value, uint32_t length,
+    njs_typed_array_type_t type)
+{
+    uint64_t     size;
+    njs_value_t  buffer;
+
+    size = (uint64_t) length * njs_typed_array_sizes[type];
+
+    if (nxt_slow_path(size > NJS_ARRAY_BUFFER_MAX_SIZE)) {
+        njs_range_error(vm, "Invalid typed array length");
+        return NULL;
+    }
+
+    if (nxt_slow_path(njs_array_buffer_alloc(vm, &buffer, NULL, size)
+                      == NULL))
+    {
+        return NULL;
+    }
+
+    return njs_array_buffer_view_alloc(vm, value, &buffer, 0, length, type,
+                                       NJS_TYPED_ARRAY_MAGIC);
+}
+
+
+/*
+ * The elements of typed arrays are queried before the property name
+ * is converted to a string.  The elements out of the range are absent,
+ * the assignments to them are ignored.
+ */
+
+njs_ret_t
+njs_typed_array_property_query(njs_vm_t *vm, njs_property_query_t *pq,
+    njs_typed_array_t *array, uint32_t index)
+{
+    njs_object_prop_t  *prop;
+
+    prop = &pq->scratch;
+
+    switch (pq->query) {
+
+    case NJS_PROPERTY_QUERY_GET:
+        if (index >= njs_typed_array_length(array)) {
+            return NXT_DECLINED;
+        }
+
+        njs_value_number_set(&prop->value,
+                             njs_typed_array_get(array, index));
+        prop->type = NJS_PROPERTY;
+        break;
+
+    case NJS_PROPERTY_QUERY_DELETE:
+        if (index >= njs_typed_array_length(array)) {
+            return NXT_DECLINED;
+        }
+
+        /* Fall through. */
+
+    default:
+        prop->value.data.u.prop_handler = njs_typed_array_element_set;
+        prop->type = NJS_PROPERTY_HANDLER;
+
+        pq->ext_index = index;
+        vm->stash = (uintptr_t) pq;
+
+        /* pq->lhq.key is used for TypeError. */
+        njs_uint32_to_string(&pq->value, index);
+        njs_string_get(&pq->value, &pq->lhq.key);
+    }
+
+    prop->writable = !array->buffer->frozen;
+    prop->enumerable = 1;
+    prop->configurable = 0;
+
+    pq->lhq.value = prop;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_element_set(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    uint32_t              index;
+    njs_typed_array_t     *array;
+    njs_property_query_t  *pq;
+
+    pq = (njs_property_query_t *) vm->stash;
+    index = pq->ext_index;
+
+    array = njs_typed_array(value);
+
+    if (index < njs_typed_array_length(array)) {
+        njs_typed_array_set(array, index, njs_typed_array_number(setval));
+    }
+
+    *retval = *setval;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+njs_array_buffer_bytes(const njs_value_t *value, nxt_str_t *bytes)
+{
+    njs_typed_array_t   *view;
+    njs_array_buffer_t  *buffer;
+
+    buffer = njs_array_buffer(value);
+
+    if (buffer != NULL) {
+        bytes->start = buffer->start;
+        bytes->length = buffer->detached ? 0 : buffer->size;
+
+        return NXT_OK;
+    }
+
+    view = njs_array_buffer_view(value);
+
+    if (view != NULL) {
+        bytes->start = njs_typed_array_element(view, 0);
+        bytes->length = njs_typed_array_length(view)
+                        * njs_typed_array_sizes[view->type];
+
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+nxt_int_t
+njs_typed_array_gc_mark(njs_gc_t *gc, const njs_value_t *value)
+{
+    njs_typed_array_t  *array;
+
+    switch (value->data.magic16) {
+
+    case NJS_TYPED_ARRAY_MAGIC:
+    case NJS_DATA_VIEW_MAGIC:
+        array = value->data.u.data;
+
+        return njs_gc_mark_value(gc, &array->object);
+
+    case NJS_ARRAY_BUFFER_MAGIC:
+        return NXT_OK;
+
+    default:
+        return NXT_DECLINED;
+    }
+}
+
+
+njs_ret_t
+njs_vm_array_buffer_set(njs_vm_t *vm, njs_value_t *value, u_char *start,
+    uint32_t size)
+{
+    njs_array_buffer_t  *buffer;
+
+    buffer = njs_array_buffer_alloc(vm, value, start, size);
+    if (nxt_slow_path(buffer == NULL)) {
+        return NXT_ERROR;
+    }
+
+    /* An empty external buffer has the non-NULL start as well. */
+
+    buffer->external = 1;
+
+    return NXT_OK;
+}
+
+
+void
+njs_vm_array_buffer_detach(njs_vm_t *vm, njs_value_t *value)
+{
+    njs_array_buffer_t  *buffer;
+
+    buffer = njs_array_buffer(value);
+
+    if (buffer != NULL && !buffer->frozen) {
+        if (!buffer->external && buffer->start != NULL) {
+            nxt_mp_free(vm->mem_pool, buffer->start);
+        }
+
+        buffer->start = NULL;
+        buffer->size = 0;
+        buffer->detached = 1;
+    }
+}
+
+
+njs_ret_t
+njs_vm_value_array_buffer(njs_vm_t *vm, nxt_str_t *dst,
+    const njs_value_t *value)
+{
+    return njs_array_buffer_bytes(value, dst);
+}
+
+
+njs_ret_t
+njs_array_buffer_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    uint32_t  size;
+
+    if (!vm->top_frame->ctor) {
+        njs_type_error(vm, "the ArrayBuffer constructor must be called "
+                       "with \"new\"");
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_index(njs_arg(args, nargs, 1), &size) != NXT_OK) {
+        njs_range_error(vm, "Invalid array buffer length");
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(njs_array_buffer_alloc(vm, &vm->retval, NULL, size)
+                      == NULL))
+    {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_array_buffer_is_view(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    const njs_value_t  *retval;
+
+    retval = &njs_value_false;
+
+    if (njs_array_buffer_view(njs_arg(args, nargs, 1)) != NULL) {
+        retval = &njs_value_true;
+    }
+
+    vm->retval = *retval;
+
+    return NXT_OK;
+}
+
+
+static const njs_object_prop_t  njs_array_buffer_constructor_properties[] =
+{
+    /* ArrayBuffer.name == "ArrayBuffer". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("ArrayBuffer"),
+        .configurable = 1,
+    },
+
+    /* ArrayBuffer.length == 1. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 1, 1.0),
+        .configurable = 1,
+    },
+
+    /* ArrayBuffer.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+
+    /* ArrayBuffer.isView(). */
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("isView"),
+        .value = njs_native_function(njs_array_buffer_is_view, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_array_buffer_constructor_init = {
+    nxt_string("ArrayBuffer"),
+    njs_array_buffer_constructor_properties,
+    nxt_nitems(njs_array_buffer_constructor_properties),
+};
+
+
+static njs_ret_t
+njs_array_buffer_prototype_byte_length(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    njs_array_buffer_t  *buffer;
+
+    buffer = njs_array_buffer(value);
+
+    if (buffer == NULL) {
+        /* ArrayBuffer.prototype. */
+        *retval = njs_value_undefined;
+        return NXT_OK;
+    }
+
+    njs_value_number_set(retval, buffer->size);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_array_buffer_prototype_slice(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    uint32_t            start, end;
+    njs_array_buffer_t  *buffer, *copy;
+
+    buffer = njs_array_buffer(&args[0]);
+
+    if (nxt_slow_path(buffer == NULL)) {
+        njs_type_error(vm, "\"this\" argument is not an ArrayBuffer");
+        return NXT_ERROR;
+    }
+
+    start = njs_array_buffer_relative_index(njs_arg(args, nargs, 1),
+                                            buffer->size, 0);
+    end = njs_array_buffer_relative_index(njs_arg(args, nargs, 2),
+                                          buffer->size, buffer->size);
+
+    end = nxt_max(start, end);
+
+    copy = njs_array_buffer_alloc(vm, &vm->retval, NULL, end - start);
+    if (nxt_slow_path(copy == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (end != start) {
+        memcpy(copy->start, &buffer->start[start], end - start);
+    }
+
+    return NXT_OK;
+}
+
+
+static const njs_object_prop_t  njs_array_buffer_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("byteLength"),
+        .value = njs_prop_handler(njs_array_buffer_prototype_byte_length),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("slice"),
+        .value = njs_native_function(njs_array_buffer_prototype_slice, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_array_buffer_prototype_init = {
+    nxt_string("ArrayBuffer"),
+    njs_array_buffer_prototype_properties,
+    nxt_nitems(njs_array_buffer_prototype_properties),
+};
+
+
+/*
+ * Copies the values of an array to a typed array.  The values which are
+ * not numeric are converted in the array as by String.bytesFrom(), the
+ * conversion restarts the calling function.  Holes are stored as NaN.
+ */
+
+static njs_ret_t
+njs_typed_array_copy_array(njs_vm_t *vm, njs_typed_array_t *array,
+    uint32_t offset, njs_array_t *source)
+{
+    uint32_t     i;
+    njs_value_t  *value;
+
+    for (i = 0; i < source->length; i++) {
+        value = &source->start[i];
+
+        if (njs_is_valid(value) && !njs_is_numeric(value)) {
+            njs_vm_trap_value(vm, value);
+
+            return njs_trap(vm, NJS_TRAP_NUMBER_ARG);
+        }
+    }
+
+    for (i = 0; i < source->length; i++) {
+        value = &source->start[i];
+
+        njs_typed_array_set(array, offset + i,
+                            njs_is_valid(value)
+                            ? njs_primitive_value_to_number(value) : NAN);
+    }
+
+    return NXT_OK;
+}
+
+
+/* The values of a typed array which may share the buffer with the source. */
+
+static njs_ret_t
+njs_typed_array_copy(njs_vm_t *vm, njs_typed_array_t *array, uint32_t offset,
+    const njs_typed_array_t *source)
+{
+    double    *values;
+    uint32_t  i, length;
+
+    length = njs_typed_array_length(source);
+
+    if (array->type == source->type) {
+        if (length != 0) {
+            memmove(njs_typed_array_element(array, offset),
+                    njs_typed_array_element(source, 0),
+                    length * njs_typed_array_sizes[array->type]);
+        }
+
+        return NXT_OK;
+    }
+
+    if (array->buffer != source->buffer) {
+        for (i = 0; i < length; i++) {
+            njs_typed_array_set(array, offset + i,
+                                njs_typed_array_get(source, i));
+        }
+
+        return NXT_OK;
+    }
+
+    values = nxt_mp_alloc(vm->mem_pool, length * sizeof(double) + 1);
+    if (nxt_slow_path(values == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < length; i++) {
+        values[i] = njs_typed_array_get(source, i);
+    }
+
+    for (i = 0; i < length; i++) {
+        njs_typed_array_set(array, offset + i, values[i]);
+    }
+
+    nxt_mp_free(vm->mem_pool, values);
+
+    return NXT_OK;
+}
+
+
+/*
+ * ES8, 22.2.4: The TypedArray constructors.
+ * Array-like objects and iterables are not supported.
+ */
+
+static njs_ret_t
+njs_typed_array_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_typed_array_type_t type)
+{
+    size_t              size;
+    uint32_t            offset, length;
+    njs_array_t         *source;
+    njs_typed_array_t   *array, *src;
+    const njs_value_t   *value;
+    njs_array_buffer_t  *buffer;
+
+    if (!vm->top_frame->ctor) {
+        njs_type_error(vm, "the %s constructor must be called with \"new\"",
+                       njs_typed_array_names[type]);
+        return NXT_ERROR;
+    }
+
+    size = njs_typed_array_sizes[type];
+    value = njs_arg(args, nargs, 1);
+
+    buffer = njs_array_buffer(value);
+
+    if (buffer != NULL) {
+        if (nxt_slow_path(buffer->detached)) {
+            njs_type_error(vm, "the ArrayBuffer is detached");
+            return NXT_ERROR;
+        }
+
+        if (njs_array_buffer_index(njs_arg(args, nargs, 2), &offset)
+            != NXT_OK
+            || offset % size != 0)
+        {
+            njs_range_error(vm, "start offset of %s should be a multiple "
+                            "of %uz", njs_typed_array_names[type], size);
+            return NXT_ERROR;
+        }
+
+        if (njs_is_undefined(njs_arg(args, nargs, 3))) {
+            if (buffer->size % size != 0 || offset > buffer->size) {
+                njs_range_error(vm, "byte length of %s should be a multiple "
+                                "of %uz", njs_typed_array_names[type], size);
+                return NXT_ERROR;
+            }
+
+            length = (buffer->size - offset) / size;
+
+        } else if (njs_array_buffer_index(njs_arg(args, nargs, 3), &length)
+                   != NXT_OK
+                   || offset + (uint64_t) length * size > buffer->size)
+        {
+            njs_range_error(vm, "Invalid typed array length");
+            return NXT_ERROR;
+        }
+
+        array = njs_array_buffer_view_alloc(vm, &vm->retval, value, offset,
+                                            length, type,
+                                            NJS_TYPED_ARRAY_MAGIC);
+
+        return (array != NULL) ? NXT_OK : NXT_ERROR;
+    }
+
+    src = njs_typed_array(value);
+
+    if (src != NULL) {
+        array = njs_typed_array_alloc(vm, &vm->retval,
+                                      njs_typed_array_length(src), type);
+        if (nxt_slow_path(array == NULL)) {
+            return NXT_ERROR;
+        }
+
+        return njs_typed_array_copy(vm, array, 0, src);
+    }
+
+    if (njs_is_array(value)) {
+        source = value->data.u.array;
+
+        array = njs_typed_array_alloc(vm, &vm->retval, source->length, type);
+        if (nxt_slow_path(array == NULL)) {
+            return NXT_ERROR;
+        }
+
+        return njs_typed_array_copy_array(vm, array, 0, source);
+    }
+
+    if (nxt_slow_path(!njs_is_primitive(value))) {
+        njs_type_error(vm, "%s argument must be a length, an array, "
+                       "an ArrayBuffer or a typed array",
+                       njs_typed_array_names[type]);
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_index(value, &length) != NXT_OK) {
+        njs_range_error(vm, "Invalid typed array length");
+        return NXT_ERROR;
+    }
+
+    array = njs_typed_array_alloc(vm, &vm->retval, length, type);
+
+    return (array != NULL) ? NXT_OK : NXT_ERROR;
+}
+
+
+njs_ret_t
+njs_int8_array_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs, NJS_TYPED_ARRAY_INT8);
+}
+
+
+njs_ret_t
+njs_uint8_array_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs, NJS_TYPED_ARRAY_UINT8);
+}
+
+
+njs_ret_t
+njs_uint8_clamped_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs,
+                                       NJS_TYPED_ARRAY_UINT8_CLAMPED);
+}
+
+
+njs_ret_t
+njs_int16_array_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs, NJS_TYPED_ARRAY_INT16);
+}
+
+
+njs_ret_t
+njs_uint16_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs,
+                                       NJS_TYPED_ARRAY_UINT16);
+}
+
+
+njs_ret_t
+njs_int32_array_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs, NJS_TYPED_ARRAY_INT32);
+}
+
+
+njs_ret_t
+njs_uint32_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs,
+                                       NJS_TYPED_ARRAY_UINT32);
+}
+
+
+njs_ret_t
+njs_float32_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs,
+                                       NJS_TYPED_ARRAY_FLOAT32);
+}
+
+
+njs_ret_t
+njs_float64_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_constructor(vm, args, nargs,
+                                       NJS_TYPED_ARRAY_FLOAT64);
+}
+
+
+#define njs_typed_array_constructor_properties(_name, _string, _value,       \
+    _size)                                                                    \
+                                                                              \
+static const njs_object_prop_t  njs_##_name##_constructor_properties[] =      \
+{                                                                             \
+    {                                                                         \
+        .type = NJS_PROPERTY,                                                 \
+        .name = njs_string("name"),                                           \
+        .value = _value,                                                      \
+        .configurable = 1,                                                    \
+    },                                                                        \
+                                                                              \
+    {                                                                         \
+        .type = NJS_PROPERTY,                                                 \
+        .name = njs_string("length"),                                         \
+        .value = njs_value(NJS_NUMBER, 1, 3.0),                               \
+        .configurable = 1,                                                    \
+    },                                                                        \
+                                                                              \
+    {                                                                         \
+        .type = NJS_PROPERTY_HANDLER,                                         \
+        .name = njs_string("prototype"),                                      \
+        .value = njs_prop_handler(njs_object_prototype_create),               \
+    },                                                                        \
+                                                                              \
+    {                                                                         \
+        .type = NJS_PROPERTY,                                                 \
+        .name = njs_long_string("BYTES_PER_ELEMENT"),                         \
+        .value = njs_value(NJS_NUMBER, 1, _size),                             \
+    },                                                                        \
+};                                                                            \
+                                                                              \
+                                                                              \
+const njs_object_init_t  njs_##_name##_constructor_init = {                   \
+    nxt_string(_string),                                                      \
+    njs_##_name##_constructor_properties,                                     \
+    nxt_nitems(njs_##_name##_constructor_properties),                         \
+}
+
+
+njs_typed_array_constructor_properties(int8_array, "Int8Array",
+    njs_string("Int8Array"), 1.0);
+njs_typed_array_constructor_properties(uint8_array, "Uint8Array",
+    njs_string("Uint8Array"), 1.0);
+njs_typed_array_constructor_properties(uint8_clamped_array,
+    "Uint8ClampedArray", njs_long_string("Uint8ClampedArray"), 1.0);
+njs_typed_array_constructor_properties(int16_array, "Int16Array",
+    njs_string("Int16Array"), 2.0);
+njs_typed_array_constructor_properties(uint16_array, "Uint16Array",
+    njs_string("Uint16Array"), 2.0);
+njs_typed_array_constructor_properties(int32_array, "Int32Array",
+    njs_string("Int32Array"), 4.0);
+njs_typed_array_constructor_properties(uint32_array, "Uint32Array",
+    njs_string("Uint32Array"), 4.0);
+njs_typed_array_constructor_properties(float32_array, "Float32Array",
+    njs_string("Float32Array"), 4.0);
+njs_typed_array_constructor_properties(float64_array, "Float64Array",
+    njs_string("Float64Array"), 8.0);
+
+
+/* The getters are shared by typed arrays and DataView. */
+
+static njs_ret_t
+njs_array_buffer_view_buffer(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    njs_typed_array_t  *view;
+
+    view = njs_array_buffer_view(value);
+
+    *retval = (view != NULL) ? view->object : njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_array_buffer_view_byte_length(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    njs_typed_array_t  *view;
+
+    view = njs_array_buffer_view(value);
+
+    if (view == NULL) {
+        *retval = njs_value_undefined;
+        return NXT_OK;
+    }
+
+    njs_value_number_set(retval, njs_typed_array_length(view)
+                                 * njs_typed_array_sizes[view->type]);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_array_buffer_view_byte_offset(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    njs_typed_array_t  *view;
+
+    view = njs_array_buffer_view(value);
+
+    if (view == NULL) {
+        *retval = njs_value_undefined;
+        return NXT_OK;
+    }
+
+    njs_value_number_set(retval, view->buffer->detached ? 0 : view->offset);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_length(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array(value);
+
+    if (array == NULL) {
+        *retval = njs_value_undefined;
+        return NXT_OK;
+    }
+
+    njs_value_number_set(retval, njs_typed_array_length(array));
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_bytes_per_element(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *setval, njs_value_t *retval)
+{
+    int32_t            index;
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array(value);
+
+    if (array != NULL) {
+        njs_value_number_set(retval, njs_typed_array_sizes[array->type]);
+        return NXT_OK;
+    }
+
+    /* The typed array prototypes. */
+
+    index = (njs_object_prototype_t *) value->data.u.object - vm->prototypes;
+    index -= NJS_PROTOTYPE_INT8_ARRAY;
+
+    if (njs_is_object(value)
+        && index >= 0
+        && index < (int32_t) nxt_nitems(njs_typed_array_sizes))
+    {
+        njs_value_number_set(retval, njs_typed_array_sizes[index]);
+        return NXT_OK;
+    }
+
+    *retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+nxt_inline njs_typed_array_t *
+njs_typed_array_this(njs_vm_t *vm, const njs_value_t *value)
+{
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array(value);
+
+    if (nxt_slow_path(array == NULL)) {
+        njs_type_error(vm, "\"this\" argument is not a typed array");
+    }
+
+    return array;
+}
+
+
+nxt_inline njs_ret_t
+njs_array_buffer_writable(njs_vm_t *vm, const njs_array_buffer_t *buffer)
+{
+    if (nxt_slow_path(buffer->frozen)) {
+        njs_type_error(vm, "the ArrayBuffer is frozen");
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_set(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    double             num;
+    uint32_t           length, offset;
+    njs_array_t        *source;
+    njs_typed_array_t  *array, *src;
+    const njs_value_t  *value;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_writable(vm, array->buffer) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    value = njs_arg(args, nargs, 2);
+    num = njs_is_undefined(value) ? 0 : value->data.u.number;
+
+    length = njs_typed_array_length(array);
+
+    /* The offset is converted to uint32_t only after the range check. */
+
+    if (num < 0 || num > length) {
+        njs_range_error(vm, "offset is out of bounds");
+        return NXT_ERROR;
+    }
+
+    offset = num;
+    value = njs_arg(args, nargs, 1);
+
+    src = njs_typed_array(value);
+
+    if (src != NULL) {
+        if ((uint64_t) offset + njs_typed_array_length(src) > length) {
+            njs_range_error(vm, "offset is out of bounds");
+            return NXT_ERROR;
+        }
+
+        vm->retval = njs_value_undefined;
+
+        return njs_typed_array_copy(vm, array, offset, src);
+    }
+
+    if (njs_is_array(value)) {
+        source = value->data.u.array;
+
+        if ((uint64_t) offset + source->length > length) {
+            njs_range_error(vm, "offset is out of bounds");
+            return NXT_ERROR;
+        }
+
+        vm->retval = njs_value_undefined;
+
+        return njs_typed_array_copy_array(vm, array, offset, source);
+    }
+
+    njs_type_error(vm, "the source must be an array or a typed array");
+
+    return NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_subarray(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    uint32_t           start, end, length;
+    njs_typed_array_t  *array, *subarray;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    length = njs_typed_array_length(array);
+
+    start = njs_array_buffer_relative_index(njs_arg(args, nargs, 1),
+                                            length, 0);
+    end = njs_array_buffer_relative_index(njs_arg(args, nargs, 2),
+                                          length, length);
+
+    end = nxt_max(start, end);
+
+    subarray = njs_array_buffer_view_alloc(vm, &vm->retval, &array->object,
+                            array->offset + start
+                            * njs_typed_array_sizes[array->type],
+                            end - start, array->type, NJS_TYPED_ARRAY_MAGIC);
+
+    return (subarray != NULL) ? NXT_OK : NXT_ERROR;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_slice(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    uint32_t           start, end, length;
+    njs_typed_array_t  *array, *copy;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    length = njs_typed_array_length(array);
+
+    start = njs_array_buffer_relative_index(njs_arg(args, nargs, 1),
+                                            length, 0);
+    end = njs_array_buffer_relative_index(njs_arg(args, nargs, 2),
+                                          length, length);
+
+    end = nxt_max(start, end);
+
+    copy = njs_typed_array_alloc(vm, &vm->retval, end - start, array->type);
+    if (nxt_slow_path(copy == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (end != start) {
+        memcpy(njs_typed_array_element(copy, 0),
+               njs_typed_array_element(array, start),
+               (end - start) * njs_typed_array_sizes[array->type]);
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_fill(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    double             num;
+    size_t             size;
+    u_char             *p, *first;
+    uint32_t           start, end, length;
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_writable(vm, array->buffer) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    length = njs_typed_array_length(array);
+
+    start = njs_array_buffer_relative_index(njs_arg(args, nargs, 2),
+                                            length, 0);
+    end = njs_array_buffer_relative_index(njs_arg(args, nargs, 3),
+                                          length, length);
+
+    if (start < end) {
+        num = njs_arg(args, nargs, 1)->data.u.number;
+        njs_typed_array_set(array, start, num);
+
+        /* The rest of the elements are copies of the first one. */
+
+        size = njs_typed_array_sizes[array->type];
+        first = njs_typed_array_element(array, start);
+        p = first + size;
+
+        while (++start < end) {
+            memcpy(p, first, size);
+            p += size;
+        }
+    }
+
+    vm->retval = args[0];
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_index_of(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    nxt_bool_t includes)
+{
+    double             num;
+    int64_t            index;
+    uint32_t           i, length;
+    njs_typed_array_t  *array;
+    const njs_value_t  *value;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    index = -1;
+    value = njs_arg(args, nargs, 1);
+    length = njs_typed_array_length(array);
+
+    if (!njs_is_number(value)) {
+        goto done;
+    }
+
+    num = value->data.u.number;
+
+    i = njs_array_buffer_relative_index(njs_arg(args, nargs, 2), length, 0);
+
+    if (includes && isnan(num)) {
+        for ( /* void */ ; i < length; i++) {
+            if (isnan(njs_typed_array_get(array, i))) {
+                index = i;
+                break;
+            }
+        }
+
+        goto done;
+    }
+
+    for ( /* void */ ; i < length; i++) {
+        if (njs_typed_array_get(array, i) == num) {
+            index = i;
+            break;
+        }
+    }
+
+done:
+
+    if (includes) {
+        vm->retval = (index != -1) ? njs_value_true : njs_value_false;
+
+    } else {
+        njs_value_number_set(&vm->retval, index);
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_index_of(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_index_of(vm, args, nargs, 0);
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_includes(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_typed_array_index_of(vm, args, nargs, 1);
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_last_index_of(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    double             num;
+    int64_t            i, index;
+    uint32_t           length;
+    njs_typed_array_t  *array;
+    const njs_value_t  *value;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    index = -1;
+    value = njs_arg(args, nargs, 1);
+    length = njs_typed_array_length(array);
+
+    if (njs_is_number(value) && length != 0) {
+        num = value->data.u.number;
+
+        value = njs_arg(args, nargs, 2);
+        i = length - 1;
+
+        if (!njs_is_undefined(value)) {
+            i = (int64_t) value->data.u.number;
+
+            if (i < 0) {
+                i += length;
+
+            } else if (i >= length) {
+                i = length - 1;
+            }
+        }
+
+        for ( /* void */ ; i >= 0; i--) {
+            if (njs_typed_array_get(array, i) == num) {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    njs_value_number_set(&vm->retval, index);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_reverse(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    size_t             size;
+    u_char             *p, *q, tmp[8];
+    uint32_t           length;
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_writable(vm, array->buffer) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    length = njs_typed_array_length(array);
+
+    if (length > 1) {
+        size = njs_typed_array_sizes[array->type];
+        p = njs_typed_array_element(array, 0);
+        q = njs_typed_array_element(array, length - 1);
+
+        while (p < q) {
+            memcpy(tmp, p, size);
+            memcpy(p, q, size);
+            memcpy(q, tmp, size);
+
+            p += size;
+            q -= size;
+        }
+    }
+
+    vm->retval = args[0];
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_typed_array_join(njs_vm_t *vm, njs_typed_array_t *array,
+    const njs_value_t *separator)
+{
+    u_char             *p;
+    size_t             size;
+    uint32_t           i, length;
+    njs_ret_t          ret;
+    njs_value_t        number, *values;
+    njs_string_prop_t  sep, string;
+
+    length = njs_typed_array_length(array);
+
+    if (length == 0) {
+        vm->retval = njs_string_empty;
+        return NXT_OK;
+    }
+
+    values = nxt_mp_alloc(vm->mem_pool, length * sizeof(njs_value_t));
+    if (nxt_slow_path(values == NULL)) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    (void) njs_string_prop(&sep, separator);
+
+    size = sep.size * (length - 1);
+
+    for (i = 0; i < length; i++) {
+        njs_value_number_set(&number, njs_typed_array_get(array, i));
+
+        ret = njs_number_to_string(vm, &values[i], &number);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto done;
+        }
+
+        size += njs_string_prop(&string, &values[i]);
+    }
+
+    /* The numbers are ASCII strings, so the length is the size. */
+
+    if (sep.length != 0 && sep.length != sep.size) {
+        p = njs_string_alloc(vm, &vm->retval, size,
+                             size - sep.size * (length - 1)
+                             + sep.length * (length - 1));
+
+    } else {
+        p = njs_string_alloc(vm, &vm->retval, size, size);
+    }
+
+    if (nxt_slow_path(p == NULL)) {
+        ret = NXT_ERROR;
+        goto done;
+    }
+
+    for (i = 0; i < length; i++) {
+        (void) njs_string_prop(&string, &values[i]);
+
+        p = nxt_cpymem(p, string.start, string.size);
+
+        if (i < length - 1) {
+            p = nxt_cpymem(p, sep.start, sep.size);
+        }
+    }
+
+    ret = NXT_OK;
+
+done:
+
+    nxt_mp_free(vm->mem_pool, values);
+
+    return ret;
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_join(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    return njs_typed_array_join(vm, array, (nargs > 1) ? &args[1]
+                                                       : &njs_string_comma);
+}
+
+
+static njs_ret_t
+njs_typed_array_prototype_to_string(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    njs_typed_array_t  *array;
+
+    array = njs_typed_array_this(vm, &args[0]);
+    if (nxt_slow_path(array == NULL)) {
+        return NXT_ERROR;
+    }
+
+    return njs_typed_array_join(vm, array, &njs_string_comma);
+}
+
+
+static const njs_object_prop_t  njs_typed_array_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("buffer"),
+        .value = njs_prop_handler(njs_array_buffer_view_buffer),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("byteLength"),
+        .value = njs_prop_handler(njs_array_buffer_view_byte_length),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("byteOffset"),
+        .value = njs_prop_handler(njs_array_buffer_view_byte_offset),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("length"),
+        .value = njs_prop_handler(njs_typed_array_prototype_length),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_long_string("BYTES_PER_ELEMENT"),
+        .value = njs_prop_handler(njs_typed_array_prototype_bytes_per_element),
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("set"),
+        .value = njs_native_function(njs_typed_array_prototype_set, 0,
+                     NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("subarray"),
+        .value = njs_native_function(njs_typed_array_prototype_subarray, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("slice"),
+        .value = njs_native_function(njs_typed_array_prototype_slice, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("fill"),
+        .value = njs_native_function(njs_typed_array_prototype_fill, 0,
+                     NJS_SKIP_ARG, NJS_NUMBER_ARG, NJS_INTEGER_ARG,
+                     NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("indexOf"),
+        .value = njs_native_function(njs_typed_array_prototype_index_of, 0,
+                     NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("lastIndexOf"),
+        .value = njs_native_function(njs_typed_array_prototype_last_index_of,
+                     0, NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("includes"),
+        .value = njs_native_function(njs_typed_array_prototype_includes, 0,
+                     NJS_SKIP_ARG, NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("reverse"),
+        .value = njs_native_function(njs_typed_array_prototype_reverse, 0, 0),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("join"),
+        .value = njs_native_function(njs_typed_array_prototype_join, 0,
+                     NJS_SKIP_ARG, NJS_STRING_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("toString"),
+        .value = njs_native_function(njs_typed_array_prototype_to_string, 0,
+                                     0),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_int8_array_prototype_init = {
+    nxt_string("Int8Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_uint8_array_prototype_init = {
+    nxt_string("Uint8Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_uint8_clamped_array_prototype_init = {
+    nxt_string("Uint8ClampedArray"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_int16_array_prototype_init = {
+    nxt_string("Int16Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_uint16_array_prototype_init = {
+    nxt_string("Uint16Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_int32_array_prototype_init = {
+    nxt_string("Int32Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_uint32_array_prototype_init = {
+    nxt_string("Uint32Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_float32_array_prototype_init = {
+    nxt_string("Float32Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+const njs_object_init_t  njs_float64_array_prototype_init = {
+    nxt_string("Float64Array"),
+    njs_typed_array_prototype_properties,
+    nxt_nitems(njs_typed_array_prototype_properties),
+};
+
+
+njs_ret_t
+njs_data_view_constructor(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    uint32_t            offset, length;
+    njs_typed_array_t   *view;
+    const njs_value_t   *value;
+    njs_array_buffer_t  *buffer;
+
+    if (!vm->top_frame->ctor) {
+        njs_type_error(vm, "the DataView constructor must be called "
+                       "with \"new\"");
+        return NXT_ERROR;
+    }
+
+    value = njs_arg(args, nargs, 1);
+    buffer = njs_array_buffer(value);
+
+    if (nxt_slow_path(buffer == NULL || buffer->detached)) {
+        njs_type_error(vm, "the DataView argument must be an ArrayBuffer");
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_index(njs_arg(args, nargs, 2), &offset) != NXT_OK
+        || offset > buffer->size)
+    {
+        njs_range_error(vm, "start offset is outside the bounds "
+                        "of the buffer");
+        return NXT_ERROR;
+    }
+
+    length = buffer->size - offset;
+
+    if (!njs_is_undefined(njs_arg(args, nargs, 3))) {
+        if (njs_array_buffer_index(njs_arg(args, nargs, 3), &length) != NXT_OK
+            || (uint64_t) offset + length > buffer->size)
+        {
+            njs_range_error(vm, "Invalid DataView length");
+            return NXT_ERROR;
+        }
+    }
+
+    view = njs_array_buffer_view_alloc(vm, &vm->retval, value, offset,
+                                       length, NJS_TYPED_ARRAY_UINT8,
+                                       NJS_DATA_VIEW_MAGIC);
+
+    return (view != NULL) ? NXT_OK : NXT_ERROR;
+}
+
+
+static const njs_object_prop_t  njs_data_view_constructor_properties[] =
+{
+    /* DataView.name == "DataView". */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("name"),
+        .value = njs_string("DataView"),
+        .configurable = 1,
+    },
+
+    /* DataView.length == 1. */
+    {
+        .type = NJS_PROPERTY,
+        .name = njs_string("length"),
+        .value = njs_value(NJS_NUMBER, 1, 1.0),
+        .configurable = 1,
+    },
+
+    /* DataView.prototype. */
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("prototype"),
+        .value = njs_prop_handler(njs_object_prototype_create),
+    },
+};
+
+
+const njs_object_init_t  njs_data_view_constructor_init = {
+    nxt_string("DataView"),
+    njs_data_view_constructor_properties,
+    nxt_nitems(njs_data_view_constructor_properties),
+};
+
+
+/*
+ * The DataView values are assembled byte by byte in the requested
+ * order, so the byte order of the host does not matter.
+ */
+
+static u_char *
+njs_data_view_bytes(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    size_t size)
+{
+    double             num;
+    njs_typed_array_t  *view;
+    const njs_value_t  *value;
+
+    view = njs_data_view(&args[0]);
+
+    if (nxt_slow_path(view == NULL)) {
+        njs_type_error(vm, "\"this\" argument is not a DataView");
+        return NULL;
+    }
+
+    if (nxt_slow_path(view->buffer->detached)) {
+        njs_type_error(vm, "the ArrayBuffer is detached");
+        return NULL;
+    }
+
+    value = njs_arg(args, nargs, 1);
+    num = njs_is_undefined(value) ? 0 : value->data.u.number;
+
+    if (num < 0 || num + size > njs_typed_array_length(view)) {
+        njs_range_error(vm, "offset is outside the bounds of the DataView");
+        return NULL;
+    }
+
+    return njs_typed_array_element(view, (uint32_t) num);
+}
+
+
+static njs_ret_t
+njs_data_view_get(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_typed_array_type_t type)
+{
+    float     f32;
+    double    num;
+    u_char    *p;
+    size_t    i, size;
+    uint32_t  u32;
+    uint64_t  u64;
+
+    size = njs_typed_array_sizes[type];
+
+    p = njs_data_view_bytes(vm, args, nargs, size);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    u64 = 0;
+
+    if (njs_is_true(njs_arg(args, nargs, 2))) {
+        for (i = size; i != 0; i--) {
+            u64 = (u64 << 8) | p[i - 1];
+        }
+
+    } else {
+        for (i = 0; i < size; i++) {
+            u64 = (u64 << 8) | p[i];
+        }
+    }
+
+    switch (type) {
+
+    case NJS_TYPED_ARRAY_INT8:
+        num = (int8_t) u64;
+        break;
+
+    case NJS_TYPED_ARRAY_INT16:
+        num = (int16_t) u64;
+        break;
+
+    case NJS_TYPED_ARRAY_INT32:
+        num = (int32_t) u64;
+        break;
+
+    case NJS_TYPED_ARRAY_FLOAT32:
+        u32 = (uint32_t) u64;
+        memcpy(&f32, &u32, sizeof(float));
+        num = f32;
+        break;
+
+    case NJS_TYPED_ARRAY_FLOAT64:
+        memcpy(&num, &u64, sizeof(double));
+        break;
+
+    default:
+        num = u64;
+        break;
+    }
+
+    njs_value_number_set(&vm->retval, num);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_data_view_set(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_typed_array_type_t type)
+{
+    float     f32;
+    double    num;
+    u_char    *p;
+    size_t    i, size;
+    uint32_t  u32;
+    uint64_t  u64;
+
+    size = njs_typed_array_sizes[type];
+
+    p = njs_data_view_bytes(vm, args, nargs, size);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (njs_array_buffer_writable(vm, njs_data_view(&args[0])->buffer)
+        != NXT_OK)
+    {
+        return NXT_ERROR;
+    }
+
+    num = njs_arg(args, nargs, 2)->data.u.number;
+
+    switch (type) {
+
+    case NJS_TYPED_ARRAY_FLOAT32:
+        f32 = (float) num;
+        memcpy(&u32, &f32, sizeof(float));
+        u64 = u32;
+        break;
+
+    case NJS_TYPED_ARRAY_FLOAT64:
+        memcpy(&u64, &num, sizeof(double));
+        break;
+
+    default:
+        u64 = (uint64_t) njs_number_to_int64(num);
+        break;
+    }
+
+    if (njs_is_true(njs_arg(args, nargs, 3))) {
+        for (i = 0; i < size; i++) {
+            p[i] = (u_char) u64;
+            u64 >>= 8;
+        }
+
+    } else {
+        for (i = size; i != 0; i--) {
+            p[i - 1] = (u_char) u64;
+            u64 >>= 8;
+        }
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_int8(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_INT8);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_uint8(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_UINT8);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_int16(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_INT16);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_uint16(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_UINT16);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_int32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_INT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_uint32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_UINT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_float32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_FLOAT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_get_float64(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_get(vm, args, nargs, NJS_TYPED_ARRAY_FLOAT64);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_int8(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_INT8);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_uint8(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_UINT8);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_int16(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_INT16);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_uint16(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_UINT16);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_int32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_INT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_uint32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_UINT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_float32(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_FLOAT32);
+}
+
+
+static njs_ret_t
+njs_data_view_prototype_set_float64(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused)
+{
+    return njs_data_view_set(vm, args, nargs, NJS_TYPED_ARRAY_FLOAT64);
+}
+
+
+static const njs_object_prop_t  njs_data_view_prototype_properties[] =
+{
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("constructor"),
+        .value = njs_prop_handler(njs_object_prototype_create_constructor),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("buffer"),
+        .value = njs_prop_handler(njs_array_buffer_view_buffer),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("byteLength"),
+        .value = njs_prop_handler(njs_array_buffer_view_byte_length),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_PROPERTY_HANDLER,
+        .name = njs_string("byteOffset"),
+        .value = njs_prop_handler(njs_array_buffer_view_byte_offset),
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getInt8"),
+        .value = njs_native_function(njs_data_view_prototype_get_int8, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getUint8"),
+        .value = njs_native_function(njs_data_view_prototype_get_uint8, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getInt16"),
+        .value = njs_native_function(njs_data_view_prototype_get_int16, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getUint16"),
+        .value = njs_native_function(njs_data_view_prototype_get_uint16, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getInt32"),
+        .value = njs_native_function(njs_data_view_prototype_get_int32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getUint32"),
+        .value = njs_native_function(njs_data_view_prototype_get_uint32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getFloat32"),
+        .value = njs_native_function(njs_data_view_prototype_get_float32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("getFloat64"),
+        .value = njs_native_function(njs_data_view_prototype_get_float64, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setInt8"),
+        .value = njs_native_function(njs_data_view_prototype_set_int8, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setUint8"),
+        .value = njs_native_function(njs_data_view_prototype_set_uint8, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setInt16"),
+        .value = njs_native_function(njs_data_view_prototype_set_int16, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setUint16"),
+        .value = njs_native_function(njs_data_view_prototype_set_uint16, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setInt32"),
+        .value = njs_native_function(njs_data_view_prototype_set_int32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setUint32"),
+        .value = njs_native_function(njs_data_view_prototype_set_uint32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setFloat32"),
+        .value = njs_native_function(njs_data_view_prototype_set_float32, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+
+    {
+        .type = NJS_METHOD,
+        .name = njs_string("setFloat64"),
+        .value = njs_native_function(njs_data_view_prototype_set_float64, 0,
+                     NJS_SKIP_ARG, NJS_INTEGER_ARG, NJS_NUMBER_ARG),
+        .writable = 1,
+        .configurable = 1,
+    },
+};
+
+
+const njs_object_init_t  njs_data_view_prototype_init = {
+    nxt_string("DataView"),
+    njs_data_view_prototype_properties,
+    nxt_nitems(njs_data_view_prototype_properties),
+};
@@ -0,0 +1,115 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NJS_TYPED_ARRAY_H_INCLUDED_
+#define _NJS_TYPED_ARRAY_H_INCLUDED_
+
+
+/*
+ * The order of the types is the order of the typed array
+ * prototypes and constructors starting from NJS_PROTOTYPE_INT8_ARRAY.
+ */
+typedef enum {
+    NJS_TYPED_ARRAY_INT8 = 0,
+    NJS_TYPED_ARRAY_UINT8,
+    NJS_TYPED_ARRAY_UINT8_CLAMPED,
+    NJS_TYPED_ARRAY_INT16,
+    NJS_TYPED_ARRAY_UINT16,
+    NJS_TYPED_ARRAY_INT32,
+    NJS_TYPED_ARRAY_UINT32,
+    NJS_TYPED_ARRAY_FLOAT32,
+    NJS_TYPED_ARRAY_FLOAT64,
+} njs_typed_array_type_t;
+
+
+typedef struct {
+    u_char                  *start;
+    uint32_t                size;
+
+    /* The memory is not allocated by VM and is not freed. */
+    uint8_t                 external;   /* 1 bit */
+
+    /* The memory is no longer accessible, the size is zero. */
+    uint8_t                 detached;   /* 1 bit */
+
+    /* The memory is shared by the clones of a frozen VM and is read-only. */
+    uint8_t                 frozen;     /* 1 bit */
+} njs_array_buffer_t;
+
+
+/* A typed array or DataView. */
+
+typedef struct {
+    /* The ArrayBuffer object. */
+    njs_value_t             object;
+
+    njs_array_buffer_t      *buffer;
+    uint32_t                offset;
+
+    /* The number of elements, the number of bytes for DataView. */
+    uint32_t                length;
+
+    njs_typed_array_type_t  type:8;
+} njs_typed_array_t;
+
+
+njs_array_buffer_t *njs_array_buffer(const njs_value_t *value);
+njs_typed_array_t *njs_typed_array(const njs_value_t *value);
+njs_typed_array_t *njs_array_buffer_view(const njs_value_t *value);
+nxt_int_t njs_array_buffer_bytes(const njs_value_t *value, nxt_str_t *bytes);
+
+njs_ret_t njs_typed_array_property_query(njs_vm_t *vm,
+    njs_property_query_t *pq, njs_typed_array_t *array, uint32_t index);
+nxt_int_t njs_typed_array_gc_mark(njs_gc_t *gc, const njs_value_t *value);
+
+njs_ret_t njs_array_buffer_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_data_view_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_int8_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_uint8_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_uint8_clamped_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_int16_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_uint16_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_int32_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_uint32_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_float32_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+njs_ret_t njs_float64_array_constructor(njs_vm_t *vm, njs_value_t *args,
+    nxt_uint_t nargs, njs_index_t unused);
+
+
+extern const njs_object_init_t  njs_array_buffer_constructor_init;
+extern const njs_object_init_t  njs_array_buffer_prototype_init;
+extern const njs_object_init_t  njs_data_view_constructor_init;
+extern const njs_object_init_t  njs_data_view_prototype_init;
+extern const njs_object_init_t  njs_int8_array_constructor_init;
+extern const njs_object_init_t  njs_int8_array_prototype_init;
+extern const njs_object_init_t  njs_uint8_array_constructor_init;
+extern const njs_object_init_t  njs_uint8_array_prototype_init;
+extern const njs_object_init_t  njs_uint8_clamped_array_constructor_init;
+extern const njs_object_init_t  njs_uint8_clamped_array_prototype_init;
+extern const njs_object_init_t  njs_int16_array_constructor_init;
+extern const njs_object_init_t  njs_int16_array_prototype_init;
+extern const njs_object_init_t  njs_uint16_array_constructor_init;
+extern const njs_object_init_t  njs_uint16_array_prototype_init;
+extern const njs_object_init_t  njs_int32_array_constructor_init;
+extern const njs_object_init_t  njs_int32_array_prototype_init;
+extern const njs_object_init_t  njs_uint32_array_constructor_init;
+extern const njs_object_init_t  njs_uint32_array_prototype_init;
+extern const njs_object_init_t  njs_float32_array_constructor_init;
+extern const njs_object_init_t  njs_float32_array_prototype_init;
+extern const njs_object_init_t  njs_float64_array_constructor_init;
+extern const njs_object_init_t  njs_float64_array_prototype_init;
+
+
+#endif /* _NJS_TYPED_ARRAY_H_INCLUDED_ */
@@ -12,6 +12,10 @@
 static njs_variable_t *njs_variable_scope_add(njs_vm_t *vm,
     njs_parser_scope_t *scope, nxt_lvlhsh_query_t *lhq,
     njs_variable_type_t type);
+static void njs_variables_references_resolve(njs_vm_t *vm,
+    njs_parser_scope_t *scope, nxt_bool_t closure);
+static void njs_variable_closure_capture(njs_parser_scope_t *scope,
+    nxt_uint_t nesting);
 static njs_ret_t njs_variable_reference_resolve(njs_vm_t *vm,
     njs_variable_reference_t *vr, njs_parser_scope_t *node_scope);
 static njs_variable_t *njs_variable_alloc(njs_vm_t *vm, nxt_str_t *name,
@@ -179,7 +183,7 @@ njs_label_add(njs_vm_t *vm, njs_parser_scope_t *scope, nxt_str_t *name,
     nxt_mp_free(vm->mem_pool, label->name.start);
     nxt_mp_free(vm->mem_pool, label);
 
-    njs_internal_error(vm, "lvlhsh insert failed");
+    njs_lvlhsh_insert_error(vm, ret);
 
     return NULL;
 }
@@ -274,16 +278,33 @@ njs_variable_reference(njs_vm_t *vm, njs_parser_scope_t *scope,
 }
 
 
+/*
+ * The closure level of a captured variable is marked in the referencing
+ * function and all functions it is nested in down to the function which
+ * declares the variable, because each of them passes the closure to the
+ * next one.  Functions which capture nothing do not copy closures at all.
+ */
+
+static void
+njs_variable_closure_capture(njs_parser_scope_t *scope, nxt_uint_t nesting)
+{
+    while (scope->nesting > nesting) {
+        if (scope->type == NJS_SCOPE_FUNCTION) {
+            scope->closures |= (1 << nesting);
+        }
+
+        scope = scope->parent;
+    }
+}
+
+
 static njs_ret_t
 njs_variables_scope_resolve(njs_vm_t *vm, njs_parser_scope_t *scope,
     nxt_bool_t closure)
 {
-    njs_ret_t                 ret;
-    nxt_queue_t               *nested;
-    nxt_queue_link_t          *lnk;
-    njs_parser_node_t         *node;
-    nxt_lvlhsh_each_t         lhe;
-    njs_variable_reference_t  *vr;
+    njs_ret_t         ret;
+    nxt_queue_t       *nested;
+    nxt_queue_link_t  *lnk;
 
     nested = &scope->nested;
 
@@ -298,40 +319,57 @@ njs_variables_scope_resolve(njs_vm_t *vm, njs_parser_scope_t *scope,
             return NXT_ERROR;
         }
 
-        nxt_lvlhsh_each_init(&lhe, &njs_variables_hash_proto);
+        njs_variables_references_resolve(vm, scope, closure);
+    }
 
-        for ( ;; ) {
-            node = nxt_lvlhsh_each(&scope->references, &lhe);
+    return NXT_OK;
+}
 
-            if (node == NULL) {
-                break;
-            }
 
-            vr = &node->u.reference;
+static void
+njs_variables_references_resolve(njs_vm_t *vm, njs_parser_scope_t *scope,
+    nxt_bool_t closure)
+{
+    njs_ret_t                 ret;
+    njs_parser_node_t         *node;
+    nxt_lvlhsh_each_t         lhe;
+    njs_variable_reference_t  *vr;
 
-            if (closure) {
-                ret = njs_variable_reference_resolve(vm, vr, node->scope);
-                if (nxt_slow_path(ret != NXT_OK)) {
-                    continue;
-                }
+    nxt_lvlhsh_each_init(&lhe, &njs_variables_hash_proto);
 
-                if (vr->scope_index == NJS_SCOPE_INDEX_LOCAL) {
-                    continue;
-                }
+    for ( ;; ) {
+        node = nxt_lvlhsh_each(&scope->references, &lhe);
+
+        if (node == NULL) {
+            break;
+        }
+
+        vr = &node->u.reference;
+
+        if (closure) {
+            ret = njs_variable_reference_resolve(vm, vr, node->scope);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                continue;
             }
 
-            (void) njs_variable_resolve(vm, node);
+            if (vr->scope_index == NJS_SCOPE_INDEX_LOCAL) {
+                continue;
+            }
+
+            njs_variable_closure_capture(node->scope, vr->scope->nesting);
         }
-    }
 
-    return NXT_OK;
+        (void) njs_variable_resolve(vm, node);
+    }
 }
 
 
 njs_ret_t
 njs_variables_scope_reference(njs_vm_t *vm, njs_parser_scope_t *scope)
 {
-    njs_ret_t  ret;
+    njs_ret_t          ret;
+    njs_parser_node_t  *node;
+    nxt_lvlhsh_each_t  lhe;
 
     /*
      * Calculating proper scope types for variables.
@@ -349,6 +387,53 @@ njs_variables_scope_reference(njs_vm_t *vm, njs_parser_scope_t *scope)
         return NXT_ERROR;
     }
 
+    /*
+     * The global scope references such as built-in objects are resolved
+     * as well, so all global values are allocated before the global scope
+     * size is calculated even if nested functions are generated later.
+     */
+
+    nxt_lvlhsh_each_init(&lhe, &njs_variables_hash_proto);
+
+    for ( ;; ) {
+        node = nxt_lvlhsh_each(&scope->references, &lhe);
+
+        if (node == NULL) {
+            break;
+        }
+
+        (void) njs_variable_resolve(vm, node);
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Resolves the references of a function body parsed on the first call.
+ * The outer variables referenced by the body have been captured at compile
+ * time by the references the pre-parser has added to the function scope.
+ */
+
+njs_ret_t
+njs_variables_lambda_reference(njs_vm_t *vm, njs_parser_scope_t *scope)
+{
+    njs_ret_t  ret;
+
+    ret = njs_variables_scope_resolve(vm, scope, 1);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    njs_variables_references_resolve(vm, scope, 1);
+
+    ret = njs_variables_scope_resolve(vm, scope, 0);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    njs_variables_references_resolve(vm, scope, 0);
+
     return NXT_OK;
 }
 
@@ -640,6 +725,7 @@ njs_name_copy(njs_vm_t *vm, nxt_str_t *dst, nxt_str_t *src)
 const njs_value_t *
 njs_vm_value(njs_vm_t *vm, const nxt_str_t *name)
 {
+    njs_value_t         *value;
     nxt_lvlhsh_query_t  lhq;
 
     lhq.key_hash = nxt_djb_hash(name->start, name->length);
@@ -647,7 +733,12 @@ njs_vm_value(njs_vm_t *vm, const nxt_str_t *name)
     lhq.proto = &njs_variables_hash_proto;
 
     if (nxt_lvlhsh_find(&vm->variables_hash, &lhq) == NXT_OK) {
-        return njs_vmcode_operand(vm, ((njs_variable_t *) lhq.value)->index);
+        value = njs_vmcode_operand(vm, ((njs_variable_t *) lhq.value)->index);
+
+        /* The value may be used after the variable is changed. */
+        njs_value_pin(value);
+
+        return value;
     }
 
     lhq.proto = &njs_extern_value_hash_proto;
@@ -6,6 +6,8 @@
 
 #include <njs_core.h>
 #include <njs_regexp.h>
+#include <njs_promise.h>
+#include <njs_async.h>
 #include <string.h>
 
 
@@ -29,11 +31,26 @@ static nxt_noinline njs_ret_t njs_values_compare(njs_vm_t *vm,
     const njs_value_t *val1, const njs_value_t *val2);
 static njs_ret_t njs_function_frame_create(njs_vm_t *vm, njs_value_t *value,
     const njs_value_t *this, uintptr_t nargs, nxt_bool_t ctor);
+static njs_ret_t njs_function_lambda_fast_frame(njs_vm_t *vm,
+    njs_function_t *function, const njs_value_t *this, nxt_uint_t nargs);
 static njs_object_t *njs_function_new_object(njs_vm_t *vm, njs_value_t *value);
+static void njs_vm_async_arguments(njs_vm_t *vm, nxt_uint_t nargs);
+static njs_ret_t njs_vm_frame_return(njs_vm_t *vm, njs_frame_t *frame,
+    njs_value_t *value, nxt_bool_t release);
 static void njs_vm_scopes_restore(njs_vm_t *vm, njs_frame_t *frame,
     njs_native_frame_t *previous);
+static njs_ret_t njs_vmcode_async_catch(njs_vm_t *vm, njs_value_t *invld1,
+    njs_value_t *invld2);
 static njs_ret_t njs_vmcode_continuation(njs_vm_t *vm, njs_value_t *invld1,
     njs_value_t *invld2);
+static nxt_noinline void njs_vm_operands_pin(njs_vm_t *vm,
+    njs_vmcode_generic_t *vmcode, njs_value_t *value1, njs_value_t *value2);
+static nxt_noinline void njs_vm_retval_count(njs_vm_t *vm,
+    njs_vmcode_generic_t *vmcode, njs_value_t *retval);
+static void njs_vm_value_count(njs_vm_t *vm, njs_index_t index,
+    njs_value_t *dst, njs_value_t *value);
+static void njs_vm_values_release(njs_vm_t *vm, njs_value_t *values,
+    size_t size);
 
 static void njs_vm_trap(njs_vm_t *vm, njs_trap_t trap, njs_value_t *value1,
     njs_value_t *value2);
@@ -60,6 +77,7 @@ static njs_ret_t njs_object_value_to_string(njs_vm_t *vm, njs_value_t *value);
 static njs_ret_t njs_vmcode_value_to_string(njs_vm_t *vm, njs_value_t *invld1,
     njs_value_t *invld2);
 
+static njs_ret_t njs_vm_execution_check(njs_vm_t *vm);
 static njs_ret_t njs_vm_add_backtrace_entry(njs_vm_t *vm, njs_frame_t *frame);
 
 void njs_debug(njs_index_t index, njs_value_t *value);
@@ -114,15 +132,50 @@ njs_vmcode_interpreter(njs_vm_t *vm)
     u_char                *catch;
     njs_ret_t             ret;
     njs_trap_t            trap;
+    nxt_uint_t            ops;
     njs_value_t           *retval, *value1, *value2;
     njs_frame_t           *frame;
     njs_native_frame_t    *previous;
     njs_vmcode_generic_t  *vmcode;
+#if (NXT_HAVE_JIT)
+    nxt_bool_t            jit;
+#endif
+
+    /* The instructions are counted locally and added to vm->ops. */
+    ops = 0;
+
+    if (vm->running++ == 0 && vm->timeout != 0) {
+        vm->deadline = nxt_time() + vm->timeout;
+        vm->ticks = NJS_VM_TIME_CHECKS;
+    }
 
 start:
 
+#if (NXT_HAVE_JIT)
+    jit = (vm->options.jit != 0);
+#endif
+
     for ( ;; ) {
 
+#if (NXT_HAVE_JIT)
+        /*
+         * The machine code of a function is entered on calls, returns
+         * and backward jumps.  It returns the instruction it has stopped
+         * at and the operation result to complete the instruction here.
+         */
+
+        if (nxt_slow_path(jit)) {
+            jit = 0;
+
+            ret = njs_jit_run(vm, &vmcode, &value1, &value2);
+
+            if (ret != NXT_DECLINED) {
+                jit = 1;
+                goto done;
+            }
+        }
+#endif
+
         vmcode = (njs_vmcode_generic_t *) vm->current;
 
         /*
@@ -156,8 +209,16 @@ start:
             value1 = njs_vmcode_operand(vm, vmcode->operand2);
         }
 
+        if (nxt_slow_path(vm->refcount)) {
+            njs_vm_operands_pin(vm, vmcode, value1, value2);
+        }
+
         ret = vmcode->code.operation(vm, value1, value2);
 
+#if (NXT_HAVE_JIT)
+    done:
+#endif
+
         /*
          * On success an operation returns size of the bytecode,
          * a jump offset or zero after the call or return operations.
@@ -174,9 +235,38 @@ start:
 
         if (vmcode->code.retval) {
             retval = njs_vmcode_operand(vm, vmcode->operand1);
-            njs_release(vm, retval);
+
+            if (nxt_slow_path(vm->refcount)) {
+                njs_vm_retval_count(vm, vmcode, retval);
+            }
+
             *retval = vm->retval;
         }
+
+        ops++;
+
+#if (NXT_HAVE_JIT)
+        if (nxt_slow_path(ret <= 0)) {
+            jit = (vm->options.jit != 0);
+        }
+#endif
+
+        /*
+         * Only backward jumps, calls and returns can make the execution
+         * unbounded, so the limits are checked there.
+         */
+
+        if (nxt_slow_path(ret <= 0)
+            && (vm->ops_limit != 0 || vm->timeout != 0))
+        {
+            vm->ops += ops;
+            ops = 0;
+
+            ret = njs_vm_execution_check(vm);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                break;
+            }
+        }
     }
 
     if (ret == NJS_TRAP) {
@@ -219,7 +309,15 @@ start:
             frame = (njs_frame_t *) vm->top_frame;
             catch = frame->native.exception.catch;
 
-            if (catch != NULL) {
+            /*
+             * An exception thrown by "valueOf" or "toString" method
+             * abandons the conversion of the frame operands.
+             */
+            frame->native.trap_tries = 0;
+
+            /* The termination by the execution limits is not catchable. */
+
+            if (catch != NULL && !vm->terminated) {
                 vm->current = catch;
 
                 if (vm->debug != NULL) {
@@ -232,45 +330,96 @@ start:
             if (vm->debug != NULL
                 && njs_vm_add_backtrace_entry(vm, frame) != NXT_OK)
             {
-                return NXT_ERROR;
+                break;
             }
 
             previous = frame->native.previous;
             if (previous == NULL) {
-                return NXT_ERROR;
+                break;
             }
 
             njs_vm_scopes_restore(vm, frame, previous);
 
             if (frame->native.size != 0) {
-                vm->stack_size -= frame->native.size;
-                nxt_mp_free(vm->mem_pool, frame);
+                njs_function_stack_free(vm, &frame->native);
+            }
+
+            if (previous->barrier) {
+                break;
             }
         }
     }
 
-    /* NXT_AGAIN, NJS_STOP. */
+    /* NXT_ERROR, NXT_AGAIN, NJS_STOP. */
+
+    vm->ops += ops;
+    vm->running--;
 
     return ret;
 }
 
 
+static njs_ret_t
+njs_vm_execution_check(njs_vm_t *vm)
+{
+    if (vm->ops_limit != 0 && vm->ops > vm->ops_limit) {
+        /*
+         * The terminated VM does not run code anymore, however the counter
+         * is reset to allow njs_vm_value_to_ext_string() for the exception.
+         */
+        vm->ops = 0;
+        vm->terminated = NJS_VM_INSTRUCTIONS_LIMIT;
+        return njs_vm_terminate(vm);
+    }
+
+    if (vm->timeout != 0 && --vm->ticks == 0) {
+        vm->ticks = NJS_VM_TIME_CHECKS;
+
+        if (nxt_time() > vm->deadline) {
+            vm->terminated = NJS_VM_TIME_LIMIT;
+            return njs_vm_terminate(vm);
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+njs_ret_t
+njs_vm_terminate(njs_vm_t *vm)
+{
+    if (vm->terminated == NJS_VM_INSTRUCTIONS_LIMIT) {
+        njs_internal_error(vm, "instructions limit exceeded");
+
+    } else {
+        njs_internal_error(vm, "execution time limit exceeded");
+    }
+
+    return NXT_ERROR;
+}
+
+
+/*
+ * The long strings produced by the addition in the VM clones are reference
+ * counted while they are only stored in the global, function and closure
+ * variables.  An instruction which may copy its operands elsewhere pins
+ * the strings it reads, the pinned strings are left to njs_gc() or to
+ * njs_vm_destroy().  The other strings are never counted.
+ */
+
 nxt_noinline void
 njs_value_retain(njs_value_t *value)
 {
     njs_string_t  *string;
 
-    if (njs_is_string(value)) {
-
-        if (value->long_string.external != 0xff) {
-            string = value->long_string.data;
+    if (njs_is_long_string(value)) {
+        string = value->long_string.data;
 
-            nxt_thread_log_debug("retain:%uxD \"%*s\"", string->retain,
-                                 value->long_string.size, string->start);
+        nxt_thread_log_debug("retain:%uxD \"%*s\"", string->retain,
+                             value->long_string.size, string->start);
 
-            if (string->retain != 0xffff) {
-                string->retain++;
-            }
+        if (string->retain & NJS_STRING_COUNTED) {
+            string->retain++;
         }
     }
 }
@@ -281,35 +430,147 @@ njs_value_release(njs_vm_t *vm, njs_value_t *value)
 {
     njs_string_t  *string;
 
-    if (njs_is_string(value)) {
+    if (njs_is_long_string(value)) {
+        string = value->long_string.data;
 
-        if (value->long_string.external != 0xff) {
-            string = value->long_string.data;
+        nxt_thread_log_debug("release:%uxD \"%*s\"", string->retain,
+                             value->long_string.size, string->start);
 
-            nxt_thread_log_debug("release:%uxD \"%*s\"", string->retain,
-                                 value->long_string.size, string->start);
+        if ((string->retain & NJS_STRING_COUNTED) == 0) {
+            return;
+        }
 
-            if (string->retain != 0xffff) {
-                string->retain--;
+        string->retain--;
 
-#if 0
-                if (string->retain == 0) {
-                    if ((u_char *) string + sizeof(njs_string_t)
-                        != string->start)
-                    {
-                        nxt_memcache_pool_free(vm->mem_pool,
-                                               string->start);
-                    }
+        if (string->retain != NJS_STRING_COUNTED) {
+            return;
+        }
 
-                    nxt_memcache_pool_free(vm->mem_pool, string);
-                }
-#endif
-            }
+        if (njs_is_long_string(&vm->retval)
+            && vm->retval.long_string.data == string)
+        {
+            vm->retval = njs_value_undefined;
+        }
+
+        if (vm->gc) {
+            njs_gc_free_string(vm, string);
+
+        } else {
+            nxt_mp_free(vm->mem_pool, string);
         }
     }
 }
 
 
+nxt_noinline void
+njs_value_pin(njs_value_t *value)
+{
+    if (njs_is_long_string(value)) {
+        value->long_string.data->retain = 0;
+    }
+}
+
+
+static nxt_noinline void
+njs_vm_operands_pin(njs_vm_t *vm, njs_vmcode_generic_t *vmcode,
+    njs_value_t *value1, njs_value_t *value2)
+{
+    njs_vmcode_operation_t  operation;
+
+    operation = vmcode->code.operation;
+
+    /* The operations which only read their operands. */
+
+    if (operation == njs_vmcode_move
+        || operation == njs_vmcode_addition
+        || operation == njs_vmcode_property_get
+        || operation == njs_vmcode_strict_equal
+        || operation == njs_vmcode_strict_not_equal
+        || operation == njs_vmcode_if_true_jump
+        || operation == njs_vmcode_if_false_jump
+        || operation == njs_vmcode_if_equal_jump)
+    {
+        return;
+    }
+
+    switch (vmcode->code.operands) {
+
+    case NJS_VMCODE_3OPERANDS:
+        njs_value_pin(value2);
+
+        /* Fall through. */
+
+    case NJS_VMCODE_2OPERANDS:
+        njs_value_pin(value1);
+    }
+}
+
+
+/*
+ * The result of the addition is a new string which is not referenced yet.
+ * The other operations except the move may store their result in place
+ * before it is counted, so the result is pinned.
+ */
+
+static nxt_noinline void
+njs_vm_retval_count(njs_vm_t *vm, njs_vmcode_generic_t *vmcode,
+    njs_value_t *retval)
+{
+    njs_vmcode_operation_t  operation;
+
+    operation = vmcode->code.operation;
+
+    if (operation == njs_vmcode_addition) {
+        if (njs_is_long_string(&vm->retval)) {
+            vm->retval.long_string.data->retain = NJS_STRING_COUNTED;
+        }
+
+    } else if (operation != njs_vmcode_move) {
+        njs_value_pin(&vm->retval);
+    }
+
+    njs_vm_value_count(vm, vmcode->operand1, retval, &vm->retval);
+}
+
+
+/*
+ * A value is counted if it is stored in a variable and is pinned otherwise.
+ */
+
+static void
+njs_vm_value_count(njs_vm_t *vm, njs_index_t index, njs_value_t *dst,
+    njs_value_t *value)
+{
+    uintptr_t  scope;
+
+    scope = njs_scope_type(index);
+
+    if (scope != NJS_SCOPE_GLOBAL && scope < NJS_SCOPE_LOCAL) {
+        njs_value_pin(value);
+        return;
+    }
+
+    /* The value may be stored in its own variable. */
+
+    njs_value_retain(value);
+    njs_value_release(vm, dst);
+}
+
+
+static void
+njs_vm_values_release(njs_vm_t *vm, njs_value_t *values, size_t size)
+{
+    njs_value_t  *end;
+
+    end = (njs_value_t *) ((u_char *) values + size);
+
+    while (values < end) {
+        njs_value_release(vm, values);
+        values++;
+    }
+}
+
+
 njs_ret_t
 njs_vmcode_object(njs_vm_t *vm, njs_value_t *invld1, njs_value_t *invld2)
 {
@@ -523,8 +784,6 @@ njs_vmcode_object_copy(njs_vm_t *vm, njs_value_t *value, njs_value_t *invld)
 
     vm->retval = *value;
 
-    njs_retain(value);
-
     return sizeof(njs_vmcode_object_copy_t);
 }
 
@@ -534,20 +793,37 @@ njs_vmcode_property_get(njs_vm_t *vm, njs_value_t *object,
     njs_value_t *property)
 {
     njs_ret_t              ret;
-    njs_value_t            *retval;
+    njs_value_t            *retval, prev;
     njs_vmcode_prop_get_t  *code;
 
     code = (njs_vmcode_prop_get_t *) vm->current;
     retval = njs_vmcode_operand(vm, code->value);
 
+    /*
+     * The property is stored in place, the previous value is released
+     * afterwards because the retval may be the object itself.
+     */
+    prev = *retval;
+
     ret = njs_value_property(vm, object, property, retval,
                              sizeof(njs_vmcode_prop_get_t));
     if (ret == NXT_OK || ret == NXT_DECLINED) {
         vm->retval = *retval;
+
+        if (vm->refcount) {
+            njs_value_release(vm, &prev);
+        }
+
         return sizeof(njs_vmcode_prop_get_t);
     }
 
-    return (ret == NJS_APPLIED) ? 0 : ret;
+    if (ret == NJS_APPLIED) {
+        /* The getter is called with the object as "this". */
+        njs_value_pin(object);
+        return 0;
+    }
+
+    return ret;
 }
 
 
@@ -567,6 +843,8 @@ njs_vmcode_property_init(njs_vm_t *vm, njs_value_t *object,
     code = (njs_vmcode_prop_set_t *) vm->current;
     init = njs_vmcode_operand(vm, code->value);
 
+    njs_value_pin(init);
+
     switch (object->type) {
     case NJS_ARRAY:
         index = njs_value_to_index(property);
@@ -618,7 +896,7 @@ njs_vmcode_property_init(njs_vm_t *vm, njs_value_t *object,
 
         obj = object->data.u.object;
 
-        ret = nxt_lvlhsh_find(&obj->__proto__->shared_hash, &lhq);
+        ret = nxt_flathsh_find(&obj->__proto__->shared_hash, &lhq);
         if (ret == NXT_OK) {
             prop = lhq.value;
 
@@ -641,9 +919,9 @@ njs_vmcode_property_init(njs_vm_t *vm, njs_value_t *object,
         lhq.value = prop;
         lhq.replace = 1;
 
-        ret = nxt_lvlhsh_insert(&obj->hash, &lhq);
+        ret = nxt_flathsh_insert(&obj->hash, &lhq);
         if (nxt_slow_path(ret != NXT_OK)) {
-            njs_internal_error(vm, "lvlhsh insert/replace failed");
+            njs_lvlhsh_insert_error(vm, ret);
             return NXT_ERROR;
         }
 
@@ -672,6 +950,8 @@ njs_vmcode_property_set(njs_vm_t *vm, njs_value_t *object,
     code = (njs_vmcode_prop_set_t *) vm->current;
     value = njs_vmcode_operand(vm, code->value);
 
+    njs_value_pin(value);
+
     ret = njs_value_property_set(vm, object, property, value,
                                  sizeof(njs_vmcode_prop_set_t));
     if (ret == NXT_OK) {
@@ -769,9 +1049,9 @@ njs_vmcode_property_delete(njs_vm_t *vm, njs_value_t *object,
             pq.lhq.value = whipeout;
             pq.lhq.pool = vm->mem_pool;
 
-            ret = nxt_lvlhsh_insert(&pq.prototype->hash, &pq.lhq);
+            ret = nxt_flathsh_insert(&pq.prototype->hash, &pq.lhq);
             if (nxt_slow_path(ret != NXT_OK)) {
-                njs_internal_error(vm, "lvlhsh insert failed");
+                njs_lvlhsh_insert_error(vm, ret);
                 return NXT_ERROR;
             }
 
@@ -837,13 +1117,16 @@ njs_vmcode_property_foreach(njs_vm_t *vm, njs_value_t *object,
     const njs_extern_t         *ext_proto;
     njs_vmcode_prop_foreach_t  *code;
 
+    /* The iteration state is not traced by njs_gc(). */
+    vm->retval.type = NJS_INVALID;
+
     if (njs_is_external(object)) {
         ext_proto = object->external.proto;
 
         if (ext_proto->foreach != NULL) {
             obj = njs_extern_object(vm, object);
 
-            ret = ext_proto->foreach(vm, obj, &vm->retval);
+            ret = ext_proto->foreach(vm, obj, &vm->retval.data.u);
             if (nxt_slow_path(ret != NXT_OK)) {
                 return ret;
             }
@@ -885,42 +1168,318 @@ njs_vmcode_property_next(njs_vm_t *vm, njs_value_t *object, njs_value_t *value)
     const njs_extern_t      *ext_proto;
     njs_vmcode_prop_next_t  *code;
 
-    code = (njs_vmcode_prop_next_t *) vm->current;
-    retval = njs_vmcode_operand(vm, code->retval);
+    code = (njs_vmcode_prop_next_t *) vm->current;
+    retval = njs_vmcode_operand(vm, code->retval);
+
+    if (njs_is_external(object)) {
+        ext_proto = object->external.proto;
+
+        if (ext_proto->next != NULL) {
+            obj = njs_extern_object(vm, object);
+
+            ret = ext_proto->next(vm, retval, obj, &value->data.u);
+
+            if (ret == NXT_OK) {
+                return code->offset;
+            }
+
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                return ret;
+            }
+
+            /* ret == NJS_DONE. */
+        }
+
+        return sizeof(njs_vmcode_prop_next_t);
+    }
+
+    next = value->data.u.next;
+
+    if (next->index < next->array->length) {
+        *retval = next->array->data[next->index++];
+
+        return code->offset;
+    }
+
+    nxt_mp_free(vm->mem_pool, next);
+
+    return sizeof(njs_vmcode_prop_next_t);
+}
+
+
+/*
+ * The "for-of" loop iterates arrays and strings directly without
+ * the iterator protocol, the iteration state is a number in "next":
+ * an array index or a byte offset in a string.
+ */
+
+njs_ret_t
+njs_vmcode_value_foreach(njs_vm_t *vm, njs_value_t *object,
+    njs_value_t *invld)
+{
+    njs_vmcode_prop_foreach_t  *code;
+
+    if (nxt_slow_path(!njs_is_array(object) && !njs_is_string(object))) {
+        njs_type_error(vm, "%s is not iterable",
+                       njs_type_string(object->type));
+        return NXT_ERROR;
+    }
+
+    njs_value_number_set(&vm->retval, 0);
+
+    code = (njs_vmcode_prop_foreach_t *) vm->current;
+
+    return code->offset;
+}
+
+
+njs_ret_t
+njs_vmcode_value_next(njs_vm_t *vm, njs_value_t *object, njs_value_t *value)
+{
+    size_t                  n, size;
+    njs_ret_t               ret;
+    njs_value_t             *retval;
+    njs_array_t             *array;
+    const u_char            *p, *end;
+    njs_string_prop_t       string;
+    njs_vmcode_prop_next_t  *code;
+
+    code = (njs_vmcode_prop_next_t *) vm->current;
+    retval = njs_vmcode_operand(vm, code->retval);
+
+    n = value->data.u.number;
+
+    if (njs_is_array(object)) {
+        array = object->data.u.array;
+
+        if (n < array->length) {
+            value->data.u.number = n + 1;
+
+            if (njs_is_valid(&array->start[n])) {
+                *retval = array->start[n];
+
+            } else {
+                *retval = njs_value_undefined;
+            }
+
+            return code->offset;
+        }
+
+        return sizeof(njs_vmcode_prop_next_t);
+    }
+
+    (void) njs_string_prop(&string, object);
+
+    if (n < string.size) {
+        p = string.start + n;
+        end = string.start + string.size;
+
+        if (string.length == 0 || string.length == string.size) {
+            /* Byte or ASCII string. */
+            size = 1;
+
+        } else {
+            size = nxt_utf8_next(p, end) - p;
+        }
+
+        ret = njs_string_new(vm, retval, p, size, (string.length != 0));
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        value->data.u.number = n + size;
+
+        return code->offset;
+    }
+
+    return sizeof(njs_vmcode_prop_next_t);
+}
+
+
+/*
+ * The spread elements of array literals and the rest elements of array
+ * patterns append the values of the array or the characters of the string
+ * starting from the "start" index to the destination array.
+ */
+
+njs_ret_t
+njs_vmcode_array_spread(njs_vm_t *vm, njs_value_t *value, njs_value_t *start)
+{
+    size_t              size;
+    uint32_t            i, n, length;
+    njs_ret_t           ret;
+    njs_value_t         *dst, *src, ch;
+    njs_array_t         *array, *source;
+    const u_char        *p, *end;
+    njs_string_prop_t   string;
+    njs_vmcode_3addr_t  *code;
+
+    code = (njs_vmcode_3addr_t *) vm->current;
+    array = njs_vmcode_operand(vm, code->dst)->data.u.array;
+
+    n = start->data.u.number;
+
+    if (njs_is_array(value)) {
+        source = value->data.u.array;
+
+        if (n >= source->length) {
+            return sizeof(njs_vmcode_3addr_t);
+        }
+
+        length = source->length - n;
+
+        ret = njs_array_expand(vm, array, 0, length);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        dst = &array->start[array->length];
+        src = &source->start[n];
+
+        for (i = 0; i < length; i++) {
+            if (njs_is_valid(&src[i])) {
+                /* GC: retain. */
+                dst[i] = src[i];
+
+            } else {
+                dst[i] = njs_value_undefined;
+            }
+        }
+
+        array->length += length;
+
+        return sizeof(njs_vmcode_3addr_t);
+    }
+
+    if (nxt_slow_path(!njs_is_string(value))) {
+        njs_type_error(vm, "%s is not iterable",
+                       njs_type_string(value->type));
+        return NXT_ERROR;
+    }
+
+    (void) njs_string_prop(&string, value);
+
+    p = string.start;
+    end = string.start + string.size;
+
+    while (p < end) {
+        if (string.length == 0 || string.length == string.size) {
+            /* Byte or ASCII string. */
+            size = 1;
+
+        } else {
+            size = nxt_utf8_next(p, end) - p;
+        }
+
+        if (n != 0) {
+            n--;
+
+        } else {
+            ret = njs_string_new(vm, &ch, p, size, (string.length != 0));
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            ret = njs_array_add(vm, array, &ch);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+        }
+
+        p += size;
+    }
+
+    return sizeof(njs_vmcode_3addr_t);
+}
+
+
+/*
+ * The spread elements of object literals and the rest elements of object
+ * patterns copy the own enumerable properties to the destination object.
+ * The rest element passes the array of the property names to exclude,
+ * it does not accept null and undefined values.
+ */
+
+njs_ret_t
+njs_vmcode_object_spread(njs_vm_t *vm, njs_value_t *value, njs_value_t *keys)
+{
+    uint32_t            i, k;
+    njs_ret_t           ret;
+    njs_array_t         *entries, *entry, *excluded;
+    njs_value_t         *name, *key, str;
+    njs_object_t        *object;
+    njs_object_prop_t   *prop;
+    nxt_lvlhsh_query_t  lhq;
+    njs_vmcode_3addr_t  *code;
+
+    excluded = njs_is_array(keys) ? keys->data.u.array : NULL;
+
+    if (njs_is_null_or_undefined(value)) {
+        if (excluded != NULL) {
+            njs_type_error(vm, "cannot destructure %s",
+                           njs_type_string(value->type));
+            return NXT_ERROR;
+        }
+
+        return sizeof(njs_vmcode_3addr_t);
+    }
+
+    code = (njs_vmcode_3addr_t *) vm->current;
+    object = njs_vmcode_operand(vm, code->dst)->data.u.object;
 
-    if (njs_is_external(object)) {
-        ext_proto = object->external.proto;
+    entries = njs_value_own_enumerate(vm, value, NJS_ENUM_BOTH, 0);
+    if (nxt_slow_path(entries == NULL)) {
+        return NXT_ERROR;
+    }
 
-        if (ext_proto->next != NULL) {
-            obj = njs_extern_object(vm, object);
+    lhq.replace = 1;
+    lhq.proto = &njs_object_hash_proto;
+    lhq.pool = vm->mem_pool;
 
-            ret = ext_proto->next(vm, retval, obj, value);
+    for (i = 0; i < entries->length; i++) {
+        entry = entries->start[i].data.u.array;
+        name = &entry->start[0];
 
-            if (ret == NXT_OK) {
-                return code->offset;
-            }
+        if (excluded != NULL) {
+            for (k = 0; k < excluded->length; k++) {
+                key = &excluded->start[k];
 
-            if (nxt_slow_path(ret == NXT_ERROR)) {
-                return ret;
+                if (!njs_is_string(key)) {
+                    ret = njs_primitive_value_to_string(vm, &str, key);
+                    if (nxt_slow_path(ret != NXT_OK)) {
+                        return ret;
+                    }
+
+                    key = &str;
+                }
+
+                if (njs_string_eq(name, key)) {
+                    break;
+                }
             }
 
-            /* ret == NJS_DONE. */
+            if (k != excluded->length) {
+                continue;
+            }
         }
 
-        return sizeof(njs_vmcode_prop_next_t);
-    }
-
-    next = value->data.u.next;
+        prop = njs_object_prop_alloc(vm, name, &entry->start[1], 1);
+        if (nxt_slow_path(prop == NULL)) {
+            return NXT_ERROR;
+        }
 
-    if (next->index < next->array->length) {
-        *retval = next->array->data[next->index++];
+        njs_string_get(name, &lhq.key);
+        lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+        lhq.value = prop;
 
-        return code->offset;
+        ret = nxt_flathsh_insert(&object->hash, &lhq);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            njs_lvlhsh_insert_error(vm, ret);
+            return NXT_ERROR;
+        }
     }
 
-    nxt_mp_free(vm->mem_pool, next);
-
-    return sizeof(njs_vmcode_prop_next_t);
+    return sizeof(njs_vmcode_3addr_t);
 }
 
 
@@ -1331,11 +1890,27 @@ njs_vmcode_division(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 njs_ret_t
 njs_vmcode_remainder(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 {
-    double  num;
+    double  num, num1, num2;
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num = fmod(val1->data.u.number, val2->data.u.number);
+        num1 = val1->data.u.number;
+        num2 = val2->data.u.number;
+
+        /*
+         * A positive int32 dividend and divisor do not need fmod().
+         * The zero dividend is left to fmod() to keep the sign of -0.
+         */
+
+        if (num1 > 0 && num2 > 0
+            && njs_number_is_int32(num1) && njs_number_is_int32(num2))
+        {
+            num = (int32_t) num1 % (int32_t) num2;
+
+        } else {
+            num = fmod(num1, num2);
+        }
+
         njs_value_number_set(&vm->retval, num);
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1353,8 +1928,8 @@ njs_vmcode_left_shift(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_int32(val1->data.u.number);
-        num2 = njs_number_to_uint32(val2->data.u.number);
+        num1 = njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 << (num2 & 0x1f));
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1372,8 +1947,8 @@ njs_vmcode_right_shift(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_int32(val1->data.u.number);
-        num2 = njs_number_to_uint32(val2->data.u.number);
+        num1 = njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 >> (num2 & 0x1f));
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1391,8 +1966,8 @@ njs_vmcode_unsigned_right_shift(njs_vm_t *vm, njs_value_t *val1,
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_uint32(val1->data.u.number);
-        num2 = njs_number_to_uint32(val2->data.u.number);
+        num1 = (uint32_t) njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 >> (num2 & 0x1f));
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1458,7 +2033,7 @@ njs_vmcode_bitwise_not(njs_vm_t *vm, njs_value_t *value, njs_value_t *invld)
     int32_t  num;
 
     if (nxt_fast_path(njs_is_numeric(value))) {
-        num = njs_number_to_integer(value->data.u.number);
+        num = njs_number_to_int32_fast(value->data.u.number);
         njs_value_number_set(&vm->retval, ~num);
 
         return sizeof(njs_vmcode_2addr_t);
@@ -1475,8 +2050,8 @@ njs_vmcode_bitwise_and(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_integer(val1->data.u.number);
-        num2 = njs_number_to_integer(val2->data.u.number);
+        num1 = njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 & num2);
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1493,8 +2068,8 @@ njs_vmcode_bitwise_xor(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_integer(val1->data.u.number);
-        num2 = njs_number_to_integer(val2->data.u.number);
+        num1 = njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 ^ num2);
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1511,8 +2086,8 @@ njs_vmcode_bitwise_or(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
 
     if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
 
-        num1 = njs_number_to_uint32(val1->data.u.number);
-        num2 = njs_number_to_uint32(val2->data.u.number);
+        num1 = njs_number_to_int32_fast(val1->data.u.number);
+        num2 = njs_number_to_int32_fast(val2->data.u.number);
         njs_value_number_set(&vm->retval, num1 | num2);
 
         return sizeof(njs_vmcode_3addr_t);
@@ -1622,6 +2197,16 @@ njs_vmcode_less(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
     njs_ret_t          ret;
     const njs_value_t  *retval;
 
+    /* NaN is not comparable and both comparisons are false for it. */
+
+    if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
+        retval = (val1->data.u.number < val2->data.u.number)
+                 ? &njs_value_true : &njs_value_false;
+        vm->retval = *retval;
+
+        return sizeof(njs_vmcode_3addr_t);
+    }
+
     ret = njs_values_compare(vm, val1, val2);
 
     if (nxt_fast_path(ret >= -1)) {
@@ -1656,6 +2241,14 @@ njs_vmcode_greater_or_equal(njs_vm_t *vm, njs_value_t *val1, njs_value_t *val2)
     njs_ret_t          ret;
     const njs_value_t  *retval;
 
+    if (nxt_fast_path(njs_is_numeric(val1) && njs_is_numeric(val2))) {
+        retval = (val1->data.u.number >= val2->data.u.number)
+                 ? &njs_value_true : &njs_value_false;
+        vm->retval = *retval;
+
+        return sizeof(njs_vmcode_3addr_t);
+    }
+
     ret = njs_values_compare(vm, val1, val2);
 
     if (nxt_fast_path(ret >= -1)) {
@@ -1830,8 +2423,6 @@ njs_vmcode_move(njs_vm_t *vm, njs_value_t *value, njs_value_t *invld)
 {
     vm->retval = *value;
 
-    njs_retain(value);
-
     return sizeof(njs_vmcode_move_t);
 }
 
@@ -1893,6 +2484,10 @@ njs_vmcode_function_frame(njs_vm_t *vm, njs_value_t *value, njs_value_t *nargs)
                                     (uintptr_t) nargs, function->code.ctor);
 
     if (nxt_fast_path(ret == NXT_OK)) {
+        if (nxt_slow_path(vm->active_frame->native.async)) {
+            njs_vm_async_arguments(vm, (uintptr_t) nargs);
+        }
+
         return sizeof(njs_vmcode_function_frame_t);
     }
 
@@ -1900,10 +2495,31 @@ njs_vmcode_function_frame(njs_vm_t *vm, njs_value_t *value, njs_value_t *nargs)
 }
 
 
+/*
+ * The callee arguments are set one by one after the frame is created.
+ * "await" in the arguments saves the frame with the rest of them unset,
+ * so they are initialized for the garbage collector beforehand.
+ */
+
+static void
+njs_vm_async_arguments(njs_vm_t *vm, nxt_uint_t nargs)
+{
+    njs_value_t  *value;
+
+    value = vm->scopes[NJS_SCOPE_CALLEE_ARGUMENTS];
+
+    while (nargs != 0) {
+        *value++ = njs_value_undefined;
+        nargs--;
+    }
+}
+
+
 static njs_ret_t
 njs_function_frame_create(njs_vm_t *vm, njs_value_t *value,
     const njs_value_t *this, uintptr_t nargs, nxt_bool_t ctor)
 {
+    njs_ret_t       ret;
     njs_value_t     val;
     njs_object_t    *object;
     njs_function_t  *function;
@@ -1912,7 +2528,13 @@ njs_function_frame_create(njs_vm_t *vm, njs_value_t *value,
 
         function = value->data.u.function;
 
-        if (ctor) {
+        if (!ctor) {
+            ret = njs_function_lambda_fast_frame(vm, function, this, nargs);
+            if (nxt_fast_path(ret == NXT_OK)) {
+                return ret;
+            }
+
+        } else {
             if (!function->ctor) {
                 njs_type_error(vm, "%s is not a constructor",
                                njs_type_string(value->type));
@@ -1941,6 +2563,61 @@ njs_function_frame_create(njs_vm_t *vm, njs_value_t *value,
 }
 
 
+/*
+ * A fast path of njs_function_lambda_frame() for the calls of unbound
+ * lambda functions with the declared number of arguments if the frame
+ * fits in the current stack chunk.  The frame size is precalculated and
+ * the arguments are not initialized since they are all set by the caller.
+ */
+static njs_ret_t
+njs_function_lambda_fast_frame(njs_vm_t *vm, njs_function_t *function,
+    const njs_value_t *this, nxt_uint_t nargs)
+{
+    size_t                 size;
+    njs_value_t            *value;
+    njs_frame_t            *frame;
+    njs_native_frame_t     *top;
+    njs_function_lambda_t  *lambda;
+
+    if (function->native || function->bound != NULL) {
+        return NXT_DECLINED;
+    }
+
+    lambda = function->u.lambda;
+    top = vm->top_frame;
+    size = lambda->frame_size;
+
+    if (nargs != lambda->nargs || size > top->free_size) {
+        return NXT_DECLINED;
+    }
+
+    frame = (njs_frame_t *) top->free;
+
+    nxt_memzero(&frame->native, sizeof(njs_native_frame_t));
+
+    frame->native.free_size = top->free_size - size;
+    frame->native.free = (u_char *) frame + size;
+    frame->native.previous = top;
+    frame->native.function = function;
+    frame->native.nargs = nargs;
+
+    value = (njs_value_t *) ((u_char *) frame
+                             + njs_frame_size(lambda->nesting + 1));
+    frame->native.arguments = value;
+
+    *value++ = *this;
+
+    vm->scopes[NJS_SCOPE_CALLEE_ARGUMENTS] = value;
+
+    frame->local = value + nargs;
+    frame->previous_active_frame = vm->active_frame;
+
+    vm->top_frame = &frame->native;
+
+    return NXT_OK;
+}
+
+
 static njs_object_t *
 njs_function_new_object(njs_vm_t *vm, njs_value_t *value)
 {
@@ -1960,7 +2637,7 @@ njs_function_new_object(njs_vm_t *vm, njs_value_t *value)
         lhq.proto = &njs_object_hash_proto;
         function = value->data.u.function;
 
-        ret = nxt_lvlhsh_find(&function->object.hash, &lhq);
+        ret = nxt_flathsh_find(&function->object.hash, &lhq);
 
         if (ret == NXT_OK) {
             prop = lhq.value;
@@ -1980,6 +2657,87 @@ njs_function_new_object(njs_vm_t *vm, njs_value_t *value)
 }
 
 
+/*
+ * The frame of a call with the trailing spread argument is sized after
+ * the array has been evaluated.  The static arguments are stored in the
+ * frame by the following code, the array values are copied here.
+ */
+
+njs_ret_t
+njs_vmcode_spread_frame(njs_vm_t *vm, njs_value_t *value, njs_value_t *array)
+{
+    size_t                     size;
+    uint32_t                   i, length;
+    njs_ret_t                  ret;
+    njs_value_t                *args, *start;
+    const u_char               *p, *end;
+    njs_string_prop_t          string;
+    njs_vmcode_spread_frame_t  *spread;
+
+    if (njs_is_array(array)) {
+        length = array->data.u.array->length;
+
+    } else if (njs_is_string(array)) {
+        length = njs_string_prop(&string, array);
+
+    } else {
+        njs_type_error(vm, "%s is not iterable", njs_type_string(array->type));
+        return NXT_ERROR;
+    }
+
+    spread = (njs_vmcode_spread_frame_t *) vm->current;
+
+    ret = njs_function_frame_create(vm, value,
+                                    njs_vmcode_operand(vm, spread->object),
+                                    spread->nargs + length,
+                                    spread->code.ctor);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    args = vm->scopes[NJS_SCOPE_CALLEE_ARGUMENTS] + spread->nargs;
+
+    if (njs_is_array(array)) {
+        start = array->data.u.array->start;
+
+        for (i = 0; i < length; i++) {
+            if (njs_is_valid(&start[i])) {
+                args[i] = start[i];
+
+            } else {
+                args[i] = njs_value_undefined;
+            }
+        }
+
+        return sizeof(njs_vmcode_spread_frame_t);
+    }
+
+    /* The characters of the string. */
+
+    p = string.start;
+    end = string.start + string.size;
+
+    for (i = 0; i < length; i++) {
+        if (string.length == 0 || string.length == string.size) {
+            /* Byte or ASCII string. */
+            size = 1;
+
+        } else {
+            size = nxt_utf8_next(p, end) - p;
+        }
+
+        ret = njs_string_new(vm, &args[i], p, size, (string.length != 0));
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        p += size;
+    }
+
+    return sizeof(njs_vmcode_spread_frame_t);
+}
+
+
 njs_ret_t
 njs_vmcode_method_frame(njs_vm_t *vm, njs_value_t *object, njs_value_t *name)
 {
@@ -2051,6 +2809,10 @@ njs_vmcode_method_frame(njs_vm_t *vm, njs_value_t *object, njs_value_t *name)
                                     method->code.ctor);
 
     if (nxt_fast_path(ret == NXT_OK)) {
+        if (nxt_slow_path(vm->active_frame->native.async)) {
+            njs_vm_async_arguments(vm, method->nargs);
+        }
+
         return sizeof(njs_vmcode_method_frame_t);
     }
 
@@ -2175,6 +2937,9 @@ njs_type_string(njs_value_type_t type)
     case NJS_OBJECT_URI_ERROR:
         return "uri error";
 
+    case NJS_OBJECT_VALUE:
+        return "object value";
+
     default:
         return NULL;
     }
@@ -2221,9 +2986,9 @@ njs_arg_type_string(uint8_t arg)
 njs_ret_t
 njs_vmcode_return(njs_vm_t *vm, njs_value_t *invld, njs_value_t *retval)
 {
-    njs_value_t         *value;
-    njs_frame_t         *frame;
-    njs_native_frame_t  *previous;
+    njs_ret_t    ret;
+    njs_value_t  *value;
+    njs_frame_t  *frame;
 
     value = njs_vmcode_operand(vm, retval);
 
@@ -2238,6 +3003,33 @@ njs_vmcode_return(njs_vm_t *vm, njs_value_t *invld, njs_value_t *retval)
         }
     }
 
+    if (nxt_slow_path(frame->native.async)) {
+        njs_value_pin(value);
+
+        ret = njs_promise_settle_value(vm, &frame->async->promise, value, 0);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        value = &frame->async->promise;
+    }
+
+    return njs_vm_frame_return(vm, frame, value, 1);
+}
+
+
+/*
+ * The locals of an async function suspended by "await"
+ * are not released, they are kept in the saved frame.
+ */
+
+static njs_ret_t
+njs_vm_frame_return(njs_vm_t *vm, njs_frame_t *frame, njs_value_t *value,
+    nxt_bool_t release)
+{
+    njs_value_t         *retval;
+    njs_native_frame_t  *previous;
+
     previous = njs_function_previous_frame(&frame->native);
 
     njs_vm_scopes_restore(vm, frame, previous);
@@ -2248,8 +3040,19 @@ njs_vmcode_return(njs_vm_t *vm, njs_value_t *invld, njs_value_t *retval)
      */
     retval = njs_vmcode_operand(vm, frame->retval);
 
-    /* GC: value external/internal++ depending on value and retval type */
-    *retval = *value;
+    if (vm->refcount) {
+        njs_vm_value_count(vm, frame->retval, retval, value);
+
+        *retval = *value;
+
+        if (release) {
+            njs_vm_values_release(vm, frame->local,
+                                  frame->native.function->u.lambda->local_size);
+        }
+
+    } else {
+        *retval = *value;
+    }
 
     vm->current = frame->return_address;
 
@@ -2263,6 +3066,7 @@ static void
 njs_vm_scopes_restore(njs_vm_t *vm, njs_frame_t *frame,
     njs_native_frame_t *previous)
 {
+    uint8_t         mask;
     nxt_uint_t      n, nesting;
     njs_value_t     *args;
     njs_function_t  *function;
@@ -2298,10 +3102,19 @@ njs_vm_scopes_restore(njs_vm_t *vm, njs_frame_t *frame,
 
     function = frame->native.function;
 
-    nesting = (function != NULL) ? function->u.lambda->nesting : 0;
+    if (function != NULL) {
+        nesting = function->u.lambda->nesting;
+        mask = function->u.lambda->closures | (1 << nesting);
+
+    } else {
+        nesting = 0;
+        mask = 1;
+    }
 
     for (n = 0; n <= nesting; n++) {
-        vm->scopes[NJS_SCOPE_CLOSURE + n] = &frame->closures[n]->u.values;
+        vm->scopes[NJS_SCOPE_CLOSURE + n] = (mask & (1 << n))
+                                            ? &frame->closures[n]->u.values
+                                            : NULL;
     }
 
     while (n < NJS_MAX_NESTING) {
@@ -2348,6 +3161,8 @@ njs_vmcode_stop(njs_vm_t *vm, njs_value_t *invld, njs_value_t *retval)
 
     value = njs_vmcode_operand(vm, retval);
 
+    njs_value_pin(value);
+
     vm->retval = *value;
 
     return NJS_STOP;
@@ -2437,8 +3252,6 @@ njs_vmcode_try_return(njs_vm_t *vm, njs_value_t *value, njs_value_t *invld)
 
     vm->retval = *value;
 
-    njs_retain(value);
-
     try_return = (njs_vmcode_try_return_t *) vm->current;
 
     return try_return->offset;
@@ -2476,12 +3289,103 @@ njs_vmcode_throw(njs_vm_t *vm, njs_value_t *invld, njs_value_t *retval)
 
     value = njs_vmcode_operand(vm, retval);
 
+    njs_value_pin(value);
+
     vm->retval = *value;
 
     return NXT_ERROR;
 }
 
 
+/*
+ * njs_vmcode_await() suspends an async function and leaves it returning
+ * the function promise.  The function is resumed by a promise job at the
+ * same instruction which then stores the settled value or throws it.
+ */
+
+njs_ret_t
+njs_vmcode_await(njs_vm_t *vm, njs_value_t *value, njs_value_t *retval)
+{
+    njs_ret_t    ret;
+    njs_frame_t  *frame;
+    njs_async_t  *async;
+    njs_value_t  *dst;
+
+    frame = vm->active_frame;
+    async = frame->async;
+
+    switch (async->state) {
+
+    case NJS_ASYNC_FULFILLED:
+        async->state = NJS_ASYNC_RUNNING;
+
+        dst = njs_vmcode_operand(vm, retval);
+
+        if (vm->refcount) {
+            njs_vm_value_count(vm, (njs_index_t) retval, dst, &async->value);
+        }
+
+        *dst = async->value;
+        async->value = njs_value_undefined;
+
+        return sizeof(njs_vmcode_await_t);
+
+    case NJS_ASYNC_REJECTED:
+        async->state = NJS_ASYNC_RUNNING;
+
+        vm->retval = async->value;
+        async->value = njs_value_undefined;
+
+        return NXT_ERROR;
+
+    default:
+        break;
+    }
+
+    njs_value_pin(value);
+
+    ret = njs_async_suspend(vm, frame, value);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_vm_frame_return(vm, frame, &async->promise, 0);
+}
+
+
+/*
+ * The exception handler of an async function frame rejects
+ * the function promise with the uncaught exception.
+ */
+
+const njs_vmcode_generic_t  njs_async_catch_nexus[] = {
+    { .code = { .operation = njs_vmcode_async_catch,
+                .operands =  NJS_VMCODE_NO_OPERAND,
+                .retval = NJS_VMCODE_NO_RETVAL } },
+};
+
+
+static njs_ret_t
+njs_vmcode_async_catch(njs_vm_t *vm, njs_value_t *invld1, njs_value_t *invld2)
+{
+    njs_ret_t    ret;
+    njs_value_t  value;
+    njs_frame_t  *frame;
+
+    frame = (njs_frame_t *) vm->top_frame;
+    frame->native.exception.catch = NULL;
+
+    value = vm->retval;
+
+    ret = njs_promise_settle_value(vm, &frame->async->promise, &value, 1);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    return njs_vm_frame_return(vm, frame, &frame->async->promise, 1);
+}
+
+
 /*
  * njs_vmcode_catch() is set on the start of a "catch" block to store
  * exception and to remove a "try" block if there is no "finally" block
@@ -2693,6 +3597,9 @@ njs_vm_trap(njs_vm_t *vm, njs_trap_t trap, njs_value_t *value1,
      * original operand values for the second method call if the first
      * method call will return non-primitive value.
      */
+    njs_value_pin(value1);
+    njs_value_pin(value2);
+
     njs_set_invalid(&frame->trap_scratch);
     frame->trap_values[1] = *value2;
     frame->trap_reference = njs_vm_traps[trap].reference;
@@ -2945,7 +3852,11 @@ njs_vmcode_restart(njs_vm_t *vm, njs_value_t *invld1, njs_value_t *invld2)
 
     if (vmcode->code.retval) {
         retval = njs_vmcode_operand(vm, vmcode->operand1);
-        njs_release(vm, retval);
+
+        if (vm->refcount) {
+            njs_vm_retval_count(vm, vmcode, retval);
+        }
+
         *retval = vm->retval;
     }
 
@@ -2984,7 +3895,6 @@ njs_primitive_value(njs_vm_t *vm, njs_value_t *value, nxt_uint_t hint)
         if (!njs_is_primitive(retval)) {
 
             for ( ;; ) {
-                ret = NXT_ERROR;
 
                 if (njs_is_object(value) && vm->top_frame->trap_tries < 2) {
                     hint ^= vm->top_frame->trap_tries++;
@@ -3028,15 +3938,18 @@ njs_primitive_value(njs_vm_t *vm, njs_value_t *value, nxt_uint_t hint)
                              */
                             ret = 0;
                         }
+
+                        /*
+                         * An exception of the method call, including
+                         * the termination of the VM, is passed as is.
+                         */
+                        return ret;
                     }
                 }
 
-                if (ret == NXT_ERROR) {
-                    njs_type_error(vm,
-                                   "Cannot convert object to primitive value");
-                }
+                njs_type_error(vm, "Cannot convert object to primitive value");
 
-                return ret;
+                return NXT_ERROR;
             }
         }
 
@@ -3371,6 +4284,7 @@ njs_value_data_set(njs_value_t *value, void *data)
     value->data.u.data = data;
     value->type = NJS_DATA;
     value->data.truth = 1;
+    value->data.magic16 = 0;
 }
 
 
@@ -3493,6 +4407,13 @@ njs_value_is_object(const njs_value_t *value)
 }
 
 
+nxt_noinline nxt_int_t
+njs_value_is_array(const njs_value_t *value)
+{
+    return njs_is_array(value);
+}
+
+
 nxt_noinline nxt_int_t
 njs_value_is_function(const njs_value_t *value)
 {
@@ -3678,6 +4599,13 @@ njs_lvlhsh_alloc(void *data, size_t size, nxt_uint_t nalloc)
 }
 
 
+void *
+njs_flathsh_alloc(void *data, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_align(data, sizeof(void *), size);
+}
+
+
 void
 njs_lvlhsh_free(void *data, void *p, size_t size)
 {
@@ -173,6 +173,8 @@ typedef struct njs_native_frame_s     njs_native_frame_t;
 typedef struct njs_property_next_s    njs_property_next_t;
 typedef struct njs_parser_scope_s     njs_parser_scope_t;
 typedef struct njs_parser_node_s      njs_parser_node_t;
+typedef struct njs_jit_code_s         njs_jit_code_t;
+typedef struct njs_async_s            njs_async_t;
 
 
 union njs_value_s {
@@ -201,8 +203,8 @@ union njs_value_s {
          */
         uint8_t                       truth;
 
-        uint16_t                      _spare1;
-        uint32_t                      _spare2;
+        uint16_t                      magic16;
+        uint32_t                      magic32;
 
         union {
             double                    number;
@@ -260,10 +262,10 @@ union njs_value_s {
 
 struct njs_object_s {
     /* A private hash of njs_object_prop_t. */
-    nxt_lvlhsh_t                      hash;
+    nxt_flathsh_t                     hash;
 
     /* A shared hash of njs_object_prop_t. */
-    nxt_lvlhsh_t                      shared_hash;
+    nxt_flathsh_t                     shared_hash;
 
     /* An object __proto__. */
     njs_object_t                      *__proto__;
@@ -272,6 +274,9 @@ struct njs_object_s {
     njs_value_type_t                  type:8;
     uint8_t                           shared;     /* 1 bit */
     uint8_t                           extensible; /* 1 bit */
+
+    /* Arrays are not modified in place, see njs_object_deep_freeze(). */
+    uint8_t                           frozen;     /* 1 bit */
 };
 
 
@@ -471,6 +476,9 @@ typedef njs_ret_t (*njs_vmcode_operation_t)(njs_vm_t *vm, njs_value_t *value1,
 #define njs_is_string(value)                                                  \
     ((value)->type == NJS_STRING)
 
+#define njs_is_long_string(value)                                             \
+    (njs_is_string(value) && (value)->short_string.size == NJS_STRING_LONG)
+
 #define njs_is_error(value)                                                   \
     ((value)->type >= NJS_OBJECT_ERROR                                        \
      && (value)->type <= NJS_OBJECT_URI_ERROR)
@@ -568,6 +576,12 @@ typedef njs_ret_t (*njs_vmcode_operation_t)(njs_vm_t *vm, njs_value_t *value1,
     (value)->type = NJS_INVALID
 
 
+/*
+ * The values are copied without njs_retain() throughout the VM, so
+ * the string retain counters are maintained by the interpreter only,
+ * see njs_value_retain().  The other strings are reclaimed by njs_gc().
+ */
+
 #if 0 /* GC: todo */
 
 #define njs_retain(value)                                                     \
@@ -785,6 +799,15 @@ typedef struct {
 } njs_vmcode_method_frame_t;
 
 
+typedef struct {
+    njs_vmcode_t               code;
+    njs_index_t                nargs;
+    njs_index_t                function;
+    njs_index_t                array;
+    njs_index_t                object;
+} njs_vmcode_spread_frame_t;
+
+
 typedef struct {
     njs_vmcode_t               code;
     njs_index_t                retval;
@@ -831,6 +854,13 @@ typedef struct {
 } njs_vmcode_throw_t;
 
 
+typedef struct {
+    njs_vmcode_t               code;
+    njs_index_t                retval;
+    njs_index_t                value;
+} njs_vmcode_await_t;
+
+
 typedef struct {
     njs_vmcode_t               code;
     njs_ret_t                  offset;
@@ -919,6 +949,22 @@ enum njs_prototypes_e {
     NJS_PROTOTYPE_DATE,
     NJS_PROTOTYPE_CRYPTO_HASH,
     NJS_PROTOTYPE_CRYPTO_HMAC,
+    NJS_PROTOTYPE_PROMISE,
+    NJS_PROTOTYPE_ARRAY_BUFFER,
+    NJS_PROTOTYPE_DATA_VIEW,
+    NJS_PROTOTYPE_INT8_ARRAY,
+    NJS_PROTOTYPE_UINT8_ARRAY,
+    NJS_PROTOTYPE_UINT8_CLAMPED_ARRAY,
+    NJS_PROTOTYPE_INT16_ARRAY,
+    NJS_PROTOTYPE_UINT16_ARRAY,
+    NJS_PROTOTYPE_INT32_ARRAY,
+    NJS_PROTOTYPE_UINT32_ARRAY,
+    NJS_PROTOTYPE_FLOAT32_ARRAY,
+    NJS_PROTOTYPE_FLOAT64_ARRAY,
+    NJS_PROTOTYPE_MAP,
+    NJS_PROTOTYPE_SET,
+    NJS_PROTOTYPE_WEAK_MAP,
+    NJS_PROTOTYPE_WEAK_SET,
     NJS_PROTOTYPE_ERROR,
     NJS_PROTOTYPE_EVAL_ERROR,
     NJS_PROTOTYPE_INTERNAL_ERROR,
@@ -954,6 +1000,22 @@ enum njs_constructor_e {
     NJS_CONSTRUCTOR_DATE =           NJS_PROTOTYPE_DATE,
     NJS_CONSTRUCTOR_CRYPTO_HASH =    NJS_PROTOTYPE_CRYPTO_HASH,
     NJS_CONSTRUCTOR_CRYPTO_HMAC =    NJS_PROTOTYPE_CRYPTO_HMAC,
+    NJS_CONSTRUCTOR_PROMISE =        NJS_PROTOTYPE_PROMISE,
+    NJS_CONSTRUCTOR_ARRAY_BUFFER =   NJS_PROTOTYPE_ARRAY_BUFFER,
+    NJS_CONSTRUCTOR_DATA_VIEW =      NJS_PROTOTYPE_DATA_VIEW,
+    NJS_CONSTRUCTOR_INT8_ARRAY =     NJS_PROTOTYPE_INT8_ARRAY,
+    NJS_CONSTRUCTOR_UINT8_ARRAY =    NJS_PROTOTYPE_UINT8_ARRAY,
+    NJS_CONSTRUCTOR_UINT8_CLAMPED_ARRAY = NJS_PROTOTYPE_UINT8_CLAMPED_ARRAY,
+    NJS_CONSTRUCTOR_INT16_ARRAY =    NJS_PROTOTYPE_INT16_ARRAY,
+    NJS_CONSTRUCTOR_UINT16_ARRAY =   NJS_PROTOTYPE_UINT16_ARRAY,
+    NJS_CONSTRUCTOR_INT32_ARRAY =    NJS_PROTOTYPE_INT32_ARRAY,
+    NJS_CONSTRUCTOR_UINT32_ARRAY =   NJS_PROTOTYPE_UINT32_ARRAY,
+    NJS_CONSTRUCTOR_FLOAT32_ARRAY =  NJS_PROTOTYPE_FLOAT32_ARRAY,
+    NJS_CONSTRUCTOR_FLOAT64_ARRAY =  NJS_PROTOTYPE_FLOAT64_ARRAY,
+    NJS_CONSTRUCTOR_MAP =            NJS_PROTOTYPE_MAP,
+    NJS_CONSTRUCTOR_SET =            NJS_PROTOTYPE_SET,
+    NJS_CONSTRUCTOR_WEAK_MAP =       NJS_PROTOTYPE_WEAK_MAP,
+    NJS_CONSTRUCTOR_WEAK_SET =       NJS_PROTOTYPE_WEAK_SET,
     NJS_CONSTRUCTOR_ERROR =          NJS_PROTOTYPE_ERROR,
     NJS_CONSTRUCTOR_EVAL_ERROR =     NJS_PROTOTYPE_EVAL_ERROR,
     NJS_CONSTRUCTOR_INTERNAL_ERROR = NJS_PROTOTYPE_INTERNAL_ERROR,
@@ -992,7 +1054,9 @@ enum njs_function_e {
     NJS_FUNCTION_SET_TIMEOUT,
     NJS_FUNCTION_SET_IMMEDIATE,
     NJS_FUNCTION_CLEAR_TIMEOUT,
-#define NJS_FUNCTION_MAX       (NJS_FUNCTION_CLEAR_TIMEOUT + 1)
+    NJS_FUNCTION_SET_INTERVAL,
+    NJS_FUNCTION_CLEAR_INTERVAL,
+#define NJS_FUNCTION_MAX       (NJS_FUNCTION_CLEAR_INTERVAL + 1)
 };
 
 
@@ -1012,6 +1076,35 @@ enum njs_function_e {
     njs_global_scope_index(NJS_CONSTRUCTOR_FUNCTION)
 #define NJS_INDEX_REGEXP         njs_global_scope_index(NJS_CONSTRUCTOR_REGEXP)
 #define NJS_INDEX_DATE           njs_global_scope_index(NJS_CONSTRUCTOR_DATE)
+#define NJS_INDEX_PROMISE        njs_global_scope_index(NJS_CONSTRUCTOR_PROMISE)
+#define NJS_INDEX_ARRAY_BUFFER                                                \
+    njs_global_scope_index(NJS_CONSTRUCTOR_ARRAY_BUFFER)
+#define NJS_INDEX_DATA_VIEW                                                   \
+    njs_global_scope_index(NJS_CONSTRUCTOR_DATA_VIEW)
+#define NJS_INDEX_INT8_ARRAY                                                  \
+    njs_global_scope_index(NJS_CONSTRUCTOR_INT8_ARRAY)
+#define NJS_INDEX_UINT8_ARRAY                                                 \
+    njs_global_scope_index(NJS_CONSTRUCTOR_UINT8_ARRAY)
+#define NJS_INDEX_UINT8_CLAMPED_ARRAY                                         \
+    njs_global_scope_index(NJS_CONSTRUCTOR_UINT8_CLAMPED_ARRAY)
+#define NJS_INDEX_INT16_ARRAY                                                 \
+    njs_global_scope_index(NJS_CONSTRUCTOR_INT16_ARRAY)
+#define NJS_INDEX_UINT16_ARRAY                                                \
+    njs_global_scope_index(NJS_CONSTRUCTOR_UINT16_ARRAY)
+#define NJS_INDEX_INT32_ARRAY                                                 \
+    njs_global_scope_index(NJS_CONSTRUCTOR_INT32_ARRAY)
+#define NJS_INDEX_UINT32_ARRAY                                                \
+    njs_global_scope_index(NJS_CONSTRUCTOR_UINT32_ARRAY)
+#define NJS_INDEX_FLOAT32_ARRAY                                               \
+    njs_global_scope_index(NJS_CONSTRUCTOR_FLOAT32_ARRAY)
+#define NJS_INDEX_FLOAT64_ARRAY                                               \
+    njs_global_scope_index(NJS_CONSTRUCTOR_FLOAT64_ARRAY)
+#define NJS_INDEX_MAP            njs_global_scope_index(NJS_CONSTRUCTOR_MAP)
+#define NJS_INDEX_SET            njs_global_scope_index(NJS_CONSTRUCTOR_SET)
+#define NJS_INDEX_WEAK_MAP                                                    \
+    njs_global_scope_index(NJS_CONSTRUCTOR_WEAK_MAP)
+#define NJS_INDEX_WEAK_SET                                                    \
+    njs_global_scope_index(NJS_CONSTRUCTOR_WEAK_SET)
 #define NJS_INDEX_OBJECT_ERROR   njs_global_scope_index(NJS_CONSTRUCTOR_ERROR)
 #define NJS_INDEX_OBJECT_EVAL_ERROR                                           \
     njs_global_scope_index(NJS_CONSTRUCTOR_EVAL_ERROR)
@@ -1058,6 +1151,17 @@ typedef struct {
 } njs_function_debug_t;
 
 
+typedef enum {
+    NJS_VM_RUNNING = 0,
+    NJS_VM_INSTRUCTIONS_LIMIT,
+    NJS_VM_TIME_LIMIT,
+} njs_vm_limit_t;
+
+
+/* The number of backward jumps and calls between the time limit checks. */
+#define NJS_VM_TIME_CHECKS       256
+
+
 struct njs_vm_s {
     /* njs_vm_t must be aligned to njs_value_t due to scratch value. */
     njs_value_t              retval;
@@ -1087,6 +1191,7 @@ struct njs_vm_s {
     uint32_t                 event_id;
     nxt_lvlhsh_t             events_hash;
     nxt_queue_t              posted_events;
+    nxt_queue_t              unhandled_rejections;
 
     njs_vm_opt_t             options;
 
@@ -1104,6 +1209,10 @@ struct njs_vm_s {
     size_t                   scope_size;
     size_t                   stack_size;
 
+    /* The freed stack chunks linked by the previous field. */
+    njs_native_frame_t       *spare_stack;
+    nxt_uint_t               spare_stack_n;
+
     njs_vm_shared_t          *shared;
     njs_parser_t             *parser;
 
@@ -1128,6 +1237,35 @@ struct njs_vm_s {
 
     njs_trap_t               trap:8;
 
+    /*
+     * The global scope contains the values computed by the global code,
+     * the clones of a frozen VM do not run it again.
+     */
+    uint8_t                  frozen;  /* 1 bit */
+
+    /*
+     * The strings, objects and arrays allocated by the VM are tracked,
+     * see njs_gc.c.
+     */
+    uint8_t                  gc;      /* 1 bit */
+
+    /* The strings produced by the addition are counted. */
+    uint8_t                  refcount; /* 1 bit */
+
+    nxt_lvlhsh_t             gc_hash;
+    nxt_queue_t              gc_items;
+    size_t                   gc_allocated;
+    size_t                   gc_threshold;
+
+    /* The execution limits, see njs_vm_execution_limit(). */
+    nxt_uint_t               ops;
+    nxt_uint_t               ops_limit;
+    uint64_t                 timeout;
+    uint64_t                 deadline;
+    nxt_uint_t               ticks;
+    nxt_uint_t               running;
+    njs_vm_limit_t           terminated:8;
+
     /*
      * njs_property_query() uses it to store reference to a temporary
      * PROPERTY_HANDLERs for NJS_EXTERNAL values in NJS_PROPERTY_QUERY_SET
@@ -1140,6 +1278,7 @@ struct njs_vm_s {
 typedef struct {
     u_char                   *start;
     u_char                   *end;
+    size_t                   scope_size;
     nxt_str_t                file;
     nxt_str_t                name;
 } njs_vm_code_t;
@@ -1148,13 +1287,13 @@ typedef struct {
 struct njs_vm_shared_s {
     nxt_lvlhsh_t             keywords_hash;
     nxt_lvlhsh_t             values_hash;
-    nxt_lvlhsh_t             array_instance_hash;
-    nxt_lvlhsh_t             string_instance_hash;
-    nxt_lvlhsh_t             function_instance_hash;
-    nxt_lvlhsh_t             arrow_instance_hash;
-    nxt_lvlhsh_t             arguments_object_instance_hash;
+    nxt_flathsh_t            array_instance_hash;
+    nxt_flathsh_t            string_instance_hash;
+    nxt_flathsh_t            function_instance_hash;
+    nxt_flathsh_t            arrow_instance_hash;
+    nxt_flathsh_t            arguments_object_instance_hash;
 
-    nxt_lvlhsh_t             env_hash;
+    nxt_flathsh_t            env_hash;
 
     njs_object_t             string_object;
     njs_object_t             objects[NJS_OBJECT_MAX];
@@ -1168,6 +1307,17 @@ struct njs_vm_shared_s {
     njs_function_t           constructors[NJS_CONSTRUCTOR_MAX];
 
     njs_regexp_pattern_t     *empty_regexp_pattern;
+
+    /* The memory pool of the VM which has created the shared data. */
+    nxt_mp_t                 *mem_pool;
+
+    /* The code of the functions generated on their first call. */
+    nxt_array_t              *code;  /* of njs_vm_code_t */
+
+#if (NXT_HAVE_JIT)
+    /* The machine code of the functions. */
+    njs_jit_code_t           *jit;
+#endif
 };
 
 
@@ -1179,9 +1329,11 @@ typedef enum {
 
 
 nxt_int_t njs_vmcode_interpreter(njs_vm_t *vm);
+njs_ret_t njs_vm_terminate(njs_vm_t *vm);
 
 void njs_value_retain(njs_value_t *value);
 void njs_value_release(njs_vm_t *vm, njs_value_t *value);
+void njs_value_pin(njs_value_t *value);
 
 njs_ret_t njs_vmcode_object(njs_vm_t *vm, njs_value_t *inlvd1,
     njs_value_t *inlvd2);
@@ -1214,6 +1366,14 @@ njs_ret_t njs_vmcode_property_foreach(njs_vm_t *vm, njs_value_t *object,
     njs_value_t *invld);
 njs_ret_t njs_vmcode_property_next(njs_vm_t *vm, njs_value_t *object,
     njs_value_t *value);
+njs_ret_t njs_vmcode_value_foreach(njs_vm_t *vm, njs_value_t *object,
+    njs_value_t *invld);
+njs_ret_t njs_vmcode_value_next(njs_vm_t *vm, njs_value_t *object,
+    njs_value_t *value);
+njs_ret_t njs_vmcode_array_spread(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *start);
+njs_ret_t njs_vmcode_object_spread(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *keys);
 njs_ret_t njs_vmcode_instance_of(njs_vm_t *vm, njs_value_t *object,
     njs_value_t *constructor);
 
@@ -1297,6 +1457,8 @@ njs_ret_t njs_vmcode_function_frame(njs_vm_t *vm, njs_value_t *value,
     njs_value_t *nargs);
 njs_ret_t njs_vmcode_method_frame(njs_vm_t *vm, njs_value_t *object,
     njs_value_t *method);
+njs_ret_t njs_vmcode_spread_frame(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *array);
 njs_ret_t njs_vmcode_function_call(njs_vm_t *vm, njs_value_t *invld,
     njs_value_t *retval);
 njs_ret_t njs_vmcode_return(njs_vm_t *vm, njs_value_t *invld,
@@ -1316,6 +1478,8 @@ njs_ret_t njs_vmcode_try_end(njs_vm_t *vm, njs_value_t *invld,
     njs_value_t *offset);
 njs_ret_t njs_vmcode_throw(njs_vm_t *vm, njs_value_t *invld,
     njs_value_t *retval);
+njs_ret_t njs_vmcode_await(njs_vm_t *vm, njs_value_t *value,
+    njs_value_t *retval);
 njs_ret_t njs_vmcode_catch(njs_vm_t *vm, njs_value_t *invld,
     njs_value_t *exception);
 njs_ret_t njs_vmcode_finally(njs_vm_t *vm, njs_value_t *invld,
@@ -1341,6 +1505,7 @@ nxt_array_t *njs_vm_backtrace(njs_vm_t *vm);
 
 void *njs_lvlhsh_alloc(void *data, size_t size, nxt_uint_t nalloc);
 void njs_lvlhsh_free(void *data, void *p, size_t size);
+void *njs_flathsh_alloc(void *data, size_t size, nxt_uint_t nalloc);
 
 njs_array_t * njs_value_enumerate(njs_vm_t *vm, const njs_value_t *value,
     njs_object_enum_t kind, nxt_bool_t all);
@@ -1379,6 +1544,7 @@ extern const nxt_mem_proto_t     njs_array_mem_proto;
 extern const nxt_lvlhsh_proto_t  njs_object_hash_proto;
 
 extern const njs_vmcode_generic_t  njs_continuation_nexus[];
+extern const njs_vmcode_generic_t  njs_async_catch_nexus[];
 
 
 #endif /* _NJS_VM_H_INCLUDED_ */
@@ -14,20 +14,24 @@
 
 static nxt_int_t
 njs_unit_test_benchmark(nxt_str_t *script, nxt_str_t *result, const char *msg,
-    nxt_uint_t n)
+    nxt_uint_t n, nxt_bool_t arena)
 {
     u_char         *start;
+    size_t         size;
     njs_vm_t       *vm, *nvm;
-    uint64_t       us;
+    uint64_t       us, allocations;
     nxt_int_t      ret, rc;
     nxt_str_t      s;
     nxt_uint_t     i;
     nxt_bool_t     success;
     njs_vm_opt_t   options;
+    nxt_mp_stat_t  stat;
     struct rusage  usage;
 
     nxt_memzero(&options, sizeof(njs_vm_opt_t));
 
+    options.arena = arena;
+
     vm = NULL;
     nvm = NULL;
     rc = NXT_ERROR;
@@ -46,6 +50,9 @@ njs_unit_test_benchmark(nxt_str_t *script, nxt_str_t *result, const char *msg,
         goto done;
     }
 
+    size = 0;
+    allocations = 0;
+
     for (i = 0; i < n; i++) {
 
         nvm = njs_vm_clone(vm, NULL);
@@ -68,6 +75,11 @@ njs_unit_test_benchmark(nxt_str_t *script, nxt_str_t *result, const char *msg,
             goto done;
         }
 
+        njs_vm_memory_stats(nvm, &stat);
+
+        size += stat.size;
+        allocations += stat.allocations;
+
         njs_vm_destroy(nvm);
         nvm = NULL;
     }
@@ -78,13 +90,17 @@ njs_unit_test_benchmark(nxt_str_t *script, nxt_str_t *result, const char *msg,
          + usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
 
     if (n == 1) {
-        nxt_printf("%s: %.3fs\n", msg, (double) us / 1000000);
+        nxt_printf("%s%s: %.3fs\n", msg, arena ? " arena" : "",
+                   (double) us / 1000000);
 
     } else {
-        nxt_printf("%s: %.3fµs, %d times/s\n",
-                   msg, (double) us / n, (int) ((uint64_t) n * 1000000 / us));
+        nxt_printf("%s%s: %.3fµs, %d times/s\n", msg, arena ? " arena" : "",
+                   (double) us / n, (int) ((uint64_t) n * 1000000 / us));
     }
 
+    nxt_printf("%s%s: %uL allocations, %uz bytes per run\n",
+               msg, arena ? " arena" : "", allocations / n, size / n);
+
     rc = NXT_OK;
 
 done:
@@ -104,6 +120,8 @@ done:
 int nxt_cdecl
 main(int argc, char **argv)
 {
+    nxt_bool_t  arena;
+
     static nxt_str_t  script = nxt_string("null");
     static nxt_str_t  result = nxt_string("null");
 
@@ -143,28 +161,33 @@ main(int argc, char **argv)
     static nxt_str_t  fibo_result = nxt_string("3524578");
 
 
+    /* The second "a" argument selects the arena allocation of clones. */
+
+    arena = (argc > 2 && argv[2][0] == 'a');
+
     if (argc > 1) {
         switch (argv[1][0]) {
 
         case 'v':
             return njs_unit_test_benchmark(&script, &result,
-                                           "nJSVM clone/destroy", 1000000);
+                                           "nJSVM clone/destroy", 1000000,
+                                           arena);
 
         case 'n':
             return njs_unit_test_benchmark(&fibo_number, &fibo_result,
-                                           "fibobench numbers", 1);
+                                           "fibobench numbers", 1, arena);
 
         case 'a':
             return njs_unit_test_benchmark(&fibo_ascii, &fibo_result,
-                                           "fibobench ascii strings", 1);
+                                           "fibobench ascii strings", 1, arena);
 
         case 'b':
             return njs_unit_test_benchmark(&fibo_bytes, &fibo_result,
-                                           "fibobench byte strings", 1);
+                                           "fibobench byte strings", 1, arena);
 
         case 'u':
             return njs_unit_test_benchmark(&fibo_utf8, &fibo_result,
-                                           "fibobench utf8 strings", 1);
+                                           "fibobench utf8 strings", 1, arena);
         }
     }
 
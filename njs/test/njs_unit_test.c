@@ -956,6 +956,25 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("!2"),
       nxt_string("false") },
 
+    { nxt_string("var a = [7, -7, 2147483647, 2147483648, 7.5, 0, -0, 7, 7];"
+                 "var b = [3, 3, 10, 7, 2, 5, 5, -3, NaN];"
+                 "a.map(function(v, i) { var r = v % b[i];"
+                 "                       return (r === 0) ? 1 / r : r })"),
+      nxt_string("1,-1,7,2,1.5,Infinity,-Infinity,1,NaN") },
+
+    { nxt_string("var a = [4294967295, 2147483648.5, -1.5, 1e21, NaN];"
+                 "a.map(function(v) { return [v | 0, v >>> 0, ~v, v << 1] })"),
+      nxt_string("-1,4294967295,0,-2,"
+                 "-2147483648,2147483648,2147483647,0,"
+                 "-1,4294967295,0,-2,"
+                 "-559939584,3735027712,559939583,-1119879168,"
+                 "0,0,-1,0") },
+
+    { nxt_string("var a = [1, NaN, undefined, null, true];"
+                 "a.map(function(v) { return [v < 1, v >= 1, 0 >= v] })"),
+      nxt_string("false,true,false,false,false,false,false,false,false,"
+                 "true,false,true,false,true,false") },
+
     /**/
 
     { nxt_string("var a = { valueOf: function() { return 1 } };   ~a"),
@@ -2255,6 +2274,106 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("(function(x){ if\n(\nx)\nreturn -1\n else\nreturn 0; })(0)"),
       nxt_string("0") },
 
+    /* Constant folding and dead code elimination. */
+
+    { nxt_string("[1024 * 1024, 'a' + 'b' + 'c', 2 ** 10, 7 % 3, -7 >> 1,"
+                 " -7 >>> 28, ~5, !0, !'']"),
+      nxt_string("1048576,abc,1024,1,-4,15,-6,true,true") },
+
+    { nxt_string("[1 / -0, -0 * 1 === 0, 1 / (-0 * 1), 0 / 0]"),
+      nxt_string("-Infinity,true,-Infinity,NaN") },
+
+    { nxt_string("[null == undefined, null === undefined, '10' < '9',"
+                 " '10' < 9, NaN == NaN, 'a' !== 'a']"),
+      nxt_string("true,false,true,false,false,false") },
+
+    { nxt_string("[typeof 1 === 'number', typeof null, typeof void 0, +true]"),
+      nxt_string("true,object,undefined,1") },
+
+    { nxt_string("['1' * 2, '1' + 2, 1 + '2', (1 + 2) * 'a']"),
+      nxt_string("2,12,12,NaN") },
+
+    { nxt_string("var a = 5; [false && a, true && a, 0 || a, 'x' || a]"),
+      nxt_string("false,5,5,x") },
+
+    { nxt_string("var a = 1; true ? a : a++; false ? a++ : a; a"),
+      nxt_string("1") },
+
+    { nxt_string("var a = 1; if (false) { var b = a++ } [a, b]"),
+      nxt_string("1,") },
+
+    { nxt_string("var a = 1; if (0) { a = 2 } else if (1) { a = 3 }"
+                 "else { a = 4 } a"),
+      nxt_string("3") },
+
+    { nxt_string("var a = 0; while (a < 3) { if (1) { a++; continue } a = 10 } a"),
+      nxt_string("3") },
+
+    { nxt_string("var r; if (1) { function f() { return 1 } r = f() } r"),
+      nxt_string("1") },
+
+    { nxt_string("var r = 0; if (0) { function g() { return 1 } r = g() } r"),
+      nxt_string("0") },
+
+    /* Temporary and move elimination. */
+
+    { nxt_string("var a = 1; a + a++"),
+      nxt_string("2") },
+
+    { nxt_string("var a = 1; a++ + a"),
+      nxt_string("3") },
+
+    { nxt_string("var a = 0, b = 0; for (var i = 0; i < 5; i++) { a++; b--; }"
+                 "[a, b, i]"),
+      nxt_string("5,-5,5") },
+
+    { nxt_string("var a = 'a'; a++; a"),
+      nxt_string("NaN") },
+
+    { nxt_string("var a = 1; a++"),
+      nxt_string("1") },
+
+    { nxt_string("var a = 1, r;"
+                 "switch (a) { case a++: r = 'one'; break; default: r = 'x' }"
+                 "[r, a]"),
+      nxt_string("one,2") },
+
+    { nxt_string("var a = 2, r;"
+                 "switch (a) { case 1: r = 1; break; case 2: a = 5; r = a }"
+                 "[r, a]"),
+      nxt_string("5,5") },
+
+    { nxt_string("var a = 0; a = a || 5; a"),
+      nxt_string("5") },
+
+    { nxt_string("var a = 2; a = a && a + 1; a"),
+      nxt_string("3") },
+
+    { nxt_string("var a = 0, b = 7; a = b || a; a"),
+      nxt_string("7") },
+
+    { nxt_string("var a = 0, b = 0; a = b || 3; a"),
+      nxt_string("3") },
+
+    { nxt_string("var a = 0, b = 0; a = b && 3; a"),
+      nxt_string("0") },
+
+    { nxt_string("var a = 1, z = 0, o; try { a = z || o.x } catch (e) {} a"),
+      nxt_string("1") },
+
+    { nxt_string("var a = 1, t = 1, o = null;"
+                 "try { a = t && o.p } catch (e) {} a"),
+      nxt_string("1") },
+
+    { nxt_string("var a = 1, z = 0; try { a = z || b } catch (e) {} a"),
+      nxt_string("1") },
+
+    { nxt_string("var x = 1, r;"
+                 "var o = {valueOf: function() { x = 2; return 5 }};"
+                 "switch (x) { case o + 1: r = 'six'; break; case 1: r = 'one' }"
+                 "r"),
+      nxt_string("one") },
+
     /* do while. */
 
     { nxt_string("do { break } if (false)"),
@@ -2723,13 +2842,6 @@ static njs_unit_test_t  njs_test[] =
       nxt_string("InternalError: try continue instructions with different labels "
                  "(\"out1\" vs \"out2\") from try-catch block are not supported") },
 
-    { nxt_string("function f() {"
-                 "  a:{ try { try { return 'a'; } catch (e) {break a;} finally {} } "
-                 "      catch (e) {} finally {}; }"
-                 "}"),
-      nxt_string("InternalError: try break/return instructions with different labels "
-                 "(\"@return\" vs \"a\") from try-catch block are not supported") },
-
     { nxt_string("a:{ try { try { continue a; } catch (e) {} finally {} } "
                  "    catch (e) {} finally {}; "
                  "}"),
@@ -2976,7 +3088,7 @@ static njs_unit_test_t  njs_test[] =
       nxt_string("TypeError: cannot get property \"b\" of undefined") },
 
     { nxt_string("var a = null; a.b++; a.b"),
-      nxt_string("TypeError: cannot get property \"b\" of undefined") },
+      nxt_string("TypeError: cannot get property \"b\" of null") },
 
     { nxt_string("var a = true; a.b++; a.b"),
       nxt_string("TypeError: property set on primitive boolean type") },
@@ -3471,6 +3583,15 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("var a = [,null,undefined,false,true,0,1]; a.join()"),
       nxt_string(",,,false,true,0,1") },
 
+    { nxt_string("var a = [1.5,-0,NaN,-Infinity,1e21,'s',{},[2,3]];"
+                 "a.join(':')"),
+      nxt_string("1.5:0:NaN:-Infinity:1e+21:s:[object Object]:2,3") },
+
+    { nxt_string("var a = [];"
+                 "for (var i = 0; i < 10000; i++) { a.push(i) };"
+                 "var s = a.join(); s.length + s.slice(-10)"),
+      nxt_string("48889,9998,9999") },
+
     { nxt_string("var o = { toString: function() { return null } };"
                  "[o].join()"),
       nxt_string("null") },
@@ -3860,6 +3981,25 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("[1,2,3,4,5].includes(NaN)"),
       nxt_string("false") },
 
+    { nxt_string("var a = [1,'1',true,null,undefined,-0,,'абв','s'.repeat(20)];"
+                 "[a.indexOf('1'), a.indexOf(0), a.indexOf(undefined),"
+                 " a.indexOf(null), a.indexOf(true), a.indexOf('абв'),"
+                 " a.indexOf('s'.repeat(20)), a.indexOf('s'), a.indexOf(NaN),"
+                 " a.lastIndexOf(1), a.lastIndexOf(-0), a.lastIndexOf(NaN)]"),
+      nxt_string("1,5,4,3,2,7,8,-1,-1,0,5,-1") },
+
+    { nxt_string("var a = ['1',1,'абв',,'s'.repeat(20),'абв',1,'1'];"
+                 "[a.lastIndexOf('1'), a.lastIndexOf('1', -2),"
+                 " a.lastIndexOf('абв'), a.lastIndexOf('абв', 4),"
+                 " a.lastIndexOf('s'.repeat(20)), a.lastIndexOf('s'),"
+                 " a.lastIndexOf('')]"),
+      nxt_string("7,0,5,2,4,-1,-1") },
+
+    { nxt_string("var a = ['1',1,2,'2'];"
+                 "[a.includes(2, 3), a.includes('2', 3), a.includes('1', 1),"
+                 " a.includes(1, -3), a.includes(0), a.includes('s')]"),
+      nxt_string("false,true,false,true,false,false") },
+
     { nxt_string("[].includes.bind(0)(0, 0)"),
       nxt_string("false") },
 
@@ -3905,6 +4045,34 @@ static njs_unit_test_t  njs_test[] =
                  "a.forEach(function(v, i, a) { c++ }); c"),
       nxt_string("0") },
 
+    { nxt_string("var r = [];"
+                 "try { [1,2,3].forEach(function(v) {"
+                 "          if (v == 2) { throw v } r.push(v) }) }"
+                 "catch (e) { r.push('e' + e) } r"),
+      nxt_string("1,e2") },
+
+    { nxt_string("[1,2,3,4].filter(function(v) {"
+                 "    try { if (v & 1) { throw v } return true }"
+                 "    catch (e) { return false } })"),
+      nxt_string("2,4") },
+
+    { nxt_string("[1,2].map(function(v, i) { v += 10; arguments[1] = 5;"
+                 "                          return v + i + arguments.length })"),
+      nxt_string("14,16") },
+
+    { nxt_string("[[1,2],[3]].map(function(a) {"
+                 "    return a.map(function(v) { return v * 2 })"
+                 "            .reduce(function(x, y) { return x + y }) })"),
+      nxt_string("6,6") },
+
+    { nxt_string("function f(n) { return n == 0 ? 0"
+                 "    : [n].reduce(function(a, v) { return a + f(v - 1) }, 1) }"
+                 "f(100)"),
+      nxt_string("100") },
+
+    { nxt_string("[1,2].map((v, ...r) => r.length)"),
+      nxt_string("2,2") },
+
     { nxt_string("var a = [];"
                  "a.some(function(v, i, a) { return v > 1 })"),
       nxt_string("false") },
@@ -3997,12 +4165,12 @@ static njs_unit_test_t  njs_test[] =
 
     { nxt_string("var a = Array.prototype.fill.apply("
                  "Object({length: 40}), [\"a\", 1, 20]); Object.values(a)"),
-      nxt_string("a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,40,a,a,a,a") },
+      nxt_string("40,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a") },
 
     { nxt_string("var a = Array.prototype.fill.apply({length: "
                  "{ valueOf: function() { return 40 }}}, [\"a\", 1, 20]);"
                  "Object.values(a)"),
-      nxt_string("a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,[object Object],a,a,a,a") },
+      nxt_string("[object Object],a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a") },
 
     { nxt_string("[NaN, false, ''].map("
                  "(x) => Array.prototype.fill.call(x)"
@@ -4284,6 +4452,51 @@ static njs_unit_test_t  njs_test[] =
                  "a.sort(function(x, y) { return x - y })"),
       nxt_string("1,") },
 
+    { nxt_string("[10,9,1,true,null,'a',-1.5].sort()"),
+      nxt_string("-1.5,1,10,9,a,,true") },
+
+    { nxt_string("var a = [3,undefined,1,,2]; a.sort();"
+                 "a.length + ':' + (a[3] === undefined) + ':' + (3 in a) + ':'"
+                 "+ (4 in a) + ':' + a"),
+      nxt_string("5:true:true:false:1,2,3,,") },
+
+    { nxt_string("var a = ['b',{toString:function() { return 'c' }},'aa'];"
+                 "a.sort().join()"),
+      nxt_string("aa,b,c") },
+
+    { nxt_string("var a = [{k:1,v:'a'},{k:0,v:'b'},{k:1,v:'c'},{k:0,v:'d'}];"
+                 "a.sort(function(x, y) { return x.k - y.k })"
+                 ".map(function(o) { return o.v }).join('')"),
+      nxt_string("bdac") },
+
+    { nxt_string("[5,1,4,2,3].sort((a, b) => b - a)"),
+      nxt_string("5,4,3,2,1") },
+
+    { nxt_string("[2,'10',1].sort(function(x, y) { return x - y })"),
+      nxt_string("1,2,10") },
+
+    { nxt_string("[5,1,4,2,3].sort(function(x, y) { return x > y })"),
+      nxt_string("1,2,3,4,5") },
+
+    { nxt_string("[5,1,4,2,3].sort(function(x, y) { return String(x - y) })"),
+      nxt_string("1,2,3,4,5") },
+
+    { nxt_string("var a = [3,2,1,0];"
+                 "a.sort(function(x, y) { a.length = 0; return x - y })"),
+      nxt_string("") },
+
+    { nxt_string("var a = [];"
+                 "for (var i = 0; i < 1000; i++) { a.push((i * 7919) % 1000) };"
+                 "var s = a.slice().sort(function(x, y) { return 0 + x - y });"
+                 "var n = a.slice().sort(function(x, y) { return x - y });"
+                 "var d = a.slice().sort();"
+                 "(s.join() == n.join()) + ':' + n.slice(0, 3)"
+                 "+ ':' + d.slice(0, 3)"),
+      nxt_string("true:0,1,2:0,1,10") },
+
+    { nxt_string("[2,1].sort(function() { throw 'e' })"),
+      nxt_string("e") },
+
     /* Template literal. */
 
     { nxt_string("`"),
@@ -5926,7 +6139,7 @@ static njs_unit_test_t  njs_test[] =
       nxt_string("абвгДЕЖЗДЕ") },
 
     { nxt_string("String.bytesFrom({})"),
-      nxt_string("TypeError: value must be a string or array") },
+      nxt_string("TypeError: value must be a string, array or ArrayBuffer") },
 
     { nxt_string("String.bytesFrom([1, 2, 0.23, '5', 'A']).toString('hex')"),
       nxt_string("0102000500") },
@@ -6240,10 +6453,6 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("function x(a) { while (a < 2) a++; return a + 1 } x(1) "),
       nxt_string("3") },
 
-    { nxt_string("(function(){(function(){(function(){(function(){"
-                    "(function(){(function(){(function(){})})})})})})})"),
-      nxt_string("SyntaxError: The maximum function nesting level is \"5\" in 1") },
-
     { nxt_string("Function.prototype.toString = function () {return 'X'};"
                  "eval"),
       nxt_string("X") },
@@ -6375,6 +6584,36 @@ static njs_unit_test_t  njs_test[] =
                  "f()()"),
       nxt_string("a") },
 
+    { nxt_string("function a(x) { function b() {"
+                 "function c() { return x } return c } return b()() } a(5)"),
+      nxt_string("5") },
+
+    { nxt_string("function a(x) { function b(y) {"
+                 "function c() { return x + y } return c } return b }"
+                 "a(1)(2)() + a(3)(4)()"),
+      nxt_string("10") },
+
+    { nxt_string("function a(x) { function b(y) {"
+                 "function c(z) { return y + z } return c } return b(x) }"
+                 "var f = a(1); f(2) + f(3)"),
+      nxt_string("7") },
+
+    { nxt_string("function f(a) { return a.map(function(v) { return v * 2 })"
+                 ".concat(a.map(function(v) { return v + a.length })) } f([1,2])"),
+      nxt_string("2,4,3,4") },
+
+    { nxt_string("function f() { var n = 0;"
+                 "function g(v) { function h() { n += v } h() }"
+                 "[1,2,3].forEach(g); return n } f() + f()"),
+      nxt_string("12") },
+
+    { nxt_string("function f() { var a = 'a';"
+                 "function g() { var b = 'b';"
+                 "function h() { var c = 'c';"
+                 "function k() { return function() { return a + c } }"
+                 "return k()() + b } return h() } return g() } f()"),
+      nxt_string("acb") },
+
     { nxt_string("function f() { var a = f2(); }"),
       nxt_string("undefined") },
 
@@ -6864,6 +7103,25 @@ static njs_unit_test_t  njs_test[] =
                  "f(3,4) === f.bind()(3,4)"),
       nxt_string("true") },
 
+    { nxt_string("function f(a, b) { return [a, b, arguments.length] }"
+                 "[f(1, 2), f(1), f(1, 2, 3)].join(';')"),
+      nxt_string("1,2,2;1,,1;1,2,3") },
+
+    { nxt_string("var o = {v: 1, f: function(a) { return this.v + a }}; o.f(2)"),
+      nxt_string("3") },
+
+    { nxt_string("function f(a) { var x = 1; x += a; return x }"
+                 "[f(1), f(2), f(3)]"),
+      nxt_string("2,3,4") },
+
+    { nxt_string("function f(n, a) { return n ? f(n - 1, a + 1) : a }"
+                 "f(2000, 0)"),
+      nxt_string("2000") },
+
+    { nxt_string("function f(a) { return function(b) { return a + b } }"
+                 "f(1)(2)"),
+      nxt_string("3") },
+
     { nxt_string("var obj = {prop:'abc'}; "
                  "var func = function(x) { "
                  "    return this === obj && x === 1 && arguments[0] === 1 "
@@ -6988,9 +7246,6 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("function arguments(){}"),
       nxt_string("SyntaxError: Identifier \"arguments\" is forbidden in function declaration in 1") },
 
-    { nxt_string("(function () {arguments = [];})"),
-      nxt_string("SyntaxError: Identifier \"arguments\" is forbidden as left-hand in assignment in 1") },
-
     { nxt_string("(function(){return arguments[0];})(1,2,3)"),
       nxt_string("1") },
 
@@ -7078,6 +7333,246 @@ static njs_unit_test_t  njs_test[] =
                  "myFoo(1,2);" ),
       nxt_string("") },
 
+    /* spread arguments. */
+
+    { nxt_string("function f(a, b, ...r) { return [a, b, r.length] };"
+                 "f(...[1,2,3,4])"),
+      nxt_string("1,2,2") },
+
+    { nxt_string("function f() { return arguments.length };"
+                 "[f(...[]), f(0, ...[1,2]), f(...[,,])]"),
+      nxt_string("0,3,2") },
+
+    { nxt_string("var a = [1, 5, 3]; Math.max(...a) + Math.min(0, ...a)"),
+      nxt_string("5") },
+
+    { nxt_string("var i = 0, a = [1];"
+                 "function f() { return Array.prototype.slice.call(arguments) };"
+                 "f(i, i++, ...a)"),
+      nxt_string("0,0,1") },
+
+    { nxt_string("var o = {f: function(a, b) { return this === o && a + b }};"
+                 "o.f(...[1, 2])"),
+      nxt_string("3") },
+
+    { nxt_string("var o = {f: function() { return this.v }, v: 1}, p = o;"
+                 "[o.f(o = {v: 2}, ...[]), p.f(p = null, ...[1])]"),
+      nxt_string("1,1") },
+
+    { nxt_string("function f() { return 'f' }; function g() { return 'g' };"
+                 "f(f = g, ...[])"),
+      nxt_string("f") },
+
+    { nxt_string("function F(a, b) { this.s = a + b }; new F(...[1, 2]).s"),
+      nxt_string("3") },
+
+    { nxt_string("var f = function() { return arguments.length }.bind(null, 1);"
+                 "f(...[2, 3])"),
+      nxt_string("3") },
+
+    { nxt_string("Math.max(...1)"),
+      nxt_string("TypeError: number is not iterable") },
+
+    { nxt_string("Math.max(...[1], 2)"),
+      nxt_string("2") },
+
+    { nxt_string("function f() { return Array.prototype.slice.call(arguments) }"
+                 "f(...'aб😀').join('|')"),
+      nxt_string("a|б|😀") },
+
+    { nxt_string("function f() { return Array.prototype.slice.call(arguments) }"
+                 "var a = [1, 2], b = [3];"
+                 "f(0, ...a, ...b, 4, ...'xy', ...[])"),
+      nxt_string("0,1,2,3,4,x,y") },
+
+    { nxt_string("function f() { return Array.prototype.slice.call(arguments) }"
+                 "var i = 0; f(i++, ...[i++], i++, ...[i++], i++,)"),
+      nxt_string("0,1,2,3,4") },
+
+    { nxt_string("var o = { m: function() { return this.v + arguments.length },"
+                 "          v: 'v' };"
+                 "o.m(...[1], ...'ab')"),
+      nxt_string("v3") },
+
+    { nxt_string("function F(a, b, c) { this.s = a + b + c };"
+                 "new F(...[1], 2, ...[3]).s"),
+      nxt_string("6") },
+
+    { nxt_string("Math.max(...[1], , 2)"),
+      nxt_string("SyntaxError: Unexpected token \",\" in 1") },
+
+    /* destructuring. */
+
+    { nxt_string("var {a, b: c} = {a: 1, b: 2}; [a, c]"),
+      nxt_string("1,2") },
+
+    { nxt_string("var [a, , b, c] = [1, 2, 3]; [a, b, c]"),
+      nxt_string("1,3,") },
+
+    { nxt_string("var [a, [b, {c}]] = [1, [2, {c: 3}]]; a + b + c"),
+      nxt_string("6") },
+
+    { nxt_string("var [a = 1, b = 2] = [undefined, null]; [a, b]"),
+      nxt_string("1,") },
+
+    { nxt_string("var {a: {b} = {b: 5}} = {}; b"),
+      nxt_string("5") },
+
+    { nxt_string("var x = 1, y = 2; [x, y] = [y, x]; [x, y]"),
+      nxt_string("2,1") },
+
+    { nxt_string("var a = [1, 2], x, y; [x, a] = a; [x, a]"),
+      nxt_string("1,2") },
+
+    { nxt_string("var o = {}, a; a = [o.x, o.y] = [1, 2]; [o.x, o.y, a]"),
+      nxt_string("1,2,1,2") },
+
+    { nxt_string("var a, b; ({a, b} = {a: 'x', b: 'y'}); a + b"),
+      nxt_string("xy") },
+
+    { nxt_string("var {length} = 'abc', [c] = 'xyz'; length + c"),
+      nxt_string("3x") },
+
+    { nxt_string("var [a, [[b] = [2]]] = [1, []]; a + b"),
+      nxt_string("3") },
+
+    { nxt_string("var n = 0; function f() { n++; return [1, 2] };"
+                 "var [a, b] = f(); [a, b, n]"),
+      nxt_string("1,2,1") },
+
+    { nxt_string("var [a] = null"),
+      nxt_string("TypeError: cannot get property \"0\" of null") },
+
+    { nxt_string("var [a];"),
+      nxt_string("SyntaxError: Missing initializer in destructuring declaration in 1") },
+
+    { nxt_string("[1] = [2]"),
+      nxt_string("SyntaxError: Invalid destructuring assignment target in 1") },
+
+    { nxt_string("var {a: b.c} = {}"),
+      nxt_string("SyntaxError: Invalid destructuring declaration target in 1") },
+
+    { nxt_string("var {a = 1, b = 2} = {b: null}; [a, b]"),
+      nxt_string("1,") },
+
+    { nxt_string("var a, b; ({a = 1, b: {b = 2} = {}} = {}); a + b"),
+      nxt_string("3") },
+
+    { nxt_string("var {a = 1}"),
+      nxt_string("SyntaxError: Missing initializer in destructuring declaration in 1") },
+
+    { nxt_string("var o = {a = 1}"),
+      nxt_string("SyntaxError: Invalid shorthand property initializer in 1") },
+
+    { nxt_string("var [a, ...r] = [1, 2, 3]; [a, r.length, r]"),
+      nxt_string("1,2,2,3") },
+
+    { nxt_string("var [a, , ...r] = [1]; r.length"),
+      nxt_string("0") },
+
+    { nxt_string("var [a, ...[b, c]] = 'xyz'; a + b + c"),
+      nxt_string("xyz") },
+
+    { nxt_string("var o = {}; [o.a, ...o.r] = [1, , 3]; o.r"),
+      nxt_string(",3") },
+
+    { nxt_string("var r = [5]; try { [...r] = 1 } catch (e) {}; r"),
+      nxt_string("5") },
+
+    { nxt_string("var [...r] = 1"),
+      nxt_string("TypeError: number is not iterable") },
+
+    { nxt_string("var {a, 'b': b, 1: c, ...r} = {a: 1, b: 2, 1: 3, d: 4, e: 5};"
+                 "[a, b, c, Object.keys(r).sort()]"),
+      nxt_string("1,2,3,d,e") },
+
+    { nxt_string("var {...r} = 'ab'; r[0] + r[1]"),
+      nxt_string("ab") },
+
+    { nxt_string("var {a} = null"),
+      nxt_string("TypeError: cannot get property \"a\" of null") },
+
+    { nxt_string("var {a} = undefined"),
+      nxt_string("TypeError: cannot get property \"a\" of undefined") },
+
+    { nxt_string("var {...r} = null"),
+      nxt_string("TypeError: cannot destructure null") },
+
+    { nxt_string("var [...r, a] = []"),
+      nxt_string("SyntaxError: Rest element must be last element in 1") },
+
+    { nxt_string("var {...r, a} = {}"),
+      nxt_string("SyntaxError: Rest element must be last element in 1") },
+
+    { nxt_string("var {...{a}} = {}"),
+      nxt_string("SyntaxError: Invalid rest element in 1") },
+
+    { nxt_string("var [...r = 1] = []"),
+      nxt_string("SyntaxError: Invalid rest element in 1") },
+
+    /* spread elements. */
+
+    { nxt_string("var a = [1, 2]; [0, ...a, 3, ...[], ...a]"),
+      nxt_string("0,1,2,3,1,2") },
+
+    { nxt_string("var a = [, 1]; [...a].hasOwnProperty(0)"),
+      nxt_string("true") },
+
+    { nxt_string("[1, , ...'αβ', , 2].length"),
+      nxt_string("6") },
+
+    { nxt_string("var i = 0; [i++, ...[i++, i++], i++]"),
+      nxt_string("0,1,2,3") },
+
+    { nxt_string("[...{}]"),
+      nxt_string("TypeError: object is not iterable") },
+
+    { nxt_string("var o = {a: 1, ...{b: 2, a: 3}, c: 4, ...null, ...'x'};"
+                 "njs.dump(o)"),
+      nxt_string("{a:3,b:2,c:4,0:'x'}") },
+
+    /* for-of. */
+
+    { nxt_string("var s = 0; for (var v of [1, 2, 3]) s += v; s"),
+      nxt_string("6") },
+
+    { nxt_string("var r = []; for (var v of [1, , 3]) r.push(typeof v); r"),
+      nxt_string("number,undefined,number") },
+
+    { nxt_string("var r = ''; for (var c of 'aб€😀') r += c + '|'; r"),
+      nxt_string("a|б|€|😀|") },
+
+    { nxt_string("var s = 0, v; for (v of [1, 2, 3, 4]) {"
+                 "  if (v == 2) continue; if (v == 4) break; s += v }; [s, v]"),
+      nxt_string("4,4") },
+
+    { nxt_string("var a = [1, 2], r = [];"
+                 "for (var v of a) { if (a.length < 4) a.push(v * 10); r.push(v) }"
+                 "r"),
+      nxt_string("1,2,10,20") },
+
+    { nxt_string("var a = [1, 2], n = 0; for (var v of a) { a = []; n++ }; n"),
+      nxt_string("2") },
+
+    { nxt_string("var r = [];"
+                 "for (var [k, v = 0] of [['a', 1], ['b']]) r.push(k + v); r"),
+      nxt_string("a1,b0") },
+
+    { nxt_string("var o = {}; for (o.p of [1, 2]) {}; o.p"),
+      nxt_string("2") },
+
+    { nxt_string("function f() { var r = [];"
+                 "  out: for (var a of [[1, 2], [3, 4]]) {"
+                 "    for (var v of a) { if (v == 3) break out; r.push(v) } }"
+                 "  return r } f()"),
+      nxt_string("1,2") },
+
+    { nxt_string("for (var v of {}) {}"),
+      nxt_string("TypeError: object is not iterable") },
+
+    { nxt_string("for (1 of []) {}"),
+      nxt_string("ReferenceError: Invalid left-hand side \"1\" in for-of statement in 1") },
+
     /* arrow functions. */
 
     { nxt_string("()"),
@@ -8160,6 +8655,17 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("var o = { toString: function() { return [1] } }; 'o:' + o"),
       nxt_string("TypeError: Cannot convert object to primitive value") },
 
+    { nxt_string("var o = { valueOf: function() { throw new Error('v') } };"
+                 "o + 1"),
+      nxt_string("Error: v") },
+
+    { nxt_string("var o = { valueOf: function() { throw 1 } };"
+                 "try { o * 2 } catch (e) {}"
+                 "var p = { valueOf: function() { return 5 },"
+                 "          toString: function() { return 's' } };"
+                 "p + 1"),
+      nxt_string("6") },
+
     { nxt_string("var a = { valueOf: function() { return '3' } };"
                  "var b = { toString: function() { return 10 - a + 'OK' } };"
                  "var c = { toString: function() { return b + 'YES' } };"
@@ -8323,8 +8829,22 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("var o = {}; var o2 = Object.create(o); o.__proto__ = o2"),
       nxt_string("TypeError: Cyclic __proto__ value") },
 
+    { nxt_string("var o = {}, p = {a: 1}; o.__proto__ = p; o.a"),
+      nxt_string("1") },
+
+    { nxt_string("var o = {}, p = {}; o.__proto__ = p; o.__proto__ = {a: 1};"
+                 "[o.a, Object.getPrototypeOf(o) === p]"),
+      nxt_string("1,false") },
+
+    { nxt_string("var o = Object.preventExtensions({}); o.__proto__ = {}"),
+      nxt_string("TypeError: Cannot set __proto__ of non-extensible object") },
+
+    { nxt_string("var o = Object.freeze({}); o.__proto__ = Object.prototype;"
+                 "o.__proto__ === Object.prototype"),
+      nxt_string("true") },
+
     { nxt_string("Object.prototype.__proto__.f()"),
-      nxt_string("TypeError: cannot get property \"f\" of undefined") },
+      nxt_string("TypeError: cannot get property \"f\" of null") },
 
     { nxt_string("var obj = Object.create(null); obj.one = 1;"
                  "var res = [];"
@@ -12646,6 +13166,20 @@ static njs_unit_test_t  njs_test[] =
                  "fs.writeFileSync('/njs_unknown_path', '', true)"),
       nxt_string("TypeError: Unknown options type (a string or object required)") },
 
+    /* require('fs').promises */
+
+    { nxt_string("var fsp = require('fs').promises;"
+                 "[fsp.readFile, fsp.writeFile, fsp.appendFile]"
+                 ".every(f => typeof f == 'function')"),
+      nxt_string("true") },
+
+    { nxt_string("require('fs').promises.readFile()"),
+      nxt_string("TypeError: too few arguments") },
+
+    { nxt_string("require('fs').promises.readFile('/njs_unknown_path')"
+                 ".catch(e => {throw e.syscall + ':' + e.errno})"),
+      nxt_string("open:2") },
+
     /* require('crypto').createHash() */
 
     { nxt_string("require('crypto').createHash('sha1')"),
@@ -12842,984 +13376,2592 @@ static njs_unit_test_t  njs_test[] =
     { nxt_string("typeof require('crypto').createHmac('md5', 'a')"),
       nxt_string("object") },
 
-    /* setTimeout(). */
-
-    { nxt_string("setTimeout()"),
-      nxt_string("TypeError: too few arguments") },
+    /* Promise. */
 
-    { nxt_string("setTimeout(function(){})"),
-      nxt_string("InternalError: not supported by host environment") },
+    { nxt_string("typeof Promise"),
+      nxt_string("function") },
 
-    { nxt_string("setTimeout(function(){}, 12)"),
-      nxt_string("InternalError: not supported by host environment") },
+    { nxt_string("Promise.name"),
+      nxt_string("Promise") },
 
-    /* clearTimeout(). */
+    { nxt_string("Promise.length"),
+      nxt_string("1") },
 
-    { nxt_string("clearTimeout()"),
-      nxt_string("undefined") },
+    { nxt_string("Object.prototype.toString.call(Promise.resolve())"),
+      nxt_string("[object Object]") },
 
-    { nxt_string("clearTimeout(123)"),
-      nxt_string("undefined") },
+    { nxt_string("Promise.prototype.constructor === Promise"),
+      nxt_string("true") },
 
-    /* Trick: number to boolean. */
+    { nxt_string("Promise()"),
+      nxt_string("TypeError: the Promise constructor must be called "
+                 "with \"new\"") },
 
-    { nxt_string("var a = 0; !!a"),
-      nxt_string("false") },
+    { nxt_string("new Promise()"),
+      nxt_string("TypeError: Promise executor is not a function") },
 
-    { nxt_string("var a = 5; !!a"),
+    { nxt_string("var p = Promise.resolve(1); Promise.resolve(p) === p"),
       nxt_string("true") },
 
-    /* Trick: flooring. */
+    { nxt_string("var a = []; Promise.resolve(1).then(v => a.push(v));"
+                 "a.push(0); a"),
+      nxt_string("0") },
 
-    { nxt_string("var n = -10.12345; ~~n"),
-      nxt_string("-10") },
+    { nxt_string("Promise.resolve(1).then(v => {throw Error('v:' + v)})"),
+      nxt_string("Error: v:1") },
 
-    { nxt_string("var n = 10.12345; ~~n"),
-      nxt_string("10") },
+    { nxt_string("Promise.reject(Error('oops'))"),
+      nxt_string("Error: oops") },
 
-    /* es5id: 8.2_A1_T1 */
-    /* es5id: 8.2_A1_T2 */
+    { nxt_string("Promise.reject(1).catch(v => v + 1)"
+                 ".then(v => {throw v})"),
+      nxt_string("2") },
 
-    { nxt_string("var x = null;"),
-      nxt_string("undefined") },
+    { nxt_string("new Promise(function(r, j) {j('x'); r('y')})"),
+      nxt_string("x") },
 
-    /* es5id: 8.2_A2 */
+    { nxt_string("new Promise(function() {throw 'thrown'})"),
+      nxt_string("thrown") },
 
-    { nxt_string("var null;"),
-      nxt_string("SyntaxError: Unexpected token \"null\" in 1") },
+    { nxt_string("var p = Promise.resolve(1); p.then(v => {throw v + 1});"
+                 "p.then(v => {throw v + 2})"),
+      nxt_string("2") },
 
-    /* es5id: 8.2_A3 */
+    { nxt_string("var p = Promise.resolve(1); p.then(() => p)"
+                 ".then(v => {throw 'v:' + v})"),
+      nxt_string("v:1") },
 
-    { nxt_string("typeof(null) === \"object\""),
-      nxt_string("true") },
+    { nxt_string("var p = Promise.resolve().then(() => p);"
+                 "p.catch(e => {throw e})"),
+      nxt_string("TypeError: promise is resolved with itself") },
 
-    /* Module. */
+    { nxt_string("Promise.resolve({then: function(r) {r(5)}})"
+                 ".then(v => {throw v})"),
+      nxt_string("5") },
 
-    { nxt_string("import;"),
-      nxt_string("SyntaxError: Non-default import is not supported in 1") },
+    { nxt_string("Promise.resolve({then: function() {throw 'x'}})"),
+      nxt_string("x") },
 
-    { nxt_string("import {x} from y"),
-      nxt_string("SyntaxError: Non-default import is not supported in 1") },
+    { nxt_string("Promise.resolve(1).finally(() => 2).then(v => {throw v})"),
+      nxt_string("1") },
 
-    { nxt_string("import x from y"),
-      nxt_string("SyntaxError: Unexpected token \"y\" in 1") },
+    { nxt_string("Promise.reject(1).finally(() => {throw 2})"),
+      nxt_string("2") },
 
-    { nxt_string("import x from {"),
-      nxt_string("SyntaxError: Unexpected token \"{\" in 1") },
+    { nxt_string("Promise.all([1, Promise.resolve(2), {then: r => r(3)}])"
+                 ".then(v => {throw v.join()})"),
+      nxt_string("1,2,3") },
 
-    { nxt_string("import x from ''"),
-      nxt_string("SyntaxError: Cannot find module \"\" in 1") },
+    { nxt_string("Promise.all([]).then(v => {throw v.length})"),
+      nxt_string("0") },
 
-    { nxt_string("import x from 'crypto'"),
-      nxt_string("undefined") },
+    { nxt_string("Promise.all([1, Promise.reject(2)])"),
+      nxt_string("2") },
 
-    { nxt_string("import x from 'crypto' 1"),
-      nxt_string("SyntaxError: Unexpected token \"1\" in 1") },
+    { nxt_string("Promise.race([new Promise(() => {}), Promise.resolve(3)])"
+                 ".then(v => {throw v})"),
+      nxt_string("3") },
 
-    { nxt_string("if (1) {import x from 'crypto'}"),
-      nxt_string("SyntaxError: Illegal import statement in 1") },
+    { nxt_string("var p = Promise.resolve(0);"
+                 "for (var i = 0; i < 1000; i++) { p = p.then(v => v + 1) }"
+                 "p.then(v => {throw v})"),
+      nxt_string("1000") },
 
-    { nxt_string("export"),
-      nxt_string("SyntaxError: Illegal export statement in 1") },
+    /* Async functions. */
 
-};
+    { nxt_string("async function f() {}; typeof f"),
+      nxt_string("function") },
 
+    { nxt_string("(async function() {})() instanceof Promise"),
+      nxt_string("true") },
 
-static njs_unit_test_t  njs_module_test[] =
-{
-    { nxt_string("function f(){return 2}; var f; f()"),
-      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+    { nxt_string("new (async function() {})"),
+      nxt_string("TypeError: function is not a constructor") },
 
-    { nxt_string("function f(){return 2}; var f = 1; f()"),
-      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+    { nxt_string("(async () => {}).prototype"),
+      nxt_string("undefined") },
 
-    { nxt_string("function f(){return 1}; function f(){return 2}; f()"),
-      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+    { nxt_string("await 1"),
+      nxt_string("SyntaxError: await is only valid in async functions in 1") },
 
-    { nxt_string("var f = 1; function f() {};"),
-      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+    { nxt_string("var async = 1; async + 1"),
+      nxt_string("2") },
 
-    { nxt_string("{ var f = 1; } function f() {};"),
-      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
-};
+    { nxt_string("var f = async => async * 2; f(4)"),
+      nxt_string("8") },
 
+    { nxt_string("var a = []; async function f() {a.push(1); await 0; a.push(3)}"
+                 "f(); a.push(2); a"),
+      nxt_string("1,2") },
 
-static njs_unit_test_t  njs_tz_test[] =
-{
-     { nxt_string("var d = new Date(1); d = d + ''; d.slice(0, 33)"),
-       nxt_string("Thu Jan 01 1970 12:45:00 GMT+1245") },
+    { nxt_string("async function f(x) {return await x + 1}"
+                 "f(Promise.resolve(1)).then(v => {throw v})"),
+      nxt_string("2") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getTime()"),
-       nxt_string("1308895200000") },
+    { nxt_string("async function f() {throw 'x'} f()"),
+      nxt_string("x") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.valueOf()"),
-       nxt_string("1308895200000") },
+    { nxt_string("async function f() {"
+                 "    try {await Promise.reject(1)} catch (e) {throw e + 1}}"
+                 "f()"),
+      nxt_string("2") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45);"
-                  "d.toString().slice(0, 33)"),
-       nxt_string("Fri Jun 24 2011 18:45:00 GMT+1245") },
+    { nxt_string("async function f() {try {return await 1} finally {throw 2}}"
+                 "f()"),
+      nxt_string("2") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45);"
-                  "d.toTimeString().slice(0, 17)"),
-       nxt_string("18:45:00 GMT+1245") },
+    { nxt_string("function g(a, b) {return a + b}"
+                 "async function f() {return g(1, await 2) + g(await 3, 4)}"
+                 "f().then(v => {throw v})"),
+      nxt_string("10") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.toUTCString()"),
-       nxt_string("Fri Jun 24 2011 06:00:00 GMT") },
+    { nxt_string("var f = async (x) => (await x) * 2;"
+                 "f({then: r => r(21)}).then(v => {throw v})"),
+      nxt_string("42") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
-                  "d.toISOString()"),
-       nxt_string("2011-06-24T06:00:12.625Z") },
+    { nxt_string("async function f() {var x = 1, g = () => x; x = await 2;"
+                 "    return g() + arguments[0]}"
+                 "f(3).then(v => {throw v})"),
+      nxt_string("5") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getUTCHours()"),
-       nxt_string("6") },
+    { nxt_string("async function f() {var s = 0;"
+                 "    for (var i = 0; i < 100; i++) {s += await i} return s}"
+                 "f().then(v => {throw v})"),
+      nxt_string("4950") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getUTCMinutes()"),
-       nxt_string("0") },
+    { nxt_string("async function f(n) {return n ? n + await f(n - 1) : 0}"
+                 "f(100).then(v => {throw v})"),
+      nxt_string("5050") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
-                  "d.getTimezoneOffset()"),
-       nxt_string("-765") },
+    { nxt_string("var timers = require('timers');"
+                 "async function f() {"
+                 "    var v = await timers.promises.setImmediate(1);"
+                 "    throw [v, await timers.promises.setTimeout(0, 2)]}"
+                 "f()"),
+      nxt_string("InternalError: not supported by host environment") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3, 2, 5003);"
-                  "d.getTime()"),
-       nxt_string("1308892687003") },
+    { nxt_string("var timers = require('timers');"
+                 "async function f() {"
+                 "    throw [await timers.promises.setImmediate(1),"
+                 "           await timers.promises.setImmediate()]}"
+                 "f()"),
+      nxt_string("1,") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3, 2);"
-                  "d.getTime()"),
-       nxt_string("1308892682625") },
+    /* ArrayBuffer, typed arrays and DataView. */
 
-     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3);"
-                  "d.getTime()"),
-       nxt_string("1308892683625") },
+    { nxt_string("var b = new ArrayBuffer(5); [b.byteLength, b]"),
+      nxt_string("5,[object Object]") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3, 2, 5003);"
-                  "d.getTime()"),
-       nxt_string("1308899887003") },
+    { nxt_string("new ArrayBuffer('3').byteLength"),
+      nxt_string("3") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3, 2);"
-                  "d.getTime()"),
-       nxt_string("1308899882625") },
+    { nxt_string("new ArrayBuffer(-1)"),
+      nxt_string("RangeError: Invalid array buffer length") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3);"
-                  "d.getTime()"),
-       nxt_string("1308899883625") },
+    { nxt_string("ArrayBuffer(1)"),
+      nxt_string("TypeError: the ArrayBuffer constructor must be called "
+                 "with \"new\"") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setHours(20);"
-                  "d.getTime()"),
-       nxt_string("1308902523625") },
+    { nxt_string("var b = new ArrayBuffer(4); new Uint8Array(b).set([1,2,3,4]);"
+                 "new Uint8Array(b.slice(1, -1))"),
+      nxt_string("2,3") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setMonth(2, 10);"
-                  "d.getTime()"),
-       nxt_string("1299733323625") },
+    { nxt_string("[ArrayBuffer.isView(new Int8Array(1)),"
+                 " ArrayBuffer.isView(new DataView(new ArrayBuffer(1))),"
+                 " ArrayBuffer.isView(new ArrayBuffer(1)),"
+                 " ArrayBuffer.isView([])]"),
+      nxt_string("true,true,false,false") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setMonth(2);"
-                  "d.getTime()"),
-       nxt_string("1300942923625") },
+    { nxt_string("var a = new Uint8Array(3); a[0] = 257; a[1] = -1; a[2] = 2.9;"
+                 "a"),
+      nxt_string("1,255,2") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setFullYear(2010, 2, 10);"
-                  "d.getTime()"),
-       nxt_string("1268197323625") },
+    { nxt_string("new Int8Array([127, 128, -129, 255])"),
+      nxt_string("127,-128,127,-1") },
 
-     { nxt_string("var d = new Date(1308895323625); d.setFullYear(2010, 2);"
-                  "d.getTime()"),
-       nxt_string("1269406923625") },
+    { nxt_string("new Uint8ClampedArray([300, -5, 1.5, 2.5, 254.5, NaN])"),
+      nxt_string("255,0,2,2,254,0") },
 
-     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
-                  "d.toJSON(1)"),
-       nxt_string("2011-06-24T06:00:12.625Z") },
-};
+    { nxt_string("new Int16Array([32768, -32769, 65535])"),
+      nxt_string("-32768,32767,-1") },
 
+    { nxt_string("new Uint16Array([-1, 65536])"),
+      nxt_string("65535,0") },
 
-static njs_unit_test_t  njs_regexp_test[] =
-{
-    { nxt_string("/[\\\\u02E0-\\\\u02E4]/"),
-      nxt_string("/[\\\\u02E0-\\\\u02E4]/") },
+    { nxt_string("new Int32Array([2147483648, -1.5, Infinity])"),
+      nxt_string("-2147483648,-1,0") },
 
-    { nxt_string("/[\\u02E0-\\u02E4]/"),
-      nxt_string("/[\\u02E0-\\u02E4]/") },
+    { nxt_string("new Uint32Array([-1, 4294967296])"),
+      nxt_string("4294967295,0") },
 
-    { nxt_string("RegExp('[\\\\u02E0-\\\\u02E4]')"),
-      nxt_string("/[\\u02E0-\\u02E4]/") },
+    { nxt_string("new Float32Array([0.1, 1e40])"),
+      nxt_string("0.10000000149011612,Infinity") },
 
-    { nxt_string("/[\\u0430-\\u044f]+/.test('тест')"),
-      nxt_string("true") },
+    { nxt_string("new Float64Array([0.1, -0, NaN])"),
+      nxt_string("0.1,0,NaN") },
 
-    { nxt_string("RegExp('[\\\\u0430-\\\\u044f]+').test('тест')"),
-      nxt_string("true") },
+    { nxt_string("new Uint8Array(['1', null, true, [], {}, , 7])"),
+      nxt_string("1,0,1,0,0,0,7") },
 
-    { nxt_string("RegExp('[\\\\u0430-\\\\u044f]+').exec('тест')[0]"),
-      nxt_string("тест") },
+    { nxt_string("new Uint8Array([{valueOf: function() {return 5}}])"),
+      nxt_string("5") },
 
-    { nxt_string("/[\\uFDE0-\\uFFFD]/g; export default 1"),
-      nxt_string("SyntaxError: Illegal export statement in 1") },
+    { nxt_string("var a = new Uint8Array(2); a[1] = {valueOf: function() {return 5}};"
+                 "a[1]"),
+      nxt_string("0") },
 
-    { nxt_string("RegExp(RegExp('\x00]]')).test('\x00]]')"),
-      nxt_string("true") },
+    { nxt_string("var a = new Int16Array(2);"
+                 "[a.length, a.byteLength, a.byteOffset, a.BYTES_PER_ELEMENT,"
+                 " a.buffer.byteLength]"),
+      nxt_string("2,4,0,2,4") },
 
-    { nxt_string("RegExp('\0').test('\0')"),
-      nxt_string("true") },
+    { nxt_string("[Int8Array.BYTES_PER_ELEMENT, Uint8ClampedArray.BYTES_PER_ELEMENT,"
+                 " Uint16Array.BYTES_PER_ELEMENT, Float32Array.BYTES_PER_ELEMENT,"
+                 " Float64Array.prototype.BYTES_PER_ELEMENT]"),
+      nxt_string("1,1,2,4,8") },
 
-    { nxt_string("RegExp('\x00').test('\0')"),
-      nxt_string("true") },
+    { nxt_string("[Uint8ClampedArray.name, Float64Array.name, DataView.name,"
+                 " Int32Array.length]"),
+      nxt_string("Uint8ClampedArray,Float64Array,DataView,3") },
 
-    { nxt_string("RegExp('\x00\\\\x00').source"),
-      nxt_string("\\u0000\\x00") },
+    { nxt_string("var a = new Uint32Array(1);"
+                 "[a.constructor === Uint32Array,"
+                 " Object.getPrototypeOf(a) === Uint32Array.prototype]"),
+      nxt_string("true,true") },
 
-    { nxt_string("/\\\0/"),
-      nxt_string("/\\\\u0000/") },
+    { nxt_string("var a = new Uint8Array(2); [a[2], a[-1], a['1'], a.x]"),
+      nxt_string(",,0,") },
 
-    { nxt_string("RegExp('\\\\\\0').source"),
-      nxt_string("\\\\u0000") },
+    { nxt_string("var a = new Uint8Array(2); a[5] = 1; a[5]"),
+      nxt_string("undefined") },
 
-    { nxt_string("RegExp('[\0]').test('\0')"),
-      nxt_string("true") },
-};
+    { nxt_string("var a = new Uint8Array(2); a.x = 1; a.x"),
+      nxt_string("1") },
 
+    { nxt_string("var a = new Uint8Array(2); delete a[0]"),
+      nxt_string("TypeError: Cannot delete property \"0\" of object value") },
 
-typedef struct {
-    nxt_lvlhsh_t          hash;
-    const njs_extern_t    *proto;
-    nxt_mp_t              *pool;
+    { nxt_string("var b = new ArrayBuffer(8), u8 = new Uint8Array(b),"
+                 "    u16 = new Uint16Array(b, 2, 2);"
+                 "u16[0] = 0x0102; u16[1] = 0xffff; u8[7] = 7;"
+                 "[u16.byteOffset, u16.length, u8[4], u8[5], u8[7],"
+                 " new Uint16Array(b, 6)[0] >> 8]"),
+      nxt_string("2,2,255,255,7,7") },
 
-    uint32_t              a;
-    nxt_str_t             uri;
+    { nxt_string("new Int32Array(new ArrayBuffer(8), 2)"),
+      nxt_string("RangeError: start offset of Int32Array should be a multiple "
+                 "of 4") },
 
-    njs_opaque_value_t    value;
-} njs_unit_test_req_t;
+    { nxt_string("new Int32Array(new ArrayBuffer(6))"),
+      nxt_string("RangeError: byte length of Int32Array should be a multiple "
+                 "of 4") },
 
+    { nxt_string("new Int32Array(new ArrayBuffer(8), 4, 2)"),
+      nxt_string("RangeError: Invalid typed array length") },
 
-typedef struct {
-    njs_value_t           name;
-    njs_value_t           value;
-} njs_unit_test_prop_t;
+    { nxt_string("new Uint8Array(-1)"),
+      nxt_string("RangeError: Invalid typed array length") },
 
+    { nxt_string("new Uint8Array({})"),
+      nxt_string("TypeError: Uint8Array argument must be a length, an array, "
+                 "an ArrayBuffer or a typed array") },
 
-static nxt_int_t
-lvlhsh_unit_test_key_test(nxt_lvlhsh_query_t *lhq, void *data)
-{
-    nxt_str_t             name;
-    njs_unit_test_prop_t  *prop;
+    { nxt_string("Float32Array(1)"),
+      nxt_string("TypeError: the Float32Array constructor must be called "
+                 "with \"new\"") },
 
-    prop = data;
-    njs_string_get(&prop->name, &name);
+    { nxt_string("new Int8Array(new Float64Array([1.5, -129, 3]))"),
+      nxt_string("1,127,3") },
 
-    if (name.length != lhq->key.length) {
-        return NXT_DECLINED;
-    }
+    { nxt_string("var a = new Uint16Array([1, 2]), b = new Uint16Array(a);"
+                 "b[0] = 5; [a[0], b[0]]"),
+      nxt_string("1,5") },
 
-    if (memcmp(name.start, lhq->key.start, lhq->key.length) == 0) {
-        return NXT_OK;
-    }
+    { nxt_string("var a = new Int32Array([1, 2, 3, 4, 5]);"
+                 "[a.subarray(1, -1), a.subarray(-2), a.subarray(3, 1).length]"),
+      nxt_string("2,3,4,4,5,0") },
 
-    return NXT_DECLINED;
-}
+    { nxt_string("var a = new Int32Array([1, 2, 3, 4]), s = a.subarray(2);"
+                 "s[0] = 9; [a, s.byteOffset, s.buffer === a.buffer]"),
+      nxt_string("1,2,9,4,8,true") },
 
+    { nxt_string("var a = new Int32Array([1, 2, 3, 4]), s = a.slice(1, 3);"
+                 "s[0] = 9; [a, s, s.buffer === a.buffer]"),
+      nxt_string("1,2,3,4,9,3,false") },
 
-static void *
-lvlhsh_unit_test_pool_alloc(void *pool, size_t size, nxt_uint_t nalloc)
-{
-    return nxt_mp_align(pool, size, size);
-}
+    { nxt_string("var a = new Uint8Array(5); a.set([1, 2], 1);"
+                 "a.set(new Float64Array([3.5]), 4); a"),
+      nxt_string("0,1,2,0,3") },
 
+    { nxt_string("var a = new Uint8Array(2); a.set([1, 2, 3])"),
+      nxt_string("RangeError: offset is out of bounds") },
 
-static void
-lvlhsh_unit_test_pool_free(void *pool, void *p, size_t size)
-{
-    nxt_mp_free(pool, p);
-}
+    { nxt_string("var a = new Uint8Array(2); a.set([], 3)"),
+      nxt_string("RangeError: offset is out of bounds") },
 
+    { nxt_string("var a = new Uint8Array(2); a.set([], 2 ** 40)"),
+      nxt_string("RangeError: offset is out of bounds") },
 
-static const nxt_lvlhsh_proto_t  lvlhsh_proto  nxt_aligned(64) = {
-    NXT_LVLHSH_LARGE_SLAB,
-    0,
-    lvlhsh_unit_test_key_test,
-    lvlhsh_unit_test_pool_alloc,
-    lvlhsh_unit_test_pool_free,
-};
+    { nxt_string("var a = new Uint8Array(2); a.set([1], NaN); a.set([], 2); a"),
+      nxt_string("1,0") },
 
+    { nxt_string("var a = new Uint8Array(2); a.set(1)"),
+      nxt_string("TypeError: the source must be an array or a typed array") },
 
-static njs_unit_test_prop_t *
-lvlhsh_unit_test_alloc(nxt_mp_t *pool, const njs_value_t *name,
-    const njs_value_t *value)
-{
-    njs_unit_test_prop_t *prop;
+    { nxt_string("var a = new Uint8Array([1, 2, 3, 4, 5, 6]);"
+                 "a.set(a.subarray(0, 4), 2); a"),
+      nxt_string("1,2,1,2,3,4") },
 
-    prop = nxt_mp_alloc(pool, sizeof(njs_unit_test_prop_t));
-    if (prop == NULL) {
-        return NULL;
-    }
+    { nxt_string("var b = new ArrayBuffer(8), a = new Uint16Array(b);"
+                 "a.set([1, 2, 3, 4]);"
+                 "new Uint8Array(b).set(a.subarray(1)); a"),
+      nxt_string("770,4,3,4") },
 
-    prop->name = *name;
-    prop->value = *value;
+    { nxt_string("new Float32Array(5).fill(1.5, 1, -1)"),
+      nxt_string("0,1.5,1.5,1.5,0") },
 
-    return prop;
-}
+    { nxt_string("new Uint8Array(3).fill(257)"),
+      nxt_string("1,1,1") },
 
+    { nxt_string("var a = new Int8Array([1, 2, 3, 2, 1]);"
+                 "[a.indexOf(2), a.indexOf(2, 2), a.lastIndexOf(2),"
+                 " a.lastIndexOf(2, -3), a.indexOf(5), a.indexOf('2')]"),
+      nxt_string("1,3,3,1,-1,-1") },
 
-static nxt_int_t
-lvlhsh_unit_test_add(njs_unit_test_req_t *r, njs_unit_test_prop_t *prop)
-{
-    nxt_lvlhsh_query_t  lhq;
+    { nxt_string("var a = new Float64Array([1, NaN]);"
+                 "[a.includes(NaN), a.indexOf(NaN), a.includes(1, 1)]"),
+      nxt_string("true,-1,false") },
 
-    njs_string_get(&prop->name, &lhq.key);
-    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+    { nxt_string("new Int16Array([1, -2, 3]).join('-')"),
+      nxt_string("1--2-3") },
 
-    lhq.replace = 1;
-    lhq.value = (void *) prop;
-    lhq.proto = &lvlhsh_proto;
-    lhq.pool = r->pool;
+    { nxt_string("new Int16Array([1, 2]).join('αβ')"),
+      nxt_string("1αβ2") },
 
-    switch (nxt_lvlhsh_insert(&r->hash, &lhq)) {
+    { nxt_string("new Int16Array(0).join()"),
+      nxt_string("") },
 
-    case NXT_OK:
-        return NXT_OK;
+    { nxt_string("new Float64Array([1, 2, 3]).reverse()"),
+      nxt_string("3,2,1") },
 
-    case NXT_DECLINED:
-    default:
-        return NXT_ERROR;
-    }
-}
+    { nxt_string("new Uint8Array([1, 2, 3, 4]).reverse()"),
+      nxt_string("4,3,2,1") },
 
+    { nxt_string("Uint8Array.prototype.join.call([1, 2])"),
+      nxt_string("TypeError: \"this\" argument is not a typed array") },
 
-static njs_ret_t
-njs_unit_test_r_get_uri_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    char *p = obj;
+    { nxt_string("var b = new ArrayBuffer(8), d = new DataView(b, 2);"
+                 "d.setUint32(0, 0x01020304);"
+                 "[d.byteOffset, d.byteLength, d.getUint32(0),"
+                 " d.getUint32(0, true), d.getUint16(1), d.getInt8(3),"
+                 " new Uint8Array(b)]"),
+      nxt_string("2,6,16909060,67305985,515,4,0,0,1,2,3,4,0,0") },
 
-    nxt_str_t  *field;
+    { nxt_string("var d = new DataView(new ArrayBuffer(8));"
+                 "d.setInt16(0, -2, true); d.setFloat32(2, 1.5);"
+                 "[d.getInt16(0, true), d.getUint16(0), d.getFloat32(2)]"),
+      nxt_string("-2,65279,1.5") },
 
-    field = (nxt_str_t *) (p + data);
+    { nxt_string("var d = new DataView(new ArrayBuffer(8));"
+                 "d.setFloat64(0, Math.PI, true);"
+                 "[d.getFloat64(0, true), new Float64Array(d.buffer)[0] === Math.PI]"),
+      nxt_string("3.141592653589793,true") },
 
-    return njs_vm_value_string_set(vm, value, field->start, field->length);
-}
+    { nxt_string("var d = new DataView(new ArrayBuffer(4));"
+                 "d.setInt32(0, -1); [d.getUint32(0), d.getInt32(0)]"),
+      nxt_string("4294967295,-1") },
 
+    { nxt_string("new DataView(new ArrayBuffer(4)).getInt32(1)"),
+      nxt_string("RangeError: offset is outside the bounds of the DataView") },
 
-static njs_ret_t
-njs_unit_test_r_set_uri_external(njs_vm_t *vm, void *obj, uintptr_t data,
-    nxt_str_t *value)
-{
-    char *p = obj;
+    { nxt_string("new DataView(new ArrayBuffer(4)).getInt8(-1)"),
+      nxt_string("RangeError: offset is outside the bounds of the DataView") },
 
-    nxt_str_t  *field;
+    { nxt_string("new DataView(new ArrayBuffer(4), 5)"),
+      nxt_string("RangeError: start offset is outside the bounds of the buffer") },
 
-    field = (nxt_str_t *) (p + data);
+    { nxt_string("new DataView(new ArrayBuffer(4), 1, 4)"),
+      nxt_string("RangeError: Invalid DataView length") },
 
-    *field = *value;
+    { nxt_string("new DataView([])"),
+      nxt_string("TypeError: the DataView argument must be an ArrayBuffer") },
 
-    return NXT_OK;
-}
+    { nxt_string("DataView.prototype.getInt8.call(new Uint8Array(1), 0)"),
+      nxt_string("TypeError: \"this\" argument is not a DataView") },
 
+    { nxt_string("String.bytesFrom(new Uint8Array([0x61, 0x62, 0x63]))"),
+      nxt_string("abc") },
 
-static njs_ret_t
-njs_unit_test_r_get_a_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    u_char               buf[16], *p;
-    njs_unit_test_req_t  *r;
+    { nxt_string("String.bytesFrom(new Uint16Array([0x6261]).buffer)"),
+      nxt_string("ab") },
 
-    r = (njs_unit_test_req_t *) obj;
+    { nxt_string("String.bytesFrom(new Uint8Array([1, 2, 3, 4]).subarray(1, 3))"
+                 ".toString('hex')"),
+      nxt_string("0203") },
 
-    p = nxt_sprintf(buf, buf + nxt_length(buf), "%uD", r->a);
+    /* Map, Set, WeakMap and WeakSet. */
 
-    return njs_vm_value_string_set(vm, value, buf, p - buf);
-}
+    { nxt_string("[typeof Map, typeof Set, typeof WeakMap, typeof WeakSet]"),
+      nxt_string("function,function,function,function") },
 
+    { nxt_string("[Map.name, Set.name, WeakMap.name, WeakSet.name, Map.length]"),
+      nxt_string("Map,Set,WeakMap,WeakSet,0") },
 
-static njs_ret_t
-njs_unit_test_r_get_b_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    njs_value_number_set(value, data);
+    { nxt_string("Map.prototype.constructor === Map"),
+      nxt_string("true") },
 
-    return NJS_OK;
-}
+    { nxt_string("Map()"),
+      nxt_string("TypeError: the Map constructor must be called with \"new\"") },
 
+    { nxt_string("new Set(1)"),
+      nxt_string("TypeError: the Set constructor argument is not iterable") },
 
-static njs_ret_t
-njs_unit_test_host_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    return njs_vm_value_string_set(vm, value, (u_char *) "АБВГДЕЁЖЗИЙ", 22);
-}
+    { nxt_string("new Map([1])"),
+      nxt_string("TypeError: iterator value is not an entry array") },
 
+    { nxt_string("var m = new Map(); m.set('a', 1).set('b', 2);"
+                 "[m.size, m.get('a'), m.get('b'), m.get('c')]"),
+      nxt_string("2,1,2,") },
 
-static njs_ret_t
-njs_unit_test_r_get_vars(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    nxt_int_t             ret;
-    nxt_str_t             *key;
-    nxt_lvlhsh_query_t    lhq;
-    njs_unit_test_req_t   *r;
-    njs_unit_test_prop_t  *prop;
+    { nxt_string("var m = new Map([[1, 'a'], ['1', 'b']]);"
+                 "[m.get(1), m.get('1'), m.has(true)]"),
+      nxt_string("a,b,false") },
 
-    r = (njs_unit_test_req_t *) obj;
-    key = (nxt_str_t *) data;
+    { nxt_string("var m = new Map([[NaN, 'n'], [-0, 'z']]);"
+                 "[m.get(NaN), m.get(0), 1 / m.keys()[1]]"),
+      nxt_string("n,z,Infinity") },
 
-    lhq.key = *key;
-    lhq.key_hash = nxt_djb_hash(key->start, key->length);
-    lhq.proto = &lvlhsh_proto;
+    { nxt_string("var o = {}, m = new Map([[o, 1]]); [m.get(o), m.get({})]"),
+      nxt_string("1,") },
 
-    ret = nxt_lvlhsh_find(&r->hash, &lhq);
+    { nxt_string("var m = new Map([[1, 'a'], [2, 'b'], [1, 'c']]);"
+                 "njs.dump(m.entries())"),
+      nxt_string("[[1,'c'],[2,'b']]") },
 
-    prop = lhq.value;
+    { nxt_string("var m = new Map([[1, 'a'], [2, 'b']]);"
+                 "[m.delete(1), m.delete(1), m.size, m.keys()]"),
+      nxt_string("true,false,1,2") },
 
-    if (ret == NXT_OK && njs_is_valid(&prop->value)) {
-        *value = prop->value;
-        return NXT_OK;
-    }
+    { nxt_string("var m = new Map([[1, 2]]); m.clear(); [m.size, m.has(1)]"),
+      nxt_string("0,false") },
 
-    njs_value_undefined_set(value);
+    { nxt_string("var m = new Map([['a', 1]]); m.delete('a'); m.set('b', 2);"
+                 "m.set('a', 3); m.keys()"),
+      nxt_string("b,a") },
 
-    return NXT_OK;
-}
+    { nxt_string("var m = new Map();"
+                 "for (var i = 0; i < 1000; i++) { m.set(i, i); m.delete(i - 1) }"
+                 "[m.size, m.get(999), m.get(998)]"),
+      nxt_string("1,999,") },
 
+    { nxt_string("var m = new Map(); for (var i = 0; i < 100; i++) m.set('k' + i, i);"
+                 "m.values().reduce(function(a, v) { return a + v }, 0)"),
+      nxt_string("4950") },
 
-static njs_ret_t
-njs_unit_test_r_set_vars(njs_vm_t *vm, void *obj, uintptr_t data,
-    nxt_str_t *value)
-{
-    nxt_int_t             ret;
-    nxt_str_t             *key;
-    njs_value_t           name, val;
-    njs_unit_test_req_t   *r;
-    njs_unit_test_prop_t  *prop;
+    { nxt_string("var r = [], m = new Map([['a', 1], ['b', 2]]);"
+                 "m.forEach(function(v, k, map) { r.push(k + v, map === m) }); r"),
+      nxt_string("a1,true,b2,true") },
 
-    r = (njs_unit_test_req_t *) obj;
-    key = (nxt_str_t *) data;
+    { nxt_string("var r = [], m = new Map([[1, 1], [2, 2]]);"
+                 "m.forEach(function(v) { r.push(v + this.d) }, {d: 10}); r"),
+      nxt_string("11,12") },
 
-    if (key->length == 5 && memcmp(key->start, "error", 5) == 0) {
-        njs_vm_error(vm, "cannot set \"error\" prop");
-        return NXT_ERROR;
-    }
+    { nxt_string("var r = [], s = new Set([1, 2, 3]);"
+                 "s.forEach(function(v) { r.push(v); if (v == 1) {"
+                 "s.delete(2); s.add(4) } }); r"),
+      nxt_string("1,3,4") },
 
-    njs_vm_value_string_set(vm, &name, key->start, key->length);
-    njs_vm_value_string_set(vm, &val, value->start, value->length);
+    { nxt_string("var n = 0, s = new Set([0]);"
+                 "s.forEach(function(v) { if (n++ < 20) { s.delete(v); s.add(v + 1) } });"
+                 "[n, s.values()]"),
+      nxt_string("21,20") },
 
-    prop = lvlhsh_unit_test_alloc(vm->mem_pool, &name, &val);
-    if (prop == NULL) {
-        njs_memory_error(vm);
-        return NXT_ERROR;
-    }
+    { nxt_string("new Map().forEach(1)"),
+      nxt_string("TypeError: the callback argument is not a function") },
 
-    ret = lvlhsh_unit_test_add(r, prop);
-    if (ret != NXT_OK) {
-        njs_vm_error(vm, "lvlhsh_unit_test_add() failed");
-        return NXT_ERROR;
-    }
+    { nxt_string("var s = new Set([1, 2, 2, '2']); [s.size, s.has(2), s.has('2')]"),
+      nxt_string("3,true,true") },
 
-    return NXT_OK;
-}
+    { nxt_string("var s = new Set(); s.add(1).add(2); njs.dump(s.entries())"),
+      nxt_string("[[1,1],[2,2]]") },
 
+    { nxt_string("var s = new Set(new Map([[1, 2]])); njs.dump(s.values())"),
+      nxt_string("[[1,2]]") },
 
-static njs_ret_t
-njs_unit_test_r_del_vars(njs_vm_t *vm, void *obj, uintptr_t data,
-    nxt_bool_t delete)
-{
-    nxt_int_t             ret;
-    nxt_str_t             *key;
-    nxt_lvlhsh_query_t    lhq;
-    njs_unit_test_req_t   *r;
-    njs_unit_test_prop_t  *prop;
+    { nxt_string("new Map(new Set([[1, 2]])).get(1)"),
+      nxt_string("2") },
 
-    r = (njs_unit_test_req_t *) obj;
-    key = (nxt_str_t *) data;
+    { nxt_string("Map.prototype.get.call(new Set(), 1)"),
+      nxt_string("TypeError: \"this\" argument is not a Map") },
 
-    if (key->length == 5 && memcmp(key->start, "error", 5) == 0) {
-        njs_vm_error(vm, "cannot delete \"error\" prop");
-        return NXT_ERROR;
-    }
+    { nxt_string("Set.prototype.has.call({}, 1)"),
+      nxt_string("TypeError: \"this\" argument is not a Set") },
 
-    lhq.key = *key;
-    lhq.key_hash = nxt_djb_hash(key->start, key->length);
-    lhq.proto = &lvlhsh_proto;
+    { nxt_string("var o = {}, w = new WeakMap([[o, 1]]);"
+                 "[w.get(o), w.has(o), w.delete(o), w.has(o)]"),
+      nxt_string("1,true,true,false") },
 
-    ret = nxt_lvlhsh_find(&r->hash, &lhq);
+    { nxt_string("new WeakMap().set('a', 1)"),
+      nxt_string("TypeError: invalid value used as weak map key") },
 
-    prop = lhq.value;
+    { nxt_string("new WeakMap().get(1)"),
+      nxt_string("undefined") },
 
-    if (ret == NXT_OK) {
-        njs_set_invalid(&prop->value);
-    }
+    { nxt_string("var o = [], w = new WeakSet([o]); [w.has(o), w.has([])]"),
+      nxt_string("true,false") },
 
-    return NXT_OK;
-}
+    { nxt_string("new WeakSet([1])"),
+      nxt_string("TypeError: invalid value used in weak set") },
 
+    { nxt_string("[typeof WeakMap.prototype.forEach, typeof WeakSet.prototype.size]"),
+      nxt_string("undefined,undefined") },
 
-static njs_ret_t
-njs_unit_test_header_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    uintptr_t data)
-{
-    u_char     *p;
-    uint32_t   size;
-    nxt_str_t  *h;
+    /* setTimeout(). */
 
-    h = (nxt_str_t *) data;
+    { nxt_string("setTimeout()"),
+      nxt_string("TypeError: too few arguments") },
 
-    size = 7 + h->length;
+    { nxt_string("setTimeout(function(){})"),
+      nxt_string("InternalError: not supported by host environment") },
 
-    p = njs_vm_value_string_alloc(vm, value, size);
-    if (p == NULL) {
-        return NJS_ERROR;
-    }
+    { nxt_string("setTimeout(function(){}, 12)"),
+      nxt_string("InternalError: not supported by host environment") },
 
-    p = nxt_cpymem(p, h->start, h->length);
-    *p++ = '|';
-    memcpy(p, "АБВ", 6);
+    /* clearTimeout(). */
 
-    return NJS_OK;
-}
+    { nxt_string("clearTimeout()"),
+      nxt_string("undefined") },
 
+    { nxt_string("clearTimeout(123)"),
+      nxt_string("undefined") },
 
-static njs_ret_t
-njs_unit_test_header_foreach_external(njs_vm_t *vm, void *obj, void *next)
-{
-    u_char  *s;
+    /* setImmediate(). */
 
-    s = next;
-    s[0] = '0';
-    s[1] = '0';
+    { nxt_string("setImmediate()"),
+      nxt_string("TypeError: too few arguments") },
 
-    return NXT_OK;
-}
+    { nxt_string("typeof setImmediate(function(){})"),
+      nxt_string("number") },
 
+    { nxt_string("setImmediate(function(v) {throw v}, 'immediate')"),
+      nxt_string("immediate") },
 
-static njs_ret_t
-njs_unit_test_header_next_external(njs_vm_t *vm, njs_value_t *value, void *obj,
-    void *next)
-{
-    u_char  *s;
+    { nxt_string("var a = [];"
+                 "setImmediate(function(v) {a.push(v)}, 1);"
+                 "setImmediate(function(v) {a.push(v); throw a.join()}, 2)"),
+      nxt_string("1,2") },
 
-    s = next;
-    s[1]++;
+    { nxt_string("var a = [];"
+                 "setImmediate(function() {a.push(1);"
+                 "                         setImmediate(function() {throw a})});"
+                 "a.push(0)"),
+      nxt_string("0,1") },
 
-    if (s[1] == '4') {
-        return NXT_DONE;
-    }
+    { nxt_string("var t = setImmediate(function() {throw 'Oops'});"
+                 "clearTimeout(t); 1"),
+      nxt_string("1") },
 
-    return njs_vm_value_string_set(vm, value, s, 2);
-}
+    /* setInterval(). */
 
+    { nxt_string("setInterval()"),
+      nxt_string("TypeError: too few arguments") },
 
-static njs_ret_t
-njs_unit_test_method_external(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
-    njs_index_t unused)
-{
-    nxt_int_t            ret;
-    nxt_str_t            s;
-    njs_unit_test_req_t  *r;
+    { nxt_string("setInterval(function(){}, 10)"),
+      nxt_string("InternalError: not supported by host environment") },
 
-    r = njs_vm_external(vm, njs_arg(args, nargs, 0));
-    if (nxt_slow_path(r == NULL)) {
-        return NJS_ERROR;
-    }
+    /* clearInterval(). */
 
-    ret = njs_vm_value_to_ext_string(vm, &s, njs_arg(args, nargs, 1), 0);
-    if (ret == NXT_OK && s.length == 3 && memcmp(s.start, "YES", 3) == 0) {
-        return njs_vm_value_string_set(vm, njs_vm_retval(vm), r->uri.start,
-                                       r->uri.length);
-    }
+    { nxt_string("clearInterval()"),
+      nxt_string("undefined") },
 
-    vm->retval = njs_value_undefined;
+    { nxt_string("clearInterval(123)"),
+      nxt_string("undefined") },
 
-    return NJS_OK;
-}
+    /* Trick: number to boolean. */
 
+    { nxt_string("var a = 0; !!a"),
+      nxt_string("false") },
 
-static njs_ret_t
-njs_unit_test_create_external(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
-    njs_index_t unused)
-{
-    nxt_int_t            ret;
-    nxt_str_t            uri;
-    njs_value_t          *value;
-    njs_unit_test_req_t  *r, *sr;
+    { nxt_string("var a = 5; !!a"),
+      nxt_string("true") },
 
-    r = njs_vm_external(vm, njs_arg(args, nargs, 0));
-    if (nxt_slow_path(r == NULL)) {
-        return NJS_ERROR;
-    }
+    /* Trick: flooring. */
 
-    if (njs_vm_value_to_ext_string(vm, &uri, njs_arg(args, nargs, 1), 0)
-        != NJS_OK)
-    {
-        return NJS_ERROR;
-    }
+    { nxt_string("var n = -10.12345; ~~n"),
+      nxt_string("-10") },
 
-    value = nxt_mp_zalloc(r->pool, sizeof(njs_opaque_value_t));
-    if (value == NULL) {
-        goto memory_error;
-    }
+    { nxt_string("var n = 10.12345; ~~n"),
+      nxt_string("10") },
 
-    sr = nxt_mp_zalloc(r->pool, sizeof(njs_unit_test_req_t));
-    if (sr == NULL) {
-        goto memory_error;
-    }
+    /* es5id: 8.2_A1_T1 */
+    /* es5id: 8.2_A1_T2 */
 
-    sr->uri = uri;
-    sr->pool = r->pool;
-    sr->proto = r->proto;
+    { nxt_string("var x = null;"),
+      nxt_string("undefined") },
 
-    ret = njs_vm_external_create(vm, value, sr->proto, sr);
-    if (ret != NXT_OK) {
-        return NJS_ERROR;
-    }
+    /* es5id: 8.2_A2 */
 
-    njs_vm_retval_set(vm, value);
+    { nxt_string("var null;"),
+      nxt_string("SyntaxError: Unexpected token \"null\" in 1") },
 
-    return NJS_OK;
+    /* es5id: 8.2_A3 */
 
-memory_error:
+    { nxt_string("typeof(null) === \"object\""),
+      nxt_string("true") },
+
+    /* Module. */
+
+    { nxt_string("import;"),
+      nxt_string("SyntaxError: Non-default import is not supported in 1") },
+
+    { nxt_string("import {x} from y"),
+      nxt_string("SyntaxError: Non-default import is not supported in 1") },
+
+    { nxt_string("import x from y"),
+      nxt_string("SyntaxError: Unexpected token \"y\" in 1") },
+
+    { nxt_string("import x from {"),
+      nxt_string("SyntaxError: Unexpected token \"{\" in 1") },
+
+    { nxt_string("import x from ''"),
+      nxt_string("SyntaxError: Cannot find module \"\" in 1") },
+
+    { nxt_string("import x from 'crypto'"),
+      nxt_string("undefined") },
+
+    { nxt_string("import x from 'crypto' 1"),
+      nxt_string("SyntaxError: Unexpected token \"1\" in 1") },
+
+    { nxt_string("if (1) {import x from 'crypto'}"),
+      nxt_string("SyntaxError: Illegal import statement in 1") },
+
+    { nxt_string("export"),
+      nxt_string("SyntaxError: Illegal export statement in 1") },
+
+};
+
+
+static njs_unit_test_t  njs_module_test[] =
+{
+    { nxt_string("function f(){return 2}; var f; f()"),
+      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+
+    { nxt_string("function f(){return 2}; var f = 1; f()"),
+      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+
+    { nxt_string("function f(){return 1}; function f(){return 2}; f()"),
+      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+
+    { nxt_string("var f = 1; function f() {};"),
+      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+
+    { nxt_string("{ var f = 1; } function f() {};"),
+      nxt_string("SyntaxError: \"f\" has already been declared in 1") },
+};
+
+
+/*
+ * The errors in the bodies of functions which are not called,
+ * the lazy mode reports them on the calls.
+ */
+
+static njs_unit_test_t  njs_compile_test[] =
+{
+    { nxt_string("function f() {"
+                 "  a:{ try { try { return 'a'; } catch (e) {break a;} finally {} } "
+                 "      catch (e) {} finally {}; }"
+                 "}"),
+      nxt_string("InternalError: try break/return instructions with different labels "
+                 "(\"@return\" vs \"a\") from try-catch block are not supported") },
+
+    { nxt_string("(function(){(function(){(function(){(function(){"
+                    "(function(){(function(){(function(){})})})})})})})"),
+      nxt_string("SyntaxError: The maximum function nesting level is \"5\" in 1") },
+
+    { nxt_string("(function () {arguments = [];})"),
+      nxt_string("SyntaxError: Identifier \"arguments\" is forbidden as left-hand in assignment in 1") },
+
+    { nxt_string("function f() { return [{a = 1}] }"),
+      nxt_string("SyntaxError: Invalid shorthand property initializer in 1") },
+
+    { nxt_string("async function f() {function g() {await 1}}"),
+      nxt_string("SyntaxError: await is only valid in async functions in 1") },
+};
+
+
+static njs_unit_test_t  njs_lazy_test[] =
+{
+    { nxt_string("function f() { return 1 +; } 1"),
+      nxt_string("1") },
+
+    { nxt_string("function f() {\n return 1 +; }\n"
+                 "var r; try { f() } catch (e) { r = String(e) }; "
+                 "try { f() } catch (e) { r += '|' + String(e) } r"),
+      nxt_string("SyntaxError: Unexpected token \";\" in 2|"
+                 "SyntaxError: Unexpected token \";\" in 2") },
+
+    { nxt_string("function f() { break } "
+                 "var r; try { f() } catch (e) { r = String(e) } r"),
+      nxt_string("SyntaxError: Illegal break statement in 1") },
+
+    { nxt_string("function f() { return [{a = 1}] } f()"),
+      nxt_string("SyntaxError: Invalid shorthand property initializer in 1") },
+
+    { nxt_string("(function () {arguments = [];})()"),
+      nxt_string("SyntaxError: Identifier \"arguments\" is forbidden as left-hand in assignment in 1") },
+
+    { nxt_string("var x = 1; function f(y) { var z = 2; "
+                 "function g() { return x + y + z } return g } "
+                 "f(10)() + f(20)()"),
+      nxt_string("36") },
+
+    { nxt_string("var x = 'outer'; "
+                 "function f() { var x = 'inner'; return function() { return x } } "
+                 "f()()"),
+      nxt_string("inner") },
+
+    { nxt_string("function f() { var a = 1; return (() => this.b + a)() } "
+                 "f.call({b: 2})"),
+      nxt_string("3") },
+
+    { nxt_string("function f() { return [].slice.call(arguments).concat(this.a) } "
+                 "f.call({a: 3}, 1, 2).join()"),
+      nxt_string("1,2,3") },
+
+    { nxt_string("function f(s) { return `${s}:${ {a: 1}.a }` + /b/.test(s) } "
+                 "f('ab')"),
+      nxt_string("ab:1true") },
+
+    { nxt_string("function f(a, b) { var r = a / b; return Math.max(r /= 2, 1) } "
+                 "f(8, 2)"),
+      nxt_string("2") },
+
+    { nxt_string("function f() { return async function(x) { return await x } } "
+                 "f()(3).then(v => {throw v})"),
+      nxt_string("3") },
+
+    { nxt_string("async function f() { function g() { await 1 } g() } f()"),
+      nxt_string("SyntaxError: await is only valid in async functions in 1") },
+};
+
+
+static njs_unit_test_t  njs_tz_test[] =
+{
+     { nxt_string("var d = new Date(1); d = d + ''; d.slice(0, 33)"),
+       nxt_string("Thu Jan 01 1970 12:45:00 GMT+1245") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getTime()"),
+       nxt_string("1308895200000") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.valueOf()"),
+       nxt_string("1308895200000") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45);"
+                  "d.toString().slice(0, 33)"),
+       nxt_string("Fri Jun 24 2011 18:45:00 GMT+1245") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45);"
+                  "d.toTimeString().slice(0, 17)"),
+       nxt_string("18:45:00 GMT+1245") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.toUTCString()"),
+       nxt_string("Fri Jun 24 2011 06:00:00 GMT") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
+                  "d.toISOString()"),
+       nxt_string("2011-06-24T06:00:12.625Z") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getUTCHours()"),
+       nxt_string("6") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45); d.getUTCMinutes()"),
+       nxt_string("0") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
+                  "d.getTimezoneOffset()"),
+       nxt_string("-765") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3, 2, 5003);"
+                  "d.getTime()"),
+       nxt_string("1308892687003") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3, 2);"
+                  "d.getTime()"),
+       nxt_string("1308892682625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setMinutes(3);"
+                  "d.getTime()"),
+       nxt_string("1308892683625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3, 2, 5003);"
+                  "d.getTime()"),
+       nxt_string("1308899887003") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3, 2);"
+                  "d.getTime()"),
+       nxt_string("1308899882625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setHours(20, 3);"
+                  "d.getTime()"),
+       nxt_string("1308899883625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setHours(20);"
+                  "d.getTime()"),
+       nxt_string("1308902523625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setMonth(2, 10);"
+                  "d.getTime()"),
+       nxt_string("1299733323625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setMonth(2);"
+                  "d.getTime()"),
+       nxt_string("1300942923625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setFullYear(2010, 2, 10);"
+                  "d.getTime()"),
+       nxt_string("1268197323625") },
+
+     { nxt_string("var d = new Date(1308895323625); d.setFullYear(2010, 2);"
+                  "d.getTime()"),
+       nxt_string("1269406923625") },
+
+     { nxt_string("var d = new Date(2011, 5, 24, 18, 45, 12, 625);"
+                  "d.toJSON(1)"),
+       nxt_string("2011-06-24T06:00:12.625Z") },
+};
+
+
+static njs_unit_test_t  njs_regexp_test[] =
+{
+    { nxt_string("/[\\\\u02E0-\\\\u02E4]/"),
+      nxt_string("/[\\\\u02E0-\\\\u02E4]/") },
+
+    { nxt_string("/[\\u02E0-\\u02E4]/"),
+      nxt_string("/[\\u02E0-\\u02E4]/") },
+
+    { nxt_string("RegExp('[\\\\u02E0-\\\\u02E4]')"),
+      nxt_string("/[\\u02E0-\\u02E4]/") },
+
+    { nxt_string("/[\\u0430-\\u044f]+/.test('тест')"),
+      nxt_string("true") },
+
+    { nxt_string("RegExp('[\\\\u0430-\\\\u044f]+').test('тест')"),
+      nxt_string("true") },
+
+    { nxt_string("RegExp('[\\\\u0430-\\\\u044f]+').exec('тест')[0]"),
+      nxt_string("тест") },
+
+    { nxt_string("/[\\uFDE0-\\uFFFD]/g; export default 1"),
+      nxt_string("SyntaxError: Illegal export statement in 1") },
+
+    { nxt_string("RegExp(RegExp('\x00]]')).test('\x00]]')"),
+      nxt_string("true") },
+
+    { nxt_string("RegExp('\0').test('\0')"),
+      nxt_string("true") },
+
+    { nxt_string("RegExp('\x00').test('\0')"),
+      nxt_string("true") },
+
+    { nxt_string("RegExp('\x00\\\\x00').source"),
+      nxt_string("\\u0000\\x00") },
+
+    { nxt_string("/\\\0/"),
+      nxt_string("/\\\\u0000/") },
+
+    { nxt_string("RegExp('\\\\\\0').source"),
+      nxt_string("\\\\u0000") },
+
+    { nxt_string("RegExp('[\0]').test('\0')"),
+      nxt_string("true") },
+};
+
+
+typedef struct {
+    nxt_lvlhsh_t          hash;
+    const njs_extern_t    *proto;
+    nxt_mp_t              *pool;
+
+    uint32_t              a;
+    nxt_str_t             uri;
+
+    njs_opaque_value_t    value;
+} njs_unit_test_req_t;
+
+
+typedef struct {
+    njs_value_t           name;
+    njs_value_t           value;
+} njs_unit_test_prop_t;
+
+
+static nxt_int_t
+lvlhsh_unit_test_key_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_str_t             name;
+    njs_unit_test_prop_t  *prop;
+
+    prop = data;
+    njs_string_get(&prop->name, &name);
+
+    if (name.length != lhq->key.length) {
+        return NXT_DECLINED;
+    }
+
+    if (memcmp(name.start, lhq->key.start, lhq->key.length) == 0) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static void *
+lvlhsh_unit_test_pool_alloc(void *pool, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_align(pool, size, size);
+}
+
+
+static void
+lvlhsh_unit_test_pool_free(void *pool, void *p, size_t size)
+{
+    nxt_mp_free(pool, p);
+}
+
+
+static const nxt_lvlhsh_proto_t  lvlhsh_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_LARGE_SLAB,
+    0,
+    lvlhsh_unit_test_key_test,
+    lvlhsh_unit_test_pool_alloc,
+    lvlhsh_unit_test_pool_free,
+};
+
+
+static njs_unit_test_prop_t *
+lvlhsh_unit_test_alloc(nxt_mp_t *pool, const njs_value_t *name,
+    const njs_value_t *value)
+{
+    njs_unit_test_prop_t *prop;
+
+    prop = nxt_mp_alloc(pool, sizeof(njs_unit_test_prop_t));
+    if (prop == NULL) {
+        return NULL;
+    }
+
+    prop->name = *name;
+    prop->value = *value;
+
+    return prop;
+}
+
+
+static nxt_int_t
+lvlhsh_unit_test_add(njs_unit_test_req_t *r, njs_unit_test_prop_t *prop)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    njs_string_get(&prop->name, &lhq.key);
+    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+
+    lhq.replace = 1;
+    lhq.value = (void *) prop;
+    lhq.proto = &lvlhsh_proto;
+    lhq.pool = r->pool;
+
+    switch (nxt_lvlhsh_insert(&r->hash, &lhq)) {
+
+    case NXT_OK:
+        return NXT_OK;
+
+    case NXT_DECLINED:
+    default:
+        return NXT_ERROR;
+    }
+}
+
+
+static njs_ret_t
+njs_unit_test_r_get_uri_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    char *p = obj;
+
+    nxt_str_t  *field;
+
+    field = (nxt_str_t *) (p + data);
+
+    return njs_vm_value_string_set(vm, value, field->start, field->length);
+}
+
+
+static njs_ret_t
+njs_unit_test_r_set_uri_external(njs_vm_t *vm, void *obj, uintptr_t data,
+    nxt_str_t *value)
+{
+    char *p = obj;
+
+    nxt_str_t  *field;
+
+    field = (nxt_str_t *) (p + data);
+
+    *field = *value;
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_r_get_a_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    u_char               buf[16], *p;
+    njs_unit_test_req_t  *r;
+
+    r = (njs_unit_test_req_t *) obj;
+
+    p = nxt_sprintf(buf, buf + nxt_length(buf), "%uD", r->a);
+
+    return njs_vm_value_string_set(vm, value, buf, p - buf);
+}
+
+
+static njs_ret_t
+njs_unit_test_r_get_b_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    njs_value_number_set(value, data);
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_host_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    return njs_vm_value_string_set(vm, value, (u_char *) "АБВГДЕЁЖЗИЙ", 22);
+}
+
+
+static njs_ret_t
+njs_unit_test_r_get_vars(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    nxt_int_t             ret;
+    nxt_str_t             *key;
+    nxt_lvlhsh_query_t    lhq;
+    njs_unit_test_req_t   *r;
+    njs_unit_test_prop_t  *prop;
+
+    r = (njs_unit_test_req_t *) obj;
+    key = (nxt_str_t *) data;
+
+    lhq.key = *key;
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.proto = &lvlhsh_proto;
+
+    ret = nxt_lvlhsh_find(&r->hash, &lhq);
+
+    prop = lhq.value;
+
+    if (ret == NXT_OK && njs_is_valid(&prop->value)) {
+        *value = prop->value;
+        return NXT_OK;
+    }
+
+    njs_value_undefined_set(value);
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_r_set_vars(njs_vm_t *vm, void *obj, uintptr_t data,
+    nxt_str_t *value)
+{
+    nxt_int_t             ret;
+    nxt_str_t             *key;
+    njs_value_t           name, val;
+    njs_unit_test_req_t   *r;
+    njs_unit_test_prop_t  *prop;
+
+    r = (njs_unit_test_req_t *) obj;
+    key = (nxt_str_t *) data;
+
+    if (key->length == 5 && memcmp(key->start, "error", 5) == 0) {
+        njs_vm_error(vm, "cannot set \"error\" prop");
+        return NXT_ERROR;
+    }
+
+    njs_vm_value_string_set(vm, &name, key->start, key->length);
+    njs_vm_value_string_set(vm, &val, value->start, value->length);
+
+    prop = lvlhsh_unit_test_alloc(vm->mem_pool, &name, &val);
+    if (prop == NULL) {
+        njs_memory_error(vm);
+        return NXT_ERROR;
+    }
+
+    ret = lvlhsh_unit_test_add(r, prop);
+    if (ret != NXT_OK) {
+        njs_vm_error(vm, "lvlhsh_unit_test_add() failed");
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_r_del_vars(njs_vm_t *vm, void *obj, uintptr_t data,
+    nxt_bool_t delete)
+{
+    nxt_int_t             ret;
+    nxt_str_t             *key;
+    nxt_lvlhsh_query_t    lhq;
+    njs_unit_test_req_t   *r;
+    njs_unit_test_prop_t  *prop;
+
+    r = (njs_unit_test_req_t *) obj;
+    key = (nxt_str_t *) data;
+
+    if (key->length == 5 && memcmp(key->start, "error", 5) == 0) {
+        njs_vm_error(vm, "cannot delete \"error\" prop");
+        return NXT_ERROR;
+    }
+
+    lhq.key = *key;
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.proto = &lvlhsh_proto;
+
+    ret = nxt_lvlhsh_find(&r->hash, &lhq);
+
+    prop = lhq.value;
+
+    if (ret == NXT_OK) {
+        njs_set_invalid(&prop->value);
+    }
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_header_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    uintptr_t data)
+{
+    u_char     *p;
+    uint32_t   size;
+    nxt_str_t  *h;
+
+    h = (nxt_str_t *) data;
+
+    size = 7 + h->length;
+
+    p = njs_vm_value_string_alloc(vm, value, size);
+    if (p == NULL) {
+        return NJS_ERROR;
+    }
+
+    p = nxt_cpymem(p, h->start, h->length);
+    *p++ = '|';
+    memcpy(p, "АБВ", 6);
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_header_foreach_external(njs_vm_t *vm, void *obj, void *next)
+{
+    u_char  *s;
+
+    s = next;
+    s[0] = '0';
+    s[1] = '0';
+
+    return NXT_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_header_next_external(njs_vm_t *vm, njs_value_t *value, void *obj,
+    void *next)
+{
+    u_char  *s;
+
+    s = next;
+    s[1]++;
+
+    if (s[1] == '4') {
+        return NXT_DONE;
+    }
+
+    return njs_vm_value_string_set(vm, value, s, 2);
+}
+
+
+static njs_ret_t
+njs_unit_test_method_external(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    nxt_int_t            ret;
+    nxt_str_t            s;
+    njs_unit_test_req_t  *r;
+
+    r = njs_vm_external(vm, njs_arg(args, nargs, 0));
+    if (nxt_slow_path(r == NULL)) {
+        return NJS_ERROR;
+    }
+
+    ret = njs_vm_value_to_ext_string(vm, &s, njs_arg(args, nargs, 1), 0);
+    if (ret == NXT_OK && s.length == 3 && memcmp(s.start, "YES", 3) == 0) {
+        return njs_vm_value_string_set(vm, njs_vm_retval(vm), r->uri.start,
+                                       r->uri.length);
+    }
+
+    vm->retval = njs_value_undefined;
+
+    return NJS_OK;
+}
+
+
+static njs_ret_t
+njs_unit_test_create_external(njs_vm_t *vm, njs_value_t *args, nxt_uint_t nargs,
+    njs_index_t unused)
+{
+    nxt_int_t            ret;
+    nxt_str_t            uri;
+    njs_value_t          *value;
+    njs_unit_test_req_t  *r, *sr;
+
+    r = njs_vm_external(vm, njs_arg(args, nargs, 0));
+    if (nxt_slow_path(r == NULL)) {
+        return NJS_ERROR;
+    }
+
+    if (njs_vm_value_to_ext_string(vm, &uri, njs_arg(args, nargs, 1), 0)
+        != NJS_OK)
+    {
+        return NJS_ERROR;
+    }
+
+    value = nxt_mp_zalloc(r->pool, sizeof(njs_opaque_value_t));
+    if (value == NULL) {
+        goto memory_error;
+    }
+
+    sr = nxt_mp_zalloc(r->pool, sizeof(njs_unit_test_req_t));
+    if (sr == NULL) {
+        goto memory_error;
+    }
+
+    sr->uri = uri;
+    sr->pool = r->pool;
+    sr->proto = r->proto;
+
+    ret = njs_vm_external_create(vm, value, sr->proto, sr);
+    if (ret != NXT_OK) {
+        return NJS_ERROR;
+    }
+
+    njs_vm_retval_set(vm, value);
+
+    return NJS_OK;
+
+memory_error:
 
     njs_memory_error(vm);
 
-    return NXT_ERROR;
+    return NXT_ERROR;
+}
+
+
+static njs_external_t  njs_unit_test_r_props[] = {
+
+    { nxt_string("a"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      njs_unit_test_r_get_a_external,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("b"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      njs_unit_test_r_get_b_external,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      42 },
+};
+
+
+static njs_external_t  njs_unit_test_r_external[] = {
+
+    { nxt_string("uri"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      njs_unit_test_r_get_uri_external,
+      njs_unit_test_r_set_uri_external,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      offsetof(njs_unit_test_req_t, uri) },
+
+    { nxt_string("host"),
+      NJS_EXTERN_PROPERTY,
+      NULL,
+      0,
+      njs_unit_test_host_external,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("props"),
+      NJS_EXTERN_OBJECT,
+      njs_unit_test_r_props,
+      nxt_nitems(njs_unit_test_r_props),
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("vars"),
+      NJS_EXTERN_OBJECT,
+      NULL,
+      0,
+      njs_unit_test_r_get_vars,
+      njs_unit_test_r_set_vars,
+      njs_unit_test_r_del_vars,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("consts"),
+      NJS_EXTERN_OBJECT,
+      NULL,
+      0,
+      njs_unit_test_r_get_vars,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+    { nxt_string("header"),
+      NJS_EXTERN_OBJECT,
+      NULL,
+      0,
+      njs_unit_test_header_external,
+      NULL,
+      NULL,
+      njs_unit_test_header_foreach_external,
+      njs_unit_test_header_next_external,
+      NULL,
+      0 },
+
+    { nxt_string("some_method"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      njs_unit_test_method_external,
+      0 },
+
+    { nxt_string("create"),
+      NJS_EXTERN_METHOD,
+      NULL,
+      0,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      njs_unit_test_create_external,
+      0 },
+
+};
+
+
+static njs_external_t  nxt_test_external[] = {
+
+    { nxt_string("request.proto"),
+      NJS_EXTERN_OBJECT,
+      njs_unit_test_r_external,
+      nxt_nitems(njs_unit_test_r_external),
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      0 },
+
+};
+
+
+typedef struct {
+    nxt_str_t            name;
+    njs_unit_test_req_t  request;
+    njs_unit_test_prop_t props[2];
+} njs_unit_test_req_t_init_t;
+
+
+static const njs_unit_test_req_t_init_t nxt_test_requests[] = {
+
+    { nxt_string("$r"),
+     {
+         .uri = nxt_string("АБВ"),
+         .a = 1
+     },
+     {
+         { njs_string("p"), njs_string("pval") },
+         { njs_string("p2"), njs_string("p2val") },
+     }
+    },
+
+    { nxt_string("$r2"),
+     {
+         .uri = nxt_string("αβγ"),
+         .a = 2
+     },
+     {
+         { njs_string("q"), njs_string("qval") },
+         { njs_string("q2"), njs_string("q2val") },
+     }
+    },
+
+    { nxt_string("$r3"),
+     {
+         .uri = nxt_string("abc"),
+         .a = 3
+     },
+     {
+         { njs_string("k"), njs_string("kval") },
+         { njs_string("k2"), njs_string("k2val") },
+     }
+    },
+};
+
+
+static nxt_int_t
+njs_externals_init(njs_vm_t *vm)
+{
+    nxt_int_t             ret;
+    nxt_uint_t            i, j;
+    const njs_extern_t    *proto;
+    njs_unit_test_req_t   *requests;
+    njs_unit_test_prop_t  *prop;
+
+    proto = njs_vm_external_prototype(vm, &nxt_test_external[0]);
+    if (proto == NULL) {
+        nxt_printf("njs_vm_external_prototype() failed\n");
+        return NXT_ERROR;
+    }
+
+    requests = nxt_mp_zalloc(vm->mem_pool,
+                             nxt_nitems(nxt_test_requests)
+                             * sizeof(njs_unit_test_req_t));
+    if (requests == NULL) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_test_requests); i++) {
+
+        requests[i] = nxt_test_requests[i].request;
+        requests[i].pool = vm->mem_pool;
+        requests[i].proto = proto;
+
+        ret = njs_vm_external_create(vm, njs_value_arg(&requests[i].value),
+                                     proto, &requests[i]);
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_external_create() failed\n");
+            return NXT_ERROR;
+        }
+
+        ret = njs_vm_external_bind(vm, &nxt_test_requests[i].name,
+                                   njs_value_arg(&requests[i].value));
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_external_bind() failed\n");
+            return NXT_ERROR;
+        }
+
+        for (j = 0; j < nxt_nitems(nxt_test_requests[i].props); j++) {
+            prop = lvlhsh_unit_test_alloc(vm->mem_pool,
+                                          &nxt_test_requests[i].props[j].name,
+                                          &nxt_test_requests[i].props[j].value);
+
+            if (prop == NULL) {
+                nxt_printf("lvlhsh_unit_test_alloc() failed\n");
+                return NXT_ERROR;
+            }
+
+            ret = lvlhsh_unit_test_add(&requests[i], prop);
+            if (ret != NXT_OK) {
+                nxt_printf("lvlhsh_unit_test_add() failed\n");
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_unit_test(njs_unit_test_t tests[], size_t num, nxt_bool_t module,
+    nxt_bool_t lazy, uint32_t jit, nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    u_char        *start;
+    njs_vm_t      *vm, *nvm;
+    nxt_int_t     ret, rc;
+    nxt_str_t     s;
+    nxt_uint_t    i;
+    nxt_bool_t    success;
+    njs_vm_opt_t  options;
+
+    vm = NULL;
+    nvm = NULL;
+
+    rc = NXT_ERROR;
+
+    for (i = 0; i < num; i++) {
+
+        if (verbose) {
+            nxt_printf("\"%V\"\n", &tests[i].script);
+        }
+
+        nxt_memzero(&options, sizeof(njs_vm_opt_t));
+
+        options.module = module;
+        options.lazy = lazy;
+        options.jit = jit;
+
+        vm = njs_vm_create(&options);
+        if (vm == NULL) {
+            nxt_printf("njs_vm_create() failed\n");
+            goto done;
+        }
+
+        ret = njs_externals_init(vm);
+        if (ret != NXT_OK) {
+            goto done;
+        }
+
+        start = tests[i].script.start;
+
+        ret = njs_vm_compile(vm, &start, start + tests[i].script.length);
+
+        if (ret == NXT_OK) {
+            if (disassemble) {
+                njs_disassembler(vm);
+            }
+
+            nvm = njs_vm_clone(vm, NULL);
+            if (nvm == NULL) {
+                nxt_printf("njs_vm_clone() failed\n");
+                goto done;
+            }
+
+            ret = njs_vm_start(nvm);
+
+            if (njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK) {
+                nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+                goto done;
+            }
+
+            /* An unhandled rejection replaces the script result. */
+
+            if (ret == NXT_OK && njs_vm_run(nvm) == NXT_ERROR
+                && njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+            {
+                nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+                goto done;
+            }
+
+        } else {
+            if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
+                nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+                goto done;
+            }
+        }
+
+        success = nxt_strstr_eq(&tests[i].ret, &s);
+
+        if (success) {
+            if (nvm != NULL) {
+                njs_vm_destroy(nvm);
+                nvm = NULL;
+            }
+
+            njs_vm_destroy(vm);
+            vm = NULL;
+
+            continue;
+        }
+
+        nxt_printf("njs(\"%V\")\nexpected: \"%V\"\n     got: \"%V\"\n",
+                   &tests[i].script, &tests[i].ret, &s);
+
+        goto done;
+    }
+
+    rc = NXT_OK;
+
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
+
+    if (vm != NULL) {
+        njs_vm_destroy(vm);
+    }
+
+    return rc;
+}
+
+
+static nxt_int_t
+njs_timezone_optional_test(nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    size_t     size;
+    u_char     buf[16];
+    time_t     clock;
+    struct tm  tm;
+    nxt_int_t  ret;
+
+    /*
+     * Chatham Islands NZ-CHAT time zone.
+     * Standard time: UTC+12:45, Daylight Saving time: UTC+13:45.
+     */
+    (void) putenv((char *) "TZ=Pacific/Chatham");
+    tzset();
+
+    clock = 0;
+    localtime_r(&clock, &tm);
+
+    size = strftime((char *) buf, sizeof(buf), "%z", &tm);
+
+    if (memcmp(buf, "+1245", size) == 0) {
+        ret = njs_unit_test(njs_tz_test, nxt_nitems(njs_tz_test), 0, 0, 0,
+                            disassemble, verbose);
+        if (ret != NXT_OK) {
+            return ret;
+        }
+
+        nxt_printf("njs timezone tests passed\n");
+
+    } else {
+        nxt_printf("njs timezone tests skipped, timezone is unavailable\n");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_regexp_optional_test(nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    int         erroff;
+    pcre        *re1, *re2;
+    njs_ret_t   ret;
+    const char  *errstr;
+
+    /*
+     * pcre-8.21 crashes when it compiles unicode escape codes inside
+     * square brackets when PCRE_UTF8 option is provided.
+     * Catching it in runtime by compiling it without PCRE_UTF8. Normally it
+     * should return NULL and "character value in \u.... sequence is too large"
+     * error string.
+     */
+    re1 = pcre_compile("/[\\u0410]/", PCRE_JAVASCRIPT_COMPAT, &errstr, &erroff,
+                      NULL);
+
+    /*
+     * pcre-7.8 fails to compile unicode escape codes inside square brackets
+     * even when PCRE_UTF8 option is provided.
+     */
+    re2 = pcre_compile("/[\\u0410]/", PCRE_JAVASCRIPT_COMPAT | PCRE_UTF8,
+                       &errstr, &erroff, NULL);
+
+    if (re1 == NULL && re2 != NULL) {
+        ret = njs_unit_test(njs_regexp_test, nxt_nitems(njs_regexp_test), 0, 0,
+                            0, disassemble, verbose);
+        if (ret != NXT_OK) {
+            return ret;
+        }
+
+        nxt_printf("njs unicode regexp tests passed\n");
+
+    } else {
+        nxt_printf("njs unicode regexp tests skipped, libpcre fails\n");
+    }
+
+    if (re1 != NULL) {
+        pcre_free(re1);
+    }
+
+    if (re2 != NULL) {
+        pcre_free(re2);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_vm_json_test(nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    njs_vm_t           *vm;
+    nxt_int_t          ret, rc;
+    nxt_str_t          s, *script;
+    nxt_uint_t         i;
+    nxt_bool_t         success;
+    njs_value_t        args[3];
+    njs_vm_opt_t       options;
+
+    static const nxt_str_t fname = nxt_string("replacer");
+    static const nxt_str_t iname = nxt_string("indent");
+
+    static njs_unit_test_t tests[] = {
+        { nxt_string("'[1, true, \"x\", {\"a\": {}}]'"),
+          nxt_string("[1,true,\"x\",{\"a\":{}}]") },
+        { nxt_string("'{\"a\":{\"b\":1}}'"),
+          nxt_string("{\"a\":{\"b\":1}}") },
+        { nxt_string("'[[[],{}]]'"),
+          nxt_string("[[[],{}]]") },
+        { nxt_string("var indent = 1; '[]'"),
+          nxt_string("[\n \n]") },
+        { nxt_string("function replacer(k, v) {return v}; '{\"a\":{\"b\":1}}'"),
+          nxt_string("{\"a\":{\"b\":1}}") },
+        { nxt_string("function replacer(k, v) {"
+                     "   return (typeof v === 'string') ? undefined : v};"
+                     "'{\"a\":1, \"b\":\"x\"}'"),
+          nxt_string("{\"a\":1}") },
+    };
+
+    vm = NULL;
+
+    rc = NXT_ERROR;
+
+    for (i = 0; i < nxt_nitems(tests); i++) {
+
+        memset(&options, 0, sizeof(njs_vm_opt_t));
+        options.init = 1;
+
+        vm = njs_vm_create(&options);
+        if (vm == NULL) {
+            nxt_printf("njs_vm_create() failed\n");
+            goto done;
+        }
+
+        script = &tests[i].script;
+
+        ret = njs_vm_compile(vm, &script->start,
+                             script->start + script->length);
+
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_compile() failed\n");
+            goto done;
+        }
+
+        ret = njs_vm_start(vm);
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_run() failed\n");
+            goto done;
+        }
+
+        args[0] = *njs_vm_retval(vm);
+
+        ret = njs_vm_json_parse(vm, args, 1);
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_json_parse() failed\n");
+            goto done;
+        }
+
+        args[0] = vm->retval;
+        args[1] = *njs_vm_value(vm, &fname);
+        args[2] = *njs_vm_value(vm, &iname);
+
+        ret = njs_vm_json_stringify(vm, args, 3);
+        if (ret != NXT_OK) {
+            nxt_printf("njs_vm_json_stringify() failed\n");
+            goto done;
+        }
+
+        if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
+            nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+            goto done;
+        }
+
+        success = nxt_strstr_eq(&tests[i].ret, &s);
+
+        if (!success) {
+            nxt_printf("njs_vm_json_test(\"%V\")\n"
+                       "expected: \"%V\"\n     got: \"%V\"\n", script,
+                       &tests[i].ret, &s);
+
+            goto done;
+        }
+
+        njs_vm_destroy(vm);
+        vm = NULL;
+    }
+
+    rc = NXT_OK;
+
+done:
+
+    if (rc == NXT_OK) {
+        nxt_printf("njs_vm_json_test passed\n");
+
+    } else {
+        if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
+            nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+
+        } else {
+            nxt_printf("%V\n", &s);
+        }
+    }
+
+    if (vm != NULL) {
+        njs_vm_destroy(vm);
+    }
+
+    return rc;
 }
 
 
-static njs_external_t  njs_unit_test_r_props[] = {
+static nxt_int_t
+njs_vm_object_alloc_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
+{
+    njs_ret_t    ret;
+    njs_value_t  args[2], obj;
 
-    { nxt_string("a"),
-      NJS_EXTERN_PROPERTY,
-      NULL,
-      0,
-      njs_unit_test_r_get_a_external,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      0 },
+    static const njs_value_t num_key = njs_string("num");
+    static const njs_value_t bool_key = njs_string("bool");
 
-    { nxt_string("b"),
-      NJS_EXTERN_PROPERTY,
-      NULL,
-      0,
-      njs_unit_test_r_get_b_external,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      42 },
-};
+    njs_value_number_set(njs_argument(&args, 0), 1);
+    njs_value_boolean_set(njs_argument(&args, 1), 0);
 
+    ret = njs_vm_object_alloc(vm, &obj, NULL);
+    if (ret != NJS_OK) {
+        return NXT_ERROR;
+    }
 
-static njs_external_t  njs_unit_test_r_external[] = {
+    ret = njs_vm_object_alloc(vm, &obj, &num_key, NULL);
+    if (ret == NJS_OK) {
+        return NXT_ERROR;
+    }
 
-    { nxt_string("uri"),
-      NJS_EXTERN_PROPERTY,
-      NULL,
-      0,
-      njs_unit_test_r_get_uri_external,
-      njs_unit_test_r_set_uri_external,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      offsetof(njs_unit_test_req_t, uri) },
+    ret = njs_vm_object_alloc(vm, &obj, &num_key, &args[0], NULL);
+    if (ret != NJS_OK) {
+        return NXT_ERROR;
+    }
 
-    { nxt_string("host"),
-      NJS_EXTERN_PROPERTY,
-      NULL,
-      0,
-      njs_unit_test_host_external,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      0 },
+    ret = njs_vm_object_alloc(vm, &obj, &num_key, &args[0], &bool_key,
+                              &args[1], NULL);
+    if (ret != NJS_OK) {
+        return NXT_ERROR;
+    }
 
-    { nxt_string("props"),
-      NJS_EXTERN_OBJECT,
-      njs_unit_test_r_props,
-      nxt_nitems(njs_unit_test_r_props),
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      0 },
+    return NXT_OK;
+}
 
-    { nxt_string("vars"),
-      NJS_EXTERN_OBJECT,
-      NULL,
-      0,
-      njs_unit_test_r_get_vars,
-      njs_unit_test_r_set_vars,
-      njs_unit_test_r_del_vars,
-      NULL,
-      NULL,
-      NULL,
-      0 },
 
-    { nxt_string("consts"),
-      NJS_EXTERN_OBJECT,
-      NULL,
-      0,
-      njs_unit_test_r_get_vars,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      0 },
+static nxt_int_t
+njs_vm_array_alloc_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
+{
+    uint32_t     length;
+    nxt_str_t    s;
+    njs_ret_t    ret;
+    njs_value_t  array, entry, *slot;
 
-    { nxt_string("header"),
-      NJS_EXTERN_OBJECT,
-      NULL,
-      0,
-      njs_unit_test_header_external,
-      NULL,
-      NULL,
-      njs_unit_test_header_foreach_external,
-      njs_unit_test_header_next_external,
-      NULL,
-      0 },
+    static const nxt_str_t  expected = nxt_string("b");
 
-    { nxt_string("some_method"),
-      NJS_EXTERN_METHOD,
-      NULL,
-      0,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      njs_unit_test_method_external,
-      0 },
+    ret = njs_vm_array_alloc(vm, &array, 2);
+    if (ret != NJS_OK) {
+        return NXT_ERROR;
+    }
 
-    { nxt_string("create"),
-      NJS_EXTERN_METHOD,
-      NULL,
-      0,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      njs_unit_test_create_external,
-      0 },
+    slot = njs_vm_array_push(vm, &array);
+    if (slot == NULL) {
+        return NXT_ERROR;
+    }
+
+    njs_value_number_set(slot, 1);
+
+    ret = njs_vm_array_alloc(vm, &entry, 0);
+    if (ret != NJS_OK) {
+        return NXT_ERROR;
+    }
+
+    slot = njs_vm_array_push(vm, &entry);
+    if (slot == NULL
+        || njs_vm_value_string_set(vm, slot, (u_char *) "a", 1) != NJS_OK)
+    {
+        return NXT_ERROR;
+    }
+
+    slot = njs_vm_array_push(vm, &entry);
+    if (slot == NULL
+        || njs_vm_value_string_set(vm, slot, (u_char *) "b", 1) != NJS_OK)
+    {
+        return NXT_ERROR;
+    }
+
+    slot = njs_vm_array_push(vm, &array);
+    if (slot == NULL) {
+        return NXT_ERROR;
+    }
+
+    *slot = entry;
+
+    if (njs_vm_array_push(vm, njs_value_arg(&njs_value_undefined)) != NULL) {
+        return NXT_ERROR;
+    }
+
+    if (!njs_value_is_array(&array)
+        || njs_vm_array_length(vm, &array, &length) != NJS_OK
+        || length != 2)
+    {
+        return NXT_ERROR;
+    }
+
+    slot = njs_vm_array_start(vm, &array);
+    if (slot == NULL || njs_value_number(&slot[0]) != 1) {
+        return NXT_ERROR;
+    }
+
+    slot = njs_vm_array_start(vm, &slot[1]);
+    if (slot == NULL) {
+        return NXT_ERROR;
+    }
+
+    njs_string_get(&slot[1], &s);
+
+    if (!nxt_strstr_eq(&expected, &s)) {
+        nxt_printf("njs_vm_array_alloc_test:\n"
+                   "expected: \"%V\"\n     got: \"%V\"\n", &expected, &s);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+njs_vm_freeze_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
+{
+    u_char          *start;
+    nxt_str_t       s;
+    nxt_int_t       ret;
+    njs_vm_t        *worker, *nvm;
+    nxt_uint_t      i;
+    njs_function_t  *function;
+
+    static const nxt_str_t  init = nxt_string("init");
+    static const nxt_str_t  check = nxt_string("check");
+
+    static const nxt_str_t  script = nxt_string(
+        "var counter = 0; var table = {a:[1,2,3]};"
+        "function init() {"
+        "    counter = 10; table.n = 42; table.s = 'x'.repeat(40);"
+        "    table.o = {f: function(v) { return v * 2 }};"
+        "    table.u = new Uint8Array([7]); table.d = new DataView(table.u.buffer);"
+        "    table.m = new Map([['k', {v:1}]]);"
+        "    for (var i = 0; i < 20; i++) { table.m.set(i, i) }"
+        "    table.e = new Set(['a']);"
+        "    table.g = /a/g; table.g.exec('aa'); table.q = /b/; table.t = new Date(0)"
+        "}"
+        "function check() {"
+        "    var r = [table.n, table.a.length, table.s.length, table.o.f(2)];"
+        "    try { table.a.push(4) } catch (e) { r.push(e.message) }"
+        "    try { table.n = 1 } catch (e) { r.push(e.name) }"
+        "    try { table.x = 1 } catch (e) { r.push(e.name) }"
+        "    try { delete table.a } catch (e) { r.push(e.name) }"
+        "    r.push(++counter, table.n, Object.isFrozen(table.o.f));"
+        "    try { table.u[0]++ } catch (e) { r.push(e.name) }"
+        "    try { table.u.fill(1) } catch (e) { r.push(e.message) }"
+        "    try { table.d.setUint8(0, 1) } catch (e) { r.push(e.name) }"
+        "    r.push(table.u[0], Object.isFrozen(Object.prototype));"
+        "    for (var i = 20; i < 40; i++) {"
+        "        try { table.m.set(i, i) } catch (e) { r.push(e.message); break }"
+        "    }"
+        "    try { table.m.delete('k') } catch (e) { r.push(e.name) }"
+        "    try { table.m.clear() } catch (e) { r.push(e.name) }"
+        "    try { table.e.add('b') } catch (e) { r.push(e.message) }"
+        "    try { table.m.get('k').v = 2 } catch (e) { r.push(e.name) }"
+        "    r.push(table.m.size, table.m.get('k').v, table.e.has('a'));"
+        "    try { table.o.__proto__ = {p: 1} } catch (e) { r.push(e.message) }"
+        "    try { table.g.exec('aaa') } catch (e) { r.push(e.message) }"
+        "    r.push(table.g.lastIndex, 'aa'.match(table.g).length);"
+        "    var m = table.q.exec('abc' + counter);"
+        "    r.push(m.index, m.input, table.q.lastIndex);"
+        "    try { table.t.setTime(counter * 1000) } catch (e) { r.push(e.message) }"
+        "    try { table.t.setUTCHours(1) } catch (e) { r.push(e.name) }"
+        "    r.push(table.o.p, table.t.getTime());"
+        "    return r.join('|')"
+        "}");
+
+    static const nxt_str_t  expected = nxt_string(
+        "42|3|40|4|Cannot modify a frozen array|TypeError|TypeError|TypeError"
+        "|11|42|true|TypeError|the ArrayBuffer is frozen|TypeError|7|false"
+        "|Cannot modify a frozen Map|TypeError|TypeError"
+        "|Cannot modify a frozen Set|TypeError|21|1|true"
+        "|Cannot set __proto__ of non-extensible object"
+        "|Cannot modify a frozen RegExp|1|2|1|abc11|0"
+        "|Cannot modify a frozen Date|TypeError||0");
+
+    worker = NULL;
+    nvm = NULL;
+    ret = NXT_ERROR;
+
+    start = script.start;
+
+    if (njs_vm_compile(vm, &start, start + script.length) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    worker = njs_vm_clone(vm, NULL);
+    if (worker == NULL || njs_vm_start(worker) != NXT_OK) {
+        goto done;
+    }
+
+    function = njs_vm_function(worker, &init);
+    if (function == NULL || njs_vm_call(worker, function, NULL, 0) != NXT_OK) {
+        goto done;
+    }
+
+    if (njs_vm_freeze(worker) != NXT_OK) {
+        goto done;
+    }
+
+    for (i = 0; i < 2; i++) {
+        nvm = njs_vm_clone(worker, NULL);
+        if (nvm == NULL || njs_vm_start(nvm) != NXT_OK) {
+            goto done;
+        }
+
+        function = njs_vm_function(nvm, &check);
+        if (function == NULL) {
+            goto done;
+        }
+
+        if (njs_vm_call(nvm, function, NULL, 0) != NXT_OK
+            || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+        {
+            goto done;
+        }
+
+        if (!nxt_strstr_eq(&expected, &s)) {
+            nxt_printf("njs_vm_freeze_test:\n"
+                       "expected: \"%V\"\n     got: \"%V\"\n", &expected, &s);
+            goto done;
+        }
+
+        njs_vm_destroy(nvm);
+        nvm = NULL;
+    }
+
+    ret = NXT_OK;
+
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
+
+    if (worker != NULL) {
+        njs_vm_destroy(worker);
+    }
+
+    return ret;
+}
+
+
+static nxt_int_t
+njs_vm_gc_test(njs_vm_t * vm, nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    u_char            *start;
+    nxt_str_t         s;
+    nxt_int_t         ret;
+    njs_vm_t          *parent, *nvm;
+    nxt_uint_t        i, n;
+    njs_vm_opt_t      options;
+    njs_function_t    *step, *check;
+    nxt_queue_link_t  *link;
+
+    static const nxt_str_t  step_name = nxt_string("step");
+    static const nxt_str_t  check_name = nxt_string("check");
+
+    static const nxt_str_t  script = nxt_string(
+        "var n = 0, last, ring = [], resolve, settled;"
+        "var hold = (function(v) { return function() { return v } })"
+        "           ('c'.repeat(50));"
+        "function step() {"
+        "    var s = 'x'.repeat(1000) + n;"
+        "    last = s.toUpperCase().slice(980);"
+        "    ring[n % 4] = 'r'.repeat(20) + n;"
+        "    if (n % 100 == 0) {"
+        "        var tag = 't'.repeat(30) + n;"
+        "        if (resolve) { resolve('v'.repeat(20) + n) }"
+        "        new Promise(function(r) { resolve = r })"
+        "        .then(function(v) { settled = v + tag });"
+        "    }"
+        "    n++;"
+        "}"
+        "function check() {"
+        "    return [last, ring.join(','), hold(), settled].join('|')"
+        "}");
+
+    static const nxt_str_t  expected = nxt_string(
+        "XXXXXXXXXXXXXXXXXXXX999|"
+        "rrrrrrrrrrrrrrrrrrrr996,rrrrrrrrrrrrrrrrrrrr997,"
+        "rrrrrrrrrrrrrrrrrrrr998,rrrrrrrrrrrrrrrrrrrr999|"
+        "cccccccccccccccccccccccccccccccccccccccccccccccccc|"
+        "vvvvvvvvvvvvvvvvvvvv900tttttttttttttttttttttttttttttt800");
+
+    nvm = NULL;
+    ret = NXT_ERROR;
+
+    nxt_memzero(&options, sizeof(njs_vm_opt_t));
+
+    options.gc = 1;
+
+    parent = njs_vm_create(&options);
+    if (parent == NULL) {
+        return NXT_ERROR;
+    }
+
+    start = script.start;
+
+    if (njs_vm_compile(parent, &start, start + script.length) != NXT_OK) {
+        goto done;
+    }
 
-};
+    nvm = njs_vm_clone(parent, NULL);
+    if (nvm == NULL || njs_vm_start(nvm) != NXT_OK) {
+        goto done;
+    }
 
+    step = njs_vm_function(nvm, &step_name);
+    check = njs_vm_function(nvm, &check_name);
 
-static njs_external_t  nxt_test_external[] = {
+    if (step == NULL || check == NULL) {
+        goto done;
+    }
 
-    { nxt_string("request.proto"),
-      NJS_EXTERN_OBJECT,
-      njs_unit_test_r_external,
-      nxt_nitems(njs_unit_test_r_external),
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      0 },
+    for (i = 0; i < 1000; i++) {
+        if (njs_vm_call(nvm, step, NULL, 0) != NXT_OK
+            || njs_vm_run(nvm) == NXT_ERROR)
+        {
+            goto done;
+        }
+    }
 
-};
+    if (njs_vm_gc(nvm) != NXT_OK) {
+        goto done;
+    }
 
+    n = 0;
 
-typedef struct {
-    nxt_str_t            name;
-    njs_unit_test_req_t  request;
-    njs_unit_test_prop_t props[2];
-} njs_unit_test_req_t_init_t;
+    for (link = nxt_queue_first(&nvm->gc_items);
+         link != nxt_queue_tail(&nvm->gc_items);
+         link = nxt_queue_next(link))
+    {
+        n++;
+    }
 
+    if (n > 100) {
+        nxt_printf("njs_vm_gc_test: %ui values are not collected\n", n);
+        goto done;
+    }
 
-static const njs_unit_test_req_t_init_t nxt_test_requests[] = {
+    if (njs_vm_call(nvm, check, NULL, 0) != NXT_OK
+        || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+    {
+        goto done;
+    }
 
-    { nxt_string("$r"),
-     {
-         .uri = nxt_string("АБВ"),
-         .a = 1
-     },
-     {
-         { njs_string("p"), njs_string("pval") },
-         { njs_string("p2"), njs_string("p2val") },
-     }
-    },
+    if (!nxt_strstr_eq(&expected, &s)) {
+        nxt_printf("njs_vm_gc_test:\n"
+                   "expected: \"%V\"\n     got: \"%V\"\n", &expected, &s);
+        goto done;
+    }
 
-    { nxt_string("$r2"),
-     {
-         .uri = nxt_string("αβγ"),
-         .a = 2
-     },
-     {
-         { njs_string("q"), njs_string("qval") },
-         { njs_string("q2"), njs_string("q2val") },
-     }
-    },
+    ret = NXT_OK;
 
-    { nxt_string("$r3"),
-     {
-         .uri = nxt_string("abc"),
-         .a = 3
-     },
-     {
-         { njs_string("k"), njs_string("kval") },
-         { njs_string("k2"), njs_string("k2val") },
-     }
-    },
-};
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
+
+    njs_vm_destroy(parent);
+
+    return ret;
+}
 
 
 static nxt_int_t
-njs_externals_init(njs_vm_t *vm)
+njs_vm_gc_stress_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
 {
-    nxt_int_t             ret;
-    nxt_uint_t            i, j;
-    const njs_extern_t    *proto;
-    njs_unit_test_req_t   *requests;
-    njs_unit_test_prop_t  *prop;
+    u_char            *start;
+    nxt_str_t         s;
+    nxt_int_t         ret;
+    njs_vm_t          *parent, *nvm;
+    nxt_uint_t        i, n;
+    njs_vm_opt_t      options;
+    njs_function_t    *step, *check;
+    nxt_queue_link_t  *link;
+
+    static const nxt_str_t  step_name = nxt_string("step");
+    static const nxt_str_t  check_name = nxt_string("check");
+    static const nxt_str_t  ok = nxt_string("ok");
+
+    static const nxt_str_t  script = nxt_string(
+        "var n = 0, keep = {}, list = [], hold = [], objs = [];"
+        "function make(i) { return ('k' + i + ':').repeat(10) }"
+        "function step() {"
+        "    var t = '';"
+        "    for (var j = 0; j < 20; j++) { t += make(n + j) }"
+        "    t = t.split(':').join(';').replace(/k/g, 'K');"
+        "    keep['p' + n % 8] = make(n);"
+        "    objs[n % 8] = {a: [make(n), {s: make(n)}], o: {p: {q: make(n)}}};"
+        "    objs[n % 8].o[make(n)] = new Array(64).fill(n);"
+        "    list[n % 8] = JSON.stringify({v: make(n), t: t.slice(-30)});"
+        "    hold[n % 8] = (function(v) { return function() { return v } })"
+        "                  (make(n));"
+        "    return t.slice(0, 20) + n++;"
+        "}"
+        "function check() {"
+        "    for (var i = n - 8; i < n; i++) {"
+        "        var v = make(i), o = JSON.parse(list[i % 8]);"
+        "        var x = objs[i % 8];"
+        "        if (x.a[0] !== v || x.a[1].s !== v || x.o.p.q !== v"
+        "            || x.o[v].length != 64 || x.o[v][63] !== i)"
+        "        {"
+        "            return 'object failed at ' + i;"
+        "        }"
+        "        if (keep['p' + i % 8] !== v || o.v !== v || hold[i % 8]() !== v"
+        "            || o.t !== make(i + 19).split(':').join(';')"
+        "                        .replace(/k/g, 'K').slice(-30))"
+        "        {"
+        "            return 'failed at ' + i;"
+        "        }"
+        "    }"
+        "    return 'ok';"
+        "}");
 
-    proto = njs_vm_external_prototype(vm, &nxt_test_external[0]);
-    if (proto == NULL) {
-        nxt_printf("njs_vm_external_prototype() failed\n");
+    nvm = NULL;
+    ret = NXT_ERROR;
+
+    nxt_memzero(&options, sizeof(njs_vm_opt_t));
+
+    options.gc = 1;
+
+    parent = njs_vm_create(&options);
+    if (parent == NULL) {
         return NXT_ERROR;
     }
 
-    requests = nxt_mp_zalloc(vm->mem_pool,
-                             nxt_nitems(nxt_test_requests)
-                             * sizeof(njs_unit_test_req_t));
-    if (requests == NULL) {
-        return NXT_ERROR;
+    start = script.start;
+
+    if (njs_vm_compile(parent, &start, start + script.length) != NXT_OK) {
+        goto done;
     }
 
-    for (i = 0; i < nxt_nitems(nxt_test_requests); i++) {
+    nvm = njs_vm_clone(parent, NULL);
+    if (nvm == NULL || njs_vm_start(nvm) != NXT_OK) {
+        goto done;
+    }
 
-        requests[i] = nxt_test_requests[i].request;
-        requests[i].pool = vm->mem_pool;
-        requests[i].proto = proto;
+    step = njs_vm_function(nvm, &step_name);
+    check = njs_vm_function(nvm, &check_name);
 
-        ret = njs_vm_external_create(vm, njs_value_arg(&requests[i].value),
-                                     proto, &requests[i]);
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_external_create() failed\n");
-            return NXT_ERROR;
-        }
+    if (step == NULL || check == NULL) {
+        goto done;
+    }
 
-        ret = njs_vm_external_bind(vm, &nxt_test_requests[i].name,
-                                   njs_value_arg(&requests[i].value));
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_external_bind() failed\n");
-            return NXT_ERROR;
+    /*
+     * The strings are collected after each step, so a string
+     * reclaimed while still referenced is reported by the check.
+     */
+
+    for (i = 1; i <= 1000; i++) {
+        if (njs_vm_call(nvm, step, NULL, 0) != NXT_OK
+            || njs_vm_run(nvm) == NXT_ERROR
+            || njs_vm_gc(nvm) != NXT_OK)
+        {
+            goto done;
         }
 
-        for (j = 0; j < nxt_nitems(nxt_test_requests[i].props); j++) {
-            prop = lvlhsh_unit_test_alloc(vm->mem_pool,
-                                          &nxt_test_requests[i].props[j].name,
-                                          &nxt_test_requests[i].props[j].value);
+        if (i % 100 != 0) {
+            continue;
+        }
 
-            if (prop == NULL) {
-                nxt_printf("lvlhsh_unit_test_alloc() failed\n");
-                return NXT_ERROR;
-            }
+        if (njs_vm_call(nvm, check, NULL, 0) != NXT_OK
+            || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+        {
+            goto done;
+        }
 
-            ret = lvlhsh_unit_test_add(&requests[i], prop);
-            if (ret != NXT_OK) {
-                nxt_printf("lvlhsh_unit_test_add() failed\n");
-                return NXT_ERROR;
-            }
+        if (!nxt_strstr_eq(&ok, &s)) {
+            nxt_printf("njs_vm_gc_stress_test: step %ui: \"%V\"\n", i, &s);
+            goto done;
         }
     }
 
-    return NXT_OK;
+    n = 0;
+
+    for (link = nxt_queue_first(&nvm->gc_items);
+         link != nxt_queue_tail(&nvm->gc_items);
+         link = nxt_queue_next(link))
+    {
+        n++;
+    }
+
+    /* About 180 strings, objects and arrays are reachable. */
+
+    if (n > 250) {
+        nxt_printf("njs_vm_gc_stress_test: %ui values are not collected\n",
+                   n);
+        goto done;
+    }
+
+    ret = NXT_OK;
+
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
+
+    njs_vm_destroy(parent);
+
+    return ret;
 }
 
 
 static nxt_int_t
-njs_unit_test(njs_unit_test_t tests[], size_t num, nxt_bool_t module,
-    nxt_bool_t disassemble, nxt_bool_t verbose)
+njs_vm_refcount_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
 {
     u_char        *start;
-    njs_vm_t      *vm, *nvm;
-    nxt_int_t     ret, rc;
+    njs_vm_t      *parent, *nvm;
     nxt_str_t     s;
-    nxt_uint_t    i;
-    nxt_bool_t    success;
+    nxt_int_t     ret;
+    nxt_uint_t    gc;
     njs_vm_opt_t  options;
 
-    vm = NULL;
+    /*
+     * About 300M bytes of temporary strings are built and dropped
+     * within the 1M bytes memory limit, the strings which are still
+     * referenced are checked.
+     */
+
+    static const nxt_str_t  script = nxt_string(
+        "var chunk = 'abcdefgh'.repeat(128), keep = [], obj = {}, c = '';"
+        "function grow(n) {"
+        "    var s = '', t;"
+        "    for (var i = 0; i < n; i++) { t = s; s = t + chunk }"
+        "    return s;"
+        "}"
+        "function outer() {"
+        "    var v = '';"
+        "    function f() { v = v + chunk; return v.length }"
+        "    for (var i = 0; i < 16; i++) { f() }"
+        "    var r = v.length;"
+        "    v = '';"
+        "    return r;"
+        "}"
+        "function check(k) {"
+        "    var e = chunk + k;"
+        "    try { if (k % 100 == 0) { throw e } }"
+        "    catch (x) { return x === chunk + k }"
+        "    return e.length == chunk.length + String(k).length;"
+        "}"
+        "function run() {"
+        "    var n = 0, t, u;"
+        "    for (var k = 0; k < 1000; k++) {"
+        "        n += grow(16).length + outer();"
+        "        t = chunk + k; u = t; t = u + chunk;"
+        "        c = c + k; c = '' + k + chunk;"
+        "        if (!check(k)) { return 'check failed at ' + k }"
+        "        if (k % 100 == 0) { keep.push(t); obj['p' + k] = u + k }"
+        "    }"
+        "    for (k = 0; k < 1000; k += 100) {"
+        "        if (keep[k / 100] !== chunk + k + chunk"
+        "            || obj['p' + k] !== chunk + k + k)"
+        "        {"
+        "            return 'failed at ' + k;"
+        "        }"
+        "    }"
+        "    return n + ' ' + c.length + ' ' + grow(300).length;"
+        "}"
+        "run()");
+
+    static const nxt_str_t  expected = nxt_string("32768000 1027 307200");
+
     nvm = NULL;
+    parent = NULL;
+    ret = NXT_ERROR;
 
-    rc = NXT_ERROR;
+    for (gc = 0; gc < 2; gc++) {
+        nxt_memzero(&options, sizeof(njs_vm_opt_t));
 
-    for (i = 0; i < num; i++) {
+        options.gc = gc;
 
-        if (verbose) {
-            nxt_printf("\"%V\"\n", &tests[i].script);
+        parent = njs_vm_create(&options);
+        if (parent == NULL) {
+            goto done;
         }
 
-        nxt_memzero(&options, sizeof(njs_vm_opt_t));
+        start = script.start;
 
-        options.module = module;
+        if (njs_vm_compile(parent, &start, start + script.length) != NXT_OK) {
+            goto done;
+        }
 
-        vm = njs_vm_create(&options);
-        if (vm == NULL) {
-            nxt_printf("njs_vm_create() failed\n");
+        nvm = njs_vm_clone(parent, NULL);
+        if (nvm == NULL) {
             goto done;
         }
 
-        ret = njs_externals_init(vm);
-        if (ret != NXT_OK) {
+        njs_vm_memory_limit(nvm, 1024 * 1024);
+
+        (void) njs_vm_start(nvm);
+
+        if (njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK) {
             goto done;
         }
 
-        start = tests[i].script.start;
+        if (!nxt_strstr_eq(&expected, &s)) {
+            nxt_printf("njs_vm_refcount_test(gc: %ui):\n"
+                       "expected: \"%V\"\n     got: \"%V\"\n",
+                       gc, &expected, &s);
+            goto done;
+        }
 
-        ret = njs_vm_compile(vm, &start, start + tests[i].script.length);
+        njs_vm_destroy(nvm);
+        nvm = NULL;
 
-        if (ret == NXT_OK) {
-            if (disassemble) {
-                njs_disassembler(vm);
-            }
+        njs_vm_destroy(parent);
+        parent = NULL;
+    }
 
-            nvm = njs_vm_clone(vm, NULL);
-            if (nvm == NULL) {
-                nxt_printf("njs_vm_clone() failed\n");
-                goto done;
-            }
+    ret = NXT_OK;
 
-            ret = njs_vm_start(nvm);
+done:
 
-            if (njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK) {
-                nxt_printf("njs_vm_retval_to_ext_string() failed\n");
-                goto done;
-            }
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
 
-        } else {
-            if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
-                nxt_printf("njs_vm_retval_to_ext_string() failed\n");
-                goto done;
-            }
-        }
+    if (parent != NULL) {
+        njs_vm_destroy(parent);
+    }
 
-        success = nxt_strstr_eq(&tests[i].ret, &s);
+    return ret;
+}
 
-        if (success) {
-            if (nvm != NULL) {
-                njs_vm_destroy(nvm);
-                nvm = NULL;
-            }
 
-            njs_vm_destroy(vm);
-            vm = NULL;
+static nxt_int_t
+njs_vm_arena_test(njs_vm_t * vm, nxt_bool_t disassemble, nxt_bool_t verbose)
+{
+    u_char         *start;
+    njs_vm_t       *parent, *nvm;
+    nxt_str_t      s;
+    nxt_int_t      ret;
+    nxt_uint_t     i;
+    njs_vm_opt_t   options;
+    nxt_mp_stat_t  stat;
+
+    static const nxt_str_t  script = nxt_string(
+        "function f(n) { return n > 1 ? f(n - 1) + f(n - 2) : 'ab'.repeat(n) }"
+        "var a = [], o = {};"
+        "for (var i = 0; i < 1000; i++) { a.push(i); o['p' + i] = i }"
+        "[f(12).length, a.length, Object.keys(o).length,"
+        " JSON.stringify(a).length].join()");
+
+    static const nxt_str_t  expected = nxt_string("288,1000,1000,3891");
 
-            continue;
+    nvm = NULL;
+    ret = NXT_ERROR;
+
+    nxt_memzero(&options, sizeof(njs_vm_opt_t));
+
+    options.arena = 1;
+
+    parent = njs_vm_create(&options);
+    if (parent == NULL) {
+        return NXT_ERROR;
+    }
+
+    start = script.start;
+
+    if (njs_vm_compile(parent, &start, start + script.length) != NXT_OK) {
+        goto done;
+    }
+
+    for (i = 0; i < 2; i++) {
+        nvm = njs_vm_clone(parent, NULL);
+        if (nvm == NULL
+            || njs_vm_start(nvm) != NXT_OK
+            || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+        {
+            goto done;
         }
 
-        nxt_printf("njs(\"%V\")\nexpected: \"%V\"\n     got: \"%V\"\n",
-                   &tests[i].script, &tests[i].ret, &s);
+        if (!nxt_strstr_eq(&expected, &s)) {
+            nxt_printf("njs_vm_arena_test:\n"
+                       "expected: \"%V\"\n     got: \"%V\"\n", &expected, &s);
+            goto done;
+        }
+
+        njs_vm_memory_stats(nvm, &stat);
+
+        if (stat.allocations == 0 || stat.size == 0) {
+            nxt_printf("njs_vm_arena_test: no allocations\n");
+            goto done;
+        }
 
-        goto done;
+        njs_vm_destroy(nvm);
+        nvm = NULL;
     }
 
-    rc = NXT_OK;
+    ret = NXT_OK;
 
 done:
 
@@ -13827,260 +15969,373 @@ done:
         njs_vm_destroy(nvm);
     }
 
-    if (vm != NULL) {
-        njs_vm_destroy(vm);
-    }
+    njs_vm_destroy(parent);
 
-    return rc;
+    return ret;
 }
 
 
 static nxt_int_t
-njs_timezone_optional_test(nxt_bool_t disassemble, nxt_bool_t verbose)
+njs_vm_memory_limit_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
 {
-    size_t     size;
-    u_char     buf[16];
-    time_t     clock;
-    struct tm  tm;
-    nxt_int_t  ret;
+    u_char         *start;
+    size_t         limit;
+    njs_vm_t       *parent, *nvm;
+    nxt_str_t      s;
+    nxt_int_t      ret;
+    nxt_uint_t     i, arena;
+    njs_vm_opt_t   options;
+    nxt_mp_stat_t  stat;
+
+    static const njs_unit_test_t  tests[] = {
+        { nxt_string("var r, a = [];"
+                     "try { for (;;) { a.push('x'.repeat(100) + a.length) } }"
+                     "catch (e) { a = null; r = String(e) } r"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("var r, s = '';"
+                     "try { for (;;) { s += 'xyz'.repeat(50) } }"
+                     "catch (e) { s = null; r = String(e) } r"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("var r, o = {};"
+                     "try { for (var i = 0;; i++) { o['k' + i] = {v: i} } }"
+                     "catch (e) { o = null; r = String(e) } r"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("var r, a = [], t = '{\"a\": [1, \"' + 'x'.repeat(40) + '\"]}';"
+                     "try { for (;;) {"
+                     "    a.push(JSON.parse(t), JSON.parse('{\"k' + a.length + '\": 1}'))"
+                     "} } catch (e) { a = null; r = String(e) } r"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("var r;"
+                     "try { 'x'.repeat(1000000) }"
+                     "catch (e) { r = String(e) } r"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("'x'.repeat(1000000)"),
+          nxt_string("MemoryError") },
+
+        { nxt_string("'x'.repeat(1000).length"),
+          nxt_string("1000") },
+    };
+
+    nvm = NULL;
+    parent = NULL;
+    ret = NXT_ERROR;
 
     /*
-     * Chatham Islands NZ-CHAT time zone.
-     * Standard time: UTC+12:45, Daylight Saving time: UTC+13:45.
+     * The limit is exceeded at different allocations depending on
+     * the limit value, so several values are tried.
      */
-    (void) putenv((char *) "TZ=Pacific/Chatham");
-    tzset();
 
-    clock = 0;
-    localtime_r(&clock, &tm);
+    for (limit = 192 * 1024; limit <= 320 * 1024; limit += 8 * 1024) {
+        for (arena = 0; arena < 2; arena++) {
+            for (i = 0; i < nxt_nitems(tests); i++) {
+                nxt_memzero(&options, sizeof(njs_vm_opt_t));
 
-    size = strftime((char *) buf, sizeof(buf), "%z", &tm);
+                options.arena = arena;
 
-    if (memcmp(buf, "+1245", size) == 0) {
-        ret = njs_unit_test(njs_tz_test, nxt_nitems(njs_tz_test), 0,
-                            disassemble, verbose);
-        if (ret != NXT_OK) {
-            return ret;
-        }
+                parent = njs_vm_create(&options);
+                if (parent == NULL) {
+                    goto done;
+                }
 
-        nxt_printf("njs timezone tests passed\n");
+                start = tests[i].script.start;
 
-    } else {
-        nxt_printf("njs timezone tests skipped, timezone is unavailable\n");
-    }
+                if (njs_vm_compile(parent, &start,
+                                   start + tests[i].script.length)
+                    != NXT_OK)
+                {
+                    goto done;
+                }
 
-    return NXT_OK;
-}
+                nvm = njs_vm_clone(parent, NULL);
+                if (nvm == NULL) {
+                    goto done;
+                }
 
+                njs_vm_memory_limit(nvm, limit);
 
-static nxt_int_t
-njs_regexp_optional_test(nxt_bool_t disassemble, nxt_bool_t verbose)
-{
-    int         erroff;
-    pcre        *re1, *re2;
-    njs_ret_t   ret;
-    const char  *errstr;
+                (void) njs_vm_start(nvm);
 
-    /*
-     * pcre-8.21 crashes when it compiles unicode escape codes inside
-     * square brackets when PCRE_UTF8 option is provided.
-     * Catching it in runtime by compiling it without PCRE_UTF8. Normally it
-     * should return NULL and "character value in \u.... sequence is too large"
-     * error string.
-     */
-    re1 = pcre_compile("/[\\u0410]/", PCRE_JAVASCRIPT_COMPAT, &errstr, &erroff,
-                      NULL);
+                if (njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK) {
+                    goto done;
+                }
 
-    /*
-     * pcre-7.8 fails to compile unicode escape codes inside square brackets
-     * even when PCRE_UTF8 option is provided.
-     */
-    re2 = pcre_compile("/[\\u0410]/", PCRE_JAVASCRIPT_COMPAT | PCRE_UTF8,
-                       &errstr, &erroff, NULL);
+                if (!nxt_strstr_eq(&tests[i].ret, &s)) {
+                    nxt_printf("njs_vm_memory_limit_test(\"%V\", %uz)\n"
+                               "expected: \"%V\"\n     got: \"%V\"\n",
+                               &tests[i].script, limit, &tests[i].ret, &s);
+                    goto done;
+                }
 
-    if (re1 == NULL && re2 != NULL) {
-        ret = njs_unit_test(njs_regexp_test, nxt_nitems(njs_regexp_test), 0,
-                            disassemble, verbose);
-        if (ret != NXT_OK) {
-            return ret;
-        }
+                njs_vm_memory_stats(nvm, &stat);
 
-        nxt_printf("njs unicode regexp tests passed\n");
+                if (stat.peak < stat.size || stat.peak > limit + 32 * 1024) {
+                    nxt_printf("njs_vm_memory_limit_test(\"%V\", %uz): "
+                               "size: %uz, peak: %uz\n",
+                               &tests[i].script, limit, stat.size, stat.peak);
+                    goto done;
+                }
 
-    } else {
-        nxt_printf("njs unicode regexp tests skipped, libpcre fails\n");
+                njs_vm_destroy(nvm);
+                nvm = NULL;
+
+                njs_vm_destroy(parent);
+                parent = NULL;
+            }
+        }
     }
 
-    if (re1 != NULL) {
-        pcre_free(re1);
+    ret = NXT_OK;
+
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
     }
 
-    if (re2 != NULL) {
-        pcre_free(re2);
+    if (parent != NULL) {
+        njs_vm_destroy(parent);
     }
 
-    return NXT_OK;
+    return ret;
 }
 
 
 static nxt_int_t
-njs_vm_json_test(nxt_bool_t disassemble, nxt_bool_t verbose)
+njs_vm_execution_limit_test(njs_vm_t * vm, nxt_bool_t disassemble,
+    nxt_bool_t verbose)
 {
-    njs_vm_t           *vm;
-    nxt_int_t          ret, rc;
-    nxt_str_t          s, *script;
-    nxt_uint_t         i;
-    nxt_bool_t         success;
-    njs_value_t        args[3];
-    njs_vm_opt_t       options;
-
-    static const nxt_str_t fname = nxt_string("replacer");
-    static const nxt_str_t iname = nxt_string("indent");
+    u_char        *start;
+    njs_vm_t      *parent, *nvm;
+    nxt_str_t     s;
+    nxt_int_t     ret;
+    nxt_uint_t    i;
+    njs_vm_opt_t  options;
 
-    static njs_unit_test_t tests[] = {
-        { nxt_string("'[1, true, \"x\", {\"a\": {}}]'"),
-          nxt_string("[1,true,\"x\",{\"a\":{}}]") },
-        { nxt_string("'{\"a\":{\"b\":1}}'"),
-          nxt_string("{\"a\":{\"b\":1}}") },
-        { nxt_string("'[[[],{}]]'"),
-          nxt_string("[[[],{}]]") },
-        { nxt_string("var indent = 1; '[]'"),
-          nxt_string("[\n \n]") },
-        { nxt_string("function replacer(k, v) {return v}; '{\"a\":{\"b\":1}}'"),
-          nxt_string("{\"a\":{\"b\":1}}") },
-        { nxt_string("function replacer(k, v) {"
-                     "   return (typeof v === 'string') ? undefined : v};"
-                     "'{\"a\":1, \"b\":\"x\"}'"),
-          nxt_string("{\"a\":1}") },
+    static const struct {
+        nxt_str_t   script;
+        nxt_uint_t  instructions;
+        nxt_uint_t  timeout;
+        nxt_str_t   ret;
+    } tests[] = {
+        { nxt_string("var s = 0; for (var i = 0; i < 1000; i++) { s += i } s"),
+          100000, 0,
+          nxt_string("499500") },
+
+        { nxt_string("for (;;) {}"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("function f() { f() } f()"),
+          1000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("function f(n) { return n ? f(n - 1) + 1 : 0 }"
+                     "var r; for (;;) { r = f(10) }"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("var r = 'done';"
+                     "try { for (;;) {} } catch (e) { r = 'caught' }"
+                     "finally { r = 'finally' } r"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("[1, 2, 3].map(function(v) { for (;;) {} })"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("var o = {valueOf: function() { for (;;) {} }}; o + 1"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("var o = {toString: function() { for (;;) {} }};"
+                     "String(o)"),
+          100000, 0,
+          nxt_string("InternalError: instructions limit exceeded") },
+
+        { nxt_string("var o = {valueOf: function() { while (true) {} }};"
+                     "try { o * 2 } catch (e) {}"),
+          0, 10,
+          nxt_string("InternalError: execution time limit exceeded") },
+
+        { nxt_string("var s = 0; for (var i = 0; i < 1000; i++) { s += i } s"),
+          0, 1000,
+          nxt_string("499500") },
+
+        { nxt_string("while (true) {}"),
+          0, 10,
+          nxt_string("InternalError: execution time limit exceeded") },
+
+        { nxt_string("try { while (true) {} } catch (e) {}"),
+          0, 10,
+          nxt_string("InternalError: execution time limit exceeded") },
     };
 
-    vm = NULL;
-
-    rc = NXT_ERROR;
+    nvm = NULL;
+    parent = NULL;
+    ret = NXT_ERROR;
 
     for (i = 0; i < nxt_nitems(tests); i++) {
+        nxt_memzero(&options, sizeof(njs_vm_opt_t));
 
-        memset(&options, 0, sizeof(njs_vm_opt_t));
-        options.init = 1;
-
-        vm = njs_vm_create(&options);
-        if (vm == NULL) {
-            nxt_printf("njs_vm_create() failed\n");
+        parent = njs_vm_create(&options);
+        if (parent == NULL) {
             goto done;
         }
 
-        script = &tests[i].script;
-
-        ret = njs_vm_compile(vm, &script->start,
-                             script->start + script->length);
+        start = tests[i].script.start;
 
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_compile() failed\n");
+        if (njs_vm_compile(parent, &start, start + tests[i].script.length)
+            != NXT_OK)
+        {
             goto done;
         }
 
-        ret = njs_vm_start(vm);
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_run() failed\n");
+        nvm = njs_vm_clone(parent, NULL);
+        if (nvm == NULL) {
             goto done;
         }
 
-        args[0] = *njs_vm_retval(vm);
-
-        ret = njs_vm_json_parse(vm, args, 1);
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_json_parse() failed\n");
-            goto done;
-        }
+        njs_vm_execution_limit(nvm, tests[i].instructions, tests[i].timeout);
 
-        args[0] = vm->retval;
-        args[1] = *njs_vm_value(vm, &fname);
-        args[2] = *njs_vm_value(vm, &iname);
+        (void) njs_vm_start(nvm);
 
-        ret = njs_vm_json_stringify(vm, args, 3);
-        if (ret != NXT_OK) {
-            nxt_printf("njs_vm_json_stringify() failed\n");
+        if (njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK) {
             goto done;
         }
 
-        if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
-            nxt_printf("njs_vm_retval_to_ext_string() failed\n");
+        if (!nxt_strstr_eq(&tests[i].ret, &s)) {
+            nxt_printf("njs_vm_execution_limit_test(\"%V\")\n"
+                       "expected: \"%V\"\n     got: \"%V\"\n",
+                       &tests[i].script, &tests[i].ret, &s);
             goto done;
         }
 
-        success = nxt_strstr_eq(&tests[i].ret, &s);
-
-        if (!success) {
-            nxt_printf("njs_vm_json_test(\"%V\")\n"
-                       "expected: \"%V\"\n     got: \"%V\"\n", script,
-                       &tests[i].ret, &s);
-
-            goto done;
-        }
+        njs_vm_destroy(nvm);
+        nvm = NULL;
 
-        njs_vm_destroy(vm);
-        vm = NULL;
+        njs_vm_destroy(parent);
+        parent = NULL;
     }
 
-    rc = NXT_OK;
+    ret = NXT_OK;
 
 done:
 
-    if (rc == NXT_OK) {
-        nxt_printf("njs_vm_json_test passed\n");
-
-    } else {
-        if (njs_vm_retval_to_ext_string(vm, &s) != NXT_OK) {
-            nxt_printf("njs_vm_retval_to_ext_string() failed\n");
-
-        } else {
-            nxt_printf("%V\n", &s);
-        }
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
     }
 
-    if (vm != NULL) {
-        njs_vm_destroy(vm);
+    if (parent != NULL) {
+        njs_vm_destroy(parent);
     }
 
-    return rc;
+    return ret;
 }
 
 
 static nxt_int_t
-njs_vm_object_alloc_test(njs_vm_t * vm, nxt_bool_t disassemble,
+njs_vm_array_buffer_test(njs_vm_t * vm, nxt_bool_t disassemble,
     nxt_bool_t verbose)
 {
-    njs_ret_t    ret;
-    njs_value_t  args[2], obj;
+    u_char          *start;
+    nxt_str_t       s, bytes;
+    nxt_int_t       ret;
+    njs_vm_t        *nvm;
+    njs_value_t     buffer;
+    njs_function_t  *function;
+
+    u_char          data[4] = { 1, 2, 3, 4 };
+
+    static const nxt_str_t  parse = nxt_string("parse");
+    static const nxt_str_t  check = nxt_string("check");
+
+    static const nxt_str_t  script = nxt_string(
+        "var view;"
+        "function parse(b) {"
+        "    var a = new Uint8Array(b, 1); a[0] = 0xff; view = new DataView(b);"
+        "    return [view.getUint16(0), a.length, b.byteLength].join()"
+        "}"
+        "function check() {"
+        "    var e; try { view.getUint8(0) } catch (ex) { e = ex.name }"
+        "    return [view.byteLength, view.buffer.byteLength, e].join()"
+        "}");
 
-    static const njs_value_t num_key = njs_string("num");
-    static const njs_value_t bool_key = njs_string("bool");
+    static const nxt_str_t  parsed = nxt_string("511,3,4");
+    static const nxt_str_t  detached = nxt_string("0,0,TypeError");
 
-    njs_value_number_set(njs_argument(&args, 0), 1);
-    njs_value_boolean_set(njs_argument(&args, 1), 0);
+    nvm = NULL;
+    ret = NXT_ERROR;
 
-    ret = njs_vm_object_alloc(vm, &obj, NULL);
-    if (ret != NJS_OK) {
+    start = script.start;
+
+    if (njs_vm_compile(vm, &start, start + script.length) != NXT_OK) {
         return NXT_ERROR;
     }
 
-    ret = njs_vm_object_alloc(vm, &obj, &num_key, NULL);
-    if (ret == NJS_OK) {
-        return NXT_ERROR;
+    nvm = njs_vm_clone(vm, NULL);
+    if (nvm == NULL || njs_vm_start(nvm) != NXT_OK) {
+        goto done;
     }
 
-    ret = njs_vm_object_alloc(vm, &obj, &num_key, &args[0], NULL);
-    if (ret != NJS_OK) {
-        return NXT_ERROR;
+    if (njs_vm_array_buffer_set(nvm, &buffer, data, sizeof(data)) != NXT_OK
+        || njs_vm_value_array_buffer(nvm, &bytes, &buffer) != NXT_OK
+        || bytes.start != data || bytes.length != sizeof(data))
+    {
+        goto done;
     }
 
-    ret = njs_vm_object_alloc(vm, &obj, &num_key, &args[0], &bool_key,
-                              &args[1], NULL);
-    if (ret != NJS_OK) {
-        return NXT_ERROR;
+    function = njs_vm_function(nvm, &parse);
+    if (function == NULL
+        || njs_vm_call(nvm, function, &buffer, 1) != NXT_OK
+        || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+    {
+        goto done;
     }
 
-    return NXT_OK;
+    if (!nxt_strstr_eq(&parsed, &s) || data[1] != 0xff) {
+        nxt_printf("njs_vm_array_buffer_test:\n"
+                   "expected: \"%V\"\n     got: \"%V\"\n", &parsed, &s);
+        goto done;
+    }
+
+    njs_vm_array_buffer_detach(nvm, &buffer);
+
+    function = njs_vm_function(nvm, &check);
+    if (function == NULL
+        || njs_vm_call(nvm, function, NULL, 0) != NXT_OK
+        || njs_vm_retval_to_ext_string(nvm, &s) != NXT_OK)
+    {
+        goto done;
+    }
+
+    if (!nxt_strstr_eq(&detached, &s)) {
+        nxt_printf("njs_vm_array_buffer_test:\n"
+                   "expected: \"%V\"\n     got: \"%V\"\n", &detached, &s);
+        goto done;
+    }
+
+    if (njs_vm_value_array_buffer(nvm, &bytes, njs_value_arg(&njs_value_null))
+        != NXT_DECLINED)
+    {
+        goto done;
+    }
+
+    ret = NXT_OK;
+
+done:
+
+    if (nvm != NULL) {
+        njs_vm_destroy(nvm);
+    }
+
+    return ret;
 }
 
 
@@ -14185,6 +16440,24 @@ njs_api_test(nxt_bool_t disassemble, nxt_bool_t verbose)
     } tests[] = {
         { njs_vm_object_alloc_test,
           nxt_string("njs_vm_object_alloc_test") },
+        { njs_vm_array_alloc_test,
+          nxt_string("njs_vm_array_alloc_test") },
+        { njs_vm_freeze_test,
+          nxt_string("njs_vm_freeze_test") },
+        { njs_vm_gc_test,
+          nxt_string("njs_vm_gc_test") },
+        { njs_vm_gc_stress_test,
+          nxt_string("njs_vm_gc_stress_test") },
+        { njs_vm_refcount_test,
+          nxt_string("njs_vm_refcount_test") },
+        { njs_vm_arena_test,
+          nxt_string("njs_vm_arena_test") },
+        { njs_vm_memory_limit_test,
+          nxt_string("njs_vm_memory_limit_test") },
+        { njs_vm_execution_limit_test,
+          nxt_string("njs_vm_execution_limit_test") },
+        { njs_vm_array_buffer_test,
+          nxt_string("njs_vm_array_buffer_test") },
         { nxt_file_basename_test,
           nxt_string("nxt_file_basename_test") },
         { nxt_file_dirname_test,
@@ -14194,9 +16467,10 @@ njs_api_test(nxt_bool_t disassemble, nxt_bool_t verbose)
     rc = NXT_ERROR;
 
     vm = NULL;
-    nxt_memzero(&options, sizeof(njs_vm_opt_t));
 
     for (i = 0; i < nxt_nitems(tests); i++) {
+        nxt_memzero(&options, sizeof(njs_vm_opt_t));
+
         vm = njs_vm_create(&options);
         if (vm == NULL) {
             nxt_printf("njs_vm_create() failed\n");
@@ -14259,15 +16533,47 @@ main(int argc, char **argv)
 
     /* script tests. */
 
-    ret = njs_unit_test(njs_test, nxt_nitems(njs_test), 0, disassemble,
+    ret = njs_unit_test(njs_test, nxt_nitems(njs_test), 0, 0, 0, disassemble,
+                        verbose);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+    ret = njs_unit_test(njs_compile_test, nxt_nitems(njs_compile_test), 0, 0,
+                        0, disassemble, verbose);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+    /* script tests with lazy function compilation. */
+
+    ret = njs_unit_test(njs_test, nxt_nitems(njs_test), 0, 1, 0, disassemble,
+                        verbose);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+    ret = njs_unit_test(njs_lazy_test, nxt_nitems(njs_lazy_test), 0, 1, 0,
+                        disassemble, verbose);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+#if (NXT_HAVE_JIT)
+
+    /* script tests with functions compiled to machine code on first call. */
+
+    ret = njs_unit_test(njs_test, nxt_nitems(njs_test), 0, 0, 1, disassemble,
                         verbose);
     if (ret != NXT_OK) {
         return ret;
     }
 
+#endif
+
     /* module tests. */
 
-    ret = njs_unit_test(njs_module_test, nxt_nitems(njs_module_test), 1,
+    ret = njs_unit_test(njs_module_test, nxt_nitems(njs_module_test), 1, 0, 0,
                         disassemble, verbose);
     if (ret != NXT_OK) {
         return ret;
@@ -117,6 +117,33 @@ nxt_leading_zeros64(uint64_t x)
 #endif
 
 
+#if (NXT_HAVE_BUILTIN_CTZ)
+#define nxt_trailing_zeros(x)  (((x) == 0) ? 32 : __builtin_ctz(x))
+
+#else
+
+nxt_inline uint32_t
+nxt_trailing_zeros(uint32_t x)
+{
+    uint32_t  n;
+
+    if (x == 0) {
+        return 32;
+    }
+
+    n = 0;
+
+    while ((x & 1) == 0) {
+        n++;
+        x >>= 1;
+    }
+
+    return n;
+}
+
+#endif
+
+
 #if (NXT_HAVE_GCC_ATTRIBUTE_VISIBILITY)
 #define NXT_EXPORT         __attribute__((visibility("default")))
 
@@ -0,0 +1,457 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_auto_config.h>
+#include <nxt_types.h>
+#include <nxt_clang.h>
+#include <nxt_string.h>
+#include <nxt_stub.h>
+#include <nxt_lvlhsh.h>
+#include <nxt_flathsh.h>
+#include <string.h>
+
+#if (NXT_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+
+/*
+ * The flat hash table consists of a header, an array of element pointers
+ * and an array of element hashes both in insertion order, an array of
+ * element indexes and an array of control bytes.  The table size is
+ * a power of 2 and is split into groups of 16 slots.  The only group of
+ * the smallest table has 8 slots and 8 padding control bytes.
+ *
+ * A control byte is NXT_FLATHSH_EMPTY, NXT_FLATHSH_DELETED, or the low
+ * 7 bits of the element hash.  The other hash bits select the first group
+ * of a lookup, the groups are probed in the triangular sequence which
+ * visits all groups.  The control bytes of a group are compared at once,
+ * so only the elements with the matching 7 bits are tested.  A lookup
+ * stops at the first group having an empty slot.
+ *
+ * A deleted slot is marked as empty if its group has an empty slot,
+ * because no lookup has passed such a group.  Otherwise it is marked as
+ * deleted and is reused by insertion or is dropped when the table grows.
+ * The element pointer of a deleted element is set to NULL, the elements
+ * are compacted when the table grows.  The table grows when its elements
+ * array is full, the array has 7/8 of the table size.
+ */
+
+#define NXT_FLATHSH_GROUP      16
+#define NXT_FLATHSH_MIN_SIZE   8
+
+#define NXT_FLATHSH_EMPTY      0x80
+#define NXT_FLATHSH_DELETED    0xfe
+
+#define NXT_FLATHSH_NONE       ((uint32_t) -1)
+
+
+typedef struct {
+    uint32_t                   size;
+    uint32_t                   items;
+    uint32_t                   used;      /* elements including deleted */
+    uint32_t                   mask;      /* of groups */
+} nxt_flathsh_table_t;
+
+
+#define nxt_flathsh_full(size)                                                \
+    ((size) - (size) / 8)
+
+#define nxt_flathsh_ctrl_size(size)                                           \
+    nxt_max(size, NXT_FLATHSH_GROUP)
+
+#define nxt_flathsh_values(table)                                             \
+    ((void **) ((u_char *) (table) + sizeof(nxt_flathsh_table_t)))
+
+#define nxt_flathsh_hashes(table)                                             \
+    ((uint32_t *) (nxt_flathsh_values(table)                                  \
+                   + nxt_flathsh_full((table)->size)))
+
+#define nxt_flathsh_slots(table)                                              \
+    (nxt_flathsh_hashes(table) + nxt_flathsh_full((table)->size))
+
+#define nxt_flathsh_ctrl(table)                                               \
+    ((uint8_t *) (nxt_flathsh_slots(table) + (table)->size))
+
+#define nxt_flathsh_table_size(size)                                          \
+    (sizeof(nxt_flathsh_table_t)                                              \
+     + (size_t) nxt_flathsh_full(size) * (sizeof(void *) + sizeof(uint32_t))  \
+     + (size_t) (size) * sizeof(uint32_t) + nxt_flathsh_ctrl_size(size))
+
+#define nxt_flathsh_is_full(c)                                                \
+    (((c) & 0x80) == 0)
+
+
+static uint32_t nxt_flathsh_lookup(nxt_flathsh_table_t *table,
+    nxt_lvlhsh_query_t *lhq);
+static uint32_t nxt_flathsh_free_slot(nxt_flathsh_table_t *table,
+    uint32_t key_hash);
+static nxt_int_t nxt_flathsh_resize(nxt_flathsh_t *fh,
+    nxt_lvlhsh_query_t *lhq, uint32_t size);
+
+
+#if (NXT_HAVE_SSE2)
+
+nxt_inline uint32_t
+nxt_flathsh_match(const uint8_t *group, uint8_t c)
+{
+    __m128i  ctrl;
+
+    ctrl = _mm_loadu_si128((const __m128i *) group);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) c)));
+}
+
+
+nxt_inline uint32_t
+nxt_flathsh_match_free(const uint8_t *group)
+{
+    /* Both NXT_FLATHSH_EMPTY and NXT_FLATHSH_DELETED have the high bit. */
+
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+}
+
+#else
+
+nxt_inline uint32_t
+nxt_flathsh_match(const uint8_t *group, uint8_t c)
+{
+    uint32_t    mask;
+    nxt_uint_t  i;
+
+    mask = 0;
+
+    for (i = 0; i < NXT_FLATHSH_GROUP; i++) {
+        if (group[i] == c) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+
+nxt_inline uint32_t
+nxt_flathsh_match_free(const uint8_t *group)
+{
+    uint32_t    mask;
+    nxt_uint_t  i;
+
+    mask = 0;
+
+    for (i = 0; i < NXT_FLATHSH_GROUP; i++) {
+        if (!nxt_flathsh_is_full(group[i])) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+#endif
+
+
+nxt_int_t
+nxt_flathsh_find(const nxt_flathsh_t *fh, nxt_lvlhsh_query_t *lhq)
+{
+    uint32_t             n;
+    nxt_flathsh_table_t  *table;
+
+    table = fh->table;
+
+    if (table != NULL) {
+        n = nxt_flathsh_lookup(table, lhq);
+
+        if (n != NXT_FLATHSH_NONE) {
+            lhq->value = nxt_flathsh_values(table)[nxt_flathsh_slots(table)[n]];
+            return NXT_OK;
+        }
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static uint32_t
+nxt_flathsh_lookup(nxt_flathsh_table_t *table, nxt_lvlhsh_query_t *lhq)
+{
+    void      **values;
+    uint8_t   *ctrl, *group, h;
+    uint32_t  n, i, mask, match, step, *hashes, *slots, key_hash;
+
+    key_hash = lhq->key_hash;
+
+    ctrl = nxt_flathsh_ctrl(table);
+    slots = nxt_flathsh_slots(table);
+    hashes = nxt_flathsh_hashes(table);
+    values = nxt_flathsh_values(table);
+
+    h = key_hash & 0x7f;
+    mask = table->mask;
+    n = (key_hash >> 7) & mask;
+
+    for (step = 1; /* void */; step++) {
+        group = ctrl + n * NXT_FLATHSH_GROUP;
+
+        for (match = nxt_flathsh_match(group, h);
+             match != 0;
+             match &= match - 1)
+        {
+            n = group - ctrl + nxt_trailing_zeros(match);
+            i = slots[n];
+
+            if (hashes[i] == key_hash
+                && lhq->proto->test(lhq, values[i]) == NXT_OK)
+            {
+                return n;
+            }
+        }
+
+        if (nxt_flathsh_match(group, NXT_FLATHSH_EMPTY) != 0) {
+            return NXT_FLATHSH_NONE;
+        }
+
+        n = ((group - ctrl) / NXT_FLATHSH_GROUP + step) & mask;
+    }
+}
+
+
+static uint32_t
+nxt_flathsh_free_slot(nxt_flathsh_table_t *table, uint32_t key_hash)
+{
+    uint8_t   *ctrl, *group;
+    uint32_t  n, mask, match, valid, step;
+
+    ctrl = nxt_flathsh_ctrl(table);
+
+    mask = table->mask;
+    n = (key_hash >> 7) & mask;
+
+    /* The padding control bytes are marked as deleted. */
+    valid = (table->size < NXT_FLATHSH_GROUP) ? (1 << table->size) - 1
+                                              : 0xffff;
+
+    for (step = 1; /* void */; step++) {
+        group = ctrl + n * NXT_FLATHSH_GROUP;
+
+        match = nxt_flathsh_match_free(group) & valid;
+
+        if (match != 0) {
+            return n * NXT_FLATHSH_GROUP + nxt_trailing_zeros(match);
+        }
+
+        n = (n + step) & mask;
+    }
+}
+
+
+nxt_int_t
+nxt_flathsh_insert(nxt_flathsh_t *fh, nxt_lvlhsh_query_t *lhq)
+{
+    void                 *value, **values;
+    uint8_t              *ctrl;
+    uint32_t             n, i, size;
+    nxt_int_t            ret;
+    nxt_flathsh_table_t  *table;
+
+    table = fh->table;
+
+    if (table != NULL) {
+        n = nxt_flathsh_lookup(table, lhq);
+
+        if (n != NXT_FLATHSH_NONE) {
+            values = nxt_flathsh_values(table);
+            i = nxt_flathsh_slots(table)[n];
+            value = values[i];
+
+            if (lhq->replace) {
+                values[i] = lhq->value;
+                lhq->value = value;
+
+                return NXT_OK;
+            }
+
+            lhq->value = value;
+
+            return NXT_DECLINED;
+        }
+
+        if (table->used == nxt_flathsh_full(table->size)) {
+            size = table->size;
+
+            /* The table of the same size just drops the deleted elements. */
+
+            if (table->items >= size / 2) {
+                size *= 2;
+            }
+
+            ret = nxt_flathsh_resize(fh, lhq, size);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return ret;
+            }
+
+            table = fh->table;
+        }
+
+    } else {
+        ret = nxt_flathsh_resize(fh, lhq, NXT_FLATHSH_MIN_SIZE);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+
+        table = fh->table;
+    }
+
+    n = nxt_flathsh_free_slot(table, lhq->key_hash);
+    i = table->used++;
+
+    ctrl = nxt_flathsh_ctrl(table);
+
+    ctrl[n] = lhq->key_hash & 0x7f;
+    nxt_flathsh_slots(table)[n] = i;
+    nxt_flathsh_hashes(table)[i] = lhq->key_hash;
+    nxt_flathsh_values(table)[i] = lhq->value;
+
+    table->items++;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_flathsh_resize(nxt_flathsh_t *fh, nxt_lvlhsh_query_t *lhq, uint32_t size)
+{
+    void                 **values, **new_values;
+    uint8_t              *new_ctrl;
+    uint32_t             i, n, *hashes, *new_hashes;
+    nxt_flathsh_table_t  *table, *new;
+
+    new = lhq->proto->alloc(lhq->pool, nxt_flathsh_table_size(size), 1);
+    if (nxt_slow_path(new == NULL)) {
+        return NXT_ERROR;
+    }
+
+    new->size = size;
+    new->items = 0;
+    new->used = 0;
+    new->mask = (size - 1) / NXT_FLATHSH_GROUP;
+
+    new_ctrl = nxt_flathsh_ctrl(new);
+    new_hashes = nxt_flathsh_hashes(new);
+    new_values = nxt_flathsh_values(new);
+
+    nxt_memset(new_ctrl, NXT_FLATHSH_EMPTY, size);
+    nxt_memset(new_ctrl + size, NXT_FLATHSH_DELETED,
+               nxt_flathsh_ctrl_size(size) - size);
+
+    table = fh->table;
+
+    if (table != NULL) {
+        hashes = nxt_flathsh_hashes(table);
+        values = nxt_flathsh_values(table);
+
+        for (i = 0; i < table->used; i++) {
+            if (values[i] == NULL) {
+                continue;
+            }
+
+            n = nxt_flathsh_free_slot(new, hashes[i]);
+
+            new_ctrl[n] = hashes[i] & 0x7f;
+            nxt_flathsh_slots(new)[n] = new->used;
+            new_hashes[new->used] = hashes[i];
+            new_values[new->used] = values[i];
+
+            new->used++;
+        }
+
+        new->items = table->items;
+
+        lhq->proto->free(lhq->pool, table,
+                         nxt_flathsh_table_size(table->size));
+    }
+
+    fh->table = new;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+nxt_flathsh_delete(nxt_flathsh_t *fh, nxt_lvlhsh_query_t *lhq)
+{
+    void                 **values;
+    uint8_t              *ctrl, *group;
+    uint32_t             n, i;
+    nxt_flathsh_table_t  *table;
+
+    table = fh->table;
+
+    if (table == NULL) {
+        return NXT_DECLINED;
+    }
+
+    n = nxt_flathsh_lookup(table, lhq);
+
+    if (n == NXT_FLATHSH_NONE) {
+        return NXT_DECLINED;
+    }
+
+    values = nxt_flathsh_values(table);
+    i = nxt_flathsh_slots(table)[n];
+
+    lhq->value = values[i];
+
+    table->items--;
+
+    if (table->items == 0) {
+        lhq->proto->free(lhq->pool, table,
+                         nxt_flathsh_table_size(table->size));
+        fh->table = NULL;
+
+        return NXT_OK;
+    }
+
+    values[i] = NULL;
+
+    ctrl = nxt_flathsh_ctrl(table);
+    group = ctrl + n / NXT_FLATHSH_GROUP * NXT_FLATHSH_GROUP;
+
+    if (nxt_flathsh_match(group, NXT_FLATHSH_EMPTY) != 0) {
+        ctrl[n] = NXT_FLATHSH_EMPTY;
+
+    } else {
+        ctrl[n] = NXT_FLATHSH_DELETED;
+    }
+
+    return NXT_OK;
+}
+
+
+void *
+nxt_flathsh_each(const nxt_flathsh_t *fh, nxt_flathsh_each_t *fhe)
+{
+    void                 *value;
+    uint32_t             n;
+    nxt_flathsh_table_t  *table;
+
+    table = fh->table;
+
+    if (table == NULL) {
+        return NULL;
+    }
+
+    while (fhe->index < table->used) {
+        n = fhe->index++;
+        value = nxt_flathsh_values(table)[n];
+
+        if (value != NULL) {
+            fhe->key_hash = nxt_flathsh_hashes(table)[n];
+            return value;
+        }
+    }
+
+    return NULL;
+}
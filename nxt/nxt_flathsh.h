@@ -0,0 +1,63 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_FLATHSH_H_INCLUDED_
+#define _NXT_FLATHSH_H_INCLUDED_
+
+
+/*
+ * The flat hash is an open addressing alternative to lvlhsh for small
+ * and medium hashes.  It uses the lvlhsh query and proto, so both hashes
+ * can store the same elements.  Only the test, alloc and free functions
+ * of the proto are used, the allocated memory must be aligned as pointers.
+ * The elements must not be NULL.
+ */
+
+typedef struct {
+    void                      *table;
+} nxt_flathsh_t;
+
+
+typedef struct {
+    uint32_t                  index;
+    /* The hash of the returned element. */
+    uint32_t                  key_hash;
+} nxt_flathsh_each_t;
+
+
+#define nxt_flathsh_is_empty(fh)                                              \
+    ((fh)->table == NULL)
+
+
+#define nxt_flathsh_init(fh)                                                  \
+    (fh)->table = NULL
+
+
+#define nxt_flathsh_each_init(fhe)                                            \
+    (fhe)->index = 0
+
+
+/*
+ * nxt_flathsh_find(), nxt_flathsh_insert() and nxt_flathsh_delete()
+ * have the same semantics as nxt_lvlhsh_find(), nxt_lvlhsh_insert()
+ * and nxt_lvlhsh_delete().  The memory is released when the last
+ * element is deleted.
+ */
+NXT_EXPORT nxt_int_t nxt_flathsh_find(const nxt_flathsh_t *fh,
+    nxt_lvlhsh_query_t *lhq);
+NXT_EXPORT nxt_int_t nxt_flathsh_insert(nxt_flathsh_t *fh,
+    nxt_lvlhsh_query_t *lhq);
+NXT_EXPORT nxt_int_t nxt_flathsh_delete(nxt_flathsh_t *fh,
+    nxt_lvlhsh_query_t *lhq);
+
+/*
+ * nxt_flathsh_each() returns the next element in insertion order or NULL.
+ * The elements may be deleted during iteration but not inserted.
+ */
+NXT_EXPORT void *nxt_flathsh_each(const nxt_flathsh_t *fh,
+    nxt_flathsh_each_t *fhe);
+
+
+#endif /* _NXT_FLATHSH_H_INCLUDED_ */
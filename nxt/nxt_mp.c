@@ -28,6 +28,12 @@
  * sizes of the clusters and large allocations are stored in rbtree blocks
  * to find them on free operations.  The rbtree nodes are sorted by start
  * addresses.
+ *
+ * An arena memory pool allocates memory by moving a pointer in regions
+ * of cluster size.  Allocations greater than a quarter of region are
+ * allocated in separate regions.  Freed memory is not reused and all
+ * regions are released only when the pool is destroyed, so arena suits
+ * short-lived pools which are destroyed entirely.
  */
 
 
@@ -76,6 +82,13 @@ typedef enum {
 } nxt_mp_block_type_t;
 
 
+typedef struct nxt_mp_arena_s  nxt_mp_arena_t;
+
+struct nxt_mp_arena_s {
+    nxt_mp_arena_t              *next;
+};
+
+
 typedef struct {
     NXT_RBTREE_NODE             (node);
     nxt_mp_block_type_t         type:8;
@@ -109,12 +122,31 @@ struct nxt_mp_s {
 
     nxt_queue_t                 free_pages;
 
+    /* List of arena regions, the first one is being allocated from. */
+    nxt_mp_arena_t              *arenas;
+    u_char                      *arena_pos;
+    u_char                      *arena_end;
+
+    uint8_t                     arena;   /* 1 bit */
     uint8_t                     chunk_size_shift;
     uint8_t                     page_size_shift;
     uint32_t                    page_size;
     uint32_t                    page_alignment;
     uint32_t                    cluster_size;
 
+    /* Statistics, see nxt_mp_stat_t. */
+    size_t                      size;
+    size_t                      peak;
+    size_t                      allocated;
+    nxt_uint_t                  allocations;
+    nxt_uint_t                  pages;
+    nxt_uint_t                  clusters;
+    nxt_uint_t                  large;
+
+    /* Maximum size of memory allocated from the system, 0 is unlimited. */
+    size_t                      limit;
+    size_t                      reserve;
+
     const nxt_mem_proto_t       *proto;
     void                        *mem;
     void                        *trace;
@@ -139,6 +171,33 @@ struct nxt_mp_s {
     ((((value) - 1) & (value)) == 0)
 
 
+nxt_inline nxt_bool_t
+nxt_mp_over_limit(nxt_mp_t *mp, size_t size)
+{
+    if (mp->limit == 0 || mp->size + size <= mp->limit) {
+        return 0;
+    }
+
+    /* The reserve is given once to let the failure be handled. */
+
+    mp->limit += mp->reserve;
+    mp->reserve = 0;
+
+    return 1;
+}
+
+
+nxt_inline void
+nxt_mp_size_add(nxt_mp_t *mp, size_t size)
+{
+    mp->size += size;
+
+    if (mp->size > mp->peak) {
+        mp->peak = mp->size;
+    }
+}
+
+
 static nxt_uint_t nxt_mp_shift(nxt_uint_t n);
 #if !(NXT_DEBUG_MEMORY)
 static void *nxt_mp_alloc_small(nxt_mp_t *mp, size_t size);
@@ -147,6 +206,9 @@ static nxt_mp_page_t *nxt_mp_alloc_page(nxt_mp_t *mp);
 static nxt_mp_block_t *nxt_mp_alloc_cluster(nxt_mp_t *mp);
 #endif
 static void *nxt_mp_alloc_large(nxt_mp_t *mp, size_t alignment, size_t size);
+#if !(NXT_DEBUG_MEMORY)
+static void *nxt_mp_arena_alloc(nxt_mp_t *mp, size_t alignment, size_t size);
+#endif
 static intptr_t nxt_mp_rbtree_compare(nxt_rbtree_node_t *node1,
     nxt_rbtree_node_t *node2);
 static nxt_mp_block_t *nxt_mp_find_block(nxt_rbtree_t *tree,
@@ -240,6 +302,56 @@ nxt_mp_fast_create(const nxt_mem_proto_t *proto, void *mem,
 }
 
 
+nxt_mp_t *
+nxt_mp_arena_create(const nxt_mem_proto_t *proto, void *mem, void *trace,
+    size_t region_size)
+{
+    nxt_mp_t        *mp;
+    nxt_mp_arena_t  *arena;
+
+    if (nxt_slow_path(region_size < 1024 || region_size >= UINT32_MAX)) {
+        return NULL;
+    }
+
+    mp = proto->zalloc(mem, sizeof(nxt_mp_t));
+    if (nxt_slow_path(mp == NULL)) {
+        return NULL;
+    }
+
+    /* The first region is allocated beforehand. */
+
+    arena = proto->align(mem, NXT_MAX_ALIGNMENT, region_size);
+    if (nxt_slow_path(arena == NULL)) {
+        proto->free(mem, mp);
+        return NULL;
+    }
+
+    arena->next = NULL;
+
+    mp->proto = proto;
+    mp->mem = mem;
+    mp->trace = trace;
+
+    mp->arena = 1;
+    mp->page_alignment = NXT_MAX_ALIGNMENT;
+    mp->cluster_size = region_size;
+
+    mp->arenas = arena;
+    mp->arena_pos = (u_char *) arena + sizeof(nxt_mp_arena_t);
+    mp->arena_end = (u_char *) arena + region_size;
+
+    mp->size = region_size;
+    mp->peak = region_size;
+    mp->clusters = 1;
+
+    nxt_rbtree_init(&mp->blocks, nxt_mp_rbtree_compare);
+
+    nxt_queue_init(&mp->free_pages);
+
+    return mp;
+}
+
+
 static nxt_uint_t
 nxt_mp_shift(nxt_uint_t n)
 {
@@ -261,7 +373,29 @@ nxt_bool_t
 nxt_mp_is_empty(nxt_mp_t *mp)
 {
     return (nxt_rbtree_is_empty(&mp->blocks)
-            && nxt_queue_is_empty(&mp->free_pages));
+            && nxt_queue_is_empty(&mp->free_pages)
+            && mp->arenas == NULL);
+}
+
+
+void
+nxt_mp_stat(nxt_mp_t *mp, nxt_mp_stat_t *stat)
+{
+    stat->size = mp->size;
+    stat->peak = mp->peak;
+    stat->allocated = mp->allocated;
+    stat->allocations = mp->allocations;
+    stat->pages = mp->pages;
+    stat->clusters = mp->clusters;
+    stat->large = mp->large;
+}
+
+
+void
+nxt_mp_limit(nxt_mp_t *mp, size_t limit)
+{
+    mp->limit = limit;
+    mp->reserve = limit / 8;
 }
 
 
@@ -269,9 +403,17 @@ void
 nxt_mp_destroy(nxt_mp_t *mp)
 {
     void               *p;
+    nxt_mp_arena_t     *arena;
     nxt_mp_block_t     *block;
     nxt_rbtree_node_t  *node, *next;
 
+    while (mp->arenas != NULL) {
+        arena = mp->arenas;
+        mp->arenas = arena->next;
+
+        mp->proto->free(mp->mem, arena);
+    }
+
     next = nxt_rbtree_root(&mp->blocks);
 
     while (next != nxt_rbtree_sentinel(&mp->blocks)) {
@@ -299,8 +441,14 @@ nxt_mp_alloc(nxt_mp_t *mp, size_t size)
         mp->proto->trace(mp->trace, "mem cache alloc: %zd", size);
     }
 
+    mp->allocations++;
+
 #if !(NXT_DEBUG_MEMORY)
 
+    if (mp->arena) {
+        return nxt_mp_arena_alloc(mp, NXT_MAX_ALIGNMENT, size);
+    }
+
     if (size <= mp->page_size) {
         return nxt_mp_alloc_small(mp, size);
     }
@@ -338,8 +486,15 @@ nxt_mp_align(nxt_mp_t *mp, size_t alignment, size_t size)
 
     if (nxt_fast_path(nxt_is_power_of_two(alignment))) {
 
+        mp->allocations++;
+
 #if !(NXT_DEBUG_MEMORY)
 
+        if (mp->arena) {
+            return nxt_mp_arena_alloc(mp, nxt_max(alignment, NXT_MAX_ALIGNMENT),
+                                      size);
+        }
+
         if (size <= mp->page_size && alignment <= mp->page_alignment) {
             size = nxt_max(size, alignment);
 
@@ -452,9 +607,11 @@ nxt_mp_alloc_small(nxt_mp_t *mp, size_t size)
             p = nxt_mp_page_addr(mp, page);
         }
 
-#if (NXT_DEBUG)
         size = mp->page_size;
-#endif
+    }
+
+    if (nxt_fast_path(p != NULL)) {
+        mp->allocated += size;
     }
 
     if (mp->proto->trace != NULL) {
@@ -522,6 +679,8 @@ nxt_mp_alloc_page(nxt_mp_t *mp)
 
     page = nxt_queue_link_data(link, nxt_mp_page_t, link);
 
+    mp->pages++;
+
     return page;
 }
 
@@ -532,6 +691,10 @@ nxt_mp_alloc_cluster(nxt_mp_t *mp)
     nxt_uint_t      n;
     nxt_mp_block_t  *cluster;
 
+    if (nxt_slow_path(nxt_mp_over_limit(mp, mp->cluster_size))) {
+        return NULL;
+    }
+
     n = mp->cluster_size >> mp->page_size_shift;
 
     cluster = mp->proto->zalloc(mp->mem,
@@ -553,6 +716,9 @@ nxt_mp_alloc_cluster(nxt_mp_t *mp)
         return NULL;
     }
 
+    nxt_mp_size_add(mp, mp->cluster_size);
+    mp->clusters++;
+
     n--;
     cluster->pages[n].number = n;
     nxt_queue_insert_head(&mp->free_pages, &cluster->pages[n].link);
@@ -569,6 +735,72 @@ nxt_mp_alloc_cluster(nxt_mp_t *mp)
     return cluster;
 }
 
+
+static void *
+nxt_mp_arena_alloc(nxt_mp_t *mp, size_t alignment, size_t size)
+{
+    u_char          *p;
+    size_t          region_size;
+    nxt_mp_arena_t  *arena;
+
+    p = nxt_align_ptr(mp->arena_pos, alignment);
+
+    if (nxt_fast_path(p <= mp->arena_end
+                      && size <= (size_t) (mp->arena_end - p)))
+    {
+        mp->arena_pos = p + size;
+        mp->allocated += size;
+        return p;
+    }
+
+    /* Allocation must be less than 4G. */
+    if (nxt_slow_path(size >= UINT32_MAX)) {
+        return NULL;
+    }
+
+    region_size = nxt_align_size(sizeof(nxt_mp_arena_t), NXT_MAX_ALIGNMENT)
+                  + alignment - NXT_MAX_ALIGNMENT + size;
+
+    if (region_size <= mp->cluster_size / 4) {
+        region_size = mp->cluster_size;
+    }
+
+    if (nxt_slow_path(nxt_mp_over_limit(mp, region_size))) {
+        return NULL;
+    }
+
+    arena = mp->proto->align(mp->mem, NXT_MAX_ALIGNMENT, region_size);
+    if (nxt_slow_path(arena == NULL)) {
+        return NULL;
+    }
+
+    nxt_mp_size_add(mp, region_size);
+    mp->allocated += size;
+
+    p = nxt_align_ptr((u_char *) arena + sizeof(nxt_mp_arena_t), alignment);
+
+    if (region_size != mp->cluster_size) {
+        /* A large allocation does not replace the current region. */
+
+        arena->next = mp->arenas->next;
+        mp->arenas->next = arena;
+
+        mp->large++;
+
+        return p;
+    }
+
+    arena->next = mp->arenas;
+    mp->arenas = arena;
+
+    mp->clusters++;
+
+    mp->arena_pos = p + size;
+    mp->arena_end = (u_char *) arena + region_size;
+
+    return p;
+}
+
 #endif
 
 
@@ -585,6 +817,10 @@ nxt_mp_alloc_large(nxt_mp_t *mp, size_t alignment, size_t size)
         return NULL;
     }
 
+    if (nxt_slow_path(nxt_mp_over_limit(mp, size))) {
+        return NULL;
+    }
+
     if (nxt_is_power_of_two(size)) {
         block = mp->proto->alloc(mp->mem, sizeof(nxt_mp_block_t));
         if (nxt_slow_path(block == NULL)) {
@@ -617,6 +853,10 @@ nxt_mp_alloc_large(nxt_mp_t *mp, size_t alignment, size_t size)
     block->size = size;
     block->start = p;
 
+    nxt_mp_size_add(mp, size);
+    mp->allocated += size;
+    mp->large++;
+
     nxt_rbtree_insert(&mp->blocks, &block->node);
 
     return p;
@@ -645,6 +885,15 @@ nxt_mp_free(nxt_mp_t *mp, void *p)
         mp->proto->trace(mp->trace, "mem cache free %p", p);
     }
 
+#if !(NXT_DEBUG_MEMORY)
+
+    if (mp->arena) {
+        /* Arena memory is released when the pool is destroyed. */
+        return;
+    }
+
+#endif
+
     block = nxt_mp_find_block(&mp->blocks, p);
 
     if (nxt_fast_path(block != NULL)) {
@@ -659,6 +908,10 @@ nxt_mp_free(nxt_mp_t *mp, void *p)
         } else if (nxt_fast_path(p == block->start)) {
             nxt_rbtree_delete(&mp->blocks, &block->node);
 
+            mp->size -= block->size;
+            mp->allocated -= block->size;
+            mp->large--;
+
             if (block->type == NXT_MP_DISCRETE_BLOCK) {
                 mp->proto->free(mp->mem, block);
             }
@@ -745,6 +998,8 @@ nxt_mp_chunk_free(nxt_mp_t *mp, nxt_mp_block_t *cluster,
 
         nxt_mp_chunk_set_free(page->map, chunk);
 
+        mp->allocated -= size;
+
         /* Find a slot with appropriate chunk size. */
         for (slot = mp->slots; slot->size < size; slot++) { /* void */ }
 
@@ -773,11 +1028,15 @@ nxt_mp_chunk_free(nxt_mp_t *mp, nxt_mp_block_t *cluster,
 
     } else if (nxt_slow_path(p != start)) {
         return "invalid pointer to chunk: %p";
+
+    } else {
+        mp->allocated -= size;
     }
 
     /* Add the free page to the mp's free pages tree. */
 
     page->size = 0;
+    mp->pages--;
     nxt_queue_insert_head(&mp->free_pages, &page->link);
 
     nxt_mp_free_junk(p, size);
@@ -814,5 +1073,8 @@ nxt_mp_chunk_free(nxt_mp_t *mp, nxt_mp_block_t *cluster,
     mp->proto->free(mp->mem, cluster);
     mp->proto->free(mp->mem, p);
 
+    mp->size -= mp->cluster_size;
+    mp->clusters--;
+
     return NULL;
 }
@@ -11,6 +11,22 @@
 typedef struct nxt_mp_s  nxt_mp_t;
 
 
+typedef struct {
+    /* Size of memory allocated from the system and its maximum. */
+    size_t      size;
+    size_t      peak;
+
+    /* Size of memory allocated from the pool and not freed. */
+    size_t      allocated;
+    nxt_uint_t  allocations;
+
+    /* Used pages, clusters or arena regions, and large allocations. */
+    nxt_uint_t  pages;
+    nxt_uint_t  clusters;
+    nxt_uint_t  large;
+} nxt_mp_stat_t;
+
+
 NXT_EXPORT nxt_mp_t *nxt_mp_create(const nxt_mem_proto_t *proto, void *mem,
     void *trace, size_t cluster_size, size_t page_alignment, size_t page_size,
     size_t min_chunk_size)
@@ -19,7 +35,17 @@ NXT_EXPORT nxt_mp_t * nxt_mp_fast_create(const nxt_mem_proto_t *proto,
     void *mem, void *trace, size_t cluster_size, size_t page_alignment,
     size_t page_size, size_t min_chunk_size)
     NXT_MALLOC_LIKE;
+NXT_EXPORT nxt_mp_t *nxt_mp_arena_create(const nxt_mem_proto_t *proto,
+    void *mem, void *trace, size_t region_size)
+    NXT_MALLOC_LIKE;
 NXT_EXPORT nxt_bool_t nxt_mp_is_empty(nxt_mp_t *mp);
+NXT_EXPORT void nxt_mp_stat(nxt_mp_t *mp, nxt_mp_stat_t *stat);
+/*
+ * Limits the size of memory allocated from the system, 0 is unlimited.
+ * The first allocation over the limit fails and the limit is raised
+ * by one eighth, so the failure can be handled.
+ */
+NXT_EXPORT void nxt_mp_limit(nxt_mp_t *mp, size_t limit);
 NXT_EXPORT void nxt_mp_destroy(nxt_mp_t *mp);
 
 NXT_EXPORT void *nxt_mp_alloc(nxt_mp_t *mp, size_t size)
@@ -0,0 +1,385 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_auto_config.h>
+#include <nxt_types.h>
+#include <nxt_clang.h>
+#include <nxt_sprintf.h>
+#include <nxt_string.h>
+#include <nxt_stub.h>
+#include <nxt_malloc.h>
+#include <nxt_lvlhsh.h>
+#include <nxt_flathsh.h>
+#include <nxt_djb_hash.h>
+#include <nxt_murmur_hash.h>
+#include <nxt_time.h>
+#include <nxt_mp.h>
+#include <string.h>
+
+
+/* The number of operations of each kind for each hash size. */
+#define FLATHSH_BENCHMARK_OPS     (4 * 1024 * 1024)
+
+/* The minimal number of operations between the time measurements. */
+#define FLATHSH_BENCHMARK_BATCH   4096
+
+
+typedef struct {
+    nxt_str_t           name;
+    uint32_t            hash;
+    u_char              start[12];
+} flathsh_benchmark_key_t;
+
+
+typedef struct {
+    const char                *name;
+    const nxt_lvlhsh_proto_t  *proto;
+
+    nxt_int_t                 (*find)(void *hash, nxt_lvlhsh_query_t *lhq);
+    nxt_int_t                 (*insert)(void *hash, nxt_lvlhsh_query_t *lhq);
+    nxt_int_t                 (*delete)(void *hash, nxt_lvlhsh_query_t *lhq);
+} flathsh_benchmark_hash_t;
+
+
+static nxt_int_t
+flathsh_benchmark_key_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    flathsh_benchmark_key_t  *key;
+
+    key = data;
+
+    if (nxt_strstr_eq(&lhq->key, &key->name)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static void *
+flathsh_benchmark_lvlhsh_alloc(void *pool, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_align(pool, size, size);
+}
+
+
+static void *
+flathsh_benchmark_flathsh_alloc(void *pool, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_alloc(pool, size);
+}
+
+
+static void
+flathsh_benchmark_pool_free(void *pool, void *p, size_t size)
+{
+    nxt_mp_free(pool, p);
+}
+
+
+static const nxt_lvlhsh_proto_t  flathsh_benchmark_lvlhsh_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    0,
+    flathsh_benchmark_key_test,
+    flathsh_benchmark_lvlhsh_alloc,
+    flathsh_benchmark_pool_free,
+};
+
+
+/* The flat hash does not require the alignment of lvlhsh. */
+
+static const nxt_lvlhsh_proto_t  flathsh_benchmark_flathsh_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    0,
+    flathsh_benchmark_key_test,
+    flathsh_benchmark_flathsh_alloc,
+    flathsh_benchmark_pool_free,
+};
+
+
+static nxt_int_t
+flathsh_benchmark_lvlhsh_find(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_lvlhsh_find(hash, lhq);
+}
+
+
+static nxt_int_t
+flathsh_benchmark_lvlhsh_insert(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_lvlhsh_insert(hash, lhq);
+}
+
+
+static nxt_int_t
+flathsh_benchmark_lvlhsh_delete(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_lvlhsh_delete(hash, lhq);
+}
+
+
+static nxt_int_t
+flathsh_benchmark_flathsh_find(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_flathsh_find(hash, lhq);
+}
+
+
+static nxt_int_t
+flathsh_benchmark_flathsh_insert(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_flathsh_insert(hash, lhq);
+}
+
+
+static nxt_int_t
+flathsh_benchmark_flathsh_delete(void *hash, nxt_lvlhsh_query_t *lhq)
+{
+    return nxt_flathsh_delete(hash, lhq);
+}
+
+
+static const flathsh_benchmark_hash_t  flathsh_benchmark_hashes[] = {
+    { "lvlhsh",
+      &flathsh_benchmark_lvlhsh_proto,
+      flathsh_benchmark_lvlhsh_find,
+      flathsh_benchmark_lvlhsh_insert,
+      flathsh_benchmark_lvlhsh_delete },
+
+    { "flathsh",
+      &flathsh_benchmark_flathsh_proto,
+      flathsh_benchmark_flathsh_find,
+      flathsh_benchmark_flathsh_insert,
+      flathsh_benchmark_flathsh_delete },
+};
+
+
+static void *
+flathsh_malloc(void *mem, size_t size)
+{
+    return nxt_malloc(size);
+}
+
+
+static void *
+flathsh_zalloc(void *mem, size_t size)
+{
+    void  *p;
+
+    p = nxt_malloc(size);
+
+    if (p != NULL) {
+        nxt_memzero(p, size);
+    }
+
+    return p;
+}
+
+
+static void *
+flathsh_align(void *mem, size_t alignment, size_t size)
+{
+    return nxt_memalign(alignment, size);
+}
+
+
+static void
+flathsh_free(void *mem, void *p)
+{
+    nxt_free(p);
+}
+
+
+static void
+flathsh_alert(void *mem, const char *fmt, ...)
+{
+    u_char   buf[1024], *p;
+    va_list  args;
+
+    va_start(args, fmt);
+    p = nxt_sprintf(buf, buf + sizeof(buf), fmt, args);
+    va_end(args);
+
+    (void) nxt_error("alert: \"%*s\"\n", p - buf, buf);
+}
+
+
+static const nxt_mem_proto_t  flathsh_benchmark_mp_proto = {
+    flathsh_malloc,
+    flathsh_zalloc,
+    flathsh_align,
+    NULL,
+    flathsh_free,
+    flathsh_alert,
+    NULL,
+};
+
+
+static nxt_int_t
+flathsh_benchmark(const flathsh_benchmark_hash_t *hash, nxt_mp_t *pool,
+    flathsh_benchmark_key_t *keys, nxt_uint_t n)
+{
+    uint64_t                 start, insert, find, delete;
+    nxt_uint_t               i, j, k, m, rounds, ops;
+    nxt_lvlhsh_query_t       lhq;
+    flathsh_benchmark_key_t  *key;
+
+    /* nxt_lvlhsh_t and nxt_flathsh_t are both a single pointer. */
+    static void              *tables[FLATHSH_BENCHMARK_BATCH];
+
+    /* Small hashes are measured in batches of several hashes. */
+    m = nxt_max(FLATHSH_BENCHMARK_BATCH / n, 1);
+    rounds = FLATHSH_BENCHMARK_OPS / (m * n);
+
+    insert = 0;
+    find = 0;
+    delete = 0;
+
+    lhq.replace = 0;
+    lhq.proto = hash->proto;
+    lhq.pool = pool;
+
+    for (i = 0; i < rounds; i++) {
+
+        start = nxt_time();
+
+        for (k = 0; k < m; k++) {
+            for (j = 0; j < n; j++) {
+                key = &keys[j];
+
+                lhq.key = key->name;
+                lhq.key_hash = key->hash;
+                lhq.value = key;
+
+                if (hash->insert(&tables[k], &lhq) != NXT_OK) {
+                    goto failed;
+                }
+            }
+        }
+
+        insert += nxt_time() - start;
+        start = nxt_time();
+
+        for (k = 0; k < m; k++) {
+            for (j = 0; j < n; j++) {
+                key = &keys[j];
+
+                lhq.key = key->name;
+                lhq.key_hash = key->hash;
+
+                if (hash->find(&tables[k], &lhq) != NXT_OK
+                    || lhq.value != key)
+                {
+                    goto failed;
+                }
+            }
+        }
+
+        find += nxt_time() - start;
+        start = nxt_time();
+
+        for (k = 0; k < m; k++) {
+            for (j = 0; j < n; j++) {
+                key = &keys[j];
+
+                lhq.key = key->name;
+                lhq.key_hash = key->hash;
+
+                if (hash->delete(&tables[k], &lhq) != NXT_OK) {
+                    goto failed;
+                }
+            }
+        }
+
+        delete += nxt_time() - start;
+    }
+
+    ops = rounds * m * n;
+
+    nxt_printf("%s %l items: insert %.1fns, find %.1fns, delete %.1fns\n",
+               hash->name, (long) n, (double) insert / ops,
+               (double) find / ops, (double) delete / ops);
+
+    return NXT_OK;
+
+failed:
+
+    nxt_printf("%s benchmark failed: %l items\n", hash->name, (long) n);
+
+    return NXT_ERROR;
+}
+
+
+int nxt_cdecl
+main(int argc, char **argv)
+{
+    u_char                   *p;
+    uint32_t                 seed;
+    nxt_mp_t                 *pool;
+    nxt_int_t                ret;
+    nxt_uint_t               i, j, n;
+    flathsh_benchmark_key_t  key, *keys;
+
+    static const nxt_uint_t  sizes[] = { 4, 16, 256, 64 * 1024 };
+
+    n = sizes[nxt_nitems(sizes) - 1];
+
+    keys = nxt_malloc(n * sizeof(flathsh_benchmark_key_t));
+    if (keys == NULL) {
+        return 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(keys[i].start, keys[i].start + sizeof(keys[i].start),
+                        "key%ui", i);
+
+        keys[i].name.start = keys[i].start;
+        keys[i].name.length = p - keys[i].start;
+        keys[i].hash = nxt_djb_hash(keys[i].name.start, keys[i].name.length);
+    }
+
+    /* The keys are accessed in a random order. */
+
+    seed = 0;
+
+    for (i = n - 1; i > 0; i--) {
+        seed = nxt_murmur_hash2(&seed, sizeof(uint32_t));
+        j = seed % (i + 1);
+
+        key = keys[i];
+        keys[i] = keys[j];
+        keys[j] = key;
+
+        keys[i].name.start = keys[i].start;
+        keys[j].name.start = keys[j].start;
+    }
+
+    pool = nxt_mp_create(&flathsh_benchmark_mp_proto, NULL, NULL, 4096,
+                         128, 1024, 32);
+    if (pool == NULL) {
+        return 1;
+    }
+
+    ret = NXT_OK;
+
+    for (i = 0; i < nxt_nitems(sizes); i++) {
+        for (j = 0; j < nxt_nitems(flathsh_benchmark_hashes); j++) {
+            ret = flathsh_benchmark(&flathsh_benchmark_hashes[j], pool, keys,
+                                    sizes[i]);
+            if (ret != NXT_OK) {
+                break;
+            }
+        }
+    }
+
+    nxt_mp_destroy(pool);
+    nxt_free(keys);
+
+    return (ret == NXT_OK) ? 0 : 1;
+}
@@ -0,0 +1,380 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_auto_config.h>
+#include <nxt_types.h>
+#include <nxt_clang.h>
+#include <nxt_sprintf.h>
+#include <nxt_string.h>
+#include <nxt_stub.h>
+#include <nxt_malloc.h>
+#include <nxt_lvlhsh.h>
+#include <nxt_flathsh.h>
+#include <nxt_murmur_hash.h>
+#include <nxt_mp.h>
+#include <string.h>
+
+
+static nxt_int_t
+flathsh_unit_test_key_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    if (*(uintptr_t *) lhq->key.start == (uintptr_t) data) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static void *
+flathsh_unit_test_pool_alloc(void *pool, size_t size, nxt_uint_t nalloc)
+{
+    return nxt_mp_alloc(pool, size);
+}
+
+
+static void
+flathsh_unit_test_pool_free(void *pool, void *p, size_t size)
+{
+    nxt_mp_free(pool, p);
+}
+
+
+static const nxt_lvlhsh_proto_t  flathsh_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    0,
+    flathsh_unit_test_key_test,
+    flathsh_unit_test_pool_alloc,
+    flathsh_unit_test_pool_free,
+};
+
+
+static nxt_int_t
+flathsh_unit_test_add(nxt_flathsh_t *fh, void *pool, uintptr_t key)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = key;
+    lhq.replace = 0;
+    lhq.key.length = sizeof(uintptr_t);
+    lhq.key.start = (u_char *) &key;
+    lhq.value = (void *) key;
+    lhq.proto = &flathsh_proto;
+    lhq.pool = pool;
+
+    switch (nxt_flathsh_insert(fh, &lhq)) {
+
+    case NXT_OK:
+        return NXT_OK;
+
+    case NXT_DECLINED:
+        nxt_printf("flathsh unit test failed: key %08Xl is already in hash\n",
+                   (long) key);
+        /* Fall through. */
+
+    default:
+        return NXT_ERROR;
+    }
+}
+
+
+static nxt_int_t
+flathsh_unit_test_get(nxt_flathsh_t *fh, uintptr_t key, nxt_bool_t exists)
+{
+    nxt_int_t           ret;
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = key;
+    lhq.key.length = sizeof(uintptr_t);
+    lhq.key.start = (u_char *) &key;
+    lhq.proto = &flathsh_proto;
+
+    ret = nxt_flathsh_find(fh, &lhq);
+
+    if (exists) {
+        if (ret == NXT_OK && key == (uintptr_t) lhq.value) {
+            return NXT_OK;
+        }
+
+        nxt_printf("flathsh unit test failed: key %08Xl not found in hash\n",
+                   (long) key);
+
+        return NXT_ERROR;
+    }
+
+    if (ret == NXT_DECLINED) {
+        return NXT_OK;
+    }
+
+    nxt_printf("flathsh unit test failed: deleted key %08Xl found in hash\n",
+               (long) key);
+
+    return NXT_ERROR;
+}
+
+
+static nxt_int_t
+flathsh_unit_test_replace(nxt_flathsh_t *fh, void *pool, uintptr_t key)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = key;
+    lhq.key.length = sizeof(uintptr_t);
+    lhq.key.start = (u_char *) &key;
+    lhq.value = (void *) key;
+    lhq.proto = &flathsh_proto;
+    lhq.pool = pool;
+
+    lhq.replace = 0;
+
+    if (nxt_flathsh_insert(fh, &lhq) != NXT_DECLINED
+        || lhq.value != (void *) key)
+    {
+        nxt_printf("flathsh unit test failed: key %08Xl is not declined\n",
+                   (long) key);
+        return NXT_ERROR;
+    }
+
+    lhq.replace = 1;
+
+    if (nxt_flathsh_insert(fh, &lhq) != NXT_OK
+        || lhq.value != (void *) key)
+    {
+        nxt_printf("flathsh unit test failed: key %08Xl is not replaced\n",
+                   (long) key);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+flathsh_unit_test_delete(nxt_flathsh_t *fh, void *pool, uintptr_t key)
+{
+    nxt_int_t           ret;
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key_hash = key;
+    lhq.key.length = sizeof(uintptr_t);
+    lhq.key.start = (u_char *) &key;
+    lhq.proto = &flathsh_proto;
+    lhq.pool = pool;
+
+    ret = nxt_flathsh_delete(fh, &lhq);
+
+    if (ret != NXT_OK || lhq.value != (void *) key) {
+        nxt_printf("flathsh unit test failed: key %08lX not found in hash\n",
+                   (long) key);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static void *
+flathsh_malloc(void *mem, size_t size)
+{
+    return nxt_malloc(size);
+}
+
+
+static void *
+flathsh_zalloc(void *mem, size_t size)
+{
+    void  *p;
+
+    p = nxt_malloc(size);
+
+    if (p != NULL) {
+        nxt_memzero(p, size);
+    }
+
+    return p;
+}
+
+
+static void *
+flathsh_align(void *mem, size_t alignment, size_t size)
+{
+    return nxt_memalign(alignment, size);
+}
+
+
+static void
+flathsh_free(void *mem, void *p)
+{
+    nxt_free(p);
+}
+
+
+static void
+flathsh_alert(void *mem, const char *fmt, ...)
+{
+    u_char   buf[1024], *p;
+    va_list  args;
+
+    va_start(args, fmt);
+    p = nxt_sprintf(buf, buf + sizeof(buf), fmt, args);
+    va_end(args);
+
+    (void) nxt_error("alert: \"%*s\"\n", p - buf, buf);
+}
+
+
+static const nxt_mem_proto_t  flat_mp_proto = {
+    flathsh_malloc,
+    flathsh_zalloc,
+    flathsh_align,
+    NULL,
+    flathsh_free,
+    flathsh_alert,
+    NULL,
+};
+
+
+static nxt_int_t
+flathsh_unit_test(nxt_uint_t n)
+{
+    void                *value;
+    nxt_mp_t            *pool;
+    uint32_t            key;
+    nxt_uint_t          i, round;
+    nxt_flathsh_t       fh;
+    nxt_flathsh_each_t  fhe;
+
+    const size_t        min_chunk_size = 32;
+    const size_t        page_size = 1024;
+    const size_t        page_alignment = 128;
+    const size_t        cluster_size = 4096;
+
+    pool = nxt_mp_create(&flat_mp_proto, NULL, NULL, cluster_size,
+                         page_alignment, page_size, min_chunk_size);
+    if (pool == NULL) {
+        return NXT_ERROR;
+    }
+
+    nxt_printf("flathsh unit test started: %l items\n", (long) n);
+
+    nxt_flathsh_init(&fh);
+
+    key = 0;
+    for (i = 0; i < n; i++) {
+        key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+        if (flathsh_unit_test_add(&fh, pool, key) != NXT_OK) {
+            nxt_printf("flathsh add unit test failed at %l\n", (long) i);
+            return NXT_ERROR;
+        }
+    }
+
+    key = 0;
+    for (i = 0; i < n; i++) {
+        key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+        if (flathsh_unit_test_get(&fh, key, 1) != NXT_OK) {
+            return NXT_ERROR;
+        }
+
+        if (i % 16 == 0) {
+            if (flathsh_unit_test_replace(&fh, pool, key) != NXT_OK) {
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    /* The elements are iterated in insertion order. */
+
+    nxt_flathsh_each_init(&fhe);
+
+    key = 0;
+    for (i = 0; i < n + 1; i++) {
+        value = nxt_flathsh_each(&fh, &fhe);
+        if (value == NULL) {
+            break;
+        }
+
+        key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+        if (value != (void *) (uintptr_t) key) {
+            nxt_printf("flathsh each unit test failed: wrong order at %l\n",
+                       (long) i);
+            return NXT_ERROR;
+        }
+    }
+
+    if (i != n) {
+        nxt_printf("flathsh each unit test failed at %l of %l\n",
+                   (long) i, (long) n);
+        return NXT_ERROR;
+    }
+
+    /* The odd keys are deleted and inserted again to reuse deleted slots. */
+
+    for (round = 0; round < 2; round++) {
+        key = 0;
+        for (i = 0; i < n; i++) {
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+            if (i % 2 && flathsh_unit_test_delete(&fh, pool, key) != NXT_OK) {
+                return NXT_ERROR;
+            }
+        }
+
+        key = 0;
+        for (i = 0; i < n; i++) {
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+            if (flathsh_unit_test_get(&fh, key, i % 2 == 0) != NXT_OK) {
+                return NXT_ERROR;
+            }
+        }
+
+        key = 0;
+        for (i = 0; i < n; i++) {
+            key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+            if (i % 2 && flathsh_unit_test_add(&fh, pool, key) != NXT_OK) {
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    key = 0;
+    for (i = 0; i < n; i++) {
+        key = nxt_murmur_hash2(&key, sizeof(uint32_t));
+
+        if (flathsh_unit_test_delete(&fh, pool, key) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (!nxt_flathsh_is_empty(&fh) || !nxt_mp_is_empty(pool)) {
+        nxt_printf("mem cache pool is not empty\n");
+        return NXT_ERROR;
+    }
+
+    nxt_mp_destroy(pool);
+
+    nxt_printf("flathsh unit test passed\n");
+
+    return NXT_OK;
+}
+
+
+int
+main(void)
+{
+    if (flathsh_unit_test(7) != NXT_OK) {
+        return 1;
+    }
+
+    if (flathsh_unit_test(1000) != NXT_OK) {
+        return 1;
+    }
+
+    return flathsh_unit_test(1000 * 1000);
+}